@@ -38,7 +38,8 @@
 
 #include "itkPlatformMultiThreader.h"
 
-#include <memory> // For unique_ptr.
+#include <memory> // For shared_ptr and unique_ptr.
+#include <vector>
 
 namespace itk
 {
@@ -209,6 +210,34 @@ public:
    * This method allows the user to inspect this setting. */
   itkGetConstMacro(UseImageSampler, bool);
 
+  /** The points of the samples, mapped by the transform with the given parameters.
+   * Metrics that use the same image sampler and transform can share these, so
+   * that each sample is transformed only once per iteration.
+   */
+  struct MappedPointsType
+  {
+    const ImageSampleContainerType * m_SampleContainer{ nullptr };
+    ModifiedTimeType                 m_SampleContainerUpdateMTime{ 0 };
+    TransformParametersType          m_Parameters;
+    std::vector<OutputPointType>     m_Points;
+  };
+  using MappedPointsPointer = std::shared_ptr<MappedPointsType>;
+
+  /** Set/Get the mapped points that are shared with other metrics. By default
+   * (null), this metric transforms the points of the samples itself.
+   */
+  virtual void
+  SetSharedMappedPoints(const MappedPointsPointer & mappedPoints)
+  {
+    this->m_SharedMappedPoints = mappedPoints;
+    this->m_SharedMappedPointsAreValid = false;
+  }
+  const MappedPointsPointer &
+  GetSharedMappedPoints() const
+  {
+    return this->m_SharedMappedPoints;
+  }
+
   /** Set/Get the required ratio of valid samples; default 0.25.
    * When less than this ratio*numberOfSamplesTried samples map
    * inside the moving image buffer, an exception will be thrown. */
@@ -275,6 +304,28 @@ public:
   virtual void
   SetNumberOfWorkUnits(ThreadIdType numberOfThreads);
 
+  /** Get the number of work units, i.e. the number of blocks in which the
+   * samples are split. Equals the DeterministicNumberOfWorkUnits when set,
+   * and the number of threads otherwise.
+   */
+  const ThreadIdType &
+  GetNumberOfWorkUnits() const override
+  {
+    return this->m_DeterministicNumberOfWorkUnits > 0 ? this->m_DeterministicNumberOfWorkUnits
+                                                      : Superclass::GetNumberOfWorkUnits();
+  }
+
+  /** Set/Get a fixed number of work units, which makes the multi-threaded
+   * results independent of the number of threads and cores. The samples are
+   * split in this number of blocks, which the threads process in turns, and
+   * the results of the blocks are summed pairwise in a fixed order. Each work
+   * unit has its own derivative buffer, so large values cost memory.
+   * Default: 0, i.e. use the number of threads.
+   */
+  virtual void
+  SetDeterministicNumberOfWorkUnits(ThreadIdType numberOfWorkUnits);
+  itkGetConstMacro(DeterministicNumberOfWorkUnits, ThreadIdType);
+
   /** Switch the function BeforeThreadedGetValueAndDerivative on or off. */
   itkSetMacro(UseMetricSingleThreaded, bool);
   itkGetConstReferenceMacro(UseMetricSingleThreaded, bool);
@@ -412,10 +463,43 @@ protected:
   static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
   AccumulateDerivativesThreaderCallback(void * arg);
 
+  /** Calls function(workUnit) for each of the work units that the thread of
+   * the info struct processes. When there are more work units than threads,
+   * each thread processes every so many work units.
+   */
+  template <class TFunction>
+  void
+  ForEachWorkUnitOfThread(const ThreadInfoType & infoStruct, const TFunction & function) const
+  {
+    const ThreadIdType numberOfWorkUnits = Self::GetNumberOfWorkUnits();
+    for (ThreadIdType workUnit = infoStruct.WorkUnitID; workUnit < numberOfWorkUnits;
+         workUnit += infoStruct.NumberOfWorkUnits)
+    {
+      function(workUnit);
+    }
+  }
+
+  /** Sums x(begin), ..., x(end-1), with end > begin, pairwise along a binary tree
+   * whose shape only depends on the range. Used to reduce the per-thread results
+   * in a fixed order, which is also more accurate than a running sum.
+   */
+  template <class TValue, class TFunction>
+  static TValue
+  PairwiseSum(const ThreadIdType begin, const ThreadIdType end, const TFunction & x)
+  {
+    if (end - begin == 1)
+    {
+      return x(begin);
+    }
+    const ThreadIdType middle = begin + (end - begin) / 2;
+    return PairwiseSum<TValue>(begin, middle, x) + PairwiseSum<TValue>(middle, end, x);
+  }
+
   /** Variables for multi-threading. */
-  bool m_UseMetricSingleThreaded{ true };
-  bool m_UseMultiThread{ false };
-  bool m_UseOpenMP;
+  bool         m_UseMetricSingleThreaded{ true };
+  bool         m_UseMultiThread{ false };
+  bool         m_UseOpenMP;
+  ThreadIdType m_DeterministicNumberOfWorkUnits{ 0 };
 
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
@@ -454,6 +538,7 @@ protected:
   struct GetValueAndDerivativePerThreadStruct
   {
     SizeValueType  st_NumberOfPixelsCounted;
+    double         st_SumOfSampleWeights;
     MeasureType    st_Value;
     DerivativeType st_Derivative;
   };
@@ -549,6 +634,24 @@ protected:
   MovingImagePointType
   TransformPoint(const FixedImagePointType & fixedImagePoint) const;
 
+  /** Transform the point of the sample at the given position in the sample container.
+   * Returns the shared mapped point, when it is up to date, see SetSharedMappedPoints().
+   */
+  MovingImagePointType
+  TransformSamplePoint(const SizeValueType sampleIndex, const FixedImagePointType & fixedImagePoint) const;
+
+  /** Returns the importance weight of the sample at the given position in the sample container,
+   * see ImageSamplerBase::GetSampleWeights(). This is 1 for samplers that sample uniformly.
+   */
+  double
+  GetSampleWeight(const SizeValueType sampleIndex) const;
+
+  /** Recompute the shared mapped points, if they are not up to date with the
+   * current samples and transform parameters. Called by BeforeThreadedGetValueAndDerivative().
+   */
+  virtual void
+  UpdateSharedMappedPoints() const;
+
   /** This function returns a reference to the transform Jacobians.
    * This is either a reference to the full TransformJacobian or
    * a reference to a sparse Jacobians.
@@ -598,6 +701,10 @@ private:
   bool   m_ScaleGradientWithRespectToMovingImageOrientation{ false };
 
   MovingImageDerivativeScalesType m_MovingImageDerivativeScales{ MovingImageDerivativeScalesType::Filled(1.0) };
+
+  /** The mapped points, shared with other metrics. */
+  MappedPointsPointer m_SharedMappedPoints{ nullptr };
+  mutable bool        m_SharedMappedPointsAreValid{ false };
 };
 
 } // end namespace itk
@@ -29,6 +29,8 @@
 
 #include "itkTimeProbe.h"
 
+#include <algorithm> // For min.
+
 namespace itk
 {
 
@@ -76,12 +78,31 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::SetNumberOfWorkUnits(Thre
   Superclass::SetNumberOfWorkUnits(numberOfThreads);
 
 #ifdef ELASTIX_USE_OPENMP
-  const int nthreads = static_cast<int>(Self::GetNumberOfWorkUnits());
+  const int nthreads = static_cast<int>(Superclass::GetNumberOfWorkUnits());
   omp_set_num_threads(nthreads);
 #endif
 } // end SetNumberOfWorkUnits()
 
 
+/**
+ * ********************* SetDeterministicNumberOfWorkUnits ****************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::SetDeterministicNumberOfWorkUnits(
+  ThreadIdType numberOfWorkUnits)
+{
+  /** The number of threads is left as it is: the threads process the work units in turns. */
+  if (this->m_DeterministicNumberOfWorkUnits != numberOfWorkUnits)
+  {
+    this->m_DeterministicNumberOfWorkUnits = numberOfWorkUnits;
+    this->Modified();
+  }
+
+} // end SetDeterministicNumberOfWorkUnits()
+
+
 /**
  * ********************* Initialize ****************************
  */
@@ -113,10 +134,11 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::Initialize()
   {
     this->InitializeThreadingParameters();
 
+    /** The interpolators have scratch buffers for each work unit. */
     const auto setNumberOfWorkUnitsIfNotNull = [this](const auto bsplineInterpolator) {
       if (!bsplineInterpolator.IsNull())
       {
-        bsplineInterpolator->SetNumberOfWorkUnits(this->Superclass::GetNumberOfWorkUnits());
+        bsplineInterpolator->SetNumberOfWorkUnits(Self::GetNumberOfWorkUnits());
       }
     };
     setNumberOfWorkUnitsIfNotNull(m_BSplineInterpolator);
@@ -168,6 +190,7 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeThreadingParame
     this->m_GetValuePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
 
     this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_SumOfSampleWeights = 0.0;
     this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
     this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.SetSize(this->GetNumberOfParameters());
     this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.Fill(
@@ -200,6 +223,7 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeLimiters()
     typename ComputeFixedImageExtremaFilterType::Pointer computeFixedImageExtrema =
       ComputeFixedImageExtremaFilterType::New();
     computeFixedImageExtrema->SetInput(this->GetFixedImage());
+    computeFixedImageExtrema->SetUseCache(true);
     computeFixedImageExtrema->SetImageRegion(this->GetFixedImageRegion());
     if (this->m_FixedImageMask.IsNotNull())
     {
@@ -255,6 +279,7 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeLimiters()
     typename ComputeMovingImageExtremaFilterType::Pointer computeMovingImageExtrema =
       ComputeMovingImageExtremaFilterType::New();
     computeMovingImageExtrema->SetInput(this->GetMovingImage());
+    computeMovingImageExtrema->SetUseCache(true);
     computeMovingImageExtrema->SetImageRegion(this->GetMovingImage()->GetBufferedRegion());
     if (this->m_MovingImageMask.IsNotNull())
     {
@@ -692,6 +717,39 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::TransformPoint(const Fixe
 } // end TransformPoint()
 
 
+/**
+ * ********************** TransformSamplePoint ************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+auto
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::TransformSamplePoint(
+  const SizeValueType         sampleIndex,
+  const FixedImagePointType & fixedImagePoint) const -> MovingImagePointType
+{
+  if (this->m_SharedMappedPointsAreValid)
+  {
+    return this->m_SharedMappedPoints->m_Points[sampleIndex];
+  }
+  return this->TransformPoint(fixedImagePoint);
+
+} // end TransformSamplePoint()
+
+
+/**
+ * ********************** GetSampleWeight ************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+double
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::GetSampleWeight(const SizeValueType sampleIndex) const
+{
+  const std::vector<double> & sampleWeights = this->m_ImageSampler->GetSampleWeights();
+  return sampleWeights.empty() ? 1.0 : sampleWeights[sampleIndex];
+
+} // end GetSampleWeight()
+
+
 /**
  * *************** EvaluateTransformJacobian ****************
  */
@@ -776,11 +834,61 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::BeforeThreadedGetValueAnd
     {
       this->GetImageSampler()->Update();
     }
+    this->UpdateSharedMappedPoints();
   }
 
 } // end BeforeThreadedGetValueAndDerivative()
 
 
+/**
+ * *********************** UpdateSharedMappedPoints ***********************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::UpdateSharedMappedPoints() const
+{
+  this->m_SharedMappedPointsAreValid = false;
+  if (this->m_SharedMappedPoints == nullptr || !this->m_UseImageSampler)
+  {
+    return;
+  }
+
+  /** Another metric may already have computed the points for these samples and parameters. */
+  MappedPointsType &               mappedPoints = *this->m_SharedMappedPoints;
+  const ImageSampleContainerType * sampleContainer = this->GetImageSampler()->GetOutput();
+  const TransformParametersType &  parameters = this->m_Transform->GetParameters();
+  if (mappedPoints.m_SampleContainer != sampleContainer ||
+      mappedPoints.m_SampleContainerUpdateMTime != sampleContainer->GetUpdateMTime() ||
+      mappedPoints.m_Parameters != parameters)
+  {
+    const SizeValueType numberOfSamples = sampleContainer->Size();
+    mappedPoints.m_Points.resize(numberOfSamples);
+
+    /** Transform the points multi-threaded, in chunks of samples. */
+    constexpr SizeValueType chunkSize = 1024;
+    const SizeValueType     numberOfChunks = (numberOfSamples + chunkSize - 1) / chunkSize;
+    this->m_Threader->ParallelizeArray(
+      0,
+      numberOfChunks,
+      [this, sampleContainer, numberOfSamples, &mappedPoints](const SizeValueType chunk) {
+        const SizeValueType last = std::min((chunk + 1) * chunkSize, numberOfSamples);
+        for (SizeValueType i = chunk * chunkSize; i < last; ++i)
+        {
+          mappedPoints.m_Points[i] = this->TransformPoint(sampleContainer->ElementAt(i).m_ImageCoordinates);
+        }
+      },
+      nullptr);
+
+    mappedPoints.m_SampleContainer = sampleContainer;
+    mappedPoints.m_SampleContainerUpdateMTime = sampleContainer->GetUpdateMTime();
+    mappedPoints.m_Parameters = parameters;
+  }
+  this->m_SharedMappedPointsAreValid = true;
+
+} // end UpdateSharedMappedPoints()
+
+
 /**
  * **************** GetValueThreaderCallback *******
  */
@@ -790,11 +898,11 @@ ITK_THREAD_RETURN_TYPE
 AdvancedImageToImageMetric<TFixedImage, TMovingImage>::GetValueThreaderCallback(void * arg)
 {
   ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
-  ThreadIdType     threadID = infoStruct->WorkUnitID;
 
   MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
 
-  temp->st_Metric->ThreadedGetValue(threadID);
+  temp->st_Metric->ForEachWorkUnitOfThread(
+    *infoStruct, [temp](const ThreadIdType workUnit) { temp->st_Metric->ThreadedGetValue(workUnit); });
 
   return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
 
@@ -828,11 +936,11 @@ ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
 AdvancedImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivativeThreaderCallback(void * arg)
 {
   ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
-  ThreadIdType     threadID = infoStruct->WorkUnitID;
 
   MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
 
-  temp->st_Metric->ThreadedGetValueAndDerivative(threadID);
+  temp->st_Metric->ForEachWorkUnitOfThread(
+    *infoStruct, [temp](const ThreadIdType workUnit) { temp->st_Metric->ThreadedGetValueAndDerivative(workUnit); });
 
   return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
 
@@ -870,6 +978,7 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AccumulateDerivativesThre
   ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
 
   MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+  const ThreadIdType           numberOfWorkUnits = temp->st_Metric->GetNumberOfWorkUnits();
 
   const unsigned int numPar = temp->st_Metric->GetNumberOfParameters();
   const unsigned int subSize =
@@ -883,15 +992,17 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AccumulateDerivativesThre
    */
   const DerivativeValueType zero = NumericTraits<DerivativeValueType>::Zero;
   const DerivativeValueType normalization = 1.0 / temp->st_NormalizationFactor;
+  auto * const perThreadVariables = temp->st_Metric->m_GetValueAndDerivativePerThreadVariables.get();
   for (unsigned int j = jmin; j < jmax; ++j)
   {
-    DerivativeValueType tmp = zero;
-    for (ThreadIdType i = 0; i < nrOfThreads; ++i)
+    const DerivativeValueType tmp =
+      PairwiseSum<DerivativeValueType>(0, numberOfWorkUnits, [perThreadVariables, j](const ThreadIdType i) {
+        return perThreadVariables[i].st_Derivative[j];
+      });
+    for (ThreadIdType i = 0; i < numberOfWorkUnits; ++i)
     {
-      tmp += temp->st_Metric->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative[j];
-
       /** Reset this variable for the next iteration. */
-      temp->st_Metric->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative[j] = zero;
+      perThreadVariables[i].st_Derivative[j] = zero;
     }
     temp->st_DerivativePointer[j] = tmp * normalization;
   }
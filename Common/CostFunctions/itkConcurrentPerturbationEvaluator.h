@@ -0,0 +1,151 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkConcurrentPerturbationEvaluator_h
+#define itkConcurrentPerturbationEvaluator_h
+
+#include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkAdvancedRayCastResampleImageFilter.h"
+#include "itkFiniteDifferenceDerivativeEstimator.h"
+#include "itkImage.h"
+#include "itkMultiThreaderBase.h"
+
+#include <memory>
+#include <vector>
+
+namespace itk
+{
+/**
+ * \class PerturbationProjectionPipeline
+ * \brief The ray cast projection at the start of a pipeline of a ConcurrentPerturbationEvaluator.
+ *
+ * The metrics derive their own pipeline from it, adding the filters that
+ * compute the value from the output of the Projector.
+ *
+ * \ingroup RegistrationMetrics
+ */
+
+template <class TFixedImage, class TMovingImage, class TScalar>
+struct PerturbationProjectionPipeline
+{
+  using FixedImageType = TFixedImage;
+  using MovingImageType = TMovingImage;
+  using ScalarType = TScalar;
+  using ProjectedImageType = Image<typename TFixedImage::PixelType, TFixedImage::ImageDimension>;
+  using RayCastInterpolatorType = AdvancedRayCastInterpolateImageFunction<TMovingImage, TScalar>;
+  using ProjectorType = AdvancedRayCastResampleImageFilter<TMovingImage, ProjectedImageType, TScalar>;
+
+  typename MovingImageType::Pointer         MovingImage;
+  typename RayCastInterpolatorType::Pointer RayCaster;
+  typename ProjectorType::Pointer           Projector;
+};
+
+
+/**
+ * \class ConcurrentPerturbationEvaluator
+ * \brief Computes the values of a projection (DRR) based metric at the perturbed
+ * parameters of a finite difference derivative concurrently.
+ *
+ * Instead of cloning the transform, the transform at each of the perturbed
+ * parameters is collapsed and copied into an affine snapshot. This is only
+ * possible if the transform (chain) is linear. Each work unit then computes
+ * the values of its share of the snapshots with its own pipeline, connected
+ * to grafts of the images, so that the pipelines can be updated concurrently.
+ * All filters of the pipelines are single-threaded.
+ *
+ * The pipelines are created on demand, and kept until Clear() is called.
+ *
+ * The template argument TPipeline is the pipeline type of the metric, derived
+ * from a PerturbationProjectionPipeline.
+ *
+ * \ingroup RegistrationMetrics
+ */
+
+template <class TPipeline>
+class ITK_TEMPLATE_EXPORT ConcurrentPerturbationEvaluator
+{
+public:
+  /** Standard class typedefs. */
+  using Self = ConcurrentPerturbationEvaluator;
+  using PipelineType = TPipeline;
+
+  using FixedImageType = typename PipelineType::FixedImageType;
+  using MovingImageType = typename PipelineType::MovingImageType;
+  using ScalarType = typename PipelineType::ScalarType;
+  using RayCastInterpolatorType = typename PipelineType::RayCastInterpolatorType;
+  using RayCastTransformPointer = typename RayCastInterpolatorType::TransformPointer;
+  using TransformContainerType = std::vector<RayCastTransformPointer>;
+  using ParametersContainerType = FiniteDifferenceDerivativeEstimator::ParametersContainerType;
+  using MeasureContainerType = FiniteDifferenceDerivativeEstimator::MeasureContainerType;
+
+  /** Compute the values at the perturbed parameters concurrently, using the work units of the threader.
+   * \li setParameters(parameters) sets the parameters of the transform of the ray caster.
+   * \li completePipeline(pipeline) adds the filters of the metric to a new pipeline.
+   * \li computeValue(pipeline) computes the value, after the transform of the pipeline has been set.
+   * Returns false, without computing any value, if the values cannot be computed concurrently,
+   * because there is only one work unit, or because the transform (chain) is not linear.
+   */
+  template <class TSetParameters, class TCompletePipeline, class TComputeValue>
+  bool
+  ComputeValues(MultiThreaderBase &             threader,
+                const ParametersContainerType & perturbedParameters,
+                const RayCastInterpolatorType & rayCaster,
+                const MovingImageType *         movingImage,
+                const FixedImageType *          fixedImage,
+                const TSetParameters &          setParameters,
+                const TCompletePipeline &       completePipeline,
+                const TComputeValue &           computeValue,
+                MeasureContainerType &          values);
+
+  /** Remove the pipelines, which are connected to the previous images. */
+  void
+  Clear()
+  {
+    m_Pipelines.clear();
+  }
+
+private:
+  /** Take a snapshot of the transform at each of the perturbed parameters. This is done one
+   * after the other, because the transform is shared. Returns false if it is not linear.
+   */
+  template <class TSetParameters>
+  static bool
+  TakeSnapshots(const ParametersContainerType & perturbedParameters,
+                const RayCastInterpolatorType & rayCaster,
+                const TSetParameters &          setParameters,
+                TransformContainerType &        transforms);
+
+  /** Create or update the pipelines. */
+  template <class TCompletePipeline>
+  void
+  InitializePipelines(std::size_t                     numberOfPipelines,
+                      const RayCastInterpolatorType & rayCaster,
+                      const MovingImageType *         movingImage,
+                      const FixedImageType *          fixedImage,
+                      const TCompletePipeline &       completePipeline);
+
+  std::vector<std::unique_ptr<PipelineType>> m_Pipelines;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkConcurrentPerturbationEvaluator.hxx"
+#endif
+
+#endif // end #ifndef itkConcurrentPerturbationEvaluator_h
@@ -0,0 +1,177 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkConcurrentPerturbationEvaluator_hxx
+#define itkConcurrentPerturbationEvaluator_hxx
+
+#include "itkConcurrentPerturbationEvaluator.h"
+#include "itkAffineTransform.h"
+#include "itkCombinationTransformCollapser.h"
+
+#include <algorithm> // For min.
+
+namespace itk
+{
+
+/**
+ * ******************** ComputeValues ******************************
+ */
+
+template <class TPipeline>
+template <class TSetParameters, class TCompletePipeline, class TComputeValue>
+bool
+ConcurrentPerturbationEvaluator<TPipeline>::ComputeValues(MultiThreaderBase &             threader,
+                                                          const ParametersContainerType & perturbedParameters,
+                                                          const RayCastInterpolatorType & rayCaster,
+                                                          const MovingImageType *         movingImage,
+                                                          const FixedImageType *          fixedImage,
+                                                          const TSetParameters &          setParameters,
+                                                          const TCompletePipeline &       completePipeline,
+                                                          const TComputeValue &           computeValue,
+                                                          MeasureContainerType &          values)
+{
+  const std::size_t numberOfPipelines =
+    std::min<std::size_t>(threader.GetNumberOfWorkUnits(), perturbedParameters.size());
+  if (numberOfPipelines < 2)
+  {
+    return false;
+  }
+
+  TransformContainerType transforms;
+  if (!Self::TakeSnapshots(perturbedParameters, rayCaster, setParameters, transforms))
+  {
+    return false;
+  }
+
+  this->InitializePipelines(numberOfPipelines, rayCaster, movingImage, fixedImage, completePipeline);
+
+  /** Each pipeline computes every numberOfPipelines-th value. */
+  threader.ParallelizeArray(
+    0,
+    numberOfPipelines,
+    [this, numberOfPipelines, &transforms, &computeValue, &values](const SizeValueType pipelineIndex) {
+      PipelineType & pipeline = *this->m_Pipelines[pipelineIndex];
+      for (std::size_t k = pipelineIndex; k < transforms.size(); k += numberOfPipelines)
+      {
+        pipeline.RayCaster->SetTransform(transforms[k]);
+        pipeline.Projector->SetTransform(transforms[k]);
+        values[k] = computeValue(pipeline);
+      }
+    },
+    nullptr);
+
+  return true;
+
+} // end ComputeValues()
+
+
+/**
+ * ******************** TakeSnapshots ******************************
+ */
+
+template <class TPipeline>
+template <class TSetParameters>
+bool
+ConcurrentPerturbationEvaluator<TPipeline>::TakeSnapshots(const ParametersContainerType & perturbedParameters,
+                                                          const RayCastInterpolatorType & rayCaster,
+                                                          const TSetParameters &          setParameters,
+                                                          TransformContainerType &        transforms)
+{
+  using CollapserType = CombinationTransformCollapser<ScalarType, MovingImageType::ImageDimension>;
+  using MatrixOffsetTransformType = typename CollapserType::MatrixOffsetTransformType;
+  using SnapshotTransformType = AffineTransform<ScalarType, MovingImageType::ImageDimension>;
+
+  const auto collapser = CollapserType::New();
+  collapser->SetNumberOfErrorSamples(0);
+
+  transforms.clear();
+  for (const auto & testPoint : perturbedParameters)
+  {
+    setParameters(testPoint);
+    collapser->SetTransform(rayCaster.GetTransform());
+    collapser->Update();
+
+    const auto linear = dynamic_cast<const MatrixOffsetTransformType *>(collapser->GetCollapsedTransform());
+    if (linear == nullptr)
+    {
+      transforms.clear();
+      return false;
+    }
+    const auto snapshot = SnapshotTransformType::New();
+    snapshot->SetMatrix(linear->GetMatrix());
+    snapshot->SetOffset(linear->GetOffset());
+    transforms.push_back(snapshot.GetPointer());
+  }
+  return true;
+
+} // end TakeSnapshots()
+
+
+/**
+ * ******************** InitializePipelines ******************************
+ */
+
+template <class TPipeline>
+template <class TCompletePipeline>
+void
+ConcurrentPerturbationEvaluator<TPipeline>::InitializePipelines(const std::size_t               numberOfPipelines,
+                                                                const RayCastInterpolatorType & rayCaster,
+                                                                const MovingImageType *         movingImage,
+                                                                const FixedImageType *          fixedImage,
+                                                                const TCompletePipeline &       completePipeline)
+{
+  /** The pipelines are not connected to the (shared) moving image itself,
+   * but to a graft of it, so that they can be updated concurrently.
+   */
+  while (this->m_Pipelines.size() < numberOfPipelines)
+  {
+    auto pipeline = std::make_unique<PipelineType>();
+
+    pipeline->MovingImage = MovingImageType::New();
+    pipeline->MovingImage->Graft(movingImage);
+    pipeline->RayCaster = RayCastInterpolatorType::New();
+
+    pipeline->Projector = PipelineType::ProjectorType::New();
+    pipeline->Projector->SetNumberOfWorkUnits(1);
+    pipeline->Projector->SetInterpolator(pipeline->RayCaster);
+    pipeline->Projector->SetInput(pipeline->MovingImage);
+    pipeline->Projector->SetDefaultPixelValue(0);
+    pipeline->Projector->SetSize(fixedImage->GetLargestPossibleRegion().GetSize());
+    pipeline->Projector->SetOutputOrigin(fixedImage->GetOrigin());
+    pipeline->Projector->SetOutputSpacing(fixedImage->GetSpacing());
+    pipeline->Projector->SetOutputDirection(fixedImage->GetDirection());
+
+    completePipeline(*pipeline);
+
+    this->m_Pipelines.push_back(std::move(pipeline));
+  }
+
+  /** Copy the (per resolution) settings of the ray caster. */
+  for (const auto & pipeline : this->m_Pipelines)
+  {
+    pipeline->RayCaster->SetFocalPoint(rayCaster.GetFocalPoint());
+    pipeline->RayCaster->SetThreshold(rayCaster.GetThreshold());
+    pipeline->RayCaster->SetUseOccupancyGrid(rayCaster.GetUseOccupancyGrid());
+    pipeline->RayCaster->SetOccupancyBlockSize(rayCaster.GetOccupancyBlockSize());
+  }
+
+} // end InitializePipelines()
+
+} // end namespace itk
+
+#endif // end #ifndef itkConcurrentPerturbationEvaluator_hxx
@@ -0,0 +1,166 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFiniteDifferenceDerivativeEstimator.h"
+
+#include <cmath>
+
+namespace itk
+{
+
+/**
+ * **************** Constructor *****************************
+ */
+
+FiniteDifferenceDerivativeEstimator::FiniteDifferenceDerivativeEstimator()
+{
+  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
+
+} // end Constructor
+
+
+/**
+ * **************** GetStepSize *****************************
+ */
+
+double
+FiniteDifferenceDerivativeEstimator::GetStepSize(const unsigned int i) const
+{
+  if (this->m_Scales.GetSize() == 0)
+  {
+    return this->m_DerivativeDelta;
+  }
+  return this->m_DerivativeDelta / std::sqrt(this->m_Scales[i]);
+
+} // end GetStepSize()
+
+
+/**
+ * **************** GeneratePerturbedParameters *****************************
+ */
+
+void
+FiniteDifferenceDerivativeEstimator::GeneratePerturbedParameters(const ParametersType &    parameters,
+                                                                 ParametersContainerType & perturbedParameters)
+{
+  const unsigned int numberOfParameters = parameters.GetSize();
+  if (this->m_Scales.GetSize() != 0 && this->m_Scales.GetSize() != numberOfParameters)
+  {
+    itkExceptionMacro(<< "The number of scales (" << this->m_Scales.GetSize()
+                      << ") does not match the number of parameters (" << numberOfParameters << ").");
+  }
+
+  perturbedParameters.clear();
+
+  if (!this->m_UseSimultaneousPerturbation)
+  {
+    /** Central differences: perturb one parameter at a time. */
+    perturbedParameters.reserve(2 * numberOfParameters);
+    for (unsigned int i = 0; i < numberOfParameters; ++i)
+    {
+      ParametersType testPoint = parameters;
+      testPoint[i] -= this->GetStepSize(i);
+      perturbedParameters.push_back(testPoint);
+      testPoint[i] += 2 * this->GetStepSize(i);
+      perturbedParameters.push_back(testPoint);
+    }
+    return;
+  }
+
+  /** Simultaneous perturbation: perturb all parameters along a random
+   * direction, with Bernoulli distributed components.
+   */
+  this->m_PerturbationDirections.assign(this->m_NumberOfPerturbations, std::vector<signed char>(numberOfParameters));
+  perturbedParameters.reserve(2 * this->m_NumberOfPerturbations);
+  for (auto & direction : this->m_PerturbationDirections)
+  {
+    ParametersType minusPoint = parameters;
+    ParametersType plusPoint = parameters;
+    for (unsigned int i = 0; i < numberOfParameters; ++i)
+    {
+      direction[i] = (this->m_RandomGenerator->GetUniformVariate(0.0, 1.0) < 0.5) ? -1 : 1;
+      minusPoint[i] -= direction[i] * this->GetStepSize(i);
+      plusPoint[i] += direction[i] * this->GetStepSize(i);
+    }
+    perturbedParameters.push_back(minusPoint);
+    perturbedParameters.push_back(plusPoint);
+  }
+
+} // end GeneratePerturbedParameters()
+
+
+/**
+ * **************** ComputeDerivative *****************************
+ */
+
+void
+FiniteDifferenceDerivativeEstimator::ComputeDerivative(const MeasureContainerType & values,
+                                                       DerivativeType &             derivative) const
+{
+  if (!this->m_UseSimultaneousPerturbation)
+  {
+    const unsigned int numberOfParameters = values.size() / 2;
+    derivative = DerivativeType(numberOfParameters);
+    for (unsigned int i = 0; i < numberOfParameters; ++i)
+    {
+      derivative[i] = (values[2 * i + 1] - values[2 * i]) / (2 * this->GetStepSize(i));
+    }
+    return;
+  }
+
+  if (values.size() != 2 * this->m_PerturbationDirections.size())
+  {
+    itkExceptionMacro(<< "The number of values does not match the number of perturbations.");
+  }
+
+  const unsigned int numberOfParameters =
+    this->m_PerturbationDirections.empty() ? 0 : this->m_PerturbationDirections.front().size();
+  derivative = DerivativeType(numberOfParameters);
+  derivative.Fill(0.0);
+
+  for (std::size_t k = 0; k < this->m_PerturbationDirections.size(); ++k)
+  {
+    const double difference = values[2 * k + 1] - values[2 * k];
+    for (unsigned int i = 0; i < numberOfParameters; ++i)
+    {
+      derivative[i] += difference / (2 * this->m_PerturbationDirections[k][i] * this->GetStepSize(i));
+    }
+  }
+  derivative /= static_cast<double>(this->m_PerturbationDirections.size());
+
+} // end ComputeDerivative()
+
+
+/**
+ * **************** PrintSelf *****************************
+ */
+
+void
+FiniteDifferenceDerivativeEstimator::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "DerivativeDelta: " << this->m_DerivativeDelta << std::endl;
+  os << indent << "Scales: " << this->m_Scales << std::endl;
+  os << indent << "UseSimultaneousPerturbation: " << this->m_UseSimultaneousPerturbation << std::endl;
+  os << indent << "NumberOfPerturbations: " << this->m_NumberOfPerturbations << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
@@ -0,0 +1,144 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkFiniteDifferenceDerivativeEstimator_h
+#define itkFiniteDifferenceDerivativeEstimator_h
+
+#include "itkSingleValuedCostFunction.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <vector>
+
+namespace itk
+{
+/**
+ * \class FiniteDifferenceDerivativeEstimator
+ * \brief Estimates the derivative of a cost function from its values at perturbed parameters.
+ *
+ * The estimation is split in two steps, so that the cost function values can be
+ * computed in any order, or concurrently, by the caller:
+ * \li GeneratePerturbedParameters() returns pairs of parameter vectors,
+ *   p - h and p + h, at which the cost function has to be evaluated.
+ * \li ComputeDerivative() combines these values into the derivative.
+ *
+ * By default, central differences are used: one pair per parameter, with
+ * \f$ h_i = \delta / \sqrt{s_i} \f$, with \f$ \delta \f$ the DerivativeDelta
+ * and \f$ s_i \f$ the scale of parameter \f$ i \f$.
+ *
+ * Alternatively, the simultaneous perturbation (SPSA) estimator can be used.
+ * It perturbs all parameters at once, along a random direction with
+ * components \f$ \pm h_i \f$, and estimates
+ * \f$ g_i = ( f(p + h) - f(p - h) ) / ( 2 h_i ) \f$.
+ * This requires only two cost function evaluations per perturbation,
+ * independent of the number of parameters, at the expense of noise in the
+ * estimate. The noise decreases when averaging over more perturbations.
+ *
+ * \ingroup Numerics
+ */
+
+class FiniteDifferenceDerivativeEstimator : public Object
+{
+public:
+  /** Standard ITK-stuff. */
+  using Self = FiniteDifferenceDerivativeEstimator;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(FiniteDifferenceDerivativeEstimator, Object);
+
+  /** Typedefs. */
+  using MeasureType = SingleValuedCostFunction::MeasureType;
+  using DerivativeType = SingleValuedCostFunction::DerivativeType;
+  using ParametersType = SingleValuedCostFunction::ParametersType;
+  using ParametersContainerType = std::vector<ParametersType>;
+  using MeasureContainerType = std::vector<MeasureType>;
+  using ScalesType = Array<double>;
+  using RandomGeneratorType = Statistics::MersenneTwisterRandomVariateGenerator;
+
+  /** Set/Get the size of the perturbation. Default: 0.001. */
+  itkSetMacro(DerivativeDelta, double);
+  itkGetConstMacro(DerivativeDelta, double);
+
+  /** Set/Get the parameter scales. If empty, all scales are assumed to be 1. */
+  itkSetMacro(Scales, ScalesType);
+  itkGetConstReferenceMacro(Scales, ScalesType);
+
+  /** Set/Get whether the simultaneous perturbation estimator is used,
+   * instead of central differences. Default: false.
+   */
+  itkSetMacro(UseSimultaneousPerturbation, bool);
+  itkGetConstMacro(UseSimultaneousPerturbation, bool);
+  itkBooleanMacro(UseSimultaneousPerturbation);
+
+  /** Set/Get the number of random perturbations that are averaged by the
+   * simultaneous perturbation estimator. Default: 1.
+   */
+  itkSetClampMacro(NumberOfPerturbations, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(NumberOfPerturbations, unsigned int);
+
+  /** Generate the parameter vectors at which the cost function has to be
+   * evaluated. Element 2k is the point p - h and element 2k + 1 the point
+   * p + h of the k-th perturbation.
+   */
+  virtual void
+  GeneratePerturbedParameters(const ParametersType & parameters, ParametersContainerType & perturbedParameters);
+
+  /** Combine the cost function values at the perturbed parameters, generated by
+   * the last call to GeneratePerturbedParameters(), into the derivative.
+   */
+  virtual void
+  ComputeDerivative(const MeasureContainerType & values, DerivativeType & derivative) const;
+
+protected:
+  /** The constructor. */
+  FiniteDifferenceDerivativeEstimator();
+  /** The destructor. */
+  ~FiniteDifferenceDerivativeEstimator() override = default;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Returns the step size of parameter i. */
+  double
+  GetStepSize(const unsigned int i) const;
+
+private:
+  FiniteDifferenceDerivativeEstimator(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  double       m_DerivativeDelta{ 0.001 };
+  ScalesType   m_Scales;
+  bool         m_UseSimultaneousPerturbation{ false };
+  unsigned int m_NumberOfPerturbations{ 1 };
+
+  RandomGeneratorType::Pointer m_RandomGenerator;
+
+  /** The directions (+1 or -1 per parameter) of the last simultaneous perturbations. */
+  std::vector<std::vector<signed char>> m_PerturbationDirections;
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkFiniteDifferenceDerivativeEstimator_h
@@ -40,6 +40,11 @@ namespace itk
  *
  * \brief Implements a metric base class that takes multiple inputs.
  *
+ * Inheriting metrics can evaluate all moving images at a mapped point in
+ * one go, with EvaluateMovingImageValuesAndDerivatives(). When the moving
+ * images share their geometry, which is the usual case for multi-channel
+ * and feature images, the point is converted to a continuous index and
+ * checked against the image buffer only once for all channels.
  *
  * \ingroup RegistrationMetrics
  *
@@ -304,6 +309,10 @@ public:
   /** A function to check if all moving image interpolators are of type B-spline. */
   itkGetConstMacro(InterpolatorsAreBSpline, bool);
 
+  /** Whether all moving images have the same origin, spacing, direction and buffered region.
+   * Determined by Initialize(). */
+  itkGetConstMacro(MovingImagesShareGeometry, bool);
+
   /** ******************** FixedImageInterpolators ********************
    * These interpolators are used for the fixed images.
    */
@@ -380,10 +389,29 @@ protected:
                                         RealType &                   movingImageValue,
                                         MovingImageDerivativeType *  gradient) const override;
 
+  /** Compute the values, and optionally the spatial derivatives, of all moving images at
+   * mappedPoint in one gather. The first moving image is evaluated like in
+   * EvaluateMovingImageValueAndDerivative(); the other (feature) images share its
+   * continuous index when the moving images share their geometry, and the B-spline
+   * interpolators then compute value and derivative in a single call.
+   * The values array should hold GetNumberOfMovingImages() elements, and so should the
+   * gradients array, if not null. The derivatives of the feature images are computed
+   * by their B-spline interpolators. This function is thread-safe.
+   * Returns false if mappedPoint is outside one of the moving image buffers.
+   */
+  bool
+  EvaluateMovingImageValuesAndDerivatives(const MovingImagePointType & mappedPoint,
+                                          RealType *                   values,
+                                          MovingImageDerivativeType *  gradients) const;
+
   /** IsInsideMovingMask: Returns the AND of all moving image masks. */
   bool
   IsInsideMovingMask(const MovingImagePointType & mappedPoint) const override;
 
+  /** Check if all moving images have the same geometry; called by Initialize. */
+  virtual void
+  CheckForSharedMovingImageGeometry();
+
   /** Protected member variables. */
   FixedImageVectorType             m_FixedImageVector;
   FixedImageMaskVectorType         m_FixedImageMaskVector;
@@ -395,6 +423,7 @@ protected:
 
   bool                          m_InterpolatorsAreBSpline;
   BSplineInterpolatorVectorType m_BSplineInterpolatorVector;
+  bool                          m_MovingImagesShareGeometry{ false };
 
 private:
   MultiInputImageToImageMetricBase(const Self &) = delete;
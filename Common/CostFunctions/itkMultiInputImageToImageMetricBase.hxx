@@ -211,6 +211,33 @@ MultiInputImageToImageMetricBase<TFixedImage, TMovingImage>::CheckForBSplineInte
 } // end CheckForBSplineInterpolators()
 
 
+/**
+ * ****************** CheckForSharedMovingImageGeometry **********************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+MultiInputImageToImageMetricBase<TFixedImage, TMovingImage>::CheckForSharedMovingImageGeometry()
+{
+  /** The interpolators convert points to continuous indices and check them against
+   * the buffered region of their input image. If these are the same for all
+   * moving images, this only needs to be done once for all of them.
+   */
+  this->m_MovingImagesShareGeometry = this->m_NumberOfInterpolators == this->m_NumberOfMovingImages;
+  const MovingImageType * firstImage = this->m_MovingImageVector.empty() ? nullptr : this->m_MovingImageVector[0];
+  for (unsigned int i = 1; i < this->m_NumberOfMovingImages && this->m_MovingImagesShareGeometry; ++i)
+  {
+    const MovingImageType * image = this->m_MovingImageVector[i];
+    this->m_MovingImagesShareGeometry = image->GetOrigin() == firstImage->GetOrigin() &&
+                                        image->GetSpacing() == firstImage->GetSpacing() &&
+                                        image->GetDirection() == firstImage->GetDirection() &&
+                                        image->GetBufferedRegion() == firstImage->GetBufferedRegion();
+  }
+  itkDebugMacro(<< "Moving images share their geometry: " << this->m_MovingImagesShareGeometry);
+
+} // end CheckForSharedMovingImageGeometry()
+
+
 /**
  * ****************** Initialize **********************
  */
@@ -234,6 +261,9 @@ MultiInputImageToImageMetricBase<TFixedImage, TMovingImage>::Initialize()
   /** Check for B-spline interpolators. */
   this->CheckForBSplineInterpolators();
 
+  /** Check if the moving images can share their continuous indices. */
+  this->CheckForSharedMovingImageGeometry();
+
   /** Call the superclass' implementation. */
   this->Superclass::Initialize();
 
@@ -289,9 +319,13 @@ MultiInputImageToImageMetricBase<TFixedImage, TMovingImage>::EvaluateMovingImage
   RealType &                   movingImageValue,
   MovingImageDerivativeType *  gradient) const
 {
-  /** Check if the mapped point is inside the moving image buffers of the feature images. */
-  bool sampleOk = true;
-  for (unsigned int i = 1; i < this->GetNumberOfInterpolators(); ++i)
+  /** Check if the mapped point is inside the moving image buffers of the feature images.
+   * Not needed when they share the geometry of the first moving image, which is checked below.
+   */
+  bool               sampleOk = true;
+  const unsigned int numberOfInterpolatorsToCheck =
+    this->m_MovingImagesShareGeometry ? 1 : this->GetNumberOfInterpolators();
+  for (unsigned int i = 1; i < numberOfInterpolatorsToCheck; ++i)
   {
     sampleOk &= this->GetInterpolator(i)->IsInsideBuffer(mappedPoint);
 
@@ -308,6 +342,60 @@ MultiInputImageToImageMetricBase<TFixedImage, TMovingImage>::EvaluateMovingImage
 } // end EvaluateMovingImageValueAndDerivative()
 
 
+/**
+ * ******************* EvaluateMovingImageValuesAndDerivatives ******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+MultiInputImageToImageMetricBase<TFixedImage, TMovingImage>::EvaluateMovingImageValuesAndDerivatives(
+  const MovingImagePointType & mappedPoint,
+  RealType *                   values,
+  MovingImageDerivativeType *  gradients) const
+{
+  /** Evaluate the first moving image, which also checks its buffer. */
+  if (!this->Superclass::EvaluateMovingImageValueAndDerivative(mappedPoint, values[0], gradients))
+  {
+    return false;
+  }
+
+  const unsigned int numberOfMovingImages = this->GetNumberOfMovingImages();
+  if (numberOfMovingImages < 2)
+  {
+    return true;
+  }
+
+  /** Gather the feature images. With a shared geometry, one continuous index serves all of them. */
+  const bool                     useBSplineDerivative = this->m_InterpolatorsAreBSpline && !this->GetComputeGradient();
+  MovingImageContinuousIndexType cindex;
+  this->m_InterpolatorVector[0]->ConvertPointToContinuousIndex(mappedPoint, cindex);
+  for (unsigned int i = 1; i < numberOfMovingImages; ++i)
+  {
+    if (!this->m_MovingImagesShareGeometry)
+    {
+      this->m_InterpolatorVector[i]->ConvertPointToContinuousIndex(mappedPoint, cindex);
+      if (!this->m_InterpolatorVector[i]->IsInsideBuffer(cindex))
+      {
+        return false;
+      }
+    }
+
+    if (gradients && useBSplineDerivative)
+    {
+      this->m_BSplineInterpolatorVector[i]->EvaluateValueAndDerivativeAtContinuousIndex(
+        cindex, values[i], gradients[i]);
+    }
+    else
+    {
+      values[i] = this->m_InterpolatorVector[i]->EvaluateAtContinuousIndex(cindex);
+    }
+  }
+
+  return true;
+
+} // end EvaluateMovingImageValuesAndDerivatives()
+
+
 /**
  * ************************ IsInsideMovingMask *************************
  */
@@ -213,6 +213,22 @@ public:
   itkSetMacro(FiniteDifferencePerturbation, double);
   itkGetConstMacro(FiniteDifferencePerturbation, double);
 
+  /** Whether ComputePDFsAndSampleCache() may store the per-sample results that
+   * a second pass over the samples needs, i.e. the limited fixed and moving image
+   * values and the sparse product of the moving image gradient and the transform
+   * Jacobian. Only used by subclasses that loop over the samples twice, and only
+   * in the multi-threaded code. Default: false.
+   */
+  itkSetMacro(UseSampleCache, bool);
+  itkGetConstMacro(UseSampleCache, bool);
+  itkBooleanMacro(UseSampleCache);
+
+  /** The maximum size of the sample cache, in megabytes. When the cache would
+   * need more memory, the per-sample results are recomputed instead. Default: 512.
+   */
+  itkSetMacro(MaximumSampleCacheMemory, double);
+  itkGetConstMacro(MaximumSampleCacheMemory, double);
+
 protected:
   /** The constructor. */
   ParzenWindowHistogramImageToImageMetric();
@@ -315,6 +331,14 @@ protected:
   void
   LaunchComputePDFsThreaderCallback() const;
 
+  /** Multi-threaded version of the loop over the samples of ComputePDFsAndIncrementalPDFs(). */
+  inline void
+  ThreadedComputePDFsAndSparseIncrementalPDFs(ThreadIdType threadId);
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputePDFsAndSparseIncrementalPDFsThreaderCallback(void * arg);
+
   /** Compute the Parzen values given an image value and a starting histogram index
    * Compute the values at (parzenWindowIndex - parzenWindowTerm + k) for
    * k = 0 ... kernelsize-1
@@ -431,6 +455,50 @@ protected:
   virtual void
   ComputePDFsAndIncrementalPDFs(const ParametersType & parameters) const;
 
+  /** A sample, together with a transform parameter that has a nonzero Jacobian at
+   * that sample. The moving image values at the right and left perturbed positions,
+   * mu + delta * e_k and mu - delta * e_k, are only valid if the sample maps inside
+   * the moving image (mask) after the perturbation.
+   */
+  struct PerturbedSampleType
+  {
+    SizeValueType m_Parameter;
+    SizeValueType m_Sample;
+    RealType      m_MovingImageValueRight;
+    RealType      m_MovingImageValueLeft;
+    bool          m_IsInsideRight;
+    bool          m_IsInsideLeft;
+  };
+
+  /** Multi-threaded alternative for ComputePDFsAndIncrementalPDFs(). Instead of the
+   * incremental pdfs, of size \#parameters * \#bins * \#bins, it stores the perturbed
+   * samples, which only scale with the number of samples and nonzero Jacobian indices.
+   * The threads collect these in private lists, which are grouped by parameter
+   * afterwards: the perturbed samples of parameter k are found in m_PerturbedSamples,
+   * from m_PerturbedSampleOffsets[k] up to m_PerturbedSampleOffsets[k+1]. The limited
+   * fixed and moving image values of sample s are stored in m_SampleFixedImageValues[s]
+   * and m_SampleMovingImageValues[s]. Also constructs the m_JointPDF and m_Alpha.
+   */
+  virtual void
+  ComputePDFsAndSparseIncrementalPDFs(const ParametersType & parameters) const;
+
+  /** Add weight * ParzenWindow( fixedImageValue, movingImageValue ) to a buffer
+   * that has the layout of the joint pdf. Used to construct the incremental pdf
+   * of a single parameter from the perturbed samples. Returns the offset in the
+   * buffer of the first bin of the Parzen window.
+   */
+  OffsetValueType
+  AddToIncrementalPDF(const RealType fixedImageValue,
+                      const RealType movingImageValue,
+                      const double   weight,
+                      PDFValueType * incrementalPDF) const;
+
+  /** The results of ComputePDFsAndSparseIncrementalPDFs(). */
+  mutable std::vector<PerturbedSampleType> m_PerturbedSamples;
+  mutable std::vector<SizeValueType>       m_PerturbedSampleOffsets;
+  mutable std::vector<RealType>            m_SampleFixedImageValues;
+  mutable std::vector<RealType>            m_SampleMovingImageValues;
+
   /** Compute PDFs; Loops over the fixed image samples and constructs
    * the m_JointPDF and m_Alpha
    * The JointPDF and Alpha are related as follows:
@@ -445,6 +513,35 @@ protected:
   virtual void
   ComputePDFs(const ParametersType & parameters) const;
 
+  /** Compute PDFs like ComputePDFs(), but also fill the sample cache, if UseSampleCache
+   * is true and the cache fits in the MaximumSampleCacheMemory. Afterwards,
+   * m_SampleCacheFilled tells whether the cache can be used.
+   */
+  virtual void
+  ComputePDFsAndSampleCache(const ParametersType & parameters) const;
+
+  /** The per-sample results of the samples of one thread, that passed the
+   * checks of ComputePDFsAndSampleCache(). The image Jacobian and nonzero
+   * Jacobian indices of sample i start at i * GetNumberOfNonZeroJacobianIndices().
+   */
+  struct SampleCacheType
+  {
+    SizeValueType                                                m_NumberOfSamples{ 0 };
+    std::vector<RealType>                                        m_FixedImageValues;
+    std::vector<RealType>                                        m_MovingImageValues;
+    std::vector<DerivativeValueType>                             m_ImageJacobians;
+    std::vector<typename NonZeroJacobianIndicesType::value_type> m_NonZeroJacobianIndices;
+  };
+
+  /** The sample cache of each thread. The buffers are kept between iterations. */
+  mutable std::vector<SampleCacheType> m_SampleCaches;
+  mutable bool                         m_SampleCacheFilled{ false };
+
+  /** Tells whether UpdateJointPDFAndDerivatives() may use its specialized implementation for a fixed kernel
+   * of order 0 and a moving kernel of order 3. Set by InitializeKernels().
+   */
+  bool m_UseSpecializedParzenKernels{ false };
+
   /** Some initialization functions, called by Initialize. */
   virtual void
   InitializeHistograms();
@@ -482,6 +579,9 @@ private:
   /** Threading related parameters. */
   mutable std::vector<JointPDFPointer> m_ThreaderJointPDFs;
 
+  /** The perturbed samples of each thread, see ComputePDFsAndSparseIncrementalPDFs(). */
+  mutable std::vector<std::vector<PerturbedSampleType>> m_PerturbedSamplesPerThread;
+
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
    */
@@ -494,6 +594,7 @@ private:
   struct ParzenWindowHistogramGetValueAndDerivativePerThreadStruct
   {
     SizeValueType   st_NumberOfPixelsCounted;
+    double          st_SumOfSampleWeights;
     JointPDFPointer st_JointPDF;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
@@ -514,6 +615,8 @@ private:
   bool          m_UseExplicitPDFDerivatives;
   bool          m_UseFiniteDifferenceDerivative;
   double        m_FiniteDifferencePerturbation;
+  bool          m_UseSampleCache{ false };
+  double        m_MaximumSampleCacheMemory{ 512.0 };
 };
 
 } // end namespace itk
@@ -25,6 +25,8 @@
 #include "itkImageLinearIteratorWithIndex.h"
 #include "itkImageScanlineIterator.h"
 #include <vnl/vnl_math.h>
+#include <algorithm> // For copy and copy_n.
+#include <numeric>   // For partial_sum.
 
 namespace itk
 {
@@ -90,6 +92,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(st
   os << indent << "NumberOfMovingHistogramBins: " << this->m_NumberOfMovingHistogramBins << std::endl;
   os << indent << "FixedKernelBSplineOrder: " << this->m_FixedKernelBSplineOrder << std::endl;
   os << indent << "MovingKernelBSplineOrder: " << this->m_MovingKernelBSplineOrder << std::endl;
+  os << indent << "UseSampleCache: " << this->m_UseSampleCache << std::endl;
+  os << indent << "MaximumSampleCacheMemory: " << this->m_MaximumSampleCacheMemory << std::endl;
 
   /*double m_MovingImageNormalizedMin;
   double m_FixedImageNormalizedMin;
@@ -254,48 +258,59 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeHi
     {
       this->m_JointPDFDerivatives = nullptr;
 
-      this->m_IncrementalJointPDFRight = JointPDFDerivativesType::New();
-      this->m_IncrementalJointPDFLeft = JointPDFDerivativesType::New();
-      this->m_IncrementalJointPDFRight->SetRegions(jointPDFDerivativesRegion);
-      this->m_IncrementalJointPDFLeft->SetRegions(jointPDFDerivativesRegion);
-      this->m_IncrementalJointPDFRight->Allocate();
-      this->m_IncrementalJointPDFLeft->Allocate();
-
-      /** Also initialize the incremental marginal pdfs. */
-      IncrementalMarginalPDFRegionType fixedIMPDFRegion;
-      IncrementalMarginalPDFIndexType  fixedIMPDFIndex;
-      IncrementalMarginalPDFSizeType   fixedIMPDFSize;
-
-      IncrementalMarginalPDFRegionType movingIMPDFRegion;
-      IncrementalMarginalPDFIndexType  movingIMPDFIndex;
-      IncrementalMarginalPDFSizeType   movingIMPDFSize;
-
-      fixedIMPDFIndex.Fill(0);
-      fixedIMPDFSize[0] = this->GetNumberOfParameters();
-      fixedIMPDFSize[1] = this->m_NumberOfFixedHistogramBins;
-      fixedIMPDFRegion.SetSize(fixedIMPDFSize);
-      fixedIMPDFRegion.SetIndex(fixedIMPDFIndex);
-
-      movingIMPDFIndex.Fill(0);
-      movingIMPDFSize[0] = this->GetNumberOfParameters();
-      movingIMPDFSize[1] = this->m_NumberOfMovingHistogramBins;
-      movingIMPDFRegion.SetSize(movingIMPDFSize);
-      movingIMPDFRegion.SetIndex(movingIMPDFIndex);
-
-      this->m_FixedIncrementalMarginalPDFRight = IncrementalMarginalPDFType::New();
-      this->m_MovingIncrementalMarginalPDFRight = IncrementalMarginalPDFType::New();
-      this->m_FixedIncrementalMarginalPDFLeft = IncrementalMarginalPDFType::New();
-      this->m_MovingIncrementalMarginalPDFLeft = IncrementalMarginalPDFType::New();
-
-      this->m_FixedIncrementalMarginalPDFRight->SetRegions(fixedIMPDFRegion);
-      this->m_MovingIncrementalMarginalPDFRight->SetRegions(movingIMPDFRegion);
-      this->m_FixedIncrementalMarginalPDFLeft->SetRegions(fixedIMPDFRegion);
-      this->m_MovingIncrementalMarginalPDFLeft->SetRegions(movingIMPDFRegion);
-
-      this->m_FixedIncrementalMarginalPDFRight->Allocate();
-      this->m_MovingIncrementalMarginalPDFRight->Allocate();
-      this->m_FixedIncrementalMarginalPDFLeft->Allocate();
-      this->m_MovingIncrementalMarginalPDFLeft->Allocate();
+      /** The multi-threaded computation stores sparse incremental pdfs instead,
+       * see ComputePDFsAndSparseIncrementalPDFs().
+       */
+      if (this->m_UseMultiThread)
+      {
+        this->m_IncrementalJointPDFRight = nullptr;
+        this->m_IncrementalJointPDFLeft = nullptr;
+      }
+      else
+      {
+        this->m_IncrementalJointPDFRight = JointPDFDerivativesType::New();
+        this->m_IncrementalJointPDFLeft = JointPDFDerivativesType::New();
+        this->m_IncrementalJointPDFRight->SetRegions(jointPDFDerivativesRegion);
+        this->m_IncrementalJointPDFLeft->SetRegions(jointPDFDerivativesRegion);
+        this->m_IncrementalJointPDFRight->Allocate();
+        this->m_IncrementalJointPDFLeft->Allocate();
+
+        /** Also initialize the incremental marginal pdfs. */
+        IncrementalMarginalPDFRegionType fixedIMPDFRegion;
+        IncrementalMarginalPDFIndexType  fixedIMPDFIndex;
+        IncrementalMarginalPDFSizeType   fixedIMPDFSize;
+
+        IncrementalMarginalPDFRegionType movingIMPDFRegion;
+        IncrementalMarginalPDFIndexType  movingIMPDFIndex;
+        IncrementalMarginalPDFSizeType   movingIMPDFSize;
+
+        fixedIMPDFIndex.Fill(0);
+        fixedIMPDFSize[0] = this->GetNumberOfParameters();
+        fixedIMPDFSize[1] = this->m_NumberOfFixedHistogramBins;
+        fixedIMPDFRegion.SetSize(fixedIMPDFSize);
+        fixedIMPDFRegion.SetIndex(fixedIMPDFIndex);
+
+        movingIMPDFIndex.Fill(0);
+        movingIMPDFSize[0] = this->GetNumberOfParameters();
+        movingIMPDFSize[1] = this->m_NumberOfMovingHistogramBins;
+        movingIMPDFRegion.SetSize(movingIMPDFSize);
+        movingIMPDFRegion.SetIndex(movingIMPDFIndex);
+
+        this->m_FixedIncrementalMarginalPDFRight = IncrementalMarginalPDFType::New();
+        this->m_MovingIncrementalMarginalPDFRight = IncrementalMarginalPDFType::New();
+        this->m_FixedIncrementalMarginalPDFLeft = IncrementalMarginalPDFType::New();
+        this->m_MovingIncrementalMarginalPDFLeft = IncrementalMarginalPDFType::New();
+
+        this->m_FixedIncrementalMarginalPDFRight->SetRegions(fixedIMPDFRegion);
+        this->m_MovingIncrementalMarginalPDFRight->SetRegions(movingIMPDFRegion);
+        this->m_FixedIncrementalMarginalPDFLeft->SetRegions(fixedIMPDFRegion);
+        this->m_MovingIncrementalMarginalPDFLeft->SetRegions(movingIMPDFRegion);
+
+        this->m_FixedIncrementalMarginalPDFRight->Allocate();
+        this->m_MovingIncrementalMarginalPDFRight->Allocate();
+        this->m_FixedIncrementalMarginalPDFLeft->Allocate();
+        this->m_MovingIncrementalMarginalPDFLeft->Allocate();
+      }
     } // end if this->GetUseFiniteDifferenceDerivative()
     else
     {
@@ -409,6 +424,10 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeKe
   this->m_FixedParzenTermToIndexOffset = 0.5 - static_cast<double>(this->m_FixedKernelBSplineOrder) / 2.0;
   this->m_MovingParzenTermToIndexOffset = 0.5 - static_cast<double>(this->m_MovingKernelBSplineOrder) / 2.0;
 
+  /** The default kernel orders have a specialized implementation. */
+  this->m_UseSpecializedParzenKernels =
+    this->m_FixedKernelBSplineOrder == 0 && this->m_MovingKernelBSplineOrder == 3;
+
 } // end InitializeKernels()
 
 
@@ -449,6 +468,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeTh
   for (auto & perThreadVariable : m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables)
   {
     perThreadVariable.st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
+    perThreadVariable.st_SumOfSampleWeights = 0.0;
 
     // Initialize the joint pdf
     JointPDFPointer & jointPDF = perThreadVariable.st_JointPDF;
@@ -463,6 +483,10 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeTh
     }
   }
 
+  /** The sample caches are filled by the threads, when requested. */
+  this->m_SampleCaches.resize(numberOfThreads);
+  this->m_SampleCacheFilled = false;
+
 } // end InitializeThreadingParameters()
 
 
@@ -549,6 +573,30 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::UpdateJointP
   const OffsetValueType movingImageParzenWindowIndex =
     static_cast<OffsetValueType>(std::floor(movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset));
 
+  /** Specialized version for the default kernels (fixed order 0, moving order 3),
+   * in case no derivatives are needed. The kernels are evaluated in closed form,
+   * without virtual function calls and Parzen value containers, and the four
+   * affected bins, which are contiguous in the joint PDF, are updated directly.
+   */
+  if (!imageJacobian && this->m_UseSpecializedParzenKernels)
+  {
+    double fixedParzenValue;
+    double movingParzenValues[4];
+    BSplineKernelFunction2<0>::FastEvaluate(
+      static_cast<double>(fixedImageParzenWindowIndex) - fixedImageParzenWindowTerm, &fixedParzenValue);
+    BSplineKernelFunction2<3>::FastEvaluate(
+      static_cast<double>(movingImageParzenWindowIndex) - movingImageParzenWindowTerm, movingParzenValues);
+
+    PDFValueType * const bins = jointPDF->GetBufferPointer() +
+                                fixedImageParzenWindowIndex * jointPDF->GetOffsetTable()[1] +
+                                movingImageParzenWindowIndex;
+    for (unsigned int m = 0; m < 4; ++m)
+    {
+      bins[m] += static_cast<PDFValueType>(fixedParzenValue * movingParzenValues[m]);
+    }
+    return;
+  }
+
   /** The Parzen values. */
   ParzenValueContainerType fixedParzenValues(this->m_JointPDFWindow.GetSize()[1]);
   ParzenValueContainerType movingParzenValues(this->m_JointPDFWindow.GetSize()[0]);
@@ -1002,6 +1050,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsS
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const bool                  useSampleWeights = !this->GetImageSampler()->GetSampleWeights().empty();
+  double                      sumOfSampleWeights = 0.0;
 
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator fiter;
@@ -1041,8 +1091,18 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsS
       movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue);
 
       /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateJointPDFAndDerivatives(
-        fixedImageValue, movingImageValue, nullptr, nullptr, this->m_JointPDF.GetPointer());
+      if (useSampleWeights)
+      {
+        const double sampleWeight = this->GetSampleWeight(fiter.Index());
+        sumOfSampleWeights += sampleWeight;
+        this->AddToIncrementalPDF(
+          fixedImageValue, movingImageValue, sampleWeight, this->m_JointPDF->GetBufferPointer());
+      }
+      else
+      {
+        this->UpdateJointPDFAndDerivatives(
+          fixedImageValue, movingImageValue, nullptr, nullptr, this->m_JointPDF.GetPointer());
+      }
     }
 
   } // end iterating over fixed image spatial sample container for loop
@@ -1050,8 +1110,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsS
   /** Check if enough samples were valid. */
   this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
 
-  /** Compute alpha. */
-  this->m_Alpha = 1.0 / static_cast<double>(this->m_NumberOfPixelsCounted);
+  /** Compute alpha. With importance weights, the joint histogram is normalized by their sum. */
+  this->m_Alpha = 1.0 / (useSampleWeights ? sumOfSampleWeights : static_cast<double>(this->m_NumberOfPixelsCounted));
 
 } // end ComputePDFsSingleThreaded()
 
@@ -1064,6 +1124,9 @@ template <class TFixedImage, class TMovingImage>
 void
 ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFs(const ParametersType & parameters) const
 {
+  /** The sample cache is only filled by ComputePDFsAndSampleCache(). */
+  this->m_SampleCacheFilled = false;
+
   /** Option for now to still use the single threaded code. */
   if (!this->m_UseMultiThread)
   {
@@ -1094,6 +1157,43 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFs(
 } // end ComputePDFs()
 
 
+/**
+ * ************************ ComputePDFsAndSampleCache **************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsAndSampleCache(
+  const ParametersType & parameters) const
+{
+  this->m_SampleCacheFilled = false;
+  if (!this->m_UseSampleCache || !this->m_UseMultiThread)
+  {
+    return this->ComputePDFs(parameters);
+  }
+
+  /** Update the transform and the sampler, see ComputePDFs(). */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  /** Only fill the cache when it fits in the memory budget. The sample
+   * container size is an upper bound for the number of valid samples.
+   */
+  using JacobianIndexType = typename NonZeroJacobianIndicesType::value_type;
+  const double numberOfSamples = this->GetImageSampler()->GetOutput()->Size();
+  const double nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+  const double bytesPerSample =
+    2.0 * sizeof(RealType) + nnzji * (sizeof(DerivativeValueType) + sizeof(JacobianIndexType));
+  this->m_SampleCacheFilled = numberOfSamples * bytesPerSample <= this->m_MaximumSampleCacheMemory * 1024.0 * 1024.0;
+
+  /** Launch multi-threading JointPDF computation. */
+  this->LaunchComputePDFsThreaderCallback();
+
+  /** Gather the results from all threads. */
+  this->AfterThreadedComputePDFs();
+
+} // end ComputePDFsAndSampleCache()
+
+
 /**
  * ******************* ThreadedComputePDFs *******************
  */
@@ -1132,6 +1232,27 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComp
 
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
+  double        sumOfSampleWeights = 0.0;
+  const bool    useSampleWeights = !this->GetImageSampler()->GetSampleWeights().empty();
+
+  /** When requested, also compute and store the results that the derivative
+   * needs. The buffers are sized once for all samples of this thread, so that
+   * they are written without reallocation.
+   */
+  const bool                 fillSampleCache = this->m_SampleCacheFilled;
+  const SizeValueType        nnzji =
+    fillSampleCache ? this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices() : 0;
+  NonZeroJacobianIndicesType nzji(nnzji);
+  DerivativeType             imageJacobian(nnzji);
+  SampleCacheType &          sampleCache = this->m_SampleCaches[threadId];
+  if (fillSampleCache)
+  {
+    const unsigned long numberOfSamplesOfThread = pos_end - pos_begin;
+    sampleCache.m_FixedImageValues.resize(numberOfSamplesOfThread);
+    sampleCache.m_MovingImageValues.resize(numberOfSamplesOfThread);
+    sampleCache.m_ImageJacobians.resize(numberOfSamplesOfThread * nnzji);
+    sampleCache.m_NonZeroJacobianIndices.resize(numberOfSamplesOfThread * nnzji);
+  }
 
   /** Loop over sample container and compute contribution of each sample to pdfs. */
   for (fiter = fbegin; fiter != fend; ++fiter)
@@ -1139,9 +1260,10 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComp
     /** Read fixed coordinates and initialize some variables. */
     const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
     RealType                    movingImageValue;
+    MovingImageDerivativeType   movingImageDerivative;
 
     /** Transform point. */
-    const MovingImagePointType mappedPoint = this->TransformPoint(fixedPoint);
+    const MovingImagePointType mappedPoint = this->TransformSamplePoint(fiter.Index(), fixedPoint);
 
     /** Check if the point is inside the moving mask. */
     bool sampleOk = this->IsInsideMovingMask(mappedPoint);
@@ -1151,28 +1273,63 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComp
      */
     if (sampleOk)
     {
-      sampleOk = this->FastEvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, nullptr, threadId);
+      sampleOk = this->FastEvaluateMovingImageValueAndDerivative(
+        mappedPoint, movingImageValue, fillSampleCache ? &movingImageDerivative : nullptr, threadId);
     }
 
     if (sampleOk)
     {
-      numberOfPixelsCounted++;
-
       /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
+      RealType     fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
+      const double sampleWeight = this->GetSampleWeight(fiter.Index());
 
       /** Make sure the values fall within the histogram range. */
       fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
-      movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue);
+      if (fillSampleCache)
+      {
+        movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue, movingImageDerivative);
+
+        /** Store this sample's results for the derivative. The image Jacobian is
+         * stored with the importance weight of the sample applied.
+         */
+        this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
+          fixedPoint, movingImageDerivative, imageJacobian, nzji);
+        if (useSampleWeights)
+        {
+          imageJacobian *= sampleWeight;
+        }
+        const SizeValueType offset = numberOfPixelsCounted * nnzji;
+        sampleCache.m_FixedImageValues[numberOfPixelsCounted] = fixedImageValue;
+        sampleCache.m_MovingImageValues[numberOfPixelsCounted] = movingImageValue;
+        std::copy(imageJacobian.begin(), imageJacobian.end(), sampleCache.m_ImageJacobians.begin() + offset);
+        std::copy(nzji.begin(), nzji.end(), sampleCache.m_NonZeroJacobianIndices.begin() + offset);
+      }
+      else
+      {
+        movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue);
+      }
+      numberOfPixelsCounted++;
+      sumOfSampleWeights += sampleWeight;
 
       /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateJointPDFAndDerivatives(fixedImageValue, movingImageValue, nullptr, nullptr, jointPDF.GetPointer());
+      if (useSampleWeights)
+      {
+        this->AddToIncrementalPDF(fixedImageValue, movingImageValue, sampleWeight, jointPDF->GetBufferPointer());
+      }
+      else
+      {
+        this->UpdateJointPDFAndDerivatives(
+          fixedImageValue, movingImageValue, nullptr, nullptr, jointPDF.GetPointer());
+      }
     }
   } // end iterating over fixed image spatial sample container for loop
+  sampleCache.m_NumberOfSamples = fillSampleCache ? numberOfPixelsCounted : 0;
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted =
     numberOfPixelsCounted;
+  this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_SumOfSampleWeights =
+    sumOfSampleWeights;
 
 } // end ThreadedComputePDFs()
 
@@ -1187,56 +1344,52 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::AfterThreade
 {
   const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
-  /** Accumulate the number of pixels. */
-  this->m_NumberOfPixelsCounted =
-    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted;
+  /** Accumulate the number of pixels and the sum of their importance weights. */
+  auto * const perThreadVariables = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables.data();
+  this->m_NumberOfPixelsCounted = perThreadVariables[0].st_NumberOfPixelsCounted;
+  const double sumOfSampleWeights =
+    Self::template PairwiseSum<double>(0, numberOfThreads, [perThreadVariables](const ThreadIdType i) {
+      return perThreadVariables[i].st_SumOfSampleWeights;
+    });
   for (ThreadIdType i = 1; i < numberOfThreads; ++i)
   {
-    this->m_NumberOfPixelsCounted +=
-      this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
+    this->m_NumberOfPixelsCounted += perThreadVariables[i].st_NumberOfPixelsCounted;
 
-    /** Reset this variable for the next iteration. */
-    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = 0;
+    /** Reset these variables for the next iteration. */
+    perThreadVariables[i].st_NumberOfPixelsCounted = 0;
+    perThreadVariables[i].st_SumOfSampleWeights = 0.0;
   }
 
   /** Check if enough samples were valid. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
 
-  /** Compute alpha. */
-  this->m_Alpha = 1.0 / static_cast<double>(this->m_NumberOfPixelsCounted);
-
-  /** Accumulate joint histogram. */
-  // could be multi-threaded too, by each thread updating only a part of the JointPDF.
-  using JointPDFIteratorType = ImageScanlineIterator<JointPDFType>;
-  JointPDFIteratorType              it(this->m_JointPDF, this->m_JointPDF->GetBufferedRegion());
-  std::vector<JointPDFIteratorType> itT(numberOfThreads);
-  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
-  {
-    itT[i] = JointPDFIteratorType(this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDF,
-                                  this->m_JointPDF->GetBufferedRegion());
-  }
+  /** Compute alpha. The joint histogram is normalized by the sum of the importance weights,
+   * which is the number of pixels when the samples are not weighted.
+   */
+  this->m_Alpha = 1.0 / sumOfSampleWeights;
 
-  PDFValueType sum;
-  while (!it.IsAtEnd())
+  /** Accumulate joint histogram. The histograms of the threads have the same
+   * layout as the joint PDF, so their buffers are summed element-wise, in
+   * contiguous (vectorizable) loops. The buffers are added in place, pairwise
+   * along a binary tree, so that the result only depends on the number of
+   * work units. The threads refill their histogram in the next iteration.
+   */
+  const SizeValueType numberOfBins = this->m_JointPDF->GetBufferedRegion().GetNumberOfPixels();
+  for (ThreadIdType stride = 1; stride < numberOfThreads; stride *= 2)
   {
-    while (!it.IsAtEndOfLine())
+    for (ThreadIdType i = 0; i + stride < numberOfThreads; i += 2 * stride)
     {
-      sum = NumericTraits<PDFValueType>::Zero;
-      for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+      PDFValueType * const       sumBuffer = perThreadVariables[i].st_JointPDF->GetBufferPointer();
+      const PDFValueType * const addedBuffer = perThreadVariables[i + stride].st_JointPDF->GetBufferPointer();
+      for (SizeValueType j = 0; j < numberOfBins; ++j)
       {
-        sum += itT[i].Value();
-        ++itT[i];
+        sumBuffer[j] += addedBuffer[j];
       }
-      it.Set(sum);
-      ++it;
-    }
-    it.NextLine();
-    for (ThreadIdType i = 0; i < numberOfThreads; ++i)
-    {
-      itT[i].NextLine();
     }
   }
+  std::copy_n(
+    perThreadVariables[0].st_JointPDF->GetBufferPointer(), numberOfBins, this->m_JointPDF->GetBufferPointer());
 
 } // end AfterThreadedComputePDFs()
 
@@ -1250,12 +1403,12 @@ ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
 ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsThreaderCallback(void * arg)
 {
   ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
-  ThreadIdType     threadId = infoStruct->WorkUnitID;
 
   ParzenWindowHistogramMultiThreaderParameterType * temp =
     static_cast<ParzenWindowHistogramMultiThreaderParameterType *>(infoStruct->UserData);
 
-  temp->m_Metric->ThreadedComputePDFs(threadId);
+  temp->m_Metric->ForEachWorkUnitOfThread(
+    *infoStruct, [temp](const ThreadIdType workUnit) { temp->m_Metric->ThreadedComputePDFs(workUnit); });
 
   return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
 
@@ -1609,6 +1762,272 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
 } // end ComputePDFsAndIncrementalPDFs()
 
 
+/**
+ * ************************ ComputePDFsAndSparseIncrementalPDFs *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsAndSparseIncrementalPDFs(
+  const ParametersType & parameters) const
+{
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  /** The threads store the limited image values of each sample at its position in the sample container. */
+  const SizeValueType numberOfSamples = this->GetImageSampler()->GetOutput()->Size();
+  this->m_SampleFixedImageValues.resize(numberOfSamples);
+  this->m_SampleMovingImageValues.resize(numberOfSamples);
+  this->m_PerturbedSamplesPerThread.resize(Self::GetNumberOfWorkUnits());
+
+  /** Launch multi-threading JointPDF computation. */
+  this->m_Threader->SetSingleMethod(
+    this->ComputePDFsAndSparseIncrementalPDFsThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowHistogramThreaderParameters)));
+  this->m_Threader->SingleMethodExecute();
+
+  /** Gather the results of all threads. Samples outside the moving image are
+   * skipped, so the moving mask value of all counted samples equals one.
+   */
+  this->AfterThreadedComputePDFs();
+
+  /** Group the perturbed samples by parameter, by a counting sort. The threads
+   * are merged in a fixed order, so that the result does not depend on timing.
+   */
+  const SizeValueType numberOfParameters = this->GetNumberOfParameters();
+  this->m_PerturbedSampleOffsets.assign(numberOfParameters + 1, 0);
+  for (const auto & perturbedSamples : this->m_PerturbedSamplesPerThread)
+  {
+    for (const auto & perturbedSample : perturbedSamples)
+    {
+      ++this->m_PerturbedSampleOffsets[perturbedSample.m_Parameter + 1];
+    }
+  }
+  std::partial_sum(this->m_PerturbedSampleOffsets.begin(),
+                   this->m_PerturbedSampleOffsets.end(),
+                   this->m_PerturbedSampleOffsets.begin());
+
+  this->m_PerturbedSamples.resize(this->m_PerturbedSampleOffsets.back());
+  std::vector<SizeValueType> positions(this->m_PerturbedSampleOffsets.begin(),
+                                       this->m_PerturbedSampleOffsets.end() - 1);
+  for (auto & perturbedSamples : this->m_PerturbedSamplesPerThread)
+  {
+    for (const auto & perturbedSample : perturbedSamples)
+    {
+      this->m_PerturbedSamples[positions[perturbedSample.m_Parameter]++] = perturbedSample;
+    }
+    perturbedSamples.clear();
+  }
+
+} // end ComputePDFsAndSparseIncrementalPDFs()
+
+
+/**
+ * ******************* ThreadedComputePDFsAndSparseIncrementalPDFs *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComputePDFsAndSparseIncrementalPDFs(
+  ThreadIdType threadId)
+{
+  /** Get a handle to the pre-allocated joint PDF for the current thread. */
+  JointPDFPointer & jointPDF =
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_JointPDF;
+  jointPDF->FillBuffer(NumericTraits<PDFValueType>::ZeroValue());
+
+  /** The perturbed samples of this thread. */
+  std::vector<PerturbedSampleType> & perturbedSamples = this->m_PerturbedSamplesPerThread[threadId];
+  perturbedSamples.clear();
+
+  /** Get a handle to the sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+
+  /** Get the samples for this thread. */
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  /** Create variables to store intermediate results. circumvent false sharing */
+  unsigned long numberOfPixelsCounted = 0;
+  const double  delta = this->GetFiniteDifferencePerturbation();
+
+  /** sparse jacobian+indices. */
+  NonZeroJacobianIndicesType nzji(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+  TransformJacobianType      jacobian;
+
+  /** Loop over the samples of this thread and compute the contribution of each sample to the pdfs. */
+  for (unsigned long pos = pos_begin; pos < pos_end; ++pos)
+  {
+    /** Read fixed coordinates. */
+    const FixedImagePointType & fixedPoint = sampleContainer->ElementAt(pos).m_ImageCoordinates;
+
+    /** Transform point. */
+    const MovingImagePointType mappedPoint = this->TransformSamplePoint(pos, fixedPoint);
+
+    /** Compute the moving image value M(T(x)) and check if the point is inside
+     * the moving mask and the moving image buffer. As in ComputePDFsAndIncrementalPDFs(),
+     * samples that are not, are skipped, also for the perturbed parameters.
+     */
+    RealType movingImageValue = NumericTraits<RealType>::Zero;
+    bool     sampleOk = this->IsInsideMovingMask(mappedPoint);
+    if (sampleOk)
+    {
+      sampleOk = this->FastEvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, nullptr, threadId);
+    }
+    if (!sampleOk)
+    {
+      continue;
+    }
+
+    /** Make sure the values fall within the histogram range. */
+    RealType fixedImageValue = static_cast<RealType>(sampleContainer->ElementAt(pos).m_ImageValue);
+    fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
+    movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue);
+    this->m_SampleFixedImageValues[pos] = fixedImageValue;
+    this->m_SampleMovingImageValues[pos] = movingImageValue;
+    ++numberOfPixelsCounted;
+
+    /** Compute this sample's contribution to the joint distribution. */
+    this->UpdateJointPDFAndDerivatives(fixedImageValue, movingImageValue, nullptr, nullptr, jointPDF.GetPointer());
+
+    /** Get the TransformJacobian dT/dmu. We assume the transform is a linear
+     * function of its parameters, so that we can evaluate T(x;\mu+delta_ek)
+     * as T(x) + delta * dT/dmu_k.
+     */
+    this->EvaluateTransformJacobian(fixedPoint, jacobian, nzji);
+
+    /** Loop over all parameters to perturb (parameters with nonzero Jacobian). */
+    MovingImagePointType mappedPointRight;
+    MovingImagePointType mappedPointLeft;
+    for (unsigned int i = 0; i < nzji.size(); ++i)
+    {
+      /** Compute the transformed input point after perturbation. */
+      for (unsigned int j = 0; j < MovingImageDimension; ++j)
+      {
+        const double delta_jac = delta * jacobian[j][i];
+        mappedPointRight[j] = mappedPoint[j] + delta_jac;
+        mappedPointLeft[j] = mappedPoint[j] - delta_jac;
+      }
+
+      /** Compute the moving image values at the perturbed positions. */
+      PerturbedSampleType perturbedSample;
+      perturbedSample.m_Parameter = nzji[i];
+      perturbedSample.m_Sample = pos;
+      perturbedSample.m_MovingImageValueRight = NumericTraits<RealType>::Zero;
+      perturbedSample.m_MovingImageValueLeft = NumericTraits<RealType>::Zero;
+      perturbedSample.m_IsInsideRight =
+        this->IsInsideMovingMask(mappedPointRight) &&
+        this->FastEvaluateMovingImageValueAndDerivative(
+          mappedPointRight, perturbedSample.m_MovingImageValueRight, nullptr, threadId);
+      perturbedSample.m_IsInsideLeft =
+        this->IsInsideMovingMask(mappedPointLeft) &&
+        this->FastEvaluateMovingImageValueAndDerivative(
+          mappedPointLeft, perturbedSample.m_MovingImageValueLeft, nullptr, threadId);
+      if (perturbedSample.m_IsInsideRight)
+      {
+        perturbedSample.m_MovingImageValueRight =
+          this->GetMovingImageLimiter()->Evaluate(perturbedSample.m_MovingImageValueRight);
+      }
+      if (perturbedSample.m_IsInsideLeft)
+      {
+        perturbedSample.m_MovingImageValueLeft =
+          this->GetMovingImageLimiter()->Evaluate(perturbedSample.m_MovingImageValueLeft);
+      }
+      perturbedSamples.push_back(perturbedSample);
+    } // next parameter to perturb
+  }   // end iterating over fixed image spatial sample container for loop
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted =
+    numberOfPixelsCounted;
+  this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_SumOfSampleWeights =
+    static_cast<double>(numberOfPixelsCounted);
+
+} // end ThreadedComputePDFsAndSparseIncrementalPDFs()
+
+
+/**
+ * **************** ComputePDFsAndSparseIncrementalPDFsThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ParzenWindowHistogramImageToImageMetric<TFixedImage,
+                                        TMovingImage>::ComputePDFsAndSparseIncrementalPDFsThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+
+  ParzenWindowHistogramMultiThreaderParameterType * temp =
+    static_cast<ParzenWindowHistogramMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ForEachWorkUnitOfThread(*infoStruct, [temp](const ThreadIdType workUnit) {
+    temp->m_Metric->ThreadedComputePDFsAndSparseIncrementalPDFs(workUnit);
+  });
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputePDFsAndSparseIncrementalPDFsThreaderCallback()
+
+
+/**
+ * ********************** AddToIncrementalPDF ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+auto
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::AddToIncrementalPDF(
+  const RealType fixedImageValue,
+  const RealType movingImageValue,
+  const double   weight,
+  PDFValueType * incrementalPDF) const -> OffsetValueType
+{
+  /** The Parzen windows contain at most four values, since the kernel orders are at most 3. */
+  PDFValueType       fixedParzenValues[4];
+  PDFValueType       movingParzenValues[4];
+  const unsigned int fixedWindowSize = this->m_JointPDFWindow.GetSize()[1];
+  const unsigned int movingWindowSize = this->m_JointPDFWindow.GetSize()[0];
+
+  /** Determine the Parzen window arguments (see eq. 6 of Mattes paper [2]). */
+  const double fixedImageParzenWindowTerm =
+    fixedImageValue / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
+  const OffsetValueType fixedImageParzenWindowIndex =
+    static_cast<OffsetValueType>(std::floor(fixedImageParzenWindowTerm + this->m_FixedParzenTermToIndexOffset));
+  this->m_FixedKernel->Evaluate(static_cast<double>(fixedImageParzenWindowIndex) - fixedImageParzenWindowTerm,
+                                fixedParzenValues);
+
+  const double movingImageParzenWindowTerm =
+    movingImageValue / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
+  const OffsetValueType movingImageParzenWindowIndex =
+    static_cast<OffsetValueType>(std::floor(movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset));
+  this->m_MovingKernel->Evaluate(static_cast<double>(movingImageParzenWindowIndex) - movingImageParzenWindowTerm,
+                                 movingParzenValues);
+
+  /** Loop over the Parzen window region; the buffer has the layout of the joint pdf. */
+  const OffsetValueType fixedOffset = this->m_JointPDF->GetOffsetTable()[1];
+  const OffsetValueType windowOffset = fixedImageParzenWindowIndex * fixedOffset + movingImageParzenWindowIndex;
+  PDFValueType *        pdfPtr = incrementalPDF + windowOffset;
+  for (unsigned int f = 0; f < fixedWindowSize; ++f, pdfPtr += fixedOffset)
+  {
+    const double fv_weight = fixedParzenValues[f] * weight;
+    for (unsigned int m = 0; m < movingWindowSize; ++m)
+    {
+      pdfPtr[m] += static_cast<PDFValueType>(fv_weight * movingParzenValues[m]);
+    }
+  }
+  return windowOffset;
+
+} // end AddToIncrementalPDF()
+
+
 } // end namespace itk
 
 #endif // end #ifndef itkParzenWindowHistogramImageToImageMetric_hxx
@@ -40,6 +40,9 @@
 #include "itkMacro.h"
 #include "itkSpatialObject.h"
 #include "itkPointSet.h"
+#include "itkPlatformMultiThreader.h"
+
+#include <memory> // For unique_ptr.
 
 namespace itk
 {
@@ -113,6 +116,10 @@ public:
   /** Typedefs for support of sparse Jacobians and compact support of transformations. */
   using NonZeroJacobianIndicesType = typename TransformType::NonZeroJacobianIndicesType;
 
+  /** Typedefs for multi-threading. */
+  using ThreaderType = PlatformMultiThreader;
+  using ThreadInfoType = typename ThreaderType::WorkUnitInfo;
+
   /** Connect the fixed pointset.  */
   itkSetConstObjectMacro(FixedPointSet, FixedPointSetType);
 
@@ -170,6 +177,23 @@ public:
   itkGetConstReferenceMacro(UseMetricSingleThreaded, bool);
   itkBooleanMacro(UseMetricSingleThreaded);
 
+  /** Select the use of multi-threading. Only used by metrics that support it. Default: false. */
+  itkSetMacro(UseMultiThread, bool);
+  itkGetConstReferenceMacro(UseMultiThread, bool);
+  itkBooleanMacro(UseMultiThread);
+
+  /** Set/Get the number of threads to use for computations. */
+  virtual void
+  SetNumberOfWorkUnits(ThreadIdType numberOfThreads)
+  {
+    this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
+  }
+  virtual ThreadIdType
+  GetNumberOfWorkUnits() const
+  {
+    return this->m_Threader->GetNumberOfWorkUnits();
+  }
+
 protected:
   SingleValuedPointSetToPointSetMetric();
   ~SingleValuedPointSetToPointSetMetric() override = default;
@@ -187,8 +211,61 @@ protected:
 
   mutable unsigned int m_NumberOfPointsCounted;
 
+  /** Returns the number of threads used for the computation: the number of
+   * work units of the threader if UseMultiThread is true, and 1 otherwise.
+   */
+  ThreadIdType
+  GetNumberOfThreadsForComputation() const
+  {
+    return this->m_UseMultiThread ? this->m_Threader->GetNumberOfWorkUnits() : 1;
+  }
+
+  /** Initialize the per thread variables. The per thread derivatives are
+   * only (re)allocated when needed, since they are reset by AccumulateDerivatives().
+   */
+  void
+  InitializeThreadingParameters() const;
+
+  /** Sum the per thread derivatives, multiplied by the normalization factor,
+   * into the derivative, and reset them. Multi-threaded, if more than one
+   * thread is used.
+   */
+  void
+  AccumulateDerivatives(DerivativeType & derivative, const DerivativeValueType normalization) const;
+
+  /** AccumulateDerivatives threader callback function. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  AccumulateDerivativesThreaderCallback(void * arg);
+
   /** Variables for multi-threading. */
-  bool m_UseMetricSingleThreaded;
+  bool                           m_UseMetricSingleThreaded;
+  bool                           m_UseMultiThread{ false };
+  typename ThreaderType::Pointer m_Threader;
+
+  struct MultiThreaderParameterType
+  {
+    const Self *          st_Metric;
+    DerivativeValueType * st_DerivativePointer;
+    DerivativeValueType   st_NormalizationFactor;
+  };
+
+  /** The per thread variables, padded to avoid false sharing. */
+  struct GetValueAndDerivativePerThreadStruct
+  {
+    SizeValueType  st_NumberOfPointsCounted;
+    MeasureType    st_Value;
+    DerivativeType st_Derivative;
+  };
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
+               GetValueAndDerivativePerThreadStruct,
+               PaddedGetValueAndDerivativePerThreadStruct);
+  itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT,
+                    PaddedGetValueAndDerivativePerThreadStruct,
+                    AlignedGetValueAndDerivativePerThreadStruct);
+  mutable std::unique_ptr<AlignedGetValueAndDerivativePerThreadStruct[]> m_GetValueAndDerivativePerThreadVariables{
+    nullptr
+  };
+  mutable ThreadIdType m_GetValueAndDerivativePerThreadVariablesSize{ 0 };
 
 private:
   SingleValuedPointSetToPointSetMetric(const Self &) = delete;
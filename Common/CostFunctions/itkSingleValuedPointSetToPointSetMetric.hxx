@@ -36,6 +36,8 @@
 
 #include "itkSingleValuedPointSetToPointSetMetric.h"
 
+#include <algorithm> // For min.
+
 namespace itk
 {
 
@@ -55,6 +57,7 @@ SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::SingleVal
   this->m_NumberOfPointsCounted = 0;
 
   this->m_UseMetricSingleThreaded = true;
+  this->m_Threader = ThreaderType::New();
 
 } // end Constructor
 
@@ -133,6 +136,116 @@ SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::BeforeThr
 } // end BeforeThreadedGetValueAndDerivative()
 
 
+/**
+ * ******************* InitializeThreadingParameters ***********************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+void
+SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::InitializeThreadingParameters() const
+{
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreadsForComputation();
+
+  /** Only resize the array of structs when needed. */
+  if (this->m_GetValueAndDerivativePerThreadVariablesSize != numberOfThreads)
+  {
+    this->m_GetValueAndDerivativePerThreadVariables.reset(
+      new AlignedGetValueAndDerivativePerThreadStruct[numberOfThreads]);
+    this->m_GetValueAndDerivativePerThreadVariablesSize = numberOfThreads;
+  }
+
+  /** Some initialization. The derivatives are reset by AccumulateDerivatives(). */
+  const unsigned int numberOfParameters = this->GetNumberOfParameters();
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    auto & perThreadVariables = this->m_GetValueAndDerivativePerThreadVariables[i];
+    perThreadVariables.st_NumberOfPointsCounted = NumericTraits<SizeValueType>::Zero;
+    perThreadVariables.st_Value = NumericTraits<MeasureType>::Zero;
+    if (perThreadVariables.st_Derivative.GetSize() != numberOfParameters)
+    {
+      perThreadVariables.st_Derivative.SetSize(numberOfParameters);
+      perThreadVariables.st_Derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+    }
+  }
+
+} // end InitializeThreadingParameters()
+
+
+/**
+ * ******************* AccumulateDerivatives ***********************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+void
+SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::AccumulateDerivatives(
+  DerivativeType &          derivative,
+  const DerivativeValueType normalization) const
+{
+  derivative.SetSize(this->GetNumberOfParameters());
+
+  if (this->m_GetValueAndDerivativePerThreadVariablesSize == 1)
+  {
+    DerivativeType & threadDerivative = this->m_GetValueAndDerivativePerThreadVariables[0].st_Derivative;
+    derivative = threadDerivative * normalization;
+    threadDerivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+    return;
+  }
+
+  MultiThreaderParameterType threaderParameters;
+  threaderParameters.st_Metric = this;
+  threaderParameters.st_DerivativePointer = derivative.begin();
+  threaderParameters.st_NormalizationFactor = normalization;
+
+  this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback, &threaderParameters);
+  this->m_Threader->SingleMethodExecute();
+
+} // end AccumulateDerivatives()
+
+
+/**
+ * ******************* AccumulateDerivativesThreaderCallback ***********************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+SingleValuedPointSetToPointSetMetric<TFixedPointSet, TMovingPointSet>::AccumulateDerivativesThreaderCallback(
+  void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  const auto * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+  const Self & metric = *temp->st_Metric;
+
+  const unsigned int numPar = metric.GetNumberOfParameters();
+  const unsigned int subSize = (numPar + nrOfThreads - 1) / nrOfThreads;
+  const unsigned int jmin = std::min(threadID * subSize, numPar);
+  const unsigned int jmax = std::min(jmin + subSize, numPar);
+
+  /** This thread accumulates all sub-derivatives into a single one, for the
+   * range [ jmin, jmax [. Additionally, the sub-derivatives are reset.
+   */
+  const DerivativeValueType zero = NumericTraits<DerivativeValueType>::Zero;
+  const ThreadIdType        numberOfPerThreadVariables = metric.m_GetValueAndDerivativePerThreadVariablesSize;
+  for (unsigned int j = jmin; j < jmax; ++j)
+  {
+    DerivativeValueType tmp = zero;
+    for (ThreadIdType i = 0; i < numberOfPerThreadVariables; ++i)
+    {
+      tmp += metric.m_GetValueAndDerivativePerThreadVariables[i].st_Derivative[j];
+
+      /** Reset this variable for the next iteration. */
+      metric.m_GetValueAndDerivativePerThreadVariables[i].st_Derivative[j] = zero;
+    }
+    temp->st_DerivativePointer[j] = tmp * temp->st_NormalizationFactor;
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end AccumulateDerivativesThreaderCallback()
+
+
 /**
  * ******************* PrintSelf ***********************
  */
@@ -19,8 +19,73 @@
 // First include the header file to be tested:
 #include "elxElastixMain.h"
 
+#include "elxMetricGTestUtilities.h"
+#include "itkParameterFileParser.h"
+
+#include <itkFileTools.h>
+
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
+
+namespace
+{
+using ParameterMapType = elx::ElastixMain::ParameterMapType;
+
+
+/** Registers two blob images by a B-spline transform in two resolutions, writing a checkpoint every four
+ * iterations, and returns the final transform parameters.
+ */
+std::vector<std::string>
+RegisterWithCheckpoints(const std::string & outputDirectoryPath,
+                        const std::string & lastMaximumNumberOfIterations,
+                        const bool          resume)
+{
+  const auto fixedImageContainer = elx::ElastixMain::DataObjectContainerType::New();
+  const auto movingImageContainer = elx::ElastixMain::DataObjectContainerType::New();
+  fixedImageContainer->CreateElementAt(0) = elx::MetricGTestUtilities::CreateBlobImage(15.0, 16.0);
+  movingImageContainer->CreateElementAt(0) = elx::MetricGTestUtilities::CreateBlobImage(17.0, 14.5);
+
+  const ParameterMapType parameterMap{ // Parameters in alphabetic order:
+                                       { "CheckpointInterval", { "4" } },
+                                       { "FinalGridSpacingInVoxels", { "8" } },
+                                       { "FixedImageDimension", { "2" } },
+                                       { "FixedImagePyramid", { "FixedSmoothingImagePyramid" } },
+                                       { "FixedInternalImagePixelType", { "float" } },
+                                       { "ImageSampler", { "Full" } },
+                                       { "Interpolator", { "BSplineInterpolator" } },
+                                       { "MaximumNumberOfIterations", { "8", lastMaximumNumberOfIterations } },
+                                       { "Metric", { "AdvancedNormalizedCorrelation" } },
+                                       { "MovingImageDimension", { "2" } },
+                                       { "MovingImagePyramid", { "MovingSmoothingImagePyramid" } },
+                                       { "MovingInternalImagePixelType", { "float" } },
+                                       { "NumberOfResolutions", { "2" } },
+                                       { "Optimizer", { "AdaptiveStochasticGradientDescent" } },
+                                       { "Registration", { "MultiResolutionRegistration" } },
+                                       { "ResampleInterpolator", { "FinalBSplineInterpolator" } },
+                                       { "Resampler", { "DefaultResampler" } },
+                                       { "Transform", { "BSplineTransform" } },
+                                       { "WriteResultImage", { "false" } }
+  };
+
+  elx::ElastixMain::ArgumentMapType argumentMap{ { "-argv0", "elastix" }, { "-out", outputDirectoryPath + '/' } };
+  if (resume)
+  {
+    argumentMap["-resume"] = "true";
+  }
+
+  const auto elastixMain = elx::ElastixMain::New();
+  elastixMain->SetFixedImageContainer(fixedImageContainer);
+  elastixMain->SetMovingImageContainer(movingImageContainer);
+  EXPECT_EQ(elastixMain->Run(argumentMap, parameterMap), 0);
+
+  return elastixMain->GetTransformParametersMap()["TransformParameters"];
+}
+
+} // namespace
+
 
 // Tests retrieving the component data base and a component creator in parallel.
 GTEST_TEST(ElastixMain, GetComponentDatabaseAndCreatorInParallel)
@@ -43,3 +108,33 @@ GTEST_TEST(ElastixMain, GetComponentDatabaseAndCreatorInParallel)
     }
   }
 }
+
+
+// Tests that a registration that is resumed from a checkpoint in the last resolution ends with the same transform
+// parameters as the registration that is not interrupted. The B-spline grid of the skipped first resolution must be
+// refined as usual, for the checkpoint to fit.
+GTEST_TEST(ElastixMain, ResumeFromCheckpoint)
+{
+  const elx::xoutManager manager("", false, false);
+
+  const std::string rootOutputDirectoryPath =
+    std::string(ELX_CMAKE_CURRENT_BINARY_DIR) + "/ElastixMain_ResumeFromCheckpoint";
+  const std::string uninterruptedOutputDirectoryPath = rootOutputDirectoryPath + "/Uninterrupted";
+  const std::string interruptedOutputDirectoryPath = rootOutputDirectoryPath + "/Interrupted";
+  itk::FileTools::CreateDirectory(uninterruptedOutputDirectoryPath);
+  itk::FileTools::CreateDirectory(interruptedOutputDirectoryPath);
+
+  const auto expectedTransformParameters = RegisterWithCheckpoints(uninterruptedOutputDirectoryPath, "8", false);
+  ASSERT_FALSE(expectedTransformParameters.empty());
+
+  /** Stop after the first checkpoint of the second resolution, as if the registration were interrupted there. */
+  const auto interruptedTransformParameters = RegisterWithCheckpoints(interruptedOutputDirectoryPath, "4", false);
+  EXPECT_NE(interruptedTransformParameters, expectedTransformParameters);
+
+  const auto checkpoint =
+    itk::ParameterFileParser::ReadParameterMap(interruptedOutputDirectoryPath + "/Checkpoint.0.txt");
+  EXPECT_EQ(checkpoint.at("CheckpointResolution"), std::vector<std::string>{ "1" });
+  EXPECT_EQ(checkpoint.at("CheckpointIteration"), std::vector<std::string>{ "3" });
+
+  EXPECT_EQ(RegisterWithCheckpoints(interruptedOutputDirectoryPath, "8", true), expectedTransformParameters);
+}
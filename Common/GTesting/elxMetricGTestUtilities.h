@@ -0,0 +1,257 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxMetricGTestUtilities_h
+#define elxMetricGTestUtilities_h
+
+#include "elxGTestUtilities.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkExponentialLimiterFunction.h"
+#include "itkHardLimiterFunction.h"
+#include "itkImage.h"
+#include "itkImageBufferRange.h"
+#include "itkImageFullSampler.h"
+#include "itkImageSamplerBase.h"
+
+#include <cmath>
+#include <utility> // For move.
+#include <vector>
+
+namespace elastix
+{
+namespace MetricGTestUtilities
+{
+
+using ImageType = itk::Image<float, 2>;
+using BSplineTransformType = itk::AdvancedBSplineDeformableTransform<double, 2, 3>;
+
+
+/// Creates a smooth image with a blob and some texture, centered at the specified position, in voxels.
+inline ImageType::Pointer
+CreateBlobImage(const double centerX, const double centerY)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 32, 32 } });
+  image->Allocate();
+
+  const itk::ImageBufferRange<ImageType> range(*image);
+  auto                                   pixel = range.begin();
+  for (unsigned int y = 0; y < 32; ++y)
+  {
+    for (unsigned int x = 0; x < 32; ++x, ++pixel)
+    {
+      const double dx = x - centerX;
+      const double dy = y - centerY;
+      *pixel = static_cast<float>(100.0 * std::exp(-(dx * dx + dy * dy) / 50.0) + 10.0 * std::sin(0.7 * x) +
+                                  5.0 * std::cos(0.5 * y));
+    }
+  }
+  return image;
+}
+
+
+/// Creates a B-spline transform with a grid of 6 x 6 control points over the image, and pseudo random coefficients.
+inline BSplineTransformType::Pointer
+CreateBSplineTransform(const ImageType & image)
+{
+  const auto transform = BSplineTransformType::New();
+
+  BSplineTransformType::OriginType  gridOrigin;
+  BSplineTransformType::SpacingType gridSpacing;
+  for (unsigned int d = 0; d < 2; ++d)
+  {
+    gridSpacing[d] = image.GetSpacing()[d] * (image.GetLargestPossibleRegion().GetSize(d) - 1) / 3.0;
+    gridOrigin[d] = image.GetOrigin()[d] - gridSpacing[d];
+  }
+  transform->SetGridOrigin(gridOrigin);
+  transform->SetGridSpacing(gridSpacing);
+  transform->SetGridRegion(BSplineTransformType::RegionType(BSplineTransformType::SizeType{ { 6, 6 } }));
+  transform->SetGridDirection(image.GetDirection());
+  transform->SetParameters(GTestUtilities::GeneratePseudoRandomParameters(transform->GetNumberOfParameters(), -1.0));
+  return transform;
+}
+
+
+/// Sampler that outputs a given list of samples, with given importance weights.
+class ListSampler : public itk::ImageSamplerBase<ImageType>
+{
+public:
+  using Self = ListSampler;
+  using Superclass = itk::ImageSamplerBase<ImageType>;
+  using Pointer = itk::SmartPointer<Self>;
+
+  itkNewMacro(Self);
+  itkTypeMacro(ListSampler, ImageSamplerBase);
+
+  /// Sets the samples, at the centers of the specified voxels, and their weights (empty for uniform weights).
+  void
+  SetSamples(const ImageType & image, const std::vector<ImageType::IndexType> & indices, std::vector<double> weights)
+  {
+    m_Samples.clear();
+    for (const auto & index : indices)
+    {
+      ImageSampleType sample;
+      image.TransformIndexToPhysicalPoint(index, sample.m_ImageCoordinates);
+      sample.m_ImageValue = image.GetPixel(index);
+      m_Samples.push_back(sample);
+    }
+    m_Weights = std::move(weights);
+    this->Modified();
+  }
+
+protected:
+  ListSampler() = default;
+
+  void
+  GenerateData() override
+  {
+    this->GetOutput()->CastToSTLContainer() = m_Samples;
+    this->m_SampleWeights = m_Weights;
+  }
+
+private:
+  std::vector<ImageSampleType> m_Samples;
+  std::vector<double>          m_Weights;
+};
+
+
+/// Gives the metric the limiters of elastix (a hard one for the fixed image, an exponential one for the moving
+/// image), in so far as the metric uses limiters, like the Parzen window metrics.
+template <class TMetric>
+void
+SetLimiters(TMetric & metric)
+{
+  using RealType = typename TMetric::RealType;
+
+  if (metric.GetUseFixedImageLimiter())
+  {
+    metric.SetFixedImageLimiter(itk::HardLimiterFunction<RealType, ImageType::ImageDimension>::New());
+  }
+  if (metric.GetUseMovingImageLimiter())
+  {
+    metric.SetMovingImageLimiter(itk::ExponentialLimiterFunction<RealType, ImageType::ImageDimension>::New());
+  }
+}
+
+
+/// Connects the images, the sampler, a cubic B-spline interpolator, the limiters and the transform to the metric,
+/// and initializes it.
+template <class TMetric>
+void
+InitializeMetric(TMetric &                          metric,
+                 const ImageType &                  fixedImage,
+                 const ImageType &                  movingImage,
+                 BSplineTransformType &             transform,
+                 itk::ImageSamplerBase<ImageType> & sampler)
+{
+  using InterpolatorType = itk::BSplineInterpolateImageFunction<ImageType, double, double>;
+
+  const auto interpolator = InterpolatorType::New();
+  interpolator->SetSplineOrder(3);
+
+  metric.SetFixedImage(&fixedImage);
+  metric.SetMovingImage(&movingImage);
+  metric.SetFixedImageRegion(fixedImage.GetBufferedRegion());
+  metric.SetImageSampler(&sampler);
+  metric.SetInterpolator(interpolator);
+  metric.SetTransform(&transform);
+  SetLimiters(metric);
+  metric.Initialize();
+}
+
+
+/// Initializes the metric as above, with a full sampler.
+template <class TMetric>
+void
+InitializeMetric(TMetric &              metric,
+                 const ImageType &      fixedImage,
+                 const ImageType &      movingImage,
+                 BSplineTransformType & transform)
+{
+  InitializeMetric(metric, fixedImage, movingImage, transform, *itk::ImageFullSampler<ImageType>::New());
+}
+
+/// Expects that weighting the samples by 2 and 0 gives the value and derivative of the metric with the samples
+/// of weight 2 taken twice and the samples of weight 0 left out. The configure function sets the metric up,
+/// before it is initialized.
+template <class TMetric, class TConfigure>
+void
+ExpectWeightedSamplesEqualDuplicatedSamples(const TConfigure & configure)
+{
+  const auto fixedImage = CreateBlobImage(15.0, 16.0);
+  const auto movingImage = CreateBlobImage(17.0, 14.5);
+  const auto transform = CreateBSplineTransform(*fixedImage);
+
+  /** The samples are inside a margin, so that they are mapped inside the moving image. */
+  std::vector<ImageType::IndexType> indices;
+  std::vector<double>               weights;
+  std::vector<ImageType::IndexType> duplicatedIndices;
+  for (itk::IndexValueType y = 4; y < 28; ++y)
+  {
+    for (itk::IndexValueType x = 4; x < 28; ++x)
+    {
+      const ImageType::IndexType index{ { x, y } };
+      const bool                 isWeighted = (x + y) % 2 == 0;
+      indices.push_back(index);
+      weights.push_back(isWeighted ? 2.0 : 0.0);
+      if (isWeighted)
+      {
+        duplicatedIndices.push_back(index);
+        duplicatedIndices.push_back(index);
+      }
+    }
+  }
+
+  const auto weightedSampler = ListSampler::New();
+  weightedSampler->SetSamples(*fixedImage, indices, weights);
+  const auto duplicatedSampler = ListSampler::New();
+  duplicatedSampler->SetSamples(*fixedImage, duplicatedIndices, {});
+
+  const auto getValueAndDerivative = [&](ListSampler & sampler,
+                                         typename TMetric::MeasureType &    value,
+                                         typename TMetric::DerivativeType & derivative) {
+    const auto metric = TMetric::New();
+    configure(*metric);
+    InitializeMetric(*metric, *fixedImage, *movingImage, *transform, sampler);
+    metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+  };
+
+  typename TMetric::MeasureType    weightedValue{};
+  typename TMetric::DerivativeType weightedDerivative;
+  getValueAndDerivative(*weightedSampler, weightedValue, weightedDerivative);
+
+  typename TMetric::MeasureType    duplicatedValue{};
+  typename TMetric::DerivativeType duplicatedDerivative;
+  getValueAndDerivative(*duplicatedSampler, duplicatedValue, duplicatedDerivative);
+
+  EXPECT_NE(weightedValue, 0.0);
+  EXPECT_NEAR(weightedValue, duplicatedValue, 1e-10 * std::abs(duplicatedValue));
+  ASSERT_EQ(weightedDerivative.size(), duplicatedDerivative.size());
+  const double tolerance = 1e-10 * duplicatedDerivative.inf_norm();
+  for (unsigned int k = 0; k < weightedDerivative.size(); ++k)
+  {
+    EXPECT_NEAR(weightedDerivative[k], duplicatedDerivative[k], tolerance) << "parameter " << k;
+  }
+}
+
+} // namespace MetricGTestUtilities
+} // namespace elastix
+
+
+#endif
@@ -0,0 +1,124 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkAdvancedImageToImageMetric.h"
+
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+
+#include "elxMetricGTestUtilities.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace
+{
+using elastix::MetricGTestUtilities::ImageType;
+using MeanSquaresMetricType = itk::AdvancedMeanSquaresImageToImageMetric<ImageType, ImageType>;
+using MutualInformationMetricType = itk::ParzenWindowMutualInformationImageToImageMetric<ImageType, ImageType>;
+
+/** More work units than most of the numbers of threads, and not a multiple of them. */
+constexpr itk::ThreadIdType deterministicNumberOfWorkUnits = 5;
+
+
+/** Computes the value and derivative of the metric, multi-threaded with the specified numbers of threads and work
+ * units. The configure function sets the metric up, before it is initialized.
+ */
+template <class TMetric, class TConfigure>
+void
+GetValueAndDerivative(const TConfigure &                 configure,
+                      const itk::ThreadIdType            numberOfThreads,
+                      const itk::ThreadIdType            numberOfWorkUnits,
+                      typename TMetric::MeasureType &    value,
+                      typename TMetric::DerivativeType & derivative)
+{
+  const auto fixedImage = elastix::MetricGTestUtilities::CreateBlobImage(15.0, 16.0);
+  const auto movingImage = elastix::MetricGTestUtilities::CreateBlobImage(17.0, 14.5);
+  const auto transform = elastix::MetricGTestUtilities::CreateBSplineTransform(*fixedImage);
+
+  const auto metric = TMetric::New();
+  configure(*metric);
+  metric->SetUseMultiThread(true);
+  metric->SetNumberOfWorkUnits(numberOfThreads);
+  metric->SetDeterministicNumberOfWorkUnits(numberOfWorkUnits);
+  elastix::MetricGTestUtilities::InitializeMetric(*metric, *fixedImage, *movingImage, *transform);
+
+  EXPECT_EQ(metric->GetNumberOfWorkUnits(), numberOfWorkUnits > 0 ? numberOfWorkUnits : numberOfThreads);
+  metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+}
+
+
+/** Expects that the results with a deterministic number of work units are bit-identical for 1, 3 and 8 threads,
+ * and that they equal the results of a single work unit, up to the rounding of the sums.
+ */
+template <class TMetric, class TConfigure>
+void
+ExpectResultsIndependentOfNumberOfThreads(const TConfigure & configure)
+{
+  typename TMetric::MeasureType    referenceValue{};
+  typename TMetric::DerivativeType referenceDerivative;
+  GetValueAndDerivative<TMetric>(configure, 1, 0, referenceValue, referenceDerivative);
+
+  typename TMetric::MeasureType    expectedValue{};
+  typename TMetric::DerivativeType expectedDerivative;
+  GetValueAndDerivative<TMetric>(configure, 1, deterministicNumberOfWorkUnits, expectedValue, expectedDerivative);
+
+  /** All work units are evaluated, also when there are more of them than threads. */
+  EXPECT_NEAR(expectedValue, referenceValue, 1e-10 * std::abs(referenceValue));
+  ASSERT_EQ(expectedDerivative.size(), referenceDerivative.size());
+  const double tolerance = 1e-10 * referenceDerivative.inf_norm();
+  for (unsigned int k = 0; k < expectedDerivative.size(); ++k)
+  {
+    EXPECT_NEAR(expectedDerivative[k], referenceDerivative[k], tolerance) << "parameter " << k;
+  }
+
+  for (const itk::ThreadIdType numberOfThreads : { 3, 8 })
+  {
+    typename TMetric::MeasureType    value{};
+    typename TMetric::DerivativeType derivative;
+    GetValueAndDerivative<TMetric>(configure, numberOfThreads, deterministicNumberOfWorkUnits, value, derivative);
+
+    EXPECT_EQ(value, expectedValue) << numberOfThreads << " threads";
+    EXPECT_EQ(derivative, expectedDerivative) << numberOfThreads << " threads";
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(AdvancedImageToImageMetric, DeterministicNumberOfWorkUnitsMeanSquares)
+{
+  ExpectResultsIndependentOfNumberOfThreads<MeanSquaresMetricType>([](MeanSquaresMetricType &) {});
+}
+
+
+GTEST_TEST(AdvancedImageToImageMetric, DeterministicNumberOfWorkUnitsMutualInformation)
+{
+  for (const bool useExplicitPDFDerivatives : { false, true })
+  {
+    ExpectResultsIndependentOfNumberOfThreads<MutualInformationMetricType>(
+      [useExplicitPDFDerivatives](MutualInformationMetricType & metric) {
+        metric.SetNumberOfFixedHistogramBins(16);
+        metric.SetNumberOfMovingHistogramBins(16);
+        metric.SetUseExplicitPDFDerivatives(useExplicitPDFDerivatives);
+      });
+  }
+}
@@ -0,0 +1,110 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+
+#include "elxMetricGTestUtilities.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+using elastix::MetricGTestUtilities::ImageType;
+using elastix::MetricGTestUtilities::ListSampler;
+using MetricType = itk::AdvancedMeanSquaresImageToImageMetric<ImageType, ImageType>;
+} // namespace
+
+
+GTEST_TEST(AdvancedMeanSquaresImageToImageMetric, WeightedSamplesEqualDuplicatedSamples)
+{
+  for (const bool useMultiThread : { false, true })
+  {
+    elastix::MetricGTestUtilities::ExpectWeightedSamplesEqualDuplicatedSamples<MetricType>(
+      [useMultiThread](MetricType & metric) { metric.SetUseMultiThread(useMultiThread); });
+  }
+}
+
+
+GTEST_TEST(AdvancedMeanSquaresImageToImageMetric, WeightedSamplesAreNormalizedBySumOfWeights)
+{
+  const auto fixedImage = elastix::MetricGTestUtilities::CreateBlobImage(15.0, 16.0);
+  const auto movingImage = elastix::MetricGTestUtilities::CreateBlobImage(17.0, 14.5);
+  const auto transform = elastix::MetricGTestUtilities::CreateBSplineTransform(*fixedImage);
+
+  /** Weights of 3 and 0, so that the sum of the weights differs from the number of samples. */
+  std::vector<ImageType::IndexType> indices;
+  std::vector<double>               weights;
+  std::vector<ImageType::IndexType> weightedIndices;
+  for (itk::IndexValueType y = 4; y < 28; ++y)
+  {
+    for (itk::IndexValueType x = 4; x < 28; ++x)
+    {
+      const ImageType::IndexType index{ { x, y } };
+      const bool                 isWeighted = (x + y) % 2 == 0;
+      indices.push_back(index);
+      weights.push_back(isWeighted ? 3.0 : 0.0);
+      if (isWeighted)
+      {
+        weightedIndices.push_back(index);
+      }
+    }
+  }
+
+  const auto weightedSampler = ListSampler::New();
+  weightedSampler->SetSamples(*fixedImage, indices, weights);
+  const auto uniformSampler = ListSampler::New();
+  uniformSampler->SetSamples(*fixedImage, weightedIndices, {});
+
+  for (const bool useMultiThread : { false, true })
+  {
+    const auto getValueAndDerivative = [&](ListSampler &                sampler,
+                                           MetricType::MeasureType &    value,
+                                           MetricType::DerivativeType & derivative) {
+      const auto metric = MetricType::New();
+      metric->SetUseMultiThread(useMultiThread);
+      elastix::MetricGTestUtilities::InitializeMetric(*metric, *fixedImage, *movingImage, *transform, sampler);
+      metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+
+      /** GetValue() normalizes the value in the same way. */
+      EXPECT_NEAR(metric->GetValue(transform->GetParameters()), value, 1e-12 * std::abs(value));
+    };
+
+    MetricType::MeasureType    weightedValue{};
+    MetricType::DerivativeType weightedDerivative;
+    getValueAndDerivative(*weightedSampler, weightedValue, weightedDerivative);
+
+    /** The mean over the samples of weight 3, rather than 3 / 2 times that mean. */
+    MetricType::MeasureType    uniformValue{};
+    MetricType::DerivativeType uniformDerivative;
+    getValueAndDerivative(*uniformSampler, uniformValue, uniformDerivative);
+
+    EXPECT_NE(uniformValue, 0.0);
+    EXPECT_NEAR(weightedValue, uniformValue, 1e-10 * std::abs(uniformValue));
+    ASSERT_EQ(weightedDerivative.size(), uniformDerivative.size());
+    const double tolerance = 1e-10 * uniformDerivative.inf_norm();
+    for (unsigned int k = 0; k < weightedDerivative.size(); ++k)
+    {
+      EXPECT_NEAR(weightedDerivative[k], uniformDerivative[k], tolerance) << "parameter " << k;
+    }
+  }
+}
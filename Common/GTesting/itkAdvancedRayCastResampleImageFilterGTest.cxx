@@ -0,0 +1,129 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkAdvancedRayCastResampleImageFilter.h"
+
+#include "itkImage.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTranslationTransform.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm> // For max.
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using ImageType = itk::Image<float, Dimension>;
+using RayCasterType = itk::AdvancedRayCastInterpolateImageFunction<ImageType, double>;
+using FilterType = itk::AdvancedRayCastResampleImageFilter<ImageType, ImageType, double>;
+using TransformType = itk::TranslationTransform<double, Dimension>;
+
+
+/** A volume with a small bright cube, surrounded by much empty space. */
+ImageType::Pointer
+CreateVolume()
+{
+  const auto volume = ImageType::New();
+  volume->SetRegions(ImageType::SizeType{ { 24, 20, 22 } });
+  volume->Allocate(true);
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it(volume, volume->GetBufferedRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    const auto index = it.GetIndex();
+    if (index[0] >= 9 && index[0] < 15 && index[1] >= 7 && index[1] < 12 && index[2] >= 8 && index[2] < 14)
+    {
+      it.Set(100.0f + index[0] + index[1] + index[2]);
+    }
+  }
+  return volume;
+}
+
+
+/** Generates the projection of the volume on a detector plane. */
+ImageType::Pointer
+Project(const ImageType * volume, RayCasterType * rayCaster)
+{
+  const auto transform = TransformType::New();
+  rayCaster->SetTransform(transform);
+  rayCaster->SetFocalPoint(itk::MakePoint(0.5, -0.5, -200.0));
+  rayCaster->SetThreshold(1.0);
+
+  const auto filter = FilterType::New();
+  filter->SetInput(volume);
+  filter->SetInterpolator(rayCaster);
+  filter->SetTransform(transform);
+  filter->SetSize(ImageType::SizeType{ { 32, 30, 1 } });
+  filter->SetOutputOrigin(itk::MakePoint(-15.5, -14.5, 100.0));
+  filter->SetOutputSpacing(itk::MakeVector(1.0, 1.0, 1.0));
+  filter->SetDefaultPixelValue(0);
+  filter->Update();
+
+  return filter->GetOutput();
+}
+
+} // namespace
+
+
+GTEST_TEST(AdvancedRayCastResampleImageFilter, ProjectionEqualsEvaluateAtEachPixel)
+{
+  const auto volume = CreateVolume();
+  const auto rayCaster = RayCasterType::New();
+  const auto projection = Project(volume, rayCaster);
+
+  float maximum = 0.0f;
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it(projection, projection->GetBufferedRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    ImageType::PointType point;
+    projection->TransformIndexToPhysicalPoint(it.GetIndex(), point);
+    EXPECT_FLOAT_EQ(it.Get(), rayCaster->Evaluate(point));
+    maximum = std::max(maximum, it.Get());
+  }
+
+  /** Make sure that the rays actually hit the cube. */
+  EXPECT_GT(maximum, 100.0f);
+}
+
+
+GTEST_TEST(AdvancedRayCastResampleImageFilter, OccupancyGridDoesNotChangeTheProjection)
+{
+  const auto volume = CreateVolume();
+
+  const auto rayCaster = RayCasterType::New();
+  const auto projection = Project(volume, rayCaster);
+
+  for (const unsigned int blockSize : { 1, 3, 8, 32 })
+  {
+    const auto rayCasterWithGrid = RayCasterType::New();
+    rayCasterWithGrid->SetUseOccupancyGrid(true);
+    rayCasterWithGrid->SetOccupancyBlockSize(blockSize);
+    const auto projectionWithGrid = Project(volume, rayCasterWithGrid);
+
+    itk::ImageRegionConstIterator<ImageType> it(projection, projection->GetBufferedRegion());
+    itk::ImageRegionConstIterator<ImageType> itWithGrid(projectionWithGrid, projectionWithGrid->GetBufferedRegion());
+    for (; !it.IsAtEnd(); ++it, ++itWithGrid)
+    {
+      EXPECT_NEAR(itWithGrid.Get(), it.Get(), 1e-4 * (1.0 + it.Get()));
+    }
+  }
+}
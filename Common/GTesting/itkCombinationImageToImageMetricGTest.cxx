@@ -0,0 +1,202 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "MultiMetricMultiResolutionRegistration/itkCombinationImageToImageMetric.h"
+
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+
+#include "elxMetricGTestUtilities.h"
+
+#include "itkBSplineInterpolateImageFunction.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+using elastix::MetricGTestUtilities::BSplineTransformType;
+using elastix::MetricGTestUtilities::ImageType;
+using elastix::MetricGTestUtilities::ListSampler;
+using CombinationMetricType = itk::CombinationImageToImageMetric<ImageType, ImageType>;
+using MeanSquaresMetricType = itk::AdvancedMeanSquaresImageToImageMetric<ImageType, ImageType>;
+using MutualInformationMetricType = itk::ParzenWindowMutualInformationImageToImageMetric<ImageType, ImageType>;
+using ParametersType = CombinationMetricType::ParametersType;
+
+
+/** Returns the indices of the voxels inside a margin, in steps of the specified size. */
+std::vector<ImageType::IndexType>
+GetSampleIndices(const itk::IndexValueType step)
+{
+  std::vector<ImageType::IndexType> indices;
+  for (itk::IndexValueType y = 4; y < 28; y += step)
+  {
+    for (itk::IndexValueType x = 4; x < 28; x += step)
+    {
+      indices.push_back({ { x, y } });
+    }
+  }
+  return indices;
+}
+
+
+/** Combines a mean squares and a mutual information metric, each with its own sampler. */
+CombinationMetricType::Pointer
+CreateCombinationMetric(const ImageType &      fixedImage,
+                        const ImageType &      movingImage,
+                        BSplineTransformType & transform,
+                        ListSampler &          meanSquaresSampler,
+                        ListSampler &          mutualInformationSampler,
+                        const bool             shareImageSamplers)
+{
+  using InterpolatorType = itk::BSplineInterpolateImageFunction<ImageType, double, double>;
+
+  const auto meanSquaresMetric = MeanSquaresMetricType::New();
+  meanSquaresMetric->SetImageSampler(&meanSquaresSampler);
+
+  const auto mutualInformationMetric = MutualInformationMetricType::New();
+  mutualInformationMetric->SetNumberOfFixedHistogramBins(16);
+  mutualInformationMetric->SetNumberOfMovingHistogramBins(16);
+  mutualInformationMetric->SetImageSampler(&mutualInformationSampler);
+  elastix::MetricGTestUtilities::SetLimiters(*mutualInformationMetric);
+
+  const auto combinationMetric = CombinationMetricType::New();
+  combinationMetric->SetNumberOfMetrics(2);
+  combinationMetric->SetMetric(meanSquaresMetric, 0);
+  combinationMetric->SetMetric(mutualInformationMetric, 1);
+  for (unsigned int i = 0; i < 2; ++i)
+  {
+    const auto interpolator = InterpolatorType::New();
+    interpolator->SetSplineOrder(3);
+    combinationMetric->SetInterpolator(interpolator, i);
+    combinationMetric->SetMetricWeight(1.0, i);
+  }
+  combinationMetric->SetFixedImage(&fixedImage);
+  combinationMetric->SetMovingImage(&movingImage);
+  combinationMetric->SetFixedImageRegion(fixedImage.GetBufferedRegion());
+  combinationMetric->SetTransform(&transform);
+  combinationMetric->SetShareImageSamplers(shareImageSamplers);
+  combinationMetric->Initialize();
+  return combinationMetric;
+}
+
+
+/** Expects that the combination metric gives the same value and derivative as an equivalent combination metric
+ * that does not share its image samplers.
+ */
+void
+ExpectSameAsUnshared(const CombinationMetricType &             combinationMetric,
+                     const ImageType &                         fixedImage,
+                     const ImageType &                         movingImage,
+                     BSplineTransformType &                    transform,
+                     const std::vector<ImageType::IndexType> & indices,
+                     const ParametersType &                    parameters)
+{
+  const auto meanSquaresSampler = ListSampler::New();
+  meanSquaresSampler->SetSamples(fixedImage, indices, {});
+  const auto mutualInformationSampler = ListSampler::New();
+  mutualInformationSampler->SetSamples(fixedImage, indices, {});
+  const auto unsharedMetric =
+    CreateCombinationMetric(fixedImage, movingImage, transform, *meanSquaresSampler, *mutualInformationSampler, false);
+
+  CombinationMetricType::MeasureType    expectedValue{};
+  CombinationMetricType::DerivativeType expectedDerivative;
+  unsharedMetric->GetValueAndDerivative(parameters, expectedValue, expectedDerivative);
+
+  CombinationMetricType::MeasureType    value{};
+  CombinationMetricType::DerivativeType derivative;
+  combinationMetric.GetValueAndDerivative(parameters, value, derivative);
+
+  EXPECT_EQ(value, expectedValue);
+  EXPECT_EQ(derivative, expectedDerivative);
+}
+
+} // namespace
+
+
+GTEST_TEST(CombinationImageToImageMetric, SharedImageSamplersGiveSameValueAndDerivative)
+{
+  const auto fixedImage = elastix::MetricGTestUtilities::CreateBlobImage(15.0, 16.0);
+  const auto movingImage = elastix::MetricGTestUtilities::CreateBlobImage(17.0, 14.5);
+  const auto transform = elastix::MetricGTestUtilities::CreateBSplineTransform(*fixedImage);
+  const auto indices = GetSampleIndices(1);
+
+  const auto meanSquaresSampler = ListSampler::New();
+  meanSquaresSampler->SetSamples(*fixedImage, indices, {});
+  const auto mutualInformationSampler = ListSampler::New();
+  mutualInformationSampler->SetSamples(*fixedImage, indices, {});
+  const auto combinationMetric = CreateCombinationMetric(
+    *fixedImage, *movingImage, *transform, *meanSquaresSampler, *mutualInformationSampler, true);
+
+  /** The second metric uses the sampler and the mapped points of the first. */
+  const auto & meanSquaresMetric = dynamic_cast<const MeanSquaresMetricType &>(*combinationMetric->GetMetric(0));
+  const auto & mutualInformationMetric =
+    dynamic_cast<const MutualInformationMetricType &>(*combinationMetric->GetMetric(1));
+  EXPECT_EQ(mutualInformationMetric.GetImageSampler(), meanSquaresMetric.GetImageSampler());
+  EXPECT_EQ(meanSquaresMetric.GetImageSampler(), meanSquaresSampler.GetPointer());
+  ASSERT_NE(meanSquaresMetric.GetSharedMappedPoints(), nullptr);
+  EXPECT_EQ(mutualInformationMetric.GetSharedMappedPoints(), meanSquaresMetric.GetSharedMappedPoints());
+
+  const ParametersType parameters = transform->GetParameters();
+  ExpectSameAsUnshared(*combinationMetric, *fixedImage, *movingImage, *transform, indices, parameters);
+}
+
+
+GTEST_TEST(CombinationImageToImageMetric, SharedMappedPointsAreUpdatedWhenParametersOrSamplesChange)
+{
+  const auto fixedImage = elastix::MetricGTestUtilities::CreateBlobImage(15.0, 16.0);
+  const auto movingImage = elastix::MetricGTestUtilities::CreateBlobImage(17.0, 14.5);
+  const auto transform = elastix::MetricGTestUtilities::CreateBSplineTransform(*fixedImage);
+  const auto indices = GetSampleIndices(1);
+
+  const auto meanSquaresSampler = ListSampler::New();
+  meanSquaresSampler->SetSamples(*fixedImage, indices, {});
+  const auto mutualInformationSampler = ListSampler::New();
+  mutualInformationSampler->SetSamples(*fixedImage, indices, {});
+  const auto combinationMetric = CreateCombinationMetric(
+    *fixedImage, *movingImage, *transform, *meanSquaresSampler, *mutualInformationSampler, true);
+
+  const auto & meanSquaresMetric = dynamic_cast<const MeanSquaresMetricType &>(*combinationMetric->GetMetric(0));
+  const auto & mappedPoints = *meanSquaresMetric.GetSharedMappedPoints();
+
+  const ParametersType initialParameters = transform->GetParameters();
+  CombinationMetricType::MeasureType    value{};
+  CombinationMetricType::DerivativeType derivative;
+  combinationMetric->GetValueAndDerivative(initialParameters, value, derivative);
+  EXPECT_EQ(mappedPoints.m_Parameters, initialParameters);
+  EXPECT_EQ(mappedPoints.m_Points.size(), indices.size());
+
+  /** New transform parameters. */
+  ParametersType parameters = initialParameters;
+  for (auto & parameter : parameters)
+  {
+    parameter *= 0.5;
+  }
+  ExpectSameAsUnshared(*combinationMetric, *fixedImage, *movingImage, *transform, indices, parameters);
+  EXPECT_EQ(mappedPoints.m_Parameters, parameters);
+
+  /** New samples, with the same transform parameters. */
+  const auto otherIndices = GetSampleIndices(2);
+  meanSquaresSampler->SetSamples(*fixedImage, otherIndices, {});
+  ExpectSameAsUnshared(*combinationMetric, *fixedImage, *movingImage, *transform, otherIndices, parameters);
+  EXPECT_EQ(mappedPoints.m_Points.size(), otherIndices.size());
+  EXPECT_EQ(mappedPoints.m_SampleContainerUpdateMTime, meanSquaresSampler->GetOutput()->GetUpdateMTime());
+}
@@ -0,0 +1,113 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkCombinationTransformCollapser.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkAdvancedTranslationTransform.h"
+
+#include <gtest/gtest.h>
+
+// Using-declaration:
+using elx::CoreMainGTestUtilities::CheckNew;
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using CollapserType = itk::CombinationTransformCollapser<double, Dimension>;
+using CombinationTransformType = CollapserType::CombinationTransformType;
+using MatrixOffsetTransformType = CollapserType::MatrixOffsetTransformType;
+
+
+itk::SmartPointer<MatrixOffsetTransformType>
+CreateAffineTransform(const double scale, const double translation)
+{
+  const auto                            transform = MatrixOffsetTransformType::New();
+  MatrixOffsetTransformType::MatrixType matrix;
+  matrix.SetIdentity();
+  matrix(0, 1) = 0.25;
+  matrix *= scale;
+  transform->SetMatrix(matrix);
+  transform->SetTranslation(MatrixOffsetTransformType::OutputVectorType(translation));
+  return transform;
+}
+
+
+/** Creates a chain ( first, then second, then third ), like elastix does for initial transforms. */
+itk::SmartPointer<CombinationTransformType>
+CreateChain(CollapserType::AdvancedTransformType * first,
+            CollapserType::AdvancedTransformType * second,
+            CollapserType::AdvancedTransformType * third)
+{
+  const auto link1 = CombinationTransformType::New();
+  link1->SetCurrentTransform(first);
+  const auto link2 = CombinationTransformType::New();
+  link2->SetInitialTransform(link1);
+  link2->SetCurrentTransform(second);
+  const auto link3 = CombinationTransformType::New();
+  link3->SetInitialTransform(link2);
+  link3->SetCurrentTransform(third);
+  return link3;
+}
+
+} // namespace
+
+
+GTEST_TEST(CombinationTransformCollapser, MergesConsecutiveMatrixOffsetTransforms)
+{
+  const auto chain = CreateChain(
+    CreateAffineTransform(1.5, 2.0), CreateAffineTransform(0.5, -3.0), CreateAffineTransform(2.0, 1.0));
+
+  const auto collapser = CheckNew<CollapserType>();
+  collapser->SetTransform(chain);
+  collapser->Update();
+
+  EXPECT_EQ(collapser->GetNumberOfTransformsBefore(), 3U);
+  EXPECT_EQ(collapser->GetNumberOfTransformsAfter(), 1U);
+  EXPECT_FALSE(collapser->GetIsBaked());
+
+  const auto point = itk::MakePoint(1.0, -2.0, 3.5);
+  const auto expected = chain->TransformPoint(point);
+  const auto actual = collapser->GetCollapsedTransform()->TransformPoint(point);
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    EXPECT_NEAR(actual[i], expected[i], 1e-10);
+  }
+}
+
+
+GTEST_TEST(CombinationTransformCollapser, KeepsNonLinearLinksOfTheChain)
+{
+  /** A translation transform is not a matrix-offset transform, so it separates the two affine transforms. */
+  const auto translation = itk::AdvancedTranslationTransform<double, Dimension>::New();
+  translation->SetOffset(itk::Vector<double, Dimension>(4.0));
+
+  const auto chain = CreateChain(CreateAffineTransform(1.5, 2.0), translation, CreateAffineTransform(2.0, 1.0));
+
+  const auto collapser = CheckNew<CollapserType>();
+  collapser->SetTransform(chain);
+  collapser->Update();
+
+  EXPECT_EQ(collapser->GetNumberOfTransformsBefore(), 3U);
+  EXPECT_EQ(collapser->GetNumberOfTransformsAfter(), 3U);
+
+  const auto point = itk::MakePoint(1.0, -2.0, 3.5);
+  EXPECT_EQ(collapser->GetCollapsedTransform()->TransformPoint(point), chain->TransformPoint(point));
+}
@@ -0,0 +1,206 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkCompactDeformationField.h"
+
+#include "itkImageFileWriter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkVectorLinearInterpolateImageFunction.h"
+#include "itkVectorNearestNeighborInterpolateImageFunction.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+namespace
+{
+constexpr unsigned int Dimension = 3;
+using CompactFieldType = itk::CompactDeformationField<double, Dimension, float>;
+using FieldType = CompactFieldType::DeformationFieldType;
+using ComponentStorageEnum = CompactFieldType::ComponentStorageEnum;
+using PointType = CompactFieldType::PointType;
+using VectorType = CompactFieldType::OutputVectorType;
+
+
+/** A smooth deformation field, with a nontrivial geometry. */
+FieldType::Pointer
+CreateField()
+{
+  const auto field = FieldType::New();
+  field->SetRegions(FieldType::SizeType{ { 9, 7, 8 } });
+  field->SetOrigin(itk::MakePoint(-3.0, 2.0, 1.5));
+  field->SetSpacing(itk::MakeVector(1.5, 2.0, 0.75));
+  FieldType::DirectionType direction;
+  direction.SetIdentity();
+  direction(0, 0) = direction(1, 1) = std::cos(0.3);
+  direction(0, 1) = -std::sin(0.3);
+  direction(1, 0) = std::sin(0.3);
+  field->SetDirection(direction);
+  field->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<FieldType> it(field, field->GetBufferedRegion());
+  for (; !it.IsAtEnd(); ++it)
+  {
+    const auto           index = it.GetIndex();
+    FieldType::PixelType vector;
+    vector[0] = 4.0 * std::sin(0.5 * index[1]);
+    vector[1] = -2.0 + 0.3 * index[0] * index[2];
+    vector[2] = 0.01 * index[0] - 1.0;
+    it.Set(vector);
+  }
+  return field;
+}
+
+
+/** Random points, partly outside the field. */
+std::vector<PointType>
+CreatePoints()
+{
+  std::mt19937                           randomGenerator(1);
+  std::uniform_real_distribution<double> coordinate(-8.0, 18.0);
+  std::vector<PointType>                 points(2000);
+  for (auto & point : points)
+  {
+    for (unsigned int d = 0; d < Dimension; ++d)
+    {
+      point[d] = coordinate(randomGenerator);
+    }
+  }
+  return points;
+}
+
+
+/** Checks that the compact field gives the results of the ITK interpolators, within the tolerance. */
+void
+ExpectEqualToInterpolators(const FieldType * field, CompactFieldType & compactField, const double tolerance)
+{
+  const auto nearestNeighbor = itk::VectorNearestNeighborInterpolateImageFunction<FieldType, double>::New();
+  const auto linear = itk::VectorLinearInterpolateImageFunction<FieldType, double>::New();
+  nearestNeighbor->SetInputImage(field);
+  linear->SetInputImage(field);
+
+  unsigned int numberOfInsidePoints = 0;
+  for (const auto & point : CreatePoints())
+  {
+    for (const unsigned int order : { 0, 1 })
+    {
+      compactField.SetInterpolationOrder(order);
+      const auto & interpolator =
+        (order == 0) ? static_cast<const itk::VectorInterpolateImageFunction<FieldType, double> &>(*nearestNeighbor)
+                     : *linear;
+
+      const auto cindex = field->TransformPhysicalPointToContinuousIndex<double>(point);
+      VectorType displacement;
+      const bool inside = compactField.Evaluate(point, displacement);
+      ASSERT_EQ(inside, interpolator.IsInsideBuffer(cindex));
+      if (inside)
+      {
+        const auto expected = interpolator.EvaluateAtContinuousIndex(cindex);
+        for (unsigned int d = 0; d < Dimension; ++d)
+        {
+          EXPECT_NEAR(displacement[d], expected[d], tolerance);
+        }
+        ++numberOfInsidePoints;
+      }
+    }
+  }
+
+  /** Make sure that points inside the field were tested. */
+  EXPECT_GT(numberOfInsidePoints, 100);
+}
+
+} // namespace
+
+
+GTEST_TEST(CompactDeformationField, HalfPrecisionConversion)
+{
+  /** Exactly representable values. */
+  for (const float value : { 0.0f, -0.0f, 1.0f, -2.5f, 0.125f, 65504.0f, -1024.5f })
+  {
+    EXPECT_EQ(CompactFieldType::HalfToFloat(CompactFieldType::FloatToHalf(value)), value);
+  }
+
+  /** Subnormal, overflow, and infinite values. */
+  EXPECT_EQ(CompactFieldType::HalfToFloat(CompactFieldType::FloatToHalf(std::ldexp(1.0f, -24))), std::ldexp(1.0f, -24));
+  EXPECT_EQ(CompactFieldType::HalfToFloat(CompactFieldType::FloatToHalf(1e-9f)), 0.0f);
+  EXPECT_TRUE(std::isinf(CompactFieldType::HalfToFloat(CompactFieldType::FloatToHalf(70000.0f))));
+  EXPECT_TRUE(std::isinf(CompactFieldType::HalfToFloat(CompactFieldType::FloatToHalf(-INFINITY))));
+
+  /** Rounding to nearest, within half a unit in the last place. */
+  std::mt19937                          randomGenerator(1);
+  std::uniform_real_distribution<float> distribution(-1000.0f, 1000.0f);
+  for (unsigned int i = 0; i < 10000; ++i)
+  {
+    const float value = distribution(randomGenerator);
+    EXPECT_NEAR(CompactFieldType::HalfToFloat(CompactFieldType::FloatToHalf(value)),
+                value,
+                std::abs(value) * std::ldexp(1.0f, -11));
+  }
+}
+
+
+GTEST_TEST(CompactDeformationField, EvaluateEqualsInterpolators)
+{
+  const auto field = CreateField();
+  const auto compactField = CompactFieldType::New();
+
+  compactField->SetDeformationField(field, ComponentStorageEnum::Float32);
+  ExpectEqualToInterpolators(field, *compactField, 1e-6);
+
+  compactField->SetDeformationField(field, ComponentStorageEnum::Float64);
+  ExpectEqualToInterpolators(field, *compactField, 1e-6);
+
+  compactField->SetDeformationField(field, ComponentStorageEnum::Half);
+  ExpectEqualToInterpolators(field, *compactField, 1e-2);
+
+  compactField->SetDeformationField(field, ComponentStorageEnum::Int16);
+  EXPECT_LT(compactField->GetQuantizationScale(), 1e-3);
+  ExpectEqualToInterpolators(field, *compactField, compactField->GetQuantizationScale());
+}
+
+
+GTEST_TEST(CompactDeformationField, MemoryMappedFileEqualsField)
+{
+  const auto field = CreateField();
+
+  for (const std::string extension : { ".mhd", ".mha", ".nrrd", ".nhdr" })
+  {
+    const std::string fileName = std::string(ELX_CMAKE_CURRENT_BINARY_DIR) + "/CompactDeformationField" + extension;
+    itk::WriteImage(field, fileName);
+
+    const auto compactField = CompactFieldType::New();
+    compactField->MapRawImageFile(fileName);
+    EXPECT_TRUE(compactField->IsMemoryMapped());
+    EXPECT_EQ(compactField->GetComponentStorage(), ComponentStorageEnum::Float32);
+    ExpectEqualToInterpolators(field, *compactField, 1e-6);
+
+    /** Decompressing gives the original field. */
+    const auto copy = compactField->CreateDeformationField();
+    EXPECT_EQ(copy->GetBufferedRegion(), field->GetBufferedRegion());
+    EXPECT_EQ(copy->GetDirection(), field->GetDirection());
+    itk::ImageRegionConstIterator<FieldType> it(field, field->GetBufferedRegion());
+    itk::ImageRegionConstIterator<FieldType> itCopy(copy, copy->GetBufferedRegion());
+    for (; !it.IsAtEnd(); ++it, ++itCopy)
+    {
+      EXPECT_EQ(itCopy.Get(), it.Get());
+    }
+  }
+}
@@ -0,0 +1,181 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "CorrespondingPointsEuclideanDistanceMetric/itkCorrespondingPointsEuclideanDistancePointMetric.h"
+
+#include "elxMetricGTestUtilities.h"
+
+#include "itkPointSet.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm> // For max.
+#include <cmath>
+
+namespace
+{
+using elastix::MetricGTestUtilities::BSplineTransformType;
+using PointSetType = itk::PointSet<double, 2>;
+using MetricType = itk::CorrespondingPointsEuclideanDistancePointMetric<PointSetType, PointSetType>;
+using RobustEstimatorEnum = MetricType::RobustEstimatorEnum;
+using ParametersType = MetricType::TransformParametersType;
+
+constexpr double robustnessScale = 1.5;
+
+
+/** Creates a metric for a grid of fixed points, and moving points at increasing distances from them, so that the
+ * distances of the transformed fixed points lie both below and above the robustness scale.
+ */
+MetricType::Pointer
+CreateMetric(const RobustEstimatorEnum robustEstimator, const bool useMultiThread, BSplineTransformType & transform)
+{
+  const auto   fixedPointSet = PointSetType::New();
+  const auto   movingPointSet = PointSetType::New();
+  unsigned int pointID = 0;
+  for (unsigned int y = 0; y < 5; ++y)
+  {
+    for (unsigned int x = 0; x < 5; ++x, ++pointID)
+    {
+      const double            radius = 0.25 + 0.15 * pointID;
+      const double            angle = 0.9 * pointID;
+      PointSetType::PointType fixedPoint;
+      fixedPoint[0] = 4.0 + 5.0 * x;
+      fixedPoint[1] = 4.0 + 5.0 * y;
+      PointSetType::PointType movingPoint;
+      movingPoint[0] = fixedPoint[0] + radius * std::cos(angle);
+      movingPoint[1] = fixedPoint[1] + radius * std::sin(angle);
+      fixedPointSet->SetPoint(pointID, fixedPoint);
+      movingPointSet->SetPoint(pointID, movingPoint);
+    }
+  }
+
+  const auto metric = MetricType::New();
+  metric->SetFixedPointSet(fixedPointSet);
+  metric->SetMovingPointSet(movingPointSet);
+  metric->SetTransform(&transform);
+  metric->SetRobustEstimator(robustEstimator);
+  metric->SetRobustnessScale(robustnessScale);
+  metric->SetUseMultiThread(useMultiThread);
+  metric->SetNumberOfWorkUnits(4);
+  metric->Initialize();
+  return metric;
+}
+
+
+/** Expects that the transform maps the fixed points to distances both below and above the robustness scale. */
+void
+ExpectDistancesOnBothSidesOfRobustnessScale(const MetricType & metric, const BSplineTransformType & transform)
+{
+  unsigned int numberOfInliers = 0;
+  unsigned int numberOfOutliers = 0;
+  const auto & fixedPoints = *metric.GetFixedPointSet()->GetPoints();
+  const auto & movingPoints = *metric.GetMovingPointSet()->GetPoints();
+  for (itk::SizeValueType i = 0; i < fixedPoints.Size(); ++i)
+  {
+    const auto mappedPoint = transform.TransformPoint(fixedPoints.ElementAt(i));
+    if (mappedPoint.EuclideanDistanceTo(movingPoints.ElementAt(i)) < robustnessScale)
+    {
+      ++numberOfInliers;
+    }
+    else
+    {
+      ++numberOfOutliers;
+    }
+  }
+  EXPECT_GT(numberOfInliers, 0U);
+  EXPECT_GT(numberOfOutliers, 0U);
+}
+
+} // namespace
+
+
+GTEST_TEST(CorrespondingPointsEuclideanDistancePointMetric, MultiThreadedEqualsSingleThreaded)
+{
+  const auto fixedImage = elastix::MetricGTestUtilities::CreateBlobImage(15.0, 16.0);
+  const auto transform = elastix::MetricGTestUtilities::CreateBSplineTransform(*fixedImage);
+  const ParametersType parameters = transform->GetParameters();
+
+  for (const auto robustEstimator :
+       { RobustEstimatorEnum::NoEstimator, RobustEstimatorEnum::Huber, RobustEstimatorEnum::Tukey })
+  {
+    const auto singleThreadedMetric = CreateMetric(robustEstimator, false, *transform);
+    ExpectDistancesOnBothSidesOfRobustnessScale(*singleThreadedMetric, *transform);
+    MetricType::MeasureType    expectedValue{};
+    MetricType::DerivativeType expectedDerivative;
+    singleThreadedMetric->GetValueAndDerivative(parameters, expectedValue, expectedDerivative);
+
+    const auto multiThreadedMetric = CreateMetric(robustEstimator, true, *transform);
+    MetricType::MeasureType    value{};
+    MetricType::DerivativeType derivative;
+    multiThreadedMetric->GetValueAndDerivative(parameters, value, derivative);
+
+    /** The threads sum their points in a different order. */
+    ASSERT_GT(expectedValue, 0.0);
+    EXPECT_NEAR(value, expectedValue, 1e-12 * expectedValue);
+    EXPECT_NEAR(multiThreadedMetric->GetValue(parameters), expectedValue, 1e-12 * expectedValue);
+    ASSERT_EQ(derivative.size(), expectedDerivative.size());
+    const double tolerance = 1e-12 * expectedDerivative.inf_norm();
+    ASSERT_GT(tolerance, 0.0);
+    for (unsigned int k = 0; k < derivative.size(); ++k)
+    {
+      EXPECT_NEAR(derivative[k], expectedDerivative[k], tolerance)
+        << "RobustEstimator " << static_cast<int>(robustEstimator) << ", parameter " << k;
+    }
+  }
+}
+
+
+GTEST_TEST(CorrespondingPointsEuclideanDistancePointMetric, RobustDerivativeMatchesFiniteDifferences)
+{
+  const auto fixedImage = elastix::MetricGTestUtilities::CreateBlobImage(15.0, 16.0);
+  const auto transform = elastix::MetricGTestUtilities::CreateBSplineTransform(*fixedImage);
+  const ParametersType parameters = transform->GetParameters();
+
+  for (const auto robustEstimator :
+       { RobustEstimatorEnum::NoEstimator, RobustEstimatorEnum::Huber, RobustEstimatorEnum::Tukey })
+  {
+    for (const bool useMultiThread : { false, true })
+    {
+      const auto metric = CreateMetric(robustEstimator, useMultiThread, *transform);
+
+      MetricType::MeasureType    value{};
+      MetricType::DerivativeType derivative;
+      metric->GetValueAndDerivative(parameters, value, derivative);
+      ExpectDistancesOnBothSidesOfRobustnessScale(*metric, *transform);
+      ASSERT_EQ(derivative.GetSize(), parameters.GetSize());
+
+      /** The robust functions are continuously differentiable, also at the robustness scale. */
+      const double delta = 1e-6;
+      for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+      {
+        ParametersType testPoint = parameters;
+        testPoint[i] = parameters[i] + delta;
+        const double valuePlus = metric->GetValue(testPoint);
+        testPoint[i] = parameters[i] - delta;
+        const double valueMinus = metric->GetValue(testPoint);
+
+        const double finiteDifference = (valuePlus - valueMinus) / (2.0 * delta);
+        EXPECT_NEAR(derivative[i], finiteDifference, 1e-5 * std::max(1.0, std::abs(finiteDifference)))
+          << "RobustEstimator " << static_cast<int>(robustEstimator) << ", UseMultiThread " << useMultiThread
+          << ", parameter " << i;
+      }
+    }
+  }
+}
@@ -0,0 +1,110 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkFiniteDifferenceDerivativeEstimator.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+using EstimatorType = itk::FiniteDifferenceDerivativeEstimator;
+using ParametersType = EstimatorType::ParametersType;
+using DerivativeType = EstimatorType::DerivativeType;
+
+
+/** A linear cost function, for which the finite differences are exact. */
+double
+EvaluateLinearFunction(const ParametersType & parameters)
+{
+  double value = 0.0;
+  for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+  {
+    value += (i + 1.0) * parameters[i];
+  }
+  return value;
+}
+
+
+DerivativeType
+EstimateDerivative(EstimatorType & estimator, const ParametersType & parameters)
+{
+  EstimatorType::ParametersContainerType perturbedParameters;
+  estimator.GeneratePerturbedParameters(parameters, perturbedParameters);
+
+  EstimatorType::MeasureContainerType values;
+  for (const auto & perturbedParameter : perturbedParameters)
+  {
+    values.push_back(EvaluateLinearFunction(perturbedParameter));
+  }
+
+  DerivativeType derivative;
+  estimator.ComputeDerivative(values, derivative);
+  return derivative;
+}
+
+} // namespace
+
+
+GTEST_TEST(FiniteDifferenceDerivativeEstimator, CentralDifferences)
+{
+  const auto     estimator = EstimatorType::New();
+  ParametersType parameters(4);
+  parameters.Fill(0.5);
+
+  EstimatorType::ScalesType scales(4);
+  scales.Fill(4.0);
+  estimator->SetScales(scales);
+
+  EstimatorType::ParametersContainerType perturbedParameters;
+  estimator->GeneratePerturbedParameters(parameters, perturbedParameters);
+  ASSERT_EQ(perturbedParameters.size(), 8);
+  EXPECT_DOUBLE_EQ(perturbedParameters[2][1], 0.5 - 0.0005);
+  EXPECT_DOUBLE_EQ(perturbedParameters[3][1], 0.5 + 0.0005);
+
+  const DerivativeType derivative = EstimateDerivative(*estimator, parameters);
+  ASSERT_EQ(derivative.GetSize(), 4);
+  for (unsigned int i = 0; i < 4; ++i)
+  {
+    EXPECT_NEAR(derivative[i], i + 1.0, 1e-8);
+  }
+}
+
+
+GTEST_TEST(FiniteDifferenceDerivativeEstimator, SimultaneousPerturbationIsUnbiased)
+{
+  const auto     estimator = EstimatorType::New();
+  ParametersType parameters(3);
+  parameters.Fill(1.0);
+
+  estimator->SetUseSimultaneousPerturbation(true);
+  estimator->SetNumberOfPerturbations(2000);
+
+  EstimatorType::ParametersContainerType perturbedParameters;
+  estimator->GeneratePerturbedParameters(parameters, perturbedParameters);
+  EXPECT_EQ(perturbedParameters.size(), 4000);
+
+  /** The errors of the individual perturbations cancel out on average. */
+  const DerivativeType derivative = EstimateDerivative(*estimator, parameters);
+  ASSERT_EQ(derivative.GetSize(), 3);
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    EXPECT_NEAR(derivative[i], i + 1.0, 0.5);
+  }
+}
@@ -0,0 +1,152 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "StandardGradientDescent/itkGradientDescentOptimizer2.h"
+
+#include <itkSingleValuedCostFunction.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace
+{
+using OptimizerType = itk::GradientDescentOptimizer2;
+
+/** Cost function that returns the values of a series, one per evaluation, and a zero derivative. */
+class SeriesCostFunction : public itk::SingleValuedCostFunction
+{
+public:
+  using Self = SeriesCostFunction;
+  using Superclass = itk::SingleValuedCostFunction;
+  using Pointer = itk::SmartPointer<Self>;
+
+  itkNewMacro(Self);
+  itkTypeMacro(SeriesCostFunction, SingleValuedCostFunction);
+
+  std::function<double(unsigned int)> m_Series;
+  mutable std::vector<double>         m_Values;
+
+  MeasureType
+  GetValue(const ParametersType &) const override
+  {
+    m_Values.push_back(m_Series(static_cast<unsigned int>(m_Values.size())));
+    return m_Values.back();
+  }
+
+  void
+  GetDerivative(const ParametersType &, DerivativeType & derivative) const override
+  {
+    derivative = DerivativeType(this->GetNumberOfParameters());
+    derivative.Fill(0.0);
+  }
+
+  void
+  GetValueAndDerivative(const ParametersType & parameters,
+                        MeasureType &          value,
+                        DerivativeType &       derivative) const override
+  {
+    value = this->GetValue(parameters);
+    this->GetDerivative(parameters, derivative);
+  }
+
+  unsigned int
+  GetNumberOfParameters() const override
+  {
+    return 2;
+  }
+};
+
+
+/** Runs the optimizer with the convergence check on the series, and returns the optimizer. */
+OptimizerType::Pointer
+Optimize(SeriesCostFunction & costFunction, const unsigned int numberOfIterations)
+{
+  const auto optimizer = OptimizerType::New();
+  optimizer->SetCostFunction(&costFunction);
+  optimizer->SetInitialPosition(OptimizerType::ParametersType(2, 0.0));
+  optimizer->SetNumberOfIterations(numberOfIterations);
+  optimizer->SetUseConvergenceCheck(true);
+  optimizer->SetConvergenceWindowSize(20);
+  optimizer->SetConvergenceTolerance(0.0);
+  optimizer->StartOptimization();
+  return optimizer;
+}
+
+} // namespace
+
+
+GTEST_TEST(GradientDescentOptimizer2, ConvergenceValueIsNaNUntilWindowIsFilled)
+{
+  const auto costFunction = SeriesCostFunction::New();
+  costFunction->m_Series = [](const unsigned int k) { return 100.0 - k; };
+
+  const auto optimizer = Optimize(*costFunction, 19);
+  EXPECT_EQ(optimizer->GetStopCondition(), OptimizerType::MaximumNumberOfIterations);
+  EXPECT_TRUE(std::isnan(optimizer->GetConvergenceValue()));
+}
+
+
+GTEST_TEST(GradientDescentOptimizer2, ConvergenceValueOfLinearSeries)
+{
+  const auto costFunction = SeriesCostFunction::New();
+  costFunction->m_Series = [](const unsigned int k) { return 100.0 - 0.5 * k; };
+
+  const auto optimizer = Optimize(*costFunction, 50);
+  EXPECT_EQ(optimizer->GetStopCondition(), OptimizerType::MaximumNumberOfIterations);
+
+  /** Without noise, the value is the decrease over the window relative to the mean of the last 20 values. */
+  const double meanValue = 100.0 - 0.5 * (30 + 49) / 2.0;
+  EXPECT_NEAR(optimizer->GetConvergenceValue(), 19 * 0.5 / meanValue, 1e-10);
+}
+
+
+GTEST_TEST(GradientDescentOptimizer2, NoisyDecreasingSeriesDoesNotConverge)
+{
+  std::mt19937                     randomNumberEngine;
+  std::uniform_real_distribution<> distribution(-1.0, 1.0);
+
+  const auto costFunction = SeriesCostFunction::New();
+  costFunction->m_Series = [&](const unsigned int k) { return 1000.0 - 0.5 * k + distribution(randomNumberEngine); };
+
+  const auto optimizer = Optimize(*costFunction, 200);
+  EXPECT_EQ(optimizer->GetStopCondition(), OptimizerType::MaximumNumberOfIterations);
+  EXPECT_EQ(optimizer->GetCurrentIteration(), 200u);
+  EXPECT_GT(optimizer->GetConvergenceValue(), 0.0);
+}
+
+
+GTEST_TEST(GradientDescentOptimizer2, NoisyFlatSeriesConverges)
+{
+  std::mt19937                     randomNumberEngine;
+  std::uniform_real_distribution<> distribution(-1.0, 1.0);
+
+  const auto costFunction = SeriesCostFunction::New();
+  costFunction->m_Series = [&](unsigned int) { return 10.0 + distribution(randomNumberEngine); };
+
+  const auto optimizer = Optimize(*costFunction, 200);
+  EXPECT_EQ(optimizer->GetStopCondition(), OptimizerType::MetricConvergence);
+  EXPECT_GE(optimizer->GetCurrentIteration(), 20u);
+  EXPECT_LT(optimizer->GetCurrentIteration(), 200u);
+  EXPECT_LT(optimizer->GetConvergenceValue(), 0.0);
+}
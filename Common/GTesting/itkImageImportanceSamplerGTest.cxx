@@ -0,0 +1,130 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkImageImportanceSampler.h"
+
+#include "itkImage.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <numeric> // For accumulate.
+#include <vector>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+using SamplerType = itk::ImageImportanceSampler<ImageType>;
+
+constexpr unsigned int sizeX = 4;
+constexpr unsigned int sizeY = 3;
+constexpr unsigned int numberOfVoxels = sizeX * sizeY;
+constexpr double       uniformFraction = 0.2;
+
+
+/** The sampling density of voxel i, for a weight image with value i at voxel i. */
+double
+ExpectedProbability(const unsigned int voxel)
+{
+  const double sumOfWeights = numberOfVoxels * (numberOfVoxels - 1) / 2.0;
+  return (1.0 - uniformFraction) * voxel / sumOfWeights + uniformFraction / numberOfVoxels;
+}
+
+
+/** Draws samples with the weight image that has value i at voxel i. */
+SamplerType::Pointer
+CreateAndUpdateSampler(const unsigned long numberOfSamples)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { sizeX, sizeY } });
+  image->Allocate(true);
+
+  const auto weightImage = SamplerType::WeightImageType::New();
+  weightImage->SetRegions(image->GetLargestPossibleRegion());
+  weightImage->Allocate();
+  for (unsigned int i = 0; i < numberOfVoxels; ++i)
+  {
+    weightImage->GetBufferPointer()[i] = static_cast<float>(i);
+  }
+
+  SamplerType::RandomGeneratorType::GetInstance()->SetSeed(42);
+
+  const auto sampler = SamplerType::New();
+  sampler->SetInput(image);
+  sampler->SetWeightImage(weightImage);
+  sampler->SetUniformFraction(uniformFraction);
+  sampler->SetNumberOfSamples(numberOfSamples);
+  sampler->Update();
+  return sampler;
+}
+
+
+/** Returns the offset of the voxel of a sample in the image buffer. */
+unsigned int
+GetVoxelOffset(const SamplerType & sampler, const SamplerType::ImageSampleType & sample)
+{
+  const auto index = sampler.GetInput()->TransformPhysicalPointToIndex(sample.m_ImageCoordinates);
+  return static_cast<unsigned int>(index[0] + sizeX * index[1]);
+}
+
+} // namespace
+
+
+GTEST_TEST(ImageImportanceSampler, FrequenciesFollowSamplingDensity)
+{
+  constexpr unsigned long numberOfSamples = 200000;
+  const auto              sampler = CreateAndUpdateSampler(numberOfSamples);
+
+  std::vector<unsigned long> counts(numberOfVoxels);
+  for (const auto & sample : sampler->GetOutput()->CastToSTLConstContainer())
+  {
+    ++counts[GetVoxelOffset(*sampler, sample)];
+  }
+
+  /** The frequencies must be within 5 standard deviations of the probabilities. */
+  for (unsigned int voxel = 0; voxel < numberOfVoxels; ++voxel)
+  {
+    const double probability = ExpectedProbability(voxel);
+    const double frequency = static_cast<double>(counts[voxel]) / numberOfSamples;
+    const double standardDeviation = std::sqrt(probability * (1.0 - probability) / numberOfSamples);
+    EXPECT_NEAR(frequency, probability, 5.0 * standardDeviation) << "voxel " << voxel;
+  }
+}
+
+
+GTEST_TEST(ImageImportanceSampler, WeightsAreInverseOfSamplingDensity)
+{
+  constexpr unsigned long numberOfSamples = 1000;
+  const auto              sampler = CreateAndUpdateSampler(numberOfSamples);
+  const auto &            samples = sampler->GetOutput()->CastToSTLConstContainer();
+  const auto &            weights = sampler->GetSampleWeights();
+  ASSERT_EQ(weights.size(), samples.size());
+
+  /** The weights have a mean of 1. */
+  EXPECT_NEAR(std::accumulate(weights.cbegin(), weights.cend(), 0.0) / numberOfSamples, 1.0, 1e-10);
+
+  /** The weight times the sampling density is the same for all samples. */
+  const double expectedProduct = weights[0] * ExpectedProbability(GetVoxelOffset(*sampler, samples[0]));
+  for (unsigned int i = 0; i < samples.size(); ++i)
+  {
+    EXPECT_NEAR(weights[i] * ExpectedProbability(GetVoxelOffset(*sampler, samples[i])), expectedProduct, 1e-5)
+      << "sample " << i;
+  }
+}
@@ -0,0 +1,137 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkImageRandomCoordinateSampler.h"
+
+#include "itkMultiInputImageRandomCoordinateSampler.h"
+#include "itkImage.h"
+#include "itkImageBufferRange.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+using SamplerType = itk::ImageRandomCoordinateSampler<ImageType>;
+using MultiInputSamplerType = itk::MultiInputImageRandomCoordinateSampler<ImageType>;
+
+
+ImageType::Pointer
+CreateImage()
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 20, 17 } });
+  image->Allocate();
+
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.5;
+  spacing[1] = 0.75;
+  image->SetSpacing(spacing);
+
+  std::mt19937                     randomNumberEngine;
+  std::uniform_real_distribution<> distribution(0.0, 100.0);
+  for (auto & pixel : itk::ImageBufferRange<ImageType>(*image))
+  {
+    pixel = static_cast<float>(distribution(randomNumberEngine));
+  }
+  return image;
+}
+
+
+/** Expects that SetInterpolationOrder selects the interpolator types, and keeps the B-spline interpolator. */
+template <class TSampler>
+void
+ExpectInterpolationOrderSelectsInterpolator()
+{
+  const auto sampler = TSampler::New();
+
+  sampler->SetInterpolationOrder(0);
+  EXPECT_NE(dynamic_cast<typename TSampler::NearestNeighborInterpolatorType *>(sampler->GetModifiableInterpolator()),
+            nullptr);
+
+  sampler->SetInterpolationOrder(1);
+  EXPECT_NE(dynamic_cast<typename TSampler::LinearInterpolatorType *>(sampler->GetModifiableInterpolator()), nullptr);
+
+  sampler->SetInterpolationOrder(2);
+  auto * const bsplineInterpolator =
+    dynamic_cast<typename TSampler::DefaultInterpolatorType *>(sampler->GetModifiableInterpolator());
+  ASSERT_NE(bsplineInterpolator, nullptr);
+  EXPECT_EQ(bsplineInterpolator->GetSplineOrder(), 2u);
+
+  /** Changing the order keeps the B-spline interpolator, but modifies the sampler. */
+  const auto timeStamp = sampler->GetMTime();
+  sampler->SetInterpolationOrder(3);
+  EXPECT_EQ(sampler->GetModifiableInterpolator(), bsplineInterpolator);
+  EXPECT_EQ(bsplineInterpolator->GetSplineOrder(), 3u);
+  EXPECT_GT(sampler->GetMTime(), timeStamp);
+}
+
+
+/** Expects that the multi-threaded sampler, which calls the nearest neighbor and linear interpolators
+ * non-virtually, gives the sample values of the reference interpolator at the sample coordinates.
+ */
+template <class TReferenceInterpolator>
+void
+ExpectSampleValuesOfInterpolationOrder(const unsigned int order)
+{
+  const auto image = CreateImage();
+
+  const auto sampler = SamplerType::New();
+  sampler->SetInput(image);
+  sampler->SetInterpolationOrder(order);
+  sampler->SetNumberOfSamples(200);
+  sampler->SetUseMultiThread(true);
+  sampler->Update();
+
+  const auto referenceInterpolator = TReferenceInterpolator::New();
+  referenceInterpolator->SetInputImage(image);
+
+  const auto & samples = sampler->GetOutput()->CastToSTLConstContainer();
+  ASSERT_EQ(samples.size(), 200u);
+  for (const auto & sample : samples)
+  {
+    ASSERT_TRUE(referenceInterpolator->IsInsideBuffer(sample.m_ImageCoordinates));
+    EXPECT_NEAR(sample.m_ImageValue, referenceInterpolator->Evaluate(sample.m_ImageCoordinates), 1e-4)
+      << "order " << order;
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(ImageRandomCoordinateSampler, SetInterpolationOrderSelectsInterpolator)
+{
+  ExpectInterpolationOrderSelectsInterpolator<SamplerType>();
+}
+
+
+GTEST_TEST(MultiInputImageRandomCoordinateSampler, SetInterpolationOrderSelectsInterpolator)
+{
+  ExpectInterpolationOrderSelectsInterpolator<MultiInputSamplerType>();
+}
+
+
+GTEST_TEST(ImageRandomCoordinateSampler, NearestNeighborAndLinearSampleValues)
+{
+  ExpectSampleValuesOfInterpolationOrder<SamplerType::NearestNeighborInterpolatorType>(0);
+  ExpectSampleValuesOfInterpolationOrder<SamplerType::LinearInterpolatorType>(1);
+}
@@ -0,0 +1,151 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkImageStatisticsCache.h"
+
+#include "itkComputeImageExtremaFilter.h"
+#include "itkImage.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+using CacheType = itk::ImageStatisticsCache<double>;
+
+
+ImageType::Pointer
+CreateImage()
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 8, 6 } });
+  image->Allocate(true);
+  image->SetPixel({ { 2, 3 } }, 5.0f);
+  image->SetPixel({ { 4, 1 } }, -3.0f);
+  return image;
+}
+
+} // namespace
+
+
+GTEST_TEST(ImageStatisticsCache, FindReturnsWhatIsInserted)
+{
+  auto & cache = CacheType::GetInstance();
+  cache.Clear();
+
+  const auto image = CreateImage();
+  const auto key = CacheType::MakeKey(image.GetPointer(), image->GetBufferedRegion());
+
+  double value = 0.0;
+  EXPECT_FALSE(cache.Find(key, value));
+  cache.Insert(key, 42.0);
+  EXPECT_TRUE(cache.Find(key, value));
+  EXPECT_EQ(value, 42.0);
+
+  /** Other regions, masks, and settings have other keys. */
+  ImageType::RegionType region = image->GetBufferedRegion();
+  region.SetSize(0, 4);
+  EXPECT_FALSE(cache.Find(CacheType::MakeKey(image.GetPointer(), region), value));
+  EXPECT_FALSE(
+    cache.Find(CacheType::MakeKey(image.GetPointer(), image->GetBufferedRegion(), image.GetPointer()), value));
+  EXPECT_FALSE(cache.Find(CacheType::MakeKey(image.GetPointer(), image->GetBufferedRegion(), nullptr, { 1.0 }), value));
+
+  /** A modified image has another key. */
+  image->Modified();
+  EXPECT_FALSE(cache.Find(CacheType::MakeKey(image.GetPointer(), image->GetBufferedRegion()), value));
+
+  cache.Clear();
+  EXPECT_EQ(cache.GetNumberOfEntries(), 0U);
+}
+
+
+GTEST_TEST(ImageStatisticsCache, RemovesLeastRecentlyUsedEntry)
+{
+  auto & cache = CacheType::GetInstance();
+  cache.Clear();
+  const std::size_t defaultMaximumNumberOfEntries = cache.GetMaximumNumberOfEntries();
+  cache.SetMaximumNumberOfEntries(2);
+
+  const auto image1 = CreateImage();
+  const auto image2 = CreateImage();
+  const auto image3 = CreateImage();
+  const auto key1 = CacheType::MakeKey(image1.GetPointer(), image1->GetBufferedRegion());
+  const auto key2 = CacheType::MakeKey(image2.GetPointer(), image2->GetBufferedRegion());
+  const auto key3 = CacheType::MakeKey(image3.GetPointer(), image3->GetBufferedRegion());
+
+  double value = 0.0;
+  cache.Insert(key1, 1.0);
+  cache.Insert(key2, 2.0);
+  EXPECT_TRUE(cache.Find(key1, value));
+  cache.Insert(key3, 3.0);
+  EXPECT_EQ(cache.GetNumberOfEntries(), 2U);
+  EXPECT_TRUE(cache.Find(key1, value));
+  EXPECT_FALSE(cache.Find(key2, value));
+  EXPECT_TRUE(cache.Find(key3, value));
+
+  /** A maximum of zero disables the cache. */
+  cache.SetMaximumNumberOfEntries(0);
+  EXPECT_EQ(cache.GetNumberOfEntries(), 0U);
+  cache.Insert(key1, 1.0);
+  EXPECT_FALSE(cache.Find(key1, value));
+
+  cache.SetMaximumNumberOfEntries(defaultMaximumNumberOfEntries);
+}
+
+
+GTEST_TEST(ImageStatisticsCache, ComputeImageExtremaFilterUsesCache)
+{
+  using FilterType = itk::ComputeImageExtremaFilter<ImageType>;
+  FilterType::StatisticsCacheType::GetInstance().Clear();
+
+  const auto image = CreateImage();
+  const auto filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetImageRegion(image->GetBufferedRegion());
+  filter->SetUseCache(true);
+  filter->Update();
+  EXPECT_EQ(filter->GetMinimum(), -3.0f);
+  EXPECT_EQ(filter->GetMaximum(), 5.0f);
+  EXPECT_EQ(filter->GetSum(), 2.0);
+
+  /** Changing the buffer without calling Modified() is not noticed by the
+   * cache, which shows that a second filter takes the statistics from it.
+   */
+  image->SetPixel({ { 0, 0 } }, 10.0f);
+  const auto filter2 = FilterType::New();
+  filter2->SetInput(image);
+  filter2->SetImageRegion(image->GetBufferedRegion());
+  filter2->SetUseCache(true);
+  filter2->Update();
+  EXPECT_EQ(filter2->GetMaximum(), 5.0f);
+  EXPECT_EQ(filter2->GetSum(), 2.0);
+
+  /** After Modified(), the statistics are recomputed. */
+  image->Modified();
+  const auto filter3 = FilterType::New();
+  filter3->SetInput(image);
+  filter3->SetImageRegion(image->GetBufferedRegion());
+  filter3->SetUseCache(true);
+  filter3->Update();
+  EXPECT_EQ(filter3->GetMaximum(), 10.0f);
+  EXPECT_EQ(filter3->GetSum(), 12.0);
+
+  FilterType::StatisticsCacheType::GetInstance().Clear();
+}
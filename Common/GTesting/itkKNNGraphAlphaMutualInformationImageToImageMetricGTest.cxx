@@ -0,0 +1,108 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "KNNGraphAlphaMutualInformation/itkKNNGraphAlphaMutualInformationImageToImageMetric.h"
+
+#include "elxMetricGTestUtilities.h"
+
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkImageFullSampler.h"
+#include "itkLinearInterpolateImageFunction.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+using elastix::MetricGTestUtilities::ImageType;
+using MetricType = itk::KNNGraphAlphaMutualInformationImageToImageMetric<ImageType, ImageType>;
+
+
+/** Computes the value and derivative of the metric for two fixed and two moving images. The moving images are
+ * shifted, so that some of the samples are mapped outside, and have to be left out of the list samples.
+ */
+void
+GetValueAndDerivative(const bool                   useMultiThread,
+                      MetricType::MeasureType &    value,
+                      MetricType::DerivativeType & derivative,
+                      unsigned long &              numberOfPixelsCounted)
+{
+  const ImageType::Pointer fixedImages[] = { elastix::MetricGTestUtilities::CreateBlobImage(15.0, 16.0),
+                                             elastix::MetricGTestUtilities::CreateBlobImage(10.0, 20.0) };
+  const ImageType::Pointer movingImages[] = { elastix::MetricGTestUtilities::CreateBlobImage(17.0, 14.5),
+                                              elastix::MetricGTestUtilities::CreateBlobImage(12.0, 18.5) };
+  for (const auto & movingImage : movingImages)
+  {
+    ImageType::PointType origin;
+    origin[0] = 6.0;
+    origin[1] = -3.0;
+    movingImage->SetOrigin(origin);
+  }
+  const auto transform = elastix::MetricGTestUtilities::CreateBSplineTransform(*fixedImages[0]);
+
+  const auto metric = MetricType::New();
+  for (unsigned int i = 0; i < 2; ++i)
+  {
+    const auto interpolator = itk::BSplineInterpolateImageFunction<ImageType, double, double>::New();
+    interpolator->SetSplineOrder(3);
+
+    metric->SetFixedImage(fixedImages[i], i);
+    metric->SetFixedImageRegion(fixedImages[i]->GetBufferedRegion(), i);
+    metric->SetFixedImageInterpolator(itk::LinearInterpolateImageFunction<ImageType, double>::New(), i);
+    metric->SetMovingImage(movingImages[i], i);
+    metric->SetInterpolator(interpolator, i);
+  }
+  metric->SetImageSampler(itk::ImageFullSampler<ImageType>::New());
+  metric->SetTransform(transform);
+  metric->SetANNkDTree(5, "ANN_KD_SL_MIDPT");
+  metric->SetANNStandardTreeSearch(5, 0.0);
+  metric->SetUseMultiThread(useMultiThread);
+  metric->SetNumberOfWorkUnits(4);
+  metric->Initialize();
+
+  metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+  numberOfPixelsCounted = metric->GetNumberOfPixelsCounted();
+}
+
+} // namespace
+
+
+GTEST_TEST(KNNGraphAlphaMutualInformationImageToImageMetric, MultiThreadedListSamplesEqualSingleThreaded)
+{
+  MetricType::MeasureType    expectedValue{};
+  MetricType::DerivativeType expectedDerivative;
+  unsigned long              expectedNumberOfPixelsCounted{};
+  GetValueAndDerivative(false, expectedValue, expectedDerivative, expectedNumberOfPixelsCounted);
+
+  /** Some samples are mapped outside the moving images, so that the list samples are compacted. */
+  EXPECT_GT(expectedNumberOfPixelsCounted, 0u);
+  EXPECT_LT(expectedNumberOfPixelsCounted, 32u * 32u);
+
+  /** The list samples are filled in parallel chunks and compacted in sample order, so the kNN graphs, and the
+   * sums over them, are the same as when they are filled serially.
+   */
+  MetricType::MeasureType    value{};
+  MetricType::DerivativeType derivative;
+  unsigned long              numberOfPixelsCounted{};
+  GetValueAndDerivative(true, value, derivative, numberOfPixelsCounted);
+
+  EXPECT_EQ(numberOfPixelsCounted, expectedNumberOfPixelsCounted);
+  EXPECT_EQ(value, expectedValue);
+  EXPECT_EQ(derivative, expectedDerivative);
+}
@@ -0,0 +1,322 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+
+#include "elxMetricGTestUtilities.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm> // For max.
+#include <cmath>
+#include <vector>
+
+namespace
+{
+using elastix::MetricGTestUtilities::ImageType;
+using MetricType = itk::ParzenWindowMutualInformationImageToImageMetric<ImageType, ImageType>;
+
+
+/** Computes the value and the finite difference derivative of the mutual information. */
+void
+GetValueAndFiniteDifferenceDerivative(const bool                   useMultiThread,
+                                      MetricType::MeasureType &    value,
+                                      MetricType::DerivativeType & derivative)
+{
+  const auto fixedImage = elastix::MetricGTestUtilities::CreateBlobImage(15.0, 16.0);
+  const auto movingImage = elastix::MetricGTestUtilities::CreateBlobImage(17.0, 14.5);
+  const auto transform = elastix::MetricGTestUtilities::CreateBSplineTransform(*fixedImage);
+
+  const auto metric = MetricType::New();
+  metric->SetNumberOfFixedHistogramBins(16);
+  metric->SetNumberOfMovingHistogramBins(16);
+  metric->SetUseFiniteDifferenceDerivative(true);
+  metric->SetFiniteDifferencePerturbation(0.5);
+  metric->SetUseMultiThread(useMultiThread);
+  elastix::MetricGTestUtilities::InitializeMetric(*metric, *fixedImage, *movingImage, *transform);
+
+  metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+}
+
+
+/** Mutual information metric that tells whether its sample cache was filled. */
+class SampleCacheMetricType : public MetricType
+{
+public:
+  using Self = SampleCacheMetricType;
+  using Pointer = itk::SmartPointer<Self>;
+
+  itkNewMacro(Self);
+
+  bool
+  IsSampleCacheFilled() const
+  {
+    return this->m_SampleCacheFilled;
+  }
+
+protected:
+  SampleCacheMetricType() = default;
+};
+
+
+/** Computes the value and the low memory analytic derivative of the mutual information, multi-threaded, with the
+ * specified sample cache settings. Returns whether the sample cache was filled.
+ */
+bool
+GetValueAndDerivativeWithSampleCache(itk::ImageSamplerBase<ImageType> & sampler,
+                                     const bool                         useSampleCache,
+                                     const double                       maximumSampleCacheMemory,
+                                     MetricType::MeasureType &          value,
+                                     MetricType::DerivativeType &       derivative)
+{
+  const auto fixedImage = elastix::MetricGTestUtilities::CreateBlobImage(15.0, 16.0);
+  const auto movingImage = elastix::MetricGTestUtilities::CreateBlobImage(17.0, 14.5);
+  const auto transform = elastix::MetricGTestUtilities::CreateBSplineTransform(*fixedImage);
+
+  const auto metric = SampleCacheMetricType::New();
+  metric->SetNumberOfFixedHistogramBins(16);
+  metric->SetNumberOfMovingHistogramBins(16);
+  metric->SetUseExplicitPDFDerivatives(false);
+  metric->SetUseMultiThread(true);
+  metric->SetUseSampleCache(useSampleCache);
+  metric->SetMaximumSampleCacheMemory(maximumSampleCacheMemory);
+  elastix::MetricGTestUtilities::InitializeMetric(*metric, *fixedImage, *movingImage, *transform, sampler);
+
+  metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+  return metric->IsSampleCacheFilled();
+}
+
+
+/** Expects that the derivative with the sample cache, and with the fallback when the cache does not fit in its
+ * maximum memory, equals the derivative without the sample cache.
+ */
+void
+ExpectSampleCacheDerivativeEqualsUncached(itk::ImageSamplerBase<ImageType> & sampler)
+{
+  MetricType::MeasureType    expectedValue{};
+  MetricType::DerivativeType expectedDerivative;
+  EXPECT_FALSE(GetValueAndDerivativeWithSampleCache(sampler, false, 512.0, expectedValue, expectedDerivative));
+
+  for (const double maximumSampleCacheMemory : { 512.0, 1e-6 })
+  {
+    MetricType::MeasureType    value{};
+    MetricType::DerivativeType derivative;
+    const bool                 isSampleCacheFilled =
+      GetValueAndDerivativeWithSampleCache(sampler, true, maximumSampleCacheMemory, value, derivative);
+
+    /** Only the cache of 512 MB is large enough for the samples. */
+    EXPECT_EQ(isSampleCacheFilled, maximumSampleCacheMemory > 1.0);
+    EXPECT_EQ(value, expectedValue) << "MaximumSampleCacheMemory " << maximumSampleCacheMemory;
+    EXPECT_EQ(derivative, expectedDerivative) << "MaximumSampleCacheMemory " << maximumSampleCacheMemory;
+  }
+}
+
+
+/** Mutual information metric that can be restricted to the generic implementation of the Parzen kernels, and that
+ * exposes its joint PDF.
+ */
+class ParzenKernelMetricType : public MetricType
+{
+public:
+  using Self = ParzenKernelMetricType;
+  using Superclass = MetricType;
+  using Pointer = itk::SmartPointer<Self>;
+
+  itkNewMacro(Self);
+
+  void
+  SetAllowSpecializedParzenKernels(const bool allowSpecializedParzenKernels)
+  {
+    m_AllowSpecializedParzenKernels = allowSpecializedParzenKernels;
+  }
+
+  bool
+  GetUseSpecializedParzenKernels() const
+  {
+    return this->m_UseSpecializedParzenKernels;
+  }
+
+  /** Returns the joint PDF, as a vector of bins, with the moving image bins along the first dimension. */
+  std::vector<double>
+  GetJointPDFValues() const
+  {
+    const double * const buffer = this->m_JointPDF->GetBufferPointer();
+    return { buffer, buffer + this->m_JointPDF->GetBufferedRegion().GetNumberOfPixels() };
+  }
+
+protected:
+  ParzenKernelMetricType() = default;
+
+  void
+  InitializeKernels() override
+  {
+    Superclass::InitializeKernels();
+    this->m_UseSpecializedParzenKernels = this->m_UseSpecializedParzenKernels && m_AllowSpecializedParzenKernels;
+  }
+
+private:
+  bool m_AllowSpecializedParzenKernels{ true };
+};
+
+
+/** Computes the value, the low memory analytic derivative and the joint PDF of the mutual information, with the
+ * default kernel orders, with or without their specialized implementation. The limit range ratios are zero, so
+ * that the minimum and maximum intensities fall into the bins at the borders of the histogram.
+ */
+std::vector<double>
+GetValueDerivativeAndJointPDF(const bool                   allowSpecializedParzenKernels,
+                              const bool                   useMultiThread,
+                              MetricType::MeasureType &    value,
+                              MetricType::DerivativeType & derivative)
+{
+  const auto fixedImage = elastix::MetricGTestUtilities::CreateBlobImage(15.0, 16.0);
+  const auto movingImage = elastix::MetricGTestUtilities::CreateBlobImage(17.0, 14.5);
+  const auto transform = elastix::MetricGTestUtilities::CreateBSplineTransform(*fixedImage);
+
+  const auto metric = ParzenKernelMetricType::New();
+  metric->SetNumberOfFixedHistogramBins(16);
+  metric->SetNumberOfMovingHistogramBins(16);
+  metric->SetFixedLimitRangeRatio(0.0);
+  metric->SetMovingLimitRangeRatio(0.0);
+  metric->SetUseExplicitPDFDerivatives(false);
+  metric->SetUseMultiThread(useMultiThread);
+  metric->SetAllowSpecializedParzenKernels(allowSpecializedParzenKernels);
+  elastix::MetricGTestUtilities::InitializeMetric(*metric, *fixedImage, *movingImage, *transform);
+  EXPECT_EQ(metric->GetUseSpecializedParzenKernels(), allowSpecializedParzenKernels);
+
+  metric->GetValueAndDerivative(transform->GetParameters(), value, derivative);
+  return metric->GetJointPDFValues();
+}
+
+} // namespace
+
+
+GTEST_TEST(ParzenWindowMutualInformationImageToImageMetric, SparseFiniteDifferenceDerivativeEqualsDense)
+{
+  MetricType::MeasureType    denseValue{};
+  MetricType::DerivativeType denseDerivative;
+  GetValueAndFiniteDifferenceDerivative(false, denseValue, denseDerivative);
+
+  /** The multi-threaded version only visits the bins touched by the perturbed samples. */
+  MetricType::MeasureType    sparseValue{};
+  MetricType::DerivativeType sparseDerivative;
+  GetValueAndFiniteDifferenceDerivative(true, sparseValue, sparseDerivative);
+
+  EXPECT_NEAR(sparseValue, denseValue, 1e-10);
+  ASSERT_EQ(sparseDerivative.size(), denseDerivative.size());
+
+  double maxAbsDerivative = 0.0;
+  for (const double d : denseDerivative)
+  {
+    maxAbsDerivative = std::max(maxAbsDerivative, std::abs(d));
+  }
+  ASSERT_GT(maxAbsDerivative, 0.0);
+
+  /** The sums are done in a different order. */
+  const double tolerance = 1e-8 * maxAbsDerivative;
+  for (unsigned int k = 0; k < denseDerivative.size(); ++k)
+  {
+    EXPECT_NEAR(sparseDerivative[k], denseDerivative[k], tolerance) << "parameter " << k;
+  }
+}
+
+
+GTEST_TEST(ParzenWindowMutualInformationImageToImageMetric, WeightedSamplesEqualDuplicatedSamples)
+{
+  for (const bool useMultiThread : { false, true })
+  {
+    elastix::MetricGTestUtilities::ExpectWeightedSamplesEqualDuplicatedSamples<MetricType>(
+      [useMultiThread](MetricType & metric) {
+        metric.SetNumberOfFixedHistogramBins(16);
+        metric.SetNumberOfMovingHistogramBins(16);
+        metric.SetUseExplicitPDFDerivatives(false);
+        metric.SetUseMultiThread(useMultiThread);
+      });
+  }
+}
+
+
+GTEST_TEST(ParzenWindowMutualInformationImageToImageMetric, SampleCacheDerivativeEqualsUncached)
+{
+  ExpectSampleCacheDerivativeEqualsUncached(*itk::ImageFullSampler<ImageType>::New());
+}
+
+
+GTEST_TEST(ParzenWindowMutualInformationImageToImageMetric, SampleCacheDerivativeEqualsUncachedForWeightedSamples)
+{
+  const auto fixedImage = elastix::MetricGTestUtilities::CreateBlobImage(15.0, 16.0);
+
+  /** Importance weights that differ per sample, including zero weights. */
+  std::vector<ImageType::IndexType> indices;
+  std::vector<double>               weights;
+  for (itk::IndexValueType y = 2; y < 30; ++y)
+  {
+    for (itk::IndexValueType x = 2; x < 30; ++x)
+    {
+      indices.push_back({ { x, y } });
+      weights.push_back(static_cast<double>((x + 2 * y) % 4) * 0.5);
+    }
+  }
+  const auto sampler = elastix::MetricGTestUtilities::ListSampler::New();
+  sampler->SetSamples(*fixedImage, indices, weights);
+
+  ExpectSampleCacheDerivativeEqualsUncached(*sampler);
+}
+
+
+GTEST_TEST(ParzenWindowMutualInformationImageToImageMetric, SpecializedParzenKernelsEqualGenericOnes)
+{
+  constexpr unsigned int numberOfBins = 16;
+
+  for (const bool useMultiThread : { false, true })
+  {
+    MetricType::MeasureType    genericValue{};
+    MetricType::DerivativeType genericDerivative;
+    const auto genericJointPDF = GetValueDerivativeAndJointPDF(false, useMultiThread, genericValue, genericDerivative);
+
+    MetricType::MeasureType    specializedValue{};
+    MetricType::DerivativeType specializedDerivative;
+    const auto                 specializedJointPDF =
+      GetValueDerivativeAndJointPDF(true, useMultiThread, specializedValue, specializedDerivative);
+
+    /** Both implementations evaluate the same kernels, and add to each bin in the same order. */
+    ASSERT_EQ(genericJointPDF.size(), numberOfBins * numberOfBins);
+    EXPECT_EQ(specializedJointPDF, genericJointPDF);
+    EXPECT_EQ(specializedValue, genericValue);
+    EXPECT_EQ(specializedDerivative, genericDerivative);
+
+    /** Check that the bins at all four borders of the histogram are reached. */
+    double firstFixedBin = 0.0;
+    double lastFixedBin = 0.0;
+    double firstMovingBin = 0.0;
+    double lastMovingBin = 0.0;
+    for (unsigned int i = 0; i < numberOfBins; ++i)
+    {
+      firstFixedBin += genericJointPDF[i];
+      lastFixedBin += genericJointPDF[(numberOfBins - 1) * numberOfBins + i];
+      firstMovingBin += genericJointPDF[i * numberOfBins];
+      lastMovingBin += genericJointPDF[i * numberOfBins + numberOfBins - 1];
+    }
+    EXPECT_GT(firstFixedBin, 0.0);
+    EXPECT_GT(lastFixedBin, 0.0);
+    EXPECT_GT(firstMovingBin, 0.0);
+    EXPECT_GT(lastMovingBin, 0.0);
+  }
+}
@@ -0,0 +1,152 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkPerLevelMultiResolutionPyramidImageFilter.h"
+
+#include "itkGenericMultiResolutionPyramidImageFilter.h"
+#include "itkMultiResolutionGaussianSmoothingPyramidImageFilter.h"
+#include "itkMultiResolutionShrinkPyramidImageFilter.h"
+#include "itkImage.h"
+#include "itkImageBufferRange.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm> // For equal.
+#include <random>
+#include <vector>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+
+constexpr unsigned int numberOfLevels = 3;
+
+
+ImageType::Pointer
+CreateImage()
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 37, 29 } });
+  image->Allocate();
+
+  std::mt19937                     randomNumberEngine;
+  std::uniform_real_distribution<> distribution(0.0, 100.0);
+  for (auto & pixel : itk::ImageBufferRange<ImageType>(*image))
+  {
+    pixel = static_cast<float>(distribution(randomNumberEngine));
+  }
+  return image;
+}
+
+
+bool
+AreEqual(const ImageType & image1, const ImageType & image2)
+{
+  if (image1.GetBufferedRegion() != image2.GetBufferedRegion() || image1.GetSpacing() != image2.GetSpacing() ||
+      image1.GetOrigin() != image2.GetOrigin())
+  {
+    return false;
+  }
+  const itk::ImageBufferRange<const ImageType> range1(image1);
+  const itk::ImageBufferRange<const ImageType> range2(image2);
+  return std::equal(range1.cbegin(), range1.cend(), range2.cbegin(), range2.cend());
+}
+
+
+/** Expects that computing the levels one by one, optionally with the next level
+ * precomputed in the background, gives the same images as computing all levels at once.
+ */
+template <class TPyramid>
+void
+ExpectPerLevelOutputsEqualAllLevels(const bool precomputeInBackground)
+{
+  const auto image = CreateImage();
+
+  const auto allLevelsPyramid = TPyramid::New();
+  allLevelsPyramid->SetNumberOfLevels(numberOfLevels);
+  allLevelsPyramid->SetInput(image);
+  allLevelsPyramid->Update();
+
+  const auto pyramid = TPyramid::New();
+  pyramid->SetNumberOfLevels(numberOfLevels);
+  pyramid->SetComputeOnlyForCurrentLevel(true);
+  pyramid->SetInput(image);
+
+  for (unsigned int level = 0; level < numberOfLevels; ++level)
+  {
+    pyramid->SetCurrentLevel(level);
+    pyramid->Update();
+
+    EXPECT_TRUE(AreEqual(*pyramid->GetOutput(level), *allLevelsPyramid->GetOutput(level))) << "level " << level;
+
+    /** The outputs of the other levels are released. */
+    for (unsigned int otherLevel = 0; otherLevel < numberOfLevels; ++otherLevel)
+    {
+      if (otherLevel != level)
+      {
+        EXPECT_EQ(pyramid->GetOutput(otherLevel)->GetBufferedRegion().GetNumberOfPixels(), 0u)
+          << "level " << level << ", other level " << otherLevel;
+      }
+    }
+
+    if (precomputeInBackground && level + 1 < numberOfLevels)
+    {
+      pyramid->PrecomputeLevelInBackground(level + 1);
+    }
+  }
+}
+
+
+template <class TPyramid>
+void
+ExpectPerLevelOutputsEqualAllLevels()
+{
+  ExpectPerLevelOutputsEqualAllLevels<TPyramid>(false);
+  ExpectPerLevelOutputsEqualAllLevels<TPyramid>(true);
+}
+
+} // namespace
+
+
+GTEST_TEST(PerLevelMultiResolutionPyramidImageFilter, SetCurrentLevelClampsToNumberOfLevels)
+{
+  const auto pyramid = itk::MultiResolutionShrinkPyramidImageFilter<ImageType, ImageType>::New();
+  pyramid->SetNumberOfLevels(numberOfLevels);
+  pyramid->SetCurrentLevel(numberOfLevels + 2);
+  EXPECT_EQ(pyramid->GetCurrentLevel(), numberOfLevels - 1);
+}
+
+
+GTEST_TEST(PerLevelMultiResolutionPyramidImageFilter, ShrinkPyramidPerLevelEqualsAllLevels)
+{
+  ExpectPerLevelOutputsEqualAllLevels<itk::MultiResolutionShrinkPyramidImageFilter<ImageType, ImageType>>();
+}
+
+
+GTEST_TEST(PerLevelMultiResolutionPyramidImageFilter, SmoothingPyramidPerLevelEqualsAllLevels)
+{
+  ExpectPerLevelOutputsEqualAllLevels<itk::MultiResolutionGaussianSmoothingPyramidImageFilter<ImageType, ImageType>>();
+}
+
+
+GTEST_TEST(PerLevelMultiResolutionPyramidImageFilter, GenericPyramidPerLevelEqualsAllLevels)
+{
+  ExpectPerLevelOutputsEqualAllLevels<itk::GenericMultiResolutionPyramidImageFilter<ImageType, ImageType>>();
+}
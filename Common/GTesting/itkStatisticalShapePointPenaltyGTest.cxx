@@ -0,0 +1,205 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "StatisticalShapePenalty/itkStatisticalShapePointPenalty.h"
+
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+#include "itkPointSet.h"
+
+#include <vnl/algo/vnl_symmetric_eigensystem.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm> // For max.
+#include <cmath>
+#include <random>
+
+namespace
+{
+using PointSetType = itk::PointSet<double, 3>;
+using PenaltyType = itk::StatisticalShapePointPenalty<PointSetType, PointSetType>;
+using TransformType = itk::AdvancedMatrixOffsetTransformBase<double, 3, 3>;
+using ParametersType = PenaltyType::TransformParametersType;
+using VnlVectorType = PenaltyType::VnlVectorType;
+using VnlMatrixType = PenaltyType::VnlMatrixType;
+
+constexpr unsigned int numberOfPoints = 5;
+constexpr unsigned int shapeLength = 3 * numberOfPoints;
+constexpr unsigned int numberOfComponents = 4;
+
+
+/** Creates a penalty with a pseudo random shape model, for the specified ShapeModelCalculation option. */
+PenaltyType::Pointer
+CreatePenalty(const int shapeModelCalculation, const bool normalizedShapeModel, TransformType & transform)
+{
+  const double coordinates[numberOfPoints][3] = {
+    { 0.0, 0.0, 0.0 }, { 10.0, 0.0, 1.0 }, { 1.0, 12.0, 2.0 }, { 2.0, 3.0, 9.0 }, { 6.0, 7.0, 5.0 }
+  };
+  const auto pointSet = PointSetType::New();
+  for (unsigned int i = 0; i < numberOfPoints; ++i)
+  {
+    PointSetType::PointType point;
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+      point[d] = coordinates[i][d];
+    }
+    pointSet->SetPoint(i, point);
+  }
+
+  /** A symmetric positive definite covariance matrix, and a mean shape. */
+  const unsigned int               proposalLength = normalizedShapeModel ? shapeLength + 4 : shapeLength;
+  std::mt19937                     randomNumberEngine;
+  std::uniform_real_distribution<> distribution(-1.0, 1.0);
+
+  VnlMatrixType randomMatrix(proposalLength, proposalLength);
+  for (unsigned int i = 0; i < proposalLength; ++i)
+  {
+    for (unsigned int j = 0; j < proposalLength; ++j)
+    {
+      randomMatrix(i, j) = distribution(randomNumberEngine);
+    }
+  }
+  VnlMatrixType covariance = randomMatrix * randomMatrix.transpose() / proposalLength;
+  for (unsigned int i = 0; i < proposalLength; ++i)
+  {
+    covariance(i, i) += 0.1;
+  }
+
+  VnlVectorType mean(proposalLength);
+  for (auto & element : mean)
+  {
+    element = 5.0 * distribution(randomNumberEngine);
+  }
+
+  const auto penalty = PenaltyType::New();
+  penalty->SetFixedPointSet(pointSet);
+  penalty->SetMovingPointSet(pointSet);
+  penalty->SetTransform(&transform);
+  penalty->SetNormalizedShapeModel(normalizedShapeModel);
+  penalty->SetShapeModelCalculation(shapeModelCalculation);
+  penalty->SetShrinkageIntensity(0.3);
+  penalty->SetBaseVariance(1.0);
+  penalty->SetCentroidXVariance(2.0);
+  penalty->SetCentroidYVariance(2.5);
+  penalty->SetCentroidZVariance(3.0);
+  penalty->SetSizeVariance(4.0);
+  penalty->SetCutOffValue(0.0);
+  penalty->SetCutOffSharpness(2.0);
+
+  /** The penalty takes ownership of the model. */
+  penalty->SetMeanVector(new VnlVectorType(mean));
+  if (shapeModelCalculation == 3)
+  {
+    /** The principal components with the largest eigenvalues (which are sorted in ascending order). */
+    const vnl_symmetric_eigensystem<double> eigensystem(covariance);
+    penalty->SetEigenVectors(
+      new VnlMatrixType(eigensystem.V.get_n_columns(proposalLength - numberOfComponents, numberOfComponents)));
+    penalty->SetEigenValues(new VnlVectorType(eigensystem.D.diagonal().extract(numberOfComponents,
+                                                                                proposalLength - numberOfComponents)));
+  }
+  else
+  {
+    penalty->SetCovarianceMatrix(new VnlMatrixType(covariance));
+  }
+
+  penalty->Initialize();
+  return penalty;
+}
+
+
+/** Returns the parameters of an affine transform, slightly away from the identity. */
+ParametersType
+GetAffineParameters(const TransformType & transform)
+{
+  ParametersType parameters = transform.GetParameters();
+
+  std::mt19937                     randomNumberEngine(42);
+  std::uniform_real_distribution<> distribution(-0.05, 0.05);
+  for (auto & parameter : parameters)
+  {
+    parameter += distribution(randomNumberEngine);
+  }
+  return parameters;
+}
+
+
+/** Expects that the derivative of the penalty equals the central finite difference derivative of its value. */
+void
+ExpectDerivativeMatchesFiniteDifferences(const int shapeModelCalculation, const bool normalizedShapeModel)
+{
+  const auto transform = TransformType::New();
+  transform->SetIdentity();
+  const auto penalty = CreatePenalty(shapeModelCalculation, normalizedShapeModel, *transform);
+
+  const ParametersType parameters = GetAffineParameters(*transform);
+
+  PenaltyType::MeasureType    value{};
+  PenaltyType::DerivativeType derivative;
+  penalty->GetValueAndDerivative(parameters, value, derivative);
+
+  ASSERT_GT(value, 0.0);
+  EXPECT_NEAR(value, penalty->GetValue(parameters), 1e-12 * value);
+  ASSERT_EQ(derivative.GetSize(), parameters.GetSize());
+
+  const double delta = 1e-6;
+  for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+  {
+    ParametersType testPoint = parameters;
+    testPoint[i] = parameters[i] + delta;
+    const double valuePlus = penalty->GetValue(testPoint);
+    testPoint[i] = parameters[i] - delta;
+    const double valueMinus = penalty->GetValue(testPoint);
+
+    const double finiteDifference = (valuePlus - valueMinus) / (2.0 * delta);
+    EXPECT_NEAR(derivative[i], finiteDifference, 1e-5 * std::max(1.0, std::abs(finiteDifference)))
+      << "ShapeModelCalculation " << shapeModelCalculation << ", NormalizedShapeModel " << normalizedShapeModel
+      << ", parameter " << i;
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(StatisticalShapePointPenalty, DerivativeOfFullCovarianceMatchesFiniteDifferences)
+{
+  ExpectDerivativeMatchesFiniteDifferences(0, false);
+  ExpectDerivativeMatchesFiniteDifferences(0, true);
+}
+
+
+GTEST_TEST(StatisticalShapePointPenalty, DerivativeOfDecomposedCovarianceMatchesFiniteDifferences)
+{
+  /** Option 1 is only implemented for NormalizedShapeModel = false. */
+  ExpectDerivativeMatchesFiniteDifferences(1, false);
+}
+
+
+GTEST_TEST(StatisticalShapePointPenalty, DerivativeOfDecomposedScaledCovarianceMatchesFiniteDifferences)
+{
+  /** Option 2 is only implemented for NormalizedShapeModel = true. */
+  ExpectDerivativeMatchesFiniteDifferences(2, true);
+}
+
+
+GTEST_TEST(StatisticalShapePointPenalty, DerivativeOfLowRankModelMatchesFiniteDifferences)
+{
+  ExpectDerivativeMatchesFiniteDifferences(3, false);
+  ExpectDerivativeMatchesFiniteDifferences(3, true);
+}
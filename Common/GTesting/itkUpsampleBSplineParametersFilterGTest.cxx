@@ -0,0 +1,110 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkUpsampleBSplineParametersFilter.h"
+#include "../Core/Main/GTesting/elxCoreMainGTestUtilities.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkOptimizerParameters.h"
+
+#include <gtest/gtest.h>
+
+// Using-declaration:
+using elx::CoreMainGTestUtilities::CheckNew;
+
+namespace
+{
+constexpr unsigned int Dimension = 2;
+using TransformType = itk::AdvancedBSplineDeformableTransform<double, Dimension, 3>;
+using ParametersType = itk::OptimizerParameters<double>;
+using UpsamplerType = itk::UpsampleBSplineParametersFilter<ParametersType, TransformType::ImageType>;
+
+} // namespace
+
+
+GTEST_TEST(UpsampleBSplineParametersFilter, DirectSubdivisionRepresentsTheSameTransform)
+{
+  /** A coarse grid with spacing 4, and a refined grid with spacing 2 that
+   * starts half a coarse grid cell before the coarse grid.
+   */
+  TransformType::RegionType coarseRegion;
+  coarseRegion.SetSize({ { 8, 7 } });
+  const TransformType::SpacingType coarseSpacing(4.0);
+  const auto                       coarseOrigin = itk::MakePoint(0.0, 1.0);
+
+  TransformType::RegionType fineRegion;
+  fineRegion.SetSize({ { 17, 15 } });
+  const TransformType::SpacingType fineSpacing(2.0);
+  const auto                       fineOrigin = itk::MakePoint(-2.0, -1.0);
+
+  TransformType::DirectionType direction;
+  direction.SetIdentity();
+
+  const auto coarseTransform = TransformType::New();
+  coarseTransform->SetGridRegion(coarseRegion);
+  coarseTransform->SetGridSpacing(coarseSpacing);
+  coarseTransform->SetGridOrigin(coarseOrigin);
+  coarseTransform->SetGridDirection(direction);
+
+  ParametersType coarseParameters(coarseTransform->GetNumberOfParameters());
+  for (unsigned int i = 0; i < coarseParameters.GetSize(); ++i)
+  {
+    coarseParameters[i] = 0.1 * static_cast<double>((i * 7) % 11) - 0.5;
+  }
+  coarseTransform->SetParameters(coarseParameters);
+
+  const auto upsampler = CheckNew<UpsamplerType>();
+  upsampler->SetBSplineOrder(3);
+  upsampler->SetUseDirectSubdivision(true);
+  upsampler->SetCurrentGridRegion(coarseRegion);
+  upsampler->SetCurrentGridSpacing(coarseSpacing);
+  upsampler->SetCurrentGridOrigin(coarseOrigin);
+  upsampler->SetCurrentGridDirection(direction);
+  upsampler->SetRequiredGridRegion(fineRegion);
+  upsampler->SetRequiredGridSpacing(fineSpacing);
+  upsampler->SetRequiredGridOrigin(fineOrigin);
+  upsampler->SetRequiredGridDirection(direction);
+
+  ParametersType fineParameters;
+  upsampler->UpsampleParameters(coarseParameters, fineParameters);
+
+  const auto fineTransform = TransformType::New();
+  fineTransform->SetGridRegion(fineRegion);
+  fineTransform->SetGridSpacing(fineSpacing);
+  fineTransform->SetGridOrigin(fineOrigin);
+  fineTransform->SetGridDirection(direction);
+  ASSERT_EQ(fineParameters.GetSize(), fineTransform->GetNumberOfParameters());
+  fineTransform->SetParameters(fineParameters);
+
+  /** Compare both transforms within the valid region of the coarse grid. */
+  for (double x = 5.0; x < 23.0; x += 1.3)
+  {
+    for (double y = 6.0; y < 19.0; y += 1.7)
+    {
+      const auto point = itk::MakePoint(x, y);
+      const auto expected = coarseTransform->TransformPoint(point);
+      const auto actual = fineTransform->TransformPoint(point);
+      for (unsigned int i = 0; i < Dimension; ++i)
+      {
+        EXPECT_NEAR(actual[i], expected[i], 1e-10);
+      }
+    }
+  }
+}
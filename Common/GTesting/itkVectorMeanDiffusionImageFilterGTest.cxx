@@ -0,0 +1,220 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "BSplineDeformableTransformWithDiffusion/itkVectorMeanDiffusionImageFilter.h"
+
+#include "itkImage.h"
+#include "itkImageBufferRange.h"
+#include "itkVector.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm> // For min, max and minmax_element.
+#include <cmath>
+#include <vector>
+
+namespace
+{
+using VectorType = itk::Vector<float, 2>;
+using FieldImageType = itk::Image<VectorType, 2>;
+using GrayValueImageType = itk::Image<float, 2>;
+using FilterType = itk::VectorMeanDiffusionImageFilter<FieldImageType, GrayValueImageType>;
+
+constexpr itk::SizeValueType sizeX = 24;
+constexpr itk::SizeValueType sizeY = 20;
+
+
+/** Creates a smooth deformation field with some texture. */
+FieldImageType::Pointer
+CreateField()
+{
+  const auto field = FieldImageType::New();
+  field->SetRegions(FieldImageType::SizeType{ { sizeX, sizeY } });
+  field->Allocate();
+
+  const itk::ImageBufferRange<FieldImageType> range(*field);
+  auto                                        pixel = range.begin();
+  for (unsigned int y = 0; y < sizeY; ++y)
+  {
+    for (unsigned int x = 0; x < sizeX; ++x, ++pixel)
+    {
+      VectorType vector;
+      vector[0] = static_cast<float>(std::sin(0.8 * x) + 0.1 * y);
+      vector[1] = static_cast<float>(std::cos(0.6 * y) - 0.2 * x);
+      *pixel = vector;
+    }
+  }
+  return field;
+}
+
+
+/** Creates a gray value image that has its minimum in a border of three voxels, so that only the voxels inside the
+ * border are diffused.
+ */
+GrayValueImageType::Pointer
+CreateGrayValueImage()
+{
+  const auto image = GrayValueImageType::New();
+  image->SetRegions(GrayValueImageType::SizeType{ { sizeX, sizeY } });
+  image->Allocate();
+
+  const itk::ImageBufferRange<GrayValueImageType> range(*image);
+  auto                                            pixel = range.begin();
+  for (unsigned int y = 0; y < sizeY; ++y)
+  {
+    for (unsigned int x = 0; x < sizeX; ++x, ++pixel)
+    {
+      const bool isBorder = x < 3 || y < 3 || x >= sizeX - 3 || y >= sizeY - 3;
+      *pixel = isBorder ? -5.0f : static_cast<float>((x * y) % 7 + 2 * (x % 3));
+    }
+  }
+  return image;
+}
+
+
+/** Diffuses the field with the specified number of work units. */
+std::vector<VectorType>
+Diffuse(const unsigned int numberOfIterations, const itk::ThreadIdType numberOfWorkUnits)
+{
+  const auto field = CreateField();
+  const auto grayValueImage = CreateGrayValueImage();
+
+  const auto filter = FilterType::New();
+  filter->SetInput(field);
+  filter->SetGrayValueImage(grayValueImage);
+  filter->SetNumberOfIterations(numberOfIterations);
+  filter->SetNumberOfWorkUnits(numberOfWorkUnits);
+  filter->GetMultiThreader()->SetNumberOfWorkUnits(numberOfWorkUnits);
+  filter->Update();
+
+  /** Only the bounding box of the voxels above the minimum gray value is diffused. */
+  const FieldImageType::IndexType expectedIndex{ { 3, 3 } };
+  const FieldImageType::SizeType  expectedSize{ { sizeX - 6, sizeY - 6 } };
+  EXPECT_EQ(filter->GetRegionOfInterest(), FieldImageType::RegionType(expectedIndex, expectedSize));
+
+  const itk::ImageBufferRange<const FieldImageType> range(*filter->GetOutput());
+  return { range.cbegin(), range.cend() };
+}
+
+
+/** Diffuses the field in a straightforward way: single-threaded, over the whole image, with the stiffness
+ * coefficients of the gray values rescaled between 1e-6 and 1 - 1e-6.
+ */
+std::vector<VectorType>
+DiffuseSingleThreadedReference(const unsigned int numberOfIterations)
+{
+  const auto field = CreateField();
+  const auto grayValueImage = CreateGrayValueImage();
+
+  const itk::ImageBufferRange<const GrayValueImageType> grayValues(*grayValueImage);
+  const auto   minmax = std::minmax_element(grayValues.cbegin(), grayValues.cend());
+  const double minimum = *minmax.first;
+  const double scale = (1.0 - 2e-6) / (*minmax.second - minimum);
+
+  std::vector<double> coefficients;
+  for (const float grayValue : grayValues)
+  {
+    coefficients.push_back(1e-6 + (grayValue - minimum) * scale);
+  }
+
+  const itk::ImageBufferRange<const FieldImageType> fieldRange(*field);
+  std::vector<VectorType>                           current(fieldRange.cbegin(), fieldRange.cend());
+  std::vector<VectorType>                           next(current.size());
+
+  /** Zero flux Neumann boundary condition. */
+  const auto toOffset = [](const int x, const int y) {
+    return std::min(std::max(y, 0), int{ sizeY } - 1) * sizeX + std::min(std::max(x, 0), int{ sizeX } - 1);
+  };
+
+  for (unsigned int k = 0; k < numberOfIterations; ++k)
+  {
+    for (int y = 0; y < int{ sizeY }; ++y)
+    {
+      for (int x = 0; x < int{ sizeX }; ++x)
+      {
+        const auto   offset = toOffset(x, y);
+        const double c = coefficients[offset];
+        if (c <= 0.000001)
+        {
+          next[offset] = current[offset];
+          continue;
+        }
+
+        double sum[2] = { 0.0, 0.0 };
+        double sumc = 0.0;
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+          for (int dx = -1; dx <= 1; ++dx)
+          {
+            const auto   neighborOffset = toOffset(x + dx, y + dy);
+            const double ci = coefficients[neighborOffset];
+            sumc += ci;
+            sum[0] += ci * current[neighborOffset][0];
+            sum[1] += ci * current[neighborOffset][1];
+          }
+        }
+        for (unsigned int j = 0; j < 2; ++j)
+        {
+          next[offset][j] = static_cast<float>((1.0 - c) * current[offset][j] + c * sum[j] / sumc);
+        }
+      }
+    }
+    std::swap(current, next);
+  }
+  return current;
+}
+
+} // namespace
+
+
+GTEST_TEST(VectorMeanDiffusionImageFilter, MultiThreadedEqualsSingleThreaded)
+{
+  /** Both an odd and an even number of iterations, as the iterations alternate between two images. */
+  for (const unsigned int numberOfIterations : { 0U, 1U, 4U, 5U })
+  {
+    const auto expectedField = Diffuse(numberOfIterations, 1);
+    for (const itk::ThreadIdType numberOfWorkUnits : { 2U, 3U, 8U })
+    {
+      EXPECT_EQ(Diffuse(numberOfIterations, numberOfWorkUnits), expectedField)
+        << "NumberOfIterations " << numberOfIterations << ", NumberOfWorkUnits " << numberOfWorkUnits;
+    }
+  }
+}
+
+
+GTEST_TEST(VectorMeanDiffusionImageFilter, MultiThreadedEqualsReference)
+{
+  for (const unsigned int numberOfIterations : { 1U, 4U, 5U })
+  {
+    const auto expectedField = DiffuseSingleThreadedReference(numberOfIterations);
+    const auto field = Diffuse(numberOfIterations, 8);
+    ASSERT_EQ(field.size(), expectedField.size());
+
+    /** The field is stored in single precision. */
+    for (std::size_t i = 0; i < field.size(); ++i)
+    {
+      for (unsigned int j = 0; j < 2; ++j)
+      {
+        EXPECT_NEAR(field[i][j], expectedField[i][j], 1e-5)
+          << "NumberOfIterations " << numberOfIterations << ", voxel " << i << ", component " << j;
+      }
+    }
+  }
+}
@@ -0,0 +1,208 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "WeightedCombinationTransform/itkWeightedCombinationTransform.h"
+
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+#include "itkImage.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+using TransformType = itk::WeightedCombinationTransform<double, 3, 3>;
+using SubTransformType = itk::AdvancedMatrixOffsetTransformBase<double, 3, 3>;
+using GridImageType = itk::Image<float, 3>;
+
+constexpr unsigned int numberOfSubTransforms = 4;
+
+
+/** Creates a weighted combination of pseudo random affine sub-transforms. Because the
+ * displacements of affine transforms are linear, their linear interpolation is exact.
+ */
+TransformType::Pointer
+CreateTransform(const bool normalizeWeights)
+{
+  std::mt19937                     randomNumberEngine;
+  std::uniform_real_distribution<> distribution(-0.1, 0.1);
+
+  TransformType::TransformContainerType subTransforms;
+  for (unsigned int i = 0; i < numberOfSubTransforms; ++i)
+  {
+    const auto subTransform = SubTransformType::New();
+    subTransform->SetIdentity();
+
+    auto parameters = subTransform->GetParameters();
+    for (auto & parameter : parameters)
+    {
+      parameter += distribution(randomNumberEngine);
+    }
+    /** Larger translations. */
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+      parameters[9 + d] *= 20.0;
+    }
+    subTransform->SetParameters(parameters);
+    subTransforms.push_back(subTransform.GetPointer());
+  }
+
+  const auto transform = TransformType::New();
+  transform->SetNormalizeWeights(normalizeWeights);
+  transform->SetTransformContainer(subTransforms);
+
+  TransformType::ParametersType weights(numberOfSubTransforms);
+  for (unsigned int i = 0; i < numberOfSubTransforms; ++i)
+  {
+    weights[i] = 0.2 + 0.1 * i;
+  }
+  transform->SetParameters(weights);
+  return transform;
+}
+
+
+/** A grid of 6 x 5 x 4 nodes, with an anisotropic spacing, that is not aligned with the axes. */
+GridImageType::Pointer
+CreateGrid()
+{
+  const auto grid = GridImageType::New();
+  grid->SetRegions(GridImageType::SizeType{ { 6, 5, 4 } });
+
+  GridImageType::PointType origin;
+  origin[0] = -10.0;
+  origin[1] = 5.0;
+  origin[2] = 2.0;
+  grid->SetOrigin(origin);
+
+  GridImageType::SpacingType spacing;
+  spacing[0] = 4.0;
+  spacing[1] = 3.0;
+  spacing[2] = 5.0;
+  grid->SetSpacing(spacing);
+
+  GridImageType::DirectionType direction;
+  direction.SetIdentity();
+  direction(0, 0) = direction(1, 1) = std::cos(0.3);
+  direction(0, 1) = -std::sin(0.3);
+  direction(1, 0) = std::sin(0.3);
+  grid->SetDirection(direction);
+  return grid;
+}
+
+
+/** Expects that TransformPoint and GetJacobian with precomputed sub-transforms equal those without. */
+void
+ExpectPrecomputedEqualsExact(const bool normalizeWeights)
+{
+  const auto transform = CreateTransform(normalizeWeights);
+  const auto grid = CreateGrid();
+
+  /** Points at, between, and outside the grid nodes. */
+  std::vector<TransformType::InputPointType> points;
+  const double continuousIndices[][3] = { { 0.0, 0.0, 0.0 }, { 5.0, 4.0, 3.0 }, { 2.0, 1.0, 3.0 },
+                                          { 0.5, 0.5, 0.5 }, { 4.3, 0.1, 2.7 }, { 1.9, 3.6, 0.2 },
+                                          { -2.0, 1.0, 1.0 }, { 3.0, 7.5, 1.0 } };
+  for (const auto & continuousIndex : continuousIndices)
+  {
+    itk::ContinuousIndex<double, 3> index;
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+      index[d] = continuousIndex[d];
+    }
+    TransformType::InputPointType point;
+    grid->TransformContinuousIndexToPhysicalPoint(index, point);
+    points.push_back(point);
+  }
+
+  std::vector<TransformType::OutputPointType>            exactPoints;
+  std::vector<TransformType::JacobianType>               exactJacobians;
+  std::vector<TransformType::NonZeroJacobianIndicesType> exactIndices;
+  for (const auto & point : points)
+  {
+    exactPoints.push_back(transform->TransformPoint(point));
+    TransformType::JacobianType               jacobian;
+    TransformType::NonZeroJacobianIndicesType nonZeroJacobianIndices;
+    transform->GetJacobian(point, jacobian, nonZeroJacobianIndices);
+    exactJacobians.push_back(jacobian);
+    exactIndices.push_back(nonZeroJacobianIndices);
+  }
+
+  ASSERT_FALSE(transform->GetHasPrecomputedSubTransformDisplacements());
+  transform->PrecomputeSubTransformDisplacements(grid);
+  ASSERT_TRUE(transform->GetHasPrecomputedSubTransformDisplacements());
+
+  /** The displacements are stored in single precision. */
+  const double tolerance = 1e-4;
+  for (std::size_t p = 0; p < points.size(); ++p)
+  {
+    const auto outputPoint = transform->TransformPoint(points[p]);
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+      EXPECT_NEAR(outputPoint[d], exactPoints[p][d], tolerance) << "point " << p;
+    }
+
+    TransformType::JacobianType               jacobian;
+    TransformType::NonZeroJacobianIndicesType nonZeroJacobianIndices;
+    transform->GetJacobian(points[p], jacobian, nonZeroJacobianIndices);
+    EXPECT_EQ(nonZeroJacobianIndices, exactIndices[p]);
+    ASSERT_EQ(jacobian.rows(), exactJacobians[p].rows());
+    ASSERT_EQ(jacobian.cols(), exactJacobians[p].cols());
+    for (unsigned int i = 0; i < jacobian.rows(); ++i)
+    {
+      for (unsigned int j = 0; j < jacobian.cols(); ++j)
+      {
+        EXPECT_NEAR(jacobian(i, j), exactJacobians[p](i, j), tolerance) << "point " << p;
+      }
+    }
+  }
+
+  /** Clearing restores the exact path. */
+  transform->ClearPrecomputedSubTransformDisplacements();
+  EXPECT_FALSE(transform->GetHasPrecomputedSubTransformDisplacements());
+  EXPECT_EQ(transform->TransformPoint(points[3]), exactPoints[3]);
+}
+
+} // namespace
+
+
+GTEST_TEST(WeightedCombinationTransform, PrecomputedEqualsExact)
+{
+  ExpectPrecomputedEqualsExact(false);
+}
+
+
+GTEST_TEST(WeightedCombinationTransform, PrecomputedEqualsExactWithNormalizedWeights)
+{
+  ExpectPrecomputedEqualsExact(true);
+}
+
+
+GTEST_TEST(WeightedCombinationTransform, SetTransformContainerClearsPrecomputedDisplacements)
+{
+  const auto transform = CreateTransform(false);
+  transform->PrecomputeSubTransformDisplacements(CreateGrid());
+  ASSERT_TRUE(transform->GetHasPrecomputedSubTransformDisplacements());
+
+  transform->SetTransformContainer(transform->GetTransformContainer());
+  EXPECT_FALSE(transform->GetHasPrecomputedSubTransformDisplacements());
+}
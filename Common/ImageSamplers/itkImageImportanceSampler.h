@@ -0,0 +1,166 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageImportanceSampler_h
+#define itkImageImportanceSampler_h
+
+#include "itkImageRandomSamplerBase.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+namespace itk
+{
+/** \class ImageImportanceSampler
+ *
+ * \brief Samples randomly some voxels of an image, with a preference for informative voxels.
+ *
+ * The voxels of the InputImageRegion (within the mask, if given) are drawn with a
+ * probability proportional to a sampling density. By default this density is the
+ * gradient magnitude of the input image, so that few samples are spent in homogeneous
+ * regions, which hardly contribute to the metric derivative. Alternatively, a weight
+ * image can be supplied, which is interpolated at the voxel positions and therefore
+ * does not need to have the same grid as the input image.
+ *
+ * A fraction of the density, the UniformFraction, is spread uniformly over all voxels.
+ * This bounds the importance weights, and makes sure that every voxel can be drawn.
+ *
+ * The samples are drawn in constant time from an alias table, which is only rebuilt
+ * when the input image, weight image, mask, region, or UniformFraction changed, so
+ * typically once per resolution. Each sample gets the importance weight
+ * uniformDensity / samplingDensity, see GetSampleWeights(). The weights are scaled
+ * to a mean of 1 over the drawn samples, such that metrics that average over the
+ * samples can use them as they are.
+ *
+ * \ingroup ImageSamplers
+ */
+
+template <class TInputImage>
+class ITK_TEMPLATE_EXPORT ImageImportanceSampler : public ImageRandomSamplerBase<TInputImage>
+{
+public:
+  /** Standard ITK-stuff. */
+  using Self = ImageImportanceSampler;
+  using Superclass = ImageRandomSamplerBase<TInputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageImportanceSampler, ImageRandomSamplerBase);
+
+  /** Typedefs inherited from the superclass. */
+  using typename Superclass::DataObjectPointer;
+  using typename Superclass::OutputVectorContainerType;
+  using typename Superclass::OutputVectorContainerPointer;
+  using typename Superclass::InputImageType;
+  using typename Superclass::InputImagePointer;
+  using typename Superclass::InputImageConstPointer;
+  using typename Superclass::InputImageRegionType;
+  using typename Superclass::InputImagePixelType;
+  using typename Superclass::ImageSampleType;
+  using typename Superclass::ImageSampleValueType;
+  using typename Superclass::ImageSampleContainerType;
+  using typename Superclass::ImageSampleContainerPointer;
+  using typename Superclass::MaskType;
+  using typename Superclass::InputImageSizeType;
+
+  /** The input image dimension. */
+  itkStaticConstMacro(InputImageDimension, unsigned int, Superclass::InputImageDimension);
+
+  /** Other typedefs. */
+  using InputImageIndexType = typename InputImageType::IndexType;
+  using InputImagePointType = typename InputImageType::PointType;
+
+  /** The image that defines the sampling density, when not using the gradient magnitude. */
+  using WeightImageType = Image<float, Self::InputImageDimension>;
+  using WeightImagePointer = typename WeightImageType::Pointer;
+
+  /** The random number generator used to draw the samples. */
+  using RandomGeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+  using RandomGeneratorPointer = typename RandomGeneratorType::Pointer;
+
+  /** Set/Get the image that defines the sampling density. Negative values are treated as 0.
+   * If not set, the gradient magnitude of the input image is used. Default: nullptr. */
+  itkSetConstObjectMacro(WeightImage, WeightImageType);
+  itkGetConstObjectMacro(WeightImage, WeightImageType);
+
+  /** Set/Get the fraction of the sampling density that is spread uniformly over the voxels.
+   * 0 samples purely by the density, 1 samples uniformly. Default: 0.1. */
+  itkSetClampMacro(UniformFraction, double, 0.0, 1.0);
+  itkGetConstMacro(UniformFraction, double);
+
+protected:
+  /** The constructor. */
+  ImageImportanceSampler();
+  /** The destructor. */
+  ~ImageImportanceSampler() override = default;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Function that does the work. */
+  void
+  GenerateData() override;
+
+  /** Compute the sampling density of the voxels, and build the alias table from it. */
+  virtual void
+  BuildAliasTable();
+
+  /** Returns whether the alias table needs to be rebuilt. */
+  bool
+  AliasTableIsOutOfDate() const;
+
+  RandomGeneratorPointer m_RandomGenerator;
+
+private:
+  /** The deleted copy constructor. */
+  ImageImportanceSampler(const Self &) = delete;
+  /** The deleted assignment operator. */
+  void
+  operator=(const Self &) = delete;
+
+  typename WeightImageType::ConstPointer m_WeightImage{ nullptr };
+  double                                 m_UniformFraction{ 0.1 };
+
+  /** The alias table, see BuildAliasTable(). For each voxel with a nonzero density it contains
+   * the offset of the voxel in the cropped input image region, its importance weight, the
+   * probability of keeping the voxel when its table entry is drawn, and the alias voxel that is
+   * taken otherwise.
+   */
+  std::vector<SizeValueType> m_SupportOffsets;
+  std::vector<float>         m_SupportWeights;
+  std::vector<float>         m_AliasProbabilities;
+  std::vector<SizeValueType> m_AliasIndices;
+
+  /** The inputs from which the alias table was built. */
+  TimeStamp               m_AliasTableBuildTime;
+  const InputImageType *  m_AliasTableInput{ nullptr };
+  const WeightImageType * m_AliasTableWeightImage{ nullptr };
+  const MaskType *        m_AliasTableMask{ nullptr };
+  InputImageRegionType    m_AliasTableRegion;
+  double                  m_AliasTableUniformFraction{ 0.0 };
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkImageImportanceSampler.hxx"
+#endif
+
+#endif // end #ifndef itkImageImportanceSampler_h
@@ -0,0 +1,302 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageImportanceSampler_hxx
+#define itkImageImportanceSampler_hxx
+
+#include "itkImageImportanceSampler.h"
+
+#include "itkGradientMagnitudeImageFilter.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include <algorithm> // For max.
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template <class TInputImage>
+ImageImportanceSampler<TInputImage>::ImageImportanceSampler()
+{
+  /** Setup random generator. */
+  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
+
+} // end Constructor
+
+
+/**
+ * ******************* GenerateData *******************
+ */
+
+template <class TInputImage>
+void
+ImageImportanceSampler<TInputImage>::GenerateData()
+{
+  /** Get handles to the input image, output sample container, and mask. */
+  InputImageConstPointer          inputImage = this->GetInput();
+  ImageSampleContainerPointer     sampleContainer = this->GetOutput();
+  typename MaskType::ConstPointer mask = this->GetMask();
+
+  /** Update the mask. */
+  if (mask.IsNotNull() && mask->GetSource())
+  {
+    mask->GetSource()->Update();
+  }
+
+  /** Rebuild the alias table, if the sampling density changed. */
+  if (this->AliasTableIsOutOfDate())
+  {
+    this->BuildAliasTable();
+  }
+  const SizeValueType tableSize = this->m_SupportOffsets.size();
+  if (tableSize == 0)
+  {
+    itkExceptionMacro(<< "ERROR: the sampling density is zero everywhere. Probably the mask is empty.");
+  }
+
+  /** Reserve memory for the output and the weights. */
+  const unsigned long numberOfSamples = this->GetNumberOfSamples();
+  sampleContainer->Reserve(numberOfSamples);
+  this->m_SampleWeights.resize(numberOfSamples);
+
+  /** Setup an iterator over the output, which is of ImageSampleContainerType. */
+  typename ImageSampleContainerType::Iterator      iter;
+  typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
+
+  /** Draw the samples. */
+  const InputImageSizeType  regionSize = this->GetCroppedInputImageRegion().GetSize();
+  const InputImageIndexType regionIndex = this->GetCroppedInputImageRegion().GetIndex();
+  double                    sumOfWeights = 0.0;
+  for (iter = sampleContainer->Begin(); iter != end; ++iter)
+  {
+    /** Draw a table entry, and choose between the voxel of the entry and its alias. */
+    const SizeValueType entry = this->m_RandomGenerator->GetIntegerVariate(tableSize - 1);
+    const SizeValueType voxel = this->m_RandomGenerator->GetVariateWithOpenUpperRange() <
+                                    this->m_AliasProbabilities[entry]
+                                  ? entry
+                                  : this->m_AliasIndices[entry];
+
+    /** Translate the offset of the voxel to an index, copied from ImageRandomConstIteratorWithIndex. */
+    SizeValueType       position = this->m_SupportOffsets[voxel];
+    InputImageIndexType positionIndex;
+    for (unsigned int dim = 0; dim < InputImageDimension; ++dim)
+    {
+      const SizeValueType sizeInThisDimension = regionSize[dim];
+      const SizeValueType residual = position % sizeInThisDimension;
+      positionIndex[dim] = residual + regionIndex[dim];
+      position -= residual;
+      position /= sizeInThisDimension;
+    }
+
+    /** Put the coordinates, the value, and the importance weight in the sample. */
+    inputImage->TransformIndexToPhysicalPoint(positionIndex, (*iter).Value().m_ImageCoordinates);
+    (*iter).Value().m_ImageValue = static_cast<ImageSampleValueType>(inputImage->GetPixel(positionIndex));
+    this->m_SampleWeights[iter.Index()] = this->m_SupportWeights[voxel];
+    sumOfWeights += this->m_SupportWeights[voxel];
+
+  } // end for loop
+
+  /** Scale the weights to a mean of 1. */
+  const double weightScale = static_cast<double>(numberOfSamples) / sumOfWeights;
+  for (double & weight : this->m_SampleWeights)
+  {
+    weight *= weightScale;
+  }
+
+} // end GenerateData()
+
+
+/**
+ * ******************* AliasTableIsOutOfDate *******************
+ */
+
+template <class TInputImage>
+bool
+ImageImportanceSampler<TInputImage>::AliasTableIsOutOfDate() const
+{
+  const InputImageType *  inputImage = this->GetInput();
+  const WeightImageType * weightImage = this->m_WeightImage.GetPointer();
+  const MaskType *        mask = this->GetMask();
+  const ModifiedTimeType  buildTime = this->m_AliasTableBuildTime.GetMTime();
+
+  return this->m_SupportOffsets.empty() || inputImage != this->m_AliasTableInput ||
+         weightImage != this->m_AliasTableWeightImage || mask != this->m_AliasTableMask ||
+         this->GetCroppedInputImageRegion() != this->m_AliasTableRegion ||
+         this->m_UniformFraction != this->m_AliasTableUniformFraction || inputImage->GetMTime() > buildTime ||
+         (weightImage != nullptr && weightImage->GetMTime() > buildTime) ||
+         (mask != nullptr && mask->GetMTime() > buildTime);
+
+} // end AliasTableIsOutOfDate()
+
+
+/**
+ * ******************* BuildAliasTable *******************
+ */
+
+template <class TInputImage>
+void
+ImageImportanceSampler<TInputImage>::BuildAliasTable()
+{
+  /** Get handles to the input image and the mask. */
+  InputImageConstPointer          inputImage = this->GetInput();
+  typename MaskType::ConstPointer mask = this->GetMask();
+  const InputImageRegionType &    region = this->GetCroppedInputImageRegion();
+
+  /** The density is defined by the weight image, interpolated at the voxel positions,
+   * or else by the gradient magnitude of the input image.
+   */
+  using WeightInterpolatorType = LinearInterpolateImageFunction<WeightImageType, double>;
+  using GradientMagnitudeFilterType = GradientMagnitudeImageFilter<InputImageType, WeightImageType>;
+  typename WeightInterpolatorType::Pointer weightInterpolator;
+  typename WeightImageType::ConstPointer   gradientMagnitude;
+  if (this->m_WeightImage.IsNotNull())
+  {
+    weightInterpolator = WeightInterpolatorType::New();
+    weightInterpolator->SetInputImage(this->m_WeightImage);
+  }
+  else
+  {
+    auto gradientMagnitudeFilter = GradientMagnitudeFilterType::New();
+    gradientMagnitudeFilter->SetInput(inputImage);
+    gradientMagnitudeFilter->Update();
+    gradientMagnitude = gradientMagnitudeFilter->GetOutput();
+  }
+
+  /** Compute the density of all voxels of the region that are inside the mask. */
+  this->m_SupportOffsets.clear();
+  std::vector<double> densities;
+  double              sumOfDensities = 0.0;
+  SizeValueType       offset = 0;
+  InputImagePointType point;
+  for (ImageRegionConstIteratorWithIndex<InputImageType> it(inputImage, region); !it.IsAtEnd(); ++it, ++offset)
+  {
+    inputImage->TransformIndexToPhysicalPoint(it.GetIndex(), point);
+    if (mask.IsNotNull() && !mask->IsInsideInWorldSpace(point))
+    {
+      continue;
+    }
+
+    double density = 0.0;
+    if (weightInterpolator.IsNotNull())
+    {
+      if (weightInterpolator->IsInsideBuffer(point))
+      {
+        density = weightInterpolator->Evaluate(point);
+      }
+    }
+    else
+    {
+      density = gradientMagnitude->GetPixel(it.GetIndex());
+    }
+    density = std::max(density, 0.0);
+
+    this->m_SupportOffsets.push_back(offset);
+    densities.push_back(density);
+    sumOfDensities += density;
+  }
+
+  /** Mix the normalized density with the uniform density, see UniformFraction. Without any
+   * density, for example in a constant image, the voxels are sampled uniformly. Voxels
+   * that can not be drawn are removed from the table. The importance weight of a voxel is
+   * the ratio of the uniform density and its sampling density.
+   */
+  const SizeValueType numberOfVoxelsInMask = densities.size();
+  const double        uniformFraction = sumOfDensities > 0.0 ? this->m_UniformFraction : 1.0;
+  const double        uniformDensity = 1.0 / static_cast<double>(numberOfVoxelsInMask);
+  const double        densityScale = sumOfDensities > 0.0 ? (1.0 - uniformFraction) / sumOfDensities : 0.0;
+  SizeValueType       tableSize = 0;
+  this->m_SupportWeights.clear();
+  for (SizeValueType i = 0; i < numberOfVoxelsInMask; ++i)
+  {
+    const double density = densityScale * densities[i] + uniformFraction * uniformDensity;
+    if (density > 0.0)
+    {
+      this->m_SupportOffsets[tableSize] = this->m_SupportOffsets[i];
+      this->m_SupportWeights.push_back(static_cast<float>(uniformDensity / density));
+      densities[tableSize] = density;
+      ++tableSize;
+    }
+  }
+  this->m_SupportOffsets.resize(tableSize);
+  densities.resize(tableSize);
+
+  /** Build the alias table with Vose's method. The densities are scaled by the table size,
+   * so that each entry of the table holds a probability of 1, which is divided over the
+   * voxel of the entry and its alias.
+   */
+  this->m_AliasProbabilities.assign(tableSize, 1.0f);
+  this->m_AliasIndices.resize(tableSize);
+  std::vector<SizeValueType> smallEntries;
+  std::vector<SizeValueType> largeEntries;
+  for (SizeValueType i = 0; i < tableSize; ++i)
+  {
+    densities[i] *= static_cast<double>(tableSize);
+    this->m_AliasIndices[i] = i;
+    (densities[i] < 1.0 ? smallEntries : largeEntries).push_back(i);
+  }
+  while (!smallEntries.empty() && !largeEntries.empty())
+  {
+    const SizeValueType smallEntry = smallEntries.back();
+    const SizeValueType largeEntry = largeEntries.back();
+    smallEntries.pop_back();
+
+    this->m_AliasProbabilities[smallEntry] = static_cast<float>(densities[smallEntry]);
+    this->m_AliasIndices[smallEntry] = largeEntry;
+    densities[largeEntry] -= 1.0 - densities[smallEntry];
+    if (densities[largeEntry] < 1.0)
+    {
+      largeEntries.pop_back();
+      smallEntries.push_back(largeEntry);
+    }
+  }
+  /** The entries that are left keep their own voxel: their probability is 1 up to rounding errors. */
+
+  /** Store the inputs from which the table was built. */
+  this->m_AliasTableInput = inputImage.GetPointer();
+  this->m_AliasTableWeightImage = this->m_WeightImage.GetPointer();
+  this->m_AliasTableMask = mask.GetPointer();
+  this->m_AliasTableRegion = region;
+  this->m_AliasTableUniformFraction = this->m_UniformFraction;
+  this->m_AliasTableBuildTime.Modified();
+
+} // end BuildAliasTable()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template <class TInputImage>
+void
+ImageImportanceSampler<TInputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "WeightImage: " << this->m_WeightImage.GetPointer() << std::endl;
+  os << indent << "UniformFraction: " << this->m_UniformFraction << std::endl;
+  os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
+  os << indent << "AliasTableSize: " << this->m_SupportOffsets.size() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkImageImportanceSampler_hxx
@@ -21,6 +21,8 @@
 #include "itkImageRandomSamplerBase.h"
 #include "itkInterpolateImageFunction.h"
 #include "itkBSplineInterpolateImageFunction.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 
 namespace itk
@@ -81,6 +83,8 @@ public:
   using InterpolatorType = InterpolateImageFunction<InputImageType, CoordRepType>;
   using InterpolatorPointer = typename InterpolatorType::Pointer;
   using DefaultInterpolatorType = BSplineInterpolateImageFunction<InputImageType, CoordRepType, double>;
+  using LinearInterpolatorType = LinearInterpolateImageFunction<InputImageType, CoordRepType>;
+  using NearestNeighborInterpolatorType = NearestNeighborInterpolateImageFunction<InputImageType, CoordRepType>;
 
   /** The random number generator used to generate random coordinates. */
   using RandomGeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
@@ -90,6 +94,14 @@ public:
   itkSetObjectMacro(Interpolator, InterpolatorType);
   itkGetModifiableObjectMacro(Interpolator, InterpolatorType);
 
+  /** Select the interpolator by its B-spline order. Order 0 and 1 are served by a nearest neighbor
+   * and a linear interpolator, which do not need a B-spline coefficient image. Higher orders use the
+   * DefaultInterpolatorType. A B-spline interpolator that is already set is kept and only gets its
+   * order changed, so that its coefficients are not recomputed when neither order nor input changed.
+   */
+  virtual void
+  SetInterpolationOrder(unsigned int order);
+
   /** Set/Get the sample region size (in mm). Only needed when UseRandomSampleRegion==true;
    * default: filled with ones.  */
   itkSetMacro(SampleRegionSize, InputImageSpacingType);
@@ -123,6 +135,15 @@ protected:
   void
   ThreadedGenerateData(const InputImageRegionType & inputRegionForThread, ThreadIdType threadId) override;
 
+  /** Fill the samples of one thread, using the random numbers from randomNumberIndex onwards. The
+   * values are computed by the evaluator, which lets the nearest neighbor and linear interpolators be
+   * called without a virtual function call per sample. */
+  template <class TEvaluator>
+  void
+  FillThreaderSampleContainer(ImageSampleContainerType & sampleContainer,
+                              unsigned long              randomNumberIndex,
+                              const TEvaluator &         evaluator) const;
+
   /** Generate a point randomly in a bounding box. */
   virtual void
   GenerateRandomCoordinate(const InputImageContinuousIndexType & smallestContIndex,
@@ -20,6 +20,7 @@
 
 #include "itkImageRandomCoordinateSampler.h"
 #include <vnl/vnl_math.h>
+#include <typeinfo> // For typeid.
 
 namespace itk
 {
@@ -45,6 +46,19 @@ ImageRandomCoordinateSampler<TInputImage>::ImageRandomCoordinateSampler()
 } // end Constructor
 
 
+/**
+ * ******************* SetInterpolationOrder *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomCoordinateSampler<TInputImage>::SetInterpolationOrder(unsigned int order)
+{
+  Superclass::SetInterpolationOrderOfSampler(*this, order);
+
+} // end SetInterpolationOrder()
+
+
 /**
  * ******************* GenerateData *******************
  */
@@ -221,9 +235,6 @@ ImageRandomCoordinateSampler<TInputImage>::ThreadedGenerateData(const InputImage
     itkExceptionMacro(<< "ERROR: do not call this function when a mask is supplied.");
   }
 
-  /** Get handle to the input image. */
-  InputImageConstPointer inputImage = this->GetInput();
-
   /** Figure out which samples to process. */
   unsigned long chunkSize = this->GetNumberOfSamples() / this->GetNumberOfWorkUnits();
   unsigned long sampleStart = threadId * chunkSize * InputImageDimension;
@@ -237,14 +248,61 @@ ImageRandomCoordinateSampler<TInputImage>::ThreadedGenerateData(const InputImage
     = this->m_ThreaderSampleContainer[threadId];
   sampleContainerThisThread->Reserve(chunkSize);
 
-  /** Setup an iterator over the sampleContainerThisThread. */
+  /** Fill the local sample container. The exact type of the interpolator is checked once, so that
+   * the nearest neighbor and linear interpolators are called non-virtually inside the sample loop.
+   * Subclasses of these interpolators take the generic path, as they may override the evaluation.
+   */
+  const InterpolatorType & interpolator = *(this->m_Interpolator);
+  if (typeid(interpolator) == typeid(LinearInterpolatorType))
+  {
+    const auto & linearInterpolator = static_cast<const LinearInterpolatorType &>(interpolator);
+    this->FillThreaderSampleContainer(
+      *sampleContainerThisThread, sampleStart, [&linearInterpolator](const InputImageContinuousIndexType & cindex) {
+        return linearInterpolator.LinearInterpolatorType::EvaluateAtContinuousIndex(cindex);
+      });
+  }
+  else if (typeid(interpolator) == typeid(NearestNeighborInterpolatorType))
+  {
+    const auto & nearestNeighborInterpolator = static_cast<const NearestNeighborInterpolatorType &>(interpolator);
+    this->FillThreaderSampleContainer(
+      *sampleContainerThisThread,
+      sampleStart,
+      [&nearestNeighborInterpolator](const InputImageContinuousIndexType & cindex) {
+        return nearestNeighborInterpolator.NearestNeighborInterpolatorType::EvaluateAtContinuousIndex(cindex);
+      });
+  }
+  else
+  {
+    this->FillThreaderSampleContainer(
+      *sampleContainerThisThread, sampleStart, [&interpolator](const InputImageContinuousIndexType & cindex) {
+        return interpolator.EvaluateAtContinuousIndex(cindex);
+      });
+  }
+
+} // end ThreadedGenerateData()
+
+
+/**
+ * ******************* FillThreaderSampleContainer *******************
+ */
+
+template <class TInputImage>
+template <class TEvaluator>
+void
+ImageRandomCoordinateSampler<TInputImage>::FillThreaderSampleContainer(ImageSampleContainerType & sampleContainer,
+                                                                       unsigned long              randomNumberIndex,
+                                                                       const TEvaluator &         evaluator) const
+{
+  /** Get handle to the input image. */
+  const InputImageType & inputImage = *(this->GetInput());
+
+  /** Setup an iterator over the sample container. */
   typename ImageSampleContainerType::Iterator      iter;
-  typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
+  typename ImageSampleContainerType::ConstIterator end = sampleContainer.End();
 
-  /** Fill the local sample container. */
   InputImageContinuousIndexType sampleCIndex;
-  unsigned long                 sampleId = sampleStart;
-  for (iter = sampleContainerThisThread->Begin(); iter != end; ++iter)
+  unsigned long                 sampleId = randomNumberIndex;
+  for (iter = sampleContainer.Begin(); iter != end; ++iter)
   {
     /** Create a random point out of InputImageDimension random numbers. */
     for (unsigned int j = 0; j < InputImageDimension; ++j, sampleId++)
@@ -257,14 +315,14 @@ ImageRandomCoordinateSampler<TInputImage>::ThreadedGenerateData(const InputImage
     ImageSampleValueType & sampleValue = (*iter).Value().m_ImageValue;
 
     /** Convert to point */
-    inputImage->TransformContinuousIndexToPhysicalPoint(sampleCIndex, samplePoint);
+    inputImage.TransformContinuousIndexToPhysicalPoint(sampleCIndex, samplePoint);
 
     /** Compute the value at the contindex. */
-    sampleValue = static_cast<ImageSampleValueType>(this->m_Interpolator->EvaluateAtContinuousIndex(sampleCIndex));
+    sampleValue = static_cast<ImageSampleValueType>(evaluator(sampleCIndex));
 
   } // end for loop
 
-} // end ThreadedGenerateData()
+} // end FillThreaderSampleContainer()
 
 
 /**
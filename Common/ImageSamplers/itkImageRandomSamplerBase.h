@@ -80,6 +80,15 @@ protected:
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Select the interpolator of a sampler that samples on physical coordinates, by its B-spline
+   * order. Shared by the SetInterpolationOrder() of the random coordinate samplers. The sampler
+   * type must provide the NearestNeighborInterpolatorType, the LinearInterpolatorType and the
+   * DefaultInterpolatorType, which is a B-spline interpolator.
+   */
+  template <class TSampler>
+  static void
+  SetInterpolationOrderOfSampler(TSampler & sampler, const unsigned int order);
+
   /** Member variable used when threading. */
   std::vector<double> m_RandomNumberList;
 
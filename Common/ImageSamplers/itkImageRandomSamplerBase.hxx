@@ -71,6 +71,53 @@ ImageRandomSamplerBase<TInputImage>::BeforeThreadedGenerateData()
 } // end BeforeThreadedGenerateData()
 
 
+/**
+ * ******************* SetInterpolationOrderOfSampler *******************
+ */
+
+template <class TInputImage>
+template <class TSampler>
+void
+ImageRandomSamplerBase<TInputImage>::SetInterpolationOrderOfSampler(TSampler & sampler, const unsigned int order)
+{
+  using NearestNeighborInterpolatorType = typename TSampler::NearestNeighborInterpolatorType;
+  using LinearInterpolatorType = typename TSampler::LinearInterpolatorType;
+  using DefaultInterpolatorType = typename TSampler::DefaultInterpolatorType;
+
+  auto * const interpolator = sampler.GetModifiableInterpolator();
+  if (order == 0)
+  {
+    if (dynamic_cast<NearestNeighborInterpolatorType *>(interpolator) == nullptr)
+    {
+      sampler.SetInterpolator(NearestNeighborInterpolatorType::New());
+    }
+  }
+  else if (order == 1)
+  {
+    if (dynamic_cast<LinearInterpolatorType *>(interpolator) == nullptr)
+    {
+      sampler.SetInterpolator(LinearInterpolatorType::New());
+    }
+  }
+  else
+  {
+    auto * const bsplineInterpolator = dynamic_cast<DefaultInterpolatorType *>(interpolator);
+    if (bsplineInterpolator == nullptr)
+    {
+      auto newBSplineInterpolator = DefaultInterpolatorType::New();
+      newBSplineInterpolator->SetSplineOrder(order);
+      sampler.SetInterpolator(newBSplineInterpolator);
+    }
+    else if (bsplineInterpolator->GetSplineOrder() != order)
+    {
+      bsplineInterpolator->SetSplineOrder(order);
+      sampler.Modified();
+    }
+  }
+
+} // end SetInterpolationOrderOfSampler()
+
+
 /**
  * ******************* PrintSelf *******************
  */
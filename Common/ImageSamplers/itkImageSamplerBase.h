@@ -176,6 +176,11 @@ public:
   itkSetClampMacro(NumberOfSamples, unsigned long, 1, NumericTraits<unsigned long>::max());
   itkGetConstMacro(NumberOfSamples, unsigned long);
 
+  /** Get the importance weights of the samples in the output, in the same order as the samples.
+   * Samplers that draw their samples uniformly leave it empty, meaning that all weights are 1.
+   */
+  itkGetConstReferenceMacro(SampleWeights, std::vector<double>);
+
   /** \todo: Temporary, should think about interface. */
   itkSetMacro(UseMultiThread, bool);
 
@@ -222,6 +227,7 @@ protected:
   /***/
   unsigned long                            m_NumberOfSamples;
   std::vector<ImageSampleContainerPointer> m_ThreaderSampleContainer;
+  std::vector<double>                      m_SampleWeights;
 
   // tmp?
   bool m_UseMultiThread;
@@ -20,6 +20,7 @@
 
 #include "itkMultiInputImageRandomCoordinateSampler.h"
 #include <vnl/vnl_inverse.h>
+#include <vector>
 #include "itkConfigure.h"
 
 namespace itk
@@ -46,6 +47,19 @@ MultiInputImageRandomCoordinateSampler<TInputImage>::MultiInputImageRandomCoordi
 } // end Constructor()
 
 
+/**
+ * ******************* SetInterpolationOrder *******************
+ */
+
+template <class TInputImage>
+void
+MultiInputImageRandomCoordinateSampler<TInputImage>::SetInterpolationOrder(unsigned int order)
+{
+  Superclass::SetInterpolationOrderOfSampler(*this, order);
+
+} // end SetInterpolationOrder()
+
+
 /**
  * ******************* GenerateData *******************
  */
@@ -82,7 +96,11 @@ MultiInputImageRandomCoordinateSampler<TInputImage>::GenerateData()
   typename ImageSampleContainerType::Iterator      iter;
   typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
 
-  InputImageContinuousIndexType sampleContIndex;
+  /** The random coordinates are generated sequentially, so that they do not depend on
+   * the number of threads. The values at these coordinates are interpolated afterwards.
+   */
+  std::vector<InputImageContinuousIndexType> sampleContIndices(this->GetNumberOfSamples());
+
   /** Fill the sample container. */
   if (mask.IsNull())
   {
@@ -90,8 +108,8 @@ MultiInputImageRandomCoordinateSampler<TInputImage>::GenerateData()
     for (iter = sampleContainer->Begin(); iter != end; ++iter)
     {
       /** Make a reference to the current sample in the container. */
-      InputImagePointType &  samplePoint = (*iter).Value().m_ImageCoordinates;
-      ImageSampleValueType & sampleValue = (*iter).Value().m_ImageValue;
+      InputImagePointType &           samplePoint = (*iter).Value().m_ImageCoordinates;
+      InputImageContinuousIndexType & sampleContIndex = sampleContIndices[iter.Index()];
 
       /** Generate a point in the input image region. */
       this->GenerateRandomCoordinate(smallestContIndex, largestContIndex, sampleContIndex);
@@ -99,9 +117,6 @@ MultiInputImageRandomCoordinateSampler<TInputImage>::GenerateData()
       /** Convert to point */
       inputImage->TransformContinuousIndexToPhysicalPoint(sampleContIndex, samplePoint);
 
-      /** Compute the value at the contindex. */
-      sampleValue = static_cast<ImageSampleValueType>(this->m_Interpolator->EvaluateAtContinuousIndex(sampleContIndex));
-
     } // end for loop
   }   // end if no mask
   else
@@ -119,8 +134,8 @@ MultiInputImageRandomCoordinateSampler<TInputImage>::GenerateData()
     for (iter = sampleContainer->Begin(); iter != end; ++iter)
     {
       /** Make a reference to the current sample in the container. */
-      InputImagePointType &  samplePoint = (*iter).Value().m_ImageCoordinates;
-      ImageSampleValueType & sampleValue = (*iter).Value().m_ImageValue;
+      InputImagePointType &           samplePoint = (*iter).Value().m_ImageCoordinates;
+      InputImageContinuousIndexType & sampleContIndex = sampleContIndices[iter.Index()];
 
       /** Walk over the image until we find a valid point. */
       do
@@ -143,12 +158,21 @@ MultiInputImageRandomCoordinateSampler<TInputImage>::GenerateData()
         inputImage->TransformContinuousIndexToPhysicalPoint(sampleContIndex, samplePoint);
       } while (!this->IsInsideAllMasks(samplePoint));
 
-      /** Compute the value at the contindex. */
-      sampleValue = static_cast<ImageSampleValueType>(this->m_Interpolator->EvaluateAtContinuousIndex(sampleContIndex));
-
     } // end for loop
   }   // end if mask
 
+  /** Compute the values at the continuous indices, multi-threaded. */
+  const InterpolatorType & sampleInterpolator = *(this->m_Interpolator);
+  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+  this->GetMultiThreader()->ParallelizeArray(
+    0,
+    sampleContainer->Size(),
+    [&sampleContainer, &sampleContIndices, &sampleInterpolator](const SizeValueType i) {
+      sampleContainer->ElementAt(i).m_ImageValue =
+        static_cast<ImageSampleValueType>(sampleInterpolator.EvaluateAtContinuousIndex(sampleContIndices[i]));
+    },
+    nullptr);
+
 } // end GenerateData()
 
 
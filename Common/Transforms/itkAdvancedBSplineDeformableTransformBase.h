@@ -22,6 +22,8 @@
 #include "itkImage.h"
 #include "itkImageRegion.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -218,6 +220,24 @@ public:
   virtual void
   SetCoefficientImages(ImagePointer images[]);
 
+  /** Set/Get whether an interleaved copy of the coefficients is maintained.
+   *
+   * When enabled, the coefficients are additionally stored as one packed
+   * array with the SpaceDimension coefficients of each control point next
+   * to each other ( x0 y0 z0 x1 y1 z1 ... ). This mirror is refreshed by
+   * SetParameters(), SetParametersByValue(), SetCoefficientImages() and
+   * SetIdentity(), and is used by derived classes for point evaluation,
+   * since it touches far fewer cache lines than reading from SpaceDimension
+   * separate coefficient images. Note that, as the parameters are not copied
+   * by SetParameters(), changing them in-place requires another call to
+   * SetParameters() to keep the mirror up-to-date. Default: false.
+   */
+  virtual void
+  SetUseInterleavedCoefficients(const bool arg);
+
+  itkGetConstMacro(UseInterleavedCoefficients, bool);
+  itkBooleanMacro(UseInterleavedCoefficients);
+
   /** Typedefs for specifying the extend to the grid. */
   using RegionType = ImageRegion<Self::SpaceDimension>;
 
@@ -356,6 +376,12 @@ protected:
   virtual bool
   InsideValidRegion(const ContinuousIndexType & index) const;
 
+  /** Copy the coefficient images into m_InterleavedCoefficients,
+   * in case UseInterleavedCoefficients is true.
+   */
+  void
+  UpdateInterleavedCoefficients();
+
 private:
   const unsigned m_SplineOrder;
 
@@ -409,6 +435,12 @@ protected:
   /** Internal parameters buffer. */
   ParametersType m_InternalParametersBuffer;
 
+  /** Packed copy of the coefficients: for each control point the
+   * SpaceDimension coefficients are stored contiguously.
+   */
+  bool                   m_UseInterleavedCoefficients{ false };
+  std::vector<PixelType> m_InterleavedCoefficients;
+
   void
   UpdateGridOffsetTable();
 
@@ -242,6 +242,7 @@ AdvancedBSplineDeformableTransformBase<TScalarType, NDimensions>::SetIdentity()
   {
     ParametersType * parameters = const_cast<ParametersType *>(this->m_InputParametersPointer);
     parameters->Fill(0.0);
+    this->UpdateInterleavedCoefficients();
     this->Modified();
   }
   else
@@ -387,9 +388,55 @@ AdvancedBSplineDeformableTransformBase<TScalarType, NDimensions>::WrapAsImages()
     dataPointer += numberOfPixels;
     this->m_CoefficientImages[j] = this->m_WrappedImage[j];
   }
+
+  this->UpdateInterleavedCoefficients();
 }
 
 
+// Set whether to maintain an interleaved copy of the coefficients
+template <class TScalarType, unsigned int NDimensions>
+void
+AdvancedBSplineDeformableTransformBase<TScalarType, NDimensions>::SetUseInterleavedCoefficients(const bool arg)
+{
+  if (this->m_UseInterleavedCoefficients != arg)
+  {
+    this->m_UseInterleavedCoefficients = arg;
+    this->UpdateInterleavedCoefficients();
+    this->Modified();
+  }
+}
+
+
+// Copy the coefficient images into the interleaved buffer
+template <class TScalarType, unsigned int NDimensions>
+void
+AdvancedBSplineDeformableTransformBase<TScalarType, NDimensions>::UpdateInterleavedCoefficients()
+{
+  if (!this->m_UseInterleavedCoefficients || !this->m_CoefficientImages[0])
+  {
+    /** Release the memory, so that the derived classes fall back to the
+     * separate coefficient images.
+     */
+    std::vector<PixelType>().swap(this->m_InterleavedCoefficients);
+    return;
+  }
+
+  const SizeValueType numberOfPixels = this->m_CoefficientImages[0]->GetBufferedRegion().GetNumberOfPixels();
+  this->m_InterleavedCoefficients.resize(numberOfPixels * SpaceDimension);
+
+  PixelType * interleaved = this->m_InterleavedCoefficients.data();
+  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  {
+    const PixelType * coefficients = this->m_CoefficientImages[j]->GetBufferPointer();
+    for (SizeValueType i = 0; i < numberOfPixels; ++i)
+    {
+      interleaved[i * SpaceDimension + j] = coefficients[i];
+    }
+  }
+
+} // end UpdateInterleavedCoefficients()
+
+
 // Set the parameters by value
 template <class TScalarType, unsigned int NDimensions>
 void
@@ -486,6 +533,8 @@ AdvancedBSplineDeformableTransformBase<TScalarType, NDimensions>::SetCoefficient
     // Clean up buffered parameters
     this->m_InternalParametersBuffer = ParametersType(0);
     this->m_InputParametersPointer = nullptr;
+
+    this->UpdateInterleavedCoefficients();
   }
 }
 
@@ -523,6 +572,7 @@ AdvancedBSplineDeformableTransformBase<TScalarType, NDimensions>::PrintSelf(std:
   os << " ]" << std::endl;
 
   os << indent << "InputParametersPointer: " << this->m_InputParametersPointer << std::endl;
+  os << indent << "UseInterleavedCoefficients: " << this->m_UseInterleavedCoefficients << std::endl;
   os << indent << "ValidRegion: " << this->m_ValidRegion << std::endl;
   os << indent << "LastJacobianIndex: " << this->m_LastJacobianIndex << std::endl;
 }
@@ -31,6 +31,7 @@
 #include <vnl/vnl_diag_matrix.h>
 
 #include "itkPlatformMultiThreader.h"
+#include "itkImageStatisticsCache.h"
 
 #include <vector>
 
@@ -59,6 +60,10 @@ namespace itk
  * computing the moments and doing so simplifies memory management for
  * the caller.
  *
+ * When UseCache is enabled, the moments are stored in the
+ * ImageStatisticsCache, and a later Compute() with the same image, mask,
+ * and settings takes them from the cache.
+ *
  * \ingroup Operators
  *
  * \todo It's not yet clear how multi-echo images should be handled here.
@@ -250,6 +255,26 @@ public:
   itkSetMacro(LowerThresholdForCenterGravity, InputPixelType);
   itkSetMacro(CenterOfGravityUsesLowerThreshold, bool);
 
+  /** Set/Get whether the moments are looked up in, and stored in, the
+   * ImageStatisticsCache. Default: false.
+   */
+  itkSetMacro(UseCache, bool);
+  itkGetConstMacro(UseCache, bool);
+  itkBooleanMacro(UseCache);
+
+  /** The moments that are stored in the ImageStatisticsCache. */
+  struct CachedMomentsType
+  {
+    ScalarType m_M0;
+    VectorType m_M1;
+    MatrixType m_M2;
+    VectorType m_Cg;
+    MatrixType m_Cm;
+    VectorType m_Pm;
+    MatrixType m_Pa;
+  };
+  using MomentsCacheType = ImageStatisticsCache<CachedMomentsType>;
+
 protected:
   AdvancedImageMomentsCalculator();
   ~AdvancedImageMomentsCalculator() override = default;
@@ -320,6 +345,7 @@ private:
   InputPixelType              m_LowerThresholdForCenterGravity;
   bool                        m_CenterOfGravityUsesLowerThreshold;
   ImageSampleContainerPointer m_SampleContainer;
+  bool                        m_UseCache{ false };
 
   bool       m_Valid; // Have moments been computed yet?
   ScalarType m_M0;    // Zeroth moment
@@ -23,6 +23,7 @@
 #include <vnl/algo/vnl_real_eigensystem.h>
 #include <vnl/algo/vnl_symmetric_eigensystem.h>
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageMaskSpatialObject.h"
 
 namespace itk
 {
@@ -157,23 +158,70 @@ template <typename TImage>
 void
 AdvancedImageMomentsCalculator<TImage>::Compute()
 {
+  /** Take the moments from the cache, when they have been computed before
+   * for the same image, mask, and settings.
+   */
+  typename MomentsCacheType::KeyType key;
+  const bool                         useCache = this->m_UseCache && this->m_Image.IsNotNull();
+  if (useCache)
+  {
+    /** An image mask is identified by its image, as the spatial object is often recreated. */
+    using ImageMaskSpatialObjectType = ImageMaskSpatialObject<Self::ImageDimension>;
+    const Object * mask = this->m_SpatialObjectMask.GetPointer();
+    const auto     imageMask = dynamic_cast<const ImageMaskSpatialObjectType *>(mask);
+    if (imageMask != nullptr)
+    {
+      mask = imageMask->GetImage();
+    }
+
+    key = MomentsCacheType::MakeKey(this->m_Image.GetPointer(),
+                                    this->m_Image->GetRequestedRegion(),
+                                    mask,
+                                    { static_cast<double>(this->m_UseMultiThread),
+                                      static_cast<double>(this->m_NumberOfSamplesForCenteredTransformInitialization),
+                                      static_cast<double>(this->m_CenterOfGravityUsesLowerThreshold),
+                                      static_cast<double>(this->m_LowerThresholdForCenterGravity) });
+
+    CachedMomentsType moments;
+    if (MomentsCacheType::GetInstance().Find(key, moments))
+    {
+      this->m_M0 = moments.m_M0;
+      this->m_M1 = moments.m_M1;
+      this->m_M2 = moments.m_M2;
+      this->m_Cg = moments.m_Cg;
+      this->m_Cm = moments.m_Cm;
+      this->m_Pm = moments.m_Pm;
+      this->m_Pa = moments.m_Pa;
+      this->m_Valid = true;
+      return;
+    }
+  }
+
   /** Option for now to still use the single threaded code. */
   if (!this->m_UseMultiThread)
   {
-    return this->ComputeSingleThreaded();
+    this->ComputeSingleThreaded();
   }
+  else
+  {
+    /** Initialize multi-threading. */
+    this->InitializeThreadingParameters();
 
-  /** Initialize multi-threading. */
-  this->InitializeThreadingParameters();
+    /** Tackle stuff needed before multi-threading. */
+    this->BeforeThreadedCompute();
 
-  /** Tackle stuff needed before multi-threading. */
-  this->BeforeThreadedCompute();
+    /** Launch multi-threaded computation. */
+    this->LaunchComputeThreaderCallback();
 
-  /** Launch multi-threaded computation. */
-  this->LaunchComputeThreaderCallback();
+    /** Gather the values from all threads. */
+    this->AfterThreadedCompute();
+  }
 
-  /** Gather the values from all threads. */
-  this->AfterThreadedCompute();
+  if (useCache && this->m_Valid)
+  {
+    MomentsCacheType::GetInstance().Insert(
+      key, { this->m_M0, this->m_M1, this->m_M2, this->m_Cg, this->m_Cm, this->m_Pm, this->m_Pa });
+  }
 
 } // end Compute()
 
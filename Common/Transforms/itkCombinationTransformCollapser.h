@@ -0,0 +1,201 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkCombinationTransformCollapser_h
+#define itkCombinationTransformCollapser_h
+
+#include "itkObject.h"
+#include "itkAdvancedCombinationTransform.h"
+#include "itkAdvancedMatrixOffsetTransformBase.h"
+#include "itkImage.h"
+#include "itkVector.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * \class CombinationTransformCollapser
+ * \brief Collapses a chain of composed transforms into an equivalent, cheaper transform.
+ *
+ * An AdvancedCombinationTransform evaluates a chain of initial transforms
+ * recursively, with one virtual call chain per transform per point. This class
+ * flattens such a chain (following the initial transforms as long as they are
+ * combined by composition), and rebuilds it such that consecutive
+ * matrix-offset transforms are multiplied into a single affine transform.
+ *
+ * Optionally, a chain that contains deformable parts can be baked into a
+ * single displacement field, sampled on a user-specified grid. In that case the
+ * collapsed transform is only an approximation of the original chain; the
+ * mean and maximum approximation error are estimated from random points
+ * within the output grid, and can be retrieved after Update().
+ *
+ * The original transforms are not modified; the collapsed transform shares
+ * the non-linear sub-transforms with the original chain.
+ *
+ * \ingroup Transforms
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+class ITK_TEMPLATE_EXPORT CombinationTransformCollapser : public Object
+{
+public:
+  /** Standard class typedefs. */
+  using Self = CombinationTransformCollapser;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(CombinationTransformCollapser, Object);
+
+  /** Dimension of the domain space. */
+  itkStaticConstMacro(SpaceDimension, unsigned int, NDimensions);
+
+  /** Typedefs of the transforms. */
+  using CombinationTransformType = AdvancedCombinationTransform<TScalarType, NDimensions>;
+  using AdvancedTransformType = typename CombinationTransformType::InitialTransformType;
+  using AdvancedTransformConstPointer = typename AdvancedTransformType::ConstPointer;
+  using MatrixOffsetTransformType = AdvancedMatrixOffsetTransformBase<TScalarType, NDimensions, NDimensions>;
+  using TransformType = Transform<TScalarType, NDimensions, NDimensions>;
+  using TransformPointer = typename TransformType::Pointer;
+  using TransformConstPointer = typename TransformType::ConstPointer;
+  using InputPointType = typename TransformType::InputPointType;
+
+  /** Typedefs of the displacement field, used when baking the chain. */
+  using DisplacementFieldType = Image<Vector<TScalarType, NDimensions>, NDimensions>;
+  using OriginType = typename DisplacementFieldType::PointType;
+  using SpacingType = typename DisplacementFieldType::SpacingType;
+  using DirectionType = typename DisplacementFieldType::DirectionType;
+  using SizeType = typename DisplacementFieldType::SizeType;
+  using IndexType = typename DisplacementFieldType::IndexType;
+
+  /** Set/Get the transform chain that is to be collapsed. */
+  itkSetConstObjectMacro(Transform, TransformType);
+  itkGetConstObjectMacro(Transform, TransformType);
+
+  /** Set/Get whether chains with deformable parts are baked into a displacement field.
+   * Default: false, i.e. only the matrix-offset transforms are merged.
+   */
+  itkSetMacro(BakeDeformableTransforms, bool);
+  itkGetConstMacro(BakeDeformableTransforms, bool);
+  itkBooleanMacro(BakeDeformableTransforms);
+
+  /** Set/Get the output grid, on which the displacement field is sampled.
+   * The grid is also used to estimate the approximation error.
+   */
+  itkSetMacro(OutputOrigin, OriginType);
+  itkGetConstReferenceMacro(OutputOrigin, OriginType);
+  itkSetMacro(OutputSpacing, SpacingType);
+  itkGetConstReferenceMacro(OutputSpacing, SpacingType);
+  itkSetMacro(OutputDirection, DirectionType);
+  itkGetConstReferenceMacro(OutputDirection, DirectionType);
+  itkSetMacro(OutputSize, SizeType);
+  itkGetConstReferenceMacro(OutputSize, SizeType);
+  itkSetMacro(OutputStartIndex, IndexType);
+  itkGetConstReferenceMacro(OutputStartIndex, IndexType);
+
+  /** Set/Get the number of random points used to estimate the approximation error. Default: 10000. */
+  itkSetMacro(NumberOfErrorSamples, SizeValueType);
+  itkGetConstMacro(NumberOfErrorSamples, SizeValueType);
+
+  /** Collapse the chain. */
+  virtual void
+  Update();
+
+  /** Get the collapsed transform. Only valid after Update(). */
+  itkGetModifiableObjectMacro(CollapsedTransform, TransformType);
+
+  /** Get the number of transforms in the chain before and after collapsing. */
+  itkGetConstMacro(NumberOfTransformsBefore, SizeValueType);
+  itkGetConstMacro(NumberOfTransformsAfter, SizeValueType);
+
+  /** Returns true when the chain was baked into a displacement field. */
+  itkGetConstMacro(IsBaked, bool);
+
+  /** Get the estimated mean and maximum distance between the points mapped
+   * by the original chain and by the collapsed transform.
+   */
+  itkGetConstMacro(MeanError, double);
+  itkGetConstMacro(MaximumError, double);
+
+protected:
+  CombinationTransformCollapser();
+  ~CombinationTransformCollapser() override = default;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  using TransformChainType = std::vector<AdvancedTransformConstPointer>;
+
+  /** Append the leaf transforms of a (nested) composition to the chain,
+   * in the order in which they are applied to a point.
+   */
+  static void
+  FlattenTransformChain(const AdvancedTransformType * transform, TransformChainType & chain);
+
+  /** Merge consecutive matrix-offset transforms of the chain. */
+  static TransformChainType
+  MergeLinearTransforms(const TransformChainType & chain);
+
+  /** Build a (nested) combination transform that applies the chain. */
+  static TransformPointer
+  ComposeTransformChain(const TransformChainType & chain);
+
+  /** Sample the original transform into a displacement field transform. */
+  TransformPointer
+  BakeIntoDisplacementField() const;
+
+  /** Estimate the mean and maximum approximation error. */
+  void
+  ComputeApproximationError();
+
+private:
+  CombinationTransformCollapser(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  TransformConstPointer m_Transform;
+  TransformPointer      m_CollapsedTransform;
+
+  bool          m_BakeDeformableTransforms{ false };
+  OriginType    m_OutputOrigin{};
+  SpacingType   m_OutputSpacing{ 1.0 };
+  DirectionType m_OutputDirection{ DirectionType::GetIdentity() };
+  SizeType      m_OutputSize{};
+  IndexType     m_OutputStartIndex{};
+  SizeValueType m_NumberOfErrorSamples{ 10000 };
+
+  SizeValueType m_NumberOfTransformsBefore{ 0 };
+  SizeValueType m_NumberOfTransformsAfter{ 0 };
+  bool          m_IsBaked{ false };
+  double        m_MeanError{ 0.0 };
+  double        m_MaximumError{ 0.0 };
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkCombinationTransformCollapser.hxx"
+#endif
+
+#endif // end #ifndef itkCombinationTransformCollapser_h
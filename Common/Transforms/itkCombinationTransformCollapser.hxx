@@ -0,0 +1,331 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkCombinationTransformCollapser_hxx
+#define itkCombinationTransformCollapser_hxx
+
+#include "itkCombinationTransformCollapser.h"
+
+#include "itkDisplacementFieldTransform.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTransformToDisplacementFieldFilter.h"
+
+#include <algorithm> // For max.
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+CombinationTransformCollapser<TScalarType, NDimensions>::CombinationTransformCollapser() = default;
+
+
+/**
+ * ********************* FlattenTransformChain ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+CombinationTransformCollapser<TScalarType, NDimensions>::FlattenTransformChain(const AdvancedTransformType * transform,
+                                                                              TransformChainType &          chain)
+{
+  /** Only compositions can be flattened. A combination that uses addition,
+   * or that has no current transform, is kept as a single link of the chain.
+   */
+  const auto combination = dynamic_cast<const CombinationTransformType *>(transform);
+  if (combination != nullptr && combination->GetCurrentTransform() != nullptr &&
+      (combination->GetUseComposition() || combination->GetInitialTransform() == nullptr))
+  {
+    if (combination->GetInitialTransform() != nullptr)
+    {
+      FlattenTransformChain(combination->GetInitialTransform(), chain);
+    }
+    FlattenTransformChain(combination->GetCurrentTransform(), chain);
+    return;
+  }
+
+  chain.push_back(transform);
+
+} // end FlattenTransformChain()
+
+
+/**
+ * ********************* MergeLinearTransforms ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+auto
+CombinationTransformCollapser<TScalarType, NDimensions>::MergeLinearTransforms(const TransformChainType & chain)
+  -> TransformChainType
+{
+  using MatrixType = typename MatrixOffsetTransformType::MatrixType;
+  using OffsetType = typename MatrixOffsetTransformType::OutputVectorType;
+
+  TransformChainType mergedChain;
+
+  /** The accumulated matrix and offset of the current run of linear transforms. */
+  MatrixType                    matrix;
+  OffsetType                    offset;
+  AdvancedTransformConstPointer firstOfRun;
+  SizeValueType                 lengthOfRun = 0;
+
+  const auto flushRun = [&]() {
+    if (lengthOfRun == 1)
+    {
+      /** Nothing to merge, keep the original transform. */
+      mergedChain.push_back(firstOfRun);
+    }
+    else if (lengthOfRun > 1)
+    {
+      const auto merged = MatrixOffsetTransformType::New();
+      merged->SetMatrix(matrix);
+      merged->SetTranslation(offset); // the center is zero, so the translation equals the offset
+      mergedChain.push_back(merged.GetPointer());
+    }
+    lengthOfRun = 0;
+  };
+
+  for (const auto & transform : chain)
+  {
+    const auto linear = dynamic_cast<const MatrixOffsetTransformType *>(transform.GetPointer());
+    if (linear == nullptr)
+    {
+      flushRun();
+      mergedChain.push_back(transform);
+      continue;
+    }
+
+    if (lengthOfRun == 0)
+    {
+      matrix = linear->GetMatrix();
+      offset = linear->GetOffset();
+      firstOfRun = transform;
+    }
+    else
+    {
+      /** T2( T1( x ) ) = A2 ( A1 x + b1 ) + b2 = ( A2 A1 ) x + ( A2 b1 + b2 ). */
+      offset = linear->GetMatrix() * offset + linear->GetOffset();
+      matrix = linear->GetMatrix() * matrix;
+    }
+    ++lengthOfRun;
+  }
+  flushRun();
+
+  return mergedChain;
+
+} // end MergeLinearTransforms()
+
+
+/**
+ * ********************* ComposeTransformChain ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+auto
+CombinationTransformCollapser<TScalarType, NDimensions>::ComposeTransformChain(const TransformChainType & chain)
+  -> TransformPointer
+{
+  /** The combination transforms require non-const sub-transforms,
+   * but they never modify them.
+   */
+  typename AdvancedTransformType::Pointer composed = const_cast<AdvancedTransformType *>(chain.front().GetPointer());
+  for (std::size_t i = 1; i < chain.size(); ++i)
+  {
+    const auto combination = CombinationTransformType::New();
+    combination->SetUseComposition(true);
+    combination->SetInitialTransform(composed);
+    combination->SetCurrentTransform(const_cast<AdvancedTransformType *>(chain[i].GetPointer()));
+    composed = combination.GetPointer();
+  }
+
+  return composed.GetPointer();
+
+} // end ComposeTransformChain()
+
+
+/**
+ * ********************* BakeIntoDisplacementField ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+auto
+CombinationTransformCollapser<TScalarType, NDimensions>::BakeIntoDisplacementField() const -> TransformPointer
+{
+  using FieldGeneratorType = TransformToDisplacementFieldFilter<DisplacementFieldType, TScalarType>;
+  using DisplacementFieldTransformType = DisplacementFieldTransform<TScalarType, NDimensions>;
+
+  const auto fieldGenerator = FieldGeneratorType::New();
+  fieldGenerator->SetSize(this->m_OutputSize);
+  fieldGenerator->SetOutputStartIndex(this->m_OutputStartIndex);
+  fieldGenerator->SetOutputOrigin(this->m_OutputOrigin);
+  fieldGenerator->SetOutputSpacing(this->m_OutputSpacing);
+  fieldGenerator->SetOutputDirection(this->m_OutputDirection);
+  fieldGenerator->SetTransform(this->m_Transform);
+  fieldGenerator->Update();
+
+  const auto displacementFieldTransform = DisplacementFieldTransformType::New();
+  displacementFieldTransform->SetDisplacementField(fieldGenerator->GetOutput());
+
+  return displacementFieldTransform.GetPointer();
+
+} // end BakeIntoDisplacementField()
+
+
+/**
+ * ********************* ComputeApproximationError ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+CombinationTransformCollapser<TScalarType, NDimensions>::ComputeApproximationError()
+{
+  this->m_MeanError = 0.0;
+  this->m_MaximumError = 0.0;
+
+  SizeValueType numberOfGridPoints = 1;
+  for (unsigned int d = 0; d < SpaceDimension; ++d)
+  {
+    numberOfGridPoints *= this->m_OutputSize[d];
+  }
+  if (numberOfGridPoints == 0 || this->m_NumberOfErrorSamples == 0)
+  {
+    return;
+  }
+
+  /** Use a fixed seed, so that the reported error is reproducible. */
+  using RandomGeneratorType = Statistics::MersenneTwisterRandomVariateGenerator;
+  const auto randomGenerator = RandomGeneratorType::New();
+  randomGenerator->Initialize(121212);
+
+  const auto indexToPoint = this->m_OutputDirection.GetVnlMatrix();
+  double     sumError = 0.0;
+  for (SizeValueType i = 0; i < this->m_NumberOfErrorSamples; ++i)
+  {
+    /** Draw a random point within the output grid. */
+    InputPointType point;
+    double         scaledIndex[SpaceDimension];
+    for (unsigned int d = 0; d < SpaceDimension; ++d)
+    {
+      const double maximum = static_cast<double>(this->m_OutputSize[d]) - 1.0;
+      scaledIndex[d] = (this->m_OutputStartIndex[d] + randomGenerator->GetUniformVariate(0.0, maximum)) *
+                       this->m_OutputSpacing[d];
+    }
+    for (unsigned int r = 0; r < SpaceDimension; ++r)
+    {
+      point[r] = this->m_OutputOrigin[r];
+      for (unsigned int c = 0; c < SpaceDimension; ++c)
+      {
+        point[r] += indexToPoint(r, c) * scaledIndex[c];
+      }
+    }
+
+    const double error =
+      this->m_Transform->TransformPoint(point).EuclideanDistanceTo(this->m_CollapsedTransform->TransformPoint(point));
+    sumError += error;
+    this->m_MaximumError = std::max(this->m_MaximumError, error);
+  }
+  this->m_MeanError = sumError / static_cast<double>(this->m_NumberOfErrorSamples);
+
+} // end ComputeApproximationError()
+
+
+/**
+ * ********************* Update ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+CombinationTransformCollapser<TScalarType, NDimensions>::Update()
+{
+  if (this->m_Transform.IsNull())
+  {
+    itkExceptionMacro(<< "ERROR: No transform has been set.");
+  }
+
+  this->m_IsBaked = false;
+
+  /** Transforms that are not advanced transforms are not collapsed. */
+  const auto advancedTransform = dynamic_cast<const AdvancedTransformType *>(this->m_Transform.GetPointer());
+  if (advancedTransform == nullptr)
+  {
+    this->m_CollapsedTransform = const_cast<TransformType *>(this->m_Transform.GetPointer());
+    this->m_NumberOfTransformsBefore = 1;
+    this->m_NumberOfTransformsAfter = 1;
+    this->ComputeApproximationError();
+    return;
+  }
+
+  TransformChainType chain;
+  FlattenTransformChain(advancedTransform, chain);
+  this->m_NumberOfTransformsBefore = chain.size();
+
+  const TransformChainType mergedChain = MergeLinearTransforms(chain);
+  const bool               isLinear = std::all_of(mergedChain.cbegin(), mergedChain.cend(), [](const auto & transform) {
+    return dynamic_cast<const MatrixOffsetTransformType *>(transform.GetPointer()) != nullptr;
+  });
+
+  if (this->m_BakeDeformableTransforms && !isLinear)
+  {
+    this->m_CollapsedTransform = this->BakeIntoDisplacementField();
+    this->m_NumberOfTransformsAfter = 1;
+    this->m_IsBaked = true;
+  }
+  else
+  {
+    this->m_CollapsedTransform = ComposeTransformChain(mergedChain);
+    this->m_NumberOfTransformsAfter = mergedChain.size();
+  }
+
+  this->ComputeApproximationError();
+
+} // end Update()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+CombinationTransformCollapser<TScalarType, NDimensions>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Transform: " << this->m_Transform.GetPointer() << std::endl;
+  os << indent << "CollapsedTransform: " << this->m_CollapsedTransform.GetPointer() << std::endl;
+  os << indent << "BakeDeformableTransforms: " << this->m_BakeDeformableTransforms << std::endl;
+  os << indent << "OutputOrigin: " << this->m_OutputOrigin << std::endl;
+  os << indent << "OutputSpacing: " << this->m_OutputSpacing << std::endl;
+  os << indent << "OutputDirection: " << this->m_OutputDirection << std::endl;
+  os << indent << "OutputSize: " << this->m_OutputSize << std::endl;
+  os << indent << "OutputStartIndex: " << this->m_OutputStartIndex << std::endl;
+  os << indent << "NumberOfErrorSamples: " << this->m_NumberOfErrorSamples << std::endl;
+  os << indent << "NumberOfTransformsBefore: " << this->m_NumberOfTransformsBefore << std::endl;
+  os << indent << "NumberOfTransformsAfter: " << this->m_NumberOfTransformsAfter << std::endl;
+  os << indent << "IsBaked: " << this->m_IsBaked << std::endl;
+  os << indent << "MeanError: " << this->m_MeanError << std::endl;
+  os << indent << "MaximumError: " << this->m_MaximumError << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkCombinationTransformCollapser_hxx
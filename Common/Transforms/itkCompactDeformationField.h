@@ -0,0 +1,213 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkCompactDeformationField_h
+#define itkCompactDeformationField_h
+
+#include "itkImage.h"
+#include "itkMemoryMappedFile.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * \class CompactDeformationField
+ * \brief A deformation field with compact or memory mapped storage, that
+ * interpolates its vectors on the fly.
+ *
+ * The vectors of the field can be stored in one of the following ways:
+ * \li Float32 or Float64: the components in single or double precision.
+ * \li Half: the components in IEEE half precision (16 bits), with a
+ *   relative precision of about 1e-3.
+ * \li Int16: the components quantized to 16 bit integers, which are multiplied
+ *   by the QuantizationScale. The absolute precision is half the scale.
+ *
+ * The field can be set from an image, by SetDeformationField(), which copies
+ * the vectors into the requested storage, or it can be mapped into memory from
+ * the raw data of an uncompressed MetaImage (mhd/mha) or NRRD (nhdr/nrrd) file,
+ * by MapRawImageFile(). A mapped field is never copied: the pages of the file
+ * are read on demand and shared with other processes that map the same file.
+ * Mapped files can have float, double, or (quantized) short components.
+ *
+ * Evaluate() interpolates the field with nearest neighbour (order 0) or
+ * linear (order 1) interpolation, converting the stored components to
+ * TScalarType on the fly. It gives the same results as the
+ * VectorNearestNeighborInterpolateImageFunction and the
+ * VectorLinearInterpolateImageFunction, up to the precision of the storage.
+ *
+ * \ingroup Transforms
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType = float>
+class ITK_TEMPLATE_EXPORT CompactDeformationField : public Object
+{
+public:
+  /** Standard ITK-stuff. */
+  using Self = CompactDeformationField;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(CompactDeformationField, Object);
+
+  /** Typedefs. */
+  using DeformationFieldVectorType = Vector<TComponentType, NDimensions>;
+  using DeformationFieldType = Image<DeformationFieldVectorType, NDimensions>;
+  using DeformationFieldPointer = typename DeformationFieldType::Pointer;
+  using GeometryType = ImageBase<NDimensions>;
+  using GeometryPointer = typename GeometryType::Pointer;
+  using PointType = Point<TScalarType, NDimensions>;
+  using OutputVectorType = Vector<TScalarType, NDimensions>;
+  using ContinuousIndexType = ContinuousIndex<TScalarType, NDimensions>;
+  using SizeType = typename GeometryType::SizeType;
+  using IndexType = typename GeometryType::IndexType;
+
+  /** The ways to store the components of the vectors. */
+  enum class ComponentStorageEnum
+  {
+    Float32,
+    Float64,
+    Half,
+    Int16
+  };
+
+  /** Copy the vectors of an image into the given storage. For the Int16
+   * storage, the QuantizationScale is chosen such that the largest component
+   * is represented by the largest 16 bit integer.
+   */
+  virtual void
+  SetDeformationField(const DeformationFieldType * field, const ComponentStorageEnum storage);
+
+  /** Map the raw data of an uncompressed MetaImage or NRRD file into memory.
+   * The data should be stored in the byte order of this machine. For files with
+   * short components, each component is multiplied by the quantizationScale.
+   */
+  virtual void
+  MapRawImageFile(const std::string & fileName, const double quantizationScale = 1.0);
+
+  /** Decompress the field into a new image. */
+  virtual DeformationFieldPointer
+  CreateDeformationField() const;
+
+  /** Interpolate the deformation field at a point. Returns false, and leaves the
+   * displacement untouched, when the point is outside the field.
+   */
+  bool
+  Evaluate(const PointType & point, OutputVectorType & displacement) const;
+
+  /** The interpolation order: 0 (nearest neighbour) or 1 (linear). Default: 0. */
+  itkSetClampMacro(InterpolationOrder, unsigned int, 0, 1);
+  itkGetConstMacro(InterpolationOrder, unsigned int);
+
+  /** The storage of the components. */
+  itkGetConstMacro(ComponentStorage, ComponentStorageEnum);
+
+  /** The scale of the Int16 components. */
+  itkGetConstMacro(QuantizationScale, double);
+
+  /** Whether the field is mapped from a file. */
+  bool
+  IsMemoryMapped() const
+  {
+    return this->m_MappedFile.IsNotNull();
+  }
+
+  /** The number of bytes used for the components. For a memory mapped field,
+   * these bytes are shared with other processes that map the same file.
+   */
+  std::size_t
+  GetBufferSizeInBytes() const;
+
+  /** The geometry of the field: origin, spacing, direction, and largest
+   * possible region. The direction may be changed, to ignore the direction
+   * cosines of the field.
+   */
+  itkGetModifiableObjectMacro(Geometry, GeometryType);
+
+  /** Conversions between single and half precision. */
+  static std::uint16_t
+  FloatToHalf(const float value);
+
+  static float
+  HalfToFloat(const std::uint16_t value);
+
+protected:
+  /** The constructor. */
+  CompactDeformationField();
+  /** The destructor. */
+  ~CompactDeformationField() override = default;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Return component i of the buffer, converted to double. */
+  double
+  GetComponent(const std::size_t i) const;
+
+  /** Determine the name of the file containing the raw data of the image
+   * with the given header, and the position of the data in that file.
+   */
+  virtual void
+  DetermineRawDataLocation(const std::string & headerFileName,
+                           const std::size_t   dataSize,
+                           std::string &       dataFileName,
+                           std::size_t &       dataOffset) const;
+
+private:
+  CompactDeformationField(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  /** Set the size, start index, and offset table from the geometry. */
+  void
+  InitializeOffsetTable();
+
+  /** The number of bytes of a component with the given storage. */
+  static std::size_t
+  GetComponentSize(const ComponentStorageEnum storage);
+
+  GeometryPointer      m_Geometry;
+  SizeType             m_Size;
+  IndexType            m_StartIndex;
+  std::size_t          m_OffsetTable[NDimensions];
+  ComponentStorageEnum m_ComponentStorage{ ComponentStorageEnum::Float32 };
+  double               m_QuantizationScale{ 1.0 };
+  unsigned int         m_InterpolationOrder{ 0 };
+
+  /** The components, interleaved per voxel. Points into either m_OwnedBuffer,
+   * or into the mapped file.
+   */
+  const char *              m_Buffer{ nullptr };
+  std::vector<char>         m_OwnedBuffer;
+  MemoryMappedFile::Pointer m_MappedFile;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkCompactDeformationField.hxx"
+#endif
+
+#endif // end #ifndef itkCompactDeformationField_h
@@ -0,0 +1,690 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkCompactDeformationField_hxx
+#define itkCompactDeformationField_hxx
+
+#include "itkCompactDeformationField.h"
+
+#include "itkByteSwapper.h"
+#include "itkImageFileReader.h"
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm> // For min, max and max_element.
+#include <cmath>
+#include <cstring> // For memcpy.
+#include <fstream>
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::CompactDeformationField()
+{
+  this->m_Geometry = GeometryType::New();
+  this->InitializeOffsetTable();
+
+} // end Constructor
+
+
+/**
+ * ********************* GetComponentSize ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+std::size_t
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::GetComponentSize(const ComponentStorageEnum storage)
+{
+  switch (storage)
+  {
+    case ComponentStorageEnum::Float32:
+      return sizeof(float);
+    case ComponentStorageEnum::Float64:
+      return sizeof(double);
+    case ComponentStorageEnum::Half:
+    case ComponentStorageEnum::Int16:
+      return sizeof(std::int16_t);
+  }
+  return 0;
+
+} // end GetComponentSize()
+
+
+/**
+ * ********************* InitializeOffsetTable ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+void
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::InitializeOffsetTable()
+{
+  const auto & region = this->m_Geometry->GetBufferedRegion();
+  this->m_Size = region.GetSize();
+  this->m_StartIndex = region.GetIndex();
+
+  std::size_t stride = 1;
+  for (unsigned int d = 0; d < NDimensions; ++d)
+  {
+    this->m_OffsetTable[d] = stride;
+    stride *= this->m_Size[d];
+  }
+
+} // end InitializeOffsetTable()
+
+
+/**
+ * ********************* SetDeformationField ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+void
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::SetDeformationField(
+  const DeformationFieldType * field,
+  const ComponentStorageEnum   storage)
+{
+  if (field == nullptr)
+  {
+    itkExceptionMacro(<< "The deformation field is null.");
+  }
+
+  const auto geometry = GeometryType::New();
+  geometry->CopyInformation(field);
+  geometry->SetRegions(field->GetBufferedRegion());
+
+  const std::size_t      numberOfComponents = field->GetBufferedRegion().GetNumberOfPixels() * NDimensions;
+  const TComponentType * components = reinterpret_cast<const TComponentType *>(field->GetBufferPointer());
+  const std::size_t      componentSize = GetComponentSize(storage);
+
+  /** For the Int16 storage, map the largest component to the largest integer. */
+  double scale = 1.0;
+  if (storage == ComponentStorageEnum::Int16)
+  {
+    double maximumAbsoluteValue = 0.0;
+    for (std::size_t i = 0; i < numberOfComponents; ++i)
+    {
+      maximumAbsoluteValue = std::max(maximumAbsoluteValue, std::abs(static_cast<double>(components[i])));
+    }
+    if (maximumAbsoluteValue > 0.0)
+    {
+      scale = maximumAbsoluteValue / 32767.0;
+    }
+  }
+
+  std::vector<char> buffer(numberOfComponents * componentSize);
+  for (std::size_t i = 0; i < numberOfComponents; ++i)
+  {
+    const double value = static_cast<double>(components[i]);
+    char *       destination = buffer.data() + i * componentSize;
+    switch (storage)
+    {
+      case ComponentStorageEnum::Float32:
+      {
+        const auto stored = static_cast<float>(value);
+        std::memcpy(destination, &stored, componentSize);
+        break;
+      }
+      case ComponentStorageEnum::Float64:
+      {
+        std::memcpy(destination, &value, componentSize);
+        break;
+      }
+      case ComponentStorageEnum::Half:
+      {
+        const std::uint16_t stored = FloatToHalf(static_cast<float>(value));
+        std::memcpy(destination, &stored, componentSize);
+        break;
+      }
+      case ComponentStorageEnum::Int16:
+      {
+        const auto stored = static_cast<std::int16_t>(std::max(-32767.0, std::min(std::round(value / scale), 32767.0)));
+        std::memcpy(destination, &stored, componentSize);
+        break;
+      }
+    }
+  }
+
+  this->m_MappedFile = nullptr;
+  this->m_OwnedBuffer.swap(buffer);
+  this->m_Buffer = this->m_OwnedBuffer.data();
+  this->m_ComponentStorage = storage;
+  this->m_QuantizationScale = scale;
+  this->m_Geometry = geometry;
+  this->InitializeOffsetTable();
+  this->Modified();
+
+} // end SetDeformationField()
+
+
+/**
+ * ********************* MapRawImageFile ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+void
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::MapRawImageFile(const std::string & fileName,
+                                                                                   const double quantizationScale)
+{
+  /** Read the header, for the geometry and the type of the data. */
+  const auto reader = ImageFileReader<DeformationFieldType>::New();
+  reader->SetFileName(fileName);
+  reader->UpdateOutputInformation();
+  const ImageIOBase * imageIO = reader->GetImageIO();
+
+  if (imageIO->GetNumberOfDimensions() != NDimensions || imageIO->GetNumberOfComponents() != NDimensions)
+  {
+    itkExceptionMacro(<< "The deformation field \"" << fileName << "\" should have " << NDimensions
+                      << " dimensions and " << NDimensions << " components per pixel.");
+  }
+
+  ComponentStorageEnum storage;
+  switch (imageIO->GetComponentType())
+  {
+    case IOComponentEnum::FLOAT:
+      storage = ComponentStorageEnum::Float32;
+      break;
+    case IOComponentEnum::DOUBLE:
+      storage = ComponentStorageEnum::Float64;
+      break;
+    case IOComponentEnum::SHORT:
+      storage = ComponentStorageEnum::Int16;
+      break;
+    default:
+      itkExceptionMacro(<< "The deformation field \"" << fileName << "\" has components of type "
+                        << ImageIOBase::GetComponentTypeAsString(imageIO->GetComponentType())
+                        << ", which cannot be memory mapped. Use float, double, or short.");
+  }
+
+  const IOByteOrderEnum foreignByteOrder =
+    ByteSwapper<int>::SystemIsBigEndian() ? IOByteOrderEnum::LittleEndian : IOByteOrderEnum::BigEndian;
+  if (imageIO->GetByteOrder() == foreignByteOrder && GetComponentSize(storage) > 1)
+  {
+    itkExceptionMacro(<< "The deformation field \"" << fileName
+                      << "\" is not stored in the byte order of this machine, so it cannot be memory mapped.");
+  }
+
+  const auto geometry = GeometryType::New();
+  geometry->CopyInformation(reader->GetOutput());
+  geometry->SetRegions(reader->GetOutput()->GetLargestPossibleRegion());
+
+  /** Map the file with the raw data. */
+  const std::size_t dataSize =
+    geometry->GetBufferedRegion().GetNumberOfPixels() * NDimensions * GetComponentSize(storage);
+  std::string dataFileName;
+  std::size_t dataOffset = 0;
+  this->DetermineRawDataLocation(fileName, dataSize, dataFileName, dataOffset);
+
+  const auto mappedFile = MemoryMappedFile::New();
+  mappedFile->Map(dataFileName);
+  if (mappedFile->GetSize() < dataOffset + dataSize)
+  {
+    itkExceptionMacro(<< "The file \"" << dataFileName << "\" is too small for the deformation field \"" << fileName
+                      << "\".");
+  }
+
+  this->m_MappedFile = mappedFile;
+  this->m_OwnedBuffer = std::vector<char>();
+  this->m_Buffer = mappedFile->GetData() + dataOffset;
+  this->m_ComponentStorage = storage;
+  this->m_QuantizationScale = (storage == ComponentStorageEnum::Int16) ? quantizationScale : 1.0;
+  this->m_Geometry = geometry;
+  this->InitializeOffsetTable();
+  this->Modified();
+
+} // end MapRawImageFile()
+
+
+/**
+ * ********************* DetermineRawDataLocation ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+void
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::DetermineRawDataLocation(
+  const std::string & headerFileName,
+  const std::size_t   dataSize,
+  std::string &       dataFileName,
+  std::size_t &       dataOffset) const
+{
+  std::ifstream header(headerFileName, std::ios::binary);
+  if (!header)
+  {
+    itkExceptionMacro(<< "Could not open \"" << headerFileName << "\".");
+  }
+
+  const auto trim = [](const std::string & text) {
+    const auto first = text.find_first_not_of(" \t\r");
+    const auto last = text.find_last_not_of(" \t\r");
+    return (first == std::string::npos) ? std::string() : text.substr(first, last - first + 1);
+  };
+
+  /** Data files are relative to the header. */
+  const auto makeDataFileName = [&headerFileName](const std::string & name) {
+    const std::string path = itksys::SystemTools::GetFilenamePath(headerFileName);
+    return (path.empty() || itksys::SystemTools::FileIsFullPath(name)) ? name : path + "/" + name;
+  };
+
+  /** Data at the end of the file, as for a negative header size or byte skip. */
+  const auto offsetFromEnd = [this, dataSize](const std::string & name) {
+    const std::size_t fileSize = itksys::SystemTools::FileLength(name);
+    if (fileSize < dataSize)
+    {
+      itkExceptionMacro(<< "The file \"" << name << "\" is too small for the deformation field.");
+    }
+    return fileSize - dataSize;
+  };
+
+  std::string line;
+  std::getline(header, line);
+
+  if (line.compare(0, 4, "NRRD") != 0)
+  {
+    /** A MetaImage header: key = value lines, ending with the ElementDataFile. */
+    header.seekg(0);
+    long headerSize = 0;
+    while (std::getline(header, line))
+    {
+      const auto separator = line.find('=');
+      if (separator == std::string::npos)
+      {
+        continue;
+      }
+      const std::string key = trim(line.substr(0, separator));
+      const std::string value = trim(line.substr(separator + 1));
+      if (key == "CompressedData" && (value == "True" || value == "true"))
+      {
+        itkExceptionMacro(<< "The deformation field \"" << headerFileName
+                          << "\" is compressed, so it cannot be memory mapped.");
+      }
+      else if (key == "HeaderSize")
+      {
+        headerSize = std::stol(value);
+      }
+      else if (key == "ElementDataFile")
+      {
+        if (value == "LOCAL")
+        {
+          dataFileName = headerFileName;
+          dataOffset = static_cast<std::size_t>(header.tellg());
+        }
+        else if (value == "LIST" || value.find('%') != std::string::npos)
+        {
+          itkExceptionMacro(<< "The deformation field \"" << headerFileName
+                            << "\" is stored in multiple files, so it cannot be memory mapped.");
+        }
+        else
+        {
+          dataFileName = makeDataFileName(value);
+          dataOffset = (headerSize >= 0) ? static_cast<std::size_t>(headerSize) : offsetFromEnd(dataFileName);
+        }
+        return;
+      }
+    }
+    itkExceptionMacro(<< "The MetaImage header \"" << headerFileName << "\" has no ElementDataFile.");
+  }
+
+  /** A NRRD header: "field: value" lines, ending with an empty line. */
+  std::string encoding;
+  std::string dataFile;
+  long        lineSkip = 0;
+  long        byteSkip = 0;
+  while (std::getline(header, line))
+  {
+    line = trim(line);
+    if (line.empty())
+    {
+      break;
+    }
+    const auto separator = line.find(": ");
+    if (line[0] == '#' || separator == std::string::npos)
+    {
+      continue;
+    }
+    const std::string key = line.substr(0, separator);
+    const std::string value = trim(line.substr(separator + 2));
+    if (key == "encoding")
+    {
+      encoding = value;
+    }
+    else if (key == "data file" || key == "datafile")
+    {
+      dataFile = value;
+    }
+    else if (key == "line skip" || key == "lineskip")
+    {
+      lineSkip = std::stol(value);
+    }
+    else if (key == "byte skip" || key == "byteskip")
+    {
+      byteSkip = std::stol(value);
+    }
+  }
+
+  if (encoding != "raw")
+  {
+    itkExceptionMacro(<< "The deformation field \"" << headerFileName << "\" has \"" << encoding
+                      << "\" encoding. Only raw encoding can be memory mapped.");
+  }
+  if (dataFile.compare(0, 4, "LIST") == 0 || dataFile.find(' ') != std::string::npos)
+  {
+    itkExceptionMacro(<< "The deformation field \"" << headerFileName
+                      << "\" is stored in multiple files, so it cannot be memory mapped.");
+  }
+
+  std::ifstream  detachedData;
+  std::istream * data = &header;
+  dataFileName = headerFileName;
+  if (!dataFile.empty())
+  {
+    dataFileName = makeDataFileName(dataFile);
+    detachedData.open(dataFileName, std::ios::binary);
+    data = &detachedData;
+  }
+  for (long i = 0; i < lineSkip; ++i)
+  {
+    std::getline(*data, line);
+  }
+  if (!*data)
+  {
+    itkExceptionMacro(<< "Could not find the data of the deformation field \"" << headerFileName << "\".");
+  }
+  dataOffset = (byteSkip < 0) ? offsetFromEnd(dataFileName) : static_cast<std::size_t>(data->tellg()) + byteSkip;
+
+} // end DetermineRawDataLocation()
+
+
+/**
+ * ********************* GetComponent ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+double
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::GetComponent(const std::size_t i) const
+{
+  /** memcpy, since the data of a mapped file need not be aligned. */
+  switch (this->m_ComponentStorage)
+  {
+    case ComponentStorageEnum::Float32:
+    {
+      float value;
+      std::memcpy(&value, this->m_Buffer + i * sizeof(float), sizeof(float));
+      return value;
+    }
+    case ComponentStorageEnum::Float64:
+    {
+      double value;
+      std::memcpy(&value, this->m_Buffer + i * sizeof(double), sizeof(double));
+      return value;
+    }
+    case ComponentStorageEnum::Half:
+    {
+      std::uint16_t value;
+      std::memcpy(&value, this->m_Buffer + i * sizeof(value), sizeof(value));
+      return HalfToFloat(value);
+    }
+    case ComponentStorageEnum::Int16:
+    {
+      std::int16_t value;
+      std::memcpy(&value, this->m_Buffer + i * sizeof(value), sizeof(value));
+      return value * this->m_QuantizationScale;
+    }
+  }
+  return 0.0;
+
+} // end GetComponent()
+
+
+/**
+ * ********************* Evaluate ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+bool
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::Evaluate(const PointType &  point,
+                                                                            OutputVectorType & displacement) const
+{
+  ContinuousIndexType cindex;
+  this->m_Geometry->TransformPhysicalPointToContinuousIndex(point, cindex);
+
+  /** The same bounds as ImageFunction::IsInsideBuffer(). */
+  for (unsigned int d = 0; d < NDimensions; ++d)
+  {
+    cindex[d] -= this->m_StartIndex[d];
+    if (!(cindex[d] >= -0.5 && cindex[d] < this->m_Size[d] - 0.5))
+    {
+      return false;
+    }
+  }
+
+  /** Nearest neighbour interpolation, rounding as the VectorNearestNeighborInterpolateImageFunction. */
+  if (this->m_InterpolationOrder == 0)
+  {
+    std::size_t offset = 0;
+    for (unsigned int d = 0; d < NDimensions; ++d)
+    {
+      const auto index = Math::RoundHalfIntegerUp<IndexValueType>(cindex[d]);
+      offset += std::min<std::size_t>(std::max<IndexValueType>(index, 0), this->m_Size[d] - 1) * this->m_OffsetTable[d];
+    }
+    for (unsigned int c = 0; c < NDimensions; ++c)
+    {
+      displacement[c] = static_cast<TScalarType>(this->GetComponent(offset * NDimensions + c));
+    }
+    return true;
+  }
+
+  /** Linear interpolation, clamping the neighbours to the field, as the
+   * VectorLinearInterpolateImageFunction.
+   */
+  IndexValueType baseIndex[NDimensions];
+  double         distance[NDimensions];
+  for (unsigned int d = 0; d < NDimensions; ++d)
+  {
+    baseIndex[d] = Math::Floor<IndexValueType>(cindex[d]);
+    distance[d] = cindex[d] - static_cast<double>(baseIndex[d]);
+  }
+
+  double value[NDimensions] = {};
+  for (unsigned int corner = 0; corner < (1u << NDimensions); ++corner)
+  {
+    double      weight = 1.0;
+    std::size_t offset = 0;
+    for (unsigned int d = 0; d < NDimensions; ++d)
+    {
+      IndexValueType index = baseIndex[d];
+      if (corner & (1u << d))
+      {
+        ++index;
+        weight *= distance[d];
+      }
+      else
+      {
+        weight *= 1.0 - distance[d];
+      }
+      index = std::max<IndexValueType>(0, std::min<IndexValueType>(index, this->m_Size[d] - 1));
+      offset += index * this->m_OffsetTable[d];
+    }
+
+    if (weight == 0.0)
+    {
+      continue;
+    }
+    for (unsigned int c = 0; c < NDimensions; ++c)
+    {
+      value[c] += weight * this->GetComponent(offset * NDimensions + c);
+    }
+  }
+
+  for (unsigned int c = 0; c < NDimensions; ++c)
+  {
+    displacement[c] = static_cast<TScalarType>(value[c]);
+  }
+  return true;
+
+} // end Evaluate()
+
+
+/**
+ * ********************* CreateDeformationField ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+auto
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::CreateDeformationField() const
+  -> DeformationFieldPointer
+{
+  const auto field = DeformationFieldType::New();
+  field->CopyInformation(this->m_Geometry);
+  field->SetRegions(this->m_Geometry->GetBufferedRegion());
+  field->Allocate();
+
+  const std::size_t numberOfComponents = field->GetBufferedRegion().GetNumberOfPixels() * NDimensions;
+  auto *            components = reinterpret_cast<TComponentType *>(field->GetBufferPointer());
+  for (std::size_t i = 0; i < numberOfComponents; ++i)
+  {
+    components[i] = static_cast<TComponentType>(this->GetComponent(i));
+  }
+  return field;
+
+} // end CreateDeformationField()
+
+
+/**
+ * ********************* GetBufferSizeInBytes ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+std::size_t
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::GetBufferSizeInBytes() const
+{
+  return this->m_Geometry->GetBufferedRegion().GetNumberOfPixels() * NDimensions *
+         GetComponentSize(this->m_ComponentStorage);
+
+} // end GetBufferSizeInBytes()
+
+
+/**
+ * ********************* FloatToHalf ****************************
+ *
+ * Rounds to the nearest half precision value, ties to even.
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+std::uint16_t
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::FloatToHalf(const float value)
+{
+  std::uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const std::uint32_t sign = (bits >> 16) & 0x8000u;
+  const std::uint32_t absoluteBits = bits & 0x7fffffffu;
+
+  /** Infinity and NaN. */
+  if (absoluteBits >= 0x7f800000u)
+  {
+    return static_cast<std::uint16_t>(sign | 0x7c00u | ((absoluteBits > 0x7f800000u) ? 0x200u : 0u));
+  }
+
+  /** Overflow: 65520 and larger round to infinity. */
+  if (absoluteBits >= 0x477ff000u)
+  {
+    return static_cast<std::uint16_t>(sign | 0x7c00u);
+  }
+
+  /** Subnormal half precision values, below 2^-14. */
+  if (absoluteBits < 0x38800000u)
+  {
+    if (absoluteBits < 0x33000000u)
+    {
+      return static_cast<std::uint16_t>(sign);
+    }
+    const std::uint32_t exponent = absoluteBits >> 23;
+    const std::uint32_t mantissa = (absoluteBits & 0x7fffffu) | 0x800000u;
+    const std::uint32_t shift = 126 - exponent;
+    const std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+    const std::uint32_t halfway = 1u << (shift - 1);
+    std::uint32_t       result = mantissa >> shift;
+    if (remainder > halfway || (remainder == halfway && (result & 1u)))
+    {
+      ++result;
+    }
+    return static_cast<std::uint16_t>(sign | result);
+  }
+
+  /** Normal values: rebias the exponent and round the mantissa. */
+  std::uint32_t       result = (absoluteBits - 0x38000000u) >> 13;
+  const std::uint32_t remainder = absoluteBits & 0x1fffu;
+  if (remainder > 0x1000u || (remainder == 0x1000u && (result & 1u)))
+  {
+    ++result;
+  }
+  return static_cast<std::uint16_t>(sign | result);
+
+} // end FloatToHalf()
+
+
+/**
+ * ********************* HalfToFloat ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+float
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::HalfToFloat(const std::uint16_t value)
+{
+  const std::uint32_t sign = static_cast<std::uint32_t>(value & 0x8000u) << 16;
+  const std::uint32_t exponent = (value >> 10) & 0x1fu;
+  const std::uint32_t mantissa = value & 0x3ffu;
+
+  if (exponent == 0)
+  {
+    /** Zero and subnormal values. */
+    const float result = std::ldexp(static_cast<float>(mantissa), -24);
+    return sign ? -result : result;
+  }
+
+  const std::uint32_t bits =
+    (exponent == 31) ? (sign | 0x7f800000u | (mantissa << 13)) : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+
+} // end HalfToFloat()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+void
+CompactDeformationField<TScalarType, NDimensions, TComponentType>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Geometry: " << this->m_Geometry << std::endl;
+  os << indent << "ComponentStorage: " << static_cast<int>(this->m_ComponentStorage) << std::endl;
+  os << indent << "QuantizationScale: " << this->m_QuantizationScale << std::endl;
+  os << indent << "InterpolationOrder: " << this->m_InterpolationOrder << std::endl;
+  os << indent << "MemoryMapped: " << this->IsMemoryMapped() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkCompactDeformationField_hxx
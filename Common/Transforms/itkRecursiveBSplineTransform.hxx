@@ -70,15 +70,24 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::TransformPoint(co
     totalOffsetToSupportIndex += supportIndex[j] * bsplineOffsetTable[j];
   }
 
-  ScalarType * mu[SpaceDimension];
-  for (unsigned int j = 0; j < SpaceDimension; ++j)
+  /** Call the recursive TransformPoint function. When available, read all
+   * coefficients of a control point from the interleaved buffer at once.
+   */
+  ScalarType displacement[SpaceDimension];
+  if (!this->m_InterleavedCoefficients.empty())
   {
-    mu[j] = this->m_CoefficientImages[j]->GetBufferPointer() + totalOffsetToSupportIndex;
+    const ScalarType * mu = this->m_InterleavedCoefficients.data() + totalOffsetToSupportIndex * SpaceDimension;
+    ImplementationType::TransformPointInterleaved(displacement, mu, bsplineOffsetTable, weights1D.data());
+  }
+  else
+  {
+    ScalarType * mu[SpaceDimension];
+    for (unsigned int j = 0; j < SpaceDimension; ++j)
+    {
+      mu[j] = this->m_CoefficientImages[j]->GetBufferPointer() + totalOffsetToSupportIndex;
+    }
+    ImplementationType::TransformPoint(displacement, mu, bsplineOffsetTable, weights1D.data());
   }
-
-  /** Call the recursive TransformPoint function. */
-  ScalarType displacement[SpaceDimension];
-  ImplementationType::TransformPoint(displacement, mu, bsplineOffsetTable, weights1D.data());
 
   // The output point is the start point + displacement.
   for (unsigned int j = 0; j < SpaceDimension; ++j)
@@ -90,6 +90,41 @@ public:
   } // end TransformPoint()
 
 
+  /** TransformPoint recursive implementation for interleaved coefficients.
+   * In contrast to TransformPoint(), mu points to a single array, in which the
+   * OutputDimension coefficients of each control point are stored contiguously.
+   * The gridOffsetTable is the one of a single coefficient image.
+   */
+  static inline void
+  TransformPointInterleaved(TScalar * const               opp,
+                            const TScalar * const         mu,
+                            const OffsetValueType * const gridOffsetTable,
+                            const double * const          weights1D)
+  {
+    /** Create a temporary opp and initialize the original. */
+    TScalar tmp_opp[OutputDimension];
+    std::fill_n(opp, OutputDimension, 0.0);
+
+    const OffsetValueType bot = gridOffsetTable[SpaceDimension - 1] * OutputDimension;
+    const TScalar *       tmp_mu = mu;
+    for (unsigned int k = 0; k <= SplineOrder; ++k)
+    {
+      /** Recurse. */
+      RecursiveBSplineTransformImplementation<OutputDimension, SpaceDimension - 1, SplineOrder, TScalar>::
+        TransformPointInterleaved(tmp_opp, tmp_mu, gridOffsetTable, weights1D);
+
+      /** Accumulate the weights. */
+      for (unsigned int j = 0; j < OutputDimension; ++j)
+      {
+        opp[j] += tmp_opp[j] * weights1D[k + HelperConstVariable];
+      }
+
+      // move to the next mu
+      tmp_mu += bot;
+    }
+  } // end TransformPointInterleaved()
+
+
   /** GetJacobian recursive implementation. */
   static inline void
   GetJacobian(TScalar *& jacobians, const double * const weights1D, const double value)
@@ -378,6 +413,17 @@ public:
   } // end TransformPoint()
 
 
+  /** TransformPointInterleaved recursive implementation. */
+  static inline void
+  TransformPointInterleaved(TScalar * const               opp,
+                            const TScalar * const         mu,
+                            const OffsetValueType * const gridOffsetTable,
+                            const double * const          weights1D)
+  {
+    std::copy_n(mu, OutputDimension, opp);
+  } // end TransformPointInterleaved()
+
+
   /** GetJacobian recursive implementation. */
   static inline void
   GetJacobian(TScalar *& jacobians, const double * const weights1D, const double value)
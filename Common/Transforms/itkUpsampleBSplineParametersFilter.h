@@ -20,6 +20,10 @@
 
 #include "itkObject.h"
 #include "itkArray.h"
+#include "itkPlatformMultiThreader.h"
+
+#include <utility> // For pair.
+#include <vector>
 
 namespace itk
 {
@@ -33,6 +37,14 @@ namespace itk
  * on a denser grid. Therefore, the user needs to supply the old B-spline grid
  * (region, spacing, origin, direction), and the required B-spline grid.
  *
+ * When UseDirectSubdivision is enabled, and the required grid is a dyadic
+ * refinement of the current grid (half the spacing, equal direction, and an
+ * origin that lies on the refined lattice), the new parameters are computed
+ * directly from the B-spline subdivision stencil, in a multi-threaded fashion,
+ * without building intermediate images. For odd spline orders this is an exact
+ * representation of the current B-spline on the required grid. In all other
+ * cases the resample-and-decompose route is used.
+ *
  */
 
 template <class TArray, class TImage>
@@ -92,6 +104,18 @@ public:
   /** Set the B-spline order. */
   itkSetMacro(BSplineOrder, unsigned int);
 
+  /** Set/Get whether dyadic refinements are computed by direct subdivision. Default: false. */
+  itkSetMacro(UseDirectSubdivision, bool);
+  itkGetConstMacro(UseDirectSubdivision, bool);
+  itkBooleanMacro(UseDirectSubdivision);
+
+  /** Set the number of threads used for the direct subdivision. */
+  void
+  SetNumberOfWorkUnits(ThreadIdType numberOfThreads)
+  {
+    this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
+  }
+
   /** Compute the output parameter array. */
   virtual void
   UpsampleParameters(const ArrayType & param_in, ArrayType & param_out);
@@ -111,6 +135,37 @@ protected:
   virtual bool
   DoUpsampling();
 
+  /** Function that checks if the required grid is a dyadic refinement of the
+   * current grid, which can be computed by direct subdivision. If so, it
+   * precomputes the subdivision stencils.
+   */
+  virtual bool
+  PrepareDirectSubdivision();
+
+  /** Upsample the parameters using the subdivision stencils. */
+  virtual void
+  UpsampleParametersUsingSubdivision(const ArrayType & parameters_in, ArrayType & parameters_out);
+
+  /** Typedefs for multi-threading. */
+  using ThreaderType = itk::PlatformMultiThreader;
+  using ThreadInfoType = ThreaderType::WorkUnitInfo;
+
+  /** Subdivision threader callback function. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  SubdivisionThreaderCallback(void * arg);
+
+  /** The threaded implementation of UpsampleParametersUsingSubdivision(). */
+  virtual void
+  ThreadedSubdivision(ThreadIdType threadId);
+
+  /** To give the threads access to all member variables and functions. */
+  struct MultiThreaderParameterType
+  {
+    Self *            st_Self;
+    const ValueType * st_InputParameters;
+    ValueType *       st_OutputParameters;
+  };
+
 private:
   UpsampleBSplineParametersFilter(const Self &) = delete;
   void
@@ -126,6 +181,17 @@ private:
   DirectionType m_RequiredGridDirection;
   RegionType    m_RequiredGridRegion;
   unsigned int  m_BSplineOrder;
+  bool          m_UseDirectSubdivision;
+
+  /** For each dimension and each required grid position: the current grid
+   * positions (relative to the current grid region) that contribute, and their weights.
+   */
+  using SubdivisionTermType = std::pair<SizeValueType, double>;
+  using SubdivisionStencilType = std::vector<std::vector<SubdivisionTermType>>;
+  SubdivisionStencilType m_SubdivisionStencils[Dimension];
+
+  ThreaderType::Pointer      m_Threader;
+  MultiThreaderParameterType m_ThreaderParameters;
 };
 
 } // end namespace itk
@@ -24,6 +24,9 @@
 #include "itkBSplineDecompositionImageFilter.h"
 #include "itkResampleImageFilter.h"
 
+#include <algorithm> // For min and max.
+#include <cmath>     // For abs, ceil and round.
+
 namespace itk
 {
 
@@ -35,6 +38,13 @@ template <class TArray, class TImage>
 UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleBSplineParametersFilter()
 {
   this->m_BSplineOrder = 3;
+  this->m_UseDirectSubdivision = false;
+
+  /** Threading related variables. */
+  this->m_Threader = ThreaderType::New();
+  this->m_ThreaderParameters.st_Self = this;
+  this->m_ThreaderParameters.st_InputParameters = nullptr;
+  this->m_ThreaderParameters.st_OutputParameters = nullptr;
 
   // Initialize grid settings.
   this->m_CurrentGridOrigin.Fill(0.0);
@@ -62,6 +72,13 @@ UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleParameters(const ArrayT
     return;
   }
 
+  /** Dyadic refinements can be computed directly from the current coefficients. */
+  if (this->PrepareDirectSubdivision())
+  {
+    this->UpsampleParametersUsingSubdivision(parameters_in, parameters_out);
+    return;
+  }
+
   /** Typedefs. */
   using UpsampleFilterType = itk::ResampleImageFilter<ImageType, ImageType>;
   using CoefficientUpsampleFunctionType = itk::BSplineResampleImageFunction<ImageType, ValueType>;
@@ -150,6 +167,218 @@ UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleParameters(const ArrayT
 } // end UpsampleParameters()
 
 
+/**
+ * ******************* PrepareDirectSubdivision *******************
+ */
+
+template <class TArray, class TImage>
+bool
+UpsampleBSplineParametersFilter<TArray, TImage>::PrepareDirectSubdivision()
+{
+  /** The subdivision stencil of a B-spline of odd order n maps the control points
+   * of a grid with spacing h onto a grid with spacing h/2 that shares the knots.
+   * Even orders would need the refined control points at half-integer positions.
+   */
+  const unsigned int splineOrder = this->m_BSplineOrder;
+  if (!this->m_UseDirectSubdivision || splineOrder % 2 == 0 ||
+      this->m_CurrentGridDirection != this->m_RequiredGridDirection)
+  {
+    return false;
+  }
+
+  /** Check that the spacing is halved, and compute the offset (in units of the
+   * required spacing) of the required grid origin with respect to the current origin.
+   */
+  const auto    inverseDirection = this->m_CurrentGridDirection.GetInverse();
+  OffsetValueType originOffset[Dimension];
+  for (unsigned int d = 0; d < Dimension; ++d)
+  {
+    const double requiredSpacing = this->m_RequiredGridSpacing[d];
+    if (std::abs(this->m_CurrentGridSpacing[d] - 2.0 * requiredSpacing) > 1e-6 * requiredSpacing)
+    {
+      return false;
+    }
+
+    double offset = 0.0;
+    for (unsigned int c = 0; c < Dimension; ++c)
+    {
+      offset += inverseDirection(d, c) * (this->m_RequiredGridOrigin[c] - this->m_CurrentGridOrigin[c]);
+    }
+    offset /= requiredSpacing;
+    if (std::abs(offset - std::round(offset)) > 1e-4)
+    {
+      return false;
+    }
+    originOffset[d] = static_cast<OffsetValueType>(std::round(offset));
+  }
+
+  /** The stencil weights are binomial( n + 1, j ) / 2^n, for j = 0, ..., n + 1. */
+  std::vector<double> weights(splineOrder + 2, 1.0 / static_cast<double>(1u << splineOrder));
+  for (unsigned int j = 1; j <= splineOrder + 1; ++j)
+  {
+    weights[j] = weights[j - 1] * static_cast<double>(splineOrder + 2 - j) / static_cast<double>(j);
+  }
+
+  /** Floor division that also works for negative numbers. */
+  const auto floorDivideByTwo = [](const OffsetValueType value) {
+    return (value >= 0) ? (value / 2) : -((-value + 1) / 2);
+  };
+
+  /** For each required grid position, store the contributing current grid positions. */
+  const OffsetValueType halfSupport = static_cast<OffsetValueType>(splineOrder + 1) / 2;
+  for (unsigned int d = 0; d < Dimension; ++d)
+  {
+    const OffsetValueType currentBegin = this->m_CurrentGridRegion.GetIndex()[d];
+    const OffsetValueType currentEnd = currentBegin + static_cast<OffsetValueType>(this->m_CurrentGridRegion.GetSize()[d]);
+    const SizeValueType   requiredSize = this->m_RequiredGridRegion.GetSize()[d];
+
+    this->m_SubdivisionStencils[d].assign(requiredSize, std::vector<SubdivisionTermType>());
+    for (SizeValueType f = 0; f < requiredSize; ++f)
+    {
+      /** Current grid position k contributes to required grid position i with weight weights[ p - 2k ]. */
+      const OffsetValueType p =
+        this->m_RequiredGridRegion.GetIndex()[d] + static_cast<OffsetValueType>(f) + originOffset[d] + halfSupport;
+      const OffsetValueType kBegin =
+        std::max(floorDivideByTwo(p - static_cast<OffsetValueType>(splineOrder)), currentBegin);
+      const OffsetValueType kEnd = std::min(floorDivideByTwo(p) + 1, currentEnd);
+      for (OffsetValueType k = kBegin; k < kEnd; ++k)
+      {
+        this->m_SubdivisionStencils[d][f].emplace_back(static_cast<SizeValueType>(k - currentBegin), weights[p - 2 * k]);
+      }
+    }
+  }
+
+  return true;
+
+} // end PrepareDirectSubdivision()
+
+
+/**
+ * ******************* UpsampleParametersUsingSubdivision *******************
+ */
+
+template <class TArray, class TImage>
+void
+UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleParametersUsingSubdivision(const ArrayType & parameters_in,
+                                                                                    ArrayType &       parameters_out)
+{
+  parameters_out.SetSize(this->m_RequiredGridRegion.GetNumberOfPixels() * Dimension);
+
+  /** Launch multi-threaded computation. */
+  this->m_ThreaderParameters.st_InputParameters = parameters_in.data_block();
+  this->m_ThreaderParameters.st_OutputParameters = parameters_out.data_block();
+  this->m_Threader->SetSingleMethod(this->SubdivisionThreaderCallback, &this->m_ThreaderParameters);
+  this->m_Threader->SingleMethodExecute();
+
+} // end UpsampleParametersUsingSubdivision()
+
+
+/**
+ * ******************* SubdivisionThreaderCallback *******************
+ */
+
+template <class TArray, class TImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+UpsampleBSplineParametersFilter<TArray, TImage>::SubdivisionThreaderCallback(void * arg)
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *             infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType                 threadID = infoStruct->WorkUnitID;
+  MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedSubdivision(threadID);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end SubdivisionThreaderCallback()
+
+
+/**
+ * ******************* ThreadedSubdivision *******************
+ */
+
+template <class TArray, class TImage>
+void
+UpsampleBSplineParametersFilter<TArray, TImage>::ThreadedSubdivision(ThreadIdType threadId)
+{
+  const SizeValueType currentNumberOfPixels = this->m_CurrentGridRegion.GetNumberOfPixels();
+  const SizeValueType requiredNumberOfPixels = this->m_RequiredGridRegion.GetNumberOfPixels();
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  const ValueType *   parameters_in = this->m_ThreaderParameters.st_InputParameters;
+  ValueType *         parameters_out = this->m_ThreaderParameters.st_OutputParameters;
+
+  /** Get the required grid positions for this thread. */
+  const SizeValueType nrOfPixelsPerThread = (requiredNumberOfPixels + numberOfThreads - 1) / numberOfThreads;
+  const SizeValueType pos_begin = std::min(nrOfPixelsPerThread * threadId, requiredNumberOfPixels);
+  const SizeValueType pos_end = std::min(nrOfPixelsPerThread * (threadId + 1), requiredNumberOfPixels);
+
+  /** Offset table of the current grid. */
+  SizeValueType currentOffsetTable[Dimension];
+  currentOffsetTable[0] = 1;
+  for (unsigned int d = 1; d < Dimension; ++d)
+  {
+    currentOffsetTable[d] = currentOffsetTable[d - 1] * this->m_CurrentGridRegion.GetSize()[d - 1];
+  }
+
+  for (SizeValueType pos = pos_begin; pos < pos_end; ++pos)
+  {
+    /** Get the stencil of each dimension for this required grid position. */
+    const std::vector<SubdivisionTermType> * stencils[Dimension];
+    SizeValueType                            remainder = pos;
+    bool                                     hasSupport = true;
+    for (unsigned int d = 0; d < Dimension; ++d)
+    {
+      const SizeValueType size = this->m_RequiredGridRegion.GetSize()[d];
+      stencils[d] = &(this->m_SubdivisionStencils[d][remainder % size]);
+      remainder /= size;
+      hasSupport &= !stencils[d]->empty();
+    }
+
+    double values[Dimension] = {};
+    if (hasSupport)
+    {
+      /** Loop over the tensor product of the stencils. */
+      unsigned int counters[Dimension] = {};
+      bool         done = false;
+      while (!done)
+      {
+        double        weight = 1.0;
+        SizeValueType offset = 0;
+        for (unsigned int d = 0; d < Dimension; ++d)
+        {
+          const SubdivisionTermType & term = (*stencils[d])[counters[d]];
+          weight *= term.second;
+          offset += term.first * currentOffsetTable[d];
+        }
+        for (unsigned int j = 0; j < Dimension; ++j)
+        {
+          values[j] += weight * parameters_in[j * currentNumberOfPixels + offset];
+        }
+
+        /** Next combination. */
+        done = true;
+        for (unsigned int d = 0; d < Dimension; ++d)
+        {
+          if (++counters[d] < stencils[d]->size())
+          {
+            done = false;
+            break;
+          }
+          counters[d] = 0;
+        }
+      }
+    }
+
+    for (unsigned int j = 0; j < Dimension; ++j)
+    {
+      parameters_out[j * requiredNumberOfPixels + pos] = values[j];
+    }
+  }
+
+} // end ThreadedSubdivision()
+
+
 /**
  * ******************* DoUpsampling *******************
  */
@@ -189,6 +418,7 @@ UpsampleBSplineParametersFilter<TArray, TImage>::PrintSelf(std::ostream & os, In
   os << indent << "RequiredGridRegion: " << this->m_RequiredGridRegion << std::endl;
 
   os << indent << "BSplineOrder: " << this->m_BSplineOrder << std::endl;
+  os << indent << "UseDirectSubdivision: " << this->m_UseDirectSubdivision << std::endl;
 
 } // end PrintSelf()
 
@@ -38,6 +38,8 @@ PURPOSE.  See the above copyright notices for more information.
 #include "itkTransform.h"
 #include "itkVector.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -48,6 +50,12 @@ namespace itk
  * image and uses bilinear interpolation to integrate each plane of
  * voxels traversed.
  *
+ * Optionally, a coarse occupancy grid can be used to skip the parts of a
+ * ray that pass through blocks of voxels that are all below the threshold.
+ * These parts do not contribute to the integral, so the result is the same
+ * up to rounding. Call UpdateOccupancyGrid() after setting the input image,
+ * to (re)build the grid.
+ *
  * \warning This interpolator works for 3-dimensional images only.
  *
  * \ingroup ImageFunctions
@@ -143,6 +151,42 @@ public:
   OutputType
   EvaluateAtContinuousIndex(const ContinuousIndexType & index) const override;
 
+  /** Interpolate the image at a number of point positions at once.
+   *
+   * This gives the same results as calling Evaluate() for each point, but
+   * the bounding planes of the volume and the transformed focal point are
+   * computed only once for all points. It is meant for casting the rays of
+   * a whole line of detector pixels.
+   */
+  void
+  EvaluateRays(const PointType * points, OutputType * values, SizeValueType numberOfPoints) const;
+
+  /** The coarse occupancy grid. It stores, for each block of voxels, the
+   * maximum intensity of the block, including the first voxel of the next
+   * block in each direction, because the bilinear interpolation also uses those.
+   */
+  struct OccupancyGridType
+  {
+    int                 BlockSize{ 8 };
+    int                 NumberOfBlocks[3]{ 0, 0, 0 };
+    std::vector<double> BlockMaximum;
+  };
+
+  /** Set/Get whether empty space is skipped using the occupancy grid. Default: false. */
+  itkSetMacro(UseOccupancyGrid, bool);
+  itkGetConstMacro(UseOccupancyGrid, bool);
+  itkBooleanMacro(UseOccupancyGrid);
+
+  /** Set/Get the size (in voxels) of the blocks of the occupancy grid. Default: 8. */
+  itkSetClampMacro(OccupancyBlockSize, unsigned int, 1, NumericTraits<unsigned int>::max());
+  itkGetConstMacro(OccupancyBlockSize, unsigned int);
+
+  /** Build the occupancy grid of the input image, if it is used and
+   * if it is not yet up to date.
+   */
+  virtual void
+  UpdateOccupancyGrid();
+
   /** Connect the Transform. */
   itkSetObjectMacro(Transform, TransformType);
   /** Get a pointer to the Transform.  */
@@ -210,6 +254,10 @@ protected:
   /// Pointer to the interpolator
   InterpolatorPointer m_Interpolator;
 
+  /// Returns the occupancy grid if it is used and up to date, otherwise nullptr.
+  const OccupancyGridType *
+  GetValidOccupancyGrid() const;
+
 private:
   AdvancedRayCastInterpolateImageFunction(const Self &) = delete;
   void
@@ -225,6 +273,12 @@ private:
     }
     return input->GetLargestPossibleRegion().GetSize();
   }
+
+  bool                   m_UseOccupancyGrid{ false };
+  unsigned int           m_OccupancyBlockSize{ 8 };
+  OccupancyGridType      m_OccupancyGrid;
+  const InputImageType * m_OccupancyGridImage{ nullptr };
+  ModifiedTimeType       m_OccupancyGridImageMTime{ 0 };
 };
 
 } // namespace itk
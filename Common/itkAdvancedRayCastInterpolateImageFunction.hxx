@@ -38,6 +38,9 @@ PURPOSE.  See the above copyright notices for more information.
 
 #include <vnl/vnl_math.h>
 
+#include <algorithm> // For min and max.
+#include <limits>
+
 // Put the helper class in an anonymous namespace so that it is not
 // exposed to the user
 namespace
@@ -73,6 +76,9 @@ public:
   using PixelType = typename InputImageType::PixelType;
   using IndexType = typename InputImageType::IndexType;
 
+  using OccupancyGridType =
+    typename itk::AdvancedRayCastInterpolateImageFunction<TInputImage, TCoordRep>::OccupancyGridType;
+
   /**
    * Set the image class
    */
@@ -125,11 +131,13 @@ public:
    *
    * \param integral      The integrated intensities along the ray.
    * \param threshold     The integration threshold [default value: 0]
+   * \param occupancy     Optional occupancy grid, used to skip the planes
+   *                      of voxels that are all below the threshold.
    *
    * \return True if a valid ray was specified.
    */
   bool
-  IntegrateAboveThreshold(double & integral, double threshold);
+  IntegrateAboveThreshold(double & integral, double threshold, const OccupancyGridType * occupancy = nullptr);
 
   /** \brief
    * Increment each of the intensities of the 4 planar voxels
@@ -197,11 +205,19 @@ protected:
   AdjustRayLength();
 
   /**
-   *   Obtain pointers to the four voxels surrounding the point where the ray
-   *   enters the volume.
+   *   Obtain pointers to the four voxels surrounding the given point on the
+   *   ray, e.g. the point where the ray enters the volume.
    */
   void
-  InitialiseVoxelPointers();
+  InitialiseVoxelPointers(const double position[3]);
+
+  /**
+   *   Return the number of planes, starting at the current one, that the
+   *   ray certainly traverses within the current block of the occupancy grid,
+   *   or zero if that block contains intensities above the threshold.
+   */
+  int
+  GetNumberOfEmptyPlanes(const OccupancyGridType & occupancy, double threshold) const;
 
   /// Increment the voxel pointers surrounding the current point on the ray.
   void
@@ -1079,7 +1095,7 @@ RayCastHelper<TInputImage, TCoordRep>::Reset()
     {
       m_Position3Dvox[i] = m_RayVoxelStartPosition[i];
     }
-    this->InitialiseVoxelPointers();
+    this->InitialiseVoxelPointers(m_RayVoxelStartPosition);
   }
 
   // otherwise set parameters to zero
@@ -1120,16 +1136,16 @@ RayCastHelper<TInputImage, TCoordRep>::Reset()
 
 template <class TInputImage, class TCoordRep>
 void
-RayCastHelper<TInputImage, TCoordRep>::InitialiseVoxelPointers()
+RayCastHelper<TInputImage, TCoordRep>::InitialiseVoxelPointers(const double position[3])
 {
   IndexType index;
   index.Fill(0);
 
   int Ix, Iy, Iz;
 
-  Ix = (int)(m_RayVoxelStartPosition[0]);
-  Iy = (int)(m_RayVoxelStartPosition[1]);
-  Iz = (int)(m_RayVoxelStartPosition[2]);
+  Ix = (int)(position[0]);
+  Iy = (int)(position[1]);
+  Iz = (int)(position[2]);
 
   m_RayIntersectionVoxelIndex[0] = Ix;
   m_RayIntersectionVoxelIndex[1] = Iy;
@@ -1255,6 +1271,60 @@ RayCastHelper<TInputImage, TCoordRep>::InitialiseVoxelPointers()
 }
 
 
+/* -----------------------------------------------------------------------
+   GetNumberOfEmptyPlanes() - Count the planes that can be skipped
+   ----------------------------------------------------------------------- */
+
+template <class TInputImage, class TCoordRep>
+int
+RayCastHelper<TInputImage, TCoordRep>::GetNumberOfEmptyPlanes(const OccupancyGridType & occupancy,
+                                                              double                    threshold) const
+{
+  const int blockSize = occupancy.BlockSize;
+  int       block[3];
+
+  for (int i = 0; i < 3; ++i)
+  {
+    if (m_RayIntersectionVoxelIndex[i] < 0)
+    {
+      return 0;
+    }
+    block[i] = m_RayIntersectionVoxelIndex[i] / blockSize;
+    if (block[i] >= occupancy.NumberOfBlocks[i])
+    {
+      return 0;
+    }
+  }
+
+  const std::size_t blockIndex =
+    block[0] + occupancy.NumberOfBlocks[0] * (block[1] + occupancy.NumberOfBlocks[1] * std::size_t{ block[2] });
+  if (occupancy.BlockMaximum[blockIndex] > threshold)
+  {
+    return 0;
+  }
+
+  /* Count the planes until the ray leaves the block in any direction.
+     Rounding down is conservative: it may leave one empty plane, but it
+     never skips a plane of the next block. */
+
+  double numberOfPlanes = m_TotalRayVoxelPlanes - m_NumVoxelPlanesTraversed;
+  for (int i = 0; i < 3; ++i)
+  {
+    if (m_VoxelIncrement[i] > 0.)
+    {
+      numberOfPlanes =
+        std::min(numberOfPlanes, ((block[i] + 1) * blockSize - m_Position3Dvox[i]) / m_VoxelIncrement[i]);
+    }
+    else if (m_VoxelIncrement[i] < 0.)
+    {
+      numberOfPlanes = std::min(numberOfPlanes, (m_Position3Dvox[i] - block[i] * blockSize) / -m_VoxelIncrement[i]);
+    }
+  }
+
+  return (numberOfPlanes < 1.) ? 0 : static_cast<int>(numberOfPlanes);
+}
+
+
 /* -----------------------------------------------------------------------
    IncrementVoxelPointers() - Increment the voxel pointers
    ----------------------------------------------------------------------- */
@@ -1372,7 +1442,9 @@ RayCastHelper<TInputImage, TCoordRep>::IncrementIntensities(double increment)
 
 template <class TInputImage, class TCoordRep>
 bool
-RayCastHelper<TInputImage, TCoordRep>::IntegrateAboveThreshold(double & integral, double threshold)
+RayCastHelper<TInputImage, TCoordRep>::IntegrateAboveThreshold(double &                  integral,
+                                                               double                    threshold,
+                                                               const OccupancyGridType * occupancy)
 {
   double intensity;
   //  double posn3D_x, posn3D_y, posn3D_z;
@@ -1390,6 +1462,23 @@ RayCastHelper<TInputImage, TCoordRep>::IntegrateAboveThreshold(double & integral
 
   for (m_NumVoxelPlanesTraversed = 0; m_NumVoxelPlanesTraversed < m_TotalRayVoxelPlanes; ++m_NumVoxelPlanesTraversed)
   {
+    /* Jump over the planes within an empty block of the occupancy grid,
+       they do not contribute to the integral. */
+
+    if (occupancy != nullptr)
+    {
+      const int numberOfEmptyPlanes = this->GetNumberOfEmptyPlanes(*occupancy, threshold);
+      if (numberOfEmptyPlanes > 0)
+      {
+        m_Position3Dvox[0] += numberOfEmptyPlanes * m_VoxelIncrement[0];
+        m_Position3Dvox[1] += numberOfEmptyPlanes * m_VoxelIncrement[1];
+        m_Position3Dvox[2] += numberOfEmptyPlanes * m_VoxelIncrement[2];
+        this->InitialiseVoxelPointers(m_Position3Dvox);
+        m_NumVoxelPlanesTraversed += numberOfEmptyPlanes - 1;
+        continue;
+      }
+    }
+
     intensity = this->GetCurrentIntensity();
 
     if (intensity > threshold)
@@ -1508,6 +1597,8 @@ AdvancedRayCastInterpolateImageFunction<TInputImage, TCoordRep>::PrintSelf(std::
   os << indent << "FocalPoint: " << m_FocalPoint << std::endl;
   os << indent << "Transform: " << m_Transform.GetPointer() << std::endl;
   os << indent << "Interpolator: " << m_Interpolator.GetPointer() << std::endl;
+  os << indent << "UseOccupancyGrid: " << m_UseOccupancyGrid << std::endl;
+  os << indent << "OccupancyBlockSize: " << m_OccupancyBlockSize << std::endl;
 }
 
 
@@ -1519,21 +1610,140 @@ template <class TInputImage, class TCoordRep>
 auto
 AdvancedRayCastInterpolateImageFunction<TInputImage, TCoordRep>::Evaluate(const PointType & point) const -> OutputType
 {
-  double integral = 0;
+  OutputType value;
+  this->EvaluateRays(&point, &value, 1);
+
+  return value;
+}
 
-  OutputPointType transformedFocalPoint = m_Transform->TransformPoint(m_FocalPoint);
 
-  DirectionType direction = transformedFocalPoint - point;
+/* -----------------------------------------------------------------------
+   Evaluate at a number of point positions
+   ----------------------------------------------------------------------- */
+
+template <class TInputImage, class TCoordRep>
+void
+AdvancedRayCastInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateRays(const PointType * points,
+                                                                              OutputType *      values,
+                                                                              SizeValueType     numberOfPoints) const
+{
+  const OutputPointType transformedFocalPoint = m_Transform->TransformPoint(m_FocalPoint);
+  const auto            occupancy = this->GetValidOccupancyGrid();
+
+  /* The bounding planes and corners of the volume do not depend on the ray,
+     so the helper is initialised only once for all points. */
 
   RayCastHelper<TInputImage, TCoordRep> ray;
   ray.SetImage(this->m_Image);
   ray.ZeroState();
   ray.Initialise();
 
-  ray.SetRay(point, direction);
-  ray.IntegrateAboveThreshold(integral, m_Threshold);
+  for (SizeValueType i = 0; i < numberOfPoints; ++i)
+  {
+    double              integral = 0;
+    const DirectionType direction = transformedFocalPoint - points[i];
+
+    ray.SetRay(points[i], direction);
+    ray.IntegrateAboveThreshold(integral, m_Threshold, occupancy);
+
+    values[i] = static_cast<OutputType>(integral);
+  }
+}
+
+
+/* -----------------------------------------------------------------------
+   UpdateOccupancyGrid
+   ----------------------------------------------------------------------- */
+
+template <class TInputImage, class TCoordRep>
+void
+AdvancedRayCastInterpolateImageFunction<TInputImage, TCoordRep>::UpdateOccupancyGrid()
+{
+  const InputImageType * image = this->m_Image;
+  if (!m_UseOccupancyGrid || image == nullptr)
+  {
+    return;
+  }
+  if (image == m_OccupancyGridImage && image->GetMTime() == m_OccupancyGridImageMTime &&
+      static_cast<int>(m_OccupancyBlockSize) == m_OccupancyGrid.BlockSize)
+  {
+    return;
+  }
+
+  const SizeType size = image->GetLargestPossibleRegion().GetSize();
+  const int      blockSize = static_cast<int>(m_OccupancyBlockSize);
+  std::size_t    numberOfBlocks = 1;
+
+  m_OccupancyGrid.BlockSize = blockSize;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    m_OccupancyGrid.NumberOfBlocks[i] = (static_cast<int>(size[i]) + blockSize - 1) / blockSize;
+    numberOfBlocks *= m_OccupancyGrid.NumberOfBlocks[i];
+  }
+  m_OccupancyGrid.BlockMaximum.assign(numberOfBlocks, std::numeric_limits<double>::lowest());
+
+  /* A voxel on the lower border of a block also belongs to the previous block,
+     since the bilinear interpolation within that block uses it as well. */
+
+  const auto blocksOfVoxel = [blockSize](const int voxel, int blocks[2]) {
+    blocks[0] = voxel / blockSize;
+    blocks[1] = (voxel > 0 && voxel % blockSize == 0) ? blocks[0] - 1 : blocks[0];
+  };
+
+  const PixelType * voxel = image->GetBufferPointer();
+  const int *       numberOfBlocksPerDimension = m_OccupancyGrid.NumberOfBlocks;
+  for (int z = 0; z < static_cast<int>(size[2]); ++z)
+  {
+    int blocksZ[2];
+    blocksOfVoxel(z, blocksZ);
+    for (int y = 0; y < static_cast<int>(size[1]); ++y)
+    {
+      int blocksY[2];
+      blocksOfVoxel(y, blocksY);
+      for (int x = 0; x < static_cast<int>(size[0]); ++x, ++voxel)
+      {
+        int blocksX[2];
+        blocksOfVoxel(x, blocksX);
+
+        const double value = static_cast<double>(*voxel);
+        for (const int bz : blocksZ)
+        {
+          for (const int by : blocksY)
+          {
+            for (const int bx : blocksX)
+            {
+              double & blockMaximum =
+                m_OccupancyGrid.BlockMaximum[bx + numberOfBlocksPerDimension[0] *
+                                                    (by + numberOfBlocksPerDimension[1] * std::size_t{ bz })];
+              blockMaximum = std::max(blockMaximum, value);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  m_OccupancyGridImage = image;
+  m_OccupancyGridImageMTime = image->GetMTime();
+}
+
+
+/* -----------------------------------------------------------------------
+   GetValidOccupancyGrid
+   ----------------------------------------------------------------------- */
 
-  return (static_cast<OutputType>(integral));
+template <class TInputImage, class TCoordRep>
+auto
+AdvancedRayCastInterpolateImageFunction<TInputImage, TCoordRep>::GetValidOccupancyGrid() const
+  -> const OccupancyGridType *
+{
+  const InputImageType * image = this->m_Image;
+  if (m_UseOccupancyGrid && image != nullptr && image == m_OccupancyGridImage &&
+      image->GetMTime() == m_OccupancyGridImageMTime)
+  {
+    return &m_OccupancyGrid;
+  }
+  return nullptr;
 }
 
 
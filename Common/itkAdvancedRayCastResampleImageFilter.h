@@ -0,0 +1,95 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkAdvancedRayCastResampleImageFilter_h
+#define itkAdvancedRayCastResampleImageFilter_h
+
+#include "itkResampleImageFilter.h"
+#include "itkAdvancedRayCastInterpolateImageFunction.h"
+
+namespace itk
+{
+
+/**
+ * \class AdvancedRayCastResampleImageFilter
+ * \brief Resample filter that generates projections (DRRs) efficiently
+ * when used with the AdvancedRayCastInterpolateImageFunction.
+ *
+ * When the interpolator is an AdvancedRayCastInterpolateImageFunction, the
+ * output image is regarded as a detector, and its pixels are processed one
+ * line (detector row) at a time: the points of a row are transformed, and
+ * their rays are then cast in a single call to EvaluateRays(), which sets up
+ * the geometry of the volume only once per row. The rows are distributed over
+ * the threads. If the interpolator uses an occupancy grid, the grid is
+ * updated before the threads start.
+ *
+ * For any other interpolator, this filter behaves exactly like the
+ * ResampleImageFilter.
+ *
+ * \ingroup GeometricTransforms
+ */
+
+template <class TInputImage, class TOutputImage, class TCoordRep = double>
+class ITK_TEMPLATE_EXPORT AdvancedRayCastResampleImageFilter : public ResampleImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  using Self = AdvancedRayCastResampleImageFilter;
+  using Superclass = ResampleImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(AdvancedRayCastResampleImageFilter, ResampleImageFilter);
+
+  /** Typedefs from the superclass. */
+  using typename Superclass::InputImageType;
+  using typename Superclass::OutputImageType;
+  using typename Superclass::OutputImageRegionType;
+  using typename Superclass::PixelType;
+
+  /** Typedef of the ray cast interpolator. */
+  using RayCastInterpolatorType = AdvancedRayCastInterpolateImageFunction<InputImageType, TCoordRep>;
+
+protected:
+  AdvancedRayCastResampleImageFilter() = default;
+  ~AdvancedRayCastResampleImageFilter() override = default;
+
+  /** Update the occupancy grid of the ray cast interpolator, if it uses one. */
+  void
+  BeforeThreadedGenerateData() override;
+
+  /** Cast the rays of the detector rows in the given region. */
+  void
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
+
+private:
+  AdvancedRayCastResampleImageFilter(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkAdvancedRayCastResampleImageFilter.hxx"
+#endif
+
+#endif // end #ifndef itkAdvancedRayCastResampleImageFilter_h
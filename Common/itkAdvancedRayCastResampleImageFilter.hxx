@@ -0,0 +1,121 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkAdvancedRayCastResampleImageFilter_hxx
+#define itkAdvancedRayCastResampleImageFilter_hxx
+
+#include "itkAdvancedRayCastResampleImageFilter.h"
+
+#include "itkImageScanlineIterator.h"
+#include "itkNumericTraits.h"
+
+#include <algorithm> // For min and max.
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * ******************* BeforeThreadedGenerateData *******************
+ */
+
+template <class TInputImage, class TOutputImage, class TCoordRep>
+void
+AdvancedRayCastResampleImageFilter<TInputImage, TOutputImage, TCoordRep>::BeforeThreadedGenerateData()
+{
+  /** This connects the input image to the interpolator. */
+  this->Superclass::BeforeThreadedGenerateData();
+
+  /** The occupancy grid is shared by all threads, so it is built here. */
+  const auto rayCaster = dynamic_cast<RayCastInterpolatorType *>(this->GetInterpolator());
+  if (rayCaster != nullptr)
+  {
+    rayCaster->UpdateOccupancyGrid();
+  }
+
+} // end BeforeThreadedGenerateData()
+
+
+/**
+ * ******************* DynamicThreadedGenerateData *******************
+ */
+
+template <class TInputImage, class TOutputImage, class TCoordRep>
+void
+AdvancedRayCastResampleImageFilter<TInputImage, TOutputImage, TCoordRep>::DynamicThreadedGenerateData(
+  const OutputImageRegionType & outputRegionForThread)
+{
+  const auto rayCaster = dynamic_cast<const RayCastInterpolatorType *>(this->GetInterpolator());
+  if (rayCaster == nullptr)
+  {
+    this->Superclass::DynamicThreadedGenerateData(outputRegionForThread);
+    return;
+  }
+
+  if (outputRegionForThread.GetNumberOfPixels() == 0)
+  {
+    return;
+  }
+
+  using RayPointType = typename RayCastInterpolatorType::PointType;
+  using RayOutputType = typename RayCastInterpolatorType::OutputType;
+  using OutputPointType = typename Superclass::TransformType::InputPointType;
+
+  OutputImageType * outputPtr = this->GetOutput();
+  const auto        transform = this->GetTransform();
+
+  /** The ray cast interpolator does no bounds checking (its IsInsideBuffer()
+   * always returns true), so all pixels are cast, as in the superclass.
+   * The values are clamped to the range of the output pixel type.
+   */
+  const double minimumValue = static_cast<double>(NumericTraits<PixelType>::NonpositiveMin());
+  const double maximumValue = static_cast<double>(NumericTraits<PixelType>::max());
+
+  const SizeValueType        lineLength = outputRegionForThread.GetSize(0);
+  std::vector<RayPointType>  rayPoints(lineLength);
+  std::vector<RayOutputType> rayValues(lineLength);
+
+  ImageScanlineIterator<OutputImageType> outIt(outputPtr, outputRegionForThread);
+  while (!outIt.IsAtEnd())
+  {
+    /** Map the detector points of this row to the input space. */
+    SizeValueType   i = 0;
+    OutputPointType outputPoint;
+    for (; !outIt.IsAtEndOfLine(); ++outIt, ++i)
+    {
+      outputPtr->TransformIndexToPhysicalPoint(outIt.GetIndex(), outputPoint);
+      rayPoints[i].CastFrom(transform->TransformPoint(outputPoint));
+    }
+
+    /** Cast the rays of the complete row at once. */
+    rayCaster->EvaluateRays(rayPoints.data(), rayValues.data(), lineLength);
+
+    outIt.GoToBeginOfLine();
+    for (i = 0; !outIt.IsAtEndOfLine(); ++outIt, ++i)
+    {
+      const double value = static_cast<double>(rayValues[i]);
+      outIt.Set(static_cast<PixelType>(std::min(std::max(value, minimumValue), maximumValue)));
+    }
+    outIt.NextLine();
+  }
+
+} // end DynamicThreadedGenerateData()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkAdvancedRayCastResampleImageFilter_hxx
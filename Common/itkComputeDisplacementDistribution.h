@@ -26,6 +26,7 @@
 #include "itkImageFullSampler.h"
 #include "itkPlatformMultiThreader.h"
 
+#include <string>
 #include <vector>
 
 namespace itk
@@ -125,6 +126,18 @@ public:
     this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
   }
 
+  /** Get the number of threads. */
+  ThreadIdType
+  GetNumberOfWorkUnits() const
+  {
+    return this->m_Threader->GetNumberOfWorkUnits();
+  }
+
+  /** Get the time (in seconds) spent in the last computation on the exact gradient
+   * and the sampling of the fixed image, and on the loop over the Jacobians of the samples.
+   */
+  itkGetConstMacro(PreparationTime, double);
+  itkGetConstMacro(JacobianTime, double);
 
   virtual void
   BeforeThreadedCompute(const ParametersType & mu);
@@ -149,6 +162,8 @@ protected:
   DerivativeType                          m_ExactGradient;
   SizeValueType                           m_NumberOfParameters;
   ThreaderType::Pointer                   m_Threader;
+  double                                  m_PreparationTime;
+  double                                  m_JacobianTime;
 
   using FixedImageIndexType = typename FixedImageType::IndexType;
   using FixedImagePointType = typename FixedImageType::PointType;
@@ -206,8 +221,6 @@ protected:
   {
     /**  Used for accumulating variables. */
     double        st_MaxJJ;
-    double        st_Displacement;
-    double        st_DisplacementSquared;
     SizeValueType st_NumberOfPixelsCounted;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT, ComputePerThreadStruct, PaddedComputePerThreadStruct);
@@ -218,6 +231,13 @@ private:
 
   mutable std::vector<AlignedComputePerThreadStruct> m_ComputePerThreadVariables;
 
+  /** The displacement of each sample. The threads only write their own samples,
+   * after which the displacements are accumulated in sample order, so that the
+   * result does not depend on the number of threads.
+   */
+  std::vector<double> m_SampleDisplacements;
+  std::string         m_DisplacementEstimationMethod;
+
   SizeValueType               m_NumberOfPixelsCounted;
   bool                        m_UseMultiThread;
   ImageSampleContainerPointer m_SampleContainer;
@@ -31,6 +31,9 @@
 #include "itkMirrorPadImageFilter.h"
 #include "itkZeroFluxNeumannPadImageFilter.h"
 #include "itkSmoothingRecursiveGaussianImageFilter.h"
+#include "itkTimeProbe.h"
+
+#include <algorithm> // For max and sort.
 
 namespace itk
 {
@@ -48,6 +51,8 @@ ComputeDisplacementDistribution<TFixedImage, TTransform>::ComputeDisplacementDis
   this->m_FixedImageMask = nullptr;
   this->m_NumberOfJacobianMeasurements = 0;
   this->m_SampleContainer = nullptr;
+  this->m_PreparationTime = 0.0;
+  this->m_JacobianTime = 0.0;
 
   /** Threading related variables. */
   this->m_UseMultiThread = true;
@@ -235,19 +240,27 @@ ComputeDisplacementDistribution<TFixedImage, TTransform>::Compute(const Paramete
   {
     return this->ComputeSingleThreaded(mu, jacg, maxJJ, methods);
   }
-  // The multi-threaded route only supports methods == 2sigma for now
+  this->m_DisplacementEstimationMethod = methods;
 
   /** Initialize multi-threading. */
   this->InitializeThreadingParameters();
 
   /** Tackle stuff needed before multi-threading. */
+  TimeProbe timer;
+  timer.Start();
   this->BeforeThreadedCompute(mu);
+  timer.Stop();
+  this->m_PreparationTime = timer.GetMean();
 
   /** Launch multi-threaded computation. */
+  timer.Reset();
+  timer.Start();
   this->LaunchComputeThreaderCallback();
 
   /** Gather the jacg, maxJJ values from all threads. */
   this->AfterThreadedCompute(jacg, maxJJ);
+  timer.Stop();
+  this->m_JacobianTime = timer.GetMean();
 
 } // end Compute()
 
@@ -276,6 +289,9 @@ ComputeDisplacementDistribution<TFixedImage, TTransform>::BeforeThreadedCompute(
   /** Get samples. */
   this->SampleFixedImageForJacobianTerms(this->m_SampleContainer);
 
+  /** Allocate room for the displacement of each sample. */
+  this->m_SampleDisplacements.resize(this->m_SampleContainer->Size());
+
 } // end BeforeThreadedCompute()
 
 
@@ -355,15 +371,11 @@ ComputeDisplacementDistribution<TFixedImage, TTransform>::ThreadedCompute(Thread
   }
 
   /** Temporaries. */
-  // std::vector< double > JGG_k; not here so only mean + 2 sigma is supported
   DerivativeType Jgg(outdim);
   Jgg.Fill(0.0);
   const double  sqrt2 = std::sqrt(static_cast<double>(2.0));
   JacobianType  jacjjacj(outdim, outdim);
   double        maxJJ = 0.0;
-  double        jggMagnitude = 0.0;
-  double        displacement = 0.0;
-  double        displacementSquared = 0.0;
   unsigned long numberOfPixelsCounted = 0;
 
   /** Create iterator over the sample container. */
@@ -413,18 +425,14 @@ ComputeDisplacementDistribution<TFixedImage, TTransform>::ThreadedCompute(Thread
       Jgg(i) = temp;
     }
 
-    /** Sum the Jgg displacement for later use. */
-    jggMagnitude = Jgg.magnitude();
-    displacement += jggMagnitude;
-    displacementSquared += vnl_math::sqr(jggMagnitude);
+    /** Store the Jgg displacement for later use. */
+    this->m_SampleDisplacements[pos_begin + numberOfPixelsCounted] = Jgg.magnitude();
     numberOfPixelsCounted++;
   }
 
   /** Update the thread struct once. */
   AlignedComputePerThreadStruct computePerThreadStruct;
   computePerThreadStruct.st_MaxJJ = maxJJ;
-  computePerThreadStruct.st_Displacement = displacement;
-  computePerThreadStruct.st_DisplacementSquared = displacementSquared;
   computePerThreadStruct.st_NumberOfPixelsCounted = numberOfPixelsCounted;
   m_ComputePerThreadVariables[threadId] = computePerThreadStruct;
 } // end ThreadedCompute()
@@ -440,26 +448,42 @@ ComputeDisplacementDistribution<TFixedImage, TTransform>::AfterThreadedCompute(d
 {
   /** Reset all variables. */
   maxJJ = 0.0;
-  double displacement = 0.0;
-  double displacementSquared = 0.0;
   this->m_NumberOfPixelsCounted = 0.0;
 
-  /** Accumulate thread results. */
+  /** Accumulate thread results. The maximum does not depend on the order. */
   for (const auto & computePerThreadStruct : m_ComputePerThreadVariables)
   {
     maxJJ = std::max(maxJJ, computePerThreadStruct.st_MaxJJ);
-    displacement += computePerThreadStruct.st_Displacement;
-    displacementSquared += computePerThreadStruct.st_DisplacementSquared;
     this->m_NumberOfPixelsCounted += computePerThreadStruct.st_NumberOfPixelsCounted;
   }
   // Reset all variables for the next resolution.
   std::fill_n(m_ComputePerThreadVariables.begin(), m_ComputePerThreadVariables.size(), AlignedComputePerThreadStruct());
 
-  /** Compute the sigma of the distribution of the displacements. */
-  const double meanDisplacement = displacement / this->m_NumberOfPixelsCounted;
-  const double sigma = displacementSquared / this->m_NumberOfPixelsCounted - vnl_math::sqr(meanDisplacement);
+  std::vector<double> & displacements = this->m_SampleDisplacements;
+  if (this->m_DisplacementEstimationMethod == "95percentile" && displacements.size() > 2)
+  {
+    /** Compute the 95% percentile of the distribution of the displacements. */
+    const std::size_t d = std::min(static_cast<std::size_t>(displacements.size() * 0.95), displacements.size() - 2);
+    std::sort(displacements.begin(), displacements.end());
+    jacg = (displacements[d - 1] + displacements[d] + displacements[d + 1]) / 3.0;
+  }
+  else
+  {
+    /** Sum the displacements in sample order. */
+    double displacement = 0.0;
+    double displacementSquared = 0.0;
+    for (const double jggMagnitude : displacements)
+    {
+      displacement += jggMagnitude;
+      displacementSquared += vnl_math::sqr(jggMagnitude);
+    }
 
-  jacg = meanDisplacement + 2.0 * std::sqrt(sigma);
+    /** Compute the sigma of the distribution of the displacements. */
+    const double meanDisplacement = displacement / this->m_NumberOfPixelsCounted;
+    const double sigma = displacementSquared / this->m_NumberOfPixelsCounted - vnl_math::sqr(meanDisplacement);
+
+    jacg = meanDisplacement + 2.0 * std::sqrt(sigma);
+  }
 
 } // end AfterThreadedCompute()
 
@@ -21,6 +21,7 @@
 #include "itkStatisticsImageFilter.h"
 #include "itkSpatialObject.h"
 #include "itkImageMaskSpatialObject.h"
+#include "itkImageStatisticsCache.h"
 
 namespace itk
 {
@@ -37,6 +38,10 @@ namespace itk
  * threaded. It computes statistics in each thread then combines them in
  * its AfterThreadedGenerate method.
  *
+ * When UseCache is enabled, the statistics are stored in the
+ * ImageStatisticsCache, and later updates with the same input image, mask,
+ * and region take them from the cache instead of recomputing them.
+ *
  * \ingroup MathematicalStatisticsImageFilters
  * \ingroup ITKImageStatistics
  *
@@ -90,10 +95,34 @@ public:
   itkSetConstObjectMacro(ImageSpatialMask, ImageSpatialMaskType);
   itkGetConstObjectMacro(ImageSpatialMask, ImageSpatialMaskType);
 
+  /** Set/Get whether the statistics are looked up in, and stored in, the
+   * ImageStatisticsCache. Default: false.
+   */
+  itkSetMacro(UseCache, bool);
+  itkGetConstMacro(UseCache, bool);
+  itkBooleanMacro(UseCache);
+
+  /** The statistics that are stored in the ImageStatisticsCache. */
+  struct CachedStatisticsType
+  {
+    PixelType m_Minimum;
+    PixelType m_Maximum;
+    RealType  m_Mean;
+    RealType  m_Sigma;
+    RealType  m_Variance;
+    RealType  m_Sum;
+    RealType  m_SumOfSquares;
+  };
+  using StatisticsCacheType = ImageStatisticsCache<CachedStatisticsType>;
+
 protected:
   ComputeImageExtremaFilter();
   ~ComputeImageExtremaFilter() override = default;
 
+  /** Take the statistics from the cache, or compute them. */
+  void
+  GenerateData() override;
+
   /** Initialize some accumulators before the threads run. */
   void
   BeforeStreamedGenerateData() override;
@@ -117,6 +146,7 @@ protected:
   ImageSpatialMaskConstPointer m_ImageSpatialMask;
   bool                         m_UseMask;
   bool                         m_SameGeometry;
+  bool                         m_UseCache{ false };
 
 private:
   ComputeImageExtremaFilter(const Self &);
@@ -35,6 +35,59 @@ ComputeImageExtremaFilter<TInputImage>::ComputeImageExtremaFilter()
   this->m_SameGeometry = false;
 }
 
+/**
+ * ********************* GenerateData ****************************
+ */
+
+template <typename TInputImage>
+void
+ComputeImageExtremaFilter<TInputImage>::GenerateData()
+{
+  if (!this->m_UseCache)
+  {
+    Superclass::GenerateData();
+    return;
+  }
+
+  /** The mask that is used, if any. An image mask is identified by its image. */
+  const Object * mask = nullptr;
+  if (this->m_UseMask)
+  {
+    mask = this->GetImageSpatialMask() ? static_cast<const Object *>(this->GetImageSpatialMask()->GetImage())
+                                       : static_cast<const Object *>(this->GetImageMask());
+  }
+
+  const auto key = StatisticsCacheType::MakeKey(
+    this->GetInput(), this->GetInput()->GetBufferedRegion(), mask, { static_cast<double>(this->m_UseMask) });
+  auto & cache = StatisticsCacheType::GetInstance();
+
+  CachedStatisticsType statistics;
+  if (cache.Find(key, statistics))
+  {
+    this->SetMinimum(statistics.m_Minimum);
+    this->SetMaximum(statistics.m_Maximum);
+    this->SetMean(statistics.m_Mean);
+    this->SetSigma(statistics.m_Sigma);
+    this->SetVariance(statistics.m_Variance);
+    this->SetSum(statistics.m_Sum);
+    this->SetSumOfSquares(statistics.m_SumOfSquares);
+    return;
+  }
+
+  Superclass::GenerateData();
+
+  statistics.m_Minimum = this->GetMinimum();
+  statistics.m_Maximum = this->GetMaximum();
+  statistics.m_Mean = this->GetMean();
+  statistics.m_Sigma = this->GetSigma();
+  statistics.m_Variance = this->GetVariance();
+  statistics.m_Sum = this->GetSum();
+  statistics.m_SumOfSquares = this->GetSumOfSquares();
+  cache.Insert(key, statistics);
+
+} // end GenerateData()
+
+
 template <typename TInputImage>
 void
 ComputeImageExtremaFilter<TInputImage>::BeforeStreamedGenerateData()
@@ -83,6 +83,15 @@ public:
   itkSetClampMacro(ConditionNumber, double, 0.0, 10.0);
   itkGetConstReferenceMacro(ConditionNumber, double);
 
+  /** Set/get the maximum memory, in bytes, of the per-thread buffers of the preconditioner.
+   * Every work unit needs three buffers of the size of the number of parameters, so for
+   * large transforms the number of work units used for the accumulation is reduced to stay
+   * within this budget. Default 512 MiB. Note that the summation order, and therefore the
+   * last bits of the preconditioner, depend on the number of work units that is used.
+   */
+  itkSetMacro(MaximumBufferMemory, SizeValueType);
+  itkGetConstMacro(MaximumBufferMemory, SizeValueType);
+
   /** The main function that performs the computation.
    * DO NOT USE.
    */
@@ -139,11 +148,80 @@ protected:
   using typename Superclass::CoordinateRepresentationType;
   using typename Superclass::NumberOfParametersType;
 
-  double m_MaximumStepLength;
-  double m_RegularizationKappa;
-  double m_ConditionNumber;
+  using typename Superclass::ThreaderType;
+  using typename Superclass::ThreadInfoType;
+
+  double        m_MaximumStepLength;
+  double        m_RegularizationKappa;
+  double        m_ConditionNumber;
+  SizeValueType m_MaximumBufferMemory{ SizeValueType{ 512 } << 20 };
+
+  /** The ways in which the Jacobians of the samples are accumulated into the preconditioner. */
+  enum class AccumulationMethodEnum
+  {
+    DisplacementDistribution,
+    BSplineOnly,
+    JacobiType
+  };
+
+  /** Multi-threaded accumulation of the contributions of all samples to the preconditioner,
+   * the squared contributions and the bin counts. Every thread accumulates into its own
+   * buffers, which are summed in thread order afterwards. The number of threads is bounded
+   * by MaximumBufferMemory. The exact gradient is not used by the JacobiType method.
+   */
+  virtual void
+  AccumulatePreconditionerTerms(const AccumulationMethodEnum     method,
+                                const ImageSampleContainerType & sampleContainer,
+                                const DerivativeType *           exactgradient,
+                                const bool                       transformIsBSpline,
+                                double &                         maxJJ,
+                                ParametersType &                 preconditioner,
+                                std::vector<double> &            localStepSizeSquared,
+                                ParametersType &                 binCount);
+
+  /** Threader callback functions. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  AccumulatePreconditionerThreaderCallback(void * arg);
+
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ReducePreconditionerThreaderCallback(void * arg);
+
+  /** The threaded implementations of AccumulatePreconditionerTerms(). */
+  virtual void
+  ThreadedAccumulatePreconditioner(ThreadIdType threadId);
+
+  virtual void
+  ThreadedReducePreconditioner(ThreadIdType threadId);
+
+  /** To give the threads access to all member variables and functions. */
+  struct PreconditionerThreaderParameterType
+  {
+    Self *                           st_Self;
+    AccumulationMethodEnum           st_Method;
+    const ImageSampleContainerType * st_SampleContainer;
+    const DerivativeType *           st_ExactGradient;
+    bool                             st_TransformIsBSpline;
+    double *                         st_Preconditioner;
+    double *                         st_LocalStepSizeSquared;
+    double *                         st_BinCount;
+  };
+
+  struct PreconditionerPerThreadStruct
+  {
+    double              st_MaxJJ;
+    std::vector<double> st_Preconditioner;
+    std::vector<double> st_LocalStepSizeSquared;
+    std::vector<double> st_BinCount;
+  };
+  itkPadStruct(ITK_CACHE_LINE_ALIGNMENT, PreconditionerPerThreadStruct, PaddedPreconditionerPerThreadStruct);
+  itkAlignedTypedef(ITK_CACHE_LINE_ALIGNMENT,
+                    PaddedPreconditionerPerThreadStruct,
+                    AlignedPreconditionerPerThreadStruct);
 
 private:
+  PreconditionerThreaderParameterType               m_PreconditionerThreaderParameters;
+  std::vector<AlignedPreconditionerPerThreadStruct> m_PreconditionerPerThreadVariables;
+
   ComputePreconditionerUsingDisplacementDistribution(const Self &) = delete;
   void
   operator=(const Self &) = delete;
@@ -28,8 +28,10 @@
 #include "itkMirrorPadImageFilter.h"
 #include "itkZeroFluxNeumannPadImageFilter.h"
 #include "itkSmoothingRecursiveGaussianImageFilter.h"
+#include "itkTimeProbe.h"
 
-#include <cmath> // For abs.
+#include <algorithm> // For min and max.
+#include <cmath>     // For abs.
 
 
 namespace itk
@@ -91,11 +93,6 @@ ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::Com
   double &               maxJJ,
   ParametersType &       preconditioner)
 {
-// Select one of the following:
-//#define METHOD_BSPLINE 1 // weights method: 1's in middle, 0's on the outside (original code by Yuchuan)
-//#define METHOD_BSPLINE 2 // weights method: 1's everywhere
-#define METHOD_BSPLINE 3 // weights method: Use the Jacobian
-
   /** This function computes four terms needed for the automatic parameter
    * estimation using voxel displacement distribution estimation method.
    * The equation number refers to the SPIE paper.
@@ -108,188 +105,34 @@ ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::Com
   /** Get the exact gradient. Uses a random coordinate sampler with
    * NumberOfSamplesForPrecondition samples, which equals numberOfParameters.
    */
+  TimeProbe timer;
+  timer.Start();
   DerivativeType exactgradient(numberOfParameters);
   this->GetScaledDerivative(mu, exactgradient);
 
   /** Get samples. Uses a grid sampler with m_NumberOfJacobianMeasurements samples. */
   ImageSampleContainerPointer sampleContainer;
   this->SampleFixedImageForJacobianTerms(sampleContainer);
-  const SizeValueType nrofsamples = sampleContainer->Size();
-
-  /** Get transform and set current position. */
-  typename TransformType::Pointer transform = this->m_Transform;
-  const unsigned int              outdim = this->m_Transform->GetOutputSpaceDimension();
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
+  timer.Stop();
+  this->m_PreparationTime = timer.GetMean();
 
-  /** Variables for nonzerojacobian indices and the Jacobian. */
-  const SizeValueType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
-  JacobianType        jacj(outdim, sizejacind);
-  jacj.Fill(0.0);
-  NonZeroJacobianIndicesType jacind(sizejacind);
-
-  /**
-   * Compute jac * gradient
+  /** Accumulate the displacements of all samples in the support regions
+   * of the control points, using the Jacobian as weights.
    */
-  DerivativeType jacj_g(outdim);
-  jacj_g.Fill(0.0);
-  double globalDeformation = 0.0;
-  double globalDeformationSquare = 0.0;
-
+  timer.Reset();
+  timer.Start();
   std::vector<double> localStepSizeSquared(numberOfParameters, 0.0);
-
-  /** Create a compact region. */
-  // MS: Better cast transform to a B-spline transform and ask for
-  // spline order, which implicates support region size
-  // MS: why is all this needed?
-  // MS: ok, to have 1's in the middle and 0 in outer rim
-#if METHOD_BSPLINE == 1
-  auto                 compactImage = FixedImageType::New();
-  FixedImageRegionType supportRegion;
-  FixedImageRegionType compactRegion;
-
-  typename FixedImageRegionType::SizeType size;
-  unsigned int                            supportRegionSize = sizejacind / outdim;
-  double                                  supportRegionDimension = 1;
-  if (outdim == 3)
-  {
-    supportRegionDimension = std::cbrt(double(supportRegionSize));
-  }
-  else if (outdim == 2)
-  {
-    supportRegionDimension = vnl_math::sqr(double(supportRegionSize));
-  }
-  size.Fill(supportRegionDimension);
-
-  typename FixedImageRegionType::IndexType startIndex;
-  startIndex.Fill(0);
-  supportRegion.SetSize(size);
-  supportRegion.SetIndex(startIndex);
-
-  compactImage->SetRegions(supportRegion);
-  compactImage->Allocate();
-  compactImage->FillBuffer(0);
-
-  typename FixedImageRegionType::IndexType compactIndex;
-  compactIndex.Fill(1);
-  SizeValueType compactRegionDimension;
-  if (supportRegionDimension == 4)
-  {
-    compactRegionDimension = 2;
-  }
-  else
-  {
-    compactRegionDimension = supportRegionDimension - 1;
-  }
-  size.Fill(compactRegionDimension);
-  compactRegion.SetSize(size);
-  compactRegion.SetIndex(compactIndex);
-
-  itk::ImageRegionIterator<FixedImageType> compactImageIterator(compactImage, compactRegion);
-  int                                      testIter = 0;
-  while (!compactImageIterator.IsAtEnd())
-  {
-    compactImageIterator.Set(1);
-    ++compactImageIterator;
-  }
-  const FixedImagePixelType * compactSupportVector = compactImage->GetBufferPointer();
-#endif
-
-  /** Loop over all voxels in the sample container. */
-  ParametersType binCount(numberOfParameters, 0.0);
-  unsigned int   samplenr = 0; // needed for global value only
-
-  for (iter = begin; iter != end; ++iter)
-  {
-    /** Read fixed coordinates and get Jacobian. */
-    const FixedImagePointType & point = (*iter).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian(point, jacj, jacind);
-
-    /** Compute the product jac_j * gradient. */
-    for (unsigned int i = 0; i < outdim; ++i)
-    {
-      double temp = 0.0;
-      for (unsigned int j = 0; j < sizejacind; ++j)
-      {
-        int pj = jacind[j];
-        temp += jacj(i, j) * exactgradient(pj);
-      }
-
-      // Use the absolute value
-      jacj_g(i) = std::abs(temp);
-    }
-
-    /** A support region is where this voxel has the affect on the B-Spline
-     * grid mesh, which means each voxel has an influence on multiple grid
-     * control point, or means each control point is determined by multiple
-     * voxels.
-     */
-    for (unsigned int j = 0; j < sizejacind; ++j)
-    {
-      /** Select the only nonzero entry of the displacement jacj_g (B-spline specific). */
-      // const unsigned int nonzerodim = j / ( sizejacind / outdim );
-      // double displacement = jacj_g[ nonzerodim ];
-      // For the affine transform the nonzero dim would be different
-      // For a generic transform we would need the norm over all dimensions
-
-      unsigned int nonzerodim = j / outdim; // Affine, first 9 parameters
-      if (j >= outdim * outdim)
-        nonzerodim = j - outdim * outdim; // Affine, last 3
-      if (numberOfParameters > 13)
-        nonzerodim = j / (sizejacind / outdim); // B-spline
-
-      double displacement = jacj_g[nonzerodim];
-
-#if METHOD_BSPLINE == 1
-      /** Add the deformations on the compact support region. */
-      /** Count the numbers of the contributed voxels. */
-      if (compactSupportVector[j % supportRegionSize] > 0)
-      {
-        int pj = jacind[j];
-        preconditioner[pj] += displacement;
-        localStepSizeSquared[pj] += displacement * displacement;
-        binCount[pj] += 1;
-      }
-      // MS: as far as I understand the above code compactSupportVector[.] will
-      // be 1 in the middle and 0 in the outer rim.
-#elif METHOD_BSPLINE == 2
-      // MS: the following will be all 1 in the complete support region
-      int pj = jacind[j];
-      preconditioner[pj] += displacement;
-      localStepSizeSquared[pj] += displacement * displacement;
-      binCount[pj] += 1;
-#elif METHOD_BSPLINE == 3
-      // MS: the following will use the Jacobian as weights
-      const unsigned int pj = jacind[j];
-      const double       weight = std::abs(jacj(nonzerodim, j));
-      // YQ: the weight is positive.
-
-      /** localStepSize keeps track of the mean displacement.
-       * localStepSizeSquared keeps track of the standard deviation.
-       */
-      preconditioner[pj] += weight * displacement;
-      localStepSizeSquared[pj] += weight * displacement * displacement;
-      binCount[pj] += weight;
-#endif
-    }
-
-    /** Add them for global step size. */
-    double voxelDeformationTmp = jacj_g.magnitude();
-    globalDeformation += voxelDeformationTmp;
-    globalDeformationSquare += voxelDeformationTmp * voxelDeformationTmp;
-
-    ++samplenr;
-  } // end loop over sample container
-
-  /** Compute the sigma of the distribution of JGG_k.
-  double meanGlobalDeformation = globalDeformation / samplenr;
-  double global_sigma = globalDeformationSquare - meanGlobalDeformation * globalDeformation;
-  global_sigma /= ( nrofsamples - 1 ); // unbiased estimation
-  globalStepSize = meanGlobalDeformation + 2.0 * std::sqrt( global_sigma );
-  */
+  ParametersType      binCount(numberOfParameters, 0.0);
+  this->AccumulatePreconditionerTerms(AccumulationMethodEnum::BSplineOnly,
+                                      *sampleContainer,
+                                      &exactgradient,
+                                      false,
+                                      maxJJ,
+                                      preconditioner,
+                                      localStepSizeSquared,
+                                      binCount);
+  timer.Stop();
+  this->m_JacobianTime = timer.GetMean();
 
   /** Convert the local step sizes to a scaling factor. */
   unsigned int counter_tmp = 0;
@@ -359,22 +202,326 @@ ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::Com
   /** Get the exact gradient. Uses a random coordinate sampler with
    * NumberOfSamplesForPrecondition samples, which equals numberOfParameters.
    */
+  TimeProbe timer;
+  timer.Start();
   DerivativeType exactgradient(numberOfParameters);
   this->GetScaledDerivative(mu, exactgradient);
 
   /** Get samples. Uses a grid sampler with m_NumberOfJacobianMeasurements samples. */
   ImageSampleContainerPointer sampleContainer;
   this->SampleFixedImageForJacobianTerms(sampleContainer);
-  const SizeValueType nrofsamples = sampleContainer->Size();
+  timer.Stop();
+  this->m_PreparationTime = timer.GetMean();
 
-  /** Get transform and set current position. */
-  typename TransformType::Pointer transform = this->m_Transform;
-  const unsigned int              outdim = this->m_Transform->GetOutputSpaceDimension();
+  /** Accumulate the displacements due to a change in each parameter over all samples. */
+  timer.Reset();
+  timer.Start();
+  std::vector<double> localStepSizeSquared(numberOfParameters, 0.0);
+  ParametersType      binCount(numberOfParameters, 0.0);
+  this->AccumulatePreconditionerTerms(AccumulationMethodEnum::DisplacementDistribution,
+                                      *sampleContainer,
+                                      &exactgradient,
+                                      transformIsBSpline,
+                                      maxJJ,
+                                      preconditioner,
+                                      localStepSizeSquared,
+                                      binCount);
+  timer.Stop();
+  this->m_JacobianTime = timer.GetMean();
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
+  /** Compute the mean local step sizes and apply the 2 sigma rule. */
+  double maxEigenvalue = -1e+9;
+  double minEigenvalue = 1e+9;
+  for (unsigned int i = 0; i < numberOfParameters; ++i)
+  {
+    /** Mean deformation magnitude. */
+    double nonZeroBin = binCount[i];
+
+    const double meanLocalStepSize = preconditioner[i] / (nonZeroBin + 1e-14);
+    double       sigma = localStepSizeSquared[i] / (nonZeroBin + 1e-14) - meanLocalStepSize * meanLocalStepSize;
+
+    /** Due to numerical issues, in case of very small squared sums and means,
+     * the standard deviation may become negative. This happens for example in
+     * case of an affine transformation for the translational parameters.
+     */
+    if (sigma < 1e-14)
+      sigma = 0;
+
+    /** Apply the 2 sigma rule. */
+    double localStep = meanLocalStepSize + 2.0 * std::sqrt(sigma) + 1e-14;
+
+    minEigenvalue = std::min(localStep, minEigenvalue);
+    maxEigenvalue = std::max(localStep, maxEigenvalue);
+    preconditioner[i] = this->m_MaximumStepLength / localStep;
+
+  } // end loop over step size vector
+
+  /** Constrained the condition number into a given range, here we first try kappa = 2. */
+  double conditionNumber = maxEigenvalue / minEigenvalue;
+
+#if 1
+  elxout << std::scientific;
+  elxout << "The max eigen value is: [ ";
+  elxout << maxEigenvalue << " ";
+  elxout << "]" << std::endl;
+  elxout << "The min eigen value is: [ ";
+  elxout << minEigenvalue << " ";
+  elxout << "]" << std::endl;
+  elxout << "The condition number before constraints is: [ ";
+  elxout << conditionNumber << " ";
+  elxout << "]" << std::endl;
+  elxout << std::fixed;
+#endif
+
+  if (transformIsBSpline && conditionNumber > this->m_ConditionNumber)
+  {
+    minEigenvalue = maxEigenvalue / this->m_ConditionNumber;
+    for (unsigned int i = 0; i < numberOfParameters; ++i)
+    {
+      if (preconditioner[i] > this->m_MaximumStepLength / minEigenvalue)
+      {
+        preconditioner[i] = this->m_MaximumStepLength / minEigenvalue;
+      }
+    }
+  } // end condition number check.
+
+} // end Compute()
+
+
+/**
+ * ************************* ComputeJacobiTypePreconditioner ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::ComputeJacobiTypePreconditioner(
+  const ParametersType & mu,
+  double &               maxJJ,
+  ParametersType &       preconditioner)
+{
+  /** Initialize. */
+  maxJJ = 0.0;
+
+  /** Get the number of parameters. */
+  const unsigned int numberOfParameters = static_cast<unsigned int>(this->m_Transform->GetNumberOfParameters());
+
+  // Replace by a general check later.
+  bool transformIsBSpline = false;
+  if (numberOfParameters > 13)
+    transformIsBSpline = true; // assume B-spline
+
+  /** Get samples. Uses a grid sampler with m_NumberOfJacobianMeasurements samples. */
+  TimeProbe timer;
+  timer.Start();
+  ImageSampleContainerPointer sampleContainer;
+  this->SampleFixedImageForJacobianTerms(sampleContainer);
+  timer.Stop();
+  this->m_PreparationTime = timer.GetMean();
+
+  /** Accumulate the squared Jacobian entries of each parameter over all samples. */
+  timer.Reset();
+  timer.Start();
+  const unsigned int  outdim = this->m_Transform->GetOutputSpaceDimension();
+  std::vector<double> localStepSizeSquared(numberOfParameters, 0.0);
+  ParametersType      binCount(numberOfParameters, 0.0);
+  this->AccumulatePreconditionerTerms(AccumulationMethodEnum::JacobiType,
+                                      *sampleContainer,
+                                      nullptr,
+                                      transformIsBSpline,
+                                      maxJJ,
+                                      preconditioner,
+                                      localStepSizeSquared,
+                                      binCount);
+  timer.Stop();
+  this->m_JacobianTime = timer.GetMean();
+
+  double maxEigenvalue = -1e+9;
+  double minEigenvalue = 1e+9;
+  for (unsigned int i = 0; i < numberOfParameters; ++i)
+  {
+    double nonZeroBin = binCount[i] / outdim;
+    if (nonZeroBin > 0 && preconditioner[i] > 1e-9)
+    {
+      double eigenvalue = std::sqrt(preconditioner[i] / (nonZeroBin)) + 1e-14;
+      maxEigenvalue = std::max(eigenvalue, maxEigenvalue);
+      minEigenvalue = std::min(eigenvalue, minEigenvalue);
+      preconditioner[i] = 1.0 / eigenvalue;
+    }
+  }
+
+#if 0
+  elxout << std::scientific;
+  elxout << "The max eigen value is: [ ";
+  elxout << maxEigenvalue << " ";
+  elxout << "]" << std::endl;
+  elxout << "The min eigen value is: [ ";
+  elxout << minEigenvalue << " ";
+  elxout << "]" << std::endl;
+#endif
+
+  /** Condition number check. */
+  double conditionNumber = maxEigenvalue / minEigenvalue;
+
+  if (transformIsBSpline && conditionNumber > this->m_ConditionNumber)
+  {
+    minEigenvalue = maxEigenvalue / this->m_ConditionNumber;
+    for (unsigned int i = 0; i < numberOfParameters; ++i)
+    {
+      if (preconditioner[i] > 1.0 / minEigenvalue)
+      {
+        preconditioner[i] = 1.0 / minEigenvalue;
+      }
+    }
+  }
+
+#if 0
+  elxout << std::scientific;
+  elxout << "The condition number after constraints is: [ ";
+  elxout << maxEigenvalue / minEigenvalue << " ";
+  elxout << "]" << std::endl;
+  elxout << std::fixed;
+#endif
+} // end ComputeJacobiTypePreconditioner()
+
+
+/**
+ * ************************* AccumulatePreconditionerTerms ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::AccumulatePreconditionerTerms(
+  const AccumulationMethodEnum     method,
+  const ImageSampleContainerType & sampleContainer,
+  const DerivativeType *           exactgradient,
+  const bool                       transformIsBSpline,
+  double &                         maxJJ,
+  ParametersType &                 preconditioner,
+  std::vector<double> &            localStepSizeSquared,
+  ParametersType &                 binCount)
+{
+  /** Setup the threader parameters. */
+  PreconditionerThreaderParameterType & parameters = this->m_PreconditionerThreaderParameters;
+  parameters.st_Self = this;
+  parameters.st_Method = method;
+  parameters.st_SampleContainer = &sampleContainer;
+  parameters.st_ExactGradient = exactgradient;
+  parameters.st_TransformIsBSpline = transformIsBSpline;
+  parameters.st_Preconditioner = preconditioner.data_block();
+  parameters.st_LocalStepSizeSquared = localStepSizeSquared.data();
+  parameters.st_BinCount = binCount.data_block();
+
+  /** Each thread accumulates its samples into its own buffers of 3 x numberOfParameters
+   * doubles. Limit the number of threads, such that these buffers fit in the memory budget.
+   */
+  const ThreadIdType  numberOfWorkUnits = this->m_Threader->GetNumberOfWorkUnits();
+  const SizeValueType bytesPerThread = 3 * sizeof(double) * this->m_Transform->GetNumberOfParameters();
+  const SizeValueType maximumNumberOfThreads = std::max<SizeValueType>(1, this->m_MaximumBufferMemory / bytesPerThread);
+  const ThreadIdType  numberOfAccumulationThreads =
+    static_cast<ThreadIdType>(std::min<SizeValueType>(numberOfWorkUnits, maximumNumberOfThreads));
+
+  this->m_PreconditionerPerThreadVariables.resize(numberOfAccumulationThreads);
+  this->m_Threader->SetNumberOfWorkUnits(numberOfAccumulationThreads);
+  this->m_Threader->SetSingleMethod(this->AccumulatePreconditionerThreaderCallback, &parameters);
+  this->m_Threader->SingleMethodExecute();
+  this->m_Threader->SetNumberOfWorkUnits(numberOfWorkUnits);
+
+  /** Sum the buffers of all threads, in thread order, so that the result does not
+   * depend on the scheduling of the threads. This is also done multi-threaded.
+   */
+  this->m_Threader->SetSingleMethod(this->ReducePreconditionerThreaderCallback, &parameters);
+  this->m_Threader->SingleMethodExecute();
+
+  for (auto & perThreadVariables : this->m_PreconditionerPerThreadVariables)
+  {
+    maxJJ = std::max(maxJJ, perThreadVariables.st_MaxJJ);
+
+    /** Release the memory of the buffers. */
+    perThreadVariables = AlignedPreconditionerPerThreadStruct();
+  }
+
+} // end AccumulatePreconditionerTerms()
+
+
+/**
+ * ************************* AccumulatePreconditionerThreaderCallback ************************
+ */
+
+template <class TFixedImage, class TTransform>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::AccumulatePreconditionerThreaderCallback(
+  void * arg)
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *                      infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType                          threadID = infoStruct->WorkUnitID;
+  PreconditionerThreaderParameterType * temp = static_cast<PreconditionerThreaderParameterType *>(infoStruct->UserData);
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedAccumulatePreconditioner(threadID);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end AccumulatePreconditionerThreaderCallback()
+
+
+/**
+ * ************************* ReducePreconditionerThreaderCallback ************************
+ */
+
+template <class TFixedImage, class TTransform>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::ReducePreconditionerThreaderCallback(
+  void * arg)
+{
+  /** Get the current thread id and user data. */
+  ThreadInfoType *                      infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType                          threadID = infoStruct->WorkUnitID;
+  PreconditionerThreaderParameterType * temp = static_cast<PreconditionerThreaderParameterType *>(infoStruct->UserData);
+
+  /** Call the real implementation. */
+  temp->st_Self->ThreadedReducePreconditioner(threadID);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ReducePreconditionerThreaderCallback()
+
+
+/**
+ * ************************* ThreadedAccumulatePreconditioner ************************
+ */
+
+template <class TFixedImage, class TTransform>
+void
+ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::ThreadedAccumulatePreconditioner(
+  ThreadIdType threadId)
+{
+  const PreconditionerThreaderParameterType & parameters = this->m_PreconditionerThreaderParameters;
+  const AccumulationMethodEnum                method = parameters.st_Method;
+  const bool                                  transformIsBSpline = parameters.st_TransformIsBSpline;
+
+  /** Get sample container size, number of threads, and output space dimension. */
+  const SizeValueType sampleContainerSize = parameters.st_SampleContainer->Size();
+  const ThreadIdType  numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  const SizeValueType numberOfParameters = this->m_Transform->GetNumberOfParameters();
+  const unsigned int  outdim = this->m_Transform->GetOutputSpaceDimension();
+
+  /** Get the samples for this thread. */
+  const SizeValueType nrOfSamplesPerThreads = (sampleContainerSize + numberOfThreads - 1) / numberOfThreads;
+  const SizeValueType pos_begin = std::min(nrOfSamplesPerThreads * threadId, sampleContainerSize);
+  const SizeValueType pos_end = std::min(nrOfSamplesPerThreads * (threadId + 1), sampleContainerSize);
+
+  /** Initialize the buffers of this thread. This is done by the thread itself,
+   * to spread the work, and to keep the memory close to the thread.
+   */
+  AlignedPreconditionerPerThreadStruct & perThreadVariables = this->m_PreconditionerPerThreadVariables[threadId];
+  perThreadVariables.st_MaxJJ = 0.0;
+  perThreadVariables.st_Preconditioner.assign(numberOfParameters, 0.0);
+  perThreadVariables.st_LocalStepSizeSquared.assign(numberOfParameters, 0.0);
+  perThreadVariables.st_BinCount.assign(numberOfParameters, 0.0);
+  std::vector<double> & preconditioner = perThreadVariables.st_Preconditioner;
+  std::vector<double> & localStepSizeSquared = perThreadVariables.st_LocalStepSizeSquared;
+  std::vector<double> & binCount = perThreadVariables.st_BinCount;
 
   /** Variables for nonzerojacobian indices and the Jacobian. */
   const SizeValueType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
@@ -382,31 +529,101 @@ ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::Com
   jacj.Fill(0.0);
   NonZeroJacobianIndicesType jacind(sizejacind);
 
-  /** Declare temporary variables. Not needed for all methods. check later */
+  /** Declare temporary variables. */
   DerivativeType jacj_g(outdim);
   jacj_g.Fill(0.0);
-  JacobianType        jacjjacj(outdim, outdim);
-  const double        sqrt2 = std::sqrt(static_cast<double>(2.0));
-  std::vector<double> localStepSizeSquared(numberOfParameters, 0.0);
-  ParametersType      binCount(numberOfParameters);
-  binCount.Fill(0.0);
+  JacobianType jacjjacj(outdim, outdim);
+  const double sqrt2 = std::sqrt(static_cast<double>(2.0));
+  double       maxJJ = 0.0;
 
-  /** Loop over all voxels in the sample container. */
-  for (iter = begin; iter != end; ++iter)
+  /** Create iterator over the sample container. */
+  typename ImageSampleContainerType::ConstIterator threader_fiter;
+  typename ImageSampleContainerType::ConstIterator threader_fbegin = parameters.st_SampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator threader_fend = parameters.st_SampleContainer->Begin();
+  threader_fbegin += (int)pos_begin;
+  threader_fend += (int)pos_end;
+
+  /** Loop over the samples of this thread. */
+  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
   {
     /** Read fixed coordinates and get Jacobian. */
-    const FixedImagePointType & point = (*iter).Value().m_ImageCoordinates;
+    const FixedImagePointType & point = (*threader_fiter).Value().m_ImageCoordinates;
     this->m_Transform->GetJacobian(point, jacj, jacind);
 
-    /** Compute 1st part of JJ: ||J_j||_F^2. */
-    double JJ_j = vnl_math::sqr(jacj.frobenius_norm());
+    if (method != AccumulationMethodEnum::BSplineOnly)
+    {
+      /** Compute 1st part of JJ: ||J_j||_F^2. */
+      double JJ_j = vnl_math::sqr(jacj.frobenius_norm());
+
+      /** Compute 2nd part of JJ: 2\sqrt{2} || J_j J_j^T ||_F. */
+      vnl_fastops::ABt(jacjjacj, jacj, jacj);
+      JJ_j += 2.0 * sqrt2 * jacjjacj.frobenius_norm();
+
+      /** Max_j [JJ_j]. */
+      maxJJ = std::max(maxJJ, JJ_j);
+    }
+
+    if (method == AccumulationMethodEnum::JacobiType)
+    {
+      for (unsigned int i = 0; i < outdim; ++i)
+      {
+        for (unsigned int j = 0; j < sizejacind; ++j)
+        {
+          const unsigned int pj = jacind[j];
+          preconditioner[pj] += vnl_math::sqr(jacj(i, j));
+          binCount[pj] += 1;
+        }
+      }
+      continue;
+    }
+
+    const DerivativeType & exactgradient = *parameters.st_ExactGradient;
+
+    if (method == AccumulationMethodEnum::BSplineOnly)
+    {
+      /** Compute the product jac_j * gradient. */
+      for (unsigned int i = 0; i < outdim; ++i)
+      {
+        double temp = 0.0;
+        for (unsigned int j = 0; j < sizejacind; ++j)
+        {
+          int pj = jacind[j];
+          temp += jacj(i, j) * exactgradient(pj);
+        }
+
+        // Use the absolute value
+        jacj_g(i) = std::abs(temp);
+      }
+
+      /** A support region is where this voxel has the affect on the B-Spline
+       * grid mesh, which means each voxel has an influence on multiple grid
+       * control point, or means each control point is determined by multiple
+       * voxels.
+       */
+      for (unsigned int j = 0; j < sizejacind; ++j)
+      {
+        /** Select the only nonzero entry of the displacement jacj_g. */
+        unsigned int nonzerodim = j / outdim; // Affine, first 9 parameters
+        if (j >= outdim * outdim)
+          nonzerodim = j - outdim * outdim; // Affine, last 3
+        if (numberOfParameters > 13)
+          nonzerodim = j / (sizejacind / outdim); // B-spline
 
-    /** Compute 2nd part of JJ: 2\sqrt{2} || J_j J_j^T ||_F. */
-    vnl_fastops::ABt(jacjjacj, jacj, jacj);
-    JJ_j += 2.0 * sqrt2 * jacjjacj.frobenius_norm();
+        const double displacement = jacj_g[nonzerodim];
 
-    /** Max_j [JJ_j]. */
-    maxJJ = std::max(maxJJ, JJ_j);
+        /** Use the Jacobian as weights. The weight is positive. */
+        const unsigned int pj = jacind[j];
+        const double       weight = std::abs(jacj(nonzerodim, j));
+
+        /** localStepSize keeps track of the mean displacement.
+         * localStepSizeSquared keeps track of the standard deviation.
+         */
+        preconditioner[pj] += weight * displacement;
+        localStepSizeSquared[pj] += weight * displacement * displacement;
+        binCount[pj] += weight;
+      }
+      continue;
+    }
 
     double displacement2_j = 0.0;
     if (transformIsBSpline)
@@ -527,186 +744,46 @@ ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::Com
     }
   } // end loop over sample container
 
+  perThreadVariables.st_MaxJJ = maxJJ;
 
-  /** Compute the mean local step sizes and apply the 2 sigma rule. */
-  double maxEigenvalue = -1e+9;
-  double minEigenvalue = 1e+9;
-  for (unsigned int i = 0; i < numberOfParameters; ++i)
-  {
-    /** Mean deformation magnitude. */
-    double nonZeroBin = binCount[i];
-
-    const double meanLocalStepSize = preconditioner[i] / (nonZeroBin + 1e-14);
-    double       sigma = localStepSizeSquared[i] / (nonZeroBin + 1e-14) - meanLocalStepSize * meanLocalStepSize;
-
-    /** Due to numerical issues, in case of very small squared sums and means,
-     * the standard deviation may become negative. This happens for example in
-     * case of an affine transformation for the translational parameters.
-     */
-    if (sigma < 1e-14)
-      sigma = 0;
-
-    /** Apply the 2 sigma rule. */
-    double localStep = meanLocalStepSize + 2.0 * std::sqrt(sigma) + 1e-14;
-
-    minEigenvalue = std::min(localStep, minEigenvalue);
-    maxEigenvalue = std::max(localStep, maxEigenvalue);
-    preconditioner[i] = this->m_MaximumStepLength / localStep;
-
-  } // end loop over step size vector
-
-  /** Constrained the condition number into a given range, here we first try kappa = 2. */
-  double conditionNumber = maxEigenvalue / minEigenvalue;
-
-#if 1
-  elxout << std::scientific;
-  elxout << "The max eigen value is: [ ";
-  elxout << maxEigenvalue << " ";
-  elxout << "]" << std::endl;
-  elxout << "The min eigen value is: [ ";
-  elxout << minEigenvalue << " ";
-  elxout << "]" << std::endl;
-  elxout << "The condition number before constraints is: [ ";
-  elxout << conditionNumber << " ";
-  elxout << "]" << std::endl;
-  elxout << std::fixed;
-#endif
-
-  if (transformIsBSpline && conditionNumber > this->m_ConditionNumber)
-  {
-    minEigenvalue = maxEigenvalue / this->m_ConditionNumber;
-    for (unsigned int i = 0; i < numberOfParameters; ++i)
-    {
-      if (preconditioner[i] > this->m_MaximumStepLength / minEigenvalue)
-      {
-        preconditioner[i] = this->m_MaximumStepLength / minEigenvalue;
-      }
-    }
-  } // end condition number check.
-
-} // end Compute()
+} // end ThreadedAccumulatePreconditioner()
 
 
 /**
- * ************************* ComputeJacobiTypePreconditioner ************************
+ * ************************* ThreadedReducePreconditioner ************************
  */
 
 template <class TFixedImage, class TTransform>
 void
-ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::ComputeJacobiTypePreconditioner(
-  const ParametersType & mu,
-  double &               maxJJ,
-  ParametersType &       preconditioner)
+ComputePreconditionerUsingDisplacementDistribution<TFixedImage, TTransform>::ThreadedReducePreconditioner(
+  ThreadIdType threadId)
 {
-  /** Initialize. */
-  maxJJ = 0.0;
-
-  /** Get the number of parameters. */
-  const unsigned int numberOfParameters = static_cast<unsigned int>(this->m_Transform->GetNumberOfParameters());
-
-  // Replace by a general check later.
-  bool transformIsBSpline = false;
-  if (numberOfParameters > 13)
-    transformIsBSpline = true; // assume B-spline
-
-  /** Get samples. Uses a grid sampler with m_NumberOfJacobianMeasurements samples. */
-  ImageSampleContainerPointer sampleContainer;
-  this->SampleFixedImageForJacobianTerms(sampleContainer);
-  const SizeValueType nrofsamples = sampleContainer->Size();
-
-  /** Get transform and set current position. */
-  typename TransformType::Pointer transform = this->m_Transform;
-  const unsigned int              outdim = this->m_Transform->GetOutputSpaceDimension();
-
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator iter;
-  typename ImageSampleContainerType::ConstIterator begin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator end = sampleContainer->End();
-
-  /** Variables for nonzerojacobian indices and the Jacobian. */
-  const SizeValueType sizejacind = this->m_Transform->GetNumberOfNonZeroJacobianIndices();
-  JacobianType        jacj(outdim, sizejacind);
-  jacj.Fill(0.0);
-  JacobianType               jacjjacj(outdim, outdim);
-  const double               sqrt2 = std::sqrt(static_cast<double>(2.0));
-  NonZeroJacobianIndicesType jacind(sizejacind);
-  ParametersType             binCount(numberOfParameters, 0.0);
-
-  /** Loop over all voxels in the sample container. */
-  for (iter = begin; iter != end; ++iter)
-  {
-    /** Read fixed coordinates and get Jacobian. */
-    const FixedImagePointType & point = (*iter).Value().m_ImageCoordinates;
-    this->m_Transform->GetJacobian(point, jacj, jacind);
+  const PreconditionerThreaderParameterType & parameters = this->m_PreconditionerThreaderParameters;
+  const ThreadIdType                          numberOfThreads = this->m_Threader->GetNumberOfWorkUnits();
+  const SizeValueType                         numberOfParameters = this->m_Transform->GetNumberOfParameters();
 
-    /** Compute 1st part of JJ: ||J_j||_F^2. */
-    double JJ_j = vnl_math::sqr(jacj.frobenius_norm());
+  /** Get the parameters for this thread. */
+  const SizeValueType nrOfParametersPerThread = (numberOfParameters + numberOfThreads - 1) / numberOfThreads;
+  const SizeValueType pos_begin = std::min(nrOfParametersPerThread * threadId, numberOfParameters);
+  const SizeValueType pos_end = std::min(nrOfParametersPerThread * (threadId + 1), numberOfParameters);
 
-    /** Compute 2nd part of JJ: 2\sqrt{2} || J_j J_j^T ||_F. */
-    vnl_fastops::ABt(jacjjacj, jacj, jacj);
-    JJ_j += 2.0 * sqrt2 * jacjjacj.frobenius_norm();
-
-    /** Max_j [JJ_j]. */
-    maxJJ = std::max(maxJJ, JJ_j);
-
-    for (unsigned int i = 0; i < outdim; ++i)
-    {
-      for (unsigned int j = 0; j < sizejacind; ++j)
-      {
-        const unsigned int pj = jacind[j];
-        preconditioner[pj] += vnl_math::sqr(jacj(i, j));
-        binCount[pj] += 1;
-      }
-    }
-  }
-
-  double maxEigenvalue = -1e+9;
-  double minEigenvalue = 1e+9;
-  for (unsigned int i = 0; i < numberOfParameters; ++i)
-  {
-    double nonZeroBin = binCount[i] / outdim;
-    if (nonZeroBin > 0 && preconditioner[i] > 1e-9)
-    {
-      double eigenvalue = std::sqrt(preconditioner[i] / (nonZeroBin)) + 1e-14;
-      maxEigenvalue = std::max(eigenvalue, maxEigenvalue);
-      minEigenvalue = std::min(eigenvalue, minEigenvalue);
-      preconditioner[i] = 1.0 / eigenvalue;
-    }
-  }
-
-#if 0
-  elxout << std::scientific;
-  elxout << "The max eigen value is: [ ";
-  elxout << maxEigenvalue << " ";
-  elxout << "]" << std::endl;
-  elxout << "The min eigen value is: [ ";
-  elxout << minEigenvalue << " ";
-  elxout << "]" << std::endl;
-#endif
-
-  /** Condition number check. */
-  double conditionNumber = maxEigenvalue / minEigenvalue;
-
-  if (transformIsBSpline && conditionNumber > this->m_ConditionNumber)
+  for (SizeValueType i = pos_begin; i < pos_end; ++i)
   {
-    minEigenvalue = maxEigenvalue / this->m_ConditionNumber;
-    for (unsigned int i = 0; i < numberOfParameters; ++i)
+    double preconditioner = 0.0;
+    double localStepSizeSquared = 0.0;
+    double binCount = 0.0;
+    for (const auto & perThreadVariables : this->m_PreconditionerPerThreadVariables)
     {
-      if (preconditioner[i] > 1.0 / minEigenvalue)
-      {
-        preconditioner[i] = 1.0 / minEigenvalue;
-      }
+      preconditioner += perThreadVariables.st_Preconditioner[i];
+      localStepSizeSquared += perThreadVariables.st_LocalStepSizeSquared[i];
+      binCount += perThreadVariables.st_BinCount[i];
     }
+    parameters.st_Preconditioner[i] += preconditioner;
+    parameters.st_LocalStepSizeSquared[i] += localStepSizeSquared;
+    parameters.st_BinCount[i] += binCount;
   }
 
-#if 0
-  elxout << std::scientific;
-  elxout << "The condition number after constraints is: [ ";
-  elxout << maxEigenvalue / minEigenvalue << " ";
-  elxout << "]" << std::endl;
-  elxout << std::fixed;
-#endif
-} // end ComputeJacobiTypePreconditioner()
+} // end ThreadedReducePreconditioner()
 
 
 /**
@@ -18,7 +18,7 @@
 #ifndef itkGenericMultiResolutionPyramidImageFilter_h
 #define itkGenericMultiResolutionPyramidImageFilter_h
 
-#include "itkMultiResolutionPyramidImageFilter.h"
+#include "itkPerLevelMultiResolutionPyramidImageFilter.h"
 #include "itkSmoothingRecursiveGaussianImageFilter.h"
 
 namespace itk
@@ -96,7 +96,7 @@ namespace itk
  *
  * The GenericMultiResolutionPyramidImageFilter provides direct control to
  * compute only single level of the pyramid via SetCurrentLevel() and
- * SetComputeOnlyForCurrentLevel() methods.
+ * SetComputeOnlyForCurrentLevel() methods, see PerLevelMultiResolutionPyramidImageFilter.
  *
  * \author Denis P. Shamonin and Marius Staring. Division of Image Processing,
  * Department of Radiology, Leiden, The Netherlands
@@ -115,13 +115,13 @@ namespace itk
  */
 template <class TInputImage, class TOutputImage, class TPrecisionType = double>
 class ITK_TEMPLATE_EXPORT GenericMultiResolutionPyramidImageFilter
-  : public MultiResolutionPyramidImageFilter<TInputImage, TOutputImage>
+  : public PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>
 {
 public:
   /** Standard class typedefs. */
   using Self = GenericMultiResolutionPyramidImageFilter;
-  using Superclass = MultiResolutionPyramidImageFilter<TInputImage, TOutputImage>;
-  using SuperSuperclass = typename Superclass::Superclass;
+  using Superclass = PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>;
+  using SuperSuperclass = ImageToImageFilter<TInputImage, TOutputImage>;
   using Pointer = SmartPointer<Self>;
   using ConstPointer = SmartPointer<const Self>;
 
@@ -207,22 +207,6 @@ public:
   void
   SetNumberOfLevels(unsigned int num) override;
 
-  /** Set the current multi-resolution levels. The current level is clamped to
-   * a total number of levels.
-   */
-  virtual void
-  SetCurrentLevel(unsigned int level);
-
-  /** Get the current multi-resolution level. */
-  itkGetConstReferenceMacro(CurrentLevel, unsigned int);
-
-  /** Set a control on whether a current level will be used. */
-  virtual void
-  SetComputeOnlyForCurrentLevel(const bool _arg);
-
-  itkGetConstMacro(ComputeOnlyForCurrentLevel, bool);
-  itkBooleanMacro(ComputeOnlyForCurrentLevel);
-
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro(SameDimensionCheck, (Concept::SameDimension<ImageDimension, OutputImageDimension>));
@@ -264,13 +248,11 @@ protected:
   void
   GenerateData() override;
 
-  /** Release the output data when the current level is used. */
+  /** Copy the smoothing schedule and the rescale settings too. */
   void
-  ReleaseOutputs();
+  CopyPyramidSettingsTo(Superclass & pyramid) const override;
 
   SmoothingScheduleType m_SmoothingSchedule;
-  unsigned int          m_CurrentLevel;
-  bool                  m_ComputeOnlyForCurrentLevel;
   bool                  m_SmoothingScheduleDefined;
 
 private:
@@ -318,12 +300,6 @@ private:
   void
   SetSmoothingScheduleToDefault();
 
-  /** Checks whether we have to compute anything based on
-   * m_ComputeOnlyForCurrentLevel and m_CurrentLevel.
-   */
-  bool
-  ComputeForCurrentLevel(const unsigned int level) const;
-
   /** Backward compatibility method to compute default sigma value. */
   double
   GetDefaultSigma(const unsigned int   level,
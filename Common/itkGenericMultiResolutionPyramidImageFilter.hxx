@@ -58,8 +58,6 @@ template <class TInputImage, class TOutputImage, class TPrecisionType>
 GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionType>::
   GenericMultiResolutionPyramidImageFilter()
 {
-  this->m_CurrentLevel = 0;
-  this->m_ComputeOnlyForCurrentLevel = false;
   SmoothingScheduleType temp(this->GetNumberOfLevels(), ImageDimension);
   temp.Fill(NumericTraits<ScalarRealType>::ZeroValue());
   this->m_SmoothingSchedule = temp;
@@ -90,54 +88,6 @@ GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionTy
 } // end SetNumberOfLevels()
 
 
-/**
- * ******************* SetCurrentLevel ***********************
- */
-
-template <class TInputImage, class TOutputImage, class TPrecisionType>
-void
-GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionType>::SetCurrentLevel(unsigned int level)
-{
-  itkDebugMacro("setting CurrentLevel to " << level);
-  if (this->m_CurrentLevel != level)
-  {
-    // clamp value to be less then number of levels
-    this->m_CurrentLevel = level;
-    if (this->m_CurrentLevel >= this->m_NumberOfLevels)
-    {
-      // Safe this->m_NumberOfLevels always >= 1
-      this->m_CurrentLevel = this->m_NumberOfLevels - 1;
-    }
-    this->ReleaseOutputs();
-
-    /** Only set the modified flag for this filter if the output is computed per level. */
-    if (this->m_ComputeOnlyForCurrentLevel)
-    {
-      this->Modified();
-    }
-  }
-} // end SetCurrentLevel()
-
-
-/**
- * ******************* SetComputeOnlyForCurrentLevel ***********************
- */
-
-template <class TInputImage, class TOutputImage, class TPrecisionType>
-void
-GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionType>::SetComputeOnlyForCurrentLevel(
-  const bool _arg)
-{
-  itkDebugMacro("setting ComputeOnlyForCurrentLevel to " << _arg);
-  if (this->m_ComputeOnlyForCurrentLevel != _arg)
-  {
-    this->m_ComputeOnlyForCurrentLevel = _arg;
-    this->ReleaseOutputs();
-    this->Modified();
-  }
-} // end SetComputeOnlyForCurrentLevel()
-
-
 /**
  * ******************* SetSchedule ***********************
  */
@@ -304,7 +254,7 @@ GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionTy
         this->UpdateProgress(static_cast<float>(level) / static_cast<float>(this->m_NumberOfLevels));
       }
 
-      if (this->ComputeForCurrentLevel(level))
+      if (this->ComputeForCurrentLevel(level) && !this->GraftPrecomputedLevel(level))
       {
         OutputImagePointer outputPtr = this->GetOutput(level);
         outputPtr->SetBufferedRegion(input->GetLargestPossibleRegion());
@@ -336,7 +286,7 @@ GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionTy
       this->UpdateProgress(static_cast<float>(level) / static_cast<float>(this->m_NumberOfLevels));
     }
 
-    if (this->ComputeForCurrentLevel(level))
+    if (this->ComputeForCurrentLevel(level) && !this->GraftPrecomputedLevel(level))
     {
       // Allocate memory for each output
       OutputImagePointer outputPtr = this->GetOutput(level);
@@ -675,42 +625,23 @@ GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionTy
 
 
 /**
- * ******************* ReleaseOutputs ***********************
+ * ******************* CopyPyramidSettingsTo ***********************
  */
 
 template <class TInputImage, class TOutputImage, class TPrecisionType>
 void
-GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionType>::ReleaseOutputs()
+GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionType>::CopyPyramidSettingsTo(
+  Superclass & pyramid) const
 {
-  // release the memories if already has been allocated
-  for (unsigned int level = 0; level < this->m_NumberOfLevels; ++level)
-  {
-    if (this->m_ComputeOnlyForCurrentLevel && level != this->m_CurrentLevel)
-    {
-      this->GetOutput(level)->Initialize();
-    }
-  }
-} // end ReleaseOutputs()
+  Superclass::CopyPyramidSettingsTo(pyramid);
 
+  Self & copy = dynamic_cast<Self &>(pyramid);
+  copy.SetRescaleSchedule(this->m_Schedule);
+  copy.m_SmoothingSchedule = this->m_SmoothingSchedule;
+  copy.m_SmoothingScheduleDefined = this->m_SmoothingScheduleDefined;
+  copy.SetUseShrinkImageFilter(this->GetUseShrinkImageFilter());
 
-/**
- * ******************* ComputeForCurrentLevel ***********************
- */
-
-template <class TInputImage, class TOutputImage, class TPrecisionType>
-bool
-GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionType>::ComputeForCurrentLevel(
-  const unsigned int level) const
-{
-  if (!this->m_ComputeOnlyForCurrentLevel || (this->m_ComputeOnlyForCurrentLevel && level == this->m_CurrentLevel))
-  {
-    return true;
-  }
-  else
-  {
-    return false;
-  }
-} // end ComputeOnlyForCurrentLevel()
+} // end CopyPyramidSettingsTo()
 
 
 /**
@@ -907,9 +838,6 @@ GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionTy
 {
   Superclass::PrintSelf(os, indent);
 
-  os << indent << "CurrentLevel: " << this->m_CurrentLevel << std::endl;
-  os << indent << "ComputeOnlyForCurrentLevel: " << (this->m_ComputeOnlyForCurrentLevel ? "true" : "false")
-     << std::endl;
   os << indent << "SmoothingScheduleDefined: " << (this->m_SmoothingScheduleDefined ? "true" : "false") << std::endl;
   os << indent << "Smoothing Schedule: ";
   if (this->m_SmoothingSchedule.empty())
@@ -0,0 +1,205 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageStatisticsCache_h
+#define itkImageStatisticsCache_h
+
+#include "itkImageRegion.h"
+#include "itkObject.h"
+
+#include <list>
+#include <mutex>
+#include <utility> // For pair.
+#include <vector>
+
+namespace itk
+{
+/**
+ * \class ImageStatisticsCache
+ * \brief A small process-wide cache of statistics of images, like their
+ * extrema or moments.
+ *
+ * Computing statistics of large images, with a mask, takes a full pass over
+ * the image. When a registration initializes its metrics, such statistics are
+ * often computed several times for the same image: by several metrics, at
+ * each resolution, or in subsequent registrations of the same images. This
+ * cache lets each distinct computation run only once.
+ *
+ * The statistics are stored under a key, which consists of the address and
+ * the modification time of the image and of the mask, the region, and any
+ * further settings of the computation. As the modification times are unique
+ * within a process, a key never matches an image that has been changed (by
+ * calling Modified(), or by updating the pipeline that produced it), nor a
+ * new image at the address of a deleted one. Changing the pixel buffer
+ * directly, without calling Modified(), is not noticed.
+ *
+ * There is one cache for each type of statistics, obtained by GetInstance().
+ * When it holds MaximumNumberOfEntries entries, the least recently used entry
+ * is removed. A maximum of zero disables the cache. The cache is thread safe.
+ *
+ * \ingroup ITKImageStatistics
+ */
+
+template <class TStatistics>
+class ITK_TEMPLATE_EXPORT ImageStatisticsCache
+{
+public:
+  /** Standard class typedefs. */
+  using Self = ImageStatisticsCache;
+  using StatisticsType = TStatistics;
+
+  /** The key of an entry. */
+  struct KeyType
+  {
+    const void *                 m_Image{ nullptr };
+    ModifiedTimeType             m_ImageMTime{ 0 };
+    std::vector<OffsetValueType> m_Region;
+    const void *                 m_Mask{ nullptr };
+    ModifiedTimeType             m_MaskMTime{ 0 };
+    std::vector<double>          m_Settings;
+
+    bool
+    operator==(const KeyType & other) const
+    {
+      return m_Image == other.m_Image && m_ImageMTime == other.m_ImageMTime && m_Region == other.m_Region &&
+             m_Mask == other.m_Mask && m_MaskMTime == other.m_MaskMTime && m_Settings == other.m_Settings;
+    }
+  };
+
+  /** Create the key of the statistics of an image within a region, and
+   * optionally within a mask, computed with the given settings.
+   */
+  template <unsigned int VDimension>
+  static KeyType
+  MakeKey(const Object *                  image,
+          const ImageRegion<VDimension> & region,
+          const Object *                  mask = nullptr,
+          const std::vector<double> &     settings = std::vector<double>())
+  {
+    KeyType key;
+    key.m_Image = image;
+    key.m_ImageMTime = (image == nullptr) ? 0 : image->GetMTime();
+    for (unsigned int d = 0; d < VDimension; ++d)
+    {
+      key.m_Region.push_back(region.GetIndex()[d]);
+      key.m_Region.push_back(static_cast<OffsetValueType>(region.GetSize()[d]));
+    }
+    key.m_Mask = mask;
+    key.m_MaskMTime = (mask == nullptr) ? 0 : mask->GetMTime();
+    key.m_Settings = settings;
+    return key;
+  }
+
+  /** The cache of this type of statistics. */
+  static Self &
+  GetInstance()
+  {
+    static Self instance;
+    return instance;
+  }
+
+  /** Look up the statistics stored under the key. Returns false if there
+   * are none.
+   */
+  bool
+  Find(const KeyType & key, StatisticsType & statistics)
+  {
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto it = m_Entries.begin(); it != m_Entries.end(); ++it)
+    {
+      if (it->first == key)
+      {
+        /** Move the entry to the front, as the most recently used one. */
+        m_Entries.splice(m_Entries.begin(), m_Entries, it);
+        statistics = m_Entries.front().second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** Store the statistics under the key. */
+  void
+  Insert(const KeyType & key, const StatisticsType & statistics)
+  {
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Entries.remove_if([&key](const EntryType & entry) { return entry.first == key; });
+    m_Entries.emplace_front(key, statistics);
+    this->RemoveLeastRecentlyUsedEntries();
+  }
+
+  /** Remove all entries. */
+  void
+  Clear()
+  {
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Entries.clear();
+  }
+
+  /** The number of entries. */
+  std::size_t
+  GetNumberOfEntries() const
+  {
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Entries.size();
+  }
+
+  /** Set/Get the maximum number of entries. Default: 16. */
+  void
+  SetMaximumNumberOfEntries(const std::size_t maximumNumberOfEntries)
+  {
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+    m_MaximumNumberOfEntries = maximumNumberOfEntries;
+    this->RemoveLeastRecentlyUsedEntries();
+  }
+
+  std::size_t
+  GetMaximumNumberOfEntries() const
+  {
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_MaximumNumberOfEntries;
+  }
+
+  ImageStatisticsCache(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+protected:
+  ImageStatisticsCache() = default;
+  ~ImageStatisticsCache() = default;
+
+private:
+  using EntryType = std::pair<KeyType, StatisticsType>;
+
+  /** Assumes that the mutex is locked. */
+  void
+  RemoveLeastRecentlyUsedEntries()
+  {
+    while (m_Entries.size() > m_MaximumNumberOfEntries)
+    {
+      m_Entries.pop_back();
+    }
+  }
+
+  mutable std::mutex   m_Mutex;
+  std::list<EntryType> m_Entries;
+  std::size_t          m_MaximumNumberOfEntries{ 16 };
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkImageStatisticsCache_h
@@ -0,0 +1,165 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMemoryMappedFile.h"
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace itk
+{
+
+/**
+ * **************** Destructor *****************************
+ */
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+  this->Unmap();
+
+} // end Destructor
+
+
+/**
+ * **************** Map *****************************
+ */
+
+void
+MemoryMappedFile::Map(const std::string & fileName)
+{
+  this->Unmap();
+
+#ifdef _WIN32
+  const HANDLE fileHandle = CreateFileA(
+    fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (fileHandle == INVALID_HANDLE_VALUE)
+  {
+    itkExceptionMacro(<< "Could not open the file \"" << fileName << "\" for memory mapping.");
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+  {
+    CloseHandle(fileHandle);
+    itkExceptionMacro(<< "Could not map the file \"" << fileName << "\": it is empty, or its size is unknown.");
+  }
+
+  const HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  const void * data = (mappingHandle != nullptr) ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (data == nullptr)
+  {
+    if (mappingHandle != nullptr)
+    {
+      CloseHandle(mappingHandle);
+    }
+    CloseHandle(fileHandle);
+    itkExceptionMacro(<< "Could not map the file \"" << fileName << "\" into memory.");
+  }
+
+  this->m_FileHandle = fileHandle;
+  this->m_MappingHandle = mappingHandle;
+  this->m_Size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+  const int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+  if (fileDescriptor < 0)
+  {
+    itkExceptionMacro(<< "Could not open the file \"" << fileName << "\" for memory mapping.");
+  }
+
+  struct stat fileStatus;
+  if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+  {
+    close(fileDescriptor);
+    itkExceptionMacro(<< "Could not map the file \"" << fileName << "\": it is empty, or its size is unknown.");
+  }
+
+  const std::size_t size = static_cast<std::size_t>(fileStatus.st_size);
+  void *            data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+
+  /** The mapping stays valid after closing the file. */
+  close(fileDescriptor);
+  if (data == MAP_FAILED)
+  {
+    itkExceptionMacro(<< "Could not map the file \"" << fileName << "\" into memory.");
+  }
+
+  this->m_Size = size;
+#endif
+
+  this->m_Data = static_cast<const char *>(data);
+  this->m_FileName = fileName;
+  this->Modified();
+
+} // end Map()
+
+
+/**
+ * **************** Unmap *****************************
+ */
+
+void
+MemoryMappedFile::Unmap()
+{
+  if (this->m_Data == nullptr)
+  {
+    return;
+  }
+
+#ifdef _WIN32
+  UnmapViewOfFile(this->m_Data);
+  CloseHandle(this->m_MappingHandle);
+  CloseHandle(this->m_FileHandle);
+  this->m_MappingHandle = nullptr;
+  this->m_FileHandle = nullptr;
+#else
+  munmap(const_cast<char *>(this->m_Data), this->m_Size);
+#endif
+
+  this->m_Data = nullptr;
+  this->m_Size = 0;
+  this->m_FileName.clear();
+  this->Modified();
+
+} // end Unmap()
+
+
+/**
+ * **************** PrintSelf *****************************
+ */
+
+void
+MemoryMappedFile::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: " << this->m_FileName << std::endl;
+  os << indent << "Size: " << this->m_Size << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
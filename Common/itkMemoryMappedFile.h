@@ -0,0 +1,110 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkMemoryMappedFile_h
+#define itkMemoryMappedFile_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+
+#include <cstddef> // For size_t.
+#include <string>
+
+namespace itk
+{
+
+/**
+ * \class MemoryMappedFile
+ * \brief Maps a file read-only into memory.
+ *
+ * The pages of the file are only read from disk when they are accessed, and
+ * they are shared, via the page cache of the operating system, between all
+ * processes that map the same file. This allows several processes to use a
+ * very large file without each of them holding a private copy in memory.
+ *
+ * The file is unmapped when this object is destroyed, or by Unmap().
+ *
+ * \ingroup ITKCommon
+ */
+
+class MemoryMappedFile : public Object
+{
+public:
+  /** Standard ITK-stuff. */
+  using Self = MemoryMappedFile;
+  using Superclass = Object;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MemoryMappedFile, Object);
+
+  /** Map the complete file into memory. A previously mapped file is unmapped
+   * first. Throws an exception when the file cannot be mapped.
+   */
+  void
+  Map(const std::string & fileName);
+
+  /** Unmap the file, if any. */
+  void
+  Unmap();
+
+  /** The mapped contents of the file, or null when no file is mapped. */
+  const char *
+  GetData() const
+  {
+    return this->m_Data;
+  }
+
+  /** The size of the mapped file, in bytes. */
+  itkGetConstMacro(Size, std::size_t);
+
+  /** The name of the mapped file. */
+  itkGetConstReferenceMacro(FileName, std::string);
+
+protected:
+  /** The constructor. */
+  MemoryMappedFile() = default;
+  /** The destructor. */
+  ~MemoryMappedFile() override;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  MemoryMappedFile(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  const char * m_Data{ nullptr };
+  std::size_t  m_Size{ 0 };
+  std::string  m_FileName;
+
+#ifdef _WIN32
+  /** The handles of the file and of its mapping. */
+  void * m_FileHandle{ nullptr };
+  void * m_MappingHandle{ nullptr };
+#endif
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkMemoryMappedFile_h
@@ -37,7 +37,7 @@
 #ifndef itkMultiResolutionGaussianSmoothingPyramidImageFilter_h
 #define itkMultiResolutionGaussianSmoothingPyramidImageFilter_h
 
-#include "itkMultiResolutionPyramidImageFilter.h"
+#include "itkPerLevelMultiResolutionPyramidImageFilter.h"
 
 namespace itk
 {
@@ -114,6 +114,9 @@ namespace itk
  * This class is templated over the input image type and the output image
  * type.
  *
+ * Like the GenericMultiResolutionPyramidImageFilter, this filter can compute
+ * only a single level of the pyramid, see PerLevelMultiResolutionPyramidImageFilter.
+ *
  * This filter uses multithreaded filters to perform the smoothing.
  *
  * This filter supports streaming.
@@ -122,12 +125,12 @@ namespace itk
  */
 template <class TInputImage, class TOutputImage>
 class ITK_TEMPLATE_EXPORT MultiResolutionGaussianSmoothingPyramidImageFilter
-  : public MultiResolutionPyramidImageFilter<TInputImage, TOutputImage>
+  : public PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>
 {
 public:
   /** Standard class typedefs. */
   using Self = MultiResolutionGaussianSmoothingPyramidImageFilter;
-  using Superclass = MultiResolutionPyramidImageFilter<TInputImage, TOutputImage>;
+  using Superclass = PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>;
   using Pointer = SmartPointer<Self>;
   using ConstPointer = SmartPointer<const Self>;
 
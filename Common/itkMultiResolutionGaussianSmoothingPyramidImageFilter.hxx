@@ -130,6 +130,11 @@ MultiResolutionGaussianSmoothingPyramidImageFilter<TInputImage, TOutputImage>::G
 
   for (ilevel = 0; ilevel < this->m_NumberOfLevels; ++ilevel)
   {
+    // Skip the other levels, and use the output that was computed in the background, if available
+    if (!this->ComputeForCurrentLevel(ilevel) || this->GraftPrecomputedLevel(ilevel))
+    {
+      continue;
+    }
 
     this->UpdateProgress(static_cast<float>(ilevel) / static_cast<float>(this->m_NumberOfLevels));
 
@@ -216,7 +221,7 @@ void
 MultiResolutionGaussianSmoothingPyramidImageFilter<TInputImage, TOutputImage>::GenerateOutputInformation()
 {
   // call the supersuperclass's implementation of this method
-  using SuperSuperclass = typename Superclass::Superclass;
+  using SuperSuperclass = ImageToImageFilter<TInputImage, TOutputImage>;
   SuperSuperclass::GenerateOutputInformation();
 
   // get pointers to the input and output
@@ -255,7 +260,7 @@ MultiResolutionGaussianSmoothingPyramidImageFilter<TInputImage, TOutputImage>::G
   DataObject * refOutput)
 {
   // call the supersuperclass's implementation of this method
-  using SuperSuperclass = typename Superclass::Superclass;
+  using SuperSuperclass = ImageToImageFilter<TInputImage, TOutputImage>;
   SuperSuperclass::GenerateOutputRequestedRegion(refOutput);
 
   // find the index for this output
@@ -330,7 +335,7 @@ MultiResolutionGaussianSmoothingPyramidImageFilter<TInputImage, TOutputImage>::G
 {
   // call the supersuperclass's implementation of this method. This should
   // copy the output requested region to the input requested region
-  using SuperSuperclass = typename Superclass::Superclass;
+  using SuperSuperclass = ImageToImageFilter<TInputImage, TOutputImage>;
   SuperSuperclass::GenerateInputRequestedRegion();
 
   // This filter needs all of the input, because it uses the
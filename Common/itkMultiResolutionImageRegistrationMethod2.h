@@ -209,6 +209,14 @@ public:
   /** Get the current resolution level being processed. */
   itkGetConstMacro(CurrentLevel, unsigned long);
 
+  /** Set/Get the first resolution level that is optimized. The levels before
+   * it only invoke their IterationEvent, so that the components can prepare
+   * the next level, but are not optimized. Used to resume a registration.
+   * Default: 0.
+   */
+  itkSetMacro(FirstLevel, unsigned long);
+  itkGetConstMacro(FirstLevel, unsigned long);
+
   /** Set/Get the initial transformation parameters. */
   itkSetMacro(InitialTransformParameters, ParametersType);
   itkGetConstReferenceMacro(InitialTransformParameters, ParametersType);
@@ -303,6 +311,7 @@ private:
 
   unsigned long m_NumberOfLevels;
   unsigned long m_CurrentLevel;
+  unsigned long m_FirstLevel;
 };
 
 } // end namespace itk
@@ -69,6 +69,7 @@ MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::MultiResolut
 
   this->m_NumberOfLevels = 1;
   this->m_CurrentLevel = 0;
+  this->m_FirstLevel = 0;
 
   this->m_Stop = false;
 
@@ -308,6 +309,15 @@ MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::StartRegistr
         break;
       }
 
+      // Skip the optimization of the levels before the first level, but pass on
+      // their transform parameters, as if they were optimized in zero iterations
+      if (this->m_CurrentLevel < this->m_FirstLevel)
+      {
+        this->m_LastTransformParameters = this->m_Transform->GetParameters();
+        this->m_InitialTransformParametersOfNextLevel = this->m_LastTransformParameters;
+        continue;
+      }
+
       try
       {
         // initialize the interconnects between components
@@ -371,6 +381,7 @@ MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::PrintSelf(st
 
   os << indent << "NumberOfLevels: " << this->m_NumberOfLevels << std::endl;
   os << indent << "CurrentLevel: " << this->m_CurrentLevel << std::endl;
+  os << indent << "FirstLevel: " << this->m_FirstLevel << std::endl;
 
   os << indent << "InitialTransformParameters: " << this->m_InitialTransformParameters << std::endl;
   os << indent << "InitialTransformParametersOfNextLevel: " << this->m_InitialTransformParametersOfNextLevel
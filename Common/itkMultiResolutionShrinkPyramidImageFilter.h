@@ -18,7 +18,7 @@
 #ifndef itkMultiResolutionShrinkPyramidImageFilter_h
 #define itkMultiResolutionShrinkPyramidImageFilter_h
 
-#include "itkMultiResolutionPyramidImageFilter.h"
+#include "itkPerLevelMultiResolutionPyramidImageFilter.h"
 
 namespace itk
 {
@@ -31,18 +31,21 @@ namespace itk
  * No smoothing or any other operation is performed. This is useful for
  * example for registering binary images.
  *
+ * Like the GenericMultiResolutionPyramidImageFilter, this filter can compute
+ * only a single level of the pyramid, see PerLevelMultiResolutionPyramidImageFilter.
+ *
  * \sa ShrinkImageFilter
  *
  * \ingroup PyramidImageFilter Multithreaded Streamed
  */
 template <class TInputImage, class TOutputImage>
 class ITK_TEMPLATE_EXPORT MultiResolutionShrinkPyramidImageFilter
-  : public MultiResolutionPyramidImageFilter<TInputImage, TOutputImage>
+  : public PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>
 {
 public:
   /** Standard class typedefs. */
   using Self = MultiResolutionShrinkPyramidImageFilter;
-  using Superclass = MultiResolutionPyramidImageFilter<TInputImage, TOutputImage>;
+  using Superclass = PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>;
   using Pointer = SmartPointer<Self>;
   using ConstPointer = SmartPointer<const Self>;
 
@@ -42,6 +42,12 @@ MultiResolutionShrinkPyramidImageFilter<TInputImage, TOutputImage>::GenerateData
   unsigned int factors[ImageDimension];
   for (unsigned int ilevel = 0; ilevel < this->m_NumberOfLevels; ++ilevel)
   {
+    // Skip the other levels, and use the output that was computed in the background, if available
+    if (!this->ComputeForCurrentLevel(ilevel) || this->GraftPrecomputedLevel(ilevel))
+    {
+      continue;
+    }
+
     this->UpdateProgress(static_cast<float>(ilevel) / static_cast<float>(this->m_NumberOfLevels));
 
     // Allocate memory for each output
@@ -73,7 +79,7 @@ void
 MultiResolutionShrinkPyramidImageFilter<TInputImage, TOutputImage>::GenerateInputRequestedRegion()
 {
   // call the superclass' implementation of this method
-  Superclass::Superclass::GenerateInputRequestedRegion();
+  ImageToImageFilter<TInputImage, TOutputImage>::GenerateInputRequestedRegion();
 }
 
 
@@ -0,0 +1,134 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkPerLevelMultiResolutionPyramidImageFilter_h
+#define itkPerLevelMultiResolutionPyramidImageFilter_h
+
+#include "itkMultiResolutionPyramidImageFilter.h"
+
+#include <future>
+
+namespace itk
+{
+
+/** \class PerLevelMultiResolutionPyramidImageFilter
+ * \brief Base class of the pyramid filters that can compute a single level.
+ *
+ * Via SetCurrentLevel() and SetComputeOnlyForCurrentLevel(), only the output
+ * of the current level is computed, and the outputs of the other levels are
+ * released, which saves memory. In that mode, the next level may be computed
+ * in a background thread by PrecomputeLevelInBackground(), while the current
+ * level is being used.
+ *
+ * Subclasses check ComputeForCurrentLevel() and GraftPrecomputedLevel() for
+ * each level in their GenerateData().
+ *
+ * \ingroup PyramidImageFilter
+ */
+template <class TInputImage, class TOutputImage>
+class ITK_TEMPLATE_EXPORT PerLevelMultiResolutionPyramidImageFilter
+  : public MultiResolutionPyramidImageFilter<TInputImage, TOutputImage>
+{
+public:
+  /** Standard class typedefs. */
+  using Self = PerLevelMultiResolutionPyramidImageFilter;
+  using Superclass = MultiResolutionPyramidImageFilter<TInputImage, TOutputImage>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(PerLevelMultiResolutionPyramidImageFilter, MultiResolutionPyramidImageFilter);
+
+  /** Inherit types from Superclass. */
+  using typename Superclass::InputImageType;
+  using typename Superclass::OutputImagePointer;
+
+  /** Set the current multi-resolution level. The current level is clamped to
+   * the total number of levels. If ComputeOnlyForCurrentLevel is true, the
+   * outputs of the other levels are released.
+   */
+  virtual void
+  SetCurrentLevel(unsigned int level);
+
+  /** Get the current multi-resolution level. */
+  itkGetConstMacro(CurrentLevel, unsigned int);
+
+  /** Set/Get whether only the output of the current level is computed. Default: false. */
+  virtual void
+  SetComputeOnlyForCurrentLevel(const bool _arg);
+
+  itkGetConstMacro(ComputeOnlyForCurrentLevel, bool);
+  itkBooleanMacro(ComputeOnlyForCurrentLevel);
+
+  /** Start computing the output of the given level in a background thread,
+   * by a copy of this filter. The next update that computes this level
+   * waits for the result and grafts it, instead of computing it again.
+   */
+  virtual void
+  PrecomputeLevelInBackground(unsigned int level);
+
+protected:
+  PerLevelMultiResolutionPyramidImageFilter() = default;
+  ~PerLevelMultiResolutionPyramidImageFilter() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Copy the settings that determine the outputs to the given pyramid,
+   * which computes a level in the background. Subclasses with more settings
+   * should extend this method.
+   */
+  virtual void
+  CopyPyramidSettingsTo(Self & pyramid) const;
+
+  /** Release the output data of the levels other than the current level. */
+  void
+  ReleaseOutputs();
+
+  /** Checks whether the output of the level has to be computed, based on
+   * m_ComputeOnlyForCurrentLevel and m_CurrentLevel.
+   */
+  bool
+  ComputeForCurrentLevel(const unsigned int level) const;
+
+  /** Grafts the output of the level if it was computed in the background.
+   * Returns false if it was not.
+   */
+  bool
+  GraftPrecomputedLevel(const unsigned int level);
+
+  unsigned int m_CurrentLevel{ 0 };
+  bool         m_ComputeOnlyForCurrentLevel{ false };
+
+private:
+  PerLevelMultiResolutionPyramidImageFilter(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  /** The output of a level that is computed in the background. */
+  unsigned int                    m_PrecomputedLevel{ 0 };
+  const InputImageType *          m_PrecomputedInput{ nullptr };
+  std::future<OutputImagePointer> m_PrecomputedOutput;
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkPerLevelMultiResolutionPyramidImageFilter.hxx"
+#endif
+
+#endif
@@ -0,0 +1,203 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkPerLevelMultiResolutionPyramidImageFilter_hxx
+#define itkPerLevelMultiResolutionPyramidImageFilter_hxx
+
+#include "itkPerLevelMultiResolutionPyramidImageFilter.h"
+
+#include <algorithm> // For min.
+
+namespace itk
+{
+
+/**
+ * ******************* SetCurrentLevel ***********************
+ */
+
+template <class TInputImage, class TOutputImage>
+void
+PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>::SetCurrentLevel(unsigned int level)
+{
+  itkDebugMacro("setting CurrentLevel to " << level);
+
+  // clamp value to be less then number of levels; this->m_NumberOfLevels is always >= 1
+  level = std::min(level, this->m_NumberOfLevels - 1);
+  if (this->m_CurrentLevel != level)
+  {
+    this->m_CurrentLevel = level;
+    this->ReleaseOutputs();
+
+    /** Only set the modified flag for this filter if the output is computed per level. */
+    if (this->m_ComputeOnlyForCurrentLevel)
+    {
+      this->Modified();
+    }
+  }
+} // end SetCurrentLevel()
+
+
+/**
+ * ******************* SetComputeOnlyForCurrentLevel ***********************
+ */
+
+template <class TInputImage, class TOutputImage>
+void
+PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>::SetComputeOnlyForCurrentLevel(const bool _arg)
+{
+  itkDebugMacro("setting ComputeOnlyForCurrentLevel to " << _arg);
+  if (this->m_ComputeOnlyForCurrentLevel != _arg)
+  {
+    this->m_ComputeOnlyForCurrentLevel = _arg;
+    this->ReleaseOutputs();
+    this->Modified();
+  }
+} // end SetComputeOnlyForCurrentLevel()
+
+
+/**
+ * ******************* PrecomputeLevelInBackground ***********************
+ */
+
+template <class TInputImage, class TOutputImage>
+void
+PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>::PrecomputeLevelInBackground(unsigned int level)
+{
+  const InputImageType * input = this->GetInput();
+  if (input == nullptr)
+  {
+    itkExceptionMacro(<< "Input has not been set.");
+  }
+
+  /** The copy gets its own image object, sharing the pixel buffer, so that
+   * its pipeline does not interfere with the pipeline of this filter. */
+  const auto inputCopy = InputImageType::New();
+  inputCopy->Graft(input);
+
+  /** A filter of the same (most derived) type, with the same settings. */
+  const Pointer pyramid = dynamic_cast<Self *>(this->CreateAnother().GetPointer());
+  if (pyramid.IsNull())
+  {
+    itkExceptionMacro(<< "Could not create a copy of the pyramid.");
+  }
+  this->CopyPyramidSettingsTo(*pyramid);
+  pyramid->SetComputeOnlyForCurrentLevel(true);
+  pyramid->SetCurrentLevel(level);
+  pyramid->SetInput(inputCopy);
+
+  this->m_PrecomputedLevel = pyramid->GetCurrentLevel();
+  this->m_PrecomputedInput = input;
+  this->m_PrecomputedOutput = std::async(std::launch::async, [pyramid] {
+    pyramid->UpdateLargestPossibleRegion();
+    return OutputImagePointer(pyramid->GetOutput(pyramid->GetCurrentLevel()));
+  });
+
+} // end PrecomputeLevelInBackground()
+
+
+/**
+ * ******************* CopyPyramidSettingsTo ***********************
+ */
+
+template <class TInputImage, class TOutputImage>
+void
+PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>::CopyPyramidSettingsTo(Self & pyramid) const
+{
+  pyramid.SetNumberOfLevels(this->m_NumberOfLevels);
+  pyramid.SetSchedule(this->m_Schedule);
+
+} // end CopyPyramidSettingsTo()
+
+
+/**
+ * ******************* ReleaseOutputs ***********************
+ */
+
+template <class TInputImage, class TOutputImage>
+void
+PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>::ReleaseOutputs()
+{
+  // release the memories if already has been allocated
+  for (unsigned int level = 0; level < this->m_NumberOfLevels; ++level)
+  {
+    if (this->m_ComputeOnlyForCurrentLevel && level != this->m_CurrentLevel && this->GetOutput(level))
+    {
+      this->GetOutput(level)->Initialize();
+    }
+  }
+} // end ReleaseOutputs()
+
+
+/**
+ * ******************* ComputeForCurrentLevel ***********************
+ */
+
+template <class TInputImage, class TOutputImage>
+bool
+PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>::ComputeForCurrentLevel(
+  const unsigned int level) const
+{
+  return !this->m_ComputeOnlyForCurrentLevel || level == this->m_CurrentLevel;
+
+} // end ComputeForCurrentLevel()
+
+
+/**
+ * ******************* GraftPrecomputedLevel ***********************
+ */
+
+template <class TInputImage, class TOutputImage>
+bool
+PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>::GraftPrecomputedLevel(const unsigned int level)
+{
+  if (!this->m_PrecomputedOutput.valid() || this->m_PrecomputedLevel != level)
+  {
+    return false;
+  }
+
+  /** Wait for the background computation to finish. */
+  const OutputImagePointer precomputedOutput = this->m_PrecomputedOutput.get();
+  if (this->m_PrecomputedInput != this->GetInput())
+  {
+    return false;
+  }
+
+  this->GraftNthOutput(level, precomputedOutput.GetPointer());
+  return true;
+
+} // end GraftPrecomputedLevel()
+
+
+/**
+ * ******************* PrintSelf ***********************
+ */
+
+template <class TInputImage, class TOutputImage>
+void
+PerLevelMultiResolutionPyramidImageFilter<TInputImage, TOutputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "CurrentLevel: " << this->m_CurrentLevel << std::endl;
+  os << indent << "ComputeOnlyForCurrentLevel: " << (this->m_ComputeOnlyForCurrentLevel ? "true" : "false")
+     << std::endl;
+} // end PrintSelf()
+
+
+} // namespace itk
+
+#endif
@@ -80,6 +80,34 @@ public:
   using typename Superclass2::RegistrationType;
   using ITKBaseType = typename Superclass2::ITKBaseType;
 
+  /** This pyramid can compute its images per resolution. */
+  bool
+  SupportsComputePerResolution() const override
+  {
+    return true;
+  }
+
+  /** Compute only the images of the current resolution, or all at once. */
+  void
+  SetComputePerResolution(const bool computePerResolution) override
+  {
+    this->SetComputeOnlyForCurrentLevel(computePerResolution);
+  }
+
+  /** Let the pyramid filter know that we are in a next level. */
+  void
+  SetCurrentResolution(const unsigned int level) override
+  {
+    this->SetCurrentLevel(level);
+  }
+
+  /** Start computing the images of the given resolution in the background. */
+  void
+  PrecomputeResolutionInBackground(const unsigned int level) override
+  {
+    this->PrecomputeLevelInBackground(level);
+  }
+
 protected:
   /** The constructor. */
   FixedSmoothingPyramid() = default;
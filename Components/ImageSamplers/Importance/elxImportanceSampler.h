@@ -0,0 +1,154 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxImportanceSampler_h
+#define elxImportanceSampler_h
+
+#include "elxIncludes.h" // include first to avoid MSVS warning
+#include "itkImageImportanceSampler.h"
+
+namespace elastix
+{
+
+/**
+ * \class ImportanceSampler
+ * \brief An image sampler based on the itk::ImageImportanceSampler.
+ *
+ * This image sampler randomly samples 'NumberOfSamples' voxels in
+ * the InputImageRegion, with a probability proportional to the gradient
+ * magnitude of the fixed image, or to a user-supplied weight image. Few
+ * samples are therefore spent in homogeneous regions, which hardly contribute
+ * to the metric derivative. Each sample carries an importance weight, which
+ * compensates for the non-uniform sampling.
+ *
+ * The importance weights are used by the AdvancedMattesMutualInformation
+ * metric (with UseFastAndLowMemoryVersion "true" and without finite difference
+ * derivatives) and by the AdvancedMeanSquares metric. The other versions of the
+ * AdvancedMattesMutualInformation metric are rejected. Other metrics ignore
+ * them, which biases these metrics towards the regions that are sampled most.
+ *
+ * This sampler is suitable to used in combination with the
+ * NewSamplesEveryIteration parameter (defined in the elx::OptimizerBase).
+ *
+ * The parameters used in this class are:
+ * \parameter ImageSampler: Select this image sampler as follows:\n
+ *    <tt>(ImageSampler "Importance")</tt>
+ * \parameter NumberOfSpatialSamples: The number of image voxels used for computing the
+ *    metric value and its derivative in each iteration. Must be given for each resolution.\n
+ *    example: <tt>(NumberOfSpatialSamples 2048 2048 4000)</tt> \n
+ *    The default is 5000.
+ * \parameter UniformSamplingFraction: The fraction of the sampling density that is spread
+ *    uniformly over the voxels. This bounds the importance weights. 0 samples purely by the
+ *    gradient magnitude or weight image, 1 samples uniformly. Can be given for each resolution.\n
+ *    example: <tt>(UniformSamplingFraction 0.2 0.1 0.1)</tt> \n
+ *    The default is 0.1.
+ * \parameter ImportanceWeightImageName: An image that defines the sampling density instead of
+ *    the gradient magnitude of the fixed image. It is interpolated at the voxel positions of
+ *    each resolution, so it does not need to have the same size as the fixed image.\n
+ *    example: <tt>(ImportanceWeightImageName "weights.mhd")</tt> \n
+ *    By default, the gradient magnitude of the fixed image is used.
+ *
+ * \ingroup ImageSamplers
+ */
+
+template <class TElastix>
+class ITK_TEMPLATE_EXPORT ImportanceSampler
+  : public itk::ImageImportanceSampler<typename elx::ImageSamplerBase<TElastix>::InputImageType>
+  , public elx::ImageSamplerBase<TElastix>
+{
+public:
+  /** Standard ITK-stuff. */
+  using Self = ImportanceSampler;
+  using Superclass1 = itk::ImageImportanceSampler<typename elx::ImageSamplerBase<TElastix>::InputImageType>;
+  using Superclass2 = elx::ImageSamplerBase<TElastix>;
+  using Pointer = itk::SmartPointer<Self>;
+  using ConstPointer = itk::SmartPointer<const Self>;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImportanceSampler, itk::ImageImportanceSampler);
+
+  /** Name of this class.
+   * Use this name in the parameter file to select this specific image sampler. \n
+   * example: <tt>(ImageSampler "Importance")</tt>\n
+   */
+  elxClassNameMacro("Importance");
+
+  /** Typedefs inherited from the superclass. */
+  using typename Superclass1::DataObjectPointer;
+  using typename Superclass1::OutputVectorContainerType;
+  using typename Superclass1::OutputVectorContainerPointer;
+  using typename Superclass1::InputImageType;
+  using typename Superclass1::InputImagePointer;
+  using typename Superclass1::InputImageConstPointer;
+  using typename Superclass1::InputImageRegionType;
+  using typename Superclass1::InputImagePixelType;
+  using typename Superclass1::ImageSampleType;
+  using typename Superclass1::ImageSampleContainerType;
+  using typename Superclass1::MaskType;
+  using typename Superclass1::InputImageIndexType;
+  using typename Superclass1::InputImagePointType;
+  using typename Superclass1::WeightImageType;
+
+  /** The input image dimension. */
+  itkStaticConstMacro(InputImageDimension, unsigned int, Superclass1::InputImageDimension);
+
+  /** Typedefs inherited from Elastix. */
+  using typename Superclass2::ElastixType;
+  using typename Superclass2::RegistrationType;
+  using ITKBaseType = typename Superclass2::ITKBaseType;
+
+  /** Execute stuff before the registration:
+   * \li Read the weight image, if given.
+   * \li Check the AdvancedMattesMutualInformation settings, and warn about
+   *     metrics that do not use the importance weights.
+   */
+  void
+  BeforeRegistration() override;
+
+  /** Execute stuff before each resolution:
+   * \li Set the number of samples.
+   * \li Set the uniform sampling fraction.
+   */
+  void
+  BeforeEachResolution() override;
+
+protected:
+  /** The constructor. */
+  ImportanceSampler() = default;
+  /** The destructor. */
+  ~ImportanceSampler() override = default;
+
+private:
+  elxOverrideGetSelfMacro;
+
+  /** The deleted copy constructor. */
+  ImportanceSampler(const Self &) = delete;
+  /** The deleted assignment operator. */
+  void
+  operator=(const Self &) = delete;
+};
+
+} // end namespace elastix
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "elxImportanceSampler.hxx"
+#endif
+
+#endif // end #ifndef elxImportanceSampler_h
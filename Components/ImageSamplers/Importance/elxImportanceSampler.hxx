@@ -0,0 +1,137 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxImportanceSampler_hxx
+#define elxImportanceSampler_hxx
+
+#include "elxImportanceSampler.h"
+#include "itkChangeInformationImageFilter.h"
+
+namespace elastix
+{
+
+/**
+ * ******************* BeforeRegistration ******************
+ */
+
+template <class TElastix>
+void
+ImportanceSampler<TElastix>::BeforeRegistration()
+{
+  /** Read the weight image, if desired. */
+  std::string weightImageName = "";
+  this->GetConfiguration()->ReadParameter(
+    weightImageName, "ImportanceWeightImageName", this->GetComponentLabel(), 0, -1, false);
+
+  if (!weightImageName.empty())
+  {
+    using ChangeInfoFilterType = itk::ChangeInformationImageFilter<WeightImageType>;
+    using DirectionType = typename WeightImageType::DirectionType;
+
+    /** Possibly overrule the direction cosines. */
+    auto infoChanger = ChangeInfoFilterType::New();
+    infoChanger->SetOutputDirection(DirectionType::GetIdentity());
+    infoChanger->SetChangeDirection(!this->GetElastix()->GetUseDirectionCosines());
+
+    /** Do the reading. */
+    try
+    {
+      const auto image = itk::ReadImage<WeightImageType>(weightImageName);
+      infoChanger->SetInput(image);
+      infoChanger->Update();
+    }
+    catch (itk::ExceptionObject & excp)
+    {
+      /** Add information to the exception. */
+      excp.SetLocation("ImportanceSampler - BeforeRegistration()");
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occurred while reading the importance weight image.\n";
+      excp.SetDescription(err_str);
+      /** Pass the exception to an higher level. */
+      throw excp;
+    }
+
+    this->SetWeightImage(infoChanger->GetOutput());
+  }
+
+  /** Check the metrics that use the importance weights of the samples, and warn about the
+   * metrics that do not use them. The AdvancedMattesMutualInformation metric only uses them in
+   * its fast and low memory version, without finite difference derivatives.
+   */
+  unsigned int numberOfResolutions = 3;
+  this->GetConfiguration()->ReadParameter(numberOfResolutions, "NumberOfResolutions", 0);
+  for (unsigned int i = 0; i < this->GetElastix()->GetNumberOfMetrics(); ++i)
+  {
+    const auto *      metric = this->GetElastix()->GetElxMetricBase(i);
+    const std::string metricName = metric->elxGetClassName();
+    if (metricName == "AdvancedMattesMutualInformation")
+    {
+      for (unsigned int level = 0; level < numberOfResolutions; ++level)
+      {
+        bool useFastAndLowMemoryVersion = true;
+        bool useFiniteDifferenceDerivative = false;
+        this->GetConfiguration()->ReadParameter(
+          useFastAndLowMemoryVersion, "UseFastAndLowMemoryVersion", metric->GetComponentLabel(), level, 0, false);
+        this->GetConfiguration()->ReadParameter(
+          useFiniteDifferenceDerivative, "FiniteDifferenceDerivative", metric->GetComponentLabel(), level, 0, false);
+        if (!useFastAndLowMemoryVersion || useFiniteDifferenceDerivative)
+        {
+          itkExceptionMacro(<< "ERROR: the Importance image sampler requires the AdvancedMattesMutualInformation\n"
+                            << "  metric to use (UseFastAndLowMemoryVersion \"true\") and (FiniteDifferenceDerivative\n"
+                            << "  \"false\"), because its other versions do not use the importance weights.");
+        }
+      }
+    }
+    else if (metricName != "AdvancedMeanSquares")
+    {
+      xl::xout["warning"] << "WARNING: the " << metricName << " metric does not use the importance weights\n"
+                          << "  of the Importance image sampler, so its value and derivative are biased\n"
+                          << "  towards the regions with a high sampling density." << std::endl;
+    }
+  }
+
+} // end BeforeRegistration()
+
+
+/**
+ * ******************* BeforeEachResolution ******************
+ */
+
+template <class TElastix>
+void
+ImportanceSampler<TElastix>::BeforeEachResolution()
+{
+  const unsigned int level = (this->m_Registration->GetAsITKBaseType())->GetCurrentLevel();
+
+  /** Set the NumberOfSpatialSamples. */
+  unsigned long numberOfSpatialSamples = 5000;
+  this->GetConfiguration()->ReadParameter(
+    numberOfSpatialSamples, "NumberOfSpatialSamples", this->GetComponentLabel(), level, 0);
+  this->SetNumberOfSamples(numberOfSpatialSamples);
+
+  /** Set the UniformSamplingFraction. */
+  double uniformSamplingFraction = 0.1;
+  this->GetConfiguration()->ReadParameter(
+    uniformSamplingFraction, "UniformSamplingFraction", this->GetComponentLabel(), level, 0);
+  this->SetUniformFraction(uniformSamplingFraction);
+
+} // end BeforeEachResolution
+
+
+} // end namespace elastix
+
+#endif // end #ifndef elxImportanceSampler_hxx
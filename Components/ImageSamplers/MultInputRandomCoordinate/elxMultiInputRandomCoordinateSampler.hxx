@@ -41,12 +41,10 @@ MultiInputRandomCoordinateSampler<TElastix>::BeforeEachResolution()
   this->SetNumberOfSamples(numberOfSpatialSamples);
 
   /** Set up the fixed image interpolator and set the SplineOrder, default value = 1. */
-  auto         fixedImageInterpolator = DefaultInterpolatorType::New();
   unsigned int splineOrder = 1;
   this->GetConfiguration()->ReadParameter(
     splineOrder, "FixedImageBSplineInterpolationOrder", this->GetComponentLabel(), level, 0);
-  fixedImageInterpolator->SetSplineOrder(splineOrder);
-  this->SetInterpolator(fixedImageInterpolator);
+  this->SetInterpolationOrder(splineOrder);
 
   /** Set the UseRandomSampleRegion bool. */
   bool useRandomSampleRegion = false;
@@ -67,7 +67,8 @@ namespace elastix
  *    with fixedImageSize in mm. So, approximately 1/3 of the fixed image size.
  * \parameter FixedImageBSplineInterpolationOrder: When using a RandomCoordinate sampler,
  *    the fixed image needs to be interpolated. This is done using a B-spline interpolator.
- *    With this option you can specify the order of interpolation.\n
+ *    With this option you can specify the order of interpolation. Order 0 and 1 use a
+ *    nearest neighbor and a linear interpolator, which avoid computing B-spline coefficients.\n
  *    example: <tt>(FixedImageBSplineInterpolationOrder 0 0 1)</tt>\n
  *    Default value: 1. The parameter can be specified for each resolution.
  *
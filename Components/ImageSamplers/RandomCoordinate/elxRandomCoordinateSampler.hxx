@@ -19,7 +19,6 @@
 #define elxRandomCoordinateSampler_hxx
 
 #include "elxRandomCoordinateSampler.h"
-#include "itkLinearInterpolateImageFunction.h"
 
 namespace elastix
 {
@@ -44,18 +43,7 @@ RandomCoordinateSampler<TElastix>::BeforeEachResolution()
   unsigned int splineOrder = 1;
   this->GetConfiguration()->ReadParameter(
     splineOrder, "FixedImageBSplineInterpolationOrder", this->GetComponentLabel(), level, 0);
-  if (splineOrder == 1)
-  {
-    using LinearInterpolatorType = itk::LinearInterpolateImageFunction<InputImageType, CoordRepType>;
-    auto fixedImageLinearInterpolator = LinearInterpolatorType::New();
-    this->SetInterpolator(fixedImageLinearInterpolator);
-  }
-  else
-  {
-    auto fixedImageBSplineInterpolator = DefaultInterpolatorType::New();
-    fixedImageBSplineInterpolator->SetSplineOrder(splineOrder);
-    this->SetInterpolator(fixedImageBSplineInterpolator);
-  }
+  this->SetInterpolationOrder(splineOrder);
 
   /** Set the UseRandomSampleRegion bool. */
   bool useRandomSampleRegion = false;
@@ -36,6 +36,14 @@ namespace elastix
  * The parameters used in this class are:
  * \parameter Interpolator: Select this interpolator as follows:\n
  *    <tt>(Interpolator "RayCastInterpolator")</tt>
+ * \parameter UseOccupancyGrid: Whether to skip the parts of the rays that pass through
+ *    blocks of voxels that are all below the threshold. This does not change the result
+ *    (up to rounding), but speeds up the projection of volumes with much empty space.\n
+ *    example: <tt>(UseOccupancyGrid "true")</tt>\n
+ *    The default is "false".
+ * \parameter OccupancyBlockSize: The size (in voxels) of the blocks of the occupancy grid.\n
+ *    example: <tt>(OccupancyBlockSize 4)</tt>\n
+ *    The default is 8.
  *
  * \ingroup Interpolators
  */
@@ -111,6 +111,15 @@ RayCastInterpolator<TElastix>::BeforeEachResolution()
   this->GetConfiguration()->ReadParameter(threshold, "Threshold", this->GetComponentLabel(), level, 0);
   this->SetThreshold(threshold);
 
+  bool useOccupancyGrid = false;
+  this->GetConfiguration()->ReadParameter(useOccupancyGrid, "UseOccupancyGrid", this->GetComponentLabel(), level, 0);
+  this->SetUseOccupancyGrid(useOccupancyGrid);
+
+  unsigned int occupancyBlockSize = 8;
+  this->GetConfiguration()->ReadParameter(
+    occupancyBlockSize, "OccupancyBlockSize", this->GetComponentLabel(), level, 0);
+  this->SetOccupancyBlockSize(occupancyBlockSize);
+
 } // end BeforeEachResolution()
 
 
@@ -91,6 +91,20 @@ namespace elastix
  *    B-spline grids.
  *    example: <tt>(UseFastAndLowMemoryVersion "false")</tt> \n
  *    The default is "true".
+ * \parameter UseSampleCache: Whether the "fast and low memory" version stores
+ *    the moving image values and the (sparse) products of the moving image
+ *    gradient and the transform Jacobian, while constructing the joint
+ *    histogram. The derivative is then computed from these stored results,
+ *    instead of transforming and interpolating each sample a second time.
+ *    Only used when multi-threading is enabled, and not in combination with
+ *    UseJacobianPreconditioning.\n
+ *    example: <tt>(UseSampleCache "true")</tt> \n
+ *    The default is "false". Can be given for each resolution.
+ * \parameter MaximumSampleCacheMemory: The maximum amount of memory, in megabytes,
+ *    used by the sample cache. When more memory would be needed, the per-sample
+ *    results are computed twice, as without UseSampleCache.\n
+ *    example: <tt>(MaximumSampleCacheMemory 2048)</tt> \n
+ *    The default is 512. Can be given for each resolution.
  *
  * \sa ParzenWindowMutualInformationImageToImageMetric
  * \ingroup Metrics
@@ -121,6 +121,17 @@ AdvancedMattesMutualInformationMetric<TElastix>::BeforeEachResolution()
     useFastAndLowMemoryVersion, "UseFastAndLowMemoryVersion", this->GetComponentLabel(), level, 0);
   this->SetUseExplicitPDFDerivatives(!useFastAndLowMemoryVersion);
 
+  /** Set whether the low memory version caches the per-sample results of its
+   * first loop over the samples, and how much memory that cache may use.
+   */
+  bool useSampleCache = false;
+  this->GetConfiguration()->ReadParameter(useSampleCache, "UseSampleCache", this->GetComponentLabel(), level, 0);
+  this->SetUseSampleCache(useSampleCache);
+  double maximumSampleCacheMemory = 512.0;
+  this->GetConfiguration()->ReadParameter(
+    maximumSampleCacheMemory, "MaximumSampleCacheMemory", this->GetComponentLabel(), level, 0);
+  this->SetMaximumSampleCacheMemory(maximumSampleCacheMemory);
+
   /** Set whether to use Nick Tustison's preconditioning technique. */
   bool useJacobianPreconditioning = false;
   this->GetConfiguration()->ReadParameter(
@@ -181,6 +181,9 @@ protected:
   using typename Superclass::ParzenValueContainerType;
   using typename Superclass::KernelFunctionType;
   using typename Superclass::NonZeroJacobianIndicesType;
+  using typename Superclass::SampleCacheType;
+  using typename Superclass::PerturbedSampleType;
+  using typename Superclass::OffsetValueType;
 
   /**  Get the value and analytic derivative.
    * Called by GetValueAndDerivative if UseFiniteDifferenceDerivative == false.
@@ -218,6 +221,19 @@ protected:
                                         MeasureType &          value,
                                         DerivativeType &       derivative) const override;
 
+  /** Multi-threaded version of GetValueAndFiniteDifferenceDerivative(), based on
+   * ComputePDFsAndSparseIncrementalPDFs(). The incremental pdfs of each parameter
+   * are constructed when needed, in a buffer per thread. Only the fixed bins (rows)
+   * and moving bins (columns) touched by the Parzen windows of the perturbed samples
+   * are visited and reset, which costs O((rows + columns) * bins) per parameter,
+   * instead of O(bins^2). Bins whose mutual information term is thresholded (see
+   * the 1e-16 checks) are determined with the unperturbed alpha.
+   */
+  void
+  GetValueAndSparseFiniteDifferenceDerivative(const ParametersType & parameters,
+                                              MeasureType &          value,
+                                              DerivativeType &       derivative) const;
+
   /** Compute terms to implement preconditioning as proposed by Tustison et al. */
   virtual void
   ComputeJacobianPreconditioner(const TransformJacobianType &      jac,
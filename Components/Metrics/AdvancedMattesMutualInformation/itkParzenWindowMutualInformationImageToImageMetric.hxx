@@ -26,6 +26,7 @@
 #include "itkMatrix.h"
 #include <vnl/vnl_inverse.h>
 #include <vnl/vnl_det.h>
+#include <algorithm> // For copy_n.
 
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
@@ -245,8 +246,18 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GetV
   /** Construct the JointPDF and Alpha.
    * This function contains a loop over the samples.
    * It executes multi-threadedly when m_UseMultiThread == true.
+   * If UseSampleCache is true, it also stores the per-sample results that are
+   * needed by the second loop, so that these do not have to be recomputed.
+   * Jacobian preconditioning needs the full transform Jacobian, which is not cached.
    */
-  this->ComputePDFs(parameters);
+  if (this->GetUseJacobianPreconditioning())
+  {
+    this->ComputePDFs(parameters);
+  }
+  else
+  {
+    this->ComputePDFsAndSampleCache(parameters);
+  }
 
   /** Normalize the joint histogram by alpha. */
   this->NormalizeJointPDF(this->m_JointPDF, this->m_Alpha);
@@ -302,6 +313,7 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Comp
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const bool                  useSampleWeights = !this->GetImageSampler()->GetSampleWeights().empty();
 
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator fiter;
@@ -363,6 +375,12 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Comp
         }
       }
 
+      /** Apply the importance weight of the sample, see ImageSamplerBase::GetSampleWeights(). */
+      if (useSampleWeights)
+      {
+        imageJacobian *= this->GetSampleWeight(fiter.Index());
+      }
+
       /** Compute this sample's contribution to the joint distributions. */
       this->UpdateDerivativeLowMemory(fixedImageValue, movingImageValue, imageJacobian, nzji, derivative);
 
@@ -435,6 +453,23 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Thre
    */
   DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
 
+  /** Replay the samples that were cached by ComputePDFsAndSampleCache(). The
+   * threads use the same partitioning of the samples in both loops.
+   */
+  if (this->m_SampleCacheFilled)
+  {
+    const SampleCacheType & sampleCache = this->m_SampleCaches[threadId];
+    for (SizeValueType i = 0; i < sampleCache.m_NumberOfSamples; ++i)
+    {
+      const auto offset = static_cast<std::ptrdiff_t>(i * nnzji);
+      std::copy_n(sampleCache.m_ImageJacobians.begin() + offset, nnzji, imageJacobian.begin());
+      std::copy_n(sampleCache.m_NonZeroJacobianIndices.begin() + offset, nnzji, nzji.begin());
+      this->UpdateDerivativeLowMemory(
+        sampleCache.m_FixedImageValues[i], sampleCache.m_MovingImageValues[i], imageJacobian, nzji, derivative);
+    }
+    return;
+  }
+
   /** Declare and allocate arrays for Jacobian preconditioning. */
   DerivativeType jacobianPreconditioner, preconditioningDivisor;
   if (this->GetUseJacobianPreconditioning())
@@ -447,6 +482,7 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   const unsigned long         sampleContainerSize = sampleContainer->Size();
+  const bool                  useSampleWeights = !this->GetImageSampler()->GetSampleWeights().empty();
 
   /** Get the samples for this thread. */
   const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
@@ -473,7 +509,7 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Thre
     MovingImageDerivativeType   movingImageDerivative;
 
     /** Transform point. */
-    const MovingImagePointType mappedPoint = this->TransformPoint(fixedPoint);
+    const MovingImagePointType mappedPoint = this->TransformSamplePoint(fiter.Index(), fixedPoint);
 
     /** Check if the point is inside the moving mask. */
     bool sampleOk = this->IsInsideMovingMask(mappedPoint);
@@ -529,6 +565,12 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Thre
         }
       }
 
+      /** Apply the importance weight of the sample, see ImageSamplerBase::GetSampleWeights(). */
+      if (useSampleWeights)
+      {
+        imageJacobian *= this->GetSampleWeight(fiter.Index());
+      }
+
       /** Compute this sample's contribution to the joint distributions. */
       this->UpdateDerivativeLowMemory(fixedImageValue, movingImageValue, imageJacobian, nzji, derivative);
 
@@ -619,12 +661,12 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Comp
   void * arg)
 {
   ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
-  ThreadIdType     threadId = infoStruct->WorkUnitID;
 
   ParzenWindowMutualInformationMultiThreaderParameterType * temp =
     static_cast<ParzenWindowMutualInformationMultiThreaderParameterType *>(infoStruct->UserData);
 
-  temp->m_Metric->ThreadedComputeDerivativeLowMemory(threadId);
+  temp->m_Metric->ForEachWorkUnitOfThread(
+    *infoStruct, [temp](const ThreadIdType workUnit) { temp->m_Metric->ThreadedComputeDerivativeLowMemory(workUnit); });
 
   return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
 
@@ -825,6 +867,13 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GetV
   MeasureType &          value,
   DerivativeType &       derivative) const
 {
+  /** The multi-threaded version does not store the incremental pdfs of all parameters. */
+  if (this->m_UseMultiThread)
+  {
+    this->GetValueAndSparseFiniteDifferenceDerivative(parameters, value, derivative);
+    return;
+  }
+
   /** Initialize some variables. */
   value = NumericTraits<MeasureType>::Zero;
   derivative = DerivativeType(this->GetNumberOfParameters());
@@ -1009,6 +1058,274 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GetV
 } // end GetValueAndFiniteDifferenceDerivative
 
 
+/**
+ * ******************** GetValueAndSparseFiniteDifferenceDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndSparseFiniteDifferenceDerivative(
+  const ParametersType & parameters,
+  MeasureType &          value,
+  DerivativeType &       derivative) const
+{
+  /** Construct the JointPDF, Alpha and the perturbed samples, multi-threaded. */
+  this->ComputePDFsAndSparseIncrementalPDFs(parameters);
+
+  /** Compute the fixed and moving marginal pdf by summing over the histogram. */
+  this->ComputeMarginalPDF(this->m_JointPDF, this->m_FixedImageMarginalPDF, 0);
+  this->ComputeMarginalPDF(this->m_JointPDF, this->m_MovingImageMarginalPDF, 1);
+
+  const unsigned int         numberOfFixedBins = this->m_NumberOfFixedHistogramBins;
+  const unsigned int         numberOfMovingBins = this->m_NumberOfMovingHistogramBins;
+  const PDFValueType * const jointPDF = this->m_JointPDF->GetBufferPointer();
+  const MarginalPDFType &    fixedPDF = this->m_FixedImageMarginalPDF;
+  const MarginalPDFType &    movingPDF = this->m_MovingImageMarginalPDF;
+  const double               alpha = this->m_Alpha;
+
+  /** Compute the mutual information. Also compute the sums from which the
+   * unperturbed bins contribute to the perturbed mutual information with alpha_k:
+   * sum alpha_k h log( h / ( f m alpha_k ) ) = alpha_k ( sumHLogH - sumH log( alpha_k ) ).
+   */
+  double MI = 0.0;
+  double sumH = 0.0;
+  double sumHLogH = 0.0;
+  for (unsigned int f = 0; f < numberOfFixedBins; ++f)
+  {
+    for (unsigned int m = 0; m < numberOfMovingBins; ++m)
+    {
+      const double jointPDFValue = jointPDF[f * numberOfMovingBins + m];
+      const double fixPDFmovPDF = fixedPDF[f] * movingPDF[m];
+      if (jointPDFValue > 1e-16 && fixPDFmovPDF * alpha > 1e-16)
+      {
+        const double hLogH = jointPDFValue * std::log(jointPDFValue / fixPDFmovPDF);
+        MI += alpha * (hLogH - jointPDFValue * std::log(alpha));
+        sumH += jointPDFValue;
+        sumHLogH += hLogH;
+      }
+    }
+  }
+  value = static_cast<MeasureType>(-1.0 * MI);
+
+  /** Computes the mutual information after a perturbation, given the incremental
+   * joint pdf and the perturbed alpha. The incremental joint pdf is only nonzero
+   * in the touched fixed bins (rows) times the touched moving bins (columns), so
+   * the incremental marginal pdfs are only nonzero in the touched rows and columns.
+   * Only the bins in those rows and columns are visited. The incremental marginal
+   * pdfs are zero outside the touched bins on entry, and are zeroed again on exit.
+   */
+  const auto computePerturbedMI = [&](const std::vector<PDFValueType> &  incJointPDF,
+                                      const std::vector<unsigned int> &  touchedFixedBins,
+                                      const std::vector<unsigned int> &  touchedMovingBins,
+                                      const std::vector<unsigned char> & isTouchedFixedBin,
+                                      std::vector<double> &              incFixedPDF,
+                                      std::vector<double> &              incMovingPDF,
+                                      const double                       perturbedAlpha) {
+    if (perturbedAlpha <= 0.0)
+    {
+      return 0.0;
+    }
+
+    /** Compute the incremental marginal pdfs. */
+    for (const unsigned int f : touchedFixedBins)
+    {
+      double sum = 0.0;
+      for (const unsigned int m : touchedMovingBins)
+      {
+        sum += incJointPDF[f * numberOfMovingBins + m];
+      }
+      incFixedPDF[f] = sum;
+    }
+    for (const unsigned int m : touchedMovingBins)
+    {
+      double sum = 0.0;
+      for (const unsigned int f : touchedFixedBins)
+      {
+        sum += incJointPDF[f * numberOfMovingBins + m];
+      }
+      incMovingPDF[m] = sum;
+    }
+
+    const double logAlpha = std::log(perturbedAlpha);
+    double       perturbedMI = perturbedAlpha * (sumHLogH - sumH * logAlpha);
+
+    /** Replaces the unperturbed contribution of a bin by the perturbed one. */
+    const auto updateBin = [&](const unsigned int f, const unsigned int m) {
+      const double incJointPDFValue = incJointPDF[f * numberOfMovingBins + m];
+      if (incJointPDFValue == 0.0 && incFixedPDF[f] == 0.0 && incMovingPDF[m] == 0.0)
+      {
+        return;
+      }
+
+      const double jointPDFValue = jointPDF[f * numberOfMovingBins + m];
+      const double fixPDFmovPDF = fixedPDF[f] * movingPDF[m];
+      if (jointPDFValue > 1e-16 && fixPDFmovPDF * alpha > 1e-16)
+      {
+        perturbedMI -= perturbedAlpha * jointPDFValue * (std::log(jointPDFValue / fixPDFmovPDF) - logAlpha);
+      }
+
+      const double perturbedJointPDFValue = jointPDFValue + incJointPDFValue;
+      const double perturbedfixPDFmovPDFAlpha =
+        (fixedPDF[f] + incFixedPDF[f]) * (movingPDF[m] + incMovingPDF[m]) * perturbedAlpha;
+      if (perturbedJointPDFValue > 1e-16 && perturbedfixPDFmovPDFAlpha > 1e-16)
+      {
+        perturbedMI +=
+          perturbedAlpha * perturbedJointPDFValue * std::log(perturbedJointPDFValue / perturbedfixPDFmovPDFAlpha);
+      }
+    };
+
+    /** Visit the touched rows completely, and the touched columns of the other rows. */
+    for (const unsigned int f : touchedFixedBins)
+    {
+      for (unsigned int m = 0; m < numberOfMovingBins; ++m)
+      {
+        updateBin(f, m);
+      }
+    }
+    for (unsigned int f = 0; f < numberOfFixedBins; ++f)
+    {
+      if (!isTouchedFixedBin[f])
+      {
+        for (const unsigned int m : touchedMovingBins)
+        {
+          updateBin(f, m);
+        }
+      }
+    }
+
+    for (const unsigned int f : touchedFixedBins)
+    {
+      incFixedPDF[f] = 0.0;
+    }
+    for (const unsigned int m : touchedMovingBins)
+    {
+      incMovingPDF[m] = 0.0;
+    }
+    return perturbedMI;
+  };
+
+  /** Compute the derivative, multi-threaded over chunks of parameters, each
+   * with its own buffers for the incremental pdfs.
+   */
+  const SizeValueType numberOfParameters = this->GetNumberOfParameters();
+  const double        numberOfSamples = 1.0 / alpha;
+  const double        delta2 = -1.0 / (this->GetFiniteDifferencePerturbation() * 2.0);
+  const unsigned int  fixedWindowSize = this->m_JointPDFWindow.GetSize()[1];
+  const unsigned int  movingWindowSize = this->m_JointPDFWindow.GetSize()[0];
+  derivative = DerivativeType(numberOfParameters);
+
+  constexpr SizeValueType chunkSize = 64;
+  const SizeValueType     numberOfChunks = (numberOfParameters + chunkSize - 1) / chunkSize;
+  this->m_Threader->ParallelizeArray(
+    0,
+    numberOfChunks,
+    [&](const SizeValueType chunk) {
+      std::vector<PDFValueType>  incJointPDFRight(numberOfFixedBins * numberOfMovingBins);
+      std::vector<PDFValueType>  incJointPDFLeft(numberOfFixedBins * numberOfMovingBins);
+      std::vector<double>        incFixedPDF(numberOfFixedBins);
+      std::vector<double>        incMovingPDF(numberOfMovingBins);
+      std::vector<unsigned char> isTouchedFixedBin(numberOfFixedBins);
+      std::vector<unsigned char> isTouchedMovingBin(numberOfMovingBins);
+      std::vector<unsigned int>  touchedFixedBins;
+      std::vector<unsigned int>  touchedMovingBins;
+
+      /** Marks the rows and columns of a Parzen window as touched, given the offset of its first bin. */
+      const auto touchWindow = [&](const OffsetValueType windowOffset) {
+        const auto firstFixedBin = static_cast<unsigned int>(windowOffset / numberOfMovingBins);
+        const auto firstMovingBin = static_cast<unsigned int>(windowOffset % numberOfMovingBins);
+        for (unsigned int f = firstFixedBin; f < firstFixedBin + fixedWindowSize; ++f)
+        {
+          if (!isTouchedFixedBin[f])
+          {
+            isTouchedFixedBin[f] = 1;
+            touchedFixedBins.push_back(f);
+          }
+        }
+        for (unsigned int m = firstMovingBin; m < firstMovingBin + movingWindowSize; ++m)
+        {
+          if (!isTouchedMovingBin[m])
+          {
+            isTouchedMovingBin[m] = 1;
+            touchedMovingBins.push_back(m);
+          }
+        }
+      };
+
+      const SizeValueType last = std::min((chunk + 1) * chunkSize, numberOfParameters);
+      for (SizeValueType k = chunk * chunkSize; k < last; ++k)
+      {
+        /** Construct the incremental joint pdfs of parameter k. */
+        double numberOfSamplesRight = numberOfSamples;
+        double numberOfSamplesLeft = numberOfSamples;
+        for (SizeValueType i = this->m_PerturbedSampleOffsets[k]; i < this->m_PerturbedSampleOffsets[k + 1]; ++i)
+        {
+          const PerturbedSampleType & perturbedSample = this->m_PerturbedSamples[i];
+          const RealType              fixedImageValue = this->m_SampleFixedImageValues[perturbedSample.m_Sample];
+          const RealType              movingImageValue = this->m_SampleMovingImageValues[perturbedSample.m_Sample];
+
+          touchWindow(this->AddToIncrementalPDF(fixedImageValue, movingImageValue, -1.0, incJointPDFRight.data()));
+          this->AddToIncrementalPDF(fixedImageValue, movingImageValue, -1.0, incJointPDFLeft.data());
+          if (perturbedSample.m_IsInsideRight)
+          {
+            touchWindow(this->AddToIncrementalPDF(
+              fixedImageValue, perturbedSample.m_MovingImageValueRight, 1.0, incJointPDFRight.data()));
+          }
+          else
+          {
+            numberOfSamplesRight -= 1.0;
+          }
+          if (perturbedSample.m_IsInsideLeft)
+          {
+            touchWindow(this->AddToIncrementalPDF(
+              fixedImageValue, perturbedSample.m_MovingImageValueLeft, 1.0, incJointPDFLeft.data()));
+          }
+          else
+          {
+            numberOfSamplesLeft -= 1.0;
+          }
+        }
+
+        /** Compute the perturbed alphas and the derivative. */
+        const double perturbedAlphaRight = numberOfSamplesRight > 1e-10 ? 1.0 / numberOfSamplesRight : 0.0;
+        const double perturbedAlphaLeft = numberOfSamplesLeft > 1e-10 ? 1.0 / numberOfSamplesLeft : 0.0;
+        derivative[k] = delta2 * (computePerturbedMI(incJointPDFRight,
+                                                     touchedFixedBins,
+                                                     touchedMovingBins,
+                                                     isTouchedFixedBin,
+                                                     incFixedPDF,
+                                                     incMovingPDF,
+                                                     perturbedAlphaRight) -
+                                  computePerturbedMI(incJointPDFLeft,
+                                                     touchedFixedBins,
+                                                     touchedMovingBins,
+                                                     isTouchedFixedBin,
+                                                     incFixedPDF,
+                                                     incMovingPDF,
+                                                     perturbedAlphaLeft));
+
+        /** Reset only the touched bins of the buffers, for the next parameter. */
+        for (const unsigned int f : touchedFixedBins)
+        {
+          for (const unsigned int m : touchedMovingBins)
+          {
+            incJointPDFRight[f * numberOfMovingBins + m] = 0.0;
+            incJointPDFLeft[f * numberOfMovingBins + m] = 0.0;
+          }
+          isTouchedFixedBin[f] = 0;
+        }
+        for (const unsigned int m : touchedMovingBins)
+        {
+          isTouchedMovingBin[m] = 0;
+        }
+        touchedFixedBins.clear();
+        touchedMovingBins.clear();
+      }
+    },
+    nullptr);
+
+} // end GetValueAndSparseFiniteDifferenceDerivative
+
+
 /**
  * ******************** ComputeJacobianPreconditioner *******************
  */
@@ -47,6 +47,8 @@ namespace itk
  * \li Image derivatives are computed using either the B-spline interpolator's implementation
  * or by nearest neighbor interpolation of a precomputed central difference image.
  * \li A minimum number of samples that should map within the moving image (mask) can be specified.
+ * \li The squared differences of samples that have an importance weight (see ImageSamplerBase::GetSampleWeights())
+ * are weighted, and their sum is divided by the sum of the weights of the valid samples, instead of their number.
  *
  * \ingroup RegistrationMetrics
  * \ingroup Metrics
@@ -217,11 +219,12 @@ protected:
 
   double m_NormalizationFactor;
 
-  /** Compute a pixel's contribution to the measure and derivatives;
-   * Called by GetValueAndDerivative(). */
+  /** Compute a pixel's contribution to the measure and derivatives, scaled by
+   * the importance weight of its sample; Called by GetValueAndDerivative(). */
   void
   UpdateValueAndDerivativeTerms(const RealType                     fixedImageValue,
                                 const RealType                     movingImageValue,
+                                const double                       sampleWeight,
                                 const DerivativeType &             imageJacobian,
                                 const NonZeroJacobianIndicesType & nzji,
                                 MeasureType &                      measure,
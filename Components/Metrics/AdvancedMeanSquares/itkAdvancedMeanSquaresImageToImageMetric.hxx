@@ -72,6 +72,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::Initialize()
     typename ComputeFixedImageExtremaFilterType::Pointer computeFixedImageExtrema =
       ComputeFixedImageExtremaFilterType::New();
     computeFixedImageExtrema->SetInput(this->GetFixedImage());
+    computeFixedImageExtrema->SetUseCache(true);
     computeFixedImageExtrema->SetImageRegion(this->GetFixedImageRegion());
     if (this->m_FixedImageMask.IsNotNull())
     {
@@ -104,6 +105,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::Initialize()
     typename ComputeMovingImageExtremaFilterType::Pointer computeMovingImageExtrema =
       ComputeMovingImageExtremaFilterType::New();
     computeMovingImageExtrema->SetInput(this->GetMovingImage());
+    computeMovingImageExtrema->SetUseCache(true);
     computeMovingImageExtrema->SetImageRegion(this->GetMovingImage()->GetBufferedRegion());
     if (this->m_MovingImageMask.IsNotNull())
     {
@@ -132,8 +134,8 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::Initialize()
       this->m_MovingImageTrueMax +
       this->m_MovingLimitRangeRatio * (this->m_MovingImageTrueMax - this->m_MovingImageTrueMin));
 
-    // TODO: we may actually reuse these values from AdvancedImageToImageMetric::InitializeLimiters
-    // without recomputing them here.
+    // Note: the extrema are taken from the ImageStatisticsCache when they have already been computed by
+    // AdvancedImageToImageMetric::InitializeLimiters.
     const double diff1 = this->m_FixedImageTrueMax - this->m_MovingImageTrueMin;
     const double diff2 = this->m_MovingImageTrueMax - this->m_FixedImageTrueMin;
     const double maxdiff = std::max(diff1, diff2);
@@ -184,6 +186,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueSingle
 {
   /** Initialize some variables. */
   this->m_NumberOfPixelsCounted = 0;
+  double      sumOfSampleWeights = 0.0;
   MeasureType measure = NumericTraits<MeasureType>::Zero;
 
   /** Call non-thread-safe stuff, such as:
@@ -239,7 +242,9 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueSingle
 
       /** The difference squared. */
       const RealType diff = movingImageValue - fixedImageValue;
-      measure += diff * diff;
+      const double   sampleWeight = this->GetSampleWeight(fiter.Index());
+      sumOfSampleWeights += sampleWeight;
+      measure += sampleWeight * diff * diff;
 
     } // end if sampleOk
 
@@ -250,9 +255,9 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueSingle
 
   /** Update measure value. */
   double normal_sum = 0.0;
-  if (this->m_NumberOfPixelsCounted > 0)
+  if (sumOfSampleWeights > 0.0)
   {
-    normal_sum = this->m_NormalizationFactor / static_cast<double>(this->m_NumberOfPixelsCounted);
+    normal_sum = this->m_NormalizationFactor / sumOfSampleWeights;
   }
   measure *= normal_sum;
 
@@ -334,6 +339,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
 
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
+  double        sumOfSampleWeights = 0.0;
   MeasureType   measure = NumericTraits<MeasureType>::Zero;
 
   /** Loop over the fixed image to calculate the mean squares. */
@@ -344,7 +350,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
     RealType                    movingImageValue;
 
     /** Transform point. */
-    const MovingImagePointType mappedPoint = this->TransformPoint(fixedPoint);
+    const MovingImagePointType mappedPoint = this->TransformSamplePoint(threader_fiter.Index(), fixedPoint);
 
     /** Check if the point is inside the moving mask. */
     bool sampleOk = this->IsInsideMovingMask(mappedPoint);
@@ -366,7 +372,9 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
 
       /** The difference squared. */
       const RealType diff = movingImageValue - fixedImageValue;
-      measure += diff * diff;
+      const double   sampleWeight = this->GetSampleWeight(threader_fiter.Index());
+      sumOfSampleWeights += sampleWeight;
+      measure += sampleWeight * diff * diff;
 
     } // end if sampleOk
 
@@ -374,6 +382,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_SumOfSampleWeights = sumOfSampleWeights;
   this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = measure;
 
 } // end ThreadedGetValue()
@@ -389,30 +398,34 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
 {
   const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
-  /** Accumulate the number of pixels. */
+  /** Accumulate the number of pixels and the sum of their importance weights. */
   this->m_NumberOfPixelsCounted = this->m_GetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted;
+  double sumOfSampleWeights = this->m_GetValueAndDerivativePerThreadVariables[0].st_SumOfSampleWeights;
   for (ThreadIdType i = 1; i < numberOfThreads; ++i)
   {
     this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
+    sumOfSampleWeights += this->m_GetValueAndDerivativePerThreadVariables[i].st_SumOfSampleWeights;
 
-    /** Reset this variable for the next iteration. */
+    /** Reset these variables for the next iteration. */
     this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = 0;
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_SumOfSampleWeights = 0.0;
   }
 
   /** Check if enough samples were valid. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
 
-  /** The normalization factor. */
-  DerivativeValueType normal_sum =
-    this->m_NormalizationFactor / static_cast<DerivativeValueType>(this->m_NumberOfPixelsCounted);
+  /** The normalization factor. The sum of the importance weights is the number of pixels when the samples are not
+   * weighted.
+   */
+  DerivativeValueType normal_sum = this->m_NormalizationFactor / static_cast<DerivativeValueType>(sumOfSampleWeights);
 
-  /** Accumulate values. */
-  value = NumericTraits<MeasureType>::Zero;
+  /** Accumulate values, pairwise. */
+  value = Self::template PairwiseSum<MeasureType>(0, numberOfThreads, [this](const ThreadIdType i) {
+    return this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
+  });
   for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
-    value += this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
-
     /** Reset this variable for the next iteration. */
     this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
   }
@@ -457,6 +470,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDer
 
   /** Initialize some variables. */
   this->m_NumberOfPixelsCounted = 0;
+  double      sumOfSampleWeights = 0.0;
   MeasureType measure = NumericTraits<MeasureType>::Zero;
   derivative = DerivativeType(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
@@ -533,7 +547,15 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDer
 #endif
 
       /** Compute this pixel's contribution to the measure and derivatives. */
-      this->UpdateValueAndDerivativeTerms(fixedImageValue, movingImageValue, imageJacobian, nzji, measure, derivative);
+      const double sampleWeight = this->GetSampleWeight(fiter.Index());
+      sumOfSampleWeights += sampleWeight;
+      this->UpdateValueAndDerivativeTerms(fixedImageValue,
+                                          movingImageValue,
+                                          sampleWeight,
+                                          imageJacobian,
+                                          nzji,
+                                          measure,
+                                          derivative);
 
     } // end if sampleOk
 
@@ -544,9 +566,9 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDer
 
   /** Compute the measure value and derivative. */
   double normal_sum = 0.0;
-  if (this->m_NumberOfPixelsCounted > 0)
+  if (sumOfSampleWeights > 0.0)
   {
-    normal_sum = this->m_NormalizationFactor / static_cast<double>(this->m_NumberOfPixelsCounted);
+    normal_sum = this->m_NormalizationFactor / sumOfSampleWeights;
   }
   measure *= normal_sum;
   derivative *= normal_sum;
@@ -641,6 +663,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
 
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
+  double        sumOfSampleWeights = 0.0;
   MeasureType   measure = NumericTraits<MeasureType>::Zero;
 
   /** Loop over the fixed image to calculate the mean squares. */
@@ -652,7 +675,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
     MovingImageDerivativeType   movingImageDerivative;
 
     /** Transform point. */
-    const MovingImagePointType mappedPoint = this->TransformPoint(fixedPoint);
+    const MovingImagePointType mappedPoint = this->TransformSamplePoint(threader_fiter.Index(), fixedPoint);
 
     /** Check if the point is inside the moving mask. */
     bool sampleOk = this->IsInsideMovingMask(mappedPoint);
@@ -687,7 +710,15 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
 #endif
 
       /** Compute this pixel's contribution to the measure and derivatives. */
-      this->UpdateValueAndDerivativeTerms(fixedImageValue, movingImageValue, imageJacobian, nzji, measure, derivative);
+      const double sampleWeight = this->GetSampleWeight(threader_fiter.Index());
+      sumOfSampleWeights += sampleWeight;
+      this->UpdateValueAndDerivativeTerms(fixedImageValue,
+                                          movingImageValue,
+                                          sampleWeight,
+                                          imageJacobian,
+                                          nzji,
+                                          measure,
+                                          derivative);
 
     } // end if sampleOk
 
@@ -695,6 +726,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
 
   /** Only update these variables at the end to prevent unnecessary "false sharing". */
   this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_SumOfSampleWeights = sumOfSampleWeights;
   this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = measure;
 
 } // end ThreadedGetValueAndDerivative()
@@ -712,30 +744,34 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
 {
   const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
-  /** Accumulate the number of pixels. */
+  /** Accumulate the number of pixels and the sum of their importance weights. */
   this->m_NumberOfPixelsCounted = this->m_GetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted;
+  double sumOfSampleWeights = this->m_GetValueAndDerivativePerThreadVariables[0].st_SumOfSampleWeights;
   for (ThreadIdType i = 1; i < numberOfThreads; ++i)
   {
     this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
+    sumOfSampleWeights += this->m_GetValueAndDerivativePerThreadVariables[i].st_SumOfSampleWeights;
 
-    /** Reset this variable for the next iteration. */
+    /** Reset these variables for the next iteration. */
     this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = 0;
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_SumOfSampleWeights = 0.0;
   }
 
   /** Check if enough samples were valid. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
 
-  /** The normalization factor. */
-  DerivativeValueType normal_sum =
-    this->m_NormalizationFactor / static_cast<DerivativeValueType>(this->m_NumberOfPixelsCounted);
+  /** The normalization factor. The sum of the importance weights is the number of pixels when the samples are not
+   * weighted.
+   */
+  DerivativeValueType normal_sum = this->m_NormalizationFactor / static_cast<DerivativeValueType>(sumOfSampleWeights);
 
-  /** Accumulate values. */
-  value = NumericTraits<MeasureType>::Zero;
+  /** Accumulate values, pairwise. */
+  value = Self::template PairwiseSum<MeasureType>(0, numberOfThreads, [this](const ThreadIdType i) {
+    return this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
+  });
   for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
-    value += this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
-
     /** Reset this variable for the next iteration. */
     this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
   }
@@ -792,6 +828,7 @@ void
 AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::UpdateValueAndDerivativeTerms(
   const RealType                     fixedImageValue,
   const RealType                     movingImageValue,
+  const double                       sampleWeight,
   const DerivativeType &             imageJacobian,
   const NonZeroJacobianIndicesType & nzji,
   MeasureType &                      measure,
@@ -800,10 +837,10 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::UpdateValueAnd
   /** The difference squared. */
   const RealType diff = movingImageValue - fixedImageValue;
   const RealType diffdiff = diff * diff;
-  measure += diffdiff;
+  measure += sampleWeight * diffdiff;
 
   /** Calculate the contributions to the derivatives with respect to each parameter. */
-  const RealType diff_2 = diff * 2.0;
+  const RealType diff_2 = sampleWeight * diff * 2.0;
 
   const auto numberOfParameters = this->GetNumberOfParameters();
 
@@ -550,7 +550,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Thre
     MovingImageDerivativeType   movingImageDerivative;
 
     /** Transform point. */
-    const MovingImagePointType mappedPoint = this->TransformPoint(fixedPoint);
+    const MovingImagePointType mappedPoint = this->TransformSamplePoint(threader_fiter.Index(), fixedPoint);
 
     /** Check if the point is inside the moving mask. */
     bool sampleOk = this->IsInsideMovingMask(mappedPoint);
@@ -796,6 +796,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Accu
   const AccumulateType sfm_smm = temp->st_sfm_smm;
   const RealType       invertedDenominator = temp->st_InvertedDenominator;
   const bool           subtractMean = temp->st_Metric->m_SubtractMean;
+  const ThreadIdType   numberOfWorkUnits = temp->st_Metric->GetNumberOfWorkUnits();
 
   const unsigned int numPar = temp->st_Metric->GetNumberOfParameters();
   const unsigned int subSize =
@@ -809,7 +810,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Accu
   for (unsigned int j = jmin; j < jmax; ++j)
   {
     derivativeF = derivativeM = differential = zero;
-    for (ThreadIdType i = 0; i < nrOfThreads; ++i)
+    for (ThreadIdType i = 0; i < numberOfWorkUnits; ++i)
     {
       derivativeF += temp->st_Metric->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeF[j];
       derivativeM += temp->st_Metric->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_DerivativeM[j];
@@ -31,6 +31,20 @@ namespace elastix
  * The parameters used in this class are:
  * \parameter Metric: Select this metric as follows:\n
  *    <tt>(Metric "CorrespondingPointsEuclideanDistanceMetric")</tt>
+ * \parameter RobustEstimator: The robust function that is applied to the
+ *    distances between corresponding points, to reduce the influence of
+ *    outliers. Choose from "None", "Huber" and "Tukey". Can be given for
+ *    each resolution, or for all resolutions at once. \n
+ *    example: <tt>(RobustEstimator "Huber")</tt> \n
+ *    The default is "None".
+ * \parameter RobustnessScale: The scale of the robust function, in mm.
+ *    Distances larger than this value are regarded as outliers. Can be
+ *    given for each resolution, or for all resolutions at once. \n
+ *    example: <tt>(RobustnessScale 5.0)</tt> \n
+ *    The default is 1.0.
+ *
+ * The computation is multi-threaded, unless
+ * <tt>(UseMultiThreadingForMetrics "false")</tt> is given.
  *
  * \ingroup Metrics
  *
@@ -127,6 +141,13 @@ public:
   void
   BeforeRegistration() override;
 
+  /**
+   * Do some things before each resolution:
+   * \li Set the robust function.
+   */
+  void
+  BeforeEachResolution() override;
+
   /** Function to read the corresponding points. */
   unsigned int
   ReadLandmarks(const std::string &                    landmarkFileName,
@@ -134,6 +134,49 @@ CorrespondingPointsEuclideanDistanceMetric<TElastix>::BeforeRegistration()
 } // end BeforeRegistration()
 
 
+/**
+ * ***************** BeforeEachResolution ***********************
+ */
+
+template <class TElastix>
+void
+CorrespondingPointsEuclideanDistanceMetric<TElastix>::BeforeEachResolution()
+{
+  /** Get the current resolution level. */
+  unsigned int level = (this->m_Registration->GetAsITKBaseType())->GetCurrentLevel();
+
+  /** Get and set the robust function. */
+  std::string robustEstimator = "None";
+  this->m_Configuration->ReadParameter(robustEstimator, "RobustEstimator", this->GetComponentLabel(), level, 0);
+  if (robustEstimator == "Huber")
+  {
+    this->SetRobustEstimator(Superclass1::RobustEstimatorEnum::Huber);
+  }
+  else if (robustEstimator == "Tukey")
+  {
+    this->SetRobustEstimator(Superclass1::RobustEstimatorEnum::Tukey);
+  }
+  else if (robustEstimator == "None")
+  {
+    this->SetRobustEstimator(Superclass1::RobustEstimatorEnum::NoEstimator);
+  }
+  else
+  {
+    itkExceptionMacro(<< "ERROR: unknown RobustEstimator \"" << robustEstimator
+                      << "\". Choose from \"None\", \"Huber\" and \"Tukey\".");
+  }
+
+  double robustnessScale = 1.0;
+  this->m_Configuration->ReadParameter(robustnessScale, "RobustnessScale", this->GetComponentLabel(), level, 0);
+  if (robustnessScale <= 0.0)
+  {
+    itkExceptionMacro(<< "ERROR: RobustnessScale should be positive, but is " << robustnessScale << ".");
+  }
+  this->SetRobustnessScale(robustnessScale);
+
+} // end BeforeEachResolution()
+
+
 /**
  * ***************** ReadLandmarks ***********************
  */
@@ -23,6 +23,8 @@
 #include "itkPointSet.h"
 #include "itkImage.h"
 
+#include <memory> // For unique_ptr.
+
 namespace itk
 {
 
@@ -31,6 +33,20 @@ namespace itk
  *  and a fixed point-set.
  *  Correspondence is needed.
  *
+ * The metric value is the mean of \f$ \rho(d_i) \f$ over all corresponding
+ * points, with \f$ d_i \f$ the distance between the transformed fixed point
+ * and the moving point. By default \f$ \rho(d) = d \f$. To reduce the
+ * influence of outliers, a robust function can be selected, with scale \f$ c \f$:
+ * \li Huber: \f$ \rho(d) = d^2 / (2c) \f$ for \f$ d \leq c \f$, and
+ *   \f$ d - c/2 \f$ otherwise.
+ * \li Tukey: \f$ \rho(d) = c/6 \, ( 1 - ( 1 - (d/c)^2 )^3 ) \f$ for
+ *   \f$ d \leq c \f$, and \f$ c/6 \f$ otherwise, so that outliers do not
+ *   contribute to the derivative at all.
+ *
+ * When UseMultiThread is true, the points are distributed over the threads.
+ * Each thread accumulates the (sparse) contributions of its points into its
+ * own derivative, and these are summed afterwards, again multi-threaded.
+ *
  *
  * \ingroup RegistrationMetrics
  */
@@ -75,6 +91,24 @@ public:
   using VnlVectorType = vnl_vector<CoordRepType>;
 
   using typename Superclass::NonZeroJacobianIndicesType;
+  using typename Superclass::ThreaderType;
+  using typename Superclass::ThreadInfoType;
+
+  /** The robust functions that can be applied to the distances. */
+  enum class RobustEstimatorEnum
+  {
+    NoEstimator,
+    Huber,
+    Tukey
+  };
+
+  /** Set/Get the robust function. Default: NoEstimator. */
+  itkSetEnumMacro(RobustEstimator, RobustEstimatorEnum);
+  itkGetEnumMacro(RobustEstimator, RobustEstimatorEnum);
+
+  /** Set/Get the scale of the robust function, in physical units. Default: 1.0. */
+  itkSetMacro(RobustnessScale, double);
+  itkGetConstMacro(RobustnessScale, double);
 
   /**  Get the value for single valued optimizers. */
   MeasureType
@@ -94,10 +128,44 @@ protected:
   CorrespondingPointsEuclideanDistancePointMetric();
   ~CorrespondingPointsEuclideanDistancePointMetric() override = default;
 
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Compute the robust function of the distance, and the derivative of the
+   * robust function divided by the distance.
+   */
+  void
+  EvaluateRobustFunction(const MeasureType distance, MeasureType & value, MeasureType & weight) const;
+
+  /** Compute the value (and derivative) for the points in [ first, last [. */
+  void
+  ComputeValueAndDerivativeOfRange(const SizeValueType first,
+                                   const SizeValueType last,
+                                   const bool          computeDerivative,
+                                   ThreadIdType        threadID) const;
+
+  /** Compute the value (and derivative), multi-threaded if requested. */
+  void
+  ComputeValueAndDerivative(const bool computeDerivative, MeasureType & value, DerivativeType * derivative) const;
+
+  /** Threader callback. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeValueAndDerivativeThreaderCallback(void * arg);
+
+  struct ComputeThreaderParameterType
+  {
+    const Self * st_Metric;
+    bool         st_ComputeDerivative;
+  };
+
 private:
   CorrespondingPointsEuclideanDistancePointMetric(const Self &) = delete;
   void
   operator=(const Self &) = delete;
+
+  RobustEstimatorEnum m_RobustEstimator{ RobustEstimatorEnum::NoEstimator };
+  double              m_RobustnessScale{ 1.0 };
 };
 
 } // end namespace itk
@@ -20,6 +20,9 @@
 
 #include "itkCorrespondingPointsEuclideanDistancePointMetric.h"
 
+#include <algorithm> // For min.
+#include <cmath>
+
 namespace itk
 {
 
@@ -41,70 +44,12 @@ auto
 CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>::GetValue(
   const TransformParametersType & parameters) const -> MeasureType
 {
-  /** Sanity checks. */
-  FixedPointSetConstPointer fixedPointSet = this->GetFixedPointSet();
-  if (!fixedPointSet)
-  {
-    itkExceptionMacro(<< "Fixed point set has not been assigned");
-  }
-
-  MovingPointSetConstPointer movingPointSet = this->GetMovingPointSet();
-  if (!movingPointSet)
-  {
-    itkExceptionMacro(<< "Moving point set has not been assigned");
-  }
-
-  /** Initialize some variables. */
-  this->m_NumberOfPointsCounted = 0;
-  MeasureType     measure = NumericTraits<MeasureType>::Zero;
-  InputPointType  movingPoint;
-  OutputPointType fixedPoint, mappedPoint;
-
   /** Make sure the transform parameters are up to date. */
   this->SetTransformParameters(parameters);
 
-  /** Create iterators. */
-  PointIterator pointItFixed = fixedPointSet->GetPoints()->Begin();
-  PointIterator pointItMoving = movingPointSet->GetPoints()->Begin();
-  PointIterator pointEnd = fixedPointSet->GetPoints()->End();
-
-  /** Loop over the corresponding points. */
-  while (pointItFixed != pointEnd)
-  {
-    /** Get the current corresponding points. */
-    fixedPoint = pointItFixed.Value();
-    movingPoint = pointItMoving.Value();
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    // bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-    mappedPoint = this->m_Transform->TransformPoint(fixedPoint);
-
-    /** Check if the point is inside the moving mask. */
-    bool sampleOk = true;
-    if (sampleOk)
-    {
-      // sampleOk = this->IsInsideMovingMask( mappedPoint );
-      if (this->m_MovingImageMask.IsNotNull())
-      {
-        sampleOk = this->m_MovingImageMask->IsInsideInWorldSpace(mappedPoint);
-      }
-    }
-
-    if (sampleOk)
-    {
-      this->m_NumberOfPointsCounted++;
-
-      VnlVectorType diffPoint = (movingPoint - mappedPoint).GetVnlVector();
-      measure += diffPoint.magnitude();
-
-    } // end if sampleOk
-
-    ++pointItFixed;
-    ++pointItMoving;
-
-  } // end loop over all corresponding points
-
-  return measure / this->m_NumberOfPointsCounted;
+  MeasureType value = NumericTraits<MeasureType>::Zero;
+  this->ComputeValueAndDerivative(false, value, nullptr);
+  return value;
 
 } // end GetValue()
 
@@ -140,6 +85,38 @@ CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>
   const TransformParametersType & parameters,
   MeasureType &                   value,
   DerivativeType &                derivative) const
+{
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * Because of these calls GetValueAndDerivative itself is not thread-safe,
+   * so cannot be called multiple times simultaneously.
+   * This is however needed in the CombinationImageToImageMetric.
+   * In that case, you need to:
+   * - switch the use of this function to on, using m_UseMetricSingleThreaded = true
+   * - call BeforeThreadedGetValueAndDerivative once (single-threaded) before
+   *   calling GetValueAndDerivative
+   * - switch the use of this function to off, using m_UseMetricSingleThreaded = false
+   * - Now you can call GetValueAndDerivative multi-threaded.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  derivative.SetSize(this->GetNumberOfParameters());
+  this->ComputeValueAndDerivative(true, value, &derivative);
+
+} // end GetValueAndDerivative()
+
+
+/**
+ * ******************* ComputeValueAndDerivative *******************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+void
+CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>::ComputeValueAndDerivative(
+  const bool       computeDerivative,
+  MeasureType &    value,
+  DerivativeType * derivative) const
 {
   /** Sanity checks. */
   FixedPointSetConstPointer fixedPointSet = this->GetFixedPointSet();
@@ -154,112 +131,227 @@ CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>
     itkExceptionMacro(<< "Moving point set has not been assigned");
   }
 
-  /** Initialize some variables */
-  this->m_NumberOfPointsCounted = 0;
+  const SizeValueType numberOfPoints = fixedPointSet->GetNumberOfPoints();
+  const ThreadIdType  numberOfThreads = this->GetNumberOfThreadsForComputation();
+  this->InitializeThreadingParameters();
+
+  /** Compute the contributions of all points. */
+  ComputeThreaderParameterType threaderParameters;
+  threaderParameters.st_Metric = this;
+  threaderParameters.st_ComputeDerivative = computeDerivative;
+
+  if (numberOfThreads == 1)
+  {
+    this->ComputeValueAndDerivativeOfRange(0, numberOfPoints, computeDerivative, 0);
+  }
+  else
+  {
+    this->m_Threader->SetSingleMethod(this->ComputeValueAndDerivativeThreaderCallback, &threaderParameters);
+    this->m_Threader->SingleMethodExecute();
+  }
+
+  /** Accumulate the values. */
   MeasureType measure = NumericTraits<MeasureType>::Zero;
-  derivative = DerivativeType(this->GetNumberOfParameters());
-  derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
-  NonZeroJacobianIndicesType nzji(this->m_Transform->GetNumberOfNonZeroJacobianIndices());
-  TransformJacobianType      jacobian;
+  this->m_NumberOfPointsCounted = 0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    measure += this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
+    this->m_NumberOfPointsCounted += this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPointsCounted;
+  }
 
-  InputPointType  movingPoint;
-  OutputPointType fixedPoint, mappedPoint;
+  value = measure;
+  DerivativeValueType normalization = 1.0;
+  if (this->m_NumberOfPointsCounted > 0)
+  {
+    value = measure / this->m_NumberOfPointsCounted;
+    normalization = 1.0 / this->m_NumberOfPointsCounted;
+  }
 
-  /** Call non-thread-safe stuff, such as:
-   *   this->SetTransformParameters( parameters );
-   *   this->GetImageSampler()->Update();
-   * Because of these calls GetValueAndDerivative itself is not thread-safe,
-   * so cannot be called multiple times simultaneously.
-   * This is however needed in the CombinationImageToImageMetric.
-   * In that case, you need to:
-   * - switch the use of this function to on, using m_UseMetricSingleThreaded = true
-   * - call BeforeThreadedGetValueAndDerivative once (single-threaded) before
-   *   calling GetValueAndDerivative
-   * - switch the use of this function to off, using m_UseMetricSingleThreaded = false
-   * - Now you can call GetValueAndDerivative multi-threaded.
-   */
-  this->BeforeThreadedGetValueAndDerivative(parameters);
+  /** Accumulate the derivatives, and reset the per thread derivatives. */
+  if (computeDerivative)
+  {
+    this->AccumulateDerivatives(*derivative, normalization);
+  }
+
+} // end ComputeValueAndDerivative()
+
+
+/**
+ * ******************* ComputeValueAndDerivativeOfRange *******************
+ */
 
-  /** Create iterators. */
-  PointIterator pointItFixed = fixedPointSet->GetPoints()->Begin();
-  PointIterator pointItMoving = movingPointSet->GetPoints()->Begin();
-  PointIterator pointEnd = fixedPointSet->GetPoints()->End();
+template <class TFixedPointSet, class TMovingPointSet>
+void
+CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>::ComputeValueAndDerivativeOfRange(
+  const SizeValueType first,
+  const SizeValueType last,
+  const bool          computeDerivative,
+  ThreadIdType        threadID) const
+{
+  auto & perThreadVariables = this->m_GetValueAndDerivativePerThreadVariables[threadID];
+
+  /** Initialize some variables. */
+  const unsigned int         numberOfParameters = this->GetNumberOfParameters();
+  DerivativeType &           derivative = perThreadVariables.st_Derivative;
+  NonZeroJacobianIndicesType nzji(this->m_Transform->GetNumberOfNonZeroJacobianIndices());
+  TransformJacobianType      jacobian;
+  SizeValueType              numberOfPointsCounted = 0;
+  MeasureType                measure = NumericTraits<MeasureType>::Zero;
+
+  const auto & fixedPoints = *this->m_FixedPointSet->GetPoints();
+  const auto & movingPoints = *this->m_MovingPointSet->GetPoints();
 
   /** Loop over the corresponding points. */
-  while (pointItFixed != pointEnd)
+  for (SizeValueType pointID = first; pointID < last; ++pointID)
   {
     /** Get the current corresponding points. */
-    fixedPoint = pointItFixed.Value();
-    movingPoint = pointItMoving.Value();
+    const OutputPointType fixedPoint = fixedPoints.ElementAt(pointID);
+    const InputPointType  movingPoint = movingPoints.ElementAt(pointID);
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    // bool sampleOk = this->TransformPoint( fixedPoint, mappedPoint );
-    mappedPoint = this->m_Transform->TransformPoint(fixedPoint);
+    /** Transform point. */
+    const OutputPointType mappedPoint = this->m_Transform->TransformPoint(fixedPoint);
 
     /** Check if the point is inside the moving mask. */
-    bool sampleOk = true;
-    if (sampleOk)
+    if (this->m_MovingImageMask.IsNotNull() && !this->m_MovingImageMask->IsInsideInWorldSpace(mappedPoint))
     {
-      // sampleOk = this->IsInsideMovingMask( mappedPoint );
-      if (this->m_MovingImageMask.IsNotNull())
-      {
-        sampleOk = this->m_MovingImageMask->IsInsideInWorldSpace(mappedPoint);
-      }
+      continue;
     }
 
-    if (sampleOk)
-    {
-      this->m_NumberOfPointsCounted++;
+    ++numberOfPointsCounted;
 
+    const VnlVectorType diffPoint = (movingPoint - mappedPoint).GetVnlVector();
+    const MeasureType   distance = diffPoint.magnitude();
+    MeasureType         robustValue;
+    MeasureType         weight;
+    this->EvaluateRobustFunction(distance, robustValue, weight);
+    measure += robustValue;
+
+    /** Calculate the contributions to the derivatives with respect to each parameter. */
+    if (computeDerivative && distance > std::numeric_limits<MeasureType>::epsilon() && weight != 0.0)
+    {
       /** Get the TransformJacobian dT/dmu. */
-      // this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
       this->m_Transform->GetJacobian(fixedPoint, jacobian, nzji);
 
-      VnlVectorType diffPoint = (movingPoint - mappedPoint).GetVnlVector();
-      MeasureType   distance = diffPoint.magnitude();
-      measure += distance;
-
-      /** Calculate the contributions to the derivatives with respect to each parameter. */
-      if (distance > std::numeric_limits<MeasureType>::epsilon())
+      const VnlVectorType diff_2 = diffPoint * weight;
+      if (nzji.size() == numberOfParameters)
       {
-        VnlVectorType diff_2 = diffPoint / distance;
-        if (nzji.size() == this->GetNumberOfParameters())
-        {
-          /** Loop over all Jacobians. */
-          derivative -= diff_2 * jacobian;
-        }
-        else
+        /** Loop over all Jacobians. */
+        derivative -= diff_2 * jacobian;
+      }
+      else
+      {
+        /** Only pick the nonzero Jacobians. */
+        for (unsigned int i = 0; i < nzji.size(); ++i)
         {
-          /** Only pick the nonzero Jacobians. */
-          for (unsigned int i = 0; i < nzji.size(); ++i)
-          {
-            const unsigned int index = nzji[i];
-            VnlVectorType      column = jacobian.get_column(i);
-            derivative[index] -= dot_product(diff_2, column);
-          }
+          const unsigned int index = nzji[i];
+          VnlVectorType      column = jacobian.get_column(i);
+          derivative[index] -= dot_product(diff_2, column);
         }
-      } // end if distance != 0
+      }
+    } // end if distance != 0
 
-    } // end if sampleOk
+  } // end loop over all corresponding points
 
-    ++pointItFixed;
-    ++pointItMoving;
+  perThreadVariables.st_NumberOfPointsCounted = numberOfPointsCounted;
+  perThreadVariables.st_Value = measure;
 
-  } // end loop over all corresponding points
+} // end ComputeValueAndDerivativeOfRange()
 
-  /** Check if enough samples were valid. */
-  //   this->CheckNumberOfSamples(
-  //     fixedPointSet->GetNumberOfPoints(), this->m_NumberOfPointsCounted );
 
-  /** Copy the measure to value. */
-  value = measure;
-  if (this->m_NumberOfPointsCounted > 0)
+/**
+ * ******************* EvaluateRobustFunction *******************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+void
+CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>::EvaluateRobustFunction(
+  const MeasureType distance,
+  MeasureType &     value,
+  MeasureType &     weight) const
+{
+  const MeasureType c = this->m_RobustnessScale;
+
+  switch (this->m_RobustEstimator)
   {
-    derivative /= this->m_NumberOfPointsCounted;
-    value = measure / this->m_NumberOfPointsCounted;
+    case RobustEstimatorEnum::Huber:
+      if (distance <= c)
+      {
+        value = distance * distance / (2.0 * c);
+        weight = 1.0 / c;
+      }
+      else
+      {
+        value = distance - 0.5 * c;
+        weight = 1.0 / distance;
+      }
+      break;
+
+    case RobustEstimatorEnum::Tukey:
+      if (distance <= c)
+      {
+        const MeasureType u = 1.0 - (distance / c) * (distance / c);
+        value = c / 6.0 * (1.0 - u * u * u);
+        weight = u * u / c;
+      }
+      else
+      {
+        value = c / 6.0;
+        weight = 0.0;
+      }
+      break;
+
+    default:
+      value = distance;
+      weight = distance > 0.0 ? 1.0 / distance : 0.0;
   }
 
-} // end GetValueAndDerivative()
+} // end EvaluateRobustFunction()
+
+
+/**
+ * ******************* ComputeValueAndDerivativeThreaderCallback *******************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>::
+  ComputeValueAndDerivativeThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  const auto * temp = static_cast<ComputeThreaderParameterType *>(infoStruct->UserData);
+
+  /** Each thread processes a contiguous range of points. */
+  const SizeValueType numberOfPoints = temp->st_Metric->m_FixedPointSet->GetNumberOfPoints();
+  const SizeValueType subSize = (numberOfPoints + nrOfThreads - 1) / nrOfThreads;
+  const SizeValueType first = std::min<SizeValueType>(threadID * subSize, numberOfPoints);
+  const SizeValueType last = std::min<SizeValueType>(first + subSize, numberOfPoints);
+
+  temp->st_Metric->ComputeValueAndDerivativeOfRange(first, last, temp->st_ComputeDerivative, threadID);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeValueAndDerivativeThreaderCallback()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+void
+CorrespondingPointsEuclideanDistancePointMetric<TFixedPointSet, TMovingPointSet>::PrintSelf(std::ostream & os,
+                                                                                            Indent         indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "RobustEstimator: " << static_cast<int>(this->m_RobustEstimator) << std::endl;
+  os << indent << "RobustnessScale: " << this->m_RobustnessScale << std::endl;
+  os << indent << "UseMultiThread: " << this->m_UseMultiThread << std::endl;
+
+} // end PrintSelf()
 
 
 } // end namespace itk
@@ -28,6 +28,26 @@ namespace elastix
  * \class GradientDifferenceMetric
  * \brief An metric based on the itk::GradientDifferenceImageToImageMetric.
  *
+ * The parameters used in this class are:
+ * \parameter Metric: Select this metric as follows:\n
+ *    <tt>(Metric "GradientDifference")</tt>
+ * \parameter UseConcurrentPerturbations: Whether the values at the perturbed
+ *    parameters of the finite difference derivative are computed concurrently.
+ *    This only has effect for linear transforms. Can be given for each
+ *    resolution, or for all resolutions at once. \n
+ *    example: <tt>(UseConcurrentPerturbations "true")</tt> \n
+ *    The default is "false".
+ * \parameter UseSimultaneousPerturbation: Whether the derivative is estimated
+ *    by simultaneous perturbation (SPSA), instead of central differences. This
+ *    requires fewer metric evaluations, but gives a noisy derivative. Can be
+ *    given for each resolution, or for all resolutions at once. \n
+ *    example: <tt>(UseSimultaneousPerturbation "true")</tt> \n
+ *    The default is "false".
+ * \parameter NumberOfPerturbations: The number of random perturbations that
+ *    are averaged when UseSimultaneousPerturbation is "true". Can be given for
+ *    each resolution, or for all resolutions at once. \n
+ *    example: <tt>(NumberOfPerturbations 4)</tt> \n
+ *    The default is 1.
  *
  * \ingroup Metrics
  *
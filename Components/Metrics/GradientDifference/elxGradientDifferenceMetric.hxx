@@ -74,10 +74,29 @@ template <class TElastix>
 void
 GradientDifferenceMetric<TElastix>::BeforeEachResolution()
 {
+  /** Get the current resolution level. */
+  unsigned int level = (this->m_Registration->GetAsITKBaseType())->GetCurrentLevel();
+
   using ScalesType = typename elastix::OptimizerBase<TElastix>::ITKBaseType::ScalesType;
   ScalesType scales = this->m_Elastix->GetElxOptimizerBase()->GetAsITKBaseType()->GetScales();
   this->SetScales(scales);
 
+  /** Set the finite difference derivative options. */
+  bool useConcurrentPerturbations = false;
+  this->m_Configuration->ReadParameter(
+    useConcurrentPerturbations, "UseConcurrentPerturbations", this->GetComponentLabel(), level, 0);
+  this->SetUseConcurrentPerturbations(useConcurrentPerturbations);
+
+  bool useSimultaneousPerturbation = false;
+  this->m_Configuration->ReadParameter(
+    useSimultaneousPerturbation, "UseSimultaneousPerturbation", this->GetComponentLabel(), level, 0);
+  this->GetDerivativeEstimator()->SetUseSimultaneousPerturbation(useSimultaneousPerturbation);
+
+  unsigned int numberOfPerturbations = 1;
+  this->m_Configuration->ReadParameter(
+    numberOfPerturbations, "NumberOfPerturbations", this->GetComponentLabel(), level, 0);
+  this->GetDerivativeEstimator()->SetNumberOfPerturbations(numberOfPerturbations);
+
 } // end BeforeEachResolution()
 
 
@@ -40,10 +40,12 @@
 #include "itkNeighborhoodOperatorImageFilter.h"
 #include "itkPoint.h"
 #include "itkCastImageFilter.h"
-#include "itkResampleImageFilter.h"
+#include "itkAdvancedRayCastResampleImageFilter.h"
 #include "itkOptimizer.h"
 #include "itkAdvancedCombinationTransform.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkFiniteDifferenceDerivativeEstimator.h"
+#include "itkConcurrentPerturbationEvaluator.h"
 
 namespace itk
 {
@@ -64,6 +66,14 @@ namespace itk
  * on it. Values at these non-grid position of the Fixed image are
  * interpolated using a user-selected Interpolator.
  *
+ * The derivative is computed by finite differences. Optionally, the
+ * values at the perturbed parameters are computed concurrently, each
+ * thread using its own copy of the transform and its own projection and
+ * gradient filters. This requires the transform (chain) to be linear,
+ * otherwise the values are computed one after the other. The derivative
+ * estimator can be switched to simultaneous perturbation (SPSA), see
+ * FiniteDifferenceDerivativeEstimator.
+ *
  * Implementation of this class is based on:
  * Hipwell, J. H., et. al. (2003), "Intensity-Based 2-D-3D Registration of
  * Cerebral Angiograms,", IEEE Transactions on Medical Imaging,
@@ -121,7 +131,8 @@ public:
   using CombinationTransformType = typename itk::AdvancedCombinationTransform<ScalarType, FixedImageDimension>;
   using CombinationTransformPointer = typename CombinationTransformType::Pointer;
   using TransformedMovingImageType = itk::Image<FixedImagePixelType, Self::FixedImageDimension>;
-  using TransformMovingImageFilterType = itk::ResampleImageFilter<MovingImageType, TransformedMovingImageType>;
+  using TransformMovingImageFilterType =
+    itk::AdvancedRayCastResampleImageFilter<MovingImageType, TransformedMovingImageType, ScalarType>;
   using RayCastInterpolatorType = typename itk::AdvancedRayCastInterpolateImageFunction<MovingImageType, ScalarType>;
   using RayCastInterpolatorPointer = typename RayCastInterpolatorType::Pointer;
   using FixedGradientImageType = itk::Image<RealType, Self::FixedImageDimension>;
@@ -132,6 +143,8 @@ public:
   using CastMovedImageFilterType = itk::CastImageFilter<TransformedMovingImageType, MovedGradientImageType>;
   using CastMovedImageFilterPointer = typename CastMovedImageFilterType::Pointer;
   using MovedGradientPixelType = typename MovedGradientImageType::PixelType;
+  using DerivativeEstimatorType = FiniteDifferenceDerivativeEstimator;
+  using DerivativeEstimatorPointer = typename DerivativeEstimatorType::Pointer;
 
   /** Get the derivatives of the match measure. */
   void
@@ -163,6 +176,19 @@ public:
   itkSetMacro(DerivativeDelta, double);
   itkGetConstReferenceMacro(DerivativeDelta, double);
 
+  /** Set/Get whether the values at the perturbed parameters are computed
+   * concurrently, see the class description. Default: false.
+   */
+  itkSetMacro(UseConcurrentPerturbations, bool);
+  itkGetConstMacro(UseConcurrentPerturbations, bool);
+  itkBooleanMacro(UseConcurrentPerturbations);
+
+  /** Get the derivative estimator, to select central differences or
+   * simultaneous perturbation. The DerivativeDelta and Scales of this
+   * metric are passed to it in GetDerivative().
+   */
+  itkGetModifiableObjectMacro(DerivativeEstimator, DerivativeEstimatorType);
+
 protected:
   GradientDifferenceImageToImageMetric();
   ~GradientDifferenceImageToImageMetric() override = default;
@@ -173,6 +199,12 @@ protected:
   void
   ComputeMovedGradientRange() const;
 
+  /** Compute the range of the given moved image gradients. */
+  void
+  ComputeMovedGradientRange(const MovedGradientImageType * const movedGradients[],
+                            MovedGradientPixelType              minimum[],
+                            MovedGradientPixelType              maximum[]) const;
+
   /** Compute the variance and range of the moving image gradients. */
   void
   ComputeVariance() const;
@@ -181,10 +213,43 @@ protected:
   MeasureType
   ComputeMeasure(const TransformParametersType & parameters, const double * subtractionFactor) const;
 
+  /** Compute the similarity measure of the given moved image gradients. Thread-safe. */
+  MeasureType
+  ComputeMeasureOfGradients(const MovedGradientImageType * const movedGradients[],
+                            const double *                      subtractionFactor) const;
+
   using FixedSobelFilter = NeighborhoodOperatorImageFilter<FixedGradientImageType, FixedGradientImageType>;
 
   using MovedSobelFilter = NeighborhoodOperatorImageFilter<MovedGradientImageType, MovedGradientImageType>;
 
+  using ParametersContainerType = typename DerivativeEstimatorType::ParametersContainerType;
+  using MeasureContainerType = typename DerivativeEstimatorType::MeasureContainerType;
+
+  /** Compute the values at the perturbed parameters, concurrently if possible. */
+  void
+  ComputePerturbedValues(const ParametersContainerType & perturbedParameters, MeasureContainerType & values) const;
+
+  /** The filters that compute the value at one perturbed parameter vector,
+   * independent of the filters of the main pipeline. There is one per thread.
+   */
+  struct PerturbationPipelineType
+    : public PerturbationProjectionPipeline<FixedImageType, MovingImageType, ScalarType>
+  {
+    CastMovedImageFilterPointer                              CastMovedImageFilter;
+    typename MovedSobelFilter::Pointer                       MovedSobelFilters[MovedImageDimension];
+    ZeroFluxNeumannBoundaryCondition<MovedGradientImageType> BoundaryCondition;
+  };
+
+  using PerturbationEvaluatorType = ConcurrentPerturbationEvaluator<PerturbationPipelineType>;
+
+  /** Add the gradient filters to a new perturbation pipeline. */
+  void
+  CompletePerturbationPipeline(PerturbationPipelineType & pipeline) const;
+
+  /** Compute the value using a perturbation pipeline, of which the transform has been set. */
+  MeasureType
+  ComputeValueOfPerturbation(PerturbationPipelineType & pipeline) const;
+
 private:
   GradientDifferenceImageToImageMetric(const Self &) = delete;
   void
@@ -225,6 +290,12 @@ private:
   double                      m_DerivativeDelta;
   double                      m_Rescalingfactor;
   CombinationTransformPointer m_CombinationTransform;
+
+  bool                       m_UseConcurrentPerturbations{ false };
+  DerivativeEstimatorPointer m_DerivativeEstimator;
+
+  /** Its pipelines are created on demand, and cleared by Initialize(). */
+  mutable PerturbationEvaluatorType m_PerturbationEvaluator;
 };
 
 } // end namespace itk
@@ -77,6 +77,7 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GradientDiffere
 
   this->m_DerivativeDelta = 0.001;
   this->m_Rescalingfactor = 1.0;
+  this->m_DerivativeEstimator = DerivativeEstimatorType::New();
 }
 
 
@@ -142,6 +143,9 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::Initialize()
     this->m_MovedSobelFilters[iFilter]->UpdateLargestPossibleRegion();
   }
 
+  /** The perturbation pipelines are connected to the previous images. */
+  this->m_PerturbationEvaluator.Clear();
+
   /** Compute the variance */
   ComputeVariance();
 
@@ -166,6 +170,8 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "DerivativeDelta: " << this->m_DerivativeDelta << std::endl;
+  os << indent << "UseConcurrentPerturbations: " << this->m_UseConcurrentPerturbations << std::endl;
+  os << indent << "DerivativeEstimator: " << this->m_DerivativeEstimator.GetPointer() << std::endl;
 }
 
 
@@ -176,6 +182,23 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::
 template <class TFixedImage, class TMovingImage>
 void
 GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeMovedGradientRange() const
+{
+  const MovedGradientImageType * movedGradients[MovedImageDimension];
+  for (unsigned int iDimension = 0; iDimension < MovedImageDimension; ++iDimension)
+  {
+    movedGradients[iDimension] = this->m_MovedSobelFilters[iDimension]->GetOutput();
+  }
+
+  this->ComputeMovedGradientRange(movedGradients, this->m_MinMovedGradient, this->m_MaxMovedGradient);
+}
+
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeMovedGradientRange(
+  const MovedGradientImageType * const movedGradients[],
+  MovedGradientPixelType              minimum[],
+  MovedGradientPixelType              maximum[]) const
 {
   unsigned int           iDimension;
   MovedGradientPixelType gradient;
@@ -184,25 +207,25 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeMovedGra
   {
     using IteratorType = itk::ImageRegionConstIteratorWithIndex<MovedGradientImageType>;
 
-    IteratorType iterate(m_MovedSobelFilters[iDimension]->GetOutput(), this->GetFixedImageRegion());
+    IteratorType iterate(movedGradients[iDimension], this->GetFixedImageRegion());
 
     gradient = iterate.Get();
 
-    m_MinMovedGradient[iDimension] = gradient;
-    m_MaxMovedGradient[iDimension] = gradient;
+    minimum[iDimension] = gradient;
+    maximum[iDimension] = gradient;
 
     while (!iterate.IsAtEnd())
     {
       gradient = iterate.Get();
 
-      if (gradient > m_MaxMovedGradient[iDimension])
+      if (gradient > maximum[iDimension])
       {
-        m_MaxMovedGradient[iDimension] = gradient;
+        maximum[iDimension] = gradient;
       }
 
-      if (gradient < m_MinMovedGradient[iDimension])
+      if (gradient < minimum[iDimension])
       {
-        m_MinMovedGradient[iDimension] = gradient;
+        minimum[iDimension] = gradient;
       }
 
       ++iterate;
@@ -357,10 +380,34 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeMeasure(
   this->BeforeThreadedGetValueAndDerivative(parameters);
   // this->SetTransformParameters( parameters );
 
-  unsigned int iDimension;
   this->m_TransformMovingImageFilter->Modified();
   this->m_TransformMovingImageFilter->UpdateLargestPossibleRegion();
-  MeasureType measure = NumericTraits<MeasureType>::Zero;
+
+  const MovedGradientImageType * movedGradients[MovedImageDimension];
+  for (unsigned int iDimension = 0; iDimension < FixedImageDimension; ++iDimension)
+  {
+    this->m_FixedSobelFilters[iDimension]->UpdateLargestPossibleRegion();
+    this->m_MovedSobelFilters[iDimension]->UpdateLargestPossibleRegion();
+    movedGradients[iDimension] = this->m_MovedSobelFilters[iDimension]->GetOutput();
+  }
+
+  return this->ComputeMeasureOfGradients(movedGradients, subtractionFactor);
+
+} // end ComputeMeasure()
+
+
+/**
+ * ******************** ComputeMeasureOfGradients ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+auto
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeMeasureOfGradients(
+  const MovedGradientImageType * const movedGradients[],
+  const double *                      subtractionFactor) const -> MeasureType
+{
+  unsigned int iDimension;
+  MeasureType  measure = NumericTraits<MeasureType>::Zero;
 
   typename FixedImageType::IndexType currentIndex;
   typename FixedImageType::PointType point;
@@ -387,10 +434,7 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeMeasure(
 
     using MovedIteratorType = itk::ImageRegionConstIteratorWithIndex<MovedGradientImageType>;
 
-    MovedIteratorType movedIterator(this->m_MovedSobelFilters[iDimension]->GetOutput(), this->GetFixedImageRegion());
-
-    this->m_FixedSobelFilters[iDimension]->UpdateLargestPossibleRegion();
-    this->m_MovedSobelFilters[iDimension]->UpdateLargestPossibleRegion();
+    MovedIteratorType movedIterator(movedGradients[iDimension], this->GetFixedImageRegion());
 
     bool sampleOK = false;
 
@@ -436,7 +480,7 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeMeasure(
 
   return measure /= -this->m_Rescalingfactor; // negative for minimization
 
-} // end ComputeMeasure()
+} // end ComputeMeasureOfGradients()
 
 
 /**
@@ -488,22 +532,112 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetDerivative(
   const TransformParametersType & parameters,
   DerivativeType &                derivative) const
 {
-  TransformParametersType testPoint;
-  testPoint = parameters;
-  const unsigned int numberOfParameters = this->GetNumberOfParameters();
-  derivative = DerivativeType(numberOfParameters);
+  this->m_DerivativeEstimator->SetDerivativeDelta(this->m_DerivativeDelta);
+  this->m_DerivativeEstimator->SetScales(this->m_Scales);
+
+  ParametersContainerType perturbedParameters;
+  this->m_DerivativeEstimator->GeneratePerturbedParameters(parameters, perturbedParameters);
+
+  MeasureContainerType values(perturbedParameters.size());
+  this->ComputePerturbedValues(perturbedParameters, values);
+
+  this->m_DerivativeEstimator->ComputeDerivative(values, derivative);
+
+} // end GetDerivative()
+
+
+/**
+ * ******************** ComputePerturbedValues ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputePerturbedValues(
+  const ParametersContainerType & perturbedParameters,
+  MeasureContainerType &          values) const
+{
+  /** Compute the values concurrently, one pipeline per thread, if possible. */
+  const auto rayCaster = dynamic_cast<const RayCastInterpolatorType *>(this->m_Interpolator.GetPointer());
+  if (this->m_UseConcurrentPerturbations && rayCaster != nullptr &&
+      this->m_PerturbationEvaluator.ComputeValues(
+        *this->m_Threader,
+        perturbedParameters,
+        *rayCaster,
+        this->m_MovingImage.GetPointer(),
+        this->m_FixedImage.GetPointer(),
+        [this](const TransformParametersType & parameters) { this->SetTransformParameters(parameters); },
+        [this](PerturbationPipelineType & pipeline) { this->CompletePerturbationPipeline(pipeline); },
+        [this](PerturbationPipelineType & pipeline) { return this->ComputeValueOfPerturbation(pipeline); },
+        values))
+  {
+    return;
+  }
 
-  for (unsigned int i = 0; i < numberOfParameters; ++i)
+  /** Otherwise compute the values one after the other, using the main pipeline. */
+  for (std::size_t k = 0; k < perturbedParameters.size(); ++k)
   {
-    testPoint[i] -= this->m_DerivativeDelta / std::sqrt(this->m_Scales[i]);
-    const MeasureType valuep0 = this->GetValue(testPoint);
-    testPoint[i] += 2 * this->m_DerivativeDelta / std::sqrt(this->m_Scales[i]);
-    const MeasureType valuep1 = this->GetValue(testPoint);
-    derivative[i] = (valuep1 - valuep0) / (2 * this->m_DerivativeDelta / std::sqrt(this->m_Scales[i]));
-    testPoint[i] = parameters[i];
+    values[k] = this->GetValue(perturbedParameters[k]);
   }
 
-} // end GetDerivative()
+} // end ComputePerturbedValues()
+
+
+/**
+ * ******************** CompletePerturbationPipeline ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::CompletePerturbationPipeline(
+  PerturbationPipelineType & pipeline) const
+{
+  pipeline.CastMovedImageFilter = CastMovedImageFilterType::New();
+  pipeline.CastMovedImageFilter->SetNumberOfWorkUnits(1);
+  pipeline.CastMovedImageFilter->SetInput(pipeline.Projector->GetOutput());
+
+  for (unsigned int iFilter = 0; iFilter < MovedImageDimension; ++iFilter)
+  {
+    pipeline.MovedSobelFilters[iFilter] = MovedSobelFilter::New();
+    pipeline.MovedSobelFilters[iFilter]->SetNumberOfWorkUnits(1);
+    pipeline.MovedSobelFilters[iFilter]->OverrideBoundaryCondition(&pipeline.BoundaryCondition);
+    pipeline.MovedSobelFilters[iFilter]->SetOperator(this->m_MovedSobelOperators[iFilter]);
+    pipeline.MovedSobelFilters[iFilter]->SetInput(pipeline.CastMovedImageFilter->GetOutput());
+  }
+
+} // end CompletePerturbationPipeline()
+
+
+/**
+ * ******************** ComputeValueOfPerturbation ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+auto
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeValueOfPerturbation(
+  PerturbationPipelineType & pipeline) const -> MeasureType
+{
+  /** Update the gradient images. */
+  const MovedGradientImageType * movedGradients[MovedImageDimension];
+  for (unsigned int iFilter = 0; iFilter < MovedImageDimension; ++iFilter)
+  {
+    pipeline.MovedSobelFilters[iFilter]->UpdateLargestPossibleRegion();
+    movedGradients[iFilter] = pipeline.MovedSobelFilters[iFilter]->GetOutput();
+  }
+
+  /** Compute the range of the moved image gradients, as in GetValue(). */
+  MovedGradientPixelType minMovedGradient[MovedImageDimension];
+  MovedGradientPixelType maxMovedGradient[MovedImageDimension];
+  this->ComputeMovedGradientRange(movedGradients, minMovedGradient, maxMovedGradient);
+
+  double subtractionFactor[FixedImageDimension];
+  for (unsigned int iDimension = 0; iDimension < FixedImageDimension; ++iDimension)
+  {
+    subtractionFactor[iDimension] = this->m_MaxFixedGradient[iDimension] / maxMovedGradient[iDimension];
+  }
+
+  return this->ComputeMeasureOfGradients(movedGradients, subtractionFactor);
+
+} // end ComputeValueOfPerturbation()
 
 
 /**
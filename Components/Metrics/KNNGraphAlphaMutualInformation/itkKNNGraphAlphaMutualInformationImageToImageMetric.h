@@ -311,14 +311,6 @@ private:
                                                    TransformJacobianIndicesContainerType & jacobiansIndices,
                                                    SpatialDerivativeContainerType &        spatialDerivatives) const;
 
-  /** This function calculates the spatial derivative of the
-   * featureNr feature image at the point mappedPoint.
-   * \todo move this to base class.
-   */
-  virtual void
-  EvaluateMovingFeatureImageDerivatives(const MovingImagePointType & mappedPoint,
-                                        SpatialDerivativeType &      featureGradients) const;
-
   /** This function essentially computes D1 - D2, but also takes
    * care of going from a sparse matrix (hence the indices) to a
    * full sized matrix.
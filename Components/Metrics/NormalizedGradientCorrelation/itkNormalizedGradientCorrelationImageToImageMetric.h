@@ -23,7 +23,7 @@
 #include "itkNeighborhoodOperatorImageFilter.h"
 #include "itkPoint.h"
 #include "itkCastImageFilter.h"
-#include "itkResampleImageFilter.h"
+#include "itkAdvancedRayCastResampleImageFilter.h"
 #include "itkOptimizer.h"
 #include "itkAdvancedCombinationTransform.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
@@ -94,7 +94,8 @@ public:
   using TransformedMovingImageType = itk::Image<FixedImagePixelType, Self::FixedImageDimension>;
   using MaskImageType = itk::Image<unsigned char, Self::FixedImageDimension>;
   using MaskImageTypePointer = typename MaskImageType::Pointer;
-  using TransformMovingImageFilterType = itk::ResampleImageFilter<MovingImageType, TransformedMovingImageType>;
+  using TransformMovingImageFilterType =
+    itk::AdvancedRayCastResampleImageFilter<MovingImageType, TransformedMovingImageType, ScalarType>;
   using TransformMovingImageFilterPointer = typename TransformMovingImageFilterType::Pointer;
   using RayCastInterpolatorType = typename itk::AdvancedRayCastInterpolateImageFunction<MovingImageType, ScalarType>;
   using RayCastInterpolatorPointer = typename RayCastInterpolatorType::Pointer;
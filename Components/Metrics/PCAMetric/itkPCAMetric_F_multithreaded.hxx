@@ -880,11 +880,11 @@ ITK_THREAD_RETURN_TYPE
 PCAMetric<TFixedImage, TMovingImage>::GetSamplesThreaderCallback(void * arg)
 {
   ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
-  ThreadIdType     threadId = infoStruct->WorkUnitID;
 
   PCAMetricMultiThreaderParameterType * temp = static_cast<PCAMetricMultiThreaderParameterType *>(infoStruct->UserData);
 
-  temp->m_Metric->ThreadedGetSamples(threadId);
+  temp->m_Metric->ForEachWorkUnitOfThread(
+    *infoStruct, [temp](const ThreadIdType workUnit) { temp->m_Metric->ThreadedGetSamples(workUnit); });
 
   return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
 
@@ -902,7 +902,7 @@ PCAMetric<TFixedImage, TMovingImage>::LaunchGetSamplesThreaderCallback() const
   /** Setup local threader. */
   // \todo: is a global threader better performance-wise? check
   auto local_threader = ThreaderType::New();
-  local_threader->SetNumberOfWorkUnits(Self::GetNumberOfWorkUnits());
+  local_threader->SetNumberOfWorkUnits(this->m_Threader->GetNumberOfWorkUnits());
   local_threader->SetSingleMethod(this->GetSamplesThreaderCallback,
                                   const_cast<void *>(static_cast<const void *>(&this->m_PCAMetricThreaderParameters)));
 
@@ -1082,11 +1082,11 @@ ITK_THREAD_RETURN_TYPE
 PCAMetric<TFixedImage, TMovingImage>::ComputeDerivativeThreaderCallback(void * arg)
 {
   ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
-  ThreadIdType     threadId = infoStruct->WorkUnitID;
 
   PCAMetricMultiThreaderParameterType * temp = static_cast<PCAMetricMultiThreaderParameterType *>(infoStruct->UserData);
 
-  temp->m_Metric->ThreadedComputeDerivative(threadId);
+  temp->m_Metric->ForEachWorkUnitOfThread(
+    *infoStruct, [temp](const ThreadIdType workUnit) { temp->m_Metric->ThreadedComputeDerivative(workUnit); });
 
   return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
 
@@ -1104,7 +1104,7 @@ PCAMetric<TFixedImage, TMovingImage>::LaunchComputeDerivativeThreaderCallback()
   /** Setup local threader. */
   // \todo: is a global threader better performance-wise? check
   auto local_threader = ThreaderType::New();
-  local_threader->SetNumberOfWorkUnits(Self::GetNumberOfWorkUnits());
+  local_threader->SetNumberOfWorkUnits(this->m_Threader->GetNumberOfWorkUnits());
   local_threader->SetSingleMethod(this->ComputeDerivativeThreaderCallback,
                                   const_cast<void *>(static_cast<const void *>(&this->m_PCAMetricThreaderParameters)));
 
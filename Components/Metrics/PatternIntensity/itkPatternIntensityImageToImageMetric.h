@@ -22,13 +22,15 @@
 
 #include "itkPoint.h"
 #include "itkCastImageFilter.h"
-#include "itkResampleImageFilter.h"
+#include "itkAdvancedRayCastResampleImageFilter.h"
 #include "itkMultiplyImageFilter.h"
 #include "itkSubtractImageFilter.h"
 #include "itkOptimizer.h"
 #include "itkRescaleIntensityImageFilter.h"
 #include "itkAdvancedCombinationTransform.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkFiniteDifferenceDerivativeEstimator.h"
+#include "itkConcurrentPerturbationEvaluator.h"
 
 namespace itk
 {
@@ -110,7 +112,8 @@ public:
   using CombinationTransformPointer = typename CombinationTransformType::Pointer;
   using RayCastInterpolatorType = typename itk::AdvancedRayCastInterpolateImageFunction<MovingImageType, ScalarType>;
   using RayCastInterpolatorPointer = typename RayCastInterpolatorType::Pointer;
-  using TransformMovingImageFilterType = itk::ResampleImageFilter<MovingImageType, TransformedMovingImageType>;
+  using TransformMovingImageFilterType =
+    itk::AdvancedRayCastResampleImageFilter<MovingImageType, TransformedMovingImageType, ScalarType>;
   using TransformMovingImageFilterPointer = typename TransformMovingImageFilterType::Pointer;
   using RescaleIntensityImageFilterType =
     itk::RescaleIntensityImageFilter<TransformedMovingImageType, TransformedMovingImageType>;
@@ -122,6 +125,8 @@ public:
   using MultiplyImageFilterType =
     itk::MultiplyImageFilter<TransformedMovingImageType, TransformedMovingImageType, TransformedMovingImageType>;
   using MultiplyImageFilterPointer = typename MultiplyImageFilterType::Pointer;
+  using DerivativeEstimatorType = FiniteDifferenceDerivativeEstimator;
+  using DerivativeEstimatorPointer = typename DerivativeEstimatorType::Pointer;
 
   /** The moving image dimension. */
   itkStaticConstMacro(MovingImageDimension, unsigned int, MovingImageType::ImageDimension);
@@ -160,6 +165,22 @@ public:
   itkSetMacro(OptimizeNormalizationFactor, bool);
   itkGetConstReferenceMacro(OptimizeNormalizationFactor, bool);
 
+  /** Set/Get whether the values at the perturbed parameters of the finite
+   * difference derivative are computed concurrently. Each thread then uses
+   * its own copy of the transform and its own projection filters. This
+   * requires the transform (chain) to be linear, otherwise the values are
+   * computed one after the other. Default: false.
+   */
+  itkSetMacro(UseConcurrentPerturbations, bool);
+  itkGetConstMacro(UseConcurrentPerturbations, bool);
+  itkBooleanMacro(UseConcurrentPerturbations);
+
+  /** Get the derivative estimator, to select central differences or
+   * simultaneous perturbation. The DerivativeDelta and Scales of this
+   * metric are passed to it in GetDerivative().
+   */
+  itkGetModifiableObjectMacro(DerivativeEstimator, DerivativeEstimatorType);
+
 protected:
   PatternIntensityImageToImageMetric();
   ~PatternIntensityImageToImageMetric() override = default;
@@ -174,6 +195,38 @@ protected:
   MeasureType
   ComputePIDiff(const TransformParametersType & parameters, float scalingfactor) const;
 
+  /** Compute the pattern intensity of the given difference image. Thread-safe. */
+  MeasureType
+  ComputePIDiffOfImage(const TransformedMovingImageType * differenceImage) const;
+
+  using ParametersContainerType = typename DerivativeEstimatorType::ParametersContainerType;
+  using MeasureContainerType = typename DerivativeEstimatorType::MeasureContainerType;
+
+  /** Compute the values at the perturbed parameters, concurrently if possible. */
+  void
+  ComputePerturbedValues(const ParametersContainerType & perturbedParameters, MeasureContainerType & values) const;
+
+  /** The filters that compute the value at one perturbed parameter vector,
+   * independent of the filters of the main pipeline. There is one per thread.
+   */
+  struct PerturbationPipelineType
+    : public PerturbationProjectionPipeline<FixedImageType, MovingImageType, ScalarType>
+  {
+    typename FixedImageType::Pointer FixedImage;
+    MultiplyImageFilterPointer       MultiplyImageFilter;
+    DifferenceImageFilterPointer     DifferenceImageFilter;
+  };
+
+  using PerturbationEvaluatorType = ConcurrentPerturbationEvaluator<PerturbationPipelineType>;
+
+  /** Add the difference filters to a new perturbation pipeline. */
+  void
+  CompletePerturbationPipeline(PerturbationPipelineType & pipeline) const;
+
+  /** Compute the value using a perturbation pipeline, of which the transform has been set. */
+  MeasureType
+  ComputeValueOfPerturbation(PerturbationPipelineType & pipeline) const;
+
 private:
   PatternIntensityImageToImageMetric(const Self &) = delete;
   void
@@ -192,6 +245,12 @@ private:
   ScalesType                         m_Scales;
   MeasureType                        m_FixedMeasure;
   CombinationTransformPointer        m_CombinationTransform;
+
+  bool                       m_UseConcurrentPerturbations{ false };
+  DerivativeEstimatorPointer m_DerivativeEstimator;
+
+  /** Its pipelines are created on demand, and cleared by Initialize(). */
+  mutable PerturbationEvaluatorType m_PerturbationEvaluator;
 };
 
 } // end namespace itk
@@ -50,6 +50,7 @@ PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::PatternIntensityI
   this->m_RescaleImageFilter = RescaleIntensityImageFilterType::New();
   this->m_DifferenceImageFilter = DifferenceImageFilterType::New();
   this->m_MultiplyImageFilter = MultiplyImageFilterType::New();
+  this->m_DerivativeEstimator = DerivativeEstimatorType::New();
 
 } // end Constructor
 
@@ -96,6 +97,9 @@ PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::Initialize()
   this->m_DifferenceImageFilter->UpdateLargestPossibleRegion();
   this->m_FixedMeasure = this->ComputePIFixed();
 
+  /** The perturbation pipelines are connected to the previous images. */
+  this->m_PerturbationEvaluator.Clear();
+
   /* to rescale the similarity measure between 0-1;*/
   MeasureType tmpmeasure = this->GetValue(this->m_Transform->GetParameters());
 
@@ -117,6 +121,8 @@ PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::os
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "DerivativeDelta: " << this->m_DerivativeDelta << std::endl;
+  os << indent << "UseConcurrentPerturbations: " << this->m_UseConcurrentPerturbations << std::endl;
+  os << indent << "DerivativeEstimator: " << this->m_DerivativeEstimator.GetPointer() << std::endl;
 
 } // end PrintSelf()
 
@@ -242,6 +248,21 @@ PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::ComputePIDiff(con
   this->m_TransformMovingImageFilter->Modified();
   this->m_MultiplyImageFilter->SetConstant(scalingfactor);
   this->m_DifferenceImageFilter->UpdateLargestPossibleRegion();
+
+  return this->ComputePIDiffOfImage(this->m_DifferenceImageFilter->GetOutput());
+
+} // end ComputePIDiff()
+
+
+/**
+ * ********************* ComputePIDiffOfImage ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+auto
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::ComputePIDiffOfImage(
+  const TransformedMovingImageType * differenceImage) const -> MeasureType
+{
   MeasureType measure = NumericTraits<MeasureType>::Zero;
   MeasureType diff = NumericTraits<MeasureType>::Zero;
 
@@ -265,7 +286,7 @@ PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::ComputePIDiff(con
   iterationRegion.SetSize(iterationSize);
 
   using DifferenceImageIteratorType = itk::ImageRegionConstIteratorWithIndex<TransformedMovingImageType>;
-  DifferenceImageIteratorType differenceImageIt(this->m_DifferenceImageFilter->GetOutput(), iterationRegion);
+  DifferenceImageIteratorType differenceImageIt(differenceImage, iterationRegion);
   differenceImageIt.GoToBegin();
 
   neighboriterationRegion.SetSize(neighborIterationSize);
@@ -305,7 +326,7 @@ PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::ComputePIDiff(con
       }
 
       neighboriterationRegion.SetIndex(neighborIndex);
-      DifferenceImageIteratorType neighborIt(this->m_DifferenceImageFilter->GetOutput(), neighboriterationRegion);
+      DifferenceImageIteratorType neighborIt(differenceImage, neighboriterationRegion);
       neighborIt.GoToBegin();
 
       while (!neighborIt.IsAtEnd())
@@ -322,7 +343,7 @@ PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::ComputePIDiff(con
 
   return measure;
 
-} // end ComputePIDiff()
+} // end ComputePIDiffOfImage()
 
 
 /**
@@ -396,22 +417,121 @@ void
 PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::GetDerivative(const TransformParametersType & parameters,
                                                                              DerivativeType & derivative) const
 {
-  TransformParametersType testPoint;
-  testPoint = parameters;
-  const unsigned int numberOfParameters = this->GetNumberOfParameters();
-  derivative = DerivativeType(numberOfParameters);
+  this->m_DerivativeEstimator->SetDerivativeDelta(this->m_DerivativeDelta);
+  this->m_DerivativeEstimator->SetScales(this->m_Scales);
+
+  ParametersContainerType perturbedParameters;
+  this->m_DerivativeEstimator->GeneratePerturbedParameters(parameters, perturbedParameters);
+
+  MeasureContainerType values(perturbedParameters.size());
+  this->ComputePerturbedValues(perturbedParameters, values);
+
+  this->m_DerivativeEstimator->ComputeDerivative(values, derivative);
 
-  for (unsigned int i = 0; i < numberOfParameters; ++i)
+} // end GetDerivative()
+
+
+/**
+ * ********************* ComputePerturbedValues ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::ComputePerturbedValues(
+  const ParametersContainerType & perturbedParameters,
+  MeasureContainerType &          values) const
+{
+  /** Compute the values concurrently, one pipeline per thread, if possible. */
+  const auto rayCaster = dynamic_cast<const RayCastInterpolatorType *>(this->m_Interpolator.GetPointer());
+  if (this->m_UseConcurrentPerturbations && rayCaster != nullptr &&
+      this->m_PerturbationEvaluator.ComputeValues(
+        *this->m_Threader,
+        perturbedParameters,
+        *rayCaster,
+        this->m_MovingImage.GetPointer(),
+        this->m_FixedImage.GetPointer(),
+        [this](const TransformParametersType & parameters) { this->SetTransformParameters(parameters); },
+        [this](PerturbationPipelineType & pipeline) { this->CompletePerturbationPipeline(pipeline); },
+        [this](PerturbationPipelineType & pipeline) { return this->ComputeValueOfPerturbation(pipeline); },
+        values))
   {
-    testPoint[i] -= this->m_DerivativeDelta / std::sqrt(this->m_Scales[i]);
-    const MeasureType valuep0 = this->GetValue(testPoint);
-    testPoint[i] += 2 * this->m_DerivativeDelta / std::sqrt(this->m_Scales[i]);
-    const MeasureType valuep1 = this->GetValue(testPoint);
-    derivative[i] = (valuep1 - valuep0) / (2 * this->m_DerivativeDelta / std::sqrt(this->m_Scales[i]));
-    testPoint[i] = parameters[i];
+    return;
   }
 
-} // end GetDerivative()
+  /** Otherwise compute the values one after the other, using the main pipeline. */
+  for (std::size_t k = 0; k < perturbedParameters.size(); ++k)
+  {
+    values[k] = this->GetValue(perturbedParameters[k]);
+  }
+
+} // end ComputePerturbedValues()
+
+
+/**
+ * ********************* CompletePerturbationPipeline ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::CompletePerturbationPipeline(
+  PerturbationPipelineType & pipeline) const
+{
+  /** Like the moving image, the fixed image is grafted, so that the pipelines can be updated concurrently. */
+  pipeline.FixedImage = FixedImageType::New();
+  pipeline.FixedImage->Graft(this->m_FixedImage);
+
+  pipeline.MultiplyImageFilter = MultiplyImageFilterType::New();
+  pipeline.MultiplyImageFilter->SetNumberOfWorkUnits(1);
+  pipeline.MultiplyImageFilter->SetInput(pipeline.Projector->GetOutput());
+
+  pipeline.DifferenceImageFilter = DifferenceImageFilterType::New();
+  pipeline.DifferenceImageFilter->SetNumberOfWorkUnits(1);
+  pipeline.DifferenceImageFilter->SetInput1(pipeline.FixedImage);
+  pipeline.DifferenceImageFilter->SetInput2(pipeline.MultiplyImageFilter->GetOutput());
+
+} // end CompletePerturbationPipeline()
+
+
+/**
+ * ********************* ComputeValueOfPerturbation ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+auto
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::ComputeValueOfPerturbation(
+  PerturbationPipelineType & pipeline) const -> MeasureType
+{
+  /** As in GetValue(), but using the filters of the given pipeline. */
+  if (!this->m_OptimizeNormalizationFactor)
+  {
+    pipeline.MultiplyImageFilter->SetConstant(this->m_NormalizationFactor);
+    pipeline.DifferenceImageFilter->UpdateLargestPossibleRegion();
+    const MeasureType measure = this->ComputePIDiffOfImage(pipeline.DifferenceImageFilter->GetOutput());
+    return -(measure - this->m_FixedMeasure) / this->m_Rescalingfactor;
+  }
+
+  MeasureType currentMeasure = 1e10;
+  float       tmpfactor = 0.0;
+  float       factorstep = (this->m_NormalizationFactor * 10 - tmpfactor) / 100;
+
+  while (tmpfactor <= this->m_NormalizationFactor * 1.0)
+  {
+    pipeline.MultiplyImageFilter->SetConstant(tmpfactor);
+    pipeline.DifferenceImageFilter->UpdateLargestPossibleRegion();
+    const MeasureType measure = this->ComputePIDiffOfImage(pipeline.DifferenceImageFilter->GetOutput());
+    const MeasureType tmpMeasure = (measure - this->m_FixedMeasure) / -this->m_Rescalingfactor;
+
+    if (tmpMeasure < currentMeasure)
+    {
+      currentMeasure = tmpMeasure;
+    }
+
+    tmpfactor += factorstep;
+  }
+
+  return currentMeasure;
+
+} // end ComputeValueOfPerturbation()
 
 
 /**
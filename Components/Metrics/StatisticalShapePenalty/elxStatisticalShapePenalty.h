@@ -43,6 +43,18 @@ using namespace itk;
  * \parameter BaseVariance: The width ($\sigma_0^2$) of the non-informative prior.
  *   Can be defined for each resolution\n
  *    example: <tt>(BaseVariance 1000.0)</tt>
+ * \parameter ShapeModelCalculation: The way the Mahalanobis distance is computed:
+ *   0: the inverse of the full (regularized) covariance matrix is used;
+ *   1: the covariance matrix is decomposed (only for NormalizedShapeModel false);
+ *   2: the scaled covariance matrix is decomposed (only for NormalizedShapeModel true);
+ *   3: low-rank: only the principal components, provided by the -evectors and
+ *   -evalues command line arguments, are used. The -covariance argument is then
+ *   optional. This is recommended for shapes with many points.\n
+ *    example: <tt>(ShapeModelCalculation 3)</tt>\n
+ *   The default is 0.
+ * \parameter UseMultiThreadingForMetrics: Whether the points are processed multi-threaded.\n
+ *    example: <tt>(UseMultiThreadingForMetrics "true")</tt>\n
+ *   The default is "true".
  *
  * \author F.F. Berendsen, Image Sciences Institute, UMC Utrecht, The Netherlands
  * \note This work was funded by the projects Care4Me and Mediate.
@@ -64,7 +64,7 @@ StatisticalShapePenalty<TElastix>::BeforeRegistration()
   this->GetConfiguration()->ReadParameter(normalizedShapeModel, "NormalizedShapeModel", 0, 0);
   this->SetNormalizedShapeModel(normalizedShapeModel);
 
-  /** Get and set NormalizedShapeModel. Default TRUE. */
+  /** Get and set ShapeModelCalculation. Default 0. */
   int shapeModelCalculation = 0;
   this->GetConfiguration()->ReadParameter(shapeModelCalculation, "ShapeModelCalculation", 0, 0);
   this->SetShapeModelCalculation(shapeModelCalculation);
@@ -134,7 +134,7 @@ StatisticalShapePenalty<TElastix>::BeforeRegistration()
     datafile.clear();
     elxout << "covarianceMatrix " << covarianceMatrixName << " read" << std::endl;
   }
-  else
+  else if (shapeModelCalculation != 3)
   {
     itkExceptionMacro(<< "Unable to open covarianceMatrix file: " << covarianceMatrixName);
   }
@@ -42,6 +42,22 @@ namespace itk
  * \brief Computes the Mahalanobis distance between the transformed shape and a mean shape.
  *  A model mean and covariance are required.
  *
+ * The way the Mahalanobis distance is computed is selected by ShapeModelCalculation:
+ * \li 0: The regularized covariance matrix is inverted (full covariance).
+ * \li 1: The covariance matrix is decomposed, and uniformly regularized.
+ *   Only implemented for NormalizedShapeModel = false.
+ * \li 2: The scaled covariance matrix is decomposed, and regularized per element.
+ *   Only implemented for NormalizedShapeModel = true.
+ * \li 3: Low-rank: the provided eigenvectors and eigenvalues (principal components)
+ *   are used directly, without the covariance matrix. The inverse of the
+ *   regularized covariance is then applied by means of the Woodbury identity,
+ *   so the cost is linear in the shape length and in the number of components.
+ *
+ * The derivative is computed as the gradient of the distance with respect to
+ * the (normalized) proposal shape, which is then back-propagated to the points
+ * and multiplied with the Jacobian of each point. The points are processed
+ * multi-threaded if UseMultiThread is true.
+ *
  * \author F.F. Berendsen, Image Sciences Institute, UMC Utrecht, The Netherlands
  * \note This work was funded by the projects Care4Me and Mediate.
  * \note If you use the StatisticalShapePenalty anywhere we would appreciate if you cite the following article:\n
@@ -86,6 +102,8 @@ public:
 
   using typename Superclass::PointIterator;
   using typename Superclass::PointDataIterator;
+  using typename Superclass::ThreaderType;
+  using typename Superclass::ThreadInfoType;
 
   using typename Superclass::InputPointType;
   using typename Superclass::OutputPointType;
@@ -93,9 +111,6 @@ public:
   using CoordRepType = typename OutputPointType::CoordRepType;
   using VnlVectorType = vnl_vector<CoordRepType>;
   using VnlMatrixType = vnl_matrix<CoordRepType>;
-  // typedef itk::Array<VnlVectorType *> ProposalDerivativeType;
-  using ProposalDerivativeType = typename std::vector<VnlVectorType *>;
-  // typedef typename vnl_vector<VnlVectorType *> ProposalDerivativeType; //Cannot be linked
   using PCACovarianceType = vnl_svd_economy<CoordRepType>;
 
   /** Initialization. */
@@ -183,14 +198,34 @@ private:
   void
   FillProposalVector(const OutputPointType & fixedPoint, const unsigned int vertexindex) const;
 
+  /** Fill the proposal vector with the mapped points in [ first, last [. */
   void
-  FillProposalDerivative(const OutputPointType & fixedPoint, const unsigned int vertexindex) const;
+  FillProposalVectorOfRange(const SizeValueType first, const SizeValueType last) const;
 
+  /** Add the derivative contributions of the points in [ first, last [,
+   * i.e. the point gradients multiplied with the transform Jacobians.
+   */
   void
-  UpdateCentroidAndAlignProposalVector(const unsigned int shapeLength) const;
+  ComputeDerivativeOfRange(const SizeValueType first, const SizeValueType last, const ThreadIdType threadID) const;
 
+  /** Call FillProposalVectorOfRange() or ComputeDerivativeOfRange() for all
+   * points, multi-threaded if requested.
+   */
   void
-  UpdateCentroidAndAlignProposalDerivative(const unsigned int shapeLength) const;
+  ProcessPoints(const bool computeDerivative) const;
+
+  /** Threader callback. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ProcessPointsThreaderCallback(void * arg);
+
+  struct ProcessPointsThreaderParameterType
+  {
+    const Self * st_Metric;
+    bool         st_ComputeDerivative;
+  };
+
+  void
+  UpdateCentroidAndAlignProposalVector(const unsigned int shapeLength) const;
 
   void
   UpdateL2(const unsigned int shapeLength) const;
@@ -198,8 +233,12 @@ private:
   void
   NormalizeProposalVector(const unsigned int shapeLength) const;
 
+  /** Back-propagate the gradient with respect to the normalized proposal vector
+   * through the size normalization and centroid alignment. On return, the first
+   * shapeLength elements contain the gradient with respect to the mapped points.
+   */
   void
-  UpdateL2AndNormalizeProposalDerivative(const unsigned int shapeLength) const;
+  UpdateCentroidAndL2ProposalGradient(VnlVectorType & proposalGradient, const unsigned int shapeLength) const;
 
   void
   CalculateValue(MeasureType &   value,
@@ -207,13 +246,25 @@ private:
                  VnlVectorType & centerrotated,
                  VnlVectorType & eigrot) const;
 
+  /** Compute the gradient of the squared distance (divided by two) with
+   * respect to the proposal vector.
+   */
   void
-  CalculateDerivative(DerivativeType &      derivative,
-                      const MeasureType &   value,
-                      const VnlVectorType & differenceVector,
-                      const VnlVectorType & centerrotated,
-                      const VnlVectorType & eigrot,
-                      const unsigned int    shapeLength) const;
+  CalculateProposalGradient(const VnlVectorType & differenceVector,
+                            const VnlVectorType & eigrot,
+                            VnlVectorType &       proposalGradient) const;
+
+  /** Compute the factors of the low-rank representation of the inverse
+   * regularized covariance matrix, for ShapeModelCalculation 3.
+   */
+  void
+  InitializeLowRankModel(const unsigned int shapeLength);
+
+  /** Returns the diagonal of the covariance matrix, or, if no covariance
+   * matrix is provided, the diagonal of its principal components representation.
+   */
+  VnlVectorType
+  GetCovarianceDiagonal() const;
 
   void
   CalculateCutOffValue(MeasureType & value) const;
@@ -243,15 +294,24 @@ private:
 
   VnlVectorType * m_EigenValuesRegularized;
 
-  mutable ProposalDerivativeType * m_ProposalDerivative;
-  unsigned int                     m_ProposalLength;
-  bool                             m_NormalizedShapeModel;
-  int                              m_ShapeModelCalculation;
-  double                           m_ShrinkageIntensity;
-  double                           m_BaseVariance;
-  double                           m_BaseStd;
-  mutable VnlVectorType            m_ProposalVector;
-  mutable VnlVectorType            m_MeanValues;
+  /** The low-rank inverse of the regularized covariance matrix:
+   * diag( m_LowRankDiagonal ) - m_LowRankBasis * m_LowRankCore * m_LowRankBasis^T.
+   */
+  VnlVectorType m_LowRankDiagonal;
+  VnlMatrixType m_LowRankBasis;
+  VnlMatrixType m_LowRankCore;
+
+  unsigned int          m_ProposalLength;
+  bool                  m_NormalizedShapeModel;
+  int                   m_ShapeModelCalculation;
+  double                m_ShrinkageIntensity;
+  double                m_BaseVariance;
+  double                m_BaseStd;
+  mutable VnlVectorType m_ProposalVector;
+  mutable VnlVectorType m_MeanValues;
+
+  /** The gradient of the distance with respect to the mapped points. */
+  mutable VnlVectorType m_PointGradient;
 
   double m_CutOffValue;
   double m_CutOffSharpness;
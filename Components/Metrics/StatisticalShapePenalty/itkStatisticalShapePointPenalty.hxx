@@ -19,7 +19,10 @@
 #define itkStatisticalShapePointPenalty_hxx
 
 #include "itkStatisticalShapePointPenalty.h"
+
+#include <algorithm> // For min and max.
 #include <cmath>
+#include <vector>
 
 namespace itk
 {
@@ -31,10 +34,10 @@ template <class TFixedPointSet, class TMovingPointSet>
 StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::StatisticalShapePointPenalty()
 {
   this->m_MeanVector = nullptr;
+  this->m_CovarianceMatrix = nullptr;
   this->m_EigenVectors = nullptr;
   this->m_EigenValues = nullptr;
   this->m_EigenValuesRegularized = nullptr;
-  this->m_ProposalDerivative = nullptr;
   this->m_InverseCovarianceMatrix = nullptr;
 
   this->m_ShrinkageIntensityNeedsUpdate = true;
@@ -76,11 +79,6 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::~StatisticalShape
     delete this->m_EigenValuesRegularized;
     this->m_EigenValuesRegularized = nullptr;
   }
-  if (this->m_ProposalDerivative != nullptr)
-  {
-    delete this->m_ProposalDerivative;
-    this->m_ProposalDerivative = nullptr;
-  }
   if (this->m_InverseCovarianceMatrix != nullptr)
   {
     delete this->m_InverseCovarianceMatrix;
@@ -110,7 +108,7 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::Initialize()
     if (this->m_BaseVariance == -1.0 || this->m_CentroidXVariance == -1.0 || this->m_CentroidYVariance == -1.0 ||
         this->m_CentroidZVariance == -1.0 || this->m_SizeVariance == -1.0)
     {
-      vnl_vector<double> covDiagonal = this->m_CovarianceMatrix->get_diagonal();
+      const VnlVectorType covDiagonal = this->GetCovarianceDiagonal();
       if (this->m_BaseVariance == -1.0)
       {
         this->m_BaseVariance = covDiagonal.extract(shapeLength).mean();
@@ -139,7 +137,7 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::Initialize()
     /** Automatic selection of regularization variances. */
     if (this->m_BaseVariance == -1.0)
     {
-      vnl_vector<double> covDiagonal = this->m_CovarianceMatrix->get_diagonal();
+      const VnlVectorType covDiagonal = this->GetCovarianceDiagonal();
       this->m_BaseVariance = covDiagonal.extract(shapeLength).mean();
     } // End automatic selection of regularization variances.
   }
@@ -171,6 +169,7 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::Initialize()
          * invertible Covariance Matrix. For a Moore-Penrose pseudo inverse use
          * ShrinkageIntensity=0 and ShapeModelCalculation=1 or 2.
          */
+        delete this->m_InverseCovarianceMatrix;
         this->m_InverseCovarianceMatrix = new vnl_matrix<double>(vnl_svd_inverse(regularizedCovariance));
       }
       this->m_EigenValuesRegularized = nullptr;
@@ -329,6 +328,13 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::Initialize()
       this->m_InverseCovarianceMatrix = nullptr;
     }
     break;
+    case 3: // principal components only (low-rank)
+    {
+      this->InitializeLowRankModel(shapeLength);
+      this->m_InverseCovarianceMatrix = nullptr;
+      this->m_EigenValuesRegularized = nullptr;
+    }
+    break;
     default:
       this->m_InverseCovarianceMatrix = nullptr;
       this->m_EigenValuesRegularized = nullptr;
@@ -337,6 +343,136 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::Initialize()
 } // end Initialize()
 
 
+/**
+ * *********************** InitializeLowRankModel *****************************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+void
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::InitializeLowRankModel(const unsigned int shapeLength)
+{
+  if (this->m_EigenVectors == nullptr || this->m_EigenValues == nullptr || this->m_EigenValues->empty())
+  {
+    itkExceptionMacro(<< "ShapeModelCalculation option 3 requires the eigenvectors and eigenvalues");
+  }
+  if (this->m_EigenVectors->rows() != this->m_ProposalLength ||
+      this->m_EigenVectors->cols() != this->m_EigenValues->size())
+  {
+    itkExceptionMacro(<< "The eigenvector matrix (" << this->m_EigenVectors->rows() << "x"
+                      << this->m_EigenVectors->cols() << ") does not match the shape length ("
+                      << this->m_ProposalLength << ") and the number of eigenvalues ("
+                      << this->m_EigenValues->size() << ")");
+  }
+
+  /** Only the components with a non-zero eigenvalue are used. With full
+   * regularization (ShrinkageIntensity 1) the model does not contribute at all.
+   */
+  std::vector<unsigned int> components;
+  if (this->m_ShrinkageIntensity < 1.0)
+  {
+    for (unsigned int k = 0; k < this->m_EigenValues->size(); ++k)
+    {
+      if ((*this->m_EigenValues)[k] > 1e-14)
+      {
+        components.push_back(k);
+      }
+    }
+  }
+  const unsigned int numberOfComponents = components.size();
+
+  /** The regularization variances, as in ShapeModelCalculation option 0. */
+  VnlVectorType regularizationVariances(this->m_ProposalLength, this->m_BaseVariance);
+  if (this->m_NormalizedShapeModel)
+  {
+    regularizationVariances[shapeLength] = this->m_CentroidXVariance;
+    regularizationVariances[shapeLength + 1] = this->m_CentroidYVariance;
+    regularizationVariances[shapeLength + 2] = this->m_CentroidZVariance;
+    regularizationVariances[shapeLength + 3] = this->m_SizeVariance;
+  }
+
+  /** With regularization, the Woodbury identity gives
+   * ( beta D + (1-beta) V Lambda V^T )^-1 = A - A V ( ((1-beta) Lambda)^-1 + V^T A V )^-1 V^T A,
+   * with A = ( beta D )^-1. Without regularization, the pseudo inverse V Lambda^-1 V^T is used.
+   */
+  VnlMatrixType eigenVectors(this->m_ProposalLength, numberOfComponents);
+  for (unsigned int k = 0; k < numberOfComponents; ++k)
+  {
+    eigenVectors.set_column(k, this->m_EigenVectors->get_column(components[k]));
+  }
+
+  this->m_LowRankCore.set_size(numberOfComponents, numberOfComponents);
+  if (this->m_ShrinkageIntensity != 0)
+  {
+    this->m_LowRankDiagonal.set_size(this->m_ProposalLength);
+    for (unsigned int i = 0; i < this->m_ProposalLength; ++i)
+    {
+      this->m_LowRankDiagonal[i] = 1.0 / (this->m_ShrinkageIntensity * regularizationVariances[i]);
+    }
+
+    this->m_LowRankBasis = eigenVectors;
+    for (unsigned int i = 0; i < this->m_ProposalLength; ++i)
+    {
+      this->m_LowRankBasis.scale_row(i, this->m_LowRankDiagonal[i]);
+    }
+
+    VnlMatrixType core = eigenVectors.transpose() * this->m_LowRankBasis;
+    for (unsigned int k = 0; k < numberOfComponents; ++k)
+    {
+      core(k, k) += 1.0 / ((1.0 - this->m_ShrinkageIntensity) * (*this->m_EigenValues)[components[k]]);
+    }
+    if (numberOfComponents > 0)
+    {
+      this->m_LowRankCore = vnl_svd_inverse(core);
+    }
+  }
+  else
+  {
+    this->m_LowRankDiagonal.set_size(this->m_ProposalLength);
+    this->m_LowRankDiagonal.fill(0.0);
+    this->m_LowRankBasis = eigenVectors;
+    this->m_LowRankCore.fill(0.0);
+    for (unsigned int k = 0; k < numberOfComponents; ++k)
+    {
+      this->m_LowRankCore(k, k) = -1.0 / (*this->m_EigenValues)[components[k]];
+    }
+  }
+
+} // end InitializeLowRankModel()
+
+
+/**
+ * *********************** GetCovarianceDiagonal *****************************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+auto
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetCovarianceDiagonal() const -> VnlVectorType
+{
+  if (this->m_CovarianceMatrix != nullptr && !this->m_CovarianceMatrix->empty())
+  {
+    return this->m_CovarianceMatrix->get_diagonal();
+  }
+  if (this->m_EigenVectors == nullptr || this->m_EigenValues == nullptr ||
+      this->m_EigenVectors->cols() != this->m_EigenValues->size())
+  {
+    itkExceptionMacro(<< "Either the covariance matrix, or the eigenvectors and eigenvalues are required");
+  }
+
+  /** diag( V Lambda V^T ) */
+  VnlVectorType covDiagonal(this->m_EigenVectors->rows(), 0.0);
+  for (unsigned int i = 0; i < this->m_EigenVectors->rows(); ++i)
+  {
+    for (unsigned int k = 0; k < this->m_EigenValues->size(); ++k)
+    {
+      const double v = (*this->m_EigenVectors)(i, k);
+      covDiagonal[i] += (*this->m_EigenValues)[k] * v * v;
+    }
+  }
+  return covDiagonal;
+
+} // end GetCovarianceDiagonal()
+
+
 /**
  * ******************* GetValue *******************
  */
@@ -354,12 +490,8 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValue(
   }
 
   /** Initialize some variables */
-  // this->m_NumberOfPointsCounted = 0;
   MeasureType value = NumericTraits<MeasureType>::Zero;
 
-  // InputPointType movingPoint;
-  OutputPointType fixedPoint;
-
   /** Make sure the transform parameters are up to date. */
   this->SetTransformParameters(parameters);
 
@@ -369,22 +501,8 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValue(
   /** Part 1:
    * - Copy point positions in proposal vector
    */
-
-  /** Create iterators. */
-  PointIterator pointItFixed = fixedPointSet->GetPoints()->Begin();
-  PointIterator pointEnd = fixedPointSet->GetPoints()->End();
-
-  unsigned int vertexindex = 0;
-  /** Loop over the corresponding points. */
-  while (pointItFixed != pointEnd)
-  {
-    fixedPoint = pointItFixed.Value();
-    this->FillProposalVector(fixedPoint, vertexindex);
-
-    this->m_NumberOfPointsCounted++;
-    ++pointItFixed;
-    vertexindex += Self::FixedPointSetDimension;
-  } // end loop over all corresponding points
+  this->ProcessPoints(false);
+  this->m_NumberOfPointsCounted = fixedPointSet->GetNumberOfPoints();
 
   if (this->m_NormalizedShapeModel)
   {
@@ -454,43 +572,21 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDeriva
   }
 
   /** Initialize some variables */
-  // this->m_NumberOfPointsCounted = 0;
   value = NumericTraits<MeasureType>::Zero;
-  derivative = DerivativeType(this->GetNumberOfParameters());
+  derivative.SetSize(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
 
-  // InputPointType movingPoint;
-  OutputPointType fixedPoint;
-
   /** Make sure the transform parameters are up to date. */
   this->SetTransformParameters(parameters);
 
   const unsigned int shapeLength = Self::FixedPointSetDimension * fixedPointSet->GetNumberOfPoints();
-
   this->m_ProposalVector.set_size(this->m_ProposalLength);
-  this->m_ProposalDerivative = new ProposalDerivativeType(this->GetNumberOfParameters(), nullptr);
 
   /** Part 1:
    * - Copy point positions in proposal vector
-   * - Copy point derivatives in proposal derivative vector
    */
-
-  /** Create iterators. */
-  PointIterator pointItFixed = fixedPointSet->GetPoints()->Begin();
-  PointIterator pointEnd = fixedPointSet->GetPoints()->End();
-
-  unsigned int vertexindex = 0;
-  /** Loop over the corresponding points. */
-  while (pointItFixed != pointEnd)
-  {
-    fixedPoint = pointItFixed.Value();
-    this->FillProposalVector(fixedPoint, vertexindex);
-    this->FillProposalDerivative(fixedPoint, vertexindex);
-
-    this->m_NumberOfPointsCounted++;
-    ++pointItFixed;
-    vertexindex += Self::FixedPointSetDimension;
-  } // end loop over all corresponding points
+  this->ProcessPoints(false);
+  this->m_NumberOfPointsCounted = fixedPointSet->GetNumberOfPoints();
 
   if (this->m_NormalizedShapeModel)
   {
@@ -498,28 +594,19 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDeriva
      * - Calculate shape centroid
      * - put centroid values in proposal
      * - update proposal vector with aligned shape
-     * - Calculate centroid derivatives and update proposal derivative vectors
-     * - put centroid derivatives values in proposal derivatives
-     * - update proposal derivatives
      */
     this->UpdateCentroidAndAlignProposalVector(shapeLength);
-    this->UpdateCentroidAndAlignProposalDerivative(shapeLength);
 
     /** Part 3:
      * - Calculate l2-norm from aligned shapes
      * - put l2-norm value in proposal vector
      * - update proposal vector with size normalized shape
-     * - Calculate l2-norm derivatice from updated proposal vector
-     * - put l2-norm derivative value in proposal derivative vectors
-     * - update proposal derivatives
      */
     this->UpdateL2(shapeLength);
-    this->UpdateL2AndNormalizeProposalDerivative(shapeLength);
     this->NormalizeProposalVector(shapeLength);
 
   } // end if(m_NormalizedShapeModel)
 
-  // TODO this declaration instantiates a zero sized vector, but it will be reassigned anyways.
   VnlVectorType differenceVector;
   VnlVectorType centerrotated;
   VnlVectorType eigrot;
@@ -528,22 +615,27 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDeriva
 
   if (value != 0.0)
   {
-    this->CalculateDerivative(derivative, value, differenceVector, centerrotated, eigrot, shapeLength);
-  }
-  else
-  {
-    typename ProposalDerivativeType::iterator proposalDerivativeIt = this->m_ProposalDerivative->begin();
-    typename ProposalDerivativeType::iterator proposalDerivativeEnd = this->m_ProposalDerivative->end();
-    for (; proposalDerivativeIt != proposalDerivativeEnd; ++proposalDerivativeIt)
+    /** Part 4:
+     * - Calculate the gradient of the distance with respect to the proposal vector
+     * - back-propagate it through the normalization to the mapped points
+     */
+    VnlVectorType proposalGradient;
+    this->CalculateProposalGradient(differenceVector, eigrot, proposalGradient);
+    if (this->m_NormalizedShapeModel)
     {
-      if (*proposalDerivativeIt != nullptr)
-      {
-        delete (*proposalDerivativeIt);
-      }
+      this->UpdateCentroidAndL2ProposalGradient(proposalGradient, shapeLength);
     }
+
+    MeasureType scale = 1.0 / value;
+    this->CalculateCutOffDerivative(scale, value);
+    this->m_PointGradient = proposalGradient.extract(shapeLength) * scale;
+
+    /** Part 5:
+     * - Multiply the point gradients with the transform Jacobians of the points
+     */
+    this->ProcessPoints(true);
+    this->AccumulateDerivatives(derivative, 1.0);
   }
-  delete this->m_ProposalDerivative;
-  this->m_ProposalDerivative = nullptr;
 
   this->CalculateCutOffValue(value);
 
@@ -572,52 +664,132 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::FillProposalVecto
 
 
 /**
- * ******************* FillProposalDerivative *******************
+ * ******************* FillProposalVectorOfRange *******************
  */
 
 template <class TFixedPointSet, class TMovingPointSet>
 void
-StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::FillProposalDerivative(
-  const OutputPointType & fixedPoint,
-  const unsigned int      vertexindex) const
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::FillProposalVectorOfRange(
+  const SizeValueType first,
+  const SizeValueType last) const
 {
-  /**
-   * A (column) vector is constructed for each mu, only if that mu affects the shape penalty.
-   * I.e. if there is at least one point of the mesh with non-zero derivatives,
-   * a full column vector is instantiated (which can contain zeros for many other points)
-   *
-   * m_ProposalDerivative is a container with either full shape-vector-sized derivative vectors or NULL-s. Example:
-   *
-   * mu1: [ [ dx1/dmu1 , dy1/dmu1 , dz1/dmu1 ] , [ 0 , 0 , 0 ] , [ dx3/dmu1 , dy3/dmu1 , dz3/dmu1 ] , [...] ]^T
-   * mu2: Null
-   * mu3: [ [ 0 , 0 , 0 ] , [ dx2/dmu3 , dy2/dmu3 , dz2/dmu3 ] , [ dx3/dmu3 , dy3/dmu3 , dz3/dmu3 ] , [...] ]^T
-   *
-   */
+  const auto & fixedPoints = *this->GetFixedPointSet()->GetPoints();
+  for (SizeValueType pointID = first; pointID < last; ++pointID)
+  {
+    this->FillProposalVector(fixedPoints.ElementAt(pointID), pointID * Self::FixedPointSetDimension);
+  }
+
+} // end FillProposalVectorOfRange()
 
-  NonZeroJacobianIndicesType nzji(this->m_Transform->GetNumberOfNonZeroJacobianIndices());
 
-  /** Get the TransformJacobian dT/dmu. */
-  TransformJacobianType jacobian;
-  this->m_Transform->GetJacobian(fixedPoint, jacobian, nzji);
+/**
+ * ******************* ComputeDerivativeOfRange *******************
+ */
 
-  for (unsigned int i = 0; i < nzji.size(); ++i)
+template <class TFixedPointSet, class TMovingPointSet>
+void
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::ComputeDerivativeOfRange(
+  const SizeValueType first,
+  const SizeValueType last,
+  const ThreadIdType  threadID) const
+{
+  DerivativeType &           derivative = this->m_GetValueAndDerivativePerThreadVariables[threadID].st_Derivative;
+  NonZeroJacobianIndicesType nzji(this->m_Transform->GetNumberOfNonZeroJacobianIndices());
+  TransformJacobianType      jacobian;
+
+  const auto & fixedPoints = *this->GetFixedPointSet()->GetPoints();
+  for (SizeValueType pointID = first; pointID < last; ++pointID)
   {
-    const unsigned int mu = nzji[i];
-    if ((*this->m_ProposalDerivative)[mu] == nullptr)
+    /** Get the TransformJacobian dT/dmu. */
+    this->m_Transform->GetJacobian(fixedPoints.ElementAt(pointID), jacobian, nzji);
+
+    /** d distance / dmu = sum_d d distance / dx_d * dx_d / dmu */
+    const unsigned int vertexindex = pointID * Self::FixedPointSetDimension;
+    for (unsigned int i = 0; i < nzji.size(); ++i)
     {
-      /** Create the big column vector if it does not yet exist for this mu*/
-      (*this->m_ProposalDerivative)[mu] = new VnlVectorType(this->m_ProposalLength, 0.0);
-      // memory will be freed in CalculateDerivative()
+      DerivativeValueType sum = NumericTraits<DerivativeValueType>::ZeroValue();
+      for (unsigned int d = 0; d < Self::FixedPointSetDimension; ++d)
+      {
+        sum += this->m_PointGradient[vertexindex + d] * jacobian(d, i);
+      }
+      derivative[nzji[i]] += sum;
     }
+  }
+
+} // end ComputeDerivativeOfRange()
+
+
+/**
+ * ******************* ProcessPoints *******************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+void
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::ProcessPoints(const bool computeDerivative) const
+{
+  if (computeDerivative)
+  {
+    this->InitializeThreadingParameters();
+  }
 
-    /** The column vector exists for this mu, so copy the jacobians for this point into the big vector. */
-    for (unsigned int d = 0; d < Self::FixedPointSetDimension; ++d)
+  if (this->GetNumberOfThreadsForComputation() == 1)
+  {
+    const SizeValueType numberOfPoints = this->GetFixedPointSet()->GetNumberOfPoints();
+    if (computeDerivative)
+    {
+      this->ComputeDerivativeOfRange(0, numberOfPoints, 0);
+    }
+    else
     {
-      (*(*this->m_ProposalDerivative)[mu])[vertexindex + d] = jacobian.get_column(i)[d];
+      this->FillProposalVectorOfRange(0, numberOfPoints);
     }
+    return;
   }
 
-} // end FillProposalVector()
+  ProcessPointsThreaderParameterType threaderParameters;
+  threaderParameters.st_Metric = this;
+  threaderParameters.st_ComputeDerivative = computeDerivative;
+
+  this->m_Threader->SetSingleMethod(this->ProcessPointsThreaderCallback, &threaderParameters);
+  this->m_Threader->SingleMethodExecute();
+
+} // end ProcessPoints()
+
+
+/**
+ * ******************* ProcessPointsThreaderCallback *******************
+ */
+
+template <class TFixedPointSet, class TMovingPointSet>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::ProcessPointsThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  const auto * temp = static_cast<ProcessPointsThreaderParameterType *>(infoStruct->UserData);
+
+  /** Each thread processes a contiguous range of points, so that it writes
+   * to its own part of the proposal vector.
+   */
+  const SizeValueType numberOfPoints = temp->st_Metric->GetFixedPointSet()->GetNumberOfPoints();
+  const SizeValueType subSize = (numberOfPoints + nrOfThreads - 1) / nrOfThreads;
+  const SizeValueType first = std::min<SizeValueType>(threadID * subSize, numberOfPoints);
+  const SizeValueType last = std::min<SizeValueType>(first + subSize, numberOfPoints);
+
+  if (temp->st_ComputeDerivative)
+  {
+    temp->st_Metric->ComputeDerivativeOfRange(first, last, threadID);
+  }
+  else
+  {
+    temp->st_Metric->FillProposalVectorOfRange(first, last);
+  }
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ProcessPointsThreaderCallback()
 
 
 /**
@@ -656,44 +828,6 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::UpdateCentroidAnd
 } // end UpdateCentroidAndAlignProposalVector()
 
 
-/**
- * ******************* UpdateCentroidAndAlignProposalDerivative *******************
- */
-
-template <class TFixedPointSet, class TMovingPointSet>
-void
-StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::UpdateCentroidAndAlignProposalDerivative(
-  const unsigned int shapeLength) const
-{
-  typename ProposalDerivativeType::iterator proposalDerivativeIt = m_ProposalDerivative->begin();
-  typename ProposalDerivativeType::iterator proposalDerivativeEnd = m_ProposalDerivative->end();
-  while (proposalDerivativeIt != proposalDerivativeEnd)
-  {
-    if (*proposalDerivativeIt != nullptr)
-    {
-      for (unsigned int d = 0; d < Self::FixedPointSetDimension; ++d)
-      {
-        double & centroid_dDerivative = (**proposalDerivativeIt)[shapeLength + d];
-        centroid_dDerivative = 0; // initialize accumulators to zero
-
-        for (unsigned int index = 0; index < shapeLength; index += Self::FixedPointSetDimension)
-        {
-          centroid_dDerivative += (**proposalDerivativeIt)[index + d]; // sum all x derivatives
-        }
-
-        centroid_dDerivative /= this->GetFixedPointSet()->GetNumberOfPoints(); // divide sum to get average
-
-        for (unsigned int index = 0; index < shapeLength; index += Self::FixedPointSetDimension)
-        {
-          (**proposalDerivativeIt)[index + d] -= centroid_dDerivative; // subtract average
-        }
-      }
-    }
-    ++proposalDerivativeIt;
-  }
-} // end UpdateCentroidAndAlignProposalDerivative()
-
-
 /**
  * ******************* UpdateL2 *******************
  */
@@ -738,44 +872,51 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::NormalizeProposal
 
 
 /**
- * ******************* UpdateL2AndNormalizeProposalDerivative *******************
+ * ******************* UpdateCentroidAndL2ProposalGradient *******************
  */
 
 template <class TFixedPointSet, class TMovingPointSet>
 void
-StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::UpdateL2AndNormalizeProposalDerivative(
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::UpdateCentroidAndL2ProposalGradient(
+  VnlVectorType &    proposalGradient,
   const unsigned int shapeLength) const
 {
-  double & l2norm = this->m_ProposalVector[shapeLength + Self::FixedPointSetDimension];
+  const double numberOfPoints = this->GetFixedPointSet()->GetNumberOfPoints();
+  const double l2norm = this->m_ProposalVector[shapeLength + Self::FixedPointSetDimension];
 
-  typename ProposalDerivativeType::iterator proposalDerivativeIt = this->m_ProposalDerivative->begin();
-  typename ProposalDerivativeType::iterator proposalDerivativeEnd = this->m_ProposalDerivative->end();
+  /** The size normalization: the proposal vector contains the normalized shape
+   * y = x / l2norm, with x the aligned shape, for which
+   * d l2norm = x^T dx / ( l2norm * numberOfPoints ) = y^T dx / numberOfPoints.
+   */
+  double gradientDotShape = 0.0;
+  for (unsigned int index = 0; index < shapeLength; ++index)
+  {
+    gradientDotShape += proposalGradient[index] * this->m_ProposalVector[index];
+  }
+  const double l2normGradient =
+    proposalGradient[shapeLength + Self::FixedPointSetDimension] - gradientDotShape / l2norm;
+  const double l2normFactor = l2normGradient / numberOfPoints;
+  for (unsigned int index = 0; index < shapeLength; ++index)
+  {
+    proposalGradient[index] = proposalGradient[index] / l2norm + l2normFactor * this->m_ProposalVector[index];
+  }
 
-  while (proposalDerivativeIt != proposalDerivativeEnd)
+  /** The centroid alignment: x = p - centroid, with centroid the average of p. */
+  for (unsigned int d = 0; d < Self::FixedPointSetDimension; ++d)
   {
-    if (*proposalDerivativeIt != nullptr)
+    double alignedGradientSum = 0.0;
+    for (unsigned int index = 0; index < shapeLength; index += Self::FixedPointSetDimension)
     {
-      double & l2normDerivative = (**proposalDerivativeIt)[shapeLength + Self::FixedPointSetDimension];
-      l2normDerivative = 0; // initialize to zero
-      // loop over all shape coordinates of the aligned shape
-      for (unsigned int index = 0; index < shapeLength; ++index)
-      {
-        l2normDerivative += this->m_ProposalVector[index] * (**proposalDerivativeIt)[index];
-      }
-      l2normDerivative /= (l2norm * sqrt((double)(this->GetFixedPointSet()->GetNumberOfPoints())));
-
-      // loop over all shape coordinates of the aligned shape
-      for (unsigned int index = 0; index < shapeLength; ++index)
-      {
-        // update normalized shape derivatives
-        (**proposalDerivativeIt)[index] = (**proposalDerivativeIt)[index] / l2norm -
-                                          this->m_ProposalVector[index] * l2normDerivative / (l2norm * l2norm);
-      }
+      alignedGradientSum += proposalGradient[index + d];
+    }
+    const double centroidFactor = (proposalGradient[shapeLength + d] - alignedGradientSum) / numberOfPoints;
+    for (unsigned int index = 0; index < shapeLength; index += Self::FixedPointSetDimension)
+    {
+      proposalGradient[index + d] += centroidFactor;
     }
-    ++proposalDerivativeIt;
   }
 
-} // end UpdateL2AndNormalizeProposalDerivative()
+} // end UpdateCentroidAndL2ProposalGradient()
 
 
 /**
@@ -844,6 +985,18 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::CalculateValue(Me
 
       break;
     }
+    case 3: // principal components only (low-rank)
+    {
+      centerrotated = differenceVector * this->m_LowRankBasis; /** diff^T * B */
+      eigrot = this->m_LowRankCore * centerrotated;             /** C * B^T * diff */
+
+      /** diff^T * A * diff  -  diff^T * B * C * B^T * diff */
+      const double squaredValue =
+        dot_product(element_product(this->m_LowRankDiagonal, differenceVector), differenceVector) -
+        dot_product(eigrot, centerrotated);
+      value = std::sqrt(std::max(squaredValue, 0.0));
+      break;
+    }
     default:
       break;
   }
@@ -852,101 +1005,70 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::CalculateValue(Me
 
 
 /**
- * ******************* CalculateDerivative *******************
+ * ******************* CalculateProposalGradient *******************
  */
 
 template <class TFixedPointSet, class TMovingPointSet>
 void
-StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::CalculateDerivative(
-  DerivativeType &      derivative,
-  const MeasureType &   value,
+StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::CalculateProposalGradient(
   const VnlVectorType & differenceVector,
-  const VnlVectorType & centerrotated,
   const VnlVectorType & eigrot,
-  const unsigned int    shapeLength) const
+  VnlVectorType &       proposalGradient) const
 {
-  typename ProposalDerivativeType::iterator proposalDerivativeIt = this->m_ProposalDerivative->begin();
-  typename ProposalDerivativeType::iterator proposalDerivativeEnd = this->m_ProposalDerivative->end();
-
-  typename DerivativeType::iterator derivativeIt = derivative.begin();
-
-  for (; proposalDerivativeIt != proposalDerivativeEnd; ++proposalDerivativeIt, ++derivativeIt)
+  /** The derivative with respect to mu is proposalGradient^T * d/dmu(diff) / value,
+   * so the (large) matrix products are evaluated once, instead of once per mu.
+   */
+  switch (this->m_ShapeModelCalculation)
   {
-    if (*proposalDerivativeIt != nullptr)
+    case 0: // full covariance
+    {
+      /** diff^T * Sigma^-1 */
+      proposalGradient = differenceVector * (*this->m_InverseCovarianceMatrix);
+      break;
+    }
+    case 1: // decomposed covariance (uniform regularization)
     {
-      switch (this->m_ShapeModelCalculation)
+      /** V * Lambda^-1 * V^T * diff  +  1/(Beta*sigma_0^2) * diff */
+      proposalGradient = (*this->m_EigenVectors) * eigrot;
+      if (this->m_ShrinkageIntensity != 0)
       {
-        case 0: // full covariance
-        {
-          /**innerproduct diff^T * Sigma^-1 * d/dmu (diff), where iterated over mu-s*/
-          *derivativeIt = bracket(differenceVector, *m_InverseCovarianceMatrix, (**proposalDerivativeIt)) / value;
-          this->CalculateCutOffDerivative(*derivativeIt, value);
-          break;
-        }
-        case 1: // decomposed covariance (uniform regularization)
-        {
-          if (this->m_ShrinkageIntensity != 0)
-          {
-            /** Innerproduct diff^T * V * Lambda^-1 * V^T * d/dmu(diff)
-             * + 1/(Beta*sigma_0^2)*diff^T* d/dmu(diff), where iterated over mu-s
-             */
-            *derivativeIt = (dot_product(eigrot, this->m_EigenVectors->transpose() * (**proposalDerivativeIt)) +
-                             dot_product(differenceVector, **proposalDerivativeIt) /
-                               (this->m_ShrinkageIntensity * this->m_BaseVariance)) /
-                            value;
-            this->CalculateCutOffDerivative(*derivativeIt, value);
-          }
-          else // m_ShrinkageIntensity==0
-          {
-            /**innerproduct diff^T * V * Lambda^-1 * V^T * d/dmu (diff), where iterated over mu-s*/
-            *derivativeIt = (dot_product(eigrot, this->m_EigenVectors->transpose() * (**proposalDerivativeIt))) / value;
-            this->CalculateCutOffDerivative(*derivativeIt, value);
-          }
-          break;
-        }
-        case 2: // decomposed scaled covariance (element specific regularization)
-        {
-          // first scale proposalDerivatives with their sigma's in order to evaluate
-          // with the EigenValues and EigenVectors of the scaled CovarianceMatrix
-          typename VnlVectorType::iterator propDerivElementIt = (*proposalDerivativeIt)->begin();
-          for (unsigned int propDerivElementIndex = 0; propDerivElementIndex < shapeLength;
-               ++propDerivElementIndex, ++propDerivElementIt)
-          {
-            (*propDerivElementIt) /= this->m_BaseStd;
-          }
-          (**proposalDerivativeIt)[shapeLength] /= this->m_CentroidXStd;
-          (**proposalDerivativeIt)[shapeLength + 1] /= this->m_CentroidYStd;
-          (**proposalDerivativeIt)[shapeLength + 2] /= this->m_CentroidZStd;
-          (**proposalDerivativeIt)[shapeLength + 3] /= this->m_SizeStd;
-          if (this->m_ShrinkageIntensity != 0)
-          {
-            /** innerproduct diff^T * V * Lambda^-1 * V^T * d/dmu(diff)
-             * + 1/(Beta*sigma_0^2)*diff^T* d/dmu(diff), where iterated over mu-s
-             */
-            *derivativeIt = (dot_product(eigrot, this->m_EigenVectors->transpose() * (**proposalDerivativeIt)) +
-                             dot_product(differenceVector, **proposalDerivativeIt) / this->m_ShrinkageIntensity) /
-                            value;
-            this->CalculateCutOffDerivative(*derivativeIt, value);
-          }
-          else // m_ShrinkageIntensity==0
-          {
-            /**innerproduct diff^T * V * Lambda^-1 * V^T * d/dmu (diff), where iterated over mu-s*/
-            *derivativeIt = (dot_product(eigrot, this->m_EigenVectors->transpose() * (**proposalDerivativeIt))) / value;
-            this->CalculateCutOffDerivative(*derivativeIt, value);
-          }
-          break;
-        }
-        default:
-        {
-        }
+        proposalGradient += differenceVector / (this->m_ShrinkageIntensity * this->m_BaseVariance);
+      }
+      break;
+    }
+    case 2: // decomposed scaled covariance (element specific regularization)
+    {
+      /** V * Lambda^-1 * V^T * diff  +  1/(Beta) * diff, for the scaled diff */
+      proposalGradient = (*this->m_EigenVectors) * eigrot;
+      if (this->m_ShrinkageIntensity != 0)
+      {
+        proposalGradient += differenceVector / this->m_ShrinkageIntensity;
+      }
 
-          delete (*proposalDerivativeIt);
-          // nzjacs++;
+      /** The derivatives of the scaled diff are scaled by the sigma's as well. */
+      const unsigned int shapeLength = this->m_ProposalLength - Self::FixedPointSetDimension - 1;
+      for (unsigned int index = 0; index < shapeLength; ++index)
+      {
+        proposalGradient[index] /= this->m_BaseStd;
       }
+      proposalGradient[shapeLength] /= this->m_CentroidXStd;
+      proposalGradient[shapeLength + 1] /= this->m_CentroidYStd;
+      proposalGradient[shapeLength + 2] /= this->m_CentroidZStd;
+      proposalGradient[shapeLength + 3] /= this->m_SizeStd;
+      break;
     }
+    case 3: // principal components only (low-rank)
+    {
+      /** A * diff - B * C * B^T * diff */
+      proposalGradient = element_product(this->m_LowRankDiagonal, differenceVector) - this->m_LowRankBasis * eigrot;
+      break;
+    }
+    default:
+      proposalGradient.set_size(this->m_ProposalLength);
+      proposalGradient.fill(0.0);
   }
 
-} // end CalculateDerivative()
+} // end CalculateProposalGradient()
 
 
 /**
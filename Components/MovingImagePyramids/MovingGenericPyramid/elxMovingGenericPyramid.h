@@ -56,7 +56,8 @@ namespace elastix
  * moving_image_spacing.\n If ImagePyramidSmoothingSchedule is specified, that schedule is used for both moving and
  * moving image pyramid. \parameter ImagePyramidSmoothingSchedule: smoothing schedule for both pyramids \parameter
  * ComputePyramidImagesPerResolution: Flag to specify if all resolution levels are computed at once, or per resolution.
- * Latter saves memory.\n example: <tt>(ComputePyramidImagesPerResolution "true")</tt>\n Default false. \parameter
+ * Latter saves memory.\n example: <tt>(ComputePyramidImagesPerResolution "false")</tt>\n Default true. See also
+ * MaximumPyramidMemory and ComputePyramidImagesInBackground in the MovingImagePyramidBase. \parameter
  * ImagePyramidUseShrinkImageFilter: Flag to specify if the ShrinkingImageFilter is used for rescaling the image, or the
  * ResampleImageFilter. Shrinker is faster.\n example: <tt>(ImagePyramidUseShrinkImageFilter "true")</tt>\n Default
  * false, so by default the resampler is used.
@@ -116,9 +117,33 @@ public:
   void
   SetMovingSchedule() override;
 
-  /** Update the current resolution level. */
+  /** This pyramid can compute its images per resolution. */
+  bool
+  SupportsComputePerResolution() const override
+  {
+    return true;
+  }
+
+  /** Compute only the images of the current resolution, or all at once. */
+  void
+  SetComputePerResolution(const bool computePerResolution) override
+  {
+    this->SetComputeOnlyForCurrentLevel(computePerResolution);
+  }
+
+  /** Let the pyramid filter know that we are in a next level. */
+  void
+  SetCurrentResolution(const unsigned int level) override
+  {
+    this->SetCurrentLevel(level);
+  }
+
+  /** Start computing the images of the given resolution in the background. */
   void
-  BeforeEachResolution() override;
+  PrecomputeResolutionInBackground(const unsigned int level) override
+  {
+    this->PrecomputeLevelInBackground(level);
+  }
 
 protected:
   /** The constructor. */
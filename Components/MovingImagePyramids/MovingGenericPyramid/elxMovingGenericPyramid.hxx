@@ -143,37 +143,9 @@ MovingGenericPyramid<TElastix>::SetMovingSchedule()
   this->m_Configuration->ReadParameter(useShrinkImageFilter, "ImagePyramidUseShrinkImageFilter", 0, false);
   this->SetUseShrinkImageFilter(useShrinkImageFilter);
 
-  /** Decide whether or not to compute the pyramid images only for the current
-   * resolution. Setting the option to true saves memory, since only one level
-   * of the pyramid gets allocated per resolution.
-   */
-  bool computeThisResolution = false;
-  this->m_Configuration->ReadParameter(computeThisResolution, "ComputePyramidImagesPerResolution", 0, false);
-  this->SetComputeOnlyForCurrentLevel(computeThisResolution);
-
 } // end SetMovingSchedule()
 
 
-/**
- * ******************* BeforeEachResolution ***********************
- */
-
-template <class TElastix>
-void
-MovingGenericPyramid<TElastix>::BeforeEachResolution()
-{
-  /** What is the current resolution level? */
-  const unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
-
-  /** We let the pyramid filter know that we are in a next level.
-   * Depending on a flag only at this point the output of the current level is computed,
-   * or it was computed for all levels at once at initialization.
-   */
-  this->SetCurrentLevel(level);
-
-} // end BeforeEachResolution()
-
-
 } // end namespace elastix
 
 #endif // end #ifndef elxMovingGenericPyramid_hxx
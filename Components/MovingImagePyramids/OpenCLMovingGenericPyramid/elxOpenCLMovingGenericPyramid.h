@@ -96,6 +96,18 @@ public:
   virtual void
   ReadFromFile();
 
+  /** The images are computed on the GPU, so only precompute them in the
+   * background when falling back to the CPU.
+   */
+  void
+  PrecomputeResolutionInBackground(const unsigned int level) override
+  {
+    if (!this->m_UseOpenCL || !this->m_GPUPyramidReady)
+    {
+      this->Superclass::PrecomputeResolutionInBackground(level);
+    }
+  }
+
 protected:
   /** This method performs all configuration for GPU pyramid. */
   void
@@ -138,6 +138,9 @@ AdaGrad<TElastix>::BeforeEachResolution()
                       << std::endl;
   }
 
+  /** Set the convergence check, and show its value in the iteration info if enabled. */
+  this->BeforeEachResolutionConvergenceCheck(*this);
+
   /** Set/Get the initial time. Default: 0.0. Should be >= 0. */
   double initialTime = 0.0;
   this->GetConfiguration()->ReadParameter(initialTime, "SigmoidInitialTime", this->GetComponentLabel(), level, 0);
@@ -303,6 +306,9 @@ AdaGrad<TElastix>::AfterEachIteration()
     this->GetIterationInfoAt("4b:||SearchDirection||") << this->GetSearchDirection().magnitude();
   }
 
+  /** Print the convergence value, or mark the iteration at which the check stopped the resolution. */
+  this->AfterEachIterationConvergenceCheck(*this);
+
   /** Select new spatial samples for the computation of the metric. */
   if (this->GetNewSamplesEveryIteration())
   {
@@ -327,7 +333,8 @@ AdaGrad<TElastix>::AfterEachResolution()
    * enum StopConditionType {
    *   MaximumNumberOfIterations,
    *   MetricError,
-   *   MinimumStepSize } ;
+   *   MinimumStepSize,
+   *   MetricConvergence } ;
    */
   std::string stopcondition;
 
@@ -345,6 +352,10 @@ AdaGrad<TElastix>::AfterEachResolution()
       stopcondition = "The minimum step length has been reached";
       break;
 
+    case MetricConvergence:
+      stopcondition = "The metric values have converged";
+      break;
+
     default:
       stopcondition = "Unknown";
       break;
@@ -646,6 +657,10 @@ AdaGrad<TElastix>::AutomaticPreconditionerEstimation()
   timer4.Stop();
   elxout << "  Computing the displacement distribution took " << Conversion::SecondsToDHMS(timer4.GetMean(), 6)
          << std::endl;
+  elxout << "    of which exact gradient and sampling: "
+         << Conversion::SecondsToDHMS(computeDisplacementDistribution->GetPreparationTime(), 6)
+         << ", Jacobian terms using " << computeDisplacementDistribution->GetNumberOfWorkUnits()
+         << " threads: " << Conversion::SecondsToDHMS(computeDisplacementDistribution->GetJacobianTime(), 6) << std::endl;
 
   /** Sample the fixed image to estimate the noise factor. */
   itk::TimeProbe timer_noise;
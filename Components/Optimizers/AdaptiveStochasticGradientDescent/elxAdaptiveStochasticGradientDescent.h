@@ -78,6 +78,20 @@ namespace elastix
  *   parameter it is possible to try to draw another set of samples. \n
  *   example: <tt>(MaximumNumberOfSamplingAttempts 10 15 10)</tt> \n
  *    Default value: 0, i.e. just fail immediately, for backward compatibility.
+ * \parameter UseConvergenceCheck: Whether to stop a resolution before MaximumNumberOfIterations
+ *   when the metric values have converged. A straight line is fitted to the metric values of the
+ *   last ConvergenceWindowSize iterations; the resolution stops when the lower confidence bound of
+ *   the decrease over that window, relative to the mean metric value, drops below ConvergenceTolerance.
+ *   This bound is shown in the "5:Convergence" column of the iteration info. \n
+ *   example: <tt>(UseConvergenceCheck "true" "true" "false")</tt> \n
+ *    Default value: "false".
+ * \parameter ConvergenceWindowSize: The number of iterations used by the convergence check. \n
+ *   example: <tt>(ConvergenceWindowSize 100 100 200)</tt> \n
+ *    Default value: 100. The minimum is 3.
+ * \parameter ConvergenceTolerance: The relative metric decrease over the window below which
+ *   the convergence check stops the resolution. \n
+ *   example: <tt>(ConvergenceTolerance 0.0001)</tt> \n
+ *    Default value: 0.0, i.e. stop as soon as the decrease is no longer statistically significant.
  * \parameter AutomaticParameterEstimation: When this parameter is set to "true",
  *   many other parameters are calculated automatically: SP_a, SP_alpha, SigmoidMax,
  *   SigmoidMin, and SigmoidScale. In the elastix.log file the actually chosen values for
@@ -183,6 +197,10 @@ namespace elastix
  *   example: <tt>(NoiseCompensation "true")</tt>\n
  *   Default/recommended: true.
  *
+ * A checkpoint of the registration (see the CheckpointInterval parameter) stores the time,
+ * the gradients and the estimated step size parameters of this optimizer, so that a
+ * resumed registration continues at the iteration after the checkpoint.
+ *
  * \todo: this class contains a lot of functional code, which actually does not belong here.
  *
  * \sa AdaptiveStochasticGradientDescentOptimizer
@@ -223,6 +241,7 @@ public:
   using typename Superclass2::ElastixType;
   using typename Superclass2::RegistrationType;
   using ITKBaseType = typename Superclass2::ITKBaseType;
+  using typename Superclass2::ParameterMapType;
   using SizeValueType = itk::SizeValueType;
 
   /** Typedef for the ParametersType. */
@@ -263,6 +282,14 @@ public:
   void
   MetricErrorResponse(itk::ExceptionObject & err) override;
 
+  /** Add the time, the gradients, and the step size parameters to a checkpoint. */
+  void
+  AddStateToCheckpoint(ParameterMapType & checkpoint) const override;
+
+  /** Restore the state of AddStateToCheckpoint(), to continue after the iteration of the checkpoint. */
+  bool
+  RestoreStateFromCheckpoint(const itk::ParameterMapInterface & checkpoint) override;
+
   /** Set/Get whether automatic parameter estimation is desired.
    * If true, make sure to set the maximum step length.
    *
@@ -423,6 +450,12 @@ private:
   /** The flag of using noise compensation. */
   bool m_UseNoiseCompensation;
   bool m_OriginalButSigmoidToDefault;
+
+  /** The state of a checkpoint, restored when the optimization is resumed. */
+  bool           m_ResumeFromCheckpoint{ false };
+  double         m_CheckpointTime{ 0.0 };
+  DerivativeType m_CheckpointGradient{};
+  DerivativeType m_CheckpointPreviousGradient{};
 };
 
 } // end namespace elastix
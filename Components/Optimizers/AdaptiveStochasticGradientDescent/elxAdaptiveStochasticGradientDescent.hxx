@@ -101,6 +101,10 @@ AdaptiveStochasticGradientDescent<TElastix>::BeforeEachResolution()
   const unsigned int numberOfParameters =
     this->GetElastix()->GetElxTransformBase()->GetAsITKBaseType()->GetNumberOfParameters();
 
+  /** Start at iteration 0, unless the resolution is resumed from a checkpoint. */
+  this->SetStartIteration(0);
+  this->m_ResumeFromCheckpoint = false;
+
   /** Set the maximumNumberOfIterations. */
   SizeValueType maximumNumberOfIterations = 500;
   this->GetConfiguration()->ReadParameter(
@@ -127,6 +131,9 @@ AdaptiveStochasticGradientDescent<TElastix>::BeforeEachResolution()
                       << std::endl;
   }
 
+  /** Set the convergence check, and show its value in the iteration info if enabled. */
+  this->BeforeEachResolutionConvergenceCheck(*this);
+
   /** Set/Get the initial time. Default: 0.0. Should be >= 0. */
   double initialTime = 0.0;
   this->GetConfiguration()->ReadParameter(initialTime, "SigmoidInitialTime", this->GetComponentLabel(), level, 0);
@@ -281,6 +288,9 @@ AdaptiveStochasticGradientDescent<TElastix>::AfterEachIteration()
     this->GetIterationInfoAt("4:||Gradient||") << this->GetGradient().magnitude();
   }
 
+  /** Print the convergence value, or mark the iteration at which the check stopped the resolution. */
+  this->AfterEachIterationConvergenceCheck(*this);
+
   /** Select new spatial samples for the computation of the metric. */
   if (this->GetNewSamplesEveryIteration())
   {
@@ -305,7 +315,8 @@ AdaptiveStochasticGradientDescent<TElastix>::AfterEachResolution()
    * enum StopConditionType {
    *   MaximumNumberOfIterations,
    *   MetricError,
-   *   MinimumStepSize };
+   *   MinimumStepSize,
+   *   MetricConvergence };
    */
   std::string stopcondition;
 
@@ -323,6 +334,10 @@ AdaptiveStochasticGradientDescent<TElastix>::AfterEachResolution()
       stopcondition = "The minimum step length has been reached";
       break;
 
+    case MetricConvergence:
+      stopcondition = "The metric values have converged";
+      break;
+
     default:
       stopcondition = "Unknown";
       break;
@@ -390,7 +405,8 @@ AdaptiveStochasticGradientDescent<TElastix>::StartOptimization()
     }
   }
 
-  this->m_AutomaticParameterEstimationDone = false;
+  /** A resumed optimization keeps the step size parameters of its checkpoint. */
+  this->m_AutomaticParameterEstimationDone = this->m_ResumeFromCheckpoint;
 
   this->Superclass1::StartOptimization();
 
@@ -417,6 +433,25 @@ AdaptiveStochasticGradientDescent<TElastix>::ResumeOptimization()
     this->m_AutomaticParameterEstimationDone = true;
   }
 
+  /** Complete the iteration of the checkpoint, of which the time was not
+   * yet updated when the checkpoint was written. */
+  if (this->m_ResumeFromCheckpoint)
+  {
+    this->m_ResumeFromCheckpoint = false;
+    this->m_CurrentTime = this->m_CheckpointTime;
+    this->m_Gradient = this->m_CheckpointGradient;
+    this->m_PreviousGradient = this->m_CheckpointPreviousGradient;
+    if (this->GetUseAdaptiveStepSizes() && this->m_PreviousGradient.GetSize() == 0)
+    {
+      /** In the first iteration, the time is not updated; only the gradient is saved. */
+      this->m_PreviousGradient = this->m_Gradient;
+    }
+    else
+    {
+      this->UpdateCurrentTime();
+    }
+  }
+
   this->Superclass1::ResumeOptimization();
 
 } // end ResumeOptimization()
@@ -454,6 +489,94 @@ AdaptiveStochasticGradientDescent<TElastix>::MetricErrorResponse(itk::ExceptionO
 } // end MetricErrorResponse()
 
 
+/**
+ * ****************** AddStateToCheckpoint *************************
+ */
+
+template <class TElastix>
+void
+AdaptiveStochasticGradientDescent<TElastix>::AddStateToCheckpoint(ParameterMapType & checkpoint) const
+{
+  /** The step size parameters, which may have been estimated automatically. */
+  checkpoint["SP_a"] = { Conversion::ToString(this->GetParam_a()) };
+  checkpoint["SP_A"] = { Conversion::ToString(this->GetParam_A()) };
+  checkpoint["SP_alpha"] = { Conversion::ToString(this->GetParam_alpha()) };
+  checkpoint["SigmoidMax"] = { Conversion::ToString(this->GetSigmoidMax()) };
+  checkpoint["SigmoidMin"] = { Conversion::ToString(this->GetSigmoidMin()) };
+  checkpoint["SigmoidScale"] = { Conversion::ToString(this->GetSigmoidScale()) };
+
+  /** The checkpoint is written by the iteration event, before the time is updated. */
+  checkpoint["CurrentTime"] = { Conversion::ToString(this->GetCurrentTime()) };
+  checkpoint["Gradient"] = Conversion::ToVectorOfStrings(this->GetGradient());
+  if (this->GetCurrentIteration() > 0)
+  {
+    checkpoint["PreviousGradient"] = Conversion::ToVectorOfStrings(this->m_PreviousGradient);
+  }
+
+} // end AddStateToCheckpoint()
+
+
+/**
+ * ****************** RestoreStateFromCheckpoint *************************
+ */
+
+template <class TElastix>
+bool
+AdaptiveStochasticGradientDescent<TElastix>::RestoreStateFromCheckpoint(const itk::ParameterMapInterface & checkpoint)
+{
+  const std::vector<std::string> scalarNames{ "SP_a",       "SP_A",         "SP_alpha",   "SigmoidMax",
+                                              "SigmoidMin", "SigmoidScale", "CurrentTime" };
+  std::vector<double>            scalars;
+  for (const std::string & name : scalarNames)
+  {
+    const auto values = checkpoint.RetrieveValues<double>(name);
+    if (values == nullptr || values->size() != 1)
+    {
+      xl::xout["warning"] << "WARNING: The checkpoint has no state of " << this->GetComponentLabel() << "."
+                          << std::endl;
+      return false;
+    }
+    scalars.push_back(values->front());
+  }
+
+  const unsigned int numberOfParameters =
+    this->GetElastix()->GetElxTransformBase()->GetAsITKBaseType()->GetNumberOfParameters();
+  const auto iteration = checkpoint.RetrieveValues<unsigned int>("CheckpointIteration");
+  const auto gradient = checkpoint.RetrieveValues<double>("Gradient");
+  const auto previousGradient = checkpoint.RetrieveValues<double>("PreviousGradient");
+  if (iteration == nullptr || iteration->size() != 1 || gradient == nullptr || gradient->size() != numberOfParameters ||
+      (previousGradient != nullptr && previousGradient->size() != numberOfParameters))
+  {
+    xl::xout["warning"] << "WARNING: The checkpoint state of " << this->GetComponentLabel()
+                        << " does not match the transform." << std::endl;
+    return false;
+  }
+
+  /** Skip the automatic parameter estimation, and use the parameters of the checkpoint instead. */
+  this->SetParam_a(scalars[0]);
+  this->SetParam_A(scalars[1]);
+  this->SetParam_alpha(scalars[2]);
+  this->SetSigmoidMax(scalars[3]);
+  this->SetSigmoidMin(scalars[4]);
+  this->SetSigmoidScale(scalars[5]);
+
+  /** The time and gradients are restored by ResumeOptimization(). */
+  this->m_CheckpointTime = scalars[6];
+  this->m_CheckpointGradient.SetSize(numberOfParameters);
+  std::copy(gradient->cbegin(), gradient->cend(), this->m_CheckpointGradient.begin());
+  this->m_CheckpointPreviousGradient.SetSize(previousGradient == nullptr ? 0 : numberOfParameters);
+  if (previousGradient != nullptr)
+  {
+    std::copy(previousGradient->cbegin(), previousGradient->cend(), this->m_CheckpointPreviousGradient.begin());
+  }
+
+  this->SetStartIteration(iteration->front() + 1);
+  this->m_ResumeFromCheckpoint = true;
+  return true;
+
+} // end RestoreStateFromCheckpoint()
+
+
 /**
  * ******************* AutomaticParameterEstimation **********************
  */
@@ -704,6 +827,10 @@ AdaptiveStochasticGradientDescent<TElastix>::AutomaticParameterEstimationUsingDi
   timer4.Stop();
   elxout << "  Computing the displacement distribution took " << Conversion::SecondsToDHMS(timer4.GetMean(), 6)
          << std::endl;
+  elxout << "    of which exact gradient and sampling: "
+         << Conversion::SecondsToDHMS(computeDisplacementDistribution->GetPreparationTime(), 6)
+         << ", Jacobian terms using " << computeDisplacementDistribution->GetNumberOfWorkUnits()
+         << " threads: " << Conversion::SecondsToDHMS(computeDisplacementDistribution->GetJacobianTime(), 6) << std::endl;
 
   /** Initial of the variables. */
   double       a = 0.0;
@@ -604,6 +604,10 @@ PreconditionedStochasticGradientDescent<TElastix>::AutomaticPreconditionerEstima
 
   timer_P.Stop();
   elxout << "  Computing the preconditioner took " << Conversion::SecondsToDHMS(timer_P.GetMean(), 6) << std::endl;
+  elxout << "    of which exact gradient and sampling: "
+         << Conversion::SecondsToDHMS(preconditionerEstimator->GetPreparationTime(), 6)
+         << ", Jacobian terms using " << preconditionerEstimator->GetNumberOfWorkUnits()
+         << " threads: " << Conversion::SecondsToDHMS(preconditionerEstimator->GetJacobianTime(), 6) << std::endl;
 
 #if 0
   elxout << std::scientific;
@@ -647,6 +651,10 @@ PreconditionedStochasticGradientDescent<TElastix>::AutomaticPreconditionerEstima
     timer4.Stop();
     elxout << "  Computing the displacement distribution took " << Conversion::SecondsToDHMS(timer4.GetMean(), 6)
            << std::endl;
+    elxout << "    of which exact gradient and sampling: "
+           << Conversion::SecondsToDHMS(computeDisplacementDistribution->GetPreparationTime(), 6)
+           << ", Jacobian terms using " << computeDisplacementDistribution->GetNumberOfWorkUnits()
+           << " threads: " << Conversion::SecondsToDHMS(computeDisplacementDistribution->GetJacobianTime(), 6) << std::endl;
   }
 
   /** Sample the fixed image to estimate the noise factor. */
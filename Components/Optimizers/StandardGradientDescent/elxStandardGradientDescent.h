@@ -44,6 +44,20 @@ namespace elastix
  *   parameter it is possible to try to draw another set of samples. \n
  *   example: <tt>(MaximumNumberOfSamplingAttempts 10 15 10)</tt> \n
  *    Default value: 0, i.e. just fail immediately, for backward compatibility.
+ * \parameter UseConvergenceCheck: Whether to stop a resolution before MaximumNumberOfIterations
+ *   when the metric values have converged. A straight line is fitted to the metric values of the
+ *   last ConvergenceWindowSize iterations; the resolution stops when the lower confidence bound of
+ *   the decrease over that window, relative to the mean metric value, drops below ConvergenceTolerance.
+ *   This bound is shown in the "5:Convergence" column of the iteration info. \n
+ *   example: <tt>(UseConvergenceCheck "true" "true" "false")</tt> \n
+ *    Default value: "false".
+ * \parameter ConvergenceWindowSize: The number of iterations used by the convergence check. \n
+ *   example: <tt>(ConvergenceWindowSize 100 100 200)</tt> \n
+ *    Default value: 100. The minimum is 3.
+ * \parameter ConvergenceTolerance: The relative metric decrease over the window below which
+ *   the convergence check stops the resolution. \n
+ *   example: <tt>(ConvergenceTolerance 0.0001)</tt> \n
+ *    Default value: 0.0, i.e. stop as soon as the decrease is no longer statistically significant.
  * \parameter SP_a: The gain \f$a(k)\f$ at each iteration \f$k\f$ is defined by \n
  *   \f$a(k) =  SP\_a / (SP\_A + k + 1)^{SP\_alpha}\f$. \n
  *   SP_a can be defined for each resolution. \n
@@ -105,6 +105,9 @@ StandardGradientDescent<TElastix>::BeforeEachResolution()
                       << std::endl;
   }
 
+  /** Set the convergence check, and show its value in the iteration info if enabled. */
+  this->BeforeEachResolutionConvergenceCheck(*this);
+
 } // end BeforeEachResolution()
 
 
@@ -121,6 +124,9 @@ StandardGradientDescent<TElastix>::AfterEachIteration()
   this->GetIterationInfoAt("3:StepSize") << this->GetLearningRate();
   this->GetIterationInfoAt("4:||Gradient||") << this->GetGradient().magnitude();
 
+  /** Print the convergence value, or mark the iteration at which the check stopped the resolution. */
+  this->AfterEachIterationConvergenceCheck(*this);
+
   /** Select new spatial samples for the computation of the metric */
   if (this->GetNewSamplesEveryIteration())
   {
@@ -139,7 +145,7 @@ void
 StandardGradientDescent<TElastix>::AfterEachResolution()
 {
   /**
-   * enum   StopConditionType {  MaximumNumberOfIterations, MetricError }
+   * enum   StopConditionType {  MaximumNumberOfIterations, MetricError, MinimumStepSize, MetricConvergence }
    */
   std::string stopcondition;
   switch (this->GetStopCondition())
@@ -153,6 +159,10 @@ StandardGradientDescent<TElastix>::AfterEachResolution()
       stopcondition = "Error in metric";
       break;
 
+    case MetricConvergence:
+      stopcondition = "The metric values have converged";
+      break;
+
     default:
       stopcondition = "Unknown";
       break;
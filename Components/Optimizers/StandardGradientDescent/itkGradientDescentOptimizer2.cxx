@@ -22,6 +22,9 @@
 #include "itkEventObject.h"
 #include "itkMacro.h"
 
+#include <algorithm> // For max.
+#include <cmath>     // For abs and sqrt.
+
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
 #endif
@@ -58,11 +61,16 @@ GradientDescentOptimizer2 ::PrintSelf(std::ostream & os, Indent indent) const
   os << indent << "LearningRate: " << this->m_LearningRate << std::endl;
   os << indent << "NumberOfIterations: " << this->m_NumberOfIterations << std::endl;
   os << indent << "CurrentIteration: " << this->m_CurrentIteration;
+  os << indent << "StartIteration: " << this->m_StartIteration;
   os << indent << "Value: " << this->m_Value;
   os << indent << "StopCondition: " << this->m_StopCondition;
   os << std::endl;
   os << indent << "Gradient: " << this->m_Gradient;
   os << std::endl;
+  os << indent << "UseConvergenceCheck: " << this->m_UseConvergenceCheck << std::endl;
+  os << indent << "ConvergenceWindowSize: " << this->m_ConvergenceWindowSize << std::endl;
+  os << indent << "ConvergenceTolerance: " << this->m_ConvergenceTolerance << std::endl;
+  os << indent << "ConvergenceValue: " << this->m_ConvergenceValue << std::endl;
 
 } // end PrintSelf()
 
@@ -74,7 +82,11 @@ GradientDescentOptimizer2 ::PrintSelf(std::ostream & os, Indent indent) const
 void
 GradientDescentOptimizer2 ::StartOptimization()
 {
-  this->m_CurrentIteration = 0;
+  this->m_CurrentIteration = this->m_StartIteration;
+
+  /** Start the convergence check from scratch. */
+  this->m_ConvergenceWindow.clear();
+  this->m_ConvergenceValue = NumericTraits<double>::quiet_NaN();
 
   /** Get the number of parameters; checks also if a cost function has been set at all.
    * if not: an exception is thrown */
@@ -132,6 +144,13 @@ GradientDescentOptimizer2 ::ResumeOptimization()
       break;
     }
 
+    /** Done before AdvanceOneStep, so that the convergence value
+     * of this iteration can be shown in the iteration info. */
+    if (this->m_UseConvergenceCheck)
+    {
+      this->UpdateConvergenceValue();
+    }
+
     this->AdvanceOneStep();
 
     /** StopOptimization may have been called. */
@@ -142,6 +161,14 @@ GradientDescentOptimizer2 ::ResumeOptimization()
 
     this->m_CurrentIteration++;
 
+    /** Stop when the metric values have converged. False while the value is NaN. */
+    if (this->m_UseConvergenceCheck && this->m_ConvergenceValue < this->m_ConvergenceTolerance)
+    {
+      this->m_StopCondition = MetricConvergence;
+      this->StopOptimization();
+      break;
+    }
+
   } // end while
 
 } // end ResumeOptimization()
@@ -223,4 +250,61 @@ GradientDescentOptimizer2 ::AdvanceOneStep()
 } // end AdvanceOneStep()
 
 
+/**
+ * ************ UpdateConvergenceValue ****************************
+ */
+
+void
+GradientDescentOptimizer2 ::UpdateConvergenceValue()
+{
+  /** Keep the metric values of the last m_ConvergenceWindowSize iterations. */
+  this->m_ConvergenceWindow.push_back(this->m_Value);
+  while (this->m_ConvergenceWindow.size() > this->m_ConvergenceWindowSize)
+  {
+    this->m_ConvergenceWindow.pop_front();
+  }
+
+  const std::size_t n = this->m_ConvergenceWindow.size();
+  if (n < this->m_ConvergenceWindowSize)
+  {
+    this->m_ConvergenceValue = NumericTraits<double>::quiet_NaN();
+    return;
+  }
+
+  /** Least squares fit of value = mean + slope * ( i - xmean ), i = 0 .. n-1. */
+  const double xmean = 0.5 * static_cast<double>(n - 1);
+  const double sxx = static_cast<double>(n) * (static_cast<double>(n) * n - 1.0) / 12.0;
+  double       ymean = 0.0;
+  for (const double value : this->m_ConvergenceWindow)
+  {
+    ymean += value;
+  }
+  ymean /= static_cast<double>(n);
+
+  double sxy = 0.0;
+  double syy = 0.0;
+  double x = 0.0;
+  for (const double value : this->m_ConvergenceWindow)
+  {
+    const double dy = value - ymean;
+    sxy += (x - xmean) * dy;
+    syy += dy * dy;
+    x += 1.0;
+  }
+  const double slope = sxy / sxx;
+
+  /** Standard error of the slope, from the residual variance. */
+  const double residualVariance = std::max(syy - slope * sxy, 0.0) / static_cast<double>(n - 2);
+  const double slopeStandardError = std::sqrt(residualVariance / sxx);
+
+  /** Lower confidence bound (two standard errors, about 97.7% one-sided) of the
+   * decrease over the window, relative to the mean metric value. */
+  const double zScore = 2.0;
+  const double decrease = static_cast<double>(n - 1) * (-slope - zScore * slopeStandardError);
+  const double scale = std::max(std::abs(ymean), NumericTraits<double>::epsilon());
+  this->m_ConvergenceValue = decrease / scale;
+
+} // end UpdateConvergenceValue()
+
+
 } // end namespace itk
@@ -20,6 +20,8 @@
 
 #include "itkScaledSingleValuedNonLinearOptimizer.h"
 
+#include <deque>
+
 
 namespace itk
 {
@@ -37,8 +39,17 @@ namespace itk
  * \f]
  *
  * The learning rate is a fixed scalar defined via SetLearningRate().
- * The optimizer steps through a user defined number of iterations;
- * no convergence checking is done.
+ * The optimizer steps through a user defined number of iterations.
+ *
+ * Optionally, a convergence check on the (noisy) metric values can be
+ * enabled with SetUseConvergenceCheck(). A straight line is fitted to the
+ * metric values of the last ConvergenceWindowSize iterations. The lower
+ * confidence bound of the decrease predicted over the window (two standard
+ * errors below the fitted decrease), relative to the mean metric value in the
+ * window, is the ConvergenceValue. The optimization stops with the
+ * MetricConvergence stop condition as soon as this value drops below the
+ * ConvergenceTolerance, i.e. when there is no statistically significant
+ * evidence left that the metric still decreases by more than the tolerance.
  *
  * Additionally, user can scale each component of the \f$\partial f / \partial p\f$
  * but setting a scaling vector using method SetScale().
@@ -77,12 +88,14 @@ public:
 
   /** Codes of stopping conditions
    * The MinimumStepSize stopcondition never occurs, but may
-   * be implemented in inheriting classes */
+   * be implemented in inheriting classes. MetricConvergence only
+   * occurs when the convergence check is enabled. */
   enum StopConditionType
   {
     MaximumNumberOfIterations,
     MetricError,
-    MinimumStepSize
+    MinimumStepSize,
+    MetricConvergence
   };
 
   /** Advance one step following the gradient direction. */
@@ -122,6 +135,11 @@ public:
   /** Get the current iteration number. */
   itkGetConstMacro(CurrentIteration, unsigned int);
 
+  /** Set/Get the iteration number at which StartOptimization() starts counting.
+   * Used to continue an optimization that was interrupted. Default: 0. */
+  itkSetMacro(StartIteration, unsigned long);
+  itkGetConstMacro(StartIteration, unsigned long);
+
   /** Get the current value. */
   itkGetConstReferenceMacro(Value, double);
 
@@ -137,12 +155,39 @@ public:
   /** Set use OpenMP or not. */
   itkSetMacro(UseOpenMP, bool);
 
+  /** Set/Get whether the optimization may stop before the maximum number of
+   * iterations when the metric values converge. Default: false. */
+  itkSetMacro(UseConvergenceCheck, bool);
+  itkGetConstMacro(UseConvergenceCheck, bool);
+  itkBooleanMacro(UseConvergenceCheck);
+
+  /** Set/Get the number of iterations over which the metric values are
+   * regressed by the convergence check. Default: 100, minimum: 3. */
+  itkSetClampMacro(ConvergenceWindowSize, SizeValueType, 3, NumericTraits<SizeValueType>::max());
+  itkGetConstMacro(ConvergenceWindowSize, SizeValueType);
+
+  /** Set/Get the relative decrease of the metric over the window below which
+   * the optimization is considered converged. Default: 0.0. */
+  itkSetMacro(ConvergenceTolerance, double);
+  itkGetConstMacro(ConvergenceTolerance, double);
+
+  /** Get the lower confidence bound of the relative metric decrease over the
+   * last ConvergenceWindowSize iterations. NaN as long as the window is not
+   * filled, or when the convergence check is disabled. */
+  itkGetConstMacro(ConvergenceValue, double);
+
 protected:
   GradientDescentOptimizer2();
   ~GradientDescentOptimizer2() override = default;
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Add the current value to the convergence window and update the
+   * ConvergenceValue. Called every iteration by ResumeOptimization(),
+   * before AdvanceOneStep(), if the convergence check is enabled. */
+  virtual void
+  UpdateConvergenceValue();
+
   // made protected so subclass can access
   DerivativeType    m_Gradient;
   DerivativeType    m_SearchDirection;
@@ -158,8 +203,15 @@ private:
   bool          m_Stop{ false };
   unsigned long m_NumberOfIterations{ 100 };
   unsigned long m_CurrentIteration{ 0 };
+  unsigned long m_StartIteration{ 0 };
 
   bool m_UseOpenMP;
+
+  bool               m_UseConvergenceCheck{ false };
+  SizeValueType      m_ConvergenceWindowSize{ 100 };
+  double             m_ConvergenceTolerance{ 0.0 };
+  double             m_ConvergenceValue{ NumericTraits<double>::quiet_NaN() };
+  std::deque<double> m_ConvergenceWindow;
 };
 
 } // end namespace itk
@@ -87,6 +87,13 @@ namespace elastix
  *    example: <tt>(Metric0Use "false" "true")</tt> \n
  *    example: <tt>(Metric1Use "true" "false")</tt> \n
  *    The default is "true".
+ * \parameter ShareImageSamplers: Whether metrics that use the same fixed image,
+ *    fixed mask and fixed image region share one image sampler, in each resolution.
+ *    The samples are then drawn, and transformed, only once per iteration for
+ *    these metrics. The sampler (and its settings) of the first of these
+ *    metrics is used. \n
+ *    example: <tt>(ShareImageSamplers "false" "true")</tt> \n
+ *    The default is "false".
  *
  * \ingroup Registrations
  */
@@ -231,6 +231,11 @@ MultiMetricMultiResolutionRegistration<TElastix>::BeforeEachResolution()
     this->GetCombinationMetric()->SetUseMetric(use, metricnr);
   }
 
+  /** Set whether metrics that use the same samples share one image sampler. */
+  bool shareImageSamplers = false;
+  this->GetConfiguration()->ReadParameter(shareImageSamplers, "ShareImageSamplers", "", level, 0);
+  this->GetCombinationMetric()->SetShareImageSamplers(shareImageSamplers);
+
   /** Check if the exact metric value, computed on all pixels, should be shown.
    * If at least one of the metrics has it enabled, show also the weighted sum of all
    * exact metric values. */
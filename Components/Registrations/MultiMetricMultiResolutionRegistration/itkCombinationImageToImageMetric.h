@@ -128,6 +128,7 @@ public:
   /** Typedefs for the metrics. */
   using ImageMetricType = Superclass;
   using ImageMetricPointer = typename ImageMetricType::Pointer;
+  using ImageSamplerPointer = typename ImageMetricType::ImageSamplerPointer;
   using SingleValuedCostFunctionType = SingleValuedCostFunction;
   using SingleValuedCostFunctionPointer = typename SingleValuedCostFunctionType::Pointer;
 
@@ -200,6 +201,16 @@ public:
   itkSetMacro(UseRelativeWeights, bool);
   itkGetConstMacro(UseRelativeWeights, bool);
 
+  /** Set and Get whether image metrics that use the same fixed image, fixed mask,
+   * fixed image region and transform share one image sampler. These metrics then
+   * also share the mapped points of the samples, so that each sample is transformed
+   * only once per iteration. The sampler of the first of these metrics is used.
+   * Default: false.
+   */
+  itkSetMacro(ShareImageSamplers, bool);
+  itkGetConstMacro(ShareImageSamplers, bool);
+  itkBooleanMacro(ShareImageSamplers);
+
   /** Select which metrics are used.
    * This is useful in case you want to compute a certain measure, but not
    * actually use it during the registration.
@@ -459,6 +470,13 @@ protected:
   FixedImageRegionType m_NullFixedImageRegion;
   DerivativeType       m_NullDerivative;
 
+  /** Share the image samplers of metrics that use the same samples, if requested.
+   * Called by Initialize(), before the metrics are initialized, because the
+   * images and masks of the metrics may differ per resolution.
+   */
+  virtual void
+  InitializeSharedImageSamplers();
+
 private:
   CombinationImageToImageMetric(const Self &) = delete;
   void
@@ -476,6 +494,11 @@ private:
    */
   double
   GetFinalMetricWeight(unsigned int pos) const;
+
+  bool m_ShareImageSamplers{ false };
+
+  /** The image samplers that were set in the metrics, before sharing. */
+  std::vector<ImageSamplerPointer> m_OwnImageSamplers;
 };
 
 } // end namespace itk
@@ -174,6 +174,7 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::ostream
     os << indent << "UseMetric: " << (this->m_UseMetric[i] ? "true\n" : "false\n");
     os << indent << "MetricComputationTime: " << this->m_MetricComputationTime[i] << "\n";
   }
+  os << indent << "ShareImageSamplers: " << (this->m_ShareImageSamplers ? "true\n" : "false\n");
 
 } // end PrintSelf()
 
@@ -579,6 +580,9 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::Initialize()
     itkExceptionMacro(<< "At least one metric should be set!");
   }
 
+  /** Share image samplers between metrics that use the same samples. */
+  this->InitializeSharedImageSamplers();
+
   /** Call Initialize for all metrics. */
   for (unsigned int i = 0; i < this->GetNumberOfMetrics(); ++i)
   {
@@ -606,6 +610,75 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::Initialize()
 } // end Initialize()
 
 
+/**
+ * ******************* InitializeSharedImageSamplers *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::InitializeSharedImageSamplers()
+{
+  /** Restore the own image samplers of the metrics, since sharing may
+   * differ per resolution.
+   */
+  this->m_OwnImageSamplers.resize(this->GetNumberOfMetrics());
+  for (unsigned int i = 0; i < this->GetNumberOfMetrics(); ++i)
+  {
+    ImageMetricType * metric = dynamic_cast<ImageMetricType *>(this->GetMetric(i));
+    if (metric == nullptr)
+    {
+      continue;
+    }
+    if (this->m_OwnImageSamplers[i].IsNull())
+    {
+      this->m_OwnImageSamplers[i] = metric->GetImageSampler();
+    }
+    else
+    {
+      metric->SetImageSampler(this->m_OwnImageSamplers[i]);
+    }
+    metric->SetSharedMappedPoints(nullptr);
+  }
+
+  if (!this->m_ShareImageSamplers)
+  {
+    return;
+  }
+
+  /** Let each metric share the sampler of the first metric that uses the same samples. */
+  for (unsigned int i = 1; i < this->GetNumberOfMetrics(); ++i)
+  {
+    ImageMetricType * metric = dynamic_cast<ImageMetricType *>(this->GetMetric(i));
+    if (metric == nullptr || !metric->GetUseImageSampler())
+    {
+      continue;
+    }
+
+    for (unsigned int j = 0; j < i; ++j)
+    {
+      ImageMetricType * other = dynamic_cast<ImageMetricType *>(this->GetMetric(j));
+      if (other == nullptr || !other->GetUseImageSampler() || other->GetImageSampler() == nullptr ||
+          other->GetFixedImage() != metric->GetFixedImage() ||
+          other->GetFixedImageMask() != metric->GetFixedImageMask() ||
+          other->GetFixedImageRegion() != metric->GetFixedImageRegion() ||
+          other->GetTransform() != metric->GetTransform())
+      {
+        continue;
+      }
+
+      if (other->GetSharedMappedPoints() == nullptr)
+      {
+        other->SetSharedMappedPoints(std::make_shared<typename ImageMetricType::MappedPointsType>());
+      }
+      metric->SetImageSampler(other->GetImageSampler());
+      metric->SetSharedMappedPoints(other->GetSharedMappedPoints());
+      break;
+    }
+  }
+
+} // end InitializeSharedImageSamplers()
+
+
 /**
  * ******************* InitializeThreadingParameters *******************
  */
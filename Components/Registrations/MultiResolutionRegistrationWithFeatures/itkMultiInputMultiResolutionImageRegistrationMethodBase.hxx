@@ -469,6 +469,15 @@ MultiInputMultiResolutionImageRegistrationMethodBase<TFixedImage, TMovingImage>:
       break;
     }
 
+    // Skip the optimization of the levels before the first level, but pass on
+    // their transform parameters, as if they were optimized in zero iterations
+    if (currentLevel < this->GetFirstLevel())
+    {
+      this->m_LastTransformParameters = this->GetTransform()->GetParameters();
+      this->SetInitialTransformParametersOfNextLevel(this->m_LastTransformParameters);
+      continue;
+    }
+
     try
     {
       // initialize the interconnects between components
@@ -114,6 +114,7 @@ CenteredTransformInitializer2<TTransform, TFixedImage, TMovingImage>::Initialize
 
     // Moments
     m_FixedCalculator->SetImage(m_FixedImage);
+    m_FixedCalculator->SetUseCache(true);
     m_FixedCalculator->SetSpatialObjectMask(fixedMaskAsSpatialObject);
     if (this->m_CenterOfGravityUsesLowerThreshold)
     {
@@ -126,6 +127,7 @@ CenteredTransformInitializer2<TTransform, TFixedImage, TMovingImage>::Initialize
     m_FixedCalculator->Compute();
 
     m_MovingCalculator->SetImage(m_MovingImage);
+    m_MovingCalculator->SetUseCache(true);
     m_MovingCalculator->SetSpatialObjectMask(movingMaskAsSpatialObject);
     if (this->m_CenterOfGravityUsesLowerThreshold)
     {
@@ -76,6 +76,12 @@ namespace elastix
  *   <em>Nonrigid registration of dynamic medical imaging data using nD+t B-splines and a
  *   groupwise optimization approach</em>, C.T. Metz, S. Klein, M. Schaap, T. van Walsum and
  *   W.J. Niessen, Medical Image Analysis, in press.
+ * \parameter UseDirectGridUpsampling: when the B-spline grid is refined between resolutions
+ *   by halving the grid spacing, compute the new coefficients directly from the B-spline
+ *   subdivision rule, multi-threaded, instead of resampling the coefficient images. For
+ *   spline orders 1 and 3 this yields the same transform. Ignored for cyclic transforms. \n
+ *   example: <tt>(UseDirectGridUpsampling "true")</tt> \n
+ *   The default is "false".
  *
  *
  * The transform parameters necessary for transformix, additionally defined by this class, are:
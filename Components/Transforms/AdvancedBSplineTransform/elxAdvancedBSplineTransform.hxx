@@ -55,6 +55,12 @@ AdvancedBSplineTransform<TElastix>::InitializeBSplineTransform()
   this->m_GridUpsampler = GridUpsamplerType::New();
   this->m_GridUpsampler->SetBSplineOrder(this->m_SplineOrder);
 
+  /** Optionally compute dyadic grid refinements directly, which is not supported for cyclic grids. */
+  bool useDirectGridUpsampling = false;
+  this->GetConfiguration()->ReadParameter(
+    useDirectGridUpsampling, "UseDirectGridUpsampling", this->GetComponentLabel(), 0, 0, false);
+  this->m_GridUpsampler->SetUseDirectSubdivision(useDirectGridUpsampling && !this->m_Cyclic);
+
   return 0;
 } // end InitializeBSplineTransform()
 
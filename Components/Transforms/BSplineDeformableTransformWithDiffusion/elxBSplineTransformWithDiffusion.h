@@ -37,7 +37,6 @@
 #include "itkImageFileWriter.h"
 #include "itkResampleImageFilter.h"
 #include "itkCastImageFilter.h"
-#include "itkMaximumImageFilter.h"
 #include "itkImageRegionIterator.h"
 #include "itkBSplineInterpolateImageFunction.h"
 
@@ -55,6 +54,10 @@ namespace elastix
  * deformation field arrow. Filtering of the deformation field is based
  * on some 'stiffness coefficient' image.
  *
+ * All stages of a diffusion step are multi-threaded, and reuse the images
+ * of the previous step. The diffusion itself is restricted to the bounding
+ * box of the voxels with a nonzero stiffness coefficient.
+ *
  * \todo: this Transform has not been tested for images with Direction cosines
  * matrix other than the identity matrix.
  *
@@ -249,8 +252,6 @@ public:
   using MovingImageELXType = typename ElastixType::MovingImageType;
 
   /** Other typedef's.*/
-  using DummyImageType = itk::Image<short, Self::SpaceDimension>;
-  using DummyIteratorType = itk::ImageRegionConstIterator<DummyImageType>;
   using BSplineTransformPointer = typename BSplineTransformType::Pointer;
   using GenericDeformationFieldRegulizer = typename Superclass1::Superclass;
 
@@ -262,7 +263,6 @@ public:
   using GrayValueImagePointer = typename GrayValueImageType::Pointer;
   using GrayValuePixelType = typename GrayValueImageType::PixelType;
   using GrayValueImageIteratorType = itk::ImageRegionIterator<GrayValueImageType>;
-  using MaximumImageFilterType = itk::MaximumImageFilter<GrayValueImageType, GrayValueImageType, GrayValueImageType>;
   using DiffusionFilterType = itk::VectorMeanDiffusionImageFilter<VectorImageType, GrayValueImageType>;
   using DiffusionFilterPointer = typename DiffusionFilterType::Pointer;
   using RadiusType = typename VectorImageType::SizeType;
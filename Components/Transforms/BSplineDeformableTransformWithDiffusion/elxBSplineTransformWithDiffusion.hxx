@@ -23,7 +23,10 @@
 
 #include "itkBSplineResampleImageFunction.h"
 #include "itkBSplineDecompositionImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreaderBase.h"
 
+#include <algorithm> // For max.
 #include <cmath>
 
 namespace elastix
@@ -1046,43 +1049,33 @@ BSplineTransformWithDiffusion<TElastix>::DiffuseDeformationField()
 
   /** ------------- 1: Create deformationField. ------------- */
 
-  /** First, create a dummyImage with the right region info, so
-   * that the TransformIndexToPhysicalPoint-functions will be right.
+  /** Calculate the TransformPoint of all voxels of the image, multi-threaded.
+   * The deformation field is allocated in BeforeRegistration(), and is
+   * overwritten each time.
    */
-  auto dummyImage = DummyImageType::New();
-  dummyImage->SetRegions(this->m_DeformationRegion);
-  dummyImage->SetOrigin(this->m_DeformationOrigin);
-  dummyImage->SetSpacing(this->m_DeformationSpacing);
-
-  /** Setup an iterator over dummyImage and outputImage. */
-  DummyIteratorType       iter(dummyImage, this->m_DeformationRegion);
-  VectorImageIteratorType iterout(this->m_DeformationField, this->m_DeformationRegion);
-
-  /** Declare stuff. */
-  InputPointType  inputPoint;
-  OutputPointType outputPoint;
-  VectorType      diff_point;
-  IndexType       inputIndex;
-
-  /** Calculate the TransformPoint of all voxels of the image. */
-  iter.GoToBegin();
-  iterout.GoToBegin();
-  while (!iter.IsAtEnd())
-  {
-    inputIndex = iter.GetIndex();
-    /** Transform the points to physical space. */
-    dummyImage->TransformIndexToPhysicalPoint(inputIndex, inputPoint);
-    /** Call TransformPoint. */
-    outputPoint = this->TransformPoint(inputPoint);
-    /** Calculate the difference. */
-    for (unsigned int i = 0; i < this->FixedImageDimension; ++i)
-    {
-      diff_point[i] = outputPoint[i] - inputPoint[i];
-    }
-    iterout.Set(diff_point);
-    ++iter;
-    ++iterout;
-  }
+  VectorImageType * deformationField = this->m_DeformationField;
+  itk::MultiThreaderBase::New()->ParallelizeImageRegion<SpaceDimension>(
+    this->m_DeformationRegion,
+    [this, deformationField](const RegionType & threadRegion) {
+      InputPointType inputPoint;
+      VectorType     diff_point;
+      for (itk::ImageRegionIteratorWithIndex<VectorImageType> iterout(deformationField, threadRegion);
+           !iterout.IsAtEnd();
+           ++iterout)
+      {
+        /** Transform the points to physical space. */
+        deformationField->TransformIndexToPhysicalPoint(iterout.GetIndex(), inputPoint);
+        /** Call TransformPoint. */
+        const OutputPointType outputPoint = this->TransformPoint(inputPoint);
+        /** Calculate the difference. */
+        for (unsigned int i = 0; i < SpaceDimension; ++i)
+        {
+          diff_point[i] = outputPoint[i] - inputPoint[i];
+        }
+        iterout.Set(diff_point);
+      }
+    },
+    nullptr);
 
   /** ------------- 2: Update the intermediary deformationFieldTransform. ------------- */
 
@@ -1123,88 +1116,65 @@ BSplineTransformWithDiffusion<TElastix>::DiffuseDeformationField()
     throw excp;
   }
 
-  /** First we make a distinction between using segmentation or not. */
-  if (!this->m_UseMovingSegmentation)
+  /** If wanted also take the fixed image (or its segmentation) into account
+   * for the derivation of the GrayValueImage, by taking the maximum. When it
+   * is not based on a segmentation, the GrayValueImage is then thresholded.
+   * Both are done in a single multi-threaded pass over a preallocated image.
+   */
+  const GrayValueImageType * otherImage = nullptr;
+  if (!this->m_UseMovingSegmentation && this->m_AlsoFixed)
   {
-    /** If wanted also take the fixed image into account
-     * for the derivation of the GrayValueImage, by taking the maximum.
-     */
-    typename MaximumImageFilterType::Pointer maximumImageFilter;
-    if (this->m_AlsoFixed)
-    {
-      maximumImageFilter = MaximumImageFilterType::New();
-      maximumImageFilter->SetInput(0, this->m_GrayValueImage1);
-      maximumImageFilter->SetInput(1, this->m_Elastix->GetFixedImage());
-      this->m_GrayValueImage2 = maximumImageFilter->GetOutput();
-
-      /** Do the maximum (OR filter). */
-      try
-      {
-        this->m_GrayValueImage2->Update();
-      }
-      catch (itk::ExceptionObject & excp)
-      {
-        /** Add information to the exception. */
-        excp.SetLocation("BSplineTransformWithDiffusion - DiffuseDeformationField()");
-        std::string err_str = excp.GetDescription();
-        err_str += "\nError occurred when using the maximumImageFilter to get the grayValue image.\n";
-        excp.SetDescription(err_str);
-        /** Pass the exception to an higher level. */
-        throw excp;
-      }
-    } // end if alsoFixed
-
-    if (this->m_ThresholdBool)
-    {
-      /** Setup iterator. */
-      GrayValueImageIteratorType it(this->m_GrayValueImage2, this->m_GrayValueImage2->GetLargestPossibleRegion());
-      it.GoToBegin();
-      while (!it.IsAtEnd())
-      {
-        /** Threshold or just make sure everything is between 0 and 100. */
-        // \todo Possibly combine this with the rescaleIntensity filter of
-        //    the vectorMeanDiffusionImageFilter, in order to speed up.
-        if (it.Get() < this->m_ThresholdHU)
-        {
-          it.Set(0);
-        }
-        if (it.Get() >= this->m_ThresholdHU)
-        {
-          it.Set(100);
-        }
-        /** Update iterator. */
-        ++it;
-      } // end while
-    }   // end if
+    otherImage = this->m_Elastix->GetFixedImage();
   }
-  /** In case we do use a segmentation of the moving image: */
-  else
+  else if (this->m_UseMovingSegmentation && this->m_UseFixedSegmentation)
   {
-    typename MaximumImageFilterType::Pointer maximumImageFilter;
-    /** Check if we also want to use a segmentation of the fixed image. */
-    if (this->m_UseFixedSegmentation)
+    otherImage = this->m_FixedSegmentationImage;
+  }
+
+  if (otherImage != nullptr)
+  {
+    const GrayValueImageType * grayValueImage1 = this->m_GrayValueImage1;
+    const RegionType           region = grayValueImage1->GetBufferedRegion();
+    if (otherImage->GetBufferedRegion() != region)
     {
-      maximumImageFilter = MaximumImageFilterType::New();
-      maximumImageFilter->SetInput(0, this->m_GrayValueImage1);
-      maximumImageFilter->SetInput(1, this->m_FixedSegmentationImage);
-      this->m_GrayValueImage2 = maximumImageFilter->GetOutput();
+      itkExceptionMacro(<< "ERROR: The region of the fixed image or fixed segmentation does not match the region of "
+                           "the deformation field.");
+    }
 
-      /** Do the maximum (OR filter). */
-      try
-      {
-        this->m_GrayValueImage2->Update();
-      }
-      catch (itk::ExceptionObject & excp)
-      {
-        /** Add information to the exception. */
-        excp.SetLocation("BSplineTransformWithDiffusion - DiffuseDeformationField()");
-        std::string err_str = excp.GetDescription();
-        err_str += "\nError occurred when using the maximumImageFilter to get the grayValue image.\n";
-        excp.SetDescription(err_str);
-        /** Pass the exception to an higher level. */
-        throw excp;
-      }
+    if (this->m_GrayValueImage2.IsNull() || this->m_GrayValueImage2->GetBufferedRegion() != region)
+    {
+      this->m_GrayValueImage2 = GrayValueImageType::New();
+      this->m_GrayValueImage2->SetRegions(region);
+      this->m_GrayValueImage2->Allocate();
     }
+    this->m_GrayValueImage2->CopyInformation(grayValueImage1);
+    this->m_GrayValueImage2->Modified();
+
+    const bool               threshold = !this->m_UseMovingSegmentation && this->m_ThresholdBool;
+    const GrayValuePixelType thresholdHU = this->m_ThresholdHU;
+    GrayValueImageType *     grayValueImage2 = this->m_GrayValueImage2;
+    itk::MultiThreaderBase::New()->ParallelizeImageRegion<SpaceDimension>(
+      region,
+      [grayValueImage1, otherImage, grayValueImage2, threshold, thresholdHU](const RegionType & threadRegion) {
+        itk::ImageRegionConstIterator<GrayValueImageType> it1(grayValueImage1, threadRegion);
+        itk::ImageRegionConstIterator<GrayValueImageType> itOther(otherImage, threadRegion);
+        GrayValueImageIteratorType                        it(grayValueImage2, threadRegion);
+        for (; !it.IsAtEnd(); ++it1, ++itOther, ++it)
+        {
+          /** Take the maximum (OR filter), and threshold. */
+          const GrayValuePixelType value = std::max(it1.Get(), itOther.Get());
+          if (threshold)
+          {
+            /** Everything is set to 100 for a nonpositive threshold. */
+            it.Set((value < thresholdHU && thresholdHU > 0) ? 0 : 100);
+          }
+          else
+          {
+            it.Set(value);
+          }
+        }
+      },
+      nullptr);
   }
 
   /** ------------- 4: Setup the diffusion. ------------- */
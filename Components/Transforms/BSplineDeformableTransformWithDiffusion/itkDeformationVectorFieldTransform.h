@@ -93,7 +93,8 @@ public:
    * which is often more convenient.
    * The method internally just converts this vector image to
    * nr_of_dim scalar images and passes it on to the
-   * SetCoefficientImage function.
+   * SetCoefficientImage function. The scalar images of a previous call
+   * are reused when the region is unchanged.
    */
   virtual void
   SetCoefficientVectorImage(const CoefficientVectorImageType * vecImage);
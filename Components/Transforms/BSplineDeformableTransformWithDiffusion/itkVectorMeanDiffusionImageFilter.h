@@ -24,8 +24,6 @@
 #include "itkVector.h"
 #include "itkNumericTraits.h"
 
-#include "itkRescaleIntensityImageFilter.h"
-
 namespace itk
 {
 /**
@@ -37,6 +35,13 @@ namespace itk
  *
  * A mean filter is one of the family of linear filters.
  *
+ * The mean is weighted by a "stiffness coefficient" c(x), which is the
+ * GrayValueImage rescaled to intensities between 0 and 1. Voxels with the
+ * minimum gray value are not filtered, so only the bounding box of the other
+ * voxels, the RegionOfInterest, is processed. The iterations alternate
+ * between the output and a temporary field, which is kept between calls, and
+ * are multi-threaded.
+ *
  * \sa Image
  * \sa Neighborhood
  * \sa NeighborhoodOperator
@@ -81,10 +86,6 @@ public:
   using DoubleImagePointer = typename DoubleImageType::Pointer;
   using GrayValuePixelType = typename GrayValueImageType::PixelType;
 
-  /** Typedef for the rescale intensity filter. */
-  using RescaleImageFilterType = RescaleIntensityImageFilter<GrayValueImageType, DoubleImageType>;
-  using RescaleImageFilterPointer = typename RescaleImageFilterType::Pointer;
-
   /** Set the radius of the neighborhood used to compute the mean. */
   itkSetMacro(Radius, InputSizeType);
 
@@ -115,6 +116,8 @@ public:
     return this->m_GrayValueImage.GetPointer();
   }
 
+  /** Get the region in which the field is filtered, determined by the last update. */
+  itkGetConstReferenceMacro(RegionOfInterest, InputImageRegionType);
 
 protected:
   VectorMeanDiffusionImageFilter();
@@ -147,14 +150,22 @@ private:
   unsigned int  m_NumberOfIterations;
 
   /** Declare member images. */
-  GrayValueImagePointer m_GrayValueImage;
-  DoubleImagePointer    m_Cx;
-
-  RescaleImageFilterPointer m_RescaleFilter;
+  GrayValueImagePointer            m_GrayValueImage;
+  DoubleImagePointer               m_Cx;
+  typename InputImageType::Pointer m_TemporaryField;
+  InputImageRegionType             m_RegionOfInterest;
 
-  /** For calculating a feature image from the input m_GrayValueImage. */
+  /** For calculating a feature image from the input m_GrayValueImage,
+   * and the region of interest.
+   */
   void
   FilterGrayValueImage();
+
+  /** Do one iteration of the filter, in a part of the region of interest. */
+  void
+  ThreadedDiffuse(const InputImageType *       source,
+                  InputImageType *             target,
+                  const InputImageRegionType & threadRegion) const;
 };
 
 } // end namespace itk
@@ -24,8 +24,13 @@
 #include "itkNeighborhoodIterator.h"
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkZeroFluxNeumannBoundaryCondition.h"
 #include "itkProgressReporter.h"
+#include "itkMultiThreaderBase.h"
+
+#include <algorithm> // For min and max.
+#include <mutex>
 
 namespace itk
 {
@@ -40,7 +45,6 @@ VectorMeanDiffusionImageFilter<TInputImage, TGrayValueImage>::VectorMeanDiffusio
   /** Initialize things for the filter. */
   this->m_NumberOfIterations = 0;
   this->m_Radius.Fill(1);
-  this->m_RescaleFilter = nullptr;
   this->m_GrayValueImage = nullptr;
   this->m_Cx = nullptr;
 
@@ -110,192 +114,194 @@ template <class TInputImage, class TGrayValueImage>
 void
 VectorMeanDiffusionImageFilter<TInputImage, TGrayValueImage>::GenerateData()
 {
-  // \todo to avoid all the copying we can create a vector of
-  // outputs of size this->GetNumberOfIterations(). The last
-  // output should point to this->GetOutput(). In order to avoid
-  // a big memory footprint, at some iteration k, memory of the
-  // former iteration should be released: output[ k - 1 ] = 0,
-  // and memory of the current iteration should only now be created:
-  // output[ k ] = InputImageType::New(); ...; output[ k ]->Allocate().
-  // Only for the last iteration: output[ k ]( this->GetOutput() ).
-
-  /** Create feature image. */
+  /** Create feature image, and the region of interest. */
   this->FilterGrayValueImage();
 
-  /** Declare things. */
-  unsigned int                                      i, j;
-  ZeroFluxNeumannBoundaryCondition<InputImageType>  nbc;
-  ZeroFluxNeumannBoundaryCondition<DoubleImageType> nbc2;
-  NeighborhoodIterator<InputImageType>              nit;
-  NeighborhoodIterator<DoubleImageType>             nit2;
-  VectorRealType                                    sum;
-
   /** Allocate output. */
-  typename InputImageType::ConstPointer input(this->GetInput());
-  typename InputImageType::Pointer      output(this->GetOutput());
-  auto                                  outputtmp = InputImageType::New();
-  output->SetRegions(input->GetLargestPossibleRegion());
+  const InputImageType *     input = this->GetInput();
+  InputImageType *           output = this->GetOutput();
+  const InputImageRegionType region = input->GetLargestPossibleRegion();
+  output->SetRegions(region);
 
-  try
+  if (this->m_Cx->GetBufferedRegion() != region)
   {
-    output->Allocate();
+    itkExceptionMacro(<< "The region of the GrayValueImage does not match the region of the input.");
   }
-  catch (itk::ExceptionObject & excp)
-  {
-    /** Add information to the exception and throw again. */
-    excp.SetLocation("VectorMeanDiffusionImageFilter - GenerateData()");
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError occurred while allocating the filter output.\n";
-    excp.SetDescription(err_str);
-    throw excp;
-  }
-
-  /** Allocate a temporary output image. */
-  outputtmp->SetSpacing(input->GetSpacing());
-  outputtmp->SetOrigin(input->GetOrigin());
-  outputtmp->SetRegions(input->GetLargestPossibleRegion());
 
   try
   {
-    outputtmp->Allocate();
+    output->Allocate();
   }
   catch (itk::ExceptionObject & excp)
   {
     /** Add information to the exception and throw again. */
     excp.SetLocation("VectorMeanDiffusionImageFilter - GenerateData()");
     std::string err_str = excp.GetDescription();
-    err_str += "\nError occurred while allocating a temporary copy.\n";
+    err_str += "\nError occurred while allocating the filter output.\n";
     excp.SetDescription(err_str);
     throw excp;
   }
 
-  // support progress methods/callbacks
-  // ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
-
-  /** Copy input to output. */
-  ImageRegionConstIterator<InputImageType> in_it(input, input->GetLargestPossibleRegion());
-  ImageRegionIterator<InputImageType>      out_it(output, input->GetLargestPossibleRegion());
-  in_it.GoToBegin();
-  out_it.GoToBegin();
-  while (!in_it.IsAtEnd())
-  {
-    out_it.Set(in_it.Get());
-    ++in_it;
-    ++out_it;
-  }
-
-  /** Setup neighborhood iterator for the output deformation image. */
-  nit = NeighborhoodIterator<InputImageType>(this->m_Radius, output, output->GetLargestPossibleRegion());
-  unsigned int neighborhoodSize = nit.Size();
-  nit.OverrideBoundaryCondition(&nbc);
-
-  /** Setup neighborhood iterator for the "stiffness coefficient" image. */
-  nit2 = NeighborhoodIterator<DoubleImageType>(this->m_Radius, this->m_Cx, this->m_Cx->GetLargestPossibleRegion());
-  nit2.OverrideBoundaryCondition(&nbc2);
-
-  /** Setup iterator over outputtmp. */
-  ImageRegionIterator<InputImageType> oit(outputtmp, input->GetLargestPossibleRegion());
-
-  /** Initialize c and ci. */
-  double c = 0.0;
-  double ci = 0.0;
-
-  /** Loop over the number of iterations. */
-  for (unsigned int k = 0; k < this->GetNumberOfIterations(); ++k)
+  /** Allocate a temporary output image, unless the one of the previous
+   * update can be reused.
+   */
+  const bool diffuse = this->m_NumberOfIterations > 0 && this->m_RegionOfInterest.GetNumberOfPixels() > 0;
+  if (diffuse && (this->m_TemporaryField.IsNull() || this->m_TemporaryField->GetBufferedRegion() != region))
   {
-    /** Reset the iterators. */
-    nit.GoToBegin();
-    nit2.GoToBegin();
-    oit.GoToBegin();
+    this->m_TemporaryField = InputImageType::New();
+    this->m_TemporaryField->SetRegions(region);
 
-    /** The actual work. */
-    while (!nit.IsAtEnd())
+    try
+    {
+      this->m_TemporaryField->Allocate();
+    }
+    catch (itk::ExceptionObject & excp)
     {
-      /** Speed up: do not filter locations where c(x) = 0. */
-      if (nit2.GetCenterPixel() < 0.000001)
+      /** Add information to the exception and throw again. */
+      excp.SetLocation("VectorMeanDiffusionImageFilter - GenerateData()");
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occurred while allocating a temporary copy.\n";
+      excp.SetDescription(err_str);
+      throw excp;
+    }
+  }
+
+  /** Copy input to output, and to the temporary image. Outside the region of
+   * interest both keep these values during all iterations.
+   */
+  InputImageType * temporary = diffuse ? this->m_TemporaryField.GetPointer() : nullptr;
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  multiThreader->ParallelizeImageRegion<InputImageDimension>(
+    region,
+    [input, output, temporary](const InputImageRegionType & threadRegion) {
+      ImageRegionConstIterator<InputImageType> in_it(input, threadRegion);
+      ImageRegionIterator<InputImageType>      out_it(output, threadRegion);
+      for (; !in_it.IsAtEnd(); ++in_it, ++out_it)
       {
-        /** Just copy input to output. */
-        oit.Set(nit.GetCenterPixel());
+        out_it.Set(in_it.Get());
       }
-      else
+      if (temporary != nullptr)
       {
-        /** Initialize the sum to 0. */
-        for (j = 0; j < InputImageDimension; ++j)
+        ImageRegionIterator<InputImageType> tmp_it(temporary, threadRegion);
+        for (in_it.GoToBegin(); !in_it.IsAtEnd(); ++in_it, ++tmp_it)
         {
-          sum[j] = 0.0;
+          tmp_it.Set(in_it.Get());
         }
+      }
+    },
+    nullptr);
 
-        /** Initialize sumc. */
-        double sumc = 0.0;
-
-        /** Calculate the weighted mean over the neighborhood.
-         * mean = SUthis->m_i{ ci * x_i } / SUthis->m_i{ ci }
-         */
-        for (i = 0; i < neighborhoodSize; ++i)
-        {
-          /** Get current pixel in this neighborhood. */
-          InputPixelType pix = nit.GetPixel(i);
-
-          /** Get ci-value on current index. */
-          ci = nit2.GetPixel(i);
+  if (!diffuse)
+  {
+    return;
+  }
 
-          /** Calculate SUthis->m_i{ ci } and SUthis->m_i{ ci * x_i }. */
-          sumc += ci;
-          for (j = 0; j < InputImageDimension; ++j)
-          {
-            sum[j] += ci * static_cast<double>(pix[j]);
-          }
-        }
+  /** Loop over the number of iterations, alternating the roles of the
+   * output and the temporary image.
+   */
+  InputImageType * source = output;
+  InputImageType * target = temporary;
+  for (unsigned int k = 0; k < this->GetNumberOfIterations(); ++k)
+  {
+    multiThreader->ParallelizeImageRegion<InputImageDimension>(
+      this->m_RegionOfInterest,
+      [this, source, target](const InputImageRegionType & threadRegion) {
+        this->ThreadedDiffuse(source, target, threadRegion);
+      },
+      nullptr);
+    std::swap(source, target);
+  }
 
-        /** Get the mean value by dividing by sumc. */
-        InputPixelType mean;
-        for (j = 0; j < InputImageDimension; ++j)
+  /** Copy the result of the last iteration to the output. */
+  if (source != output)
+  {
+    multiThreader->ParallelizeImageRegion<InputImageDimension>(
+      this->m_RegionOfInterest,
+      [source, output](const InputImageRegionType & threadRegion) {
+        ImageRegionConstIterator<InputImageType> in_it(source, threadRegion);
+        ImageRegionIterator<InputImageType>      out_it(output, threadRegion);
+        for (; !in_it.IsAtEnd(); ++in_it, ++out_it)
         {
-          if (sumc < 0.00001)
-          {
-            mean[j] = 0.0;
-          }
-          else
-          {
-            mean[j] = static_cast<ValueType>(sum[j] / sumc);
-          }
+          out_it.Set(in_it.Get());
         }
+      },
+      nullptr);
+  }
 
-        /** Get c. */
-        c = nit2.GetCenterPixel();
+} // end GenerateData()
 
-        /** Set 'y = (1 - c) * x + c * mean' to the temporary output. */
-        InputPixelType value = nit.GetCenterPixel() * (1.0 - c) + mean * c;
 
-        /** Set it. */
-        oit.Set(value);
+/**
+ * ********************** ThreadedDiffuse **************************
+ */
 
-      } // end if c < 0.000001
+template <class TInputImage, class TGrayValueImage>
+void
+VectorMeanDiffusionImageFilter<TInputImage, TGrayValueImage>::ThreadedDiffuse(
+  const InputImageType *       source,
+  InputImageType *             target,
+  const InputImageRegionType & threadRegion) const
+{
+  /** Setup neighborhood iterators for the deformation image and the
+   * "stiffness coefficient" image.
+   */
+  ZeroFluxNeumannBoundaryCondition<InputImageType>  nbc;
+  ZeroFluxNeumannBoundaryCondition<DoubleImageType> nbc2;
+  ConstNeighborhoodIterator<InputImageType>         nit(this->m_Radius, source, threadRegion);
+  ConstNeighborhoodIterator<DoubleImageType>        nit2(this->m_Radius, this->m_Cx, threadRegion);
+  nit.OverrideBoundaryCondition(&nbc);
+  nit2.OverrideBoundaryCondition(&nbc2);
+  const unsigned int neighborhoodSize = nit.Size();
 
-      /** Increase all iterators. */
-      ++nit;
-      ++nit2;
-      ++oit;
-      // progress.CompletedPixel();
+  /** Setup iterator over the target. */
+  ImageRegionIterator<InputImageType> oit(target, threadRegion);
 
-    } // end while
+  for (; !nit.IsAtEnd(); ++nit, ++nit2, ++oit)
+  {
+    /** Get c. */
+    const double c = nit2.GetCenterPixel();
 
-    /** Copy outputtmp to output. */
-    if (this->GetNumberOfIterations() > 0)
+    /** Speed up: do not filter locations where c(x) = 0, i.e. where the
+     * gray value image has its minimum intensity.
+     */
+    if (c <= 0.000001)
+    {
+      /** Just copy input to output. */
+      oit.Set(nit.GetCenterPixel());
+      continue;
+    }
+
+    /** Calculate the weighted mean over the neighborhood.
+     * mean = SUM_i{ ci * x_i } / SUM_i{ ci }
+     */
+    VectorRealType sum;
+    sum.Fill(0.0);
+    double sumc = 0.0;
+    for (unsigned int i = 0; i < neighborhoodSize; ++i)
     {
-      out_it.GoToBegin();
-      oit.GoToBegin();
-      while (!out_it.IsAtEnd())
+      /** Get current pixel and ci-value in this neighborhood. */
+      const InputPixelType pix = nit.GetPixel(i);
+      const double         ci = nit2.GetPixel(i);
+
+      sumc += ci;
+      for (unsigned int j = 0; j < InputImageDimension; ++j)
       {
-        out_it.Set(oit.Get());
-        ++out_it;
-        ++oit;
+        sum[j] += ci * static_cast<double>(pix[j]);
       }
-    } // end if GetNumberOfIterations() > 0
+    }
 
-  } // end for NumberOfIterations
+    /** Get the mean value by dividing by sumc. */
+    InputPixelType mean;
+    for (unsigned int j = 0; j < InputImageDimension; ++j)
+    {
+      mean[j] = (sumc < 0.00001) ? 0.0 : static_cast<ValueType>(sum[j] / sumc);
+    }
 
-} // end GenerateData()
+    /** Set 'y = (1 - c) * x + c * mean' to the target. */
+    oit.Set(nit.GetCenterPixel() * (1.0 - c) + mean * c);
+  }
+
+} // end ThreadedDiffuse()
 
 
 /**
@@ -333,8 +339,8 @@ VectorMeanDiffusionImageFilter<TInputImage, TGrayValueImage>::SetGrayValueImage(
  * ******************** FilterGrayValueImage ********************
  *
  * This function reads an image u(x). This image is rescaled to
- * intensities between 0.0 and 1.0, giving u~(x). Then we threshold
- * the coefficient image or not.
+ * intensities between 0.0 and 1.0, giving u~(x). The region of interest
+ * is the bounding box of the voxels that are not at the minimum intensity.
  */
 
 template <class TInputImage, class TGrayValueImage>
@@ -345,33 +351,123 @@ VectorMeanDiffusionImageFilter<TInputImage, TGrayValueImage>::FilterGrayValueIma
    * this->m_GrayValueImage between 0 and 1, and converts it to
    * a double image. No thresholding is performed.
    */
+  using GrayValueRegionType = typename GrayValueImageType::RegionType;
 
-  /** Create this->m_Cx. */
-  this->m_Cx = DoubleImageType::New();
+  if (this->m_GrayValueImage.IsNull())
+  {
+    itkExceptionMacro(<< "The GrayValueImage has not been set.");
+  }
+  this->m_GrayValueImage->Update();
+  const GrayValueImageType * grayValueImage = this->m_GrayValueImage;
+  const GrayValueRegionType region = grayValueImage->GetBufferedRegion();
+
+  /** Create this->m_Cx, unless the one of the previous update can be reused. */
+  if (this->m_Cx.IsNull() || this->m_Cx->GetBufferedRegion() != region)
+  {
+    this->m_Cx = DoubleImageType::New();
+    this->m_Cx->SetRegions(region);
+    try
+    {
+      this->m_Cx->Allocate();
+    }
+    catch (itk::ExceptionObject & excp)
+    {
+      /** Add information to the exception and throw again. */
+      excp.SetLocation("VectorMeanDiffusionImageFilter - FilterGrayValueImage()");
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occurred while allocating the coefficient image.\n";
+      excp.SetDescription(err_str);
+      throw excp;
+    }
+  }
+  this->m_Cx->CopyInformation(grayValueImage);
+
+  MultiThreaderBase * multiThreader = this->GetMultiThreader();
+  std::mutex          mutex;
+
+  /** Compute the minimum and maximum intensity. */
+  double minimum = NumericTraits<double>::max();
+  double maximum = NumericTraits<double>::NonpositiveMin();
+  multiThreader->ParallelizeImageRegion<InputImageDimension>(
+    region,
+    [grayValueImage, &minimum, &maximum, &mutex](const GrayValueRegionType & threadRegion) {
+      double threadMinimum = NumericTraits<double>::max();
+      double threadMaximum = NumericTraits<double>::NonpositiveMin();
+      for (ImageRegionConstIterator<GrayValueImageType> it(grayValueImage, threadRegion); !it.IsAtEnd(); ++it)
+      {
+        const double value = static_cast<double>(it.Get());
+        threadMinimum = std::min(threadMinimum, value);
+        threadMaximum = std::max(threadMaximum, value);
+      }
+      const std::lock_guard<std::mutex> lock(mutex);
+      minimum = std::min(minimum, threadMinimum);
+      maximum = std::max(maximum, threadMaximum);
+    },
+    nullptr);
 
   /** Rescale intensity of this->m_GrayValueImage to values between
-   * 0.0 and 1.0.
+   * 0.000001 and 0.999999, and find the bounding box of the voxels above
+   * the minimum.
    */
-  this->m_RescaleFilter = RescaleImageFilterType::New();
-  this->m_RescaleFilter->SetOutputMinimum(0.000001);
-  this->m_RescaleFilter->SetOutputMaximum(0.999999);
-  this->m_RescaleFilter->SetInput(this->m_GrayValueImage);
+  const double outputMinimum = 0.000001;
+  const double outputMaximum = 0.999999;
+  const double scale = (maximum > minimum) ? (outputMaximum - outputMinimum) / (maximum - minimum) : 0.0;
+
+  IndexType lowerBound;
+  IndexType upperBound;
+  lowerBound.Fill(NumericTraits<IndexValueType>::max());
+  upperBound.Fill(NumericTraits<IndexValueType>::NonpositiveMin());
+  DoubleImageType * cx = this->m_Cx;
+  multiThreader->ParallelizeImageRegion<InputImageDimension>(
+    region,
+    [grayValueImage, cx, minimum, scale, outputMinimum, &lowerBound, &upperBound, &mutex](
+      const GrayValueRegionType & threadRegion) {
+      IndexType threadLowerBound;
+      IndexType threadUpperBound;
+      threadLowerBound.Fill(NumericTraits<IndexValueType>::max());
+      threadUpperBound.Fill(NumericTraits<IndexValueType>::NonpositiveMin());
+
+      ImageRegionConstIteratorWithIndex<GrayValueImageType> it(grayValueImage, threadRegion);
+      ImageRegionIterator<DoubleImageType>                  cit(cx, threadRegion);
+      for (; !it.IsAtEnd(); ++it, ++cit)
+      {
+        const double value = static_cast<double>(it.Get());
+        cit.Set(outputMinimum + (value - minimum) * scale);
+        if (value > minimum)
+        {
+          const IndexType index = it.GetIndex();
+          for (unsigned int d = 0; d < InputImageDimension; ++d)
+          {
+            threadLowerBound[d] = std::min(threadLowerBound[d], index[d]);
+            threadUpperBound[d] = std::max(threadUpperBound[d], index[d]);
+          }
+        }
+      }
 
-  /** First set this->m_Cx = rescaleFilter->GetOutput(). */
-  this->m_Cx = this->m_RescaleFilter->GetOutput();
-  try
+      const std::lock_guard<std::mutex> lock(mutex);
+      for (unsigned int d = 0; d < InputImageDimension; ++d)
+      {
+        lowerBound[d] = std::min(lowerBound[d], threadLowerBound[d]);
+        upperBound[d] = std::max(upperBound[d], threadUpperBound[d]);
+      }
+    },
+    nullptr);
+
+  /** Set the region of interest, which is empty if all voxels are at the minimum. */
+  InputSizeType size;
+  size.Fill(0);
+  if (lowerBound[0] <= upperBound[0])
   {
-    this->m_Cx->Update();
+    for (unsigned int d = 0; d < InputImageDimension; ++d)
+    {
+      size[d] = static_cast<SizeValueType>(upperBound[d] - lowerBound[d] + 1);
+    }
   }
-  catch (itk::ExceptionObject & excp)
+  else
   {
-    /** Add information to the exception and throw again. */
-    excp.SetLocation("VectorMeanDiffusionImageFilter - FilterGrayValueImage()");
-    std::string err_str = excp.GetDescription();
-    err_str += "\nError occurred while rescaling the intensities of the grayValue image.\n";
-    excp.SetDescription(err_str);
-    throw excp;
+    lowerBound = region.GetIndex();
   }
+  this->m_RegionOfInterest = InputImageRegionType(lowerBound, size);
 
 } // end FilterGrayValueImage()
 
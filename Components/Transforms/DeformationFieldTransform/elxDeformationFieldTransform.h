@@ -43,6 +43,19 @@ namespace elastix
  * \transformparameter DeformationFieldInterpolationOrder: The interpolation order used for interpolating the
  * deformation field:\n example: <tt>(DeformationFieldInterpolationOrder 0)</tt>\n The default value is 0. Choose from
  * the allowed values 0 or 1.
+ * \transformparameter DeformationFieldStorage: How the deformation field is stored in memory. Choose from:
+ * \li "Image": as an image with float components; the default.
+ * \li "Half": in half precision (2 bytes per component), with a relative precision of about 1e-3.
+ * \li "Int16": quantized to 16 bit integers (2 bytes per component), with an absolute precision of
+ *   1.5e-5 times the largest component.
+ * \li "MemoryMapped": mapped into memory from the raw data file, which is read on demand, and shared
+ *   with other processes (for example, several transformix processes) that use the same field. This
+ *   requires an uncompressed MetaImage (mhd/mha) or NRRD (nhdr/nrrd) file with float, double, or
+ *   short components, in the byte order of the machine.\n
+ *   example: <tt>(DeformationFieldStorage "MemoryMapped")</tt>\n
+ * \transformparameter DeformationFieldQuantizationScale: For a memory mapped field with short
+ * components: the factor that converts these components to displacements. \n
+ *   example: <tt>(DeformationFieldQuantizationScale 0.001)</tt>\n The default value is 1.
  *
  *
  * \sa DeformationFieldInterpolatingTransform
@@ -107,6 +120,7 @@ public:
   /** Typedef's specific for the DeformationFieldInterpolatingTransform. */
   using DeformationFieldType = typename DeformationFieldInterpolatingTransformType::DeformationFieldType;
   using DeformationFieldVectorType = typename DeformationFieldInterpolatingTransformType::DeformationFieldVectorType;
+  using CompactDeformationFieldType = typename DeformationFieldInterpolatingTransformType::CompactDeformationFieldType;
 
   using DeformationFieldInterpolatingTransformPointer = typename DeformationFieldInterpolatingTransformType::Pointer;
 
@@ -157,6 +171,9 @@ private:
 
   /** Original direction cosines; stored to facilitate UseDirectionCosines option. */
   DirectionType m_OriginalDeformationFieldDirection;
+
+  /** The DeformationFieldStorage, as read from the transform parameter file. */
+  std::string m_DeformationFieldStorage{ "Image" };
 };
 
 } // end namespace elastix
@@ -77,6 +77,61 @@ DeformationFieldTransform<TElastix>::ReadFromFile()
     itkExceptionMacro(<< "Error while reading transform parameter file!");
   }
 
+  /** Read the interpolation order. */
+  unsigned int interpolationOrder = 0;
+  this->m_Configuration->ReadParameter(interpolationOrder, "DeformationFieldInterpolationOrder", 0);
+  if (interpolationOrder > 1)
+  {
+    xl::xout["error"] << "Error while reading DeformationFieldInterpolationOrder from the parameter file" << std::endl;
+    xl::xout["error"] << "DeformationFieldInterpolationOrder can only be 0 or 1!" << std::endl;
+    itkExceptionMacro(<< "Invalid deformation field interpolation order selected!");
+  }
+
+  /** Read how the deformation field should be stored. */
+  this->m_DeformationFieldStorage = "Image";
+  this->m_Configuration->ReadParameter(this->m_DeformationFieldStorage, "DeformationFieldStorage", 0);
+  if (this->m_DeformationFieldStorage != "Image" && this->m_DeformationFieldStorage != "Half" &&
+      this->m_DeformationFieldStorage != "Int16" && this->m_DeformationFieldStorage != "MemoryMapped")
+  {
+    xl::xout["error"] << "ERROR: DeformationFieldStorage should be one of \"Image\", \"Half\", \"Int16\", "
+                      << "or \"MemoryMapped\", but is \"" << this->m_DeformationFieldStorage << "\"." << std::endl;
+    itkExceptionMacro(<< "Error while reading transform parameter file!");
+  }
+
+  /** A memory mapped field is not read, but mapped from the file. */
+  if (this->m_DeformationFieldStorage == "MemoryMapped")
+  {
+    double quantizationScale = 1.0;
+    this->m_Configuration->ReadParameter(quantizationScale, "DeformationFieldQuantizationScale", 0);
+
+    const auto compactField = CompactDeformationFieldType::New();
+    try
+    {
+      compactField->MapRawImageFile(fileName, quantizationScale);
+    }
+    catch (itk::ExceptionObject & excp)
+    {
+      /** Add information to the exception. */
+      excp.SetLocation("DeformationFieldTransform - ReadFromFile()");
+      std::string err_str = excp.GetDescription();
+      err_str += "\nError occured while memory mapping the deformationField image.\n";
+      excp.SetDescription(err_str);
+      /** Pass the exception to an higher level. */
+      throw excp;
+    }
+
+    /** Store the original direction for later use, and possibly overrule it. */
+    this->m_OriginalDeformationFieldDirection = compactField->GetGeometry()->GetDirection();
+    if (!this->GetElastix()->GetUseDirectionCosines())
+    {
+      compactField->GetModifiableGeometry()->SetDirection(DirectionType::GetIdentity());
+    }
+
+    compactField->SetInterpolationOrder(interpolationOrder);
+    this->m_DeformationFieldInterpolatingTransform->SetCompactDeformationField(compactField);
+    return;
+  }
+
   /** Possibly overrule the direction cosines. */
   ChangeInfoFilterPointer infoChanger = ChangeInfoFilterType::New();
   infoChanger->SetOutputDirection(DirectionType::GetIdentity());
@@ -113,23 +168,30 @@ DeformationFieldTransform<TElastix>::ReadFromFile()
   using LinInterpolatorType = itk::VectorLinearInterpolateImageFunction<DeformationFieldType, CoordRepType>;
 
   typename InterpolatorType::Pointer interpolator; // default-constructed (null)
-  unsigned int                       interpolationOrder = 0;
-  this->m_Configuration->ReadParameter(interpolationOrder, "DeformationFieldInterpolationOrder", 0);
   if (interpolationOrder == 0)
   {
     interpolator = NNInterpolatorType::New();
   }
-  else if (interpolationOrder == 1)
+  else
   {
     interpolator = LinInterpolatorType::New();
   }
-  else
+  this->m_DeformationFieldInterpolatingTransform->SetDeformationFieldInterpolator(interpolator);
+
+  /** Possibly replace the field by a compact copy; the image itself is then released. */
+  if (this->m_DeformationFieldStorage != "Image")
   {
-    xl::xout["error"] << "Error while reading DeformationFieldInterpolationOrder from the parameter file" << std::endl;
-    xl::xout["error"] << "DeformationFieldInterpolationOrder can only be 0 or 1!" << std::endl;
-    itkExceptionMacro(<< "Invalid deformation field interpolation order selected!");
+    using ComponentStorageEnum = typename CompactDeformationFieldType::ComponentStorageEnum;
+    const auto compactField = CompactDeformationFieldType::New();
+    compactField->SetDeformationField(infoChanger->GetOutput(),
+                                      (this->m_DeformationFieldStorage == "Half") ? ComponentStorageEnum::Half
+                                                                                  : ComponentStorageEnum::Int16);
+    compactField->SetInterpolationOrder(interpolationOrder);
+
+    /** SetIdentity() replaces the image by an empty field. */
+    this->m_DeformationFieldInterpolatingTransform->SetIdentity();
+    this->m_DeformationFieldInterpolatingTransform->SetCompactDeformationField(compactField);
   }
-  this->m_DeformationFieldInterpolatingTransform->SetDeformationFieldInterpolator(interpolator);
 
 } // end ReadFromFile()
 
@@ -153,11 +215,20 @@ DeformationFieldTransform<TElastix>::WriteDerivedTransformDataToFile() const
   std::string interpolatorName =
     this->m_DeformationFieldInterpolatingTransform->GetDeformationFieldInterpolator()->GetNameOfClass();
 
+  /** A compact field is written with float components. */
+  const auto compactField = this->m_DeformationFieldInterpolatingTransform->GetCompactDeformationField();
+  typename DeformationFieldType::Pointer deformationField =
+    this->m_DeformationFieldInterpolatingTransform->GetDeformationField();
+  if (compactField != nullptr)
+  {
+    deformationField = compactField->CreateDeformationField();
+  }
+
   /** Possibly change the direction cosines to there original value */
   auto infoChanger = ChangeInfoFilterType::New();
   infoChanger->SetOutputDirection(this->m_OriginalDeformationFieldDirection);
   infoChanger->SetChangeDirection(!this->GetElastix()->GetUseDirectionCosines());
-  infoChanger->SetInput(this->m_DeformationFieldInterpolatingTransform->GetDeformationField());
+  infoChanger->SetInput(deformationField);
 
   /** Write the deformation field image. */
   try
@@ -188,10 +259,27 @@ DeformationFieldTransform<TElastix>::CreateDerivedTransformParametersMap() const
 {
   const std::string interpolatorName =
     m_DeformationFieldInterpolatingTransform->GetDeformationFieldInterpolator()->GetNameOfClass();
-  const auto interpolationOrder = (interpolatorName == "LinearInterpolateImageFunction") ? 1U : 0U;
+  auto interpolationOrder = (interpolatorName == "LinearInterpolateImageFunction") ? 1U : 0U;
+
+  const auto compactField = m_DeformationFieldInterpolatingTransform->GetCompactDeformationField();
+  if (compactField != nullptr)
+  {
+    interpolationOrder = compactField->GetInterpolationOrder();
+  }
 
-  return { { "DeformationFieldFileName", { TransformIO::MakeDeformationFieldFileName(*this) } },
-           { "DeformationFieldInterpolationOrder", { Conversion::ToString(interpolationOrder) } } };
+  ParameterMapType parameterMap{
+    { "DeformationFieldFileName", { TransformIO::MakeDeformationFieldFileName(*this) } },
+    { "DeformationFieldInterpolationOrder", { Conversion::ToString(interpolationOrder) } }
+  };
+
+  /** The written field has float components, in the ResultImageFormat, which
+   * need not be mappable. So only the in-memory storage is passed on.
+   */
+  if (m_DeformationFieldStorage == "Half" || m_DeformationFieldStorage == "Int16")
+  {
+    parameterMap["DeformationFieldStorage"] = { m_DeformationFieldStorage };
+  }
+  return parameterMap;
 
 } // end CustomizeTransformParametersMap()
 
@@ -20,6 +20,7 @@
 
 #include <iostream>
 #include "itkAdvancedTransform.h"
+#include "itkCompactDeformationField.h"
 #include "itkMacro.h"
 #include "itkImage.h"
 #include "itkVectorInterpolateImageFunction.h"
@@ -36,6 +37,11 @@ namespace itk
  * is not implemented. DO NOT USE IT FOR REGISTRATION.
  * You may set your own interpolator!
  *
+ * Alternatively, a CompactDeformationField can be set, which stores the
+ * field in half precision, quantized, or memory mapped from a file, and
+ * interpolates it itself. When set, it takes precedence over the deformation
+ * field and its interpolator.
+ *
  * \ingroup Transforms
  */
 
@@ -94,6 +100,9 @@ public:
   using DefaultDeformationFieldInterpolatorType =
     VectorNearestNeighborInterpolateImageFunction<DeformationFieldType, ScalarType>;
 
+  using CompactDeformationFieldType = CompactDeformationField<ScalarType, NDimensions, TComponentType>;
+  using CompactDeformationFieldPointer = typename CompactDeformationFieldType::Pointer;
+
   /** Set the transformation parameters is not supported.
    * Use SetDeformationField() instead
    */
@@ -172,6 +181,14 @@ public:
 
   itkGetModifiableObjectMacro(DeformationFieldInterpolator, DeformationFieldInterpolatorType);
 
+  /** Set/Get the compact deformation field. When not null, it is used instead of
+   * the deformation field and its interpolator. Setting a deformation field resets it.
+   */
+  virtual void
+  SetCompactDeformationField(CompactDeformationFieldType * _arg);
+
+  itkGetModifiableObjectMacro(CompactDeformationField, CompactDeformationFieldType);
+
   bool
   IsLinear() const override
   {
@@ -255,6 +272,7 @@ protected:
   DeformationFieldPointer             m_DeformationField;
   DeformationFieldPointer             m_ZeroDeformationField;
   DeformationFieldInterpolatorPointer m_DeformationFieldInterpolator;
+  CompactDeformationFieldPointer      m_CompactDeformationField;
 
 private:
   DeformationFieldInterpolatingTransform(const Self &) = delete;
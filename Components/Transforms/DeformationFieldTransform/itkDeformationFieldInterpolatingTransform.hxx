@@ -45,6 +45,16 @@ auto
 DeformationFieldInterpolatingTransform<TScalarType, NDimensions, TComponentType>::TransformPoint(
   const InputPointType & point) const -> OutputPointType
 {
+  if (this->m_CompactDeformationField.IsNotNull())
+  {
+    OutputVectorType displacement;
+    if (this->m_CompactDeformationField->Evaluate(point, displacement))
+    {
+      return point + displacement;
+    }
+    return point;
+  }
+
   InputContinuousIndexType cindex;
   this->m_DeformationFieldInterpolator->ConvertPointToContinuousIndex(point, cindex);
 
@@ -72,9 +82,10 @@ DeformationFieldInterpolatingTransform<TScalarType, NDimensions, TComponentType>
   DeformationFieldType * _arg)
 {
   itkDebugMacro("setting DeformationField to " << _arg);
-  if (this->m_DeformationField != _arg)
+  if (this->m_DeformationField != _arg || this->m_CompactDeformationField.IsNotNull())
   {
     this->m_DeformationField = _arg;
+    this->m_CompactDeformationField = nullptr;
     this->Modified();
   }
   if (this->m_DeformationFieldInterpolator.IsNotNull())
@@ -84,6 +95,21 @@ DeformationFieldInterpolatingTransform<TScalarType, NDimensions, TComponentType>
 }
 
 
+// Set the compact deformation field
+template <class TScalarType, unsigned int NDimensions, class TComponentType>
+void
+DeformationFieldInterpolatingTransform<TScalarType, NDimensions, TComponentType>::SetCompactDeformationField(
+  CompactDeformationFieldType * _arg)
+{
+  itkDebugMacro("setting CompactDeformationField to " << _arg);
+  if (this->m_CompactDeformationField != _arg)
+  {
+    this->m_CompactDeformationField = _arg;
+    this->Modified();
+  }
+}
+
+
 // Set the deformation field interpolator
 template <class TScalarType, unsigned int NDimensions, class TComponentType>
 void
@@ -114,6 +140,7 @@ DeformationFieldInterpolatingTransform<TScalarType, NDimensions, TComponentType>
   os << indent << "DeformationField: " << this->m_DeformationField << std::endl;
   os << indent << "ZeroDeformationField: " << this->m_ZeroDeformationField << std::endl;
   os << indent << "DeformationFieldInterpolator: " << this->m_DeformationFieldInterpolator << std::endl;
+  os << indent << "CompactDeformationField: " << this->m_CompactDeformationField << std::endl;
 }
 
 
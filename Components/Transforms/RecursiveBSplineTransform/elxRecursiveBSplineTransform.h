@@ -76,6 +76,17 @@ namespace elastix
  *   <em>Nonrigid registration of dynamic medical imaging data using nD+t B-splines and a
  *   groupwise optimization approach</em>, C.T. Metz, S. Klein, M. Schaap, T. van Walsum and
  *   W.J. Niessen, Medical Image Analysis, in press.
+ * \parameter UseInterleavedCoefficients: keep an additional copy of the B-spline coefficients
+ *   in which the coefficients of each control point are stored next to each other. This
+ *   reduces the number of cache misses when transforming points, at the cost of extra memory. \n
+ *   example: <tt>(UseInterleavedCoefficients "true")</tt> \n
+ *   The default is "false".
+ * \parameter UseDirectGridUpsampling: when the B-spline grid is refined between resolutions
+ *   by halving the grid spacing, compute the new coefficients directly from the B-spline
+ *   subdivision rule, multi-threaded, instead of resampling the coefficient images. For
+ *   spline orders 1 and 3 this yields the same transform. Ignored for cyclic transforms. \n
+ *   example: <tt>(UseDirectGridUpsampling "true")</tt> \n
+ *   The default is "false".
  *
  *
  * The transform parameters necessary for transformix, additionally defined by this class, are:
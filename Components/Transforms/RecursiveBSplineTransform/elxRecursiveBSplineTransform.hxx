@@ -51,10 +51,22 @@ RecursiveBSplineTransform<TElastix>::InitializeBSplineTransform()
     m_BSplineTransform = BSplineTransformBaseType::template Create<itk::RecursiveBSplineTransform>(m_SplineOrder);
   }
 
+  /** Optionally keep an interleaved copy of the coefficients for faster point evaluation. */
+  bool useInterleavedCoefficients = false;
+  this->GetConfiguration()->ReadParameter(
+    useInterleavedCoefficients, "UseInterleavedCoefficients", this->GetComponentLabel(), 0, 0, false);
+  m_BSplineTransform->SetUseInterleavedCoefficients(useInterleavedCoefficients);
+
   this->SetCurrentTransform(this->m_BSplineTransform);
   this->m_GridUpsampler = GridUpsamplerType::New();
   this->m_GridUpsampler->SetBSplineOrder(this->m_SplineOrder);
 
+  /** Optionally compute dyadic grid refinements directly, which is not supported for cyclic grids. */
+  bool useDirectGridUpsampling = false;
+  this->GetConfiguration()->ReadParameter(
+    useDirectGridUpsampling, "UseDirectGridUpsampling", this->GetComponentLabel(), 0, 0, false);
+  this->m_GridUpsampler->SetUseDirectSubdivision(useDirectGridUpsampling && !this->m_Cyclic);
+
   return 0;
 } // end InitializeBSplineTransform()
 
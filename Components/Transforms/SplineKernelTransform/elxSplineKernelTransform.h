@@ -25,6 +25,7 @@
 #include "itkThinPlateSplineKernelTransform2.h"
 #include "itkThinPlateR2LogRSplineKernelTransform2.h"
 #include "itkVolumeSplineKernelTransform2.h"
+#include "itkWendlandSplineKernelTransform2.h"
 
 namespace elastix
 {
@@ -53,11 +54,24 @@ namespace elastix
  *    <tt>(%Transform "SplineKernelTransform")</tt>
  * \parameter SplineKernelType: Select the deformation model, which must
  * be one of { ThinPlateSpline, ThinPlateR2LogRSpline, VolumeSpline,
- * ElasticBodySpline, ElasticBodyReciprocalSpline). In 2D this option is
- * ignored and a ThinPlateSpline will always be used. \n
+ * ElasticBodySpline, ElasticBodyReciprocalSpline, WendlandSpline). In 2D this option is
+ * ignored and a ThinPlateSpline will always be used, except for the WendlandSpline. \n
  *   example: <tt>(SplineKernelType "ElasticBodySpline")</tt>\n
  * Default: ThinPlateSpline. You cannot specify this parameter for each
- * resolution differently.
+ * resolution differently. The WendlandSpline has a compactly supported kernel,
+ * which, combined with the SparseLU TPSMatrixInversionMethod, makes the transform
+ * scale to many thousands of landmarks.
+ * \parameter SplineKernelSupportRadius: the radius beyond which the kernel of the
+ * WendlandSpline is zero, in world coordinates. Required for the WendlandSpline, and
+ * ignored for the other SplineKernelTypes. Choose it such that each landmark has a
+ * few other landmarks within this radius.\n
+ *   example: <tt>(SplineKernelSupportRadius 40.0 )</tt>\n
+ * You cannot specify this parameter for each resolution differently.
+ * \parameter TPSMatrixInversionMethod: the method used to solve the spline system,
+ * one of { SVD, QR, SparseLU }. SparseLU stores the system as a sparse matrix, and is
+ * intended for the WendlandSpline.\n
+ *   example: <tt>(TPSMatrixInversionMethod "SparseLU")</tt>\n
+ * Default: SVD.
  * \parameter SplineRelaxationFactor: make the spline interpolating or
  * approximating. A value of 0.0 gives an interpolating transform. Higher
  * values result in approximating splines.\n
@@ -91,8 +105,8 @@ namespace elastix
  *    <tt>(%Transform "SplineKernelTransform")</tt>
  * \transformparameter SplineKernelType: Select the deformation model,
  * which must be one of { ThinPlateSpline, ThinPlateR2LogRSpline, VolumeSpline,
- * ElasticBodySpline, ElasticBodyReciprocalSpline). In 2D this option is
- * ignored and a ThinPlateSpline will always be used. \n
+ * ElasticBodySpline, ElasticBodyReciprocalSpline, WendlandSpline). In 2D this option is
+ * ignored and a ThinPlateSpline will always be used, except for the WendlandSpline. \n
  *   example: <tt>(SplineKernelType "ElasticBodySpline")</tt>\n   *
  * \transformparameter SplineRelaxationFactor: make the spline interpolating
  * or approximating. A value of 0.0 gives an interpolating transform.
@@ -104,6 +118,12 @@ namespace elastix
  *   example: <tt>(SplinePoissonRatio 0.3 )</tt>\n
  * Valid values are withing -1.0 and 0.5. 0.5 means incompressible.
  * Negative values are a bit odd, but possible. See Wikipedia on PoissonRatio.
+ * \transformparameter SplineKernelSupportRadius: the support radius of the
+ * WendlandSpline. Only written for the WendlandSpline.\n
+ *   example: <tt>(SplineKernelSupportRadius 40.0 )</tt>\n
+ * \transformparameter TPSMatrixInversionMethod: the method used to solve the
+ * spline system, one of { SVD, QR, SparseLU }. Only written when it is not SVD.\n
+ *   example: <tt>(TPSMatrixInversionMethod "SparseLU")</tt>\n
  * \transformparameter FixedImageLandmarks: The landmark positions in the
  * fixed image, in world coordinates. Positions written as x1 y1 [z1] x2 y2 [z2] etc.\n
  *   example: <tt>(FixedImageLandmarks 10.0 11.0 12.0 4.0 4.0 4.0 6.0 6.0 6.0 )</tt>
@@ -207,6 +227,7 @@ protected:
   using VKernelTransformType = itk::VolumeSplineKernelTransform2<CoordRepType, Self::SpaceDimension>;
   using EBKernelTransformType = itk::ElasticBodySplineKernelTransform2<CoordRepType, Self::SpaceDimension>;
   using EBRKernelTransformType = itk::ElasticBodyReciprocalSplineKernelTransform2<CoordRepType, Self::SpaceDimension>;
+  using WKernelTransformType = itk::WendlandSplineKernelTransform2<CoordRepType, Self::SpaceDimension>;
 
   /** Create an instance of a kernel transform. Returns false if the
    * kernelType is unknown.
@@ -214,6 +235,12 @@ protected:
   virtual bool
   SetKernelType(const std::string & kernelType);
 
+  /** Read the SplineKernelSupportRadius and set it in the kernel transform,
+   * for the compactly supported kernel types. Throws if it is not positive.
+   */
+  virtual void
+  SetKernelSupportRadius();
+
   /** Read source landmarks from fp file
    * \li Try reading -fp file
    */
@@ -51,9 +51,9 @@ SplineKernelTransform<TElastix>::SetKernelType(const std::string & kernelType)
    * appropriate for 2D and the normal for 3D
    * \todo: understand why
    */
-  if (SpaceDimension == 2)
+  if (SpaceDimension == 2 && kernelType != "WendlandSpline")
   {
-    /** only one variant for 2D possible: */
+    /** only one variant for 2D possible, apart from the compactly supported kernel: */
     this->m_KernelTransform = TPRKernelTransformType::New();
   }
   else
@@ -81,6 +81,10 @@ SplineKernelTransform<TElastix>::SetKernelType(const std::string & kernelType)
     {
       this->m_KernelTransform = EBRKernelTransformType::New();
     }
+    else if (kernelType == "WendlandSpline")
+    {
+      this->m_KernelTransform = WKernelTransformType::New();
+    }
     else
     {
       /** unknown kernelType */
@@ -95,6 +99,33 @@ SplineKernelTransform<TElastix>::SetKernelType(const std::string & kernelType)
 } // end SetKernelType()
 
 
+/*
+ * ******************* SetKernelSupportRadius ***********************
+ */
+
+template <class TElastix>
+void
+SplineKernelTransform<TElastix>::SetKernelSupportRadius()
+{
+  auto * wendlandTransform = dynamic_cast<WKernelTransformType *>(this->m_KernelTransform.GetPointer());
+  if (wendlandTransform == nullptr)
+  {
+    return;
+  }
+
+  double supportRadius = 0.0;
+  this->GetConfiguration()->ReadParameter(supportRadius, "SplineKernelSupportRadius", this->GetComponentLabel(), 0, -1);
+  if (supportRadius <= 0.0)
+  {
+    xl::xout["error"] << "ERROR: a positive SplineKernelSupportRadius should be given for the "
+                      << this->m_SplineKernelType << "." << std::endl;
+    itkExceptionMacro(<< "ERROR: unable to configure " << this->GetComponentLabel());
+  }
+  wendlandTransform->SetSupportRadius(supportRadius);
+
+} // end SetKernelSupportRadius()
+
+
 /*
  * ******************* BeforeAll ***********************
  */
@@ -182,7 +213,10 @@ SplineKernelTransform<TElastix>::BeforeRegistration()
     this->m_KernelTransform->SetPoissonRatio(poissonRatio);
   }
 
-  /** Set the matrix inversion method (one of {SVD, QR}). */
+  /** Set the support radius of a compactly supported kernel. */
+  this->SetKernelSupportRadius();
+
+  /** Set the matrix inversion method (one of {SVD, QR, SparseLU}). */
   std::string matrixInversionMethod = "SVD";
   this->GetConfiguration()->ReadParameter(matrixInversionMethod, "TPSMatrixInversionMethod", 0, true);
   this->m_KernelTransform->SetMatrixInversionMethod(matrixInversionMethod);
@@ -190,6 +224,20 @@ SplineKernelTransform<TElastix>::BeforeRegistration()
   /** Load fixed image (source) landmark positions. */
   this->DetermineSourceLandmarks();
 
+  /** With the sparse LU decomposition, the inverse of L is not computed when
+   * setting the source landmarks, since transforming points does not need it.
+   * The registration needs it for the Jacobian, however.
+   */
+  if (matrixInversionMethod == "SparseLU")
+  {
+    itk::TimeProbe timer;
+    timer.Start();
+    elxout << "  Computing the inverse of the sparse L matrix, for the Jacobian ..." << std::endl;
+    this->m_KernelTransform->ComputeLInverse();
+    timer.Stop();
+    elxout << "  Computing the inverse took: " << Conversion::SecondsToDHMS(timer.GetMean(), 6) << std::endl;
+  }
+
   /** Load moving image (target) landmark positions. */
   bool movingLandmarksGiven = this->DetermineTargetLandmarks();
 
@@ -402,6 +450,14 @@ SplineKernelTransform<TElastix>::ReadFromFile()
   this->GetConfiguration()->ReadParameter(poissonRatio, "SplinePoissonRatio", this->GetComponentLabel(), 0, -1);
   this->m_KernelTransform->SetPoissonRatio(poissonRatio);
 
+  /** Set the support radius of a compactly supported kernel. */
+  this->SetKernelSupportRadius();
+
+  /** Set the matrix inversion method (one of {SVD, QR, SparseLU}). */
+  std::string matrixInversionMethod = "SVD";
+  this->GetConfiguration()->ReadParameter(matrixInversionMethod, "TPSMatrixInversionMethod", 0, true);
+  this->m_KernelTransform->SetMatrixInversionMethod(matrixInversionMethod);
+
   /** Read number of parameters. */
   unsigned int numberOfParameters = 0;
   this->GetConfiguration()->ReadParameter(numberOfParameters, "NumberOfParameters", 0);
@@ -444,10 +500,22 @@ SplineKernelTransform<TElastix>::CreateDerivedTransformParametersMap() const ->
 {
   auto & itkTransform = *m_KernelTransform;
 
-  return { { "SplineKernelType", { m_SplineKernelType } },
-           { "SplinePoissonRatio", { Conversion::ToString(itkTransform.GetPoissonRatio()) } },
-           { "SplineRelaxationFactor", { Conversion::ToString(itkTransform.GetStiffness()) } },
-           { "FixedImageLandmarks", Conversion::ToVectorOfStrings(itkTransform.GetFixedParameters()) } };
+  ParameterMapType parameterMap{
+    { "SplineKernelType", { m_SplineKernelType } },
+    { "SplinePoissonRatio", { Conversion::ToString(itkTransform.GetPoissonRatio()) } },
+    { "SplineRelaxationFactor", { Conversion::ToString(itkTransform.GetStiffness()) } },
+    { "FixedImageLandmarks", Conversion::ToVectorOfStrings(itkTransform.GetFixedParameters()) }
+  };
+
+  if (itkTransform.GetKernelSupportRadius() > 0.0)
+  {
+    parameterMap["SplineKernelSupportRadius"] = { Conversion::ToString(itkTransform.GetKernelSupportRadius()) };
+  }
+  if (itkTransform.GetMatrixInversionMethod() != "SVD")
+  {
+    parameterMap["TPSMatrixInversionMethod"] = { itkTransform.GetMatrixInversionMethod() };
+  }
+  return parameterMap;
 
 } // end CustomizeTransformParametersMap()
 
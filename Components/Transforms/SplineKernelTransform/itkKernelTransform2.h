@@ -46,8 +46,11 @@ PURPOSE.  See the above copyright notices for more information.
 #include <vnl/vnl_vector.h>
 #include <vnl/vnl_vector_fixed.h>
 #include <vnl/vnl_sample.h>
+#include <vnl/vnl_sparse_matrix.h>
 #include <vnl/algo/vnl_svd.h>
 #include <vnl/algo/vnl_qr.h>
+#include <vnl/algo/vnl_sparse_lu.h>
+#include <vector>
 
 namespace itk
 {
@@ -86,6 +89,11 @@ namespace itk
  * - Support for matrix inversion by QR decomposition, instead of SVD.
  *   QR is much faster. Used in SetParameters() and SetFixedParameters().
  * - Much faster Jacobian computation for some of the derived kernel transforms.
+ * - Support for compactly supported kernels: the source landmarks are stored in
+ *   a uniform grid, so that only the landmarks within the support of the kernel
+ *   are visited when transforming a point. In combination with the "SparseLU"
+ *   matrix inversion method the L matrix is stored and decomposed as a sparse
+ *   matrix, which makes thousands of landmarks feasible.
  *
  * \ingroup Transforms
  *
@@ -295,10 +303,33 @@ public:
   }
 
 
-  /** Matrix inversion by SVD or QR decomposition. */
-  itkSetMacro(MatrixInversionMethod, std::string);
+  /** Matrix inversion by SVD, QR, or sparse LU decomposition ("SVD", "QR", or "SparseLU").
+   * The sparse LU decomposition is intended for compactly supported kernels. With
+   * "SparseLU", the inverse of L, which is only needed for GetJacobian(), is not
+   * computed automatically when the source landmarks are set: call ComputeLInverse().
+   */
+  virtual void
+  SetMatrixInversionMethod(const std::string & method)
+  {
+    if (this->m_MatrixInversionMethod != method)
+    {
+      this->m_MatrixInversionMethod = method;
+      this->m_LMatrixComputed = false;
+      this->m_LMatrixDecompositionComputed = false;
+      this->Modified();
+    }
+  }
   itkGetConstReferenceMacro(MatrixInversionMethod, std::string);
 
+  /** The radius beyond which the kernel is zero. The default, zero, means that
+   * the kernel has global support. It is overridden by compactly supported kernels.
+   */
+  virtual TScalarType
+  GetKernelSupportRadius() const
+  {
+    return 0.0;
+  }
+
   /** Must be provided. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override
@@ -429,6 +460,24 @@ protected:
   void
   ComputeK();
 
+  /** Compute the L matrix as a sparse matrix, for the "SparseLU" method. */
+  void
+  ComputeSparseL();
+
+  /** Store the source landmarks in a uniform grid, with cells of (at least)
+   * the size of the kernel support. Only done for compactly supported kernels.
+   */
+  void
+  ComputeLandmarkGrid();
+
+  /** Call function( landmarkIndex, point - landmark ) for all source landmarks
+   * within the support of the kernel around the point. Requires a
+   * compactly supported kernel, and ComputeLandmarkGrid().
+   */
+  template <class TFunction>
+  void
+  ForEachLandmarkInSupport(const InputPointType & point, TFunction && function) const;
+
   /** Compute L matrix. */
   void
   ComputeL();
@@ -463,6 +512,10 @@ protected:
   /** The L matrix. */
   LMatrixType m_LMatrix;
 
+  /** The L matrix, stored as a sparse matrix (for the "SparseLU" method only). */
+  using SparseLMatrixType = vnl_sparse_matrix<double>;
+  SparseLMatrixType m_SparseLMatrix;
+
   /** The inverse of L, which we also cache. */
   LMatrixType m_LMatrixInverse;
 
@@ -516,8 +569,23 @@ protected:
   using SVDDecompositionType = vnl_svd<ScalarType>;
   using QRDecompositionType = vnl_qr<ScalarType>;
 
-  SVDDecompositionType * m_LMatrixDecompositionSVD;
-  QRDecompositionType *  m_LMatrixDecompositionQR;
+  using SparseLUDecompositionType = vnl_sparse_lu;
+
+  SVDDecompositionType *      m_LMatrixDecompositionSVD;
+  QRDecompositionType *       m_LMatrixDecompositionQR;
+  SparseLUDecompositionType * m_LMatrixDecompositionSparseLU;
+
+  /** The uniform grid of source landmarks, for compactly supported kernels.
+   * The landmarks of cell c are m_LandmarkGridIndices[ m_LandmarkGridCellStart[ c ] ]
+   * up to m_LandmarkGridIndices[ m_LandmarkGridCellStart[ c + 1 ] ], and their
+   * positions are stored in the same order in m_LandmarkGridPoints.
+   */
+  InputPointType                m_LandmarkGridOrigin;
+  double                        m_LandmarkGridCellSize;
+  FixedArray<long, NDimensions> m_LandmarkGridSize;
+  std::vector<unsigned long>    m_LandmarkGridCellStart;
+  std::vector<unsigned long>    m_LandmarkGridIndices;
+  std::vector<InputPointType>   m_LandmarkGridPoints;
 
   /** Identity matrix. */
   IMatrixType m_I;
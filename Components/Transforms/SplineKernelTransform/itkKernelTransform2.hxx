@@ -36,6 +36,9 @@ PURPOSE.  See the above copyright notices for more information.
 
 #include "itkKernelTransform2.h"
 
+#include <algorithm> // For min and max.
+#include <cmath>
+
 namespace itk
 {
 
@@ -64,6 +67,8 @@ KernelTransform2<TScalarType, NDimensions>::KernelTransform2()
 
   this->m_LMatrixDecompositionSVD = nullptr;
   this->m_LMatrixDecompositionQR = nullptr;
+  this->m_LMatrixDecompositionSparseLU = nullptr;
+  this->m_LandmarkGridCellSize = 0.0;
 
   this->m_Stiffness = 0.0;
   this->m_PoissonRatio = 0.3;
@@ -86,6 +91,7 @@ KernelTransform2<TScalarType, NDimensions>::~KernelTransform2()
 {
   delete m_LMatrixDecompositionSVD;
   delete m_LMatrixDecompositionQR;
+  delete m_LMatrixDecompositionSparseLU;
 
 } // end destructor
 
@@ -112,7 +118,15 @@ KernelTransform2<TScalarType, NDimensions>::SetSourceLandmarks(PointSetType * la
     this->m_LMatrixDecompositionComputed = false;
 
     // you must recompute L and Linv - this does not require the targ landmarks
-    this->ComputeLInverse();
+    // With the sparse LU decomposition, Linv is only computed on request.
+    if (this->m_MatrixInversionMethod != "SparseLU")
+    {
+      this->ComputeLInverse();
+    }
+    else
+    {
+      this->m_LMatrixInverse.clear();
+    }
 
     // Precompute the nonzerojacobianindices vector
     const NumberOfParametersType nrParams = this->GetNumberOfParameters();
@@ -187,10 +201,28 @@ void
 KernelTransform2<TScalarType, NDimensions>::ComputeDeformationContribution(const InputPointType & thisPoint,
                                                                            OutputPointType &      opp) const
 {
+  GMatrixType Gmatrix;
+
+  /** For compactly supported kernels, only visit the landmarks in the support. */
+  if (this->m_LandmarkGridCellSize > 0.0)
+  {
+    this->ForEachLandmarkInSupport(thisPoint,
+                                   [this, &opp, &Gmatrix](const unsigned long lnd, const InputVectorType & x) {
+                                     this->ComputeG(x, Gmatrix);
+                                     for (unsigned int dim = 0; dim < NDimensions; ++dim)
+                                     {
+                                       for (unsigned int odim = 0; odim < NDimensions; ++odim)
+                                       {
+                                         opp[odim] += Gmatrix(dim, odim) * this->m_DMatrix(dim, lnd);
+                                       }
+                                     }
+                                   });
+    return;
+  }
+
   const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
 
   PointsIterator sp = this->m_SourceLandmarks->GetPoints()->Begin();
-  GMatrixType    Gmatrix;
 
   for (unsigned long lnd = 0; lnd < numberOfLandmarks; ++lnd)
   {
@@ -281,6 +313,27 @@ KernelTransform2<TScalarType, NDimensions>::ComputeWMatrix()
     //     vnl_qr<TScalarType> qr( this->m_LMatrix );
     //     this->m_WMatrix = qr.solve( this->m_YMatrix );
   }
+  else if (this->m_MatrixInversionMethod == "SparseLU")
+  {
+    if (!this->m_LMatrixDecompositionComputed)
+    {
+      delete this->m_LMatrixDecompositionSparseLU;
+      this->m_LMatrixDecompositionSparseLU = new SparseLUDecompositionType(this->m_SparseLMatrix);
+      this->m_LMatrixDecompositionComputed = true;
+    }
+
+    vnl_vector<double> y(this->m_YMatrix.rows());
+    for (unsigned int i = 0; i < y.size(); ++i)
+    {
+      y[i] = this->m_YMatrix(i, 0);
+    }
+    const vnl_vector<double> w = this->m_LMatrixDecompositionSparseLU->solve(y);
+    this->m_WMatrix.set_size(w.size(), 1);
+    for (unsigned int i = 0; i < w.size(); ++i)
+    {
+      this->m_WMatrix(i, 0) = w[i];
+    }
+  }
   else
   {
     itkExceptionMacro(<< "ERROR: invalid matrix inversion method (" << this->m_MatrixInversionMethod << ")");
@@ -317,6 +370,31 @@ KernelTransform2<TScalarType, NDimensions>::ComputeLInverse()
     this->m_LMatrixInverse = vnl_qr<TScalarType>(this->m_LMatrix).inverse();
     this->m_LInverseComputed = true;
   }
+  else if (this->m_MatrixInversionMethod == "SparseLU")
+  {
+    if (!this->m_LMatrixDecompositionComputed)
+    {
+      delete this->m_LMatrixDecompositionSparseLU;
+      this->m_LMatrixDecompositionSparseLU = new SparseLUDecompositionType(this->m_SparseLMatrix);
+      this->m_LMatrixDecompositionComputed = true;
+    }
+
+    /** Solve for the columns of the inverse, one at a time. The inverse is dense. */
+    const unsigned int size = this->m_SparseLMatrix.rows();
+    this->m_LMatrixInverse.set_size(size, size);
+    vnl_vector<double> unitVector(size, 0.0);
+    for (unsigned int j = 0; j < size; ++j)
+    {
+      unitVector[j] = 1.0;
+      const vnl_vector<double> column = this->m_LMatrixDecompositionSparseLU->solve(unitVector);
+      unitVector[j] = 0.0;
+      for (unsigned int i = 0; i < size; ++i)
+      {
+        this->m_LMatrixInverse(i, j) = column[i];
+      }
+    }
+    this->m_LInverseComputed = true;
+  }
   else
   {
     itkExceptionMacro(<< "ERROR: invalid matrix inversion method (" << this->m_MatrixInversionMethod << ")");
@@ -333,6 +411,17 @@ template <class TScalarType, unsigned int NDimensions>
 void
 KernelTransform2<TScalarType, NDimensions>::ComputeL()
 {
+  /** The grid is used by compactly supported kernels, for any inversion method. */
+  this->ComputeLandmarkGrid();
+
+  if (this->m_MatrixInversionMethod == "SparseLU")
+  {
+    this->ComputeSparseL();
+    this->m_LMatrixComputed = true;
+    this->m_LMatrixDecompositionComputed = false;
+    return;
+  }
+
   const unsigned long     numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
   vnl_matrix<TScalarType> O2(NDimensions * (NDimensions + 1), NDimensions * (NDimensions + 1), 0);
 
@@ -403,6 +492,255 @@ KernelTransform2<TScalarType, NDimensions>::ComputeK()
 } // end ComputeK()
 
 
+/**
+ * ******************* ComputeSparseL *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>::ComputeSparseL()
+{
+  const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
+  const unsigned long kSize = NDimensions * numberOfLandmarks;
+  this->m_SparseLMatrix = SparseLMatrixType(NDimensions * (numberOfLandmarks + NDimensions + 1),
+                                            NDimensions * (numberOfLandmarks + NDimensions + 1));
+
+  GMatrixType G;
+  const auto  addBlock = [this, &G](const unsigned long i, const unsigned long j) {
+    for (unsigned int a = 0; a < NDimensions; ++a)
+    {
+      for (unsigned int b = 0; b < NDimensions; ++b)
+      {
+        if (G(a, b) != 0.0)
+        {
+          this->m_SparseLMatrix(i * NDimensions + a, j * NDimensions + b) = G(a, b);
+        }
+      }
+    }
+  };
+
+  /** The K part: the kernel of all pairs of landmarks, as in ComputeK(). For
+   * compactly supported kernels only the pairs within the support are visited.
+   */
+  PointsIterator p1 = this->m_SourceLandmarks->GetPoints()->Begin();
+  PointsIterator end = this->m_SourceLandmarks->GetPoints()->End();
+  for (unsigned long i = 0; p1 != end; ++p1, ++i)
+  {
+    this->ComputeReflexiveG(p1, G);
+    addBlock(i, i);
+
+    const auto addPair = [this, &G, &addBlock, i](const unsigned long j, const InputVectorType & s) {
+      if (j > i)
+      {
+        this->ComputeG(s, G);
+        addBlock(i, j);
+        addBlock(j, i);
+      }
+    };
+
+    if (this->m_LandmarkGridCellSize > 0.0)
+    {
+      this->ForEachLandmarkInSupport(p1.Value(), addPair);
+    }
+    else
+    {
+      PointsIterator p2 = p1;
+      for (unsigned long j = i + 1; ++p2 != end; ++j)
+      {
+        addPair(j, p1.Value() - p2.Value());
+      }
+    }
+  }
+
+  /** The P and P^T parts: the landmark coordinates and the ones, as in ComputeP(). */
+  InputPointType p;
+  for (unsigned long i = 0; i < numberOfLandmarks; ++i)
+  {
+    this->m_SourceLandmarks->GetPoint(i, &p);
+    for (unsigned int a = 0; a < NDimensions; ++a)
+    {
+      const unsigned long row = i * NDimensions + a;
+      for (unsigned int j = 0; j < NDimensions; ++j)
+      {
+        if (p[j] != 0.0)
+        {
+          this->m_SparseLMatrix(row, kSize + j * NDimensions + a) = p[j];
+          this->m_SparseLMatrix(kSize + j * NDimensions + a, row) = p[j];
+        }
+      }
+      this->m_SparseLMatrix(row, kSize + NDimensions * NDimensions + a) = 1.0;
+      this->m_SparseLMatrix(kSize + NDimensions * NDimensions + a, row) = 1.0;
+    }
+  }
+
+} // end ComputeSparseL()
+
+
+/**
+ * ******************* ComputeLandmarkGrid *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+KernelTransform2<TScalarType, NDimensions>::ComputeLandmarkGrid()
+{
+  this->m_LandmarkGridCellStart.clear();
+  this->m_LandmarkGridIndices.clear();
+  this->m_LandmarkGridPoints.clear();
+  this->m_LandmarkGridCellSize = 0.0;
+
+  const double        radius = this->GetKernelSupportRadius();
+  const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
+  if (radius <= 0.0 || numberOfLandmarks == 0)
+  {
+    return;
+  }
+
+  /** The bounding box of the landmarks. */
+  const PointsContainer & points = *this->m_SourceLandmarks->GetPoints();
+  InputPointType          minimum = points.ElementAt(0);
+  InputPointType          maximum = minimum;
+  for (unsigned long lnd = 1; lnd < numberOfLandmarks; ++lnd)
+  {
+    const InputPointType & point = points.ElementAt(lnd);
+    for (unsigned int d = 0; d < NDimensions; ++d)
+    {
+      minimum[d] = std::min(minimum[d], point[d]);
+      maximum[d] = std::max(maximum[d], point[d]);
+    }
+  }
+
+  /** The cells are at least as large as the support, so that only the
+   * neighbouring cells have to be visited. They are enlarged when needed to keep
+   * the number of cells in the order of the number of landmarks.
+   */
+  double        cellSize = radius;
+  unsigned long numberOfCells = 1;
+  for (;;)
+  {
+    double cells = 1.0;
+    for (unsigned int d = 0; d < NDimensions; ++d)
+    {
+      cells *= std::floor((maximum[d] - minimum[d]) / cellSize) + 1.0;
+    }
+    if (cells <= 8.0 * numberOfLandmarks + 1.0)
+    {
+      numberOfCells = static_cast<unsigned long>(cells);
+      break;
+    }
+    cellSize *= 2.0;
+  }
+  for (unsigned int d = 0; d < NDimensions; ++d)
+  {
+    this->m_LandmarkGridSize[d] = static_cast<long>(std::floor((maximum[d] - minimum[d]) / cellSize)) + 1;
+  }
+  this->m_LandmarkGridOrigin = minimum;
+  this->m_LandmarkGridCellSize = cellSize;
+
+  /** Sort the landmarks into the cells (counting sort). */
+  std::vector<unsigned long> cellOfLandmark(numberOfLandmarks);
+  this->m_LandmarkGridCellStart.assign(numberOfCells + 1, 0);
+  for (unsigned long lnd = 0; lnd < numberOfLandmarks; ++lnd)
+  {
+    const InputPointType & point = points.ElementAt(lnd);
+    unsigned long          cell = 0;
+    unsigned long          stride = 1;
+    for (unsigned int d = 0; d < NDimensions; ++d)
+    {
+      const long index = static_cast<long>(std::floor((point[d] - minimum[d]) / cellSize));
+      cell += std::min(index, this->m_LandmarkGridSize[d] - 1) * stride;
+      stride *= this->m_LandmarkGridSize[d];
+    }
+    cellOfLandmark[lnd] = cell;
+    ++this->m_LandmarkGridCellStart[cell + 1];
+  }
+  for (unsigned long cell = 0; cell < numberOfCells; ++cell)
+  {
+    this->m_LandmarkGridCellStart[cell + 1] += this->m_LandmarkGridCellStart[cell];
+  }
+
+  std::vector<unsigned long> next(this->m_LandmarkGridCellStart.begin(), this->m_LandmarkGridCellStart.end() - 1);
+  this->m_LandmarkGridIndices.resize(numberOfLandmarks);
+  this->m_LandmarkGridPoints.resize(numberOfLandmarks);
+  for (unsigned long lnd = 0; lnd < numberOfLandmarks; ++lnd)
+  {
+    const unsigned long k = next[cellOfLandmark[lnd]]++;
+    this->m_LandmarkGridIndices[k] = lnd;
+    this->m_LandmarkGridPoints[k] = points.ElementAt(lnd);
+  }
+
+} // end ComputeLandmarkGrid()
+
+
+/**
+ * ******************* ForEachLandmarkInSupport *******************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+template <class TFunction>
+void
+KernelTransform2<TScalarType, NDimensions>::ForEachLandmarkInSupport(const InputPointType & point,
+                                                                     TFunction &&           function) const
+{
+  const double radius = this->GetKernelSupportRadius();
+  const double squaredRadius = radius * radius;
+
+  /** The range of cells that can contain landmarks within the support. */
+  long first[NDimensions];
+  long last[NDimensions];
+  for (unsigned int d = 0; d < NDimensions; ++d)
+  {
+    const double index = std::floor((point[d] - this->m_LandmarkGridOrigin[d]) / this->m_LandmarkGridCellSize);
+    if (index < -1.0 || index > static_cast<double>(this->m_LandmarkGridSize[d]))
+    {
+      return;
+    }
+    first[d] = std::max(static_cast<long>(index) - 1, 0L);
+    last[d] = std::min(static_cast<long>(index) + 1, this->m_LandmarkGridSize[d] - 1);
+  }
+
+  /** Visit these cells. */
+  long index[NDimensions];
+  std::copy(first, first + NDimensions, index);
+  for (;;)
+  {
+    unsigned long cell = 0;
+    unsigned long stride = 1;
+    for (unsigned int d = 0; d < NDimensions; ++d)
+    {
+      cell += index[d] * stride;
+      stride *= this->m_LandmarkGridSize[d];
+    }
+
+    for (unsigned long k = this->m_LandmarkGridCellStart[cell]; k < this->m_LandmarkGridCellStart[cell + 1]; ++k)
+    {
+      const InputVectorType x = point - this->m_LandmarkGridPoints[k];
+      if (x.GetSquaredNorm() < squaredRadius)
+      {
+        function(this->m_LandmarkGridIndices[k], x);
+      }
+    }
+
+    /** Go to the next cell. */
+    unsigned int d = 0;
+    for (; d < NDimensions; ++d)
+    {
+      if (index[d] < last[d])
+      {
+        ++index[d];
+        break;
+      }
+      index[d] = first[d];
+    }
+    if (d == NDimensions)
+    {
+      break;
+    }
+  }
+
+} // end ForEachLandmarkInSupport()
+
+
 /**
  * ******************* ComputeP *******************
  */
@@ -651,7 +989,15 @@ KernelTransform2<TScalarType, NDimensions>::SetFixedParameters(const ParametersT
   this->m_LMatrixDecompositionComputed = false;
 
   // you must recompute L and Linv - this does not require the targ lms
-  this->ComputeLInverse();
+  // With the sparse LU decomposition, Linv is only computed on request.
+  if (this->m_MatrixInversionMethod != "SparseLU")
+  {
+    this->ComputeLInverse();
+  }
+  else
+  {
+    this->m_LMatrixInverse.clear();
+  }
 
 } // end SetFixedParameters()
 
@@ -733,6 +1079,12 @@ KernelTransform2<TScalarType, NDimensions>::GetJacobian(const InputPointType &
                                                         JacobianType &               jac,
                                                         NonZeroJacobianIndicesType & nonZeroJacobianIndices) const
 {
+  /** The inverse is invalidated when the source landmarks or the kernel settings change. */
+  if (!this->m_LInverseComputed)
+  {
+    itkExceptionMacro(<< "The inverse of the L matrix is not up to date. Call ComputeLInverse() first.");
+  }
+
   const unsigned long numberOfLandmarks = this->m_SourceLandmarks->GetNumberOfPoints();
   jac.SetSize(NDimensions, numberOfLandmarks * NDimensions);
   jac.Fill(0.0);
@@ -911,6 +1263,9 @@ KernelTransform2<TScalarType, NDimensions>::PrintSelf(std::ostream & os, Indent
   os << indent << "LMatrixComputed: " << this->m_LMatrixComputed << std::endl;
   os << indent << "LInverseComputed: " << this->m_LInverseComputed << std::endl;
   os << indent << "LMatrixDecompositionComputed: " << this->m_LMatrixDecompositionComputed << std::endl;
+  os << indent << "SparseLMatrix: " << this->m_SparseLMatrix.rows() << " x " << this->m_SparseLMatrix.cols()
+     << std::endl;
+  os << indent << "LandmarkGridCellSize: " << this->m_LandmarkGridCellSize << std::endl;
 
 } // end PrintSelf()
 
@@ -0,0 +1,156 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkWendlandSplineKernelTransform2_h
+#define itkWendlandSplineKernelTransform2_h
+
+#include "itkKernelTransform2.h"
+
+namespace itk
+{
+/** \class WendlandSplineKernelTransform2
+ * This class defines a spline transformation with a compactly supported kernel:
+ * the Wendland function \f$ \phi_{3,1} \f$, which is positive definite in up to
+ * three dimensions.
+ *
+ * The kernel is zero beyond the SupportRadius, so that each landmark only
+ * influences its neighbourhood. Together with the "SparseLU" matrix inversion
+ * method, this makes the transform scale to many thousands of landmarks: the
+ * L matrix is sparse, and a point is transformed by visiting only the landmarks
+ * within the support radius.
+ *
+ * The support radius should be chosen such that each landmark has a few
+ * neighbours within its support; a too small radius results in a transform that
+ * is an affine transform plus local bumps around the landmarks.
+ *
+ * Reference: H. Wendland, "Piecewise polynomial, positive definite and compactly
+ * supported radial functions of minimal degree", Advances in Computational
+ * Mathematics 4, 1995.
+ *
+ * \ingroup Transforms
+ */
+template <class TScalarType, // Data type for scalars (float or double)
+          unsigned int NDimensions = 3>
+// Number of dimensions
+class ITK_TEMPLATE_EXPORT WendlandSplineKernelTransform2 : public KernelTransform2<TScalarType, NDimensions>
+{
+public:
+  /** Standard class typedefs. */
+  using Self = WendlandSplineKernelTransform2;
+  using Superclass = KernelTransform2<TScalarType, NDimensions>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+
+  /** New macro for creation of through a Smart Pointer */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(WendlandSplineKernelTransform2, KernelTransform2);
+
+  /** Scalar type. */
+  using typename Superclass::ScalarType;
+
+  /** Parameters type. */
+  using typename Superclass::ParametersType;
+
+  /** Jacobian Type */
+  using typename Superclass::JacobianType;
+
+  /** Dimension of the domain space. */
+  itkStaticConstMacro(SpaceDimension, unsigned int, Superclass::SpaceDimension);
+
+  /** These (rather redundant) typedefs are needed because on SGI, typedefs
+   * are not inherited */
+  using typename Superclass::InputPointType;
+  using typename Superclass::OutputPointType;
+  using typename Superclass::InputVectorType;
+  using typename Superclass::OutputVectorType;
+  using typename Superclass::InputCovariantVectorType;
+  using typename Superclass::OutputCovariantVectorType;
+  using typename Superclass::PointsIterator;
+
+  /** Set the radius beyond which the kernel is zero. Default: 1.0. */
+  virtual void
+  SetSupportRadius(TScalarType radius)
+  {
+    if (this->m_SupportRadius != radius)
+    {
+      this->m_SupportRadius = radius;
+      this->m_LMatrixComputed = false;
+      this->m_LInverseComputed = false;
+      this->m_WMatrixComputed = false;
+      this->Modified();
+    }
+  }
+  itkGetConstMacro(SupportRadius, TScalarType);
+
+  /** The radius beyond which the kernel is zero. */
+  TScalarType
+  GetKernelSupportRadius() const override
+  {
+    return this->m_SupportRadius;
+  }
+
+protected:
+  WendlandSplineKernelTransform2() { this->m_FastComputationPossible = true; }
+  ~WendlandSplineKernelTransform2() override = default;
+
+  /** These (rather redundant) typedefs are needed because on SGI, typedefs
+   * are not inherited. */
+  using typename Superclass::GMatrixType;
+
+  /** Compute G(x)
+   * For the Wendland spline, this is:
+   * \f[ G(x) = (1 - r/R)_+^4 (4 r/R + 1) I \f]
+   * where r is the Euclidean norm of x, R the support radius,
+   * and I the identity matrix. */
+  void
+  ComputeG(const InputVectorType & x, GMatrixType & GMatrix) const override;
+
+  /** Compute the reflexive G, i.e. G(0) plus the stiffness. Unlike the
+   * thin plate spline kernels, the Wendland kernel is nonzero at zero. */
+  void
+  ComputeReflexiveG(PointsIterator, GMatrixType & GMatrix) const override;
+
+  /** Compute the contribution of the landmarks weighted by the kernel funcion
+      to the global deformation of the space  */
+  void
+  ComputeDeformationContribution(const InputPointType & inputPoint, OutputPointType & result) const override;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  WendlandSplineKernelTransform2(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  /** Evaluate the Wendland function at distance r. */
+  TScalarType
+  EvaluateKernel(const TScalarType r) const;
+
+  TScalarType m_SupportRadius{ 1.0 };
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkWendlandSplineKernelTransform2.hxx"
+#endif
+
+#endif // itkWendlandSplineKernelTransform2_h
@@ -0,0 +1,101 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkWendlandSplineKernelTransform2_hxx
+#define itkWendlandSplineKernelTransform2_hxx
+
+#include "itkWendlandSplineKernelTransform2.h"
+
+namespace itk
+{
+
+template <class TScalarType, unsigned int NDimensions>
+TScalarType
+WendlandSplineKernelTransform2<TScalarType, NDimensions>::EvaluateKernel(const TScalarType r) const
+{
+  const TScalarType q = r / this->m_SupportRadius;
+  if (q >= 1.0)
+  {
+    return NumericTraits<TScalarType>::ZeroValue();
+  }
+  const TScalarType oneMinusQ = 1.0 - q;
+  const TScalarType oneMinusQ2 = oneMinusQ * oneMinusQ;
+  return oneMinusQ2 * oneMinusQ2 * (4.0 * q + 1.0);
+
+} // end EvaluateKernel()
+
+
+template <class TScalarType, unsigned int NDimensions>
+void
+WendlandSplineKernelTransform2<TScalarType, NDimensions>::ComputeG(const InputVectorType & x,
+                                                                   GMatrixType &           GMatrix) const
+{
+  GMatrix.fill(NumericTraits<TScalarType>::ZeroValue());
+  GMatrix.fill_diagonal(this->EvaluateKernel(x.GetNorm()));
+
+} // end ComputeG()
+
+
+template <class TScalarType, unsigned int NDimensions>
+void
+WendlandSplineKernelTransform2<TScalarType, NDimensions>::ComputeReflexiveG(PointsIterator,
+                                                                            GMatrixType & GMatrix) const
+{
+  GMatrix.fill(NumericTraits<TScalarType>::ZeroValue());
+  GMatrix.fill_diagonal(1.0 + this->m_Stiffness);
+
+} // end ComputeReflexiveG()
+
+
+template <class TScalarType, unsigned int NDimensions>
+void
+WendlandSplineKernelTransform2<TScalarType, NDimensions>::ComputeDeformationContribution(
+  const InputPointType & thisPoint,
+  OutputPointType &      opp) const
+{
+  /** The grid is only absent when the support radius is not positive. */
+  if (this->m_LandmarkGridCellSize <= 0.0)
+  {
+    this->Superclass::ComputeDeformationContribution(thisPoint, opp);
+    return;
+  }
+
+  this->ForEachLandmarkInSupport(thisPoint, [this, &opp](const unsigned long lnd, const InputVectorType & x) {
+    const TScalarType phi = this->EvaluateKernel(x.GetNorm());
+    for (unsigned int odim = 0; odim < NDimensions; ++odim)
+    {
+      opp[odim] += phi * this->m_DMatrix(odim, lnd);
+    }
+  });
+
+} // end ComputeDeformationContribution()
+
+
+template <class TScalarType, unsigned int NDimensions>
+void
+WendlandSplineKernelTransform2<TScalarType, NDimensions>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "SupportRadius: " << this->m_SupportRadius << std::endl;
+
+} // end PrintSelf()
+
+
+} // namespace itk
+
+#endif
@@ -64,6 +64,27 @@ namespace elastix
  *    you may want this.
  *    example: <tt>(Scales 1.0 1.0 10.0) </tt> \n
  *    Default: 1 for each parameter. See also AutomaticScalesEstimation, which is more convenient.
+ * \parameter PrecomputeSubTransforms: if "true", the displacements of the subtransforms are
+ *    computed once per resolution, on a grid that covers the fixed image. During the optimization,
+ *    the transform then only has to interpolate and weight these stored displacements, instead of
+ *    evaluating all subtransforms at each sample. This speeds up registrations with many subtransforms,
+ *    at the cost of memory: NrOfSubTransforms x Dimension floats per grid node.\n
+ *    example: <tt>(PrecomputeSubTransforms "false" "true") </tt> \n
+ *    Default: "false" for each resolution.
+ * \parameter PrecomputeSubTransformsGridSpacing: the spacing of the grid on which the
+ *    subtransforms are precomputed, in fixed image voxels, for each dimension. The displacements
+ *    are stored in single precision and interpolated linearly between the grid nodes, so the
+ *    precomputed transform is an approximation, also at the nodes. A larger spacing needs less
+ *    memory, but gives a coarser approximation, in particular at samples between the nodes, such as
+ *    those of a random coordinate sampler.\n
+ *    example: <tt>(PrecomputeSubTransformsGridSpacing 2 2 1) </tt> \n
+ *    Default: the fixed image pyramid schedule of the current resolution, but at least 1. For
+ *    smoothing pyramids, which do not downsample, this is coarser than the sample spacing.
+ * \parameter PrecomputeSubTransformsMaximumMemory: the maximum memory, in megabytes, of the
+ *    precomputed displacements. If the grid needs more, its spacing is increased in all dimensions,
+ *    and a warning is printed.\n
+ *    example: <tt>(PrecomputeSubTransformsMaximumMemory 4096) </tt> \n
+ *    Default: 1024.
  *
  * The transform parameters necessary for transformix, additionally defined by this class, are:
  * \transformparameter NormalizeCombinationWeights: use the normalized expression
@@ -160,6 +181,17 @@ public:
   void
   BeforeRegistration() override;
 
+  /** Execute stuff before each resolution:
+   * \li Precompute the subtransform displacements, if desired. */
+  void
+  BeforeEachResolution() override;
+
+  /** Execute stuff after each resolution:
+   * \li Free the precomputed subtransform displacements, so that the
+   * final transform evaluates the subtransforms themselves. */
+  void
+  AfterEachResolution() override;
+
   /** Set the scales
    * \li If AutomaticScalesEstimation is "true" estimate scales
    * \li If scales are provided by the user use those,
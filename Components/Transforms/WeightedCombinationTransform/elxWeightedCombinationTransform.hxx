@@ -20,6 +20,10 @@
 #define elxWeightedCombinationTransform_hxx
 
 #include "elxWeightedCombinationTransform.h"
+#include "itkTimeProbe.h"
+
+#include <algorithm> // For max.
+#include <cmath>
 
 namespace elastix
 {
@@ -58,6 +62,134 @@ WeightedCombinationTransformElastix<TElastix>::BeforeRegistration()
 } // end BeforeRegistration
 
 
+/*
+ * ******************* BeforeEachResolution ***********************
+ */
+
+template <class TElastix>
+void
+WeightedCombinationTransformElastix<TElastix>::BeforeEachResolution()
+{
+  /** What is the current resolution level? */
+  const unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
+
+  /** Check if the subtransform displacements should be precomputed. */
+  bool precomputeSubTransforms = false;
+  this->m_Configuration->ReadParameter(precomputeSubTransforms, "PrecomputeSubTransforms", level, false);
+  if (!precomputeSubTransforms)
+  {
+    this->m_WeightedCombinationTransform->ClearPrecomputedSubTransformDisplacements();
+    return;
+  }
+
+  /** Read the grid spacing, in fixed image voxels. By default, the grid is as coarse as
+   * the fixed image at the current resolution, according to the pyramid schedule. Note
+   * that smoothing pyramids do not downsample: their samples are still taken at every
+   * fixed image voxel, so this default grid is then coarser than the sample spacing.
+   */
+  using GridImageType = typename WeightedCombinationTransformType::GridImageType;
+  using SpacingType = typename GridImageType::SpacingType;
+  using RegionType = typename GridImageType::RegionType;
+  using SizeType = typename GridImageType::SizeType;
+
+  const FixedImageType * fixedImage = this->GetElastix()->GetFixedImage();
+  const RegionType &     fixedRegion = fixedImage->GetLargestPossibleRegion();
+  const auto &           fixedSchedule =
+    this->m_Registration->GetAsITKBaseType()->GetFixedImagePyramid()->GetSchedule();
+
+  SpacingType gridSpacingInVoxels;
+  for (unsigned int dim = 0; dim < SpaceDimension; ++dim)
+  {
+    gridSpacingInVoxels[dim] = 1.0;
+    if (level < fixedSchedule.rows() && dim < fixedSchedule.cols())
+    {
+      gridSpacingInVoxels[dim] = std::max(1.0, static_cast<double>(fixedSchedule[level][dim]));
+    }
+    this->m_Configuration->ReadParameter(
+      gridSpacingInVoxels[dim], "PrecomputeSubTransformsGridSpacing", this->GetComponentLabel(), dim, 0, false);
+    if (gridSpacingInVoxels[dim] <= 0.0)
+    {
+      itkExceptionMacro(<< "ERROR: PrecomputeSubTransformsGridSpacing should be larger than 0.");
+    }
+  }
+
+  /** The grid starts at the first fixed image voxel and covers the whole fixed image. */
+  const auto computeGridSize = [&fixedRegion, &gridSpacingInVoxels] {
+    SizeType gridSize;
+    for (unsigned int dim = 0; dim < SpaceDimension; ++dim)
+    {
+      const double extentInVoxels = static_cast<double>(fixedRegion.GetSize(dim) - 1);
+      gridSize[dim] = static_cast<itk::SizeValueType>(std::ceil(extentInVoxels / gridSpacingInVoxels[dim] - 1e-6)) + 1;
+    }
+    return gridSize;
+  };
+  SizeType gridSize = computeGridSize();
+
+  /** Check the memory of the precomputed displacements, and coarsen the grid if it is too large. */
+  double maximumMemoryInMegaBytes = 1024.0;
+  this->m_Configuration->ReadParameter(
+    maximumMemoryInMegaBytes, "PrecomputeSubTransformsMaximumMemory", this->GetComponentLabel(), 0, 0, false);
+  const double bytesPerNode = static_cast<double>(this->GetNumberOfParameters() * SpaceDimension) *
+                              sizeof(typename WeightedCombinationTransformType::GridPrecisionType);
+  const double requiredMemoryInMegaBytes =
+    static_cast<double>(RegionType(gridSize).GetNumberOfPixels()) * bytesPerNode / (1024.0 * 1024.0);
+  if (requiredMemoryInMegaBytes > maximumMemoryInMegaBytes)
+  {
+    const double coarseningFactor =
+      std::pow(requiredMemoryInMegaBytes / maximumMemoryInMegaBytes, 1.0 / static_cast<double>(SpaceDimension));
+    for (unsigned int dim = 0; dim < SpaceDimension; ++dim)
+    {
+      gridSpacingInVoxels[dim] *= coarseningFactor;
+    }
+    gridSize = computeGridSize();
+
+    xl::xout["warning"] << "WARNING: The precomputed subtransforms would need " << requiredMemoryInMegaBytes
+                        << " MB, more than PrecomputeSubTransformsMaximumMemory (" << maximumMemoryInMegaBytes
+                        << " MB).\n  The grid spacing is increased to " << gridSpacingInVoxels << " voxels."
+                        << std::endl;
+  }
+
+  typename GridImageType::PointType gridOrigin;
+  fixedImage->TransformIndexToPhysicalPoint(fixedRegion.GetIndex(), gridOrigin);
+
+  SpacingType gridSpacing;
+  for (unsigned int dim = 0; dim < SpaceDimension; ++dim)
+  {
+    gridSpacing[dim] = fixedImage->GetSpacing()[dim] * gridSpacingInVoxels[dim];
+  }
+
+  const auto grid = GridImageType::New();
+  grid->SetOrigin(gridOrigin);
+  grid->SetSpacing(gridSpacing);
+  grid->SetDirection(fixedImage->GetDirection());
+  grid->SetRegions(gridSize);
+
+  elxout << "Precomputing the displacements of " << this->GetNumberOfParameters()
+         << " subtransforms on a grid of size " << gridSize << " ..." << std::endl;
+
+  itk::TimeProbe timer;
+  timer.Start();
+  this->m_WeightedCombinationTransform->PrecomputeSubTransformDisplacements(grid);
+  timer.Stop();
+
+  elxout << "Precomputing the subtransforms took " << Conversion::SecondsToDHMS(timer.GetMean(), 2) << std::endl;
+
+} // end BeforeEachResolution()
+
+
+/*
+ * ******************* AfterEachResolution ***********************
+ */
+
+template <class TElastix>
+void
+WeightedCombinationTransformElastix<TElastix>::AfterEachResolution()
+{
+  this->m_WeightedCombinationTransform->ClearPrecomputedSubTransformDisplacements();
+
+} // end AfterEachResolution()
+
+
 /**
  * ************************* InitializeTransform *********************
  * Initialize transform to prepare it for registration.
@@ -19,6 +19,9 @@
 #define itkWeightedCombinationTransform_h
 
 #include "itkAdvancedTransform.h"
+#include "itkImageBase.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -35,6 +38,17 @@ namespace itk
  * the transformation is as follows:
  * \f[T(x) = \sum_i w_i T_i(x) / \sum_i w_i\f]
  *
+ * Both expressions can be written in terms of the displacements
+ * \f$d_i(x) = T_i(x) - x\f$ of the sub-transforms. When the sub-transforms
+ * remain fixed during a registration, and only the weights are optimized,
+ * these displacements may be precomputed on a grid, by
+ * PrecomputeSubTransformDisplacements(). Inside that grid, TransformPoint()
+ * and GetJacobian() then interpolate the stored displacements linearly,
+ * instead of calling TransformPoint() of each sub-transform. The displacements
+ * are stored as GridPrecisionType, so the result approximates that of the
+ * sub-transforms, also at the grid nodes, and more coarsely between them.
+ * Outside the grid, the sub-transforms are still evaluated.
+ *
  * \ingroup Transforms
  *
  */
@@ -84,6 +98,11 @@ public:
   using TransformPointer = typename TransformType::Pointer;
   using TransformContainerType = std::vector<TransformPointer>;
 
+  /** Typedefs for the grid on which the sub-transform displacements are precomputed. */
+  using GridImageType = ImageBase<NInputDimensions>;
+  using GridImagePointer = typename GridImageType::Pointer;
+  using GridPrecisionType = float;
+
   /**  Method to transform a point. */
   OutputPointType
   TransformPoint(const InputPointType & ipp) const override;
@@ -162,6 +181,7 @@ public:
   SetTransformContainer(const TransformContainerType & transformContainer)
   {
     this->m_TransformContainer = transformContainer;
+    this->ClearPrecomputedSubTransformDisplacements();
     this->Modified();
   }
 
@@ -182,6 +202,30 @@ public:
   }
 
 
+  /** Evaluate the displacement of each sub-transform at the nodes of the
+   * given grid, which is defined by the origin, spacing, direction and
+   * largest possible region of the grid image. The image does not need to be
+   * allocated. The evaluation is multi-threaded. The displacements are stored
+   * in single precision, in (number of grid nodes) x (number of sub-transforms)
+   * x OutputSpaceDimension floats.
+   * Should be called again whenever one of the sub-transforms is modified;
+   * SetTransformContainer() clears the precomputed displacements.
+   * Passing a null pointer clears the precomputed displacements as well. */
+  virtual void
+  PrecomputeSubTransformDisplacements(const GridImageType * grid);
+
+  /** Free the precomputed displacements, so that the sub-transforms are evaluated again. */
+  virtual void
+  ClearPrecomputedSubTransformDisplacements();
+
+  /** Returns true if the sub-transform displacements are precomputed. */
+  bool
+  GetHasPrecomputedSubTransformDisplacements() const
+  {
+    return this->m_PrecomputedGrid.IsNotNull();
+  }
+
+
   /** Must be provided. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override
@@ -250,7 +294,25 @@ private:
   void
   operator=(const Self &) = delete;
 
+  /** The number of grid nodes that surround a point. */
+  static constexpr unsigned int NumberOfSurroundingNodes = 1U << NInputDimensions;
+
+  using NodeOffsetArrayType = FixedArray<SizeValueType, NumberOfSurroundingNodes>;
+  using NodeWeightArrayType = FixedArray<double, NumberOfSurroundingNodes>;
+
+  /** Computes the offsets (in grid nodes) and the linear interpolation weights
+   * of the grid nodes that surround the given point. Returns false if the
+   * point is outside the grid. */
+  bool
+  ComputeSurroundingNodes(const InputPointType & ipp,
+                          NodeOffsetArrayType &  offsets,
+                          NodeWeightArrayType &  weights) const;
+
   bool m_NormalizeWeights;
+
+  /** The grid and the sub-transform displacements at its nodes. */
+  GridImagePointer               m_PrecomputedGrid;
+  std::vector<GridPrecisionType> m_PrecomputedDisplacements;
 };
 
 } // end namespace itk
@@ -19,6 +19,10 @@
 #define _itkWeightedCombinationTransform_hxx
 
 #include "itkWeightedCombinationTransform.h"
+#include "itkImageRegionConstIteratorWithOnlyIndex.h"
+#include "itkMultiThreaderBase.h"
+
+#include <cmath>
 
 namespace itk
 {
@@ -93,6 +97,38 @@ WeightedCombinationTransform<TScalarType, NInputDimensions, NOutputDimensions>::
   const unsigned int             N = tc.size();
   const ParametersType &         param = this->m_Parameters;
 
+  /** Use the precomputed displacements, if available:
+   * T(x) = x + \sum_i w_i d_i(x) [ / \sum_i w_i ] */
+  NodeOffsetArrayType offsets;
+  NodeWeightArrayType weights;
+  if (this->ComputeSurroundingNodes(ipp, offsets, weights))
+  {
+    const double scale = this->m_NormalizeWeights ? 1.0 / this->m_SumOfWeights : 1.0;
+    for (unsigned int d = 0; d < OutputSpaceDimension; ++d)
+    {
+      opp[d] = ipp[d];
+    }
+    for (unsigned int c = 0; c < NumberOfSurroundingNodes; ++c)
+    {
+      if (weights[c] == 0.0)
+      {
+        continue;
+      }
+      const GridPrecisionType * displacement =
+        this->m_PrecomputedDisplacements.data() + offsets[c] * N * OutputSpaceDimension;
+      for (unsigned int i = 0; i < N; ++i)
+      {
+        const double w = weights[c] * param[i] * scale;
+        for (unsigned int d = 0; d < OutputSpaceDimension; ++d)
+        {
+          opp[d] += w * (*displacement);
+          ++displacement;
+        }
+      }
+    }
+    return opp;
+  }
+
   /** Calculate sum_i w_i T_i(x) */
   for (unsigned int i = 0; i < N; ++i)
   {
@@ -146,6 +182,52 @@ WeightedCombinationTransform<TScalarType, NInputDimensions, NOutputDimensions>::
   /** This transform has only nonzero jacobians. */
   nzji = this->m_NonZeroJacobianIndices;
 
+  /** Use the precomputed displacements, if available. */
+  NodeOffsetArrayType offsets;
+  NodeWeightArrayType weights;
+  if (this->ComputeSurroundingNodes(ipp, offsets, weights))
+  {
+    /** Interpolate d_i(x) = T_i(x) - x. */
+    jac.Fill(0.0);
+    for (unsigned int c = 0; c < NumberOfSurroundingNodes; ++c)
+    {
+      if (weights[c] == 0.0)
+      {
+        continue;
+      }
+      const GridPrecisionType * displacement =
+        this->m_PrecomputedDisplacements.data() + offsets[c] * N * OutputSpaceDimension;
+      for (unsigned int i = 0; i < N; ++i)
+      {
+        for (unsigned int d = 0; d < OutputSpaceDimension; ++d)
+        {
+          jac(d, i) += weights[c] * (*displacement);
+          ++displacement;
+        }
+      }
+    }
+
+    if (this->m_NormalizeWeights)
+    {
+      /** dT/dmu_i = ( T_i(x) - T(x) ) / ( \sum_i w_i ) = ( d_i(x) - d(x) ) / ( \sum_i w_i ),
+       * with d(x) = \sum_i w_i d_i(x) / \sum_i w_i. */
+      for (unsigned int d = 0; d < OutputSpaceDimension; ++d)
+      {
+        double meanDisplacement = 0.0;
+        for (unsigned int i = 0; i < N; ++i)
+        {
+          meanDisplacement += param[i] * jac(d, i);
+        }
+        meanDisplacement /= this->m_SumOfWeights;
+        for (unsigned int i = 0; i < N; ++i)
+        {
+          jac(d, i) = (jac(d, i) - meanDisplacement) / this->m_SumOfWeights;
+        }
+      }
+    }
+    return;
+  }
+
   if (this->m_NormalizeWeights)
   {
     /** dT/dmu_i = ( T_i(x) - T(x) ) / ( \sum_i w_i ) */
@@ -189,6 +271,153 @@ WeightedCombinationTransform<TScalarType, NInputDimensions, NOutputDimensions>::
 } // end GetJacobian()
 
 
+/**
+ * ********************* PrecomputeSubTransformDisplacements ****************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+WeightedCombinationTransform<TScalarType, NInputDimensions, NOutputDimensions>::PrecomputeSubTransformDisplacements(
+  const GridImageType * grid)
+{
+  this->ClearPrecomputedSubTransformDisplacements();
+  if (grid == nullptr)
+  {
+    return;
+  }
+
+  /** Copy the geometry of the grid. */
+  using RegionType = typename GridImageType::RegionType;
+  const RegionType region = grid->GetLargestPossibleRegion();
+  const auto       precomputedGrid = GridImageType::New();
+  precomputedGrid->SetOrigin(grid->GetOrigin());
+  precomputedGrid->SetSpacing(grid->GetSpacing());
+  precomputedGrid->SetDirection(grid->GetDirection());
+  precomputedGrid->SetRegions(region);
+
+  const TransformContainerType & tc = this->m_TransformContainer;
+  const unsigned int             N = tc.size();
+  const std::size_t              nodeSize = static_cast<std::size_t>(N) * OutputSpaceDimension;
+  std::vector<GridPrecisionType> displacements(region.GetNumberOfPixels() * nodeSize);
+
+  /** Evaluate d_i(x) = T_i(x) - x at each grid node, in parallel. */
+  MultiThreaderBase::New()->ParallelizeImageRegion<NInputDimensions>(
+    region,
+    [&precomputedGrid, &tc, &displacements, N, nodeSize](const RegionType & threadRegion) {
+      InputPointType                                       point;
+      ImageRegionConstIteratorWithOnlyIndex<GridImageType> it(precomputedGrid, threadRegion);
+      for (; !it.IsAtEnd(); ++it)
+      {
+        const auto index = it.GetIndex();
+        precomputedGrid->TransformIndexToPhysicalPoint(index, point);
+        const auto          offset = static_cast<std::size_t>(precomputedGrid->ComputeOffset(index));
+        GridPrecisionType * displacement = displacements.data() + offset * nodeSize;
+        for (unsigned int i = 0; i < N; ++i)
+        {
+          const OutputPointType opp = tc[i]->TransformPoint(point);
+          for (unsigned int d = 0; d < OutputSpaceDimension; ++d)
+          {
+            *displacement = static_cast<GridPrecisionType>(opp[d] - point[d]);
+            ++displacement;
+          }
+        }
+      }
+    },
+    nullptr);
+
+  this->m_PrecomputedGrid = precomputedGrid;
+  this->m_PrecomputedDisplacements.swap(displacements);
+
+} // end PrecomputeSubTransformDisplacements()
+
+
+/**
+ * ********************* ClearPrecomputedSubTransformDisplacements ****************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+WeightedCombinationTransform<TScalarType, NInputDimensions, NOutputDimensions>::
+  ClearPrecomputedSubTransformDisplacements()
+{
+  this->m_PrecomputedGrid = nullptr;
+  std::vector<GridPrecisionType>().swap(this->m_PrecomputedDisplacements);
+
+} // end ClearPrecomputedSubTransformDisplacements()
+
+
+/**
+ * ********************* ComputeSurroundingNodes ****************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+bool
+WeightedCombinationTransform<TScalarType, NInputDimensions, NOutputDimensions>::ComputeSurroundingNodes(
+  const InputPointType & ipp,
+  NodeOffsetArrayType &  offsets,
+  NodeWeightArrayType &  weights) const
+{
+  const GridImageType * grid = this->m_PrecomputedGrid.GetPointer();
+  if (grid == nullptr)
+  {
+    return false;
+  }
+
+  ContinuousIndex<double, NInputDimensions> cindex;
+  grid->TransformPhysicalPointToContinuousIndex(ipp, cindex);
+
+  const auto &            region = grid->GetLargestPossibleRegion();
+  const OffsetValueType * offsetTable = grid->GetOffsetTable();
+
+  /** Find the first surrounding node, the step to the next node and the
+   * interpolation fraction, in each dimension. */
+  SizeValueType baseOffset = 0;
+  SizeValueType step[NInputDimensions];
+  double        fraction[NInputDimensions];
+  for (unsigned int d = 0; d < NInputDimensions; ++d)
+  {
+    const double        x = cindex[d] - static_cast<double>(region.GetIndex(d));
+    const SizeValueType size = region.GetSize(d);
+    if (!(x >= 0.0 && x <= static_cast<double>(size - 1)))
+    {
+      return false;
+    }
+    SizeValueType i0 = static_cast<SizeValueType>(std::floor(x));
+    if (i0 + 1 >= size && i0 > 0)
+    {
+      --i0;
+    }
+    const auto stride = static_cast<SizeValueType>(offsetTable[d]);
+    baseOffset += i0 * stride;
+    step[d] = (size > 1) ? stride : 0;
+    fraction[d] = x - static_cast<double>(i0);
+  }
+
+  /** Compute the offsets and the weights of all surrounding nodes. */
+  for (unsigned int c = 0; c < NumberOfSurroundingNodes; ++c)
+  {
+    SizeValueType offset = baseOffset;
+    double        weight = 1.0;
+    for (unsigned int d = 0; d < NInputDimensions; ++d)
+    {
+      if ((c >> d) & 1U)
+      {
+        offset += step[d];
+        weight *= fraction[d];
+      }
+      else
+      {
+        weight *= 1.0 - fraction[d];
+      }
+    }
+    offsets[c] = offset;
+    weights[c] = weight;
+  }
+  return true;
+
+} // end ComputeSurroundingNodes()
+
+
 } // end namespace itk
 
 #endif
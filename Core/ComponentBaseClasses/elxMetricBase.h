@@ -23,6 +23,7 @@
 
 #include "elxBaseComponentSE.h"
 #include "itkAdvancedImageToImageMetric.h"
+#include "itkSingleValuedPointSetToPointSetMetric.h"
 #include "itkImageGridSampler.h"
 #include "itkPointSet.h"
 
@@ -63,6 +64,13 @@ namespace elastix
  *    CheckNumberOfSamples. \n
  *    example: <tt>(RequiredRatioOfValidSamples 0.1)</tt> \n
  *    The default is 0.25.
+ * \parameter DeterministicNumberOfWorkUnits: When larger than 0, the multi-threaded
+ *    metric splits its samples in this fixed number of blocks, which the threads process
+ *    in turns, and sums their results pairwise in a fixed order, so that the results are
+ *    bit-identical for any number of threads or cores. Each block has its own derivative buffer, which costs memory for
+ *    transforms with many parameters. Can be given for each resolution or for all resolutions at once. \n
+ *    example: <tt>(DeterministicNumberOfWorkUnits 32)</tt> \n
+ *    The default is 0, i.e. the number of blocks equals the number of threads.
  *
  * \ingroup Metrics
  * \ingroup ComponentBaseClasses
@@ -119,6 +127,7 @@ public:
                                                                         CoordinateRepresentationType,
                                                                         CoordinateRepresentationType,
                                                                         CoordinateRepresentationType>>;
+  using PointSetMetricType = itk::SingleValuedPointSetToPointSetMetric<FixedPointSetType, MovingPointSetType>;
 
   /** Typedefs for sampler support. */
   using ImageSamplerBaseType = typename AdvancedMetricType::ImageSamplerType;
@@ -168,8 +168,35 @@ MetricBase<TElastix>::BeforeEachResolutionBase()
       }
     }
 
+    /** Should the metric results be independent of the number of threads? */
+    unsigned int deterministicNumberOfWorkUnits = 0;
+    this->GetConfiguration()->ReadParameter(
+      deterministicNumberOfWorkUnits, "DeterministicNumberOfWorkUnits", this->GetComponentLabel(), level, 0);
+    thisAsAdvanced->SetDeterministicNumberOfWorkUnits(deterministicNumberOfWorkUnits);
+
   } // end advanced metric
 
+  /** Point set metrics may also use multi-threading. */
+  PointSetMetricType * thisAsPointSetMetric = dynamic_cast<PointSetMetricType *>(this);
+  if (thisAsPointSetMetric != nullptr)
+  {
+    bool useMultiThreading = true;
+    this->GetConfiguration()->ReadParameter(
+      useMultiThreading, "UseMultiThreadingForMetrics", this->GetComponentLabel(), level, 0);
+
+    thisAsPointSetMetric->SetUseMultiThread(useMultiThreading);
+    if (useMultiThreading)
+    {
+      std::string tmp = this->m_Configuration->GetCommandLineArgument("-threads");
+      if (!tmp.empty())
+      {
+        const unsigned int nrOfThreads = atoi(tmp.c_str());
+        thisAsPointSetMetric->SetNumberOfWorkUnits(nrOfThreads);
+      }
+    }
+
+  } // end point set metric
+
 } // end BeforeEachResolutionBase()
 
 
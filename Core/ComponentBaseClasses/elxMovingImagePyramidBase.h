@@ -27,6 +27,8 @@
 
 #include "itkMultiResolutionPyramidImageFilter.h"
 
+#include <vector>
+
 namespace elastix
 {
 
@@ -48,6 +50,23 @@ namespace elastix
  *    example: <tt>(ImagePyramidSchedule  4 4 2 2 1 1)</tt> \n
  *    Used as a default when MovingImagePyramidSchedule is not specified. If both are omitted,
  *    a default schedule is assumed: isotropic, halved in each resolution, so, like in the example.
+ * \parameter ComputePyramidImagesPerResolution: Flag to specify if the pyramid images are computed
+ *    per resolution, just before they are needed, or all at once. The former saves memory, since the
+ *    images of the other resolutions are released.\n
+ *    example: <tt>(ComputePyramidImagesPerResolution "false")</tt>\n
+ *    Default "true". Pyramids that cannot compute their images per resolution, like the recursive
+ *    pyramids, ignore this option.
+ * \parameter MaximumPyramidMemory: The maximum amount of memory, in megabytes, that the images of
+ *    a pyramid may occupy. If computing all resolutions at once would exceed it, the images are
+ *    computed per resolution, even if ComputePyramidImagesPerResolution is "false".\n
+ *    example: <tt>(MaximumPyramidMemory 2048)</tt>\n
+ *    Default 0, which means no limit.
+ * \parameter ComputePyramidImagesInBackground: Flag to specify if the pyramid images of the next
+ *    resolution are computed in a background thread, while the current resolution is being optimized.
+ *    Only used when the images are computed per resolution, and only if the images of two subsequent
+ *    resolutions fit in the MaximumPyramidMemory.\n
+ *    example: <tt>(ComputePyramidImagesInBackground "true")</tt>\n
+ *    Default "false".
  * \parameter WritePyramidImagesAfterEachResolution: ...\n
  *    example: <tt>(WritePyramidImagesAfterEachResolution "true")</tt>\n
  *    default "false".
@@ -104,6 +123,8 @@ public:
   BeforeRegistrationBase() override;
 
   /** Execute stuff before each resolution:
+   * \li Compute the pyramid images of this resolution, if they are computed per resolution.
+   * \li Start computing those of the next resolution in the background, if desired.
    * \li Write the pyramid image to file.
    */
   void
@@ -118,6 +139,37 @@ public:
   WritePyramidImage(const std::string &  filename,
                     const unsigned int & level); // const;
 
+  /** Estimate the memory, in megabytes, occupied by the pyramid image of each level. */
+  virtual std::vector<double>
+  EstimatePyramidMemory();
+
+  /** Returns true if the pyramid can compute its images per resolution.
+   * Pyramids that can, override this method and the ones below. */
+  virtual bool
+  SupportsComputePerResolution() const
+  {
+    return false;
+  }
+
+
+  /** Compute only the images of the current resolution, or all at once. */
+  virtual void
+  SetComputePerResolution(const bool)
+  {}
+
+
+  /** Set the current resolution. */
+  virtual void
+  SetCurrentResolution(const unsigned int)
+  {}
+
+
+  /** Start computing the images of the given resolution in the background. */
+  virtual void
+  PrecomputeResolutionInBackground(const unsigned int)
+  {}
+
+
 protected:
   /** The constructor. */
   MovingImagePyramidBase() = default;
@@ -127,6 +179,14 @@ protected:
 private:
   elxDeclarePureVirtualGetSelfMacro(ITKBaseType);
 
+  /** Decide, based on the memory budget, whether the pyramid images are
+   * computed per resolution, and whether this is done in the background. */
+  void
+  SetComputationSchedule();
+
+  bool m_ComputePerResolution{ false };
+  bool m_ComputeNextResolutionInBackground{ false };
+
   /** The deleted copy constructor. */
   MovingImagePyramidBase(const Self &) = delete;
   /** The deleted assignment operator. */
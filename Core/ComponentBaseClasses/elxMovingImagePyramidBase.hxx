@@ -22,6 +22,9 @@
 #include "elxMovingImagePyramidBase.h"
 #include "itkImageFileCastWriter.h"
 
+#include <algorithm> // For min.
+#include <numeric>   // For accumulate.
+
 namespace elastix
 {
 
@@ -36,6 +39,9 @@ MovingImagePyramidBase<TElastix>::BeforeRegistrationBase()
   /** Call SetMovingSchedule.*/
   this->SetMovingSchedule();
 
+  /** Decide how the pyramid images are computed. */
+  this->SetComputationSchedule();
+
 } // end BeforeRegistrationBase()
 
 
@@ -50,6 +56,18 @@ MovingImagePyramidBase<TElastix>::BeforeEachResolutionBase()
   /** What is the current resolution level? */
   const unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
 
+  /** Compute the pyramid images of this resolution, and release the others. */
+  if (this->m_ComputePerResolution)
+  {
+    this->SetCurrentResolution(level);
+    this->GetAsITKBaseType()->UpdateLargestPossibleRegion();
+
+    if (this->m_ComputeNextResolutionInBackground && level + 1 < this->GetAsITKBaseType()->GetNumberOfLevels())
+    {
+      this->PrecomputeResolutionInBackground(level + 1);
+    }
+  }
+
   /** Decide whether or not to write the pyramid images this resolution. */
   bool writePyramidImage = false;
   this->m_Configuration->ReadParameter(writePyramidImage, "WritePyramidImagesAfterEachResolution", "", level, 0, false);
@@ -147,6 +165,111 @@ MovingImagePyramidBase<TElastix>::SetMovingSchedule()
 } // end SetMovingSchedule()
 
 
+/**
+ * ******************* SetComputationSchedule ********************
+ */
+
+template <class TElastix>
+void
+MovingImagePyramidBase<TElastix>::SetComputationSchedule()
+{
+  /** Read the options. The memory budget is in megabytes; 0 means no limit. */
+  bool computePerResolution = true;
+  this->m_Configuration->ReadParameter(computePerResolution, "ComputePyramidImagesPerResolution", 0, false);
+  double maximumPyramidMemory = 0.0;
+  this->m_Configuration->ReadParameter(maximumPyramidMemory, "MaximumPyramidMemory", 0, false);
+  bool computeInBackground = false;
+  this->m_Configuration->ReadParameter(computeInBackground, "ComputePyramidImagesInBackground", 0, false);
+
+  const std::vector<double> levelMemory = this->EstimatePyramidMemory();
+  const double              totalMemory = std::accumulate(levelMemory.begin(), levelMemory.end(), 0.0);
+  const bool                exceedsBudget = maximumPyramidMemory > 0.0 && totalMemory > maximumPyramidMemory;
+
+  /** Compute per resolution when requested, or when all resolutions do not fit in the budget. */
+  this->m_ComputePerResolution = (computePerResolution || exceedsBudget) && this->SupportsComputePerResolution();
+  if (this->SupportsComputePerResolution())
+  {
+    this->SetComputePerResolution(this->m_ComputePerResolution);
+  }
+  else if (exceedsBudget)
+  {
+    xl::xout["warning"] << "WARNING: The moving image pyramid needs " << totalMemory
+                        << " MB, which exceeds the MaximumPyramidMemory, but it cannot compute its images per "
+                           "resolution.\n  Consider using the MovingGenericImagePyramid."
+                        << std::endl;
+  }
+
+  /** Computing in the background requires the images of two subsequent resolutions at the same time. */
+  bool fitsInBudget = true;
+  for (std::size_t level = 0; level + 1 < levelMemory.size(); ++level)
+  {
+    fitsInBudget &= maximumPyramidMemory <= 0.0 || levelMemory[level] + levelMemory[level + 1] <= maximumPyramidMemory;
+  }
+  this->m_ComputeNextResolutionInBackground = computeInBackground && this->m_ComputePerResolution && fitsInBudget;
+  if (computeInBackground && this->m_ComputePerResolution && !fitsInBudget)
+  {
+    xl::xout["warning"] << "WARNING: The moving pyramid images of two subsequent resolutions do not fit in the "
+                           "MaximumPyramidMemory.\n  They are not computed in the background."
+                        << std::endl;
+  }
+
+  if (this->m_ComputePerResolution)
+  {
+    elxout << "The moving image pyramid computes its images per resolution ("
+           << (this->m_ComputeNextResolutionInBackground ? "in the background, " : "") << totalMemory
+           << " MB for all resolutions)." << std::endl;
+  }
+
+} // end SetComputationSchedule()
+
+
+/**
+ * ******************* EstimatePyramidMemory ********************
+ */
+
+template <class TElastix>
+std::vector<double>
+MovingImagePyramidBase<TElastix>::EstimatePyramidMemory()
+{
+  ITKBaseType * pyramid = this->GetAsITKBaseType();
+
+  /** The input of the pyramid is only set by the registration. So, find the
+   * moving image that belongs to this pyramid, and temporarily set it as the
+   * input, to let the pyramid compute the size of its output images. */
+  const auto         pyramidContainer = this->GetElastix()->GetMovingImagePyramidContainer();
+  const unsigned int numberOfImages = this->GetElastix()->GetNumberOfMovingImages();
+  unsigned int       index = 0;
+  for (unsigned int i = 0; i < this->GetElastix()->GetNumberOfMovingImagePyramids(); ++i)
+  {
+    if (pyramidContainer->ElementAt(i).GetPointer() == static_cast<const itk::Object *>(pyramid))
+    {
+      index = i;
+    }
+  }
+
+  std::vector<double> levelMemory(pyramid->GetNumberOfLevels(), 0.0);
+  if (numberOfImages == 0)
+  {
+    return levelMemory;
+  }
+
+  const typename InputImageType::ConstPointer input = pyramid->GetInput();
+  pyramid->SetInput(this->GetElastix()->GetMovingImage(std::min(index, numberOfImages - 1)));
+  pyramid->UpdateOutputInformation();
+
+  using PixelType = typename OutputImageType::PixelType;
+  for (unsigned int level = 0; level < levelMemory.size(); ++level)
+  {
+    const auto numberOfPixels = pyramid->GetOutput(level)->GetLargestPossibleRegion().GetNumberOfPixels();
+    levelMemory[level] = static_cast<double>(numberOfPixels) * sizeof(PixelType) / (1024.0 * 1024.0);
+  }
+
+  pyramid->SetInput(input);
+  return levelMemory;
+
+} // end EstimatePyramidMemory()
+
+
 /*
  * ******************* WritePyramidImage ********************
  */
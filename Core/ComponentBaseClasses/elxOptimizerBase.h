@@ -24,6 +24,7 @@
 
 #include "elxBaseComponentSE.h"
 #include "itkOptimizer.h"
+#include "itkParameterMapInterface.h"
 
 namespace elastix
 {
@@ -70,6 +71,9 @@ public:
   /** Typedef needed for the SetCurrentPositionPublic function. */
   using ParametersType = typename ITKBaseType::ParametersType;
 
+  /** Typedef for the checkpoints of the registration. */
+  using ParameterMapType = itk::ParameterMapInterface::ParameterMapType;
+
   /** Retrieves this object as ITKBaseType. */
   ITKBaseType *
   GetAsITKBaseType()
@@ -102,6 +106,22 @@ public:
   void
   AfterRegistrationBase() override;
 
+  /** Add the state of the optimizer to a checkpoint of the registration. The
+   * transform parameters are already stored by the ElastixTemplate.
+   * The default implementation adds nothing.
+   */
+  virtual void
+  AddStateToCheckpoint(ParameterMapType & checkpoint) const;
+
+  /** Restore the state that was added by AddStateToCheckpoint(). Called
+   * before the optimization of the resumed resolution starts. Returns true
+   * if the optimizer continues after the iteration of the checkpoint. The
+   * default implementation returns false: the resolution is then restarted
+   * from the transform parameters of the checkpoint.
+   */
+  virtual bool
+  RestoreStateFromCheckpoint(const itk::ParameterMapInterface & checkpoint);
+
   /** Method that sets the scales defined by a sinus
    * scale[i] = amplitude^( sin(i/nrofparam*2pi*frequency) )
    */
@@ -124,6 +144,21 @@ protected:
   virtual bool
   GetNewSamplesEveryIteration() const;
 
+  /** Read UseConvergenceCheck, ConvergenceWindowSize and ConvergenceTolerance of the current
+   * resolution, pass them to the optimizer, and add the "5:Convergence" column to the iteration
+   * info if the check is used. For optimizers derived from itk::GradientDescentOptimizer2.
+   */
+  template <class TOptimizer>
+  void
+  BeforeEachResolutionConvergenceCheck(TOptimizer & optimizer);
+
+  /** Print the convergence value of the optimizer in the "5:Convergence" column, and mark the
+   * iteration at which the check stopped the resolution.
+   */
+  template <class TOptimizer>
+  void
+  AfterEachIterationConvergenceCheck(const TOptimizer & optimizer);
+
 private:
   elxDeclarePureVirtualGetSelfMacro(ITKBaseType);
 
@@ -23,6 +23,9 @@
 #include "itkSingleValuedNonLinearOptimizer.h"
 #include "itk_zlib.h"
 
+#include <cmath> // For isnan.
+#include <iomanip>
+
 namespace elastix
 {
 
@@ -76,6 +79,74 @@ OptimizerBase<TElastix>::BeforeEachResolutionBase()
 } // end BeforeEachResolutionBase()
 
 
+/**
+ * ****************** BeforeEachResolutionConvergenceCheck **********************
+ */
+
+template <class TElastix>
+template <class TOptimizer>
+void
+OptimizerBase<TElastix>::BeforeEachResolutionConvergenceCheck(TOptimizer & optimizer)
+{
+  /** Get the current resolution level. */
+  const unsigned int level = this->GetRegistration()->GetAsITKBaseType()->GetCurrentLevel();
+
+  bool useConvergenceCheck = false;
+  this->GetConfiguration()->ReadParameter(
+    useConvergenceCheck, "UseConvergenceCheck", this->GetComponentLabel(), level, 0);
+  optimizer.SetUseConvergenceCheck(useConvergenceCheck);
+
+  itk::SizeValueType convergenceWindowSize = 100;
+  this->GetConfiguration()->ReadParameter(
+    convergenceWindowSize, "ConvergenceWindowSize", this->GetComponentLabel(), level, 0);
+  optimizer.SetConvergenceWindowSize(convergenceWindowSize);
+
+  double convergenceTolerance = 0.0;
+  this->GetConfiguration()->ReadParameter(
+    convergenceTolerance, "ConvergenceTolerance", this->GetComponentLabel(), level, 0);
+  optimizer.SetConvergenceTolerance(convergenceTolerance);
+
+  this->RemoveTargetCellFromIterationInfo("5:Convergence");
+  if (useConvergenceCheck)
+  {
+    this->AddTargetCellToIterationInfo("5:Convergence");
+    this->GetIterationInfoAt("5:Convergence") << std::showpoint << std::fixed;
+  }
+
+} // end BeforeEachResolutionConvergenceCheck()
+
+
+/**
+ * ****************** AfterEachIterationConvergenceCheck **********************
+ */
+
+template <class TElastix>
+template <class TOptimizer>
+void
+OptimizerBase<TElastix>::AfterEachIterationConvergenceCheck(const TOptimizer & optimizer)
+{
+  if (!optimizer.GetUseConvergenceCheck())
+  {
+    return;
+  }
+
+  const double convergenceValue = optimizer.GetConvergenceValue();
+  if (std::isnan(convergenceValue))
+  {
+    this->GetIterationInfoAt("5:Convergence") << "---";
+  }
+  else
+  {
+    this->GetIterationInfoAt("5:Convergence") << convergenceValue;
+    if (convergenceValue < optimizer.GetConvergenceTolerance())
+    {
+      this->GetIterationInfoAt("5:Convergence") << " (converged)";
+    }
+  }
+
+} // end AfterEachIterationConvergenceCheck()
+
+
 /**
  * ****************** AfterRegistrationBase **********************
  */
@@ -105,6 +176,33 @@ OptimizerBase<TElastix>::AfterRegistrationBase()
 } // end AfterRegistrationBase()
 
 
+/**
+ * ****************** AddStateToCheckpoint ****************************
+ */
+
+template <class TElastix>
+void
+OptimizerBase<TElastix>::AddStateToCheckpoint(ParameterMapType & /** checkpoint */) const
+{
+  /** Do nothing by default. */
+
+} // end AddStateToCheckpoint()
+
+
+/**
+ * ****************** RestoreStateFromCheckpoint ****************************
+ */
+
+template <class TElastix>
+bool
+OptimizerBase<TElastix>::RestoreStateFromCheckpoint(const itk::ParameterMapInterface & /** checkpoint */)
+{
+  /** By default, the resolution is restarted. */
+  return false;
+
+} // end RestoreStateFromCheckpoint()
+
+
 /**
  * ****************** SelectNewSamples ****************************
  */
@@ -25,6 +25,8 @@
 #include "itkResampleImageFilter.h"
 #include "elxProgressCommand.h"
 
+#include <utility> // For move.
+
 namespace elastix
 {
 /**
@@ -67,6 +69,20 @@ namespace elastix
  *    of the written image is desired.\n
  *    example: <tt>(CompressResultImage "true")</tt> \n
  *    The default is "false".
+ * \parameter CollapseTransformChain: parameter to collapse a chain of composed transforms
+ *    (e.g. from initial transform parameter files) into an equivalent, cheaper transform before
+ *    resampling. Consecutive affine/rigid transforms are multiplied into a single one.\n
+ *    example: <tt>(CollapseTransformChain "true")</tt> \n
+ *    The default is "false".
+ * \parameter CollapsedTransformChainBakeDeformableTransforms: when the chain is collapsed and it
+ *    contains deformable transforms, bake the entire chain into a single displacement field.
+ *    The mean and maximum approximation error are reported in the log.\n
+ *    example: <tt>(CollapsedTransformChainBakeDeformableTransforms "true")</tt> \n
+ *    The default is "false".
+ * \parameter CollapsedTransformChainFieldSpacing: the spacing of the displacement field into which
+ *    the chain is baked, for each dimension.\n
+ *    example: <tt>(CollapsedTransformChainFieldSpacing 2.0 2.0 2.0)</tt> \n
+ *    The default is the spacing of the output image.
  *
  * \ingroup Resamplers
  * \ingroup ComponentBaseClasses
@@ -202,6 +218,42 @@ protected:
   virtual void
   SetComponents();
 
+  /** Method that replaces the transform of the resampler by a collapsed version of the
+   * transform chain, when requested by the CollapseTransformChain parameter.
+   * Returns the original transform when it is replaced (so that it can be restored
+   * afterwards), and nullptr otherwise.
+   */
+  itk::SmartPointer<const TransformType>
+  CollapseTransformChain();
+
+  /** Restores the original transform of the resampler, as returned by CollapseTransformChain(), when it goes out of
+   * scope, so that the collapsed transform does not remain installed when resampling or writing throws an exception.
+   */
+  class OriginalTransformRestorer
+  {
+  public:
+    OriginalTransformRestorer(ITKBaseType & resampler, itk::SmartPointer<const TransformType> originalTransform)
+      : m_Resampler(resampler)
+      , m_OriginalTransform(std::move(originalTransform))
+    {}
+
+    ~OriginalTransformRestorer()
+    {
+      if (m_OriginalTransform != nullptr)
+      {
+        m_Resampler.SetTransform(m_OriginalTransform);
+      }
+    }
+
+    OriginalTransformRestorer(const OriginalTransformRestorer &) = delete;
+    OriginalTransformRestorer &
+    operator=(const OriginalTransformRestorer &) = delete;
+
+  private:
+    ITKBaseType &                                m_Resampler;
+    const itk::SmartPointer<const TransformType> m_OriginalTransform;
+  };
+
   /** Variable that defines to print the progress or not. */
   bool m_ShowProgress;
 
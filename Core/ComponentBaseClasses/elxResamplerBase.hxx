@@ -24,6 +24,7 @@
 #include "itkImageFileCastWriter.h"
 #include "itkChangeInformationImageFilter.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
+#include "itkCombinationTransformCollapser.h"
 #include "itkTimeProbe.h"
 
 namespace elastix
@@ -288,6 +289,79 @@ ResamplerBase<TElastix>::SetComponents()
 } // end SetComponents()
 
 
+/**
+ * ******************* CollapseTransformChain ********************
+ */
+
+template <class TElastix>
+auto
+ResamplerBase<TElastix>::CollapseTransformChain() -> itk::SmartPointer<const TransformType>
+{
+  const itk::SmartPointer<const TransformType> originalTransform = this->GetAsITKBaseType()->GetTransform();
+
+  bool collapseTransformChain = false;
+  this->m_Configuration->ReadParameter(collapseTransformChain, "CollapseTransformChain", 0, false);
+
+  /** The RayCastResampleInterpolator uses its own transform, so there is nothing to collapse. */
+  const auto rayCastInterpolator =
+    dynamic_cast<itk::AdvancedRayCastInterpolateImageFunction<InputImageType, CoordRepType> *>(
+      this->GetAsITKBaseType()->GetInterpolator());
+  if (!collapseTransformChain || originalTransform.IsNull() || rayCastInterpolator != nullptr)
+  {
+    return nullptr;
+  }
+
+  using CollapserType = itk::CombinationTransformCollapser<CoordRepType, ImageDimension>;
+  const auto collapser = CollapserType::New();
+  collapser->SetTransform(originalTransform);
+
+  bool bakeDeformableTransforms = false;
+  this->m_Configuration->ReadParameter(
+    bakeDeformableTransforms, "CollapsedTransformChainBakeDeformableTransforms", 0, false);
+  collapser->SetBakeDeformableTransforms(bakeDeformableTransforms);
+
+  /** The displacement field covers the output image, possibly with a different spacing. */
+  const ITKBaseType &                resampler = *(this->GetAsITKBaseType());
+  const SpacingType                  outputSpacing = resampler.GetOutputSpacing();
+  SpacingType                        fieldSpacing = outputSpacing;
+  typename CollapserType::SizeType   fieldSize;
+  typename CollapserType::OriginType fieldOrigin = resampler.GetOutputOrigin();
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    this->m_Configuration->ReadParameter(fieldSpacing[i], "CollapsedTransformChainFieldSpacing", i, false);
+    const double extent = (resampler.GetSize()[i] - 1) * outputSpacing[i];
+    fieldSize[i] = static_cast<itk::SizeValueType>(std::ceil(extent / fieldSpacing[i] - 1e-6)) + 1;
+  }
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    for (unsigned int j = 0; j < ImageDimension; ++j)
+    {
+      fieldOrigin[i] += resampler.GetOutputDirection()(i, j) * resampler.GetOutputStartIndex()[j] * outputSpacing[j];
+    }
+  }
+  collapser->SetOutputOrigin(fieldOrigin);
+  collapser->SetOutputSpacing(fieldSpacing);
+  collapser->SetOutputDirection(resampler.GetOutputDirection());
+  collapser->SetOutputSize(fieldSize);
+
+  itk::TimeProbe timer;
+  timer.Start();
+  collapser->Update();
+  timer.Stop();
+
+  elxout << "  Collapsed the transform chain from " << collapser->GetNumberOfTransformsBefore() << " to "
+         << collapser->GetNumberOfTransformsAfter() << " transform(s)"
+         << (collapser->GetIsBaked() ? ", baked into a displacement field" : "") << ", in "
+         << Conversion::SecondsToDHMS(timer.GetMean(), 2) << ".\n"
+         << "  Approximation error: mean " << collapser->GetMeanError() << ", maximum "
+         << collapser->GetMaximumError() << std::endl;
+
+  this->GetAsITKBaseType()->SetTransform(collapser->GetModifiableCollapsedTransform());
+  return originalTransform;
+
+} // end CollapseTransformChain()
+
+
 /**
  * ******************* ResampleAndWriteResultImage ********************
  */
@@ -299,6 +373,9 @@ ResamplerBase<TElastix>::ResampleAndWriteResultImage(const char * filename, cons
   /** Make sure the resampler is updated. */
   this->GetAsITKBaseType()->Modified();
 
+  /** Possibly use a collapsed version of the transform chain, until the end of this function. */
+  const OriginalTransformRestorer originalTransformRestorer(*this->GetAsITKBaseType(), this->CollapseTransformChain());
+
   /** Add a progress observer to the resampler. */
   const auto progressObserver = BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::New();
   if (showProgress && (progressObserver != nullptr))
@@ -433,6 +510,9 @@ ResamplerBase<TElastix>::CreateItkResultImage()
   /** Make sure the resampler is updated. */
   this->GetAsITKBaseType()->Modified();
 
+  /** Possibly use a collapsed version of the transform chain, until the end of this function. */
+  const OriginalTransformRestorer originalTransformRestorer(*this->GetAsITKBaseType(), this->CollapseTransformChain());
+
   const auto progressObserver =
     BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::CreateAndConnect(*(this->GetAsITKBaseType()));
 
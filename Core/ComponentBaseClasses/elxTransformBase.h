@@ -53,6 +53,11 @@ namespace elastix
  *   "Compose" by composition: \f$T(x) = T_1 ( T_0(x) )\f$.\n
  *   example: <tt>(HowToCombineTransforms "Add")</tt>\n
  *   Default: "Add".
+ * \parameter WriteBinaryOutputMesh: Write the points transformed by transformix from a
+ *   .vtk input file (see -def) in binary instead of ASCII format, which is much faster
+ *   and smaller for large meshes.\n
+ *   example: <tt>(WriteBinaryOutputMesh "true")</tt>\n
+ *   Default: "false".
  *
  * \transformparameter UseDirectionCosines: Controls whether to use or ignore the
  * direction cosines (world matrix, transform matrix) set in the images.
@@ -39,9 +39,10 @@
 #include "itkMesh.h"
 #include "itkMeshFileReader.h"
 #include "itkMeshFileWriter.h"
-#include "itkTransformMeshFilter.h"
+#include "itkMultiThreaderBase.h"
 #include "itkCommonEnums.h"
 
+#include <algorithm> // For min.
 #include <cassert>
 #include <fstream>
 #include <iomanip> // For setprecision.
@@ -897,7 +898,6 @@ TransformBase<TElastix>::TransformPointsSomePointsVTK(const std::string & filena
   using MeshType = itk::Mesh<DummyIPPPixelType, FixedImageDimension, MeshTraitsType>;
   using MeshReaderType = itk::MeshFileReader<MeshType>;
   using MeshWriterType = itk::MeshFileWriter<MeshType>;
-  using TransformMeshFilterType = itk::TransformMeshFilter<MeshType, MeshType, CombinationTransformType>;
 
   /** Read the input points. */
   const auto meshReader = MeshReaderType::New();
@@ -918,19 +918,39 @@ TransformBase<TElastix>::TransformPointsSomePointsVTK(const std::string & filena
   unsigned long nrofpoints = meshReader->GetOutput()->GetNumberOfPoints();
   elxout << "  Number of specified input points: " << nrofpoints << std::endl;
 
-  /** Apply the transform. */
+  /** Apply the transform. The points are transformed in place, in parallel
+   * chunks, so that the mesh is not duplicated in memory. The cells and
+   * point data are left untouched, as with the itk::TransformMeshFilter.
+   */
   elxout << "  The input points are transformed." << std::endl;
-  const auto meshTransformer = TransformMeshFilterType::New();
-  meshTransformer->SetTransform(const_cast<CombinationTransformType *>(this->GetAsITKBaseType()));
-  meshTransformer->SetInput(meshReader->GetOutput());
-  try
+  const auto mesh = meshReader->GetOutput();
+  const auto points = mesh->GetPoints();
+  if (points != nullptr)
   {
-    meshTransformer->Update();
-  }
-  catch (itk::ExceptionObject & err)
-  {
-    xl::xout["error"] << "  Error while transforming points." << std::endl;
-    xl::xout["error"] << err << std::endl;
+    const CombinationTransformType * transform = this->GetAsITKBaseType();
+    const itk::SizeValueType         numberOfPoints = points->Size();
+    constexpr itk::SizeValueType     chunkSize = 4096;
+    const itk::SizeValueType         numberOfChunks = (numberOfPoints + chunkSize - 1) / chunkSize;
+    try
+    {
+      itk::MultiThreaderBase::New()->ParallelizeArray(
+        0,
+        numberOfChunks,
+        [points, transform, numberOfPoints](const itk::SizeValueType chunk) {
+          const itk::SizeValueType last = std::min((chunk + 1) * chunkSize, numberOfPoints);
+          for (itk::SizeValueType i = chunk * chunkSize; i < last; ++i)
+          {
+            auto & point = points->ElementAt(i);
+            point = transform->TransformPoint(point);
+          }
+        },
+        nullptr);
+    }
+    catch (itk::ExceptionObject & err)
+    {
+      xl::xout["error"] << "  Error while transforming points." << std::endl;
+      xl::xout["error"] << err << std::endl;
+    }
   }
 
   /** Create filename and file stream. */
@@ -939,7 +959,15 @@ TransformBase<TElastix>::TransformPointsSomePointsVTK(const std::string & filena
   elxout << "  The transformed points are saved in: " << outputPointsFileName << std::endl;
   const auto meshWriter = MeshWriterType::New();
   meshWriter->SetFileName(outputPointsFileName.c_str());
-  meshWriter->SetInput(meshTransformer->GetOutput());
+  meshWriter->SetInput(mesh);
+
+  /** Optionally write the points as binary data, which avoids the ASCII conversion of large meshes. */
+  bool writeBinaryMesh = false;
+  this->m_Configuration->ReadParameter(writeBinaryMesh, "WriteBinaryOutputMesh", 0, false);
+  if (writeBinaryMesh)
+  {
+    meshWriter->SetFileTypeAsBINARY();
+  }
 
   try
   {
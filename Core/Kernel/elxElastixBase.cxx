@@ -328,6 +328,13 @@ ElastixBase::BeforeAllBase()
     elxout << "-threads  " << check << std::endl;
   }
 
+  /** Check for appearance of -resume, which resumes the registration from a checkpoint. */
+  check = this->GetConfiguration()->GetCommandLineArgument("-resume");
+  if (!check.empty())
+  {
+    elxout << "-resume   " << check << std::endl;
+  }
+
   /** Check the very important UseDirectionCosines parameter. */
   bool retudc = this->GetConfiguration()->ReadParameter(this->m_UseDirectionCosines, "UseDirectionCosines", 0);
   if (!retudc)
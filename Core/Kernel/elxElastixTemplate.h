@@ -83,6 +83,16 @@ namespace elastix
  *    example: <tt>(WriteTransformParametersEachResolution "true")</tt>\n
  *    This parameter can not be specified for each resolution separately.
  *    Default value: "false".
+ * \parameter CheckpointInterval: The number of iterations between two checkpoints
+ *    of the registration. A checkpoint stores the current resolution and iteration,
+ *    the transform parameters, the state of the optimizer and the seed of the random
+ *    generator in the file "Checkpoint.<ElastixLevel>.txt" in the output directory.
+ *    Run elastix with "-resume true" to continue from this checkpoint. The random
+ *    generator is reseeded at every checkpoint, so that a resumed registration
+ *    continues with the same random numbers.\n
+ *    example: <tt>(CheckpointInterval 500)</tt>\n
+ *    This parameter can not be specified for each resolution separately.
+ *    Default value: 0, which means that no checkpoints are written.
  * \parameter UseDirectionCosines: Controls whether to use or ignore the
  * direction cosines (world matrix, transform matrix) set in the images.
  * Voxel spacing and image origin are always taken into account, regardless
@@ -261,6 +271,14 @@ private:
   AfterEachIterationCommandPointer   m_AfterEachIterationCommand{};
   AfterEachResolutionCommandPointer  m_AfterEachResolutionCommand{};
 
+  /** The checkpoint from which the registration is resumed. Null when not resuming. */
+  itk::ParameterMapInterface::Pointer m_ResumeCheckpoint{};
+  unsigned long                       m_ResumeLevel{ 0 };
+
+  /** The number of the first iteration of the current resolution. Nonzero
+   * only when the resolution is resumed from a checkpoint. */
+  unsigned int m_FirstIteration{ 0 };
+
   /** CreateTransformParameterFile. */
   void
   CreateTransformParameterFile(const std::string & FileName, const bool ToLog);
@@ -303,6 +321,22 @@ private:
   void
   SetOriginalFixedImageDirection(const FixedImageDirectionType & arg);
 
+  /** Get the name of the checkpoint file of this elastix level. */
+  std::string
+  GetCheckpointFileName() const;
+
+  /** Write a checkpoint of the current iteration, from which the registration can be resumed. */
+  void
+  WriteCheckpoint();
+
+  /** Read the checkpoint written by an earlier run, if any, and skip the resolutions before it. */
+  void
+  ReadCheckpoint();
+
+  /** Continue the resolution of the checkpoint from its transform parameters and optimizer state. */
+  void
+  ResumeFromCheckpoint();
+
 private:
   ElastixTemplate(const Self &) = delete;
   void
@@ -20,6 +20,11 @@
 
 #  include "elxElastixTemplate.h"
 
+#  include "itkParameterFileParser.h"
+#  include <itkMersenneTwisterRandomVariateGenerator.h>
+#  include <itksys/SystemTools.hxx>
+#  include <cstdio> // For std::remove and std::rename.
+
 #  define elxCheckAndSetComponentMacro(_name)                                                                          \
     _name##BaseType * base = this->GetElx##_name##Base(i);                                                             \
     if (base != nullptr)                                                                                               \
@@ -482,6 +487,12 @@ ElastixTemplate<TFixedImage, TMovingImage>::BeforeRegistration()
   CallInEachComponent(&BaseComponentType::BeforeRegistrationBase);
   CallInEachComponent(&BaseComponentType::BeforeRegistration);
 
+  /** Continue from the checkpoint of an earlier run, if requested. */
+  if (this->GetConfiguration()->GetCommandLineArgument("-resume") == "true")
+  {
+    this->ReadCheckpoint();
+  }
+
   /** Add a column to iteration with the iteration number. */
   this->AddTargetCellToIterationInfo("1:ItNr");
 
@@ -525,23 +536,40 @@ ElastixTemplate<TFixedImage, TMovingImage>::BeforeEachResolution()
 
   /** Reset the this->m_IterationCounter. */
   this->m_IterationCounter = 0;
+  this->m_FirstIteration = 0;
 
   /** Print the current resolution. */
   elxout << "\nResolution: " << level << std::endl;
 
+  /** The resolutions before the checkpoint of a resumed registration are not optimized. */
+  const bool skipResolution = level < this->GetElxRegistrationBase()->GetAsITKBaseType()->GetFirstLevel();
+  if (skipResolution)
+  {
+    elxout << "This resolution is skipped, since the registration resumes at resolution " << this->m_ResumeLevel
+           << "." << std::endl;
+  }
+
   /** Create a TransformParameter-file for the current resolution. */
   bool writeIterationInfo = true;
   this->GetConfiguration()->ReadParameter(writeIterationInfo, "WriteIterationInfo", 0, false);
-  if (writeIterationInfo)
+  if (writeIterationInfo && !skipResolution)
   {
     this->OpenIterationInfoFile();
   }
 
-  /** Call all the BeforeEachResolution() functions. */
+  /** Call all the BeforeEachResolution() functions. This is also done for
+   * skipped resolutions, so that for example a B-spline grid is refined as usual.
+   */
   this->BeforeEachResolutionBase();
   CallInEachComponent(&BaseComponentType::BeforeEachResolutionBase);
   CallInEachComponent(&BaseComponentType::BeforeEachResolution);
 
+  /** Continue the resolution of the checkpoint where it was interrupted. */
+  if (this->m_ResumeCheckpoint && level == this->m_ResumeLevel)
+  {
+    this->ResumeFromCheckpoint();
+  }
+
   /** Print the extra preparation time needed for this resolution. */
   this->m_Timer0.Stop();
   elxout << "Elastix initialization of all components (for this resolution) took: "
@@ -619,7 +647,7 @@ void
 ElastixTemplate<TFixedImage, TMovingImage>::AfterEachIteration()
 {
   /** Write the headers of the columns that are printed each iteration. */
-  if (this->m_IterationCounter == 0)
+  if (this->m_IterationCounter == this->m_FirstIteration)
   {
     this->GetIterationInfo().WriteHeaders();
   }
@@ -679,6 +707,14 @@ ElastixTemplate<TFixedImage, TMovingImage>::AfterEachIteration()
     this->CreateTransformParameterFile(tpFileName, false);
   }
 
+  /** Write a checkpoint every CheckpointInterval iterations. */
+  unsigned int checkpointInterval = 0;
+  this->GetConfiguration()->ReadParameter(checkpointInterval, "CheckpointInterval", 0, false);
+  if (checkpointInterval > 0 && (this->m_IterationCounter + 1) % checkpointInterval == 0)
+  {
+    this->WriteCheckpoint();
+  }
+
   /** Count the number of iterations. */
   this->m_IterationCounter++;
 
@@ -1039,6 +1075,172 @@ ElastixTemplate<TFixedImage, TMovingImage>::OpenIterationInfoFile()
 } // end OpenIterationInfoFile()
 
 
+/**
+ * ************** GetCheckpointFileName *********************
+ */
+
+template <class TFixedImage, class TMovingImage>
+std::string
+ElastixTemplate<TFixedImage, TMovingImage>::GetCheckpointFileName() const
+{
+  std::ostringstream makeFileName("");
+  makeFileName << this->GetConfiguration()->GetCommandLineArgument("-out") << "Checkpoint."
+               << this->GetConfiguration()->GetElastixLevel() << ".txt";
+  return makeFileName.str();
+
+} // end GetCheckpointFileName()
+
+
+/**
+ * ************** WriteCheckpoint *********************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ElastixTemplate<TFixedImage, TMovingImage>::WriteCheckpoint()
+{
+  using RandomGeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+
+  /** Reseed the random generator with a seed drawn from it, so that its
+   * state at this checkpoint is given by a single number.
+   */
+  const RandomGeneratorType::Pointer     randomGenerator = RandomGeneratorType::GetInstance();
+  const RandomGeneratorType::IntegerType randomSeed = randomGenerator->GetIntegerVariate();
+  randomGenerator->SetSeed(randomSeed);
+
+  /** The optimizer adds its own state to the position in the registration. */
+  const unsigned long level = this->GetElxRegistrationBase()->GetAsITKBaseType()->GetCurrentLevel();
+  ParameterMapType    checkpoint{
+    { "CheckpointResolution", { Conversion::ToString(level) } },
+    { "CheckpointIteration", { Conversion::ToString(this->m_IterationCounter) } },
+    { "RandomSeed", { Conversion::ToString(randomSeed) } },
+    { "TransformParameters",
+      Conversion::ToVectorOfStrings(this->GetElxOptimizerBase()->GetAsITKBaseType()->GetCurrentPosition()) }
+  };
+  this->GetElxOptimizerBase()->AddStateToCheckpoint(checkpoint);
+
+  /** Write to a temporary file first, so that the previous checkpoint
+   * survives an interruption while writing.
+   */
+  const std::string fileName = this->GetCheckpointFileName();
+  const std::string temporaryFileName = fileName + ".tmp";
+  {
+    std::ofstream checkpointFile(temporaryFileName.c_str());
+    checkpointFile << "// Checkpoint of the registration, resume with \"-resume true\"\n\n"
+                   << Conversion::ParameterMapToString(checkpoint);
+    checkpointFile.close();
+    if (checkpointFile.fail())
+    {
+      xl::xout["error"] << "ERROR: File \"" << temporaryFileName << "\" could not be written!" << std::endl;
+      return;
+    }
+  }
+
+  /** Not every platform lets std::rename replace an existing file. */
+  if (std::rename(temporaryFileName.c_str(), fileName.c_str()) != 0)
+  {
+    std::remove(fileName.c_str());
+    if (std::rename(temporaryFileName.c_str(), fileName.c_str()) != 0)
+    {
+      xl::xout["error"] << "ERROR: File \"" << fileName << "\" could not be written!" << std::endl;
+    }
+  }
+
+} // end WriteCheckpoint()
+
+
+/**
+ * ************** ReadCheckpoint *********************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ElastixTemplate<TFixedImage, TMovingImage>::ReadCheckpoint()
+{
+  const std::string fileName = this->GetCheckpointFileName();
+  if (!itksys::SystemTools::FileExists(fileName))
+  {
+    elxout << "No checkpoint \"" << fileName << "\" found, so the registration starts from the beginning."
+           << std::endl;
+    return;
+  }
+
+  this->m_ResumeCheckpoint = itk::ParameterMapInterface::New();
+  this->m_ResumeCheckpoint->SetParameterMap(itk::ParameterFileParser::ReadParameterMap(fileName));
+
+  /** Check that the checkpoint fits in this registration. */
+  auto &     registration = *(this->GetElxRegistrationBase()->GetAsITKBaseType());
+  const auto level = this->m_ResumeCheckpoint->RetrieveValues<unsigned long>("CheckpointResolution");
+  const auto iteration = this->m_ResumeCheckpoint->RetrieveValues<unsigned int>("CheckpointIteration");
+  if (level == nullptr || level->size() != 1 || iteration == nullptr || iteration->size() != 1)
+  {
+    itkExceptionMacro(<< "ERROR: The checkpoint \"" << fileName << "\" has no valid resolution and iteration.");
+  }
+  if (level->front() >= registration.GetNumberOfLevels())
+  {
+    itkExceptionMacro(<< "ERROR: The checkpoint \"" << fileName << "\" is at resolution " << level->front()
+                      << ", but the registration has only " << registration.GetNumberOfLevels() << " resolutions.");
+  }
+
+  /** Skip the resolutions before the checkpoint. */
+  this->m_ResumeLevel = level->front();
+  registration.SetFirstLevel(this->m_ResumeLevel);
+
+  elxout << "Resuming the registration from checkpoint \"" << fileName << "\", written at resolution "
+         << this->m_ResumeLevel << ", iteration " << iteration->front() << "." << std::endl;
+
+} // end ReadCheckpoint()
+
+
+/**
+ * ************** ResumeFromCheckpoint *********************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ElastixTemplate<TFixedImage, TMovingImage>::ResumeFromCheckpoint()
+{
+  using RandomGeneratorType = itk::Statistics::MersenneTwisterRandomVariateGenerator;
+
+  const itk::ParameterMapInterface & checkpoint = *(this->m_ResumeCheckpoint);
+
+  /** Start the optimization of this resolution at the transform parameters of the checkpoint. */
+  const auto parameters = checkpoint.RetrieveValues<double>("TransformParameters");
+  const auto numberOfParameters = this->GetElxTransformBase()->GetAsITKBaseType()->GetNumberOfParameters();
+  if (parameters == nullptr || parameters->size() != numberOfParameters)
+  {
+    itkExceptionMacro(<< "ERROR: The transform parameters of the checkpoint do not match the "
+                      << numberOfParameters << " parameters of the transform.");
+  }
+  this->GetElxRegistrationBase()->GetAsITKBaseType()->SetInitialTransformParametersOfNextLevel(
+    Conversion::ToOptimizerParameters(*parameters));
+
+  /** Restore the state of the random generator. */
+  const auto randomSeed = checkpoint.RetrieveValues<RandomGeneratorType::IntegerType>("RandomSeed");
+  if (randomSeed != nullptr && randomSeed->size() == 1)
+  {
+    RandomGeneratorType::GetInstance()->SetSeed(randomSeed->front());
+  }
+
+  /** Continue after the iteration of the checkpoint, if the optimizer supports it. */
+  if (this->GetElxOptimizerBase()->RestoreStateFromCheckpoint(checkpoint))
+  {
+    this->m_FirstIteration = checkpoint.RetrieveValues<unsigned int>("CheckpointIteration")->front() + 1;
+    this->m_IterationCounter = this->m_FirstIteration;
+    elxout << "The optimization continues at iteration " << this->m_FirstIteration << "." << std::endl;
+  }
+  else
+  {
+    elxout << "The optimization of this resolution restarts from the transform parameters of the checkpoint."
+           << std::endl;
+  }
+
+  /** The checkpoint is only used once. */
+  this->m_ResumeCheckpoint = nullptr;
+
+} // end ResumeFromCheckpoint()
+
+
 /**
  * ************** GetOriginalFixedImageDirection *********************
  * Determine the original fixed image direction (it might have been
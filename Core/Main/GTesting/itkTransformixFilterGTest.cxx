@@ -39,10 +39,14 @@
 #include <itkFileTools.h>
 #include <itkImage.h>
 #include <itkImageBufferRange.h>
+#include <itkMesh.h>
+#include <itkMeshFileReader.h>
+#include <itkMeshFileWriter.h>
 #include <itkNumberToString.h>
 #include <itkResampleImageFilter.h>
 #include <itkSimilarity2DTransform.h>
 #include <itkSimilarity3DTransform.h>
+#include <itkTransformMeshFilter.h>
 #include <itkTranslationTransform.h>
 
 
@@ -889,3 +893,92 @@ GTEST_TEST(itkTransformixFilter, OutputEqualsRegistrationOutputForBSplineStackTr
     }
   }
 }
+
+
+// Tests that transformix transforms the points of a VTK file, which it does in place, in parallel chunks, like the
+// serial itk::TransformMeshFilter does, both with ASCII and with binary output.
+GTEST_TEST(itkTransformixFilter, VtkPointsEqualTransformMeshFilterOutput)
+{
+  constexpr auto ImageDimension = 3U;
+  using PixelType = float;
+  using MeshType = itk::Mesh<PixelType,
+                             ImageDimension,
+                             itk::DefaultStaticMeshTraits<PixelType, ImageDimension, ImageDimension, double>>;
+  using BSplineTransformType = itk::BSplineTransform<double, ImageDimension, 3>;
+
+  const std::string outputDirectoryPath = GetCurrentBinaryDirectoryPath() + '/' + GetNameOfTest(*this);
+  itk::FileTools::CreateDirectory(outputDirectoryPath);
+
+  const auto imageSize = itk::Size<ImageDimension>::Filled(4);
+  elx::DefaultConstructibleSubclass<BSplineTransformType> bsplineTransform;
+  bsplineTransform.SetTransformDomainPhysicalDimensions(ConvertToItkVector(imageSize));
+  bsplineTransform.SetParameters(GeneratePseudoRandomParameters(bsplineTransform.GetParameters().size(), -1.0));
+  const std::string transformFilePathName = outputDirectoryPath + "/BSplineTransform.h5";
+  elx::TransformIO::Write(bsplineTransform, transformFilePathName);
+
+  // More points than the 4096 points of a single chunk, inside the domain of the transform.
+  const auto                       inputMesh = MeshType::New();
+  std::mt19937                     randomNumberEngine;
+  std::uniform_real_distribution<> distribution(0.0, 3.0);
+  for (itk::IdentifierType pointID = 0; pointID < 10007; ++pointID)
+  {
+    MeshType::PointType point;
+    for (auto & coordinate : point)
+    {
+      coordinate = distribution(randomNumberEngine);
+    }
+    inputMesh->SetPoint(pointID, point);
+  }
+  const std::string inputFilePathName = outputDirectoryPath + "/inputpoints.vtk";
+  const auto        meshWriter = itk::MeshFileWriter<MeshType>::New();
+  meshWriter->SetInput(inputMesh);
+  meshWriter->SetFileName(inputFilePathName);
+  meshWriter->SetFileTypeAsBINARY();
+  meshWriter->Update();
+
+  // The serial reference, on the points as they are read by transformix.
+  const auto inputMeshReader = itk::MeshFileReader<MeshType>::New();
+  inputMeshReader->SetFileName(inputFilePathName);
+  const auto transformMeshFilter =
+    itk::TransformMeshFilter<MeshType, MeshType, itk::Transform<double, ImageDimension, ImageDimension>>::New();
+  transformMeshFilter->SetInput(inputMeshReader->GetOutput());
+  transformMeshFilter->SetTransform(&bsplineTransform);
+  transformMeshFilter->Update();
+  const auto & expectedPoints = Deref(Deref(transformMeshFilter->GetOutput()).GetPoints());
+
+  for (const bool writeBinaryOutputMesh : { false, true })
+  {
+    const auto transformixFilter = CheckNew<itk::TransformixFilter<itk::Image<PixelType, ImageDimension>>>();
+    transformixFilter->SetFixedPointSetFileName(inputFilePathName);
+    transformixFilter->SetOutputDirectory(outputDirectoryPath);
+    transformixFilter->SetTransformParameterObject(
+      CreateParameterObject({ // Parameters in alphabetic order:
+                              { "Direction", CreateDefaultDirectionParameterValues<ImageDimension>() },
+                              { "Index", ParameterValuesType(ImageDimension, "0") },
+                              { "Origin", ParameterValuesType(ImageDimension, "0") },
+                              { "ResampleInterpolator", { "FinalLinearInterpolator" } },
+                              { "Size", ConvertToParameterValues(imageSize) },
+                              { "Transform", ParameterValuesType{ "File" } },
+                              { "TransformFileName", { transformFilePathName } },
+                              { "Spacing", ParameterValuesType(ImageDimension, "1") },
+                              { "WriteBinaryOutputMesh", { writeBinaryOutputMesh ? "true" : "false" } } }));
+    transformixFilter->Update();
+
+    const auto outputMeshReader = itk::MeshFileReader<MeshType>::New();
+    outputMeshReader->SetFileName(outputDirectoryPath + "/outputpoints.vtk");
+    outputMeshReader->Update();
+    const auto & actualPoints = Deref(Deref(outputMeshReader->GetOutput()).GetPoints());
+
+    // Transformix evaluates the B-spline with its own implementation, and ASCII output is rounded.
+    const double tolerance = writeBinaryOutputMesh ? 1e-10 : 1e-4;
+    ASSERT_EQ(actualPoints.Size(), expectedPoints.Size());
+    for (itk::IdentifierType pointID = 0; pointID < expectedPoints.Size(); ++pointID)
+    {
+      for (unsigned int d = 0; d < ImageDimension; ++d)
+      {
+        EXPECT_NEAR(actualPoints.ElementAt(pointID)[d], expectedPoints.ElementAt(pointID)[d], tolerance)
+          << "WriteBinaryOutputMesh " << writeBinaryOutputMesh << ", point " << pointID << ", dimension " << d;
+      }
+    }
+  }
+}
@@ -65,7 +65,9 @@ constexpr const char * elastixHelpText =
   "  -t0       parameter file for initial transform\n"
   "  -priority set the process priority to high, abovenormal, normal (default),\n"
   "            belownormal, or idle (Windows only option)\n"
-  "  -threads  set the maximum number of threads of elastix\n\n"
+  "  -threads  set the maximum number of threads of elastix\n"
+  "  -resume   \"true\" to resume the registration from the checkpoint in the\n"
+  "            output directory (see the CheckpointInterval parameter)\n\n"
 
   /** The parameter file.*/
   "The parameter-file must contain all the information "
@@ -240,6 +240,7 @@ main(int argc, char * argv[])
   std::vector<InputPointType>  pointList(N);
   std::vector<OutputPointType> transformedPointList1(N);
   std::vector<OutputPointType> transformedPointList2(N);
+  std::vector<OutputPointType> transformedPointList3(N);
 
   IndexType               dummyIndex;
   CoefficientImagePointer coefficientImage = transform->GetCoefficientImages()[0];
@@ -267,6 +268,15 @@ main(int argc, char * argv[])
   }
   timeCollector.Stop("TransformPoint recursive         ");
 
+  recursiveTransform->UseInterleavedCoefficientsOn();
+  timeCollector.Start("TransformPoint recursive interl. ");
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    transformedPointList3[i] = recursiveTransform->TransformPoint(pointList[i]);
+  }
+  timeCollector.Stop("TransformPoint recursive interl. ");
+  recursiveTransform->UseInterleavedCoefficientsOff();
+
   /** Time the implementation of the Jacobian. */
   timeCollector.Start("Jacobian elastix                 ");
   for (unsigned int i = 0; i < N; ++i)
@@ -384,6 +394,18 @@ main(int argc, char * argv[])
     return EXIT_FAILURE;
   }
 
+  /** TransformPoint using the interleaved coefficients should give identical results. */
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    if (transformedPointList2[i] != transformedPointList3[i])
+    {
+      std::cerr << "ERROR: Recursive B-spline TransformPoint() with interleaved coefficients returning incorrect "
+                   "result."
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
   /** Jacobian. */
   JacobianType jacobianElastix;
   jacobianElastix.SetSize(Dimension, nzji.size());
@@ -16,14 +16,18 @@
  *
  *=========================================================================*/
 #include "SplineKernelTransform/itkThinPlateSplineKernelTransform2.h"
+#include "SplineKernelTransform/itkWendlandSplineKernelTransform2.h"
 #include "itkTransformixInputPointFileReader.h"
 
 // Report timings
 #include "itkTimeProbe.h"
 #include "itkTimeProbesCollectorBase.h"
 
+#include <algorithm> // For max.
+#include <cmath>
 #include <fstream>
 #include <iomanip>
+#include <random>
 
 #include <vnl/algo/vnl_qr.h>
 //#include <vnl/algo/vnl_sparse_lu.h>
@@ -85,6 +89,54 @@ public:
   }
 };
 
+
+// Helper class to compare the grid based evaluation of a compactly supported
+// kernel with the evaluation over all landmarks.
+template <class TScalarType, unsigned int NDimensions>
+class WendlandKernelTransformPublic : public WendlandSplineKernelTransform2<TScalarType, NDimensions>
+{
+public:
+  using Self = WendlandKernelTransformPublic;
+  using Superclass = WendlandSplineKernelTransform2<TScalarType, NDimensions>;
+  using Pointer = SmartPointer<Self>;
+  using ConstPointer = SmartPointer<const Self>;
+  itkTypeMacro(WendlandKernelTransformPublic, WendlandSplineKernelTransform2);
+  itkNewMacro(Self);
+
+  using typename Superclass::InputPointType;
+  using typename Superclass::OutputPointType;
+  using typename Superclass::GMatrixType;
+  using typename Superclass::PointsIterator;
+
+  OutputPointType
+  TransformPointBruteForce(const InputPointType & point) const
+  {
+    OutputPointType opp = point;
+    GMatrixType     Gmatrix;
+    PointsIterator  sp = this->m_SourceLandmarks->GetPoints()->Begin();
+    for (unsigned long lnd = 0; lnd < this->m_SourceLandmarks->GetNumberOfPoints(); ++lnd, ++sp)
+    {
+      this->ComputeG(point - sp->Value(), Gmatrix);
+      for (unsigned int dim = 0; dim < NDimensions; ++dim)
+      {
+        for (unsigned int odim = 0; odim < NDimensions; ++odim)
+        {
+          opp[odim] += Gmatrix(dim, odim) * this->m_DMatrix(dim, lnd);
+        }
+      }
+    }
+    for (unsigned int i = 0; i < NDimensions; ++i)
+    {
+      for (unsigned int j = 0; j < NDimensions; ++j)
+      {
+        opp[i] += this->m_AMatrix(i, j) * point[j];
+      }
+      opp[i] += this->m_BVector(i);
+    }
+    return opp;
+  }
+};
+
 // end helper class
 } // end namespace itk
 
@@ -358,6 +410,141 @@ main(int argc, char * argv[])
 
   } // end loop
 
+  /** Test the compactly supported Wendland kernel, with the sparse LU decomposition
+   * and the landmark grid, on jittered grids of landmarks of increasing size.
+   * The landmarks are displaced by a smooth deformation.
+   */
+  using WendlandTransformType = itk::WendlandKernelTransformPublic<ScalarType, Dimension>;
+  const double        landmarkSpacing = 10.0;
+  const double        supportRadius = 2.5 * landmarkSpacing;
+  const unsigned long numberOfTestPoints = 100000;
+  const unsigned long maxTestedLandmarksForQR = 1000;
+  std::mt19937        randomGenerator(1);
+
+  for (const unsigned int gridSize : { 6, 10, 18 })
+  {
+    itk::TimeProbesCollectorBase timeCollector;
+
+    std::uniform_real_distribution<double> jitter(-0.2 * landmarkSpacing, 0.2 * landmarkSpacing);
+    auto                                   sourcePoints = PointsContainerType::New();
+    auto                                   targetPoints = PointsContainerType::New();
+    for (unsigned int z = 0; z < gridSize; ++z)
+    {
+      for (unsigned int y = 0; y < gridSize; ++y)
+      {
+        for (unsigned int x = 0; x < gridSize; ++x)
+        {
+          PointType source;
+          source[0] = x * landmarkSpacing + jitter(randomGenerator);
+          source[1] = y * landmarkSpacing + jitter(randomGenerator);
+          source[2] = z * landmarkSpacing + jitter(randomGenerator);
+          PointType target = source;
+          target[0] += 3.0 * std::sin(source[1] / 30.0);
+          target[1] += 2.0 * std::cos(source[2] / 25.0);
+          target[2] += 0.05 * source[0];
+          sourcePoints->push_back(source);
+          targetPoints->push_back(target);
+        }
+      }
+    }
+    const unsigned long numberOfLandmarks = sourcePoints->Size();
+    auto                sourceLandmarks = PointSetType::New();
+    auto                targetLandmarks = PointSetType::New();
+    sourceLandmarks->SetPoints(sourcePoints);
+    targetLandmarks->SetPoints(targetPoints);
+
+    std::cerr << "----------------------------------------\n";
+    std::cerr << "Wendland kernel, number of landmarks: " << numberOfLandmarks << std::endl;
+
+    /** Set up the transform: the sparse L matrix and its decomposition. */
+    auto sparseTransform = WendlandTransformType::New();
+    sparseTransform->SetSupportRadius(supportRadius);
+    sparseTransform->SetMatrixInversionMethod("SparseLU");
+    timeCollector.Start("WendlandSetupSparseLU");
+    sparseTransform->SetSourceLandmarks(sourceLandmarks);
+    sparseTransform->SetTargetLandmarks(targetLandmarks);
+    timeCollector.Stop("WendlandSetupSparseLU");
+
+    /** The transform should interpolate the landmarks. */
+    double maxLandmarkError = 0.0;
+    for (unsigned long j = 0; j < numberOfLandmarks; ++j)
+    {
+      const PointType transformed = sparseTransform->TransformPoint(sourcePoints->ElementAt(j));
+      maxLandmarkError = std::max(maxLandmarkError, transformed.EuclideanDistanceTo(targetPoints->ElementAt(j)));
+    }
+    std::cerr << "Maximum landmark error: " << maxLandmarkError << std::endl;
+    if (maxLandmarkError > 1e-6)
+    {
+      std::cerr << "ERROR: the Wendland spline does not interpolate the landmarks: " << maxLandmarkError << std::endl;
+      return 1;
+    }
+
+    /** Transform many points, using the landmark grid. */
+    std::uniform_real_distribution<double> coordinate(-landmarkSpacing, gridSize * landmarkSpacing);
+    std::vector<PointType>                 testPoints(numberOfTestPoints);
+    for (auto & point : testPoints)
+    {
+      for (unsigned int d = 0; d < Dimension; ++d)
+      {
+        point[d] = coordinate(randomGenerator);
+      }
+    }
+    std::vector<PointType> transformedPoints(numberOfTestPoints);
+    timeCollector.Start("WendlandTransformPoint");
+    for (unsigned long j = 0; j < numberOfTestPoints; ++j)
+    {
+      transformedPoints[j] = sparseTransform->TransformPoint(testPoints[j]);
+    }
+    timeCollector.Stop("WendlandTransformPoint");
+
+    /** Compare with the evaluation over all landmarks, for a subset of the points. */
+    double maxBruteForceDifference = 0.0;
+    timeCollector.Start("WendlandTransformPointBruteForce");
+    for (unsigned long j = 0; j < numberOfTestPoints; j += 100)
+    {
+      const PointType transformed = sparseTransform->TransformPointBruteForce(testPoints[j]);
+      maxBruteForceDifference =
+        std::max(maxBruteForceDifference, transformed.EuclideanDistanceTo(transformedPoints[j]));
+    }
+    timeCollector.Stop("WendlandTransformPointBruteForce");
+    std::cerr << "Maximum difference with brute force evaluation: " << maxBruteForceDifference << std::endl;
+    if (maxBruteForceDifference > tolerance)
+    {
+      std::cerr << "ERROR: the grid based evaluation differs from the brute force evaluation: "
+                << maxBruteForceDifference << std::endl;
+      return 1;
+    }
+
+    /** Compare the sparse LU solution with the dense QR solution. */
+    if (numberOfLandmarks <= maxTestedLandmarksForQR)
+    {
+      auto denseTransform = WendlandTransformType::New();
+      denseTransform->SetSupportRadius(supportRadius);
+      denseTransform->SetMatrixInversionMethod("QR");
+      timeCollector.Start("WendlandSetupQR");
+      denseTransform->SetSourceLandmarks(sourceLandmarks);
+      denseTransform->SetTargetLandmarks(targetLandmarks);
+      timeCollector.Stop("WendlandSetupQR");
+
+      double maxSolverDifference = 0.0;
+      for (unsigned long j = 0; j < numberOfTestPoints; j += 100)
+      {
+        const PointType transformed = denseTransform->TransformPoint(testPoints[j]);
+        maxSolverDifference = std::max(maxSolverDifference, transformed.EuclideanDistanceTo(transformedPoints[j]));
+      }
+      std::cerr << "Maximum difference of SparseLU with QR: " << maxSolverDifference << std::endl;
+      if (maxSolverDifference > 1e-6)
+      {
+        std::cerr << "ERROR: the SparseLU and QR solutions differ too much: " << maxSolverDifference << std::endl;
+        return 1;
+      }
+    }
+
+    // Report timings
+    timeCollector.Report();
+    std::cout << std::endl;
+  }
+
   /** Return a value. */
   return 0;
 